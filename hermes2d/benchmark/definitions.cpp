@@ -0,0 +1,540 @@
+#include "definitions.h"
+
+void create_benchmark_mesh(MeshSharedPtr mesh, int refinements)
+{
+  double2 vertices[9];
+  for (int j = 0; j < 3; j++)
+  for (int i = 0; i < 3; i++)
+  {
+    vertices[3 * j + i][0] = i / 2.;
+    vertices[3 * j + i][1] = j / 2.;
+  }
+  int4 quads[4] = { { 0, 1, 4, 3 }, { 1, 2, 5, 4 }, { 3, 4, 7, 6 }, { 4, 5, 8, 7 } };
+  std::string quad_markers[4] = { "Domain", "Domain", "Domain", "Domain" };
+  int2 boundary_edges[8] = { { 0, 1 }, { 1, 2 }, { 2, 5 }, { 5, 8 }, { 8, 7 }, { 7, 6 }, { 6, 3 }, { 3, 0 } };
+  std::string boundary_markers[8] = { "Bottom", "Bottom", "Right", "Right", "Top", "Top", "Left", "Left" };
+
+  mesh->create(9, vertices, 0, nullptr, nullptr, 4, quads, quad_markers, 8, boundary_edges, boundary_markers);
+  for (int i = 0; i < refinements; i++)
+    mesh->refine_all_elements();
+}
+
+template<typename Scalar>
+BenchmarkFunction<Scalar>::BenchmarkFunction(MeshSharedPtr mesh, double frequency) : ExactSolutionScalar<Scalar>(mesh), frequency(frequency)
+{
+}
+
+template<typename Scalar>
+Scalar BenchmarkFunction<Scalar>::value(double x, double y) const
+{
+  return Scalar(std::sin(frequency * x) * std::cos(frequency * y) + x * y);
+}
+
+template<typename Scalar>
+void BenchmarkFunction<Scalar>::derivatives(double x, double y, Scalar& dx, Scalar& dy) const
+{
+  dx = Scalar(frequency * std::cos(frequency * x) * std::cos(frequency * y) + y);
+  dy = Scalar(-frequency * std::sin(frequency * x) * std::sin(frequency * y) + x);
+}
+
+template<typename Scalar>
+Ord BenchmarkFunction<Scalar>::ord(double x, double y) const
+{
+  return Ord(10);
+}
+
+template<typename Scalar>
+MeshFunction<Scalar>* BenchmarkFunction<Scalar>::clone() const
+{
+  return new BenchmarkFunction<Scalar>(this->mesh, frequency);
+}
+
+template class BenchmarkFunction<double>;
+template class BenchmarkFunction<complex>;
+
+MeshFunctionSharedPtr<double> benchmark_real_part(MeshFunctionSharedPtr<double> function)
+{
+  return function;
+}
+
+MeshFunctionSharedPtr<double> benchmark_real_part(MeshFunctionSharedPtr<complex> function)
+{
+  return MeshFunctionSharedPtr<double>(new RealFilter(function));
+}
+
+// Poisson.
+PoissonScenario::PoissonScenario() : source(-1.0), bc(Hermes::vector<std::string>("Bottom", "Right", "Top", "Left"), 0.0), bcs(&bc)
+{
+  wf = new WeakFormsH1::DefaultWeakFormPoisson<double>(HERMES_ANY, nullptr, &source);
+}
+
+PoissonScenario::~PoissonScenario()
+{
+  delete wf;
+}
+
+std::string PoissonScenario::get_name() const
+{
+  return "poisson";
+}
+
+int PoissonScenario::get_num_components() const
+{
+  return 1;
+}
+
+Hermes::vector<SpaceSharedPtr<double> > PoissonScenario::create_spaces(const Hermes::vector<MeshSharedPtr>& meshes, int order)
+{
+  Hermes::vector<SpaceSharedPtr<double> > spaces;
+  spaces.push_back(new H1Space<double>(meshes[0], &bcs, order));
+  return spaces;
+}
+
+WeakForm<double>* PoissonScenario::get_weak_form()
+{
+  return wf;
+}
+
+ErrorCalculator<double>* PoissonScenario::create_error_calculator()
+{
+  return new DefaultErrorCalculator<double, HERMES_H1_NORM>(RelativeErrorToGlobalNorm, 1);
+}
+
+Selector<double>* PoissonScenario::create_selector(int component)
+{
+  return new H1ProjBasedSelector<double>(H2D_HP_ANISO);
+}
+
+// Elasticity.
+const double YOUNG_MODULUS = 200e9;
+const double POISSON_RATIO = 0.3;
+const double LAMBDA = (YOUNG_MODULUS * POISSON_RATIO) / ((1 + POISSON_RATIO) * (1 - 2 * POISSON_RATIO));
+const double MU = YOUNG_MODULUS / (2 * (1 + POISSON_RATIO));
+
+ElasticityScenario::ElasticityScenario() : gravity(-7800. * 9.81), bc("Bottom", 0.0), bcs(&bc)
+{
+  wf = new WeakForm<double>(2);
+  wf->add_matrix_form(new WeakFormsElasticity::DefaultJacobianElasticity_0_0<double>(0, 0, LAMBDA, MU));
+  wf->add_matrix_form(new WeakFormsElasticity::DefaultJacobianElasticity_0_1<double>(0, 1, LAMBDA, MU));
+  wf->add_matrix_form(new WeakFormsElasticity::DefaultJacobianElasticity_1_1<double>(1, 1, LAMBDA, MU));
+  wf->add_vector_form(new WeakFormsElasticity::DefaultResidualElasticity_0_0<double>(0, LAMBDA, MU));
+  wf->add_vector_form(new WeakFormsElasticity::DefaultResidualElasticity_0_1<double>(0, LAMBDA, MU));
+  wf->add_vector_form(new WeakFormsElasticity::DefaultResidualElasticity_1_0<double>(1, LAMBDA, MU));
+  wf->add_vector_form(new WeakFormsElasticity::DefaultResidualElasticity_1_1<double>(1, LAMBDA, MU));
+  wf->add_vector_form(new WeakFormsH1::DefaultVectorFormVol<double>(1, HERMES_ANY, &gravity));
+}
+
+ElasticityScenario::~ElasticityScenario()
+{
+  delete wf;
+}
+
+std::string ElasticityScenario::get_name() const
+{
+  return "elasticity";
+}
+
+int ElasticityScenario::get_num_components() const
+{
+  return 2;
+}
+
+Hermes::vector<SpaceSharedPtr<double> > ElasticityScenario::create_spaces(const Hermes::vector<MeshSharedPtr>& meshes, int order)
+{
+  return Hermes::vector<SpaceSharedPtr<double> >(new H1Space<double>(meshes[0], &bcs, order), new H1Space<double>(meshes[1], &bcs, order));
+}
+
+WeakForm<double>* ElasticityScenario::get_weak_form()
+{
+  return wf;
+}
+
+ErrorCalculator<double>* ElasticityScenario::create_error_calculator()
+{
+  return new DefaultErrorCalculator<double, HERMES_H1_NORM>(RelativeErrorToGlobalNorm, 2);
+}
+
+Selector<double>* ElasticityScenario::create_selector(int component)
+{
+  return new H1ProjBasedSelector<double>(H2D_HP_ANISO);
+}
+
+// Navier-Stokes.
+const double REYNOLDS = 100.;
+
+NavierStokesScenario::NavierStokesScenario() : bc_lid("Top", 1.0), bc_walls(Hermes::vector<std::string>("Bottom", "Right", "Left"), 0.0),
+  bc_zero(Hermes::vector<std::string>("Bottom", "Right", "Top", "Left"), 0.0),
+  bcs_xvel(Hermes::vector<EssentialBoundaryCondition<double>*>(&bc_lid, &bc_walls)), bcs_yvel(&bc_zero)
+{
+  wf = new NavierStokesWeakForm(REYNOLDS);
+}
+
+NavierStokesScenario::~NavierStokesScenario()
+{
+  delete wf;
+}
+
+std::string NavierStokesScenario::get_name() const
+{
+  return "navier-stokes";
+}
+
+int NavierStokesScenario::get_num_components() const
+{
+  return 3;
+}
+
+Hermes::vector<SpaceSharedPtr<double> > NavierStokesScenario::create_spaces(const Hermes::vector<MeshSharedPtr>& meshes, int order)
+{
+  // Taylor-Hood: the pressure one order lower than the velocity.
+  return Hermes::vector<SpaceSharedPtr<double> >(new H1Space<double>(meshes[0], &bcs_xvel, order), new H1Space<double>(meshes[1], &bcs_yvel, order),
+    new H1Space<double>(meshes[2], std::max(order - 1, 1)));
+}
+
+WeakForm<double>* NavierStokesScenario::get_weak_form()
+{
+  return wf;
+}
+
+ErrorCalculator<double>* NavierStokesScenario::create_error_calculator()
+{
+  return new DefaultErrorCalculator<double, HERMES_H1_NORM>(RelativeErrorToGlobalNorm, 3);
+}
+
+Selector<double>* NavierStokesScenario::create_selector(int component)
+{
+  return new H1ProjBasedSelector<double>(H2D_HP_ANISO);
+}
+
+NavierStokesWeakForm::NavierStokesWeakForm(double Reynolds) : WeakForm<double>(3), Reynolds(Reynolds)
+{
+  for (int i = 0; i < 2; i++)
+  {
+    for (int j = 0; j < 3; j++)
+      add_matrix_form(new JacobianForm(i, j, Reynolds));
+    add_matrix_form(new JacobianForm(2, i, Reynolds));
+  }
+  for (int i = 0; i < 3; i++)
+    add_vector_form(new ResidualForm(i, Reynolds));
+}
+
+WeakForm<double>* NavierStokesWeakForm::clone() const
+{
+  return new NavierStokesWeakForm(*this);
+}
+
+template<typename Real, typename Scalar>
+Scalar NavierStokesWeakForm::JacobianForm::matrix_form(int n, double *wt, Func<Scalar> *u_ext[], Func<Real> *u, Func<Real> *v,
+  Geom<Real> *e, Func<Scalar> **ext) const
+{
+  Scalar result = Scalar(0);
+  Func<Scalar>* xvel_prev = u_ext[0];
+  Func<Scalar>* yvel_prev = u_ext[1];
+  for (int i = 0; i < n; i++)
+  {
+    if (this->i < 2 && this->j < 2)
+    {
+      // Diffusion and convection by the previous velocity (diagonal blocks), derivative of the convection term.
+      Func<Scalar>* vel_i_prev = u_ext[this->i];
+      if (this->i == this->j)
+        result += wt[i] * ((u->dx[i] * v->dx[i] + u->dy[i] * v->dy[i]) / Reynolds
+        + (xvel_prev->val[i] * u->dx[i] + yvel_prev->val[i] * u->dy[i]) * v->val[i]);
+      result += wt[i] * u->val[i] * (this->j == 0 ? vel_i_prev->dx[i] : vel_i_prev->dy[i]) * v->val[i];
+    }
+    else if (this->j == 2)
+      result -= wt[i] * u->val[i] * (this->i == 0 ? v->dx[i] : v->dy[i]);
+    else
+      result += wt[i] * (this->j == 0 ? u->dx[i] : u->dy[i]) * v->val[i];
+  }
+  return result;
+}
+
+double NavierStokesWeakForm::JacobianForm::value(int n, double *wt, Func<double> *u_ext[], Func<double> *u, Func<double> *v,
+  Geom<double> *e, Func<double> **ext) const
+{
+  return matrix_form<double, double>(n, wt, u_ext, u, v, e, ext);
+}
+
+Ord NavierStokesWeakForm::JacobianForm::ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v,
+  Geom<Ord> *e, Func<Ord> **ext) const
+{
+  return matrix_form<Ord, Ord>(n, wt, u_ext, u, v, e, ext);
+}
+
+MatrixFormVol<double>* NavierStokesWeakForm::JacobianForm::clone() const
+{
+  return new NavierStokesWeakForm::JacobianForm(*this);
+}
+
+template<typename Real, typename Scalar>
+Scalar NavierStokesWeakForm::ResidualForm::vector_form(int n, double *wt, Func<Scalar> *u_ext[], Func<Real> *v,
+  Geom<Real> *e, Func<Scalar> **ext) const
+{
+  Scalar result = Scalar(0);
+  Func<Scalar>* xvel_prev = u_ext[0];
+  Func<Scalar>* yvel_prev = u_ext[1];
+  Func<Scalar>* p_prev = u_ext[2];
+  for (int i = 0; i < n; i++)
+  {
+    if (this->i < 2)
+    {
+      Func<Scalar>* vel_i_prev = u_ext[this->i];
+      result += wt[i] * ((vel_i_prev->dx[i] * v->dx[i] + vel_i_prev->dy[i] * v->dy[i]) / Reynolds
+        + (xvel_prev->val[i] * vel_i_prev->dx[i] + yvel_prev->val[i] * vel_i_prev->dy[i]) * v->val[i]
+        - p_prev->val[i] * (this->i == 0 ? v->dx[i] : v->dy[i]));
+    }
+    else
+      result += wt[i] * (xvel_prev->dx[i] + yvel_prev->dy[i]) * v->val[i];
+  }
+  return result;
+}
+
+double NavierStokesWeakForm::ResidualForm::value(int n, double *wt, Func<double> *u_ext[], Func<double> *v,
+  Geom<double> *e, Func<double> **ext) const
+{
+  return vector_form<double, double>(n, wt, u_ext, v, e, ext);
+}
+
+Ord NavierStokesWeakForm::ResidualForm::ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *v,
+  Geom<Ord> *e, Func<Ord> **ext) const
+{
+  return vector_form<Ord, Ord>(n, wt, u_ext, v, e, ext);
+}
+
+VectorFormVol<double>* NavierStokesWeakForm::ResidualForm::clone() const
+{
+  return new NavierStokesWeakForm::ResidualForm(*this);
+}
+
+// Helmholtz.
+const double WAVE_NUMBER = 10.;
+
+HelmholtzScenario::HelmholtzScenario() : minus_k_squared(complex(-WAVE_NUMBER * WAVE_NUMBER, 0.)), i_k(complex(0., WAVE_NUMBER)),
+  source(complex(-1., 0.))
+{
+  wf = new WeakForm<complex>(1);
+  wf->add_matrix_form(new WeakFormsH1::DefaultJacobianDiffusion<complex>(0, 0));
+  wf->add_matrix_form(new WeakFormsH1::DefaultMatrixFormVol<complex>(0, 0, HERMES_ANY, &minus_k_squared));
+  wf->add_matrix_form_surf(new WeakFormsH1::DefaultMatrixFormSurf<complex>(0, 0, HERMES_ANY, &i_k));
+  wf->add_vector_form(new WeakFormsH1::DefaultResidualDiffusion<complex>(0));
+  wf->add_vector_form(new WeakFormsH1::DefaultResidualVol<complex>(0, HERMES_ANY, &minus_k_squared));
+  wf->add_vector_form_surf(new WeakFormsH1::DefaultResidualSurf<complex>(0, HERMES_ANY, &i_k));
+  wf->add_vector_form(new WeakFormsH1::DefaultVectorFormVol<complex>(0, HERMES_ANY, &source));
+}
+
+HelmholtzScenario::~HelmholtzScenario()
+{
+  delete wf;
+}
+
+std::string HelmholtzScenario::get_name() const
+{
+  return "helmholtz";
+}
+
+int HelmholtzScenario::get_num_components() const
+{
+  return 1;
+}
+
+Hermes::vector<SpaceSharedPtr<complex> > HelmholtzScenario::create_spaces(const Hermes::vector<MeshSharedPtr>& meshes, int order)
+{
+  Hermes::vector<SpaceSharedPtr<complex> > spaces;
+  spaces.push_back(new H1Space<complex>(meshes[0], order));
+  return spaces;
+}
+
+WeakForm<complex>* HelmholtzScenario::get_weak_form()
+{
+  return wf;
+}
+
+ErrorCalculator<complex>* HelmholtzScenario::create_error_calculator()
+{
+  return new DefaultErrorCalculator<complex, HERMES_H1_NORM>(RelativeErrorToGlobalNorm, 1);
+}
+
+Selector<complex>* HelmholtzScenario::create_selector(int component)
+{
+  return new H1ProjBasedSelector<complex>(H2D_HP_ANISO);
+}
+
+// DG advection.
+AdvectionDGScenario::AdvectionDGScenario()
+{
+  wf = new AdvectionDGWeakForm(std::cos(M_PI / 6.), std::sin(M_PI / 6.));
+}
+
+AdvectionDGScenario::~AdvectionDGScenario()
+{
+  delete wf;
+}
+
+std::string AdvectionDGScenario::get_name() const
+{
+  return "advection-dg";
+}
+
+int AdvectionDGScenario::get_num_components() const
+{
+  return 1;
+}
+
+Hermes::vector<SpaceSharedPtr<double> > AdvectionDGScenario::create_spaces(const Hermes::vector<MeshSharedPtr>& meshes, int order)
+{
+  Hermes::vector<SpaceSharedPtr<double> > spaces;
+  spaces.push_back(new L2Space<double>(meshes[0], order));
+  return spaces;
+}
+
+WeakForm<double>* AdvectionDGScenario::get_weak_form()
+{
+  return wf;
+}
+
+ErrorCalculator<double>* AdvectionDGScenario::create_error_calculator()
+{
+  return new DefaultErrorCalculator<double, HERMES_L2_NORM>(RelativeErrorToGlobalNorm, 1);
+}
+
+Selector<double>* AdvectionDGScenario::create_selector(int component)
+{
+  return new L2ProjBasedSelector<double>(H2D_HP_ANISO);
+}
+
+AdvectionDGWeakForm::AdvectionDGWeakForm(double a_x, double a_y) : WeakForm<double>(1), a_x(a_x), a_y(a_y)
+{
+  add_matrix_form(new VolumeForm());
+  add_matrix_form_surf(new BoundaryForm());
+  add_matrix_form_DG(new InterfaceForm());
+  add_vector_form_surf(new InflowForm());
+}
+
+WeakForm<double>* AdvectionDGWeakForm::clone() const
+{
+  return new AdvectionDGWeakForm(*this);
+}
+
+double AdvectionDGWeakForm::upwind_flux(double u_cent, double u_neib, double a_dot_n) const
+{
+  return a_dot_n * (a_dot_n >= 0 ? u_cent : u_neib);
+}
+
+Ord AdvectionDGWeakForm::upwind_flux(Ord u_cent, Ord u_neib, Ord a_dot_n) const
+{
+  return a_dot_n * (u_cent + u_neib);
+}
+
+template<typename Real, typename Scalar>
+Scalar AdvectionDGWeakForm::VolumeForm::matrix_form(int n, double *wt, Func<Scalar> *u_ext[], Func<Real> *u, Func<Real> *v,
+  Geom<Real> *e, Func<Scalar> **ext) const
+{
+  AdvectionDGWeakForm* advection_wf = static_cast<AdvectionDGWeakForm*>(wf);
+  Scalar result = Scalar(0);
+  for (int i = 0; i < n; i++)
+    result += -wt[i] * u->val[i] * advection_wf->a_dot(v->dx[i], v->dy[i]);
+  return result;
+}
+
+double AdvectionDGWeakForm::VolumeForm::value(int n, double *wt, Func<double> *u_ext[], Func<double> *u, Func<double> *v,
+  Geom<double> *e, Func<double> **ext) const
+{
+  return matrix_form<double, double>(n, wt, u_ext, u, v, e, ext);
+}
+
+Ord AdvectionDGWeakForm::VolumeForm::ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v,
+  Geom<Ord> *e, Func<Ord> **ext) const
+{
+  return matrix_form<Ord, Ord>(n, wt, u_ext, u, v, e, ext);
+}
+
+MatrixFormVol<double>* AdvectionDGWeakForm::VolumeForm::clone() const
+{
+  return new AdvectionDGWeakForm::VolumeForm(*this);
+}
+
+template<typename Real, typename Scalar>
+Scalar AdvectionDGWeakForm::BoundaryForm::matrix_form(int n, double *wt, Func<Scalar> *u_ext[], Func<Real> *u, Func<Real> *v,
+  Geom<Real> *e, Func<Scalar> **ext) const
+{
+  AdvectionDGWeakForm* advection_wf = static_cast<AdvectionDGWeakForm*>(wf);
+  Scalar result = Scalar(0);
+  for (int i = 0; i < n; i++)
+    result += wt[i] * advection_wf->upwind_flux(u->val[i], Scalar(0), advection_wf->a_dot(e->nx[i], e->ny[i])) * v->val[i];
+  return result;
+}
+
+double AdvectionDGWeakForm::BoundaryForm::value(int n, double *wt, Func<double> *u_ext[], Func<double> *u, Func<double> *v,
+  Geom<double> *e, Func<double> **ext) const
+{
+  return matrix_form<double, double>(n, wt, u_ext, u, v, e, ext);
+}
+
+Ord AdvectionDGWeakForm::BoundaryForm::ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v,
+  Geom<Ord> *e, Func<Ord> **ext) const
+{
+  return matrix_form<Ord, Ord>(n, wt, u_ext, u, v, e, ext);
+}
+
+MatrixFormSurf<double>* AdvectionDGWeakForm::BoundaryForm::clone() const
+{
+  return new AdvectionDGWeakForm::BoundaryForm(*this);
+}
+
+template<typename Real, typename Scalar>
+Scalar AdvectionDGWeakForm::InterfaceForm::matrix_form(int n, double *wt, DiscontinuousFunc<Scalar> **u_ext, DiscontinuousFunc<Real> *u,
+  DiscontinuousFunc<Real> *v, Geom<Real> *e, DiscontinuousFunc<Scalar> **ext) const
+{
+  AdvectionDGWeakForm* advection_wf = static_cast<AdvectionDGWeakForm*>(wf);
+  Scalar result = Scalar(0);
+  for (int i = 0; i < n; i++)
+  {
+    Real a_dot_n = advection_wf->a_dot(e->nx[i], e->ny[i]);
+    Real jump_v = (v->fn_central == nullptr ? -v->val_neighbor[i] : v->val[i]);
+    if (u->fn_central == nullptr)
+      result += wt[i] * advection_wf->upwind_flux(Scalar(0), u->val_neighbor[i], a_dot_n) * jump_v;
+    else
+      result += wt[i] * advection_wf->upwind_flux(u->val[i], Scalar(0), a_dot_n) * jump_v;
+  }
+  return result;
+}
+
+double AdvectionDGWeakForm::InterfaceForm::value(int n, double *wt, DiscontinuousFunc<double> **u_ext, DiscontinuousFunc<double> *u,
+  DiscontinuousFunc<double> *v, Geom<double> *e, DiscontinuousFunc<double> **ext) const
+{
+  return matrix_form<double, double>(n, wt, u_ext, u, v, e, ext);
+}
+
+Ord AdvectionDGWeakForm::InterfaceForm::ord(int n, double *wt, DiscontinuousFunc<Ord> **u_ext, DiscontinuousFunc<Ord> *u,
+  DiscontinuousFunc<Ord> *v, Geom<Ord> *e, DiscontinuousFunc<Ord> **ext) const
+{
+  return matrix_form<Ord, Ord>(n, wt, u_ext, u, v, e, ext);
+}
+
+MatrixFormDG<double>* AdvectionDGWeakForm::InterfaceForm::clone() const
+{
+  return new AdvectionDGWeakForm::InterfaceForm(*this);
+}
+
+double AdvectionDGWeakForm::InflowForm::value(int n, double *wt, Func<double> *u_ext[], Func<double> *v,
+  Geom<double> *e, Func<double> **ext) const
+{
+  AdvectionDGWeakForm* advection_wf = static_cast<AdvectionDGWeakForm*>(wf);
+  double result = 0.;
+  for (int i = 0; i < n; i++)
+    result += -wt[i] * advection_wf->upwind_flux(0., 1., advection_wf->a_dot(e->nx[i], e->ny[i])) * v->val[i];
+  return result;
+}
+
+Ord AdvectionDGWeakForm::InflowForm::ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *v, Geom<Ord> *e, Func<Ord> **ext) const
+{
+  Ord result = Ord(0);
+  for (int i = 0; i < n; i++)
+    result += -wt[i] * v->val[i];
+  return result;
+}
+
+VectorFormSurf<double>* AdvectionDGWeakForm::InflowForm::clone() const
+{
+  return new AdvectionDGWeakForm::InflowForm(*this);
+}
@@ -0,0 +1,284 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::RefinementSelectors;
+
+typedef std::complex<double> complex;
+
+/// The square (0, 1)^2 split into 2 x 2 quadrilaterals, boundary markers "Bottom", "Right", "Top", "Left",
+/// refined uniformly.
+void create_benchmark_mesh(MeshSharedPtr mesh, int refinements);
+
+/// Smooth function projected on the coarse and the fine spaces.
+template<typename Scalar>
+class BenchmarkFunction : public ExactSolutionScalar<Scalar>
+{
+public:
+  BenchmarkFunction(MeshSharedPtr mesh, double frequency);
+
+  virtual Scalar value(double x, double y) const;
+  virtual void derivatives(double x, double y, Scalar& dx, Scalar& dy) const;
+  virtual Ord ord(double x, double y) const;
+  MeshFunction<Scalar>* clone() const;
+
+protected:
+  double frequency;
+};
+
+/// The real part of a function (for the Linearizer).
+MeshFunctionSharedPtr<double> benchmark_real_part(MeshFunctionSharedPtr<double> function);
+MeshFunctionSharedPtr<double> benchmark_real_part(MeshFunctionSharedPtr<complex> function);
+
+/// One problem of the benchmark: the weak form, the spaces of its components and the adaptivity settings.
+template<typename Scalar>
+class BenchmarkScenario
+{
+public:
+  virtual ~BenchmarkScenario() {};
+
+  /// The name of the scenario in the results.
+  virtual std::string get_name() const = 0;
+
+  /// The number of the components.
+  virtual int get_num_components() const = 0;
+
+  /// The spaces of all components.
+  /// \param[in] meshes The meshes of the components (multimesh, the meshes may differ after the adaptivity).
+  /// \param[in] order The polynomial order of the (first) component.
+  virtual Hermes::vector<SpaceSharedPtr<Scalar> > create_spaces(const Hermes::vector<MeshSharedPtr>& meshes, int order) = 0;
+
+  /// The weak form (Jacobian & residual).
+  virtual WeakForm<Scalar>* get_weak_form() = 0;
+
+  /// The error calculator of the adaptivity.
+  virtual ErrorCalculator<Scalar>* create_error_calculator() = 0;
+
+  /// The refinement selector of the component.
+  virtual Selector<Scalar>* create_selector(int component) = 0;
+};
+
+/// Poisson equation -Laplace u = 1, u = 0 on the boundary.
+class PoissonScenario : public BenchmarkScenario<double>
+{
+public:
+  PoissonScenario();
+  ~PoissonScenario();
+
+  std::string get_name() const;
+  int get_num_components() const;
+  Hermes::vector<SpaceSharedPtr<double> > create_spaces(const Hermes::vector<MeshSharedPtr>& meshes, int order);
+  WeakForm<double>* get_weak_form();
+  ErrorCalculator<double>* create_error_calculator();
+  Selector<double>* create_selector(int component);
+
+protected:
+  Hermes2DFunction<double> source;
+  DefaultEssentialBCConst<double> bc;
+  EssentialBCs<double> bcs;
+  WeakForm<double>* wf;
+};
+
+/// Linear elasticity (2 components), the body fixed at the bottom and loaded by its weight.
+class ElasticityScenario : public BenchmarkScenario<double>
+{
+public:
+  ElasticityScenario();
+  ~ElasticityScenario();
+
+  std::string get_name() const;
+  int get_num_components() const;
+  Hermes::vector<SpaceSharedPtr<double> > create_spaces(const Hermes::vector<MeshSharedPtr>& meshes, int order);
+  WeakForm<double>* get_weak_form();
+  ErrorCalculator<double>* create_error_calculator();
+  Selector<double>* create_selector(int component);
+
+protected:
+  Hermes2DFunction<double> gravity;
+  DefaultEssentialBCConst<double> bc;
+  EssentialBCs<double> bcs;
+  WeakForm<double>* wf;
+};
+
+/// Stationary Navier-Stokes equations (Newton's method, Taylor-Hood elements), lid-driven cavity.
+class NavierStokesScenario : public BenchmarkScenario<double>
+{
+public:
+  NavierStokesScenario();
+  ~NavierStokesScenario();
+
+  std::string get_name() const;
+  int get_num_components() const;
+  Hermes::vector<SpaceSharedPtr<double> > create_spaces(const Hermes::vector<MeshSharedPtr>& meshes, int order);
+  WeakForm<double>* get_weak_form();
+  ErrorCalculator<double>* create_error_calculator();
+  Selector<double>* create_selector(int component);
+
+protected:
+  DefaultEssentialBCConst<double> bc_lid, bc_walls, bc_zero;
+  EssentialBCs<double> bcs_xvel, bcs_yvel;
+  WeakForm<double>* wf;
+};
+
+/// Helmholtz equation -Laplace u - k^2 u = 1 (complex), impedance condition du/dn + i k u = 0 on the boundary.
+class HelmholtzScenario : public BenchmarkScenario<complex>
+{
+public:
+  HelmholtzScenario();
+  ~HelmholtzScenario();
+
+  std::string get_name() const;
+  int get_num_components() const;
+  Hermes::vector<SpaceSharedPtr<complex> > create_spaces(const Hermes::vector<MeshSharedPtr>& meshes, int order);
+  WeakForm<complex>* get_weak_form();
+  ErrorCalculator<complex>* create_error_calculator();
+  Selector<complex>* create_selector(int component);
+
+protected:
+  Hermes2DFunction<complex> minus_k_squared, i_k, source;
+  WeakForm<complex>* wf;
+};
+
+/// Linear advection with a constant velocity, discontinuous Galerkin (upwind fluxes), u = 1 on the inflow boundary.
+class AdvectionDGScenario : public BenchmarkScenario<double>
+{
+public:
+  AdvectionDGScenario();
+  ~AdvectionDGScenario();
+
+  std::string get_name() const;
+  int get_num_components() const;
+  Hermes::vector<SpaceSharedPtr<double> > create_spaces(const Hermes::vector<MeshSharedPtr>& meshes, int order);
+  WeakForm<double>* get_weak_form();
+  ErrorCalculator<double>* create_error_calculator();
+  Selector<double>* create_selector(int component);
+
+protected:
+  WeakForm<double>* wf;
+};
+
+/// Newton's method forms of the stationary Navier-Stokes equations, components x-velocity, y-velocity, pressure.
+class NavierStokesWeakForm : public WeakForm<double>
+{
+public:
+  NavierStokesWeakForm(double Reynolds);
+  WeakForm<double>* clone() const;
+
+protected:
+  double Reynolds;
+
+  /// Jacobian block (i, j).
+  class JacobianForm : public MatrixFormVol<double>
+  {
+  public:
+    JacobianForm(int i, int j, double Reynolds) : MatrixFormVol<double>(i, j), Reynolds(Reynolds) {};
+
+    template<typename Real, typename Scalar>
+    Scalar matrix_form(int n, double *wt, Func<Scalar> *u_ext[], Func<Real> *u, Func<Real> *v, Geom<Real> *e, Func<Scalar> **ext) const;
+
+    virtual double value(int n, double *wt, Func<double> *u_ext[], Func<double> *u, Func<double> *v, Geom<double> *e, Func<double> **ext) const;
+
+    virtual Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v, Geom<Ord> *e, Func<Ord> **ext) const;
+
+    MatrixFormVol<double>* clone() const;
+
+  protected:
+    double Reynolds;
+  };
+
+  /// Residual of the equation i.
+  class ResidualForm : public VectorFormVol<double>
+  {
+  public:
+    ResidualForm(int i, double Reynolds) : VectorFormVol<double>(i), Reynolds(Reynolds) {};
+
+    template<typename Real, typename Scalar>
+    Scalar vector_form(int n, double *wt, Func<Scalar> *u_ext[], Func<Real> *v, Geom<Real> *e, Func<Scalar> **ext) const;
+
+    virtual double value(int n, double *wt, Func<double> *u_ext[], Func<double> *v, Geom<double> *e, Func<double> **ext) const;
+
+    virtual Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *v, Geom<Ord> *e, Func<Ord> **ext) const;
+
+    VectorFormVol<double>* clone() const;
+
+  protected:
+    double Reynolds;
+  };
+};
+
+/// Upwind discontinuous Galerkin forms of the linear advection with the velocity (a_x, a_y).
+class AdvectionDGWeakForm : public WeakForm<double>
+{
+public:
+  AdvectionDGWeakForm(double a_x, double a_y);
+  WeakForm<double>* clone() const;
+
+  double a_x, a_y;
+
+  template<typename Real>
+  Real a_dot(Real v_x, Real v_y) const { return a_x * v_x + a_y * v_y; };
+
+  double upwind_flux(double u_cent, double u_neib, double a_dot_n) const;
+  Ord upwind_flux(Ord u_cent, Ord u_neib, Ord a_dot_n) const;
+
+protected:
+  class VolumeForm : public MatrixFormVol<double>
+  {
+  public:
+    VolumeForm() : MatrixFormVol<double>(0, 0) {};
+
+    template<typename Real, typename Scalar>
+    Scalar matrix_form(int n, double *wt, Func<Scalar> *u_ext[], Func<Real> *u, Func<Real> *v, Geom<Real> *e, Func<Scalar> **ext) const;
+
+    virtual double value(int n, double *wt, Func<double> *u_ext[], Func<double> *u, Func<double> *v, Geom<double> *e, Func<double> **ext) const;
+
+    virtual Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v, Geom<Ord> *e, Func<Ord> **ext) const;
+
+    MatrixFormVol<double>* clone() const;
+  };
+
+  /// Outflow boundary.
+  class BoundaryForm : public MatrixFormSurf<double>
+  {
+  public:
+    BoundaryForm() : MatrixFormSurf<double>(0, 0) {};
+
+    template<typename Real, typename Scalar>
+    Scalar matrix_form(int n, double *wt, Func<Scalar> *u_ext[], Func<Real> *u, Func<Real> *v, Geom<Real> *e, Func<Scalar> **ext) const;
+
+    virtual double value(int n, double *wt, Func<double> *u_ext[], Func<double> *u, Func<double> *v, Geom<double> *e, Func<double> **ext) const;
+
+    virtual Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v, Geom<Ord> *e, Func<Ord> **ext) const;
+
+    MatrixFormSurf<double>* clone() const;
+  };
+
+  /// Inner edges (upwind flux).
+  class InterfaceForm : public MatrixFormDG<double>
+  {
+  public:
+    InterfaceForm() : MatrixFormDG<double>(0, 0) {};
+
+    template<typename Real, typename Scalar>
+    Scalar matrix_form(int n, double *wt, DiscontinuousFunc<Scalar> **u_ext, DiscontinuousFunc<Real> *u, DiscontinuousFunc<Real> *v, Geom<Real> *e, DiscontinuousFunc<Scalar> **ext) const;
+
+    virtual double value(int n, double *wt, DiscontinuousFunc<double> **u_ext, DiscontinuousFunc<double> *u, DiscontinuousFunc<double> *v, Geom<double> *e, DiscontinuousFunc<double> **ext) const;
+
+    virtual Ord ord(int n, double *wt, DiscontinuousFunc<Ord> **u_ext, DiscontinuousFunc<Ord> *u, DiscontinuousFunc<Ord> *v, Geom<Ord> *e, DiscontinuousFunc<Ord> **ext) const;
+
+    MatrixFormDG<double>* clone() const;
+  };
+
+  /// Inflow boundary (u = 1).
+  class InflowForm : public VectorFormSurf<double>
+  {
+  public:
+    InflowForm() : VectorFormSurf<double>(0) {};
+
+    virtual double value(int n, double *wt, Func<double> *u_ext[], Func<double> *v, Geom<double> *e, Func<double> **ext) const;
+
+    virtual Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *v, Geom<Ord> *e, Func<Ord> **ext) const;
+
+    VectorFormSurf<double>* clone() const;
+  };
+};
@@ -0,0 +1,390 @@
+#include "definitions.h"
+
+// Benchmark of the core kernels of Hermes2D (target hermes2d-bench).
+//
+// Every case (scenario x uniform mesh refinements x polynomial order x number of threads) measures separately
+//   traverse          Traverse::get_states() on the meshes of all components,
+//   projection        OGProjection::project_global() of smooth functions on the spaces,
+//   assemble          DiscreteProblem::assemble() of the Jacobian and the residual (with an existing sparse structure),
+//   set_coeff_vector  Solution::set_coeff_vector() of all components (Solution::vector_to_solutions()),
+//   calculate_errors  ErrorCalculator::calculate_errors() against the solutions on the reference spaces,
+//   linearize         Linearizer::process_solution() of (the real part of) the first component,
+//   adapt             Adapt::adapt() with the hp-anisotropic projection based selectors.
+// Every kernel runs once unmeasured (warm-up, caches) and then REPEATS times, the minimum, median and maximum wall-clock
+// times are written as one CSV line per case and kernel. The meshes are generated and the solutions are projections of
+// fixed functions, so the results of two builds (or machines) can be compared line by line. The progress and the errors
+// go to stderr, the CSV output (stdout by default) contains nothing else.
+//
+// Usage: hermes2d-bench [--scenarios poisson,elasticity,navier-stokes,helmholtz,advection-dg] [--refinements 3,4]
+//                       [--orders 2,4] [--threads 1,<numThreads>] [--repeats 5] [--output results.csv]
+
+const int DEFAULT_REPEATS = 5;
+const double ADAPT_THRESHOLD = 0.3;
+
+// Wall-clock times of the measured runs of one kernel.
+class KernelTimes
+{
+public:
+  // Starts a run, repeat -1 is the warm-up.
+  void begin(int repeat) { this->repeat = repeat; timer.tick(); }
+  // Ends the run.
+  void end() { timer.tick(); if (repeat >= 0) times.push_back(timer.last()); }
+
+  double min() const { return *std::min_element(times.begin(), times.end()); }
+  double max() const { return *std::max_element(times.begin(), times.end()); }
+  double median() const
+  {
+    std::vector<double> sorted(times);
+    std::sort(sorted.begin(), sorted.end());
+    int n = sorted.size();
+    return n % 2 ? sorted[n / 2] : (sorted[n / 2 - 1] + sorted[n / 2]) / 2.;
+  }
+  int count() const { return times.size(); }
+
+protected:
+  Hermes::Mixins::TimeMeasurable timer;
+  std::vector<double> times;
+  int repeat;
+};
+
+// The objects of one case which are not shared pointers, released also if the case fails.
+template<typename Scalar>
+class CaseData
+{
+public:
+  CaseData() : coeffs(nullptr), ref_coeffs(nullptr), errorCalculator(nullptr) {}
+  ~CaseData()
+  {
+    for (unsigned int i = 0; i < selectors.size(); i++)
+      delete selectors[i];
+    delete errorCalculator;
+    free_with_check(coeffs);
+    free_with_check(ref_coeffs);
+  }
+
+  Scalar* coeffs;
+  Scalar* ref_coeffs;
+  ErrorCalculator<Scalar>* errorCalculator;
+  Hermes::vector<Selector<Scalar>*> selectors;
+};
+
+// One combination of the parameters.
+struct BenchmarkCase
+{
+  std::string scenario;
+  int refinements, order, threads, repeats;
+  int elements, ndof;
+};
+
+static void write_header(FILE* out)
+{
+  fprintf(out, "scenario,refinements,order,threads,elements,ndof,kernel,repeats,min_s,median_s,max_s\n");
+  fflush(out);
+}
+
+static void write_result(FILE* out, const BenchmarkCase& c, const char* kernel, const KernelTimes& times)
+{
+  fprintf(out, "%s,%i,%i,%i,%i,%i,%s,%i,%.6e,%.6e,%.6e\n", c.scenario.c_str(), c.refinements, c.order, c.threads,
+    c.elements, c.ndof, kernel, times.count(), times.min(), times.median(), times.max());
+  fflush(out);
+}
+
+// The meshes of the components (copies, every component can be refined differently).
+static Hermes::vector<MeshSharedPtr> create_meshes(int num_components, int refinements)
+{
+  Hermes::vector<MeshSharedPtr> meshes;
+  meshes.push_back(MeshSharedPtr(new Mesh));
+  create_benchmark_mesh(meshes[0], refinements);
+  for (int i = 1; i < num_components; i++)
+  {
+    meshes.push_back(MeshSharedPtr(new Mesh));
+    meshes[i]->copy(meshes[0]);
+  }
+  return meshes;
+}
+
+template<typename Scalar>
+static Hermes::vector<MeshFunctionSharedPtr<Scalar> > create_functions(const Hermes::vector<MeshSharedPtr>& meshes)
+{
+  Hermes::vector<MeshFunctionSharedPtr<Scalar> > functions;
+  for (unsigned int i = 0; i < meshes.size(); i++)
+    functions.push_back(new BenchmarkFunction<Scalar>(meshes[i], 3. + i));
+  return functions;
+}
+
+template<typename Scalar>
+static Hermes::vector<MeshFunctionSharedPtr<Scalar> > create_solutions(int num_components)
+{
+  Hermes::vector<MeshFunctionSharedPtr<Scalar> > solutions;
+  for (int i = 0; i < num_components; i++)
+    solutions.push_back(new Solution<Scalar>);
+  return solutions;
+}
+
+// The reference (globally refined) spaces.
+template<typename Scalar>
+static Hermes::vector<SpaceSharedPtr<Scalar> > create_ref_spaces(const Hermes::vector<SpaceSharedPtr<Scalar> >& spaces)
+{
+  Hermes::vector<SpaceSharedPtr<Scalar> > ref_spaces;
+  for (unsigned int i = 0; i < spaces.size(); i++)
+  {
+    Mesh::ReferenceMeshCreator ref_mesh_creator(spaces[i]->get_mesh());
+    MeshSharedPtr ref_mesh = ref_mesh_creator.create_ref_mesh();
+    typename Space<Scalar>::ReferenceSpaceCreator ref_space_creator(spaces[i], ref_mesh);
+    ref_spaces.push_back(ref_space_creator.create_ref_space());
+  }
+  return ref_spaces;
+}
+
+template<typename Scalar>
+static void run_case(BenchmarkScenario<Scalar>* scenario, BenchmarkCase& c, FILE* out)
+{
+  HermesCommonApi.set_integral_param_value(numThreads, c.threads);
+  int num_components = scenario->get_num_components();
+
+  Hermes::vector<MeshSharedPtr> meshes = create_meshes(num_components, c.refinements);
+  Hermes::vector<SpaceSharedPtr<Scalar> > spaces = scenario->create_spaces(meshes, c.order);
+  c.elements = meshes[0]->get_num_active_elements();
+  c.ndof = Space<Scalar>::get_num_dofs(spaces);
+  std::cerr << "Case " << c.scenario << ", " << c.refinements << " refinements, order " << c.order << ", " << c.threads
+    << " threads: " << c.elements << " elements, " << c.ndof << " DOFs." << std::endl;
+
+  // Traversal.
+  KernelTimes traverse_times;
+  for (int repeat = -1; repeat < c.repeats; repeat++)
+  {
+    Traverse trav(num_components);
+    int num_states;
+    traverse_times.begin(repeat);
+    Traverse::State** states = trav.get_states(meshes, num_states);
+    traverse_times.end();
+    for (int i = 0; i < num_states; i++)
+      delete states[i];
+    free_with_check(states);
+  }
+  write_result(out, c, "traverse", traverse_times);
+
+  // Projection.
+  Hermes::vector<MeshFunctionSharedPtr<Scalar> > functions = create_functions<Scalar>(meshes);
+  CaseData<Scalar> data;
+  Scalar* coeffs = data.coeffs = malloc_with_check<Scalar>(c.ndof);
+  KernelTimes projection_times;
+  for (int repeat = -1; repeat < c.repeats; repeat++)
+  {
+    projection_times.begin(repeat);
+    OGProjection<Scalar>::project_global(spaces, functions, coeffs);
+    projection_times.end();
+  }
+  write_result(out, c, "projection", projection_times);
+
+  // Assembling (the warm-up creates the sparse structure).
+  DiscreteProblem<Scalar> dp(scenario->get_weak_form(), spaces);
+  CSCMatrix<Scalar> matrix;
+  SimpleVector<Scalar> rhs(c.ndof);
+  KernelTimes assemble_times;
+  for (int repeat = -1; repeat < c.repeats; repeat++)
+  {
+    assemble_times.begin(repeat);
+    dp.assemble(coeffs, &matrix, &rhs);
+    assemble_times.end();
+  }
+  write_result(out, c, "assemble", assemble_times);
+
+  // Solutions.
+  Hermes::vector<MeshFunctionSharedPtr<Scalar> > solutions = create_solutions<Scalar>(num_components);
+  KernelTimes solution_times;
+  for (int repeat = -1; repeat < c.repeats; repeat++)
+  {
+    solution_times.begin(repeat);
+    Solution<Scalar>::vector_to_solutions(coeffs, spaces, solutions);
+    solution_times.end();
+  }
+  write_result(out, c, "set_coeff_vector", solution_times);
+
+  // Errors.
+  Hermes::vector<SpaceSharedPtr<Scalar> > ref_spaces = create_ref_spaces(spaces);
+  int ref_ndof = Space<Scalar>::get_num_dofs(ref_spaces);
+  Scalar* ref_coeffs = data.ref_coeffs = malloc_with_check<Scalar>(ref_ndof);
+  Hermes::vector<MeshFunctionSharedPtr<Scalar> > ref_solutions = create_solutions<Scalar>(num_components);
+  OGProjection<Scalar>::project_global(ref_spaces, functions, ref_coeffs);
+  Solution<Scalar>::vector_to_solutions(ref_coeffs, ref_spaces, ref_solutions);
+
+  ErrorCalculator<Scalar>* errorCalculator = data.errorCalculator = scenario->create_error_calculator();
+  KernelTimes error_times;
+  for (int repeat = -1; repeat < c.repeats; repeat++)
+  {
+    error_times.begin(repeat);
+    errorCalculator->calculate_errors(solutions, ref_solutions);
+    error_times.end();
+  }
+  write_result(out, c, "calculate_errors", error_times);
+
+  // Linearization.
+  Views::Linearizer linearizer(FileExport);
+  MeshFunctionSharedPtr<double> linearized_function = benchmark_real_part(solutions[0]);
+  KernelTimes linearizer_times;
+  for (int repeat = -1; repeat < c.repeats; repeat++)
+  {
+    linearizer_times.begin(repeat);
+    linearizer.process_solution(linearized_function);
+    linearizer_times.end();
+  }
+  write_result(out, c, "linearize", linearizer_times);
+
+  // Adaptivity, every run on new meshes & spaces (with the same solutions).
+  Hermes::vector<Selector<Scalar>*>& selectors = data.selectors;
+  for (int i = 0; i < num_components; i++)
+    selectors.push_back(scenario->create_selector(i));
+  AdaptStoppingCriterionCumulative<Scalar> stoppingCriterion(ADAPT_THRESHOLD);
+  KernelTimes adapt_times;
+  for (int repeat = -1; repeat < c.repeats; repeat++)
+  {
+    Hermes::vector<MeshSharedPtr> adapt_meshes = create_meshes(num_components, c.refinements);
+    Hermes::vector<SpaceSharedPtr<Scalar> > adapt_spaces = scenario->create_spaces(adapt_meshes, c.order);
+    Hermes::vector<SpaceSharedPtr<Scalar> > adapt_ref_spaces = create_ref_spaces(adapt_spaces);
+    Hermes::vector<MeshFunctionSharedPtr<Scalar> > adapt_solutions = create_solutions<Scalar>(num_components);
+    Hermes::vector<MeshFunctionSharedPtr<Scalar> > adapt_ref_solutions = create_solutions<Scalar>(num_components);
+    Solution<Scalar>::vector_to_solutions(coeffs, adapt_spaces, adapt_solutions);
+    Solution<Scalar>::vector_to_solutions(ref_coeffs, adapt_ref_spaces, adapt_ref_solutions);
+    errorCalculator->calculate_errors(adapt_solutions, adapt_ref_solutions);
+
+    Adapt<Scalar> adaptivity(adapt_spaces, errorCalculator, &stoppingCriterion);
+    adapt_times.begin(repeat);
+    adaptivity.adapt(selectors);
+    adapt_times.end();
+  }
+  write_result(out, c, "adapt", adapt_times);
+}
+
+template<typename Scalar>
+static void run_scenario(BenchmarkScenario<Scalar>* scenario, const std::vector<int>& refinements, const std::vector<int>& orders,
+  const std::vector<int>& threads, int repeats, FILE* out)
+{
+  for (unsigned int refinements_i = 0; refinements_i < refinements.size(); refinements_i++)
+  for (unsigned int order_i = 0; order_i < orders.size(); order_i++)
+  for (unsigned int threads_i = 0; threads_i < threads.size(); threads_i++)
+  {
+    BenchmarkCase c;
+    c.scenario = scenario->get_name();
+    c.refinements = refinements[refinements_i];
+    c.order = orders[order_i];
+    c.threads = threads[threads_i];
+    c.repeats = repeats;
+    try
+    {
+      run_case(scenario, c, out);
+    }
+    catch (Hermes::Exceptions::Exception& e)
+    {
+      std::cerr << "Case " << c.scenario << " failed: " << e.info() << std::endl;
+    }
+  }
+}
+
+static std::vector<std::string> split(const std::string& list)
+{
+  std::vector<std::string> items;
+  std::stringstream stream(list);
+  std::string item;
+  while (std::getline(stream, item, ','))
+  if (!item.empty())
+    items.push_back(item);
+  return items;
+}
+
+static std::vector<int> split_int(const std::string& list)
+{
+  std::vector<int> items;
+  std::vector<std::string> strings = split(list);
+  for (unsigned int i = 0; i < strings.size(); i++)
+    items.push_back(atoi(strings[i].c_str()));
+  return items;
+}
+
+int main(int argc, char* argv[])
+{
+  std::vector<std::string> scenarios = split("poisson,elasticity,navier-stokes,helmholtz,advection-dg");
+  std::vector<int> refinements = split_int("3,4");
+  std::vector<int> orders = split_int("2,4");
+  std::vector<int> threads;
+  threads.push_back(1);
+  if (HermesCommonApi.get_integral_param_value(numThreads) > 1)
+    threads.push_back(HermesCommonApi.get_integral_param_value(numThreads));
+  int repeats = DEFAULT_REPEATS;
+  std::string output;
+
+  for (int i = 1; i < argc; i++)
+  {
+    std::string argument = argv[i];
+    if (i + 1 == argc)
+    {
+      std::cerr << "Missing the value of " << argument << "." << std::endl;
+      return -1;
+    }
+    std::string value = argv[++i];
+    if (argument == "--scenarios")
+      scenarios = split(value);
+    else if (argument == "--refinements")
+      refinements = split_int(value);
+    else if (argument == "--orders")
+      orders = split_int(value);
+    else if (argument == "--threads")
+      threads = split_int(value);
+    else if (argument == "--repeats")
+      repeats = std::max(1, atoi(value.c_str()));
+    else if (argument == "--output")
+      output = value;
+    else
+    {
+      std::cerr << "Unknown argument " << argument << "." << std::endl;
+      return -1;
+    }
+  }
+
+  FILE* out = stdout;
+  if (!output.empty())
+  {
+    out = fopen(output.c_str(), "w");
+    if (!out)
+    {
+      std::cerr << "Cannot open " << output << "." << std::endl;
+      return -1;
+    }
+  }
+  write_header(out);
+
+  for (unsigned int i = 0; i < scenarios.size(); i++)
+  {
+    if (scenarios[i] == "poisson")
+    {
+      PoissonScenario scenario;
+      run_scenario(&scenario, refinements, orders, threads, repeats, out);
+    }
+    else if (scenarios[i] == "elasticity")
+    {
+      ElasticityScenario scenario;
+      run_scenario(&scenario, refinements, orders, threads, repeats, out);
+    }
+    else if (scenarios[i] == "navier-stokes")
+    {
+      NavierStokesScenario scenario;
+      run_scenario(&scenario, refinements, orders, threads, repeats, out);
+    }
+    else if (scenarios[i] == "helmholtz")
+    {
+      HelmholtzScenario scenario;
+      run_scenario(&scenario, refinements, orders, threads, repeats, out);
+    }
+    else if (scenarios[i] == "advection-dg")
+    {
+      AdvectionDGScenario scenario;
+      run_scenario(&scenario, refinements, orders, threads, repeats, out);
+    }
+    else
+      std::cerr << "Unknown scenario " << scenarios[i] << "." << std::endl;
+  }
+
+  if (out != stdout)
+    fclose(out);
+  return 0;
+}
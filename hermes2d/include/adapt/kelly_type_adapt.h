@@ -12,34 +12,34 @@
 //
 // You should have received a copy of the GNU General Public License
 // along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
-/*
-#ifndef KELLY_TYPE_ADAPT_H
-#define KELLY_TYPE_ADAPT_H
 
-#include "adapt.h"
+#ifndef __H2D_KELLY_TYPE_ADAPT_H
+#define __H2D_KELLY_TYPE_ADAPT_H
+
+#include "error_calculator.h"
 #include "../neighbor_search.h"
-#include "../discrete_problem.h"
+#include "../mesh/traverse.h"
 
 namespace Hermes
 {
   namespace Hermes2D
   {
     /// Functor representing the interface estimator scaling function.
-    class InterfaceEstimatorScalingFunction
+    class HERMES_API InterfaceEstimatorScalingFunction
     {
-      private:
-        virtual double value(double e_diam, const std::string& e_marker) const = 0;
-        template<typename Scalar> friend class KellyTypeAdapt;
+    public:
+      virtual ~InterfaceEstimatorScalingFunction() {}
+      virtual double value(double e_diam, const std::string& e_marker) const = 0;
     };
 
     /// Pre-defined function used for scaling interface error estimates (see the KellyTypeAdapt constructor).
-    class ScaleByElementDiameter : public InterfaceEstimatorScalingFunction
+    class HERMES_API ScaleByElementDiameter : public InterfaceEstimatorScalingFunction
     {
-      private:
-        virtual double value(double e_diam, const std::string& e_marker) const {
-          return e_diam;
-        }
-        template<typename Scalar> friend class KellyTypeAdapt;
+    public:
+      virtual double value(double e_diam, const std::string& e_marker) const
+      {
+        return e_diam;
+      }
     };
 
     /// \class KellyTypeAdapt
@@ -51,6 +51,14 @@ namespace Hermes
     /// the Kelly error estimator ([1]) where a sum of the L2 norms of element residual and jumps of
     /// solution gradients across the element boundaries defines the element error.
     ///
+    /// The class is an ErrorCalculator, so it is passed to Adapt in the same way as e.g. DefaultErrorCalculator,
+    /// only the errors are calculated from the coarse solution(s) alone (see calculate_errors()).
+    ///
+    /// The evaluation runs in parallel (see Mixins::Parallel). Volumetric and boundary estimators are evaluated
+    /// over the multi-mesh traversal states, interface estimators over a list of inner edges which, with
+    /// \c ignore_visited_segments, contains every interface only once. Every thread accumulates into its own
+    /// element error arrays which are summed up at the end, so no atomic updates are needed.
+    ///
     /// References:
     ///  [1] Kelly D. W., Gago O. C., Zienkiewicz O. C., Babuska I.:
     ///&nbsp;    A posteriori error analysis and adaptive processes in the finite element method: Part I—error analysis.
@@ -63,7 +71,7 @@ namespace Hermes
     ///&nbsp;    6th ed. (2005), Elsevier.
     ///
     template<typename Scalar>
-    class HERMES_API KellyTypeAdapt : public Adapt<Scalar>
+    class HERMES_API KellyTypeAdapt : public ErrorCalculator<Scalar>
     {
     public:
       /// Class representing the weak form of an error estimator.
@@ -74,112 +82,46 @@ namespace Hermes
       ///&nbsp;- i     ... with a multi-component solution, this defines for which component this estimate applies,
       ///&nbsp;- area  ... defines in which geometric parts of the domain should the estimate be used - e.g. by defining
       ///&nbsp;            area = H2D_DG_INNER_EDGE, errors at element interfaces will be tracked by the estimator,
-      ///&nbsp;- ext   ... vector with external functions possibly used within the estimator (e.g. previous time-level
-      ///&nbsp;            solutions appearing in the residual) - currently not used.
+      ///&nbsp;- ext   ... vector with external functions possibly used within the volumetric and boundary estimators
+      ///&nbsp;            (e.g. previous time-level solutions appearing in the residual), not used for interfaces.
       ///
-      /// Every estimator form must also implement the two methods \c ord and \c value, which are used for determining
-      /// the integration order and for the actual evaluation of the form, respectively. During the evaluation, their
-      /// parameters will be interpreted as follows:
+      /// Every estimator form must implement the method \c value, which is evaluated with the maximum integration order
+      /// (as in ErrorThreadCalculator). Its parameters are interpreted as follows:
       ///
       ///&nbsp;- int n,                 ... number of integration points in the currently processed element
       ///&nbsp;- double *wt,            ... corresponding integration weights
-      ///&nbsp;- Func\<Scalar\> *u[],   ... all solution components
+      ///&nbsp;- Func\<Scalar\> *u[],   ... all solution components (nullptr for interface estimators)
       ///&nbsp;- Func\<double\> *u,     ... currently processed solution component
       ///&nbsp;- Geom\<double\> *e,     ... geometric data of the currently processed element
       ///
-      class HERMES_API ErrorEstimatorForm : public Form<Scalar>
+      class HERMES_API ErrorEstimatorForm
       {
       public:
-        int i; ///< Component.
-        std::string area; ///< Geometric region where this estimator is applied.
-        Hermes::vector<MeshFunctionSharedPtr<Scalar> > ext; ///< Additional functions required by the estimator.
-        /// Set this error form to be an interface one.
-        void setAsInterface();
         /// Constructor.
         ErrorEstimatorForm(int i, std::string area = HERMES_ANY,
-                           Hermes::vector<MeshFunctionSharedPtr<Scalar> > ext = Hermes::vector<MeshFunctionSharedPtr<Scalar> >())
-          : i(i), area(area), ext(ext) {}
+          Hermes::vector<MeshFunctionSharedPtr<Scalar> > ext = Hermes::vector<MeshFunctionSharedPtr<Scalar> >());
+        virtual ~ErrorEstimatorForm() {}
+
+        /// Set this error form to be an interface one.
+        void setAsInterface();
 
         /// Value calculation.
         virtual Scalar value(int n, double *wt, Func<Scalar> *u_ext[],
-                             DiscontinuousFunc<Scalar> *u, Geom<double> *e,
-                             Func<Scalar> **ext) const
-        {
-          throw Exceptions::MethodNotOverridenException("KellyTypeAdapt::ErrorEstimatorForm::value()");
-          return 0.0;
-        }
+          DiscontinuousFunc<Scalar> *u, Geom<double> *e,
+          Func<Scalar> **ext) const = 0;
 
         /// Integration order.
+        /// \deprecated Not called anymore, the estimators are evaluated with the maximum integration order.
+        /// Kept so that the existing estimator forms overriding it still compile.
         virtual Hermes::Ord ord(int n, double *wt, Func<Hermes::Ord> *u_ext[],
-                                DiscontinuousFunc<Hermes::Ord> *u, Geom<Hermes::Ord> *e,
-                                Func<Ord> **ext) const
-        {
-          throw Exceptions::MethodNotOverridenException("KellyTypeAdapt::ErrorEstimatorForm::ord().");
-          return Hermes::Ord();
-        }
+          DiscontinuousFunc<Hermes::Ord> *u, Geom<Hermes::Ord> *e,
+          Func<Ord> **ext) const;
 
-        /// FIXME - temporary
-        KellyTypeAdapt *adapt;
+        int i; ///< Component.
+        std::string area; ///< Geometric region where this estimator is applied.
+        Hermes::vector<MeshFunctionSharedPtr<Scalar> > ext; ///< Additional functions required by the estimator.
       };
 
-    protected:
-      DiscreteProblem<Scalar> dp; // Only needed for gaining access to NeighborSearch methods.
-
-      ///
-      /// Functions used for evaluating the actual error estimator forms for an active element or edge segment.
-      ///
-      double eval_volumetric_estimator(typename KellyTypeAdapt::ErrorEstimatorForm* err_est_form,
-                                       RefMap* rm);
-      double eval_boundary_estimator(typename KellyTypeAdapt::ErrorEstimatorForm* err_est_form,
-                                     RefMap* rm,
-                                     SurfPos* surf_pos);
-      double eval_interface_estimator(typename KellyTypeAdapt::ErrorEstimatorForm* err_est_form,
-                                      RefMap *rm,
-                                      SurfPos* surf_pos,
-                                      LightArray<NeighborSearch<Scalar>*>& neighbor_searches,
-                                      int neighbor_index);
-      double eval_solution_norm(typename Adapt<Scalar>::MatrixFormVolError* form,
-                                RefMap* rm,
-                                MeshFunctionSharedPtr<Scalar> sln);
-
-      ///
-      /// Linear forms used to calculate the error estimator value for each component.
-      ///
-      Hermes::vector<typename KellyTypeAdapt::ErrorEstimatorForm *> error_estimators_vol;
-      Hermes::vector<typename KellyTypeAdapt::ErrorEstimatorForm *> error_estimators_surf;
-
-      Mesh::ElementMarkersConversion element_markers_conversion;
-      Mesh::BoundaryMarkersConversion boundary_markers_conversion;
-
-      /// Scaling of the interface error estimates. May be specified by the user during construction.
-      ///
-      Hermes::vector<const InterfaceEstimatorScalingFunction*> interface_scaling_fns;
-      bool use_aposteriori_interface_scaling; ///< Specifies whether the interface error estimators for each
-                                              ///< component will be multiplied by \c interface_scaling_fns
-                                              ///< after being evaluated.
-
-      ///
-      /// Constant scaling. Reserved for the derived classes, not to be used by the user explicitly.
-      ///
-      double interface_scaling_const;   ///< Constant scaling of the boundary error estimates.
-      double volumetric_scaling_const;  ///< Constant scaling of the volumetric error estimates (like the residual norm).
-      double boundary_scaling_const;    ///< Constant scaling of the boundary error estimates.
-
-      /// Specifies whether the interface error estimator will be evaluated from each side of each interface
-      /// (when <c>ignore_visited_segments == false</c> ), or only once for each interface
-      /// (<c>ignore_visited_segments == true</c>).
-      bool ignore_visited_segments;
-
-      /// Calculates error estimates for each solution component, the total error estimate, and possibly also
-      /// their normalizations. If called with a pair of solutions, the version from Adapt is used (this is e.g.
-      /// done when comparing approximate solution to the exact one - in this case, we do not want to compute
-      /// the Kelly estimator value, but rather the ordinary difference between the solutions).
-      virtual double calc_err_internal(Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns,
-                                       Hermes::vector<double>* component_errors,
-                                       unsigned int error_flags);
-
-    public:
-
       /// Constructor.
       ///
       /// \param[in]  spaces_   Approximation space of each solution component.
@@ -200,98 +142,150 @@ namespace Hermes
       /// \param[in]  interface_scaling_fns_  Specifies functions used for scaling the interface error estimator for
       ///&nbsp;                                  each component. The scale is defined as a real function of the element
       ///&nbsp;                                  diameter (and possibly equation coefficients associated to the element)
-      ///&nbsp;                                  and multiplies the result of the interface estimators. It may thus be already
-      ///&nbsp;                                  present in the interface estimator forms themselves, in which case call
-      ///&nbsp;                                  \c disable_aposteriori_interface_scaling. In this case, it may also be required
-      ///&nbsp;                                  that \c ignore_visited_segments be false in order to always ensure that the
-      ///&nbsp;                                  diameter belongs to the element whose error is being calculated.
+      ///&nbsp;                                  and multiplies the result of the interface estimators. The functions
+      ///&nbsp;                                  are owned (and deleted) by this class.
       /// \param[in]  norms_    Norms used for making relative error estimates.
       ///&nbsp;                    If not specified, they are defined according to the spaces.
-      ///
+      /// \param[in]  errorType Absolute / relative errors.
       ///
       KellyTypeAdapt(Hermes::vector<SpaceSharedPtr<Scalar> > spaces,
-                     bool ignore_visited_segments = true,
-                     Hermes::vector<const InterfaceEstimatorScalingFunction*>
-                       interface_scaling_fns_ = Hermes::vector<const InterfaceEstimatorScalingFunction*>(),
-                     Hermes::vector<NormType> norms_ = Hermes::vector<NormType>());
+        bool ignore_visited_segments = true,
+        Hermes::vector<const InterfaceEstimatorScalingFunction*> interface_scaling_fns_ = Hermes::vector<const InterfaceEstimatorScalingFunction*>(),
+        Hermes::vector<NormType> norms_ = Hermes::vector<NormType>(),
+        CalculatedErrorType errorType = RelativeErrorToGlobalNorm);
 
       KellyTypeAdapt(SpaceSharedPtr<Scalar> space,
-                     bool ignore_visited_segments = true,
-                     const InterfaceEstimatorScalingFunction* interface_scaling_fn_ = nullptr,
-                     NormType norm_ = HERMES_UNSET_NORM);
+        bool ignore_visited_segments = true,
+        const InterfaceEstimatorScalingFunction* interface_scaling_fn_ = nullptr,
+        NormType norm_ = HERMES_UNSET_NORM,
+        CalculatedErrorType errorType = RelativeErrorToGlobalNorm);
 
       /// Destructor.
-      virtual ~KellyTypeAdapt()
-      {
-        for (unsigned int i = 0; i < error_estimators_surf.size(); i++)
-          delete error_estimators_surf[i];
-        error_estimators_surf.clear();
-
-        for (unsigned int i = 0; i < error_estimators_vol.size(); i++)
-          delete error_estimators_vol[i];
-        error_estimators_vol.clear();
-
-        for (unsigned int i = 0; i < interface_scaling_fns.size(); i++)
-          delete interface_scaling_fns[i];
-        interface_scaling_fns.clear();
-      }
-
-      Mesh::ElementMarkersConversion* get_element_markers_conversion()
-      {
-        return &this->element_markers_conversion;
-      }
-      Mesh::BoundaryMarkersConversion* get_boundary_markers_conversion()
-      {
-        return &this->boundary_markers_conversion;
-      }
+      virtual ~KellyTypeAdapt();
 
       /// Append volumetric error estimator form.
       ///
       /// For example, element residual norms may be represented by such a form.
       ///
       /// \param[in]  form ... object representing the form. A class derived from \c KellyTypeAdapt::ErrorEstimatorForm
-      ///&nbsp;                   defines its datatype.
+      ///&nbsp;                   defines its datatype. The form is owned (and deleted) by this class.
       ///
       void add_error_estimator_vol(ErrorEstimatorForm* form);
 
       /// Append boundary or interface error estimator form.
       ///
-      /// Interface form is defined by <c> form::area == H2D_DG_INNER_EDGE </c>. The effective types for \c u_ext, \c u
-      /// and \c e (three of the obligatory parameters of form::value() and form::ord()) will then be, respectively
-      /// \c DiscontinuousFunc*[], \c DiscontinuousFunc* and \c InterfaceGeom*.
+      /// Interface form is defined by <c> form::area == H2D_DG_INNER_EDGE </c>. The effective types for \c u
+      /// and \c e will then be \c DiscontinuousFunc* and \c InterfaceGeom*.
       ///
       void add_error_estimator_surf(ErrorEstimatorForm* form);
 
-      ///
-      /// The following two methods calculate the error of the given \c sln, using \code calc_err_internal \endcode.
-      ///
+      /// If called with a pair of solutions, the version from ErrorCalculator is used (this is e.g.
+      /// done when comparing approximate solution to the exact one - in this case, we do not want to compute
+      /// the Kelly estimator value, but rather the ordinary difference between the solutions).
+      using ErrorCalculator<Scalar>::calculate_errors;
+
+      /// Calculates error estimates for each solution component, the total error estimate, and the norms
+      /// used for making the errors relative.
+      /// \param[in] sort_and_store If true, these errors are going to be sorted, stored and used for the purposes of adaptivity.
+      void calculate_errors(Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns, bool sort_and_store = true);
 
-      double calc_err_est(MeshFunctionSharedPtr<Scalar>sln,
-                          unsigned int error_flags = HERMES_TOTAL_ERROR_REL | HERMES_ELEMENT_ERROR_REL)
+      /// Calculates error estimates of a single-component solution.
+      void calculate_errors(MeshFunctionSharedPtr<Scalar> sln, bool sort_and_store = true);
+
+      void disable_aposteriori_interface_scaling() { use_aposteriori_interface_scaling = false; }
+
+      void set_volumetric_scaling_const(double C) { volumetric_scaling_const = C; }
+      void set_boundary_scaling_const(double C) { boundary_scaling_const = C; }
+
+    protected:
+      /// State querying helpers.
+      virtual bool isOkay() const;
+      inline std::string getClassName() const { return "KellyTypeAdapt"; }
+
+      /// One (part of an) inner edge processed by the interface estimators.
+      struct InterfaceEdge
       {
-        if(this->num != 1)
-          throw Exceptions::Exception("Wrong number of solutions.");
-        Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns;
-        slns.push_back(sln);
-        return calc_err_est(slns, nullptr, error_flags);
-      }
+        InterfaceEdge(int component, Element* e, int isurf) : component(component), e(e), isurf(isurf) {};
+        int component;
+        Element* e;
+        int isurf;
+      };
 
-      double calc_err_est(Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns,
-                          Hermes::vector<double>* component_errors = nullptr,
-                          unsigned int error_flags = HERMES_TOTAL_ERROR_REL | HERMES_ELEMENT_ERROR_REL)
+      /// Data owned by one thread of the parallel evaluation.
+      struct ThreadData
       {
-        return calc_err_internal(slns, component_errors, error_flags);
-      }
+        /// Clones of the solutions / external functions (their RefMaps and caches are then thread-local).
+        Solution<Scalar>** slns;
+        MeshFunction<Scalar>** ext;
+        /// Values of the solutions and of the external functions at the quadrature points, allocated once and
+        /// refilled on every element / edge. The solution components are also wrapped as (central) discontinuous
+        /// functions, which is what the estimator forms get as \c u.
+        Func<Scalar>** u;
+        DiscontinuousFunc<Scalar>** u_discontinuous;
+        Func<Scalar>** ext_fns;
+        int ext_fns_count;
+        /// One NeighborSearch per component, moved from one interface edge to another.
+        NeighborSearch<Scalar>* neighbor_searches[H2D_MAX_COMPONENTS];
+        /// Thread-local element errors and norms, summed up after the parallel region.
+        double* errors[H2D_MAX_COMPONENTS];
+        double* norms[H2D_MAX_COMPONENTS];
+      };
+
+      /// Allocates the thread-local storage (see ThreadData).
+      void init_thread_data(ThreadData& data);
+
+      /// Frees the thread-local storage.
+      void free_thread_data(ThreadData& data);
 
-      /// Refines the elements selected by the \code RefinementSelectors::HOnlySelector \endcode according
-      /// to the errors calculated by \code calc_err_est \endcode.
+      /// Fills ThreadData::u with the values of the solutions on the current geometry.
+      void init_solution_values(ThreadData& data, int order);
+
+      /// Fills the list of inner edges (see InterfaceEdge) processed by the interface estimators.
+      void init_interface_edges();
+
+      /// Volumetric & boundary estimators and norms on one traversal state.
+      void evaluate_one_state(Traverse::State* current_state, ThreadData& data);
+
+      /// Interface estimators on one (part of an) inner edge.
+      void evaluate_interface(const InterfaceEdge& edge, ThreadData& data);
+
+      /// Evaluates the form on the current geometry, ThreadData::u has to be filled by init_solution_values().
+      double eval_estimator(ErrorEstimatorForm* form, int ext_offset, ThreadData& data, int order, int n, double* jwt, Geom<double>* geometry);
+
+      /// Linear forms used to calculate the error estimator value for each component.
+      Hermes::vector<ErrorEstimatorForm *> error_estimators_vol;
+      Hermes::vector<ErrorEstimatorForm *> error_estimators_surf;
+
+      /// All external functions of the volumetric and boundary estimators, with the offset of each estimator's
+      /// functions in this vector.
+      Hermes::vector<MeshFunctionSharedPtr<Scalar> > ext_functions;
+      Hermes::vector<int> ext_offsets_vol;
+      Hermes::vector<int> ext_offsets_surf;
+
+      /// Inner edges processed by the interface estimators.
+      Hermes::vector<InterfaceEdge> interface_edges;
+
+      /// Scaling of the interface error estimates. May be specified by the user during construction.
       ///
-      bool adapt(double thr, int strat = 0, int regularize = -1, double to_be_processed = 0.0);
+      Hermes::vector<const InterfaceEstimatorScalingFunction*> interface_scaling_fns;
+      bool use_aposteriori_interface_scaling; ///< Specifies whether the interface error estimators for each
+                                              ///< component will be multiplied by \c interface_scaling_fns
+                                              ///< after being evaluated.
 
-      void disable_aposteriori_interface_scaling() { use_aposteriori_interface_scaling = false; }
+      ///
+      /// Constant scaling. Reserved for the derived classes, not to be used by the user explicitly.
+      ///
+      double interface_scaling_const;   ///< Constant scaling of the boundary error estimates.
+      double volumetric_scaling_const;  ///< Constant scaling of the volumetric error estimates (like the residual norm).
+      double boundary_scaling_const;    ///< Constant scaling of the boundary error estimates.
 
-      void set_volumetric_scaling_const(double C) { volumetric_scaling_const = C; }
-      void set_boundary_scaling_const(double C) { boundary_scaling_const = C; }
+      /// Specifies whether the interface error estimator will be evaluated from each side of each interface
+      /// (when <c>ignore_visited_segments == false</c> ), or only once for each interface
+      /// (<c>ignore_visited_segments == true</c>).
+      bool ignore_visited_segments;
+
+    private:
+      void init(Hermes::vector<SpaceSharedPtr<Scalar> > spaces, Hermes::vector<NormType> norms);
     };
 
     /// \class BasicKellyAdapt
@@ -319,28 +313,21 @@ namespace Hermes
         ErrorEstimatorFormKelly(int i = 0, double const_by_laplacian = 1.0);
 
         virtual Scalar value(int n, double *wt, Func<Scalar> *u_ext[],
-                             DiscontinuousFunc<Scalar> *u, Geom<double> *e,
-                             Func<Scalar> **ext) const
+          DiscontinuousFunc<Scalar> *u, Geom<double> *e,
+          Func<Scalar> **ext) const
         {
           Scalar result = 0.;
-          if(u->fn_central != nullptr)
-            for (int i = 0; i < n; i++)
-              result += wt[i] * Hermes::sqr( const_by_laplacian * ( e->nx[i] * u->dx[i] + e->ny[i] * u->dy[i]));
-          else
-            for (int i = 0; i < n; i++)
-              result += wt[i] * Hermes::sqr( const_by_laplacian * ( e->nx[i] * u->dx_neighbor[i] + e->ny[i] * u->dy_neighbor[i]));
+          for (int i = 0; i < n; i++)
+            result += wt[i] * Hermes::sqr(const_by_laplacian * (e->nx[i] * (u->dx[i] - u->dx_neighbor[i]) + e->ny[i] * (u->dy[i] - u->dy_neighbor[i])));
 
           return result;
         }
 
         virtual Hermes::Ord ord(int n, double *wt, Func<Hermes::Ord> *u_ext[],
-                                DiscontinuousFunc<Hermes::Ord> *u, Geom<Hermes::Ord> *e,
-                                Func<Ord> **ext) const
+          DiscontinuousFunc<Hermes::Ord> *u, Geom<Hermes::Ord> *e,
+          Func<Ord> **ext) const
         {
-          if(u->fn_central != nullptr)
-            return Hermes::sqr(u->dx[0] + u->dy[0]);
-          else
-            return Hermes::sqr(u->dx_neighbor[0] + u->dy_neighbor[0]);
+          return Hermes::sqr(u->dx[0] + u->dy[0]);
         }
 
       private:
@@ -352,12 +339,12 @@ namespace Hermes
       /// For the equation \f$ -K \Delta u = f \f$, the argument \c const_by_laplacian is equal to \$ K \$.
       ///
       BasicKellyAdapt(Hermes::vector<SpaceSharedPtr<Scalar> > spaces_,
-                      double const_by_laplacian = 1.0,
-                      Hermes::vector<NormType> norms_ = Hermes::vector<NormType>())
+        double const_by_laplacian = 1.0,
+        Hermes::vector<NormType> norms_ = Hermes::vector<NormType>())
         : KellyTypeAdapt<Scalar>(spaces_, true, Hermes::vector<const InterfaceEstimatorScalingFunction*>(), norms_)
       {
         set_scaling_consts(const_by_laplacian);
-        for (int i = 0; i < this->num; i++)
+        for (int i = 0; i < this->component_count; i++)
           this->error_estimators_surf.push_back(new ErrorEstimatorFormKelly(i, const_by_laplacian));
       }
 
@@ -371,7 +358,7 @@ namespace Hermes
     private:
       void set_scaling_consts(double C)
       {
-        this->interface_scaling_const = 1./(24.*C);
+        this->interface_scaling_const = 1. / (24.*C);
         this->volumetric_scaling_const = this->interface_scaling_const;
         this->boundary_scaling_const = this->interface_scaling_const;
       }
@@ -379,4 +366,3 @@ namespace Hermes
   }
 }
 #endif
-*/
\ No newline at end of file
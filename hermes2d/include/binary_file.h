@@ -0,0 +1,138 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+#ifndef __H2D_BINARY_FILE_H
+#define __H2D_BINARY_FILE_H
+
+#include "global.h"
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    /// Contents of a binary checkpoint file.
+    enum BinaryFileKind
+    {
+      HERMES_BINARY_MESH = 1,
+      HERMES_BINARY_SPACE = 2,
+      HERMES_BINARY_SOLUTION = 3
+    };
+
+    /// Version of the binary checkpoint format written by BinaryFileWriter.
+    const uint32_t H2D_BINARY_FILE_VERSION = 1;
+
+    /// Writer of the binary checkpoint format.
+    ///
+    /// The format is flat and little-endian: a header (magic "H2DB", version, kind) followed
+    /// by a sequence of sections, every section being a (item count, item size) pair and the raw
+    /// items, padded to 8 bytes. Data are written as struct-of-arrays, so that every array is
+    /// written by a single fwrite() and read back directly from the memory-mapped file.
+    /// @ingroup inner
+    class HERMES_API BinaryFileWriter
+    {
+    public:
+      BinaryFileWriter(const char* filename, BinaryFileKind kind);
+      /// Closes the file if close() has not been called, ignoring the errors.
+      ~BinaryFileWriter();
+
+      /// Flushes and closes the file, throws an IOException if the data could not be written (e.g. a full disk).
+      void close();
+
+      /// Writes a section of count items.
+      template<typename T>
+      void write(const T* data, uint64_t count)
+      {
+        this->write_raw(data, sizeof(T), count);
+      }
+
+      /// Writes a section with a single item.
+      template<typename T>
+      void write_value(T value)
+      {
+        this->write_raw(&value, sizeof(T), 1);
+      }
+
+      /// Writes a section with the characters of the string.
+      void write_string(const std::string& string);
+
+    private:
+      void write_raw(const void* data, uint64_t item_size, uint64_t count);
+
+      FILE* file;
+      std::string filename;
+    };
+
+    /// Reader of the binary checkpoint format, see BinaryFileWriter.
+    /// The file is memory-mapped, the arrays returned by read() point directly to the mapping
+    /// and are valid until the reader is destroyed.
+    /// @ingroup inner
+    class HERMES_API BinaryFileReader
+    {
+    public:
+      BinaryFileReader(const char* filename, BinaryFileKind kind);
+      ~BinaryFileReader();
+
+      /// Reads a section, checks that the items are of type T.
+      /// \param[out] count The number of items.
+      template<typename T>
+      const T* read(uint64_t& count)
+      {
+        return (const T*)this->read_raw(sizeof(T), count);
+      }
+
+      /// Reads a section of exactly expected_count items of type T.
+      template<typename T>
+      const T* read(uint64_t expected_count, const char* what)
+      {
+        uint64_t count;
+        const T* data = this->read<T>(count);
+        if (count != expected_count)
+          throw Exceptions::Exception("Binary file %s: wrong number of items in '%s'.", this->filename.c_str(), what);
+        return data;
+      }
+
+      /// Reads a section with a single item.
+      template<typename T>
+      T read_value()
+      {
+        uint64_t count;
+        const T* data = this->read<T>(count);
+        if (count != 1)
+          throw Exceptions::Exception("Binary file %s: a single value expected.", this->filename.c_str());
+        return *data;
+      }
+
+      /// Reads a section written by BinaryFileWriter::write_string().
+      std::string read_string();
+
+    private:
+      const char* read_raw(uint64_t item_size, uint64_t& count);
+
+      /// Unmaps (frees) the data.
+      void release();
+
+      /// The whole (mapped) file.
+      char* data;
+      uint64_t size;
+      /// Current position in data.
+      uint64_t position;
+      /// Whether data is a mapping (otherwise it has been read to an allocated buffer).
+      bool mapped;
+
+      std::string filename;
+    };
+  }
+}
+#endif
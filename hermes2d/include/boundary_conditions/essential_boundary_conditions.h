@@ -60,6 +60,9 @@ namespace Hermes
       /// \param[in] n_y the y-component of the unit outer normal.
       /// \param[in] t_x the x-component of the tangent(perpendicular to normal).
       /// \param[in] t_y the y-component of the tangent(perpendicular to normal).
+      /// The projections of the boundary values to the boundary edges are calculated in parallel
+      /// (Space::assign_dofs(), Space::update_essential_bc_values()), so this method is called from several
+      /// threads at once. An implementation changing any shared state has to call set_thread_safe(false).
       virtual Scalar value(double x, double y, double n_x, double n_y, double t_x, double t_y) const = 0;
 
       /// Set the current time for time-dependent boundary conditions.
@@ -68,6 +71,21 @@ namespace Hermes
       /// Get the current time for time-dependent boundary conditions.
       double get_current_time() const;
 
+      /// Flags the condition as independent of the time: the projections of its values are not recalculated
+      /// by Space::update_essential_bc_values() (only by Space::assign_dofs()).
+      /// Constant conditions (DefaultEssentialBCConst) are time-independent by default.
+      void set_time_independent(bool to_set = true);
+
+      /// See set_time_independent().
+      bool is_time_independent() const;
+
+      /// Flags whether value() may be called concurrently (the default). If any condition of a space is not
+      /// thread-safe, the space calculates the projections of all its boundary edges in one thread.
+      void set_thread_safe(bool to_set = true);
+
+      /// See set_thread_safe().
+      bool is_thread_safe() const;
+
     protected:
       /// Special case of a constant function.
       Scalar value_const;
@@ -75,6 +93,12 @@ namespace Hermes
       /// Current time.
       double current_time;
 
+      /// The values do not depend on the time.
+      bool time_independent;
+
+      /// value() can be called from several threads at once.
+      bool thread_safe;
+
       /// Markers.
       Hermes::vector<std::string> markers;
 
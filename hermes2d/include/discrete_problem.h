@@ -37,6 +37,7 @@ namespace Hermes
     template<typename Scalar>
     class HERMES_API DiscreteProblem : 
       public Hermes::Mixins::TimeMeasurable, 
+      public Hermes::Mixins::Loggable, 
       public Hermes::Hermes2D::Mixins::SettableSpaces<Scalar>, 
       public Hermes::Mixins::StateQueryable,
       public Hermes::Hermes2D::Mixins::DiscreteProblemRungeKutta<Scalar>,
@@ -66,6 +67,8 @@ namespace Hermes
       void set_linear(bool to_set = true, bool dirichlet_lift_accordingly = true);
 
       /// Assembling.
+      /// The previous iterates calculated from coeff_vec are kept and reused in the next assembling with the same coefficient
+      /// vector (e.g. the jacobian following the residual at the same iterate), as long as the spaces do not change.
       void assemble(Scalar* coeff_vec, SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs = nullptr);
       /// Assembling.
       /// Without the matrix.
@@ -94,6 +97,25 @@ namespace Hermes
       /// Get all spaces as a Hermes::vector.
       Hermes::vector<SpaceSharedPtr<Scalar> >& get_spaces();
 
+      /// Measure the time spent integrating constant forms (see Form::set_constant()) and report
+      /// (using info() - verbose output has to be on) the time saved by reusing the integrals in each assembling.
+      void set_report_constant_forms_time_saved(bool to_set = true);
+      /// Estimate of the time saved by reusing the integrals of constant forms since the beginning.
+      /// Only measured if set_report_constant_forms_time_saved() is on.
+      double get_constant_forms_time_saved() const;
+
+      /// Reuse the integrals of constant volumetric matrix forms (see Form::set_constant()) among congruent affine elements,
+      /// i.e. elements with the same shape functions and the same (constant) inverse reference map.
+      /// Pays off on structured and semi-structured meshes, where the integration is mostly skipped.
+      /// All constant forms then must not depend on the position (the coordinates in Geom).
+      /// The number of hits is reported using info() (verbose output has to be on).
+      void set_reuse_congruent_elements(bool to_set = true);
+
+      /// Calculate the local matrices of the forms with constant coefficients (see MatrixFormVol::get_reference_coefficients())
+      /// on affine elements from the precalculated reference element integrals (see ReferenceIntegralTable) instead of the quadrature.
+      /// On by default.
+      void set_reference_integrals(bool to_set = true);
+
     protected:
       /// Initialize states.
       void init_assembling(Traverse::State**& states, int& num_states, Solution<Scalar>** u_ext_sln, Hermes::vector<MeshSharedPtr>& meshes);
@@ -127,6 +149,26 @@ namespace Hermes
       /// Select the right things to assemble
       DiscreteProblemSelectiveAssembler<Scalar> selectiveAssembler;
 
+      /// Integrals of constant forms.
+      DiscreteProblemConstantFormCache<Scalar> constantFormCache;
+      bool report_constant_forms_time_saved;
+      bool reuse_congruent_elements;
+      bool use_reference_integrals;
+
+      /// Previous iterates calculated from the coefficient vector of the last assembling (see assemble(Scalar*, ...)).
+      Solution<Scalar>** u_ext_sln_cache;
+      /// Copy of the coefficient vector, the seqs of the spaces and of their essential BC values (the Solutions contain
+      /// the Dirichlet lift) the previous iterates were calculated for.
+      Scalar* u_ext_coeff_vec_cache;
+      int* u_ext_space_seqs_cache;
+      unsigned int* u_ext_bc_values_seqs_cache;
+      int u_ext_ndof_cache;
+      /// The thread assemblers hold the copies of u_ext_sln_cache from the last assembling.
+      bool u_ext_sln_cache_in_threads;
+      /// Whether the cached previous iterates belong to this coefficient vector.
+      bool u_ext_cache_valid(Scalar* coeff_vec, int ndof) const;
+      void free_u_ext_cache();
+
       template<typename T> friend class Solver;
       template<typename T> friend class LinearSolver;
       template<typename T> friend class NonlinearSolver;
@@ -0,0 +1,153 @@
+/// This file is part of Hermes2D.
+///
+/// Hermes2D is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 2 of the License, or
+/// (at your option) any later version.
+///
+/// Hermes2D is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY;without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Hermes2D. If not, see <http:///www.gnu.org/licenses/>.
+
+#ifndef __H2D_DISCRETE_PROBLEM_CONSTANT_FORM_CACHE_H
+#define __H2D_DISCRETE_PROBLEM_CONSTANT_FORM_CACHE_H
+
+#include "hermes_common.h"
+#include "space/space.h"
+#include "mesh/refmap.h"
+#include "asmlist.h"
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    /// @ingroup inner
+    /// Discrete problem constant form cache class.
+    /// \brief Stores the element integrals of constant matrix forms (see Form::set_constant()) between assemblings.
+    ///
+    /// For every traversal state and every constant matrix form (and every boundary edge for surface forms),
+    /// the integrals of all pairs of basis / test functions are stored without the assembly list coefficients,
+    /// so that the Dirichlet lift is always calculated using the current values of the boundary conditions.
+    /// The cache is invalidated whenever any of the spaces, or any of the meshes used in the traversal changes.
+    ///
+    template<typename Scalar>
+    class HERMES_API DiscreteProblemConstantFormCache
+    {
+    public:
+      DiscreteProblemConstantFormCache();
+      ~DiscreteProblemConstantFormCache();
+
+      /// Free all data.
+      void free();
+
+      /// Checks that the stored integrals belong to the current spaces and meshes, frees them if not.
+      /// Has to be called before every assembling, the states have to come from the traversal of the meshes.
+      void prepare(const Hermes::vector<SpaceSharedPtr<Scalar> >& spaces, const Hermes::vector<MeshSharedPtr>& meshes, int num_states);
+
+      /// Returns the stored integrals of the form (identified by form_key) on the state, nullptr if there are none.
+      Scalar* get(int state_i, int form_key) const;
+
+      /// Allocates storage for the integrals of the form (identified by form_key) on the state.
+      Scalar* insert(int state_i, int form_key, int size);
+
+      /// Start of the statistics of one assembling.
+      void begin_statistics();
+
+      /// Adds the statistics of one assembling (of one thread).
+      /// \param[in] integrated_blocks Number of local matrices newly integrated and stored.
+      /// \param[in] integration_time Time spent in the integration of the integrated_blocks.
+      /// \param[in] reused_blocks Number of local matrices taken from the cache.
+      void add_statistics(int integrated_blocks, double integration_time, int reused_blocks);
+
+      /// Estimate of the time saved by the cache in the last assembling (based on the average time of integration of one block).
+      double get_last_time_saved() const;
+
+      /// Estimate of the time saved by the cache since the beginning.
+      double get_total_time_saved() const;
+
+      /// End of the statistics of one assembling.
+      void end_statistics();
+
+    private:
+      struct Block
+      {
+        int form_key;
+        Scalar* values;
+      };
+
+      /// Blocks for each state.
+      Hermes::vector<Block>* blocks;
+      int num_states;
+
+      /// Seq numbers of spaces & meshes the cache is valid for.
+      Hermes::vector<int> seqs;
+
+      /// Statistics.
+      int integrated_blocks;
+      double integration_time;
+      int last_reused_blocks;
+      double total_time_saved;
+    };
+
+    /// @ingroup inner
+    /// Discrete problem congruent element cache class.
+    /// \brief Stores the element integrals of constant matrix volumetric forms on affine elements, shared by all congruent elements.
+    ///
+    /// After uniform and graded refinements, most elements are translated copies of a few elements, and for forms with
+    /// constant coefficients their local matrices are identical. The integrals are identified by the form, the integration order,
+    /// the (quantised) constant inverse reference map and jacobian, the sub-element transformations and the shape function indices,
+    /// and stored without the assembly list coefficients.
+    /// Only valid for forms whose value does not depend on the position (e.g. through the coordinates in Geom).
+    /// One instance per assembling thread.
+    ///
+    template<typename Scalar>
+    class HERMES_API DiscreteProblemCongruentElementCache
+    {
+    public:
+      DiscreteProblemCongruentElementCache();
+      ~DiscreteProblemCongruentElementCache();
+
+      /// Free all data.
+      void free();
+
+      /// Sets the key of the local matrix of the form, the refmap has to have a constant jacobian.
+      void set_key(int form_key, int order, RefMap* rep_refmap, uint64_t sub_idx_i, uint64_t sub_idx_j, AsmList<Scalar>* als_i, AsmList<Scalar>* als_j);
+
+      /// Returns the integrals stored for the current key, nullptr if there are none.
+      Scalar* get();
+
+      /// Allocates storage for the integrals for the current key.
+      Scalar* insert(int size);
+
+      /// Statistics.
+      unsigned int get_lookups() const;
+      unsigned int get_hits() const;
+      unsigned int get_num_entries() const;
+
+    private:
+      struct Entry
+      {
+        int* key;
+        int key_length;
+        Scalar* values;
+      };
+
+      /// Entries by hash of their key.
+      std::map<uint64_t, Entry> entries;
+
+      /// Current key.
+      static const int max_key_length = 17 + 2 * H2D_MAX_LOCAL_BASIS_SIZE;
+      int current_key[max_key_length];
+      int current_key_length;
+      uint64_t current_hash;
+
+      unsigned int lookups;
+      unsigned int hits;
+    };
+  }
+}
+#endif
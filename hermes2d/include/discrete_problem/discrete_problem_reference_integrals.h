@@ -0,0 +1,109 @@
+/// This file is part of Hermes2D.
+///
+/// Hermes2D is free software: you can redistribute it and/or modify
+/// it under the terms of the GNU General Public License as published by
+/// the Free Software Foundation, either version 2 of the License, or
+/// (at your option) any later version.
+///
+/// Hermes2D is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY;without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with Hermes2D. If not, see <http:///www.gnu.org/licenses/>.
+
+#ifndef __H2D_DISCRETE_PROBLEM_REFERENCE_INTEGRALS_H
+#define __H2D_DISCRETE_PROBLEM_REFERENCE_INTEGRALS_H
+
+#include "hermes_common.h"
+#include "shapeset/shapeset.h"
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    class ReferenceIntegralTableRegistry;
+
+    /// @ingroup inner
+    /// Reference integral table class.
+    /// \brief Integrals of products of the shape functions and their derivatives over the reference element.
+    ///
+    /// On affine elements, the local matrices of forms with constant coefficients (mass, diffusion, advection,
+    /// see MatrixFormVol::get_reference_coefficients()) are linear combinations of these integrals weighted by the
+    /// constant inverse reference map and jacobian, so no quadrature is needed.
+    /// One table per shapeset, element mode and polynomial degree holds the integrals of all pairs of the (unconstrained)
+    /// shape functions up to that degree. The tables are created on first use and shared by all threads. They are also
+    /// stored in the directory given by the parameter precalculatedFormsDirPath of Hermes2DApi (if it exists) and loaded
+    /// from there in the following runs.
+    ///
+    class HERMES_API ReferenceIntegralTable
+    {
+    public:
+      /// Types of the integrals, v is the test function, u the basis function, xi_0 and xi_1 the reference coordinates.
+      enum IntegralType
+      {
+        /// \int u v
+        Mass = 0,
+        /// \int du/dxi_b dv/dxi_a is Stiffness + 2 * a + b.
+        Stiffness = 1,
+        /// \int du/dxi_b v is Advection + b.
+        Advection = 5,
+        NumIntegralTypes = 7
+      };
+
+      /// Returns the table, creates (or loads) it on first use.
+      static const ReferenceIntegralTable* get(Shapeset* shapeset, ElementMode2D mode, int order);
+
+      /// Frees all tables.
+      static void free_all();
+
+      /// Position of the shape function in the table, -1 if not present.
+      inline int get_position(int index) const
+      {
+        return (index >= 0 && index <= this->max_index) ? this->positions[index] : -1;
+      }
+
+      /// Number of the shape functions in the table.
+      inline int get_count() const
+      {
+        return this->count;
+      }
+
+      /// The integrals of one type, count x count, the rows belong to the test functions.
+      inline const double* get_values(int type) const
+      {
+        return this->values + type * this->count * this->count;
+      }
+
+      /// Memory of the table in bytes.
+      unsigned long get_memory_size() const;
+
+    private:
+      ReferenceIntegralTable(Shapeset* shapeset, ElementMode2D mode, int order);
+      ~ReferenceIntegralTable();
+
+      /// Integrates the table.
+      void calculate(Shapeset* shapeset);
+      /// File name in the precalculated forms directory.
+      std::string get_file_name() const;
+      /// Stores the table, returns false if it cannot be written.
+      bool save() const;
+      /// Loads the table, returns false if there is no (valid) stored table.
+      bool load();
+
+      int shapeset_id;
+      ElementMode2D mode;
+      int order;
+      int max_index;
+      /// Positions by the shape function index.
+      int* positions;
+      int count;
+      /// NumIntegralTypes tables count x count.
+      double* values;
+
+      friend class ReferenceIntegralTableRegistry;
+    };
+  }
+}
+#endif
@@ -22,6 +22,8 @@
 #include "discrete_problem_helpers.h"
 #include "discrete_problem_integration_order_calculator.h"
 #include "discrete_problem_selective_assembler.h"
+#include "discrete_problem_constant_form_cache.h"
+#include "discrete_problem_reference_integrals.h"
 
 namespace Hermes
 {
@@ -53,7 +55,8 @@ namespace Hermes
       void init_u_ext(const Hermes::vector<SpaceSharedPtr<Scalar> >& spaces, Solution<Scalar>** u_ext_sln);
 
       /// Initializes the Transformable array for doing transformations.
-      void init_assembling(Solution<Scalar>** u_ext_sln, const Hermes::vector<SpaceSharedPtr<Scalar> >& spaces, bool nonlinear, bool add_dirichlet_lift);
+      /// \param[in] u_ext_unchanged The previous iterates are those of the last assembling, the copies in u_ext are kept.
+      void init_assembling(Solution<Scalar>** u_ext_sln, const Hermes::vector<SpaceSharedPtr<Scalar> >& spaces, bool nonlinear, bool add_dirichlet_lift, bool u_ext_unchanged = false);
 
       /// Initialize Func storages.
       void init_funcs();
@@ -73,8 +76,20 @@ namespace Hermes
       /// Assemble the state.
       void assemble_one_state();
       /// Matrix volumetric forms - assemble the form.
+      /// \param[in] constant_form_key Identification of the form (and edge) on the current state in constantFormCache, -1 if the cache is not to be used.
       void assemble_matrix_form(MatrixForm<Scalar>* form, int order, Func<double>** base_fns, Func<double>** test_fns,
-        AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, int n_quadrature_points, Geom<double>* geometry, double* jacobian_x_weights);
+        AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, int n_quadrature_points, Geom<double>* geometry, double* jacobian_x_weights, int constant_form_key = -1);
+      /// Stored integrals of a constant form (without the assembly list coefficients), from constantFormCache or congruentElementCache.
+      /// Returns nullptr if there are none.
+      Scalar* get_constant_form_integrals(MatrixForm<Scalar>* form, int order, AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, int constant_form_key, bool surface_form);
+      /// Storage for the integrals of a constant form - in the cache looked up last in get_constant_form_integrals().
+      /// Returns nullptr if the integrals are not to be stored.
+      Scalar* insert_constant_form_integrals(AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, int constant_form_key);
+      /// Integrals of a volumetric form with constant coefficients (see MatrixFormVol::get_reference_coefficients()) on an affine element,
+      /// calculated from ReferenceIntegralTable (without the assembly list coefficients) into target.
+      /// Returns false if the form, the element or the shape functions do not allow that, or if the quadrature of the order
+      /// quadrature_order is not exact (the matrix has to be the same as the one integrated by the quadrature).
+      bool calculate_reference_integrals(MatrixForm<Scalar>* form, int quadrature_order, AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, Scalar* target);
       /// Vector volumetric forms - assemble the form.
       void assemble_vector_form(VectorForm<Scalar>* form, int order, Func<double>** test_fns, AsmList<Scalar>* current_als,
         int n_quadrature_points, Geom<double>* geometry, double* jacobian_x_weights);
@@ -102,6 +117,30 @@ namespace Hermes
       
       /// Currently assembled state.
       Traverse::State* current_state;
+      /// Index of the currently assembled state in the traversal (for constantFormCache).
+      int current_state_index;
+
+      /// Integrals of constant forms, nullptr if there are no constant forms.
+      DiscreteProblemConstantFormCache<Scalar>* constantFormCache;
+      /// Statistics of constantFormCache usage in the current assembling.
+      int constant_form_blocks_integrated;
+      int constant_form_blocks_reused;
+      bool measure_constant_form_time;
+      Hermes::Mixins::TimeMeasurable constantFormTimer;
+
+      /// Integrals of constant forms on congruent affine elements, nullptr if not used.
+      DiscreteProblemCongruentElementCache<Scalar>* congruentElementCache;
+      /// The key of the current form has been set in congruentElementCache.
+      bool congruent_element_key_set;
+
+      /// Use ReferenceIntegralTable for forms with constant coefficients on affine elements.
+      bool use_reference_integrals;
+      /// Tables of the shapeset reference_integrals_shapeset_id by the mode and order, looked up once per thread.
+      const ReferenceIntegralTable* reference_integral_tables[H2D_NUM_MODES][H2D_ORDER_MASK + 1];
+      bool reference_integral_tables_looked_up[H2D_NUM_MODES][H2D_ORDER_MASK + 1];
+      int reference_integrals_shapeset_id;
+      /// Integrals calculated from the tables if they are not stored in a cache.
+      Scalar reference_integral_values[H2D_MAX_LOCAL_BASIS_SIZE * H2D_MAX_LOCAL_BASIS_SIZE];
       /// Current local matrix.
       Scalar local_stiffness_matrix[H2D_MAX_LOCAL_BASIS_SIZE * H2D_MAX_LOCAL_BASIS_SIZE * 4];
 
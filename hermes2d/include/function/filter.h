@@ -24,6 +24,7 @@ namespace Hermes
   namespace Hermes2D
   {
     struct UniData;
+    template<typename Scalar> class FusedFilter;
 
     /// @ingroup meshFunctions
     /// Filter is a general postprocessing class, intended for visualization.
@@ -106,14 +107,27 @@ namespace Hermes
 
       virtual Func<Scalar>* get_pt_value(double x, double y, bool use_MeshHashGrid = false, Element* e = nullptr);
 
+      /// Batched point evaluation, see MeshFunction::get_pt_values().
+      /// The input functions are evaluated in batches, filter_fn is then applied once to all points.
+      virtual int get_pt_values(int count, const double* x, const double* y, Scalar* values, Scalar* dx = nullptr, Scalar* dy = nullptr, bool use_MeshHashGrid = true);
+
     protected:
       int item[H2D_MAX_COMPONENTS];
 
-      virtual void filter_fn(int n, Hermes::vector<Scalar*> values, Scalar* result) = 0;
+      /// The tables passed to filter_fn, sized on the first use and only repointed per element.
+      Hermes::vector<Scalar*> filter_values;
+
+      virtual void filter_fn(int n, const Hermes::vector<Scalar*>& values, Scalar* result) = 0;
+
+      /// Appends the expression of this filter to a FusedFilter.
+      /// \param[in] inputs Indices of the nodes of the input functions.
+      /// \return Index of the resulting node, -1 if the filter can not be fused (default).
+      virtual int fuse(FusedFilter<Scalar>* fused, const int* inputs) const;
 
       void init_components();
       virtual void precalculate(int order, int mask);
 
+      template<typename T> friend class FusedFilter;
     };
 
     /// @ingroup meshFunctions
@@ -164,12 +178,23 @@ namespace Hermes
       DXDYFilter(Hermes::vector<MeshFunctionSharedPtr<Scalar> > solutions);
 
       virtual ~DXDYFilter();
+
+      /// Batched point evaluation, see MeshFunction::get_pt_values().
+      /// The input functions are evaluated in batches, filter_fn is then applied once to all points.
+      virtual int get_pt_values(int count, const double* x, const double* y, Scalar* values, Scalar* dx = nullptr, Scalar* dy = nullptr, bool use_MeshHashGrid = true);
+
+      /// The value and the derivatives at one point, filter_fn applied to the values of the input functions there.
+      virtual Func<Scalar>* get_pt_value(double x, double y, bool use_MeshHashGrid = false, Element* e = nullptr);
+
     protected:
       void init(Hermes::vector<MeshFunctionSharedPtr<Scalar> > solutions);
 
-      virtual Func<Scalar>* get_pt_value(double x, double y, bool use_MeshHashGrid = false, Element* e = nullptr);
+      virtual void filter_fn(int n, double* x, double* y, const Hermes::vector<const Scalar *>& values, const Hermes::vector<const Scalar *>& dx, const Hermes::vector<const Scalar *>& dy, Scalar* rslt, Scalar* rslt_dx, Scalar* rslt_dy) = 0;
 
-      virtual void filter_fn(int n, double* x, double* y, Hermes::vector<const Scalar *> values, Hermes::vector<const Scalar *> dx, Hermes::vector<const Scalar *> dy, Scalar* rslt, Scalar* rslt_dx, Scalar* rslt_dy) = 0;
+      /// The tables passed to filter_fn, sized on the first use and only repointed per element.
+      Hermes::vector<const Scalar *> values_vector;
+      Hermes::vector<const Scalar *> dx_vector;
+      Hermes::vector<const Scalar *> dy_vector;
 
       void init_components();
 
@@ -191,7 +216,8 @@ namespace Hermes
 
       virtual ~MagFilter();
     protected:
-      virtual void filter_fn(int n, Hermes::vector<Scalar*> values, Scalar* result);
+      virtual void filter_fn(int n, const Hermes::vector<Scalar*>& values, Scalar* result);
+      virtual int fuse(FusedFilter<Scalar>* fused, const int* inputs) const;
     };
 
     /// @ingroup meshFunctions
@@ -206,7 +232,7 @@ namespace Hermes
 
       virtual ~TopValFilter();
     protected:
-      virtual void filter_fn(int n, Hermes::vector<double*> values, double* result);
+      virtual void filter_fn(int n, const Hermes::vector<double*>& values, double* result);
       Hermes::vector<double> limits;
     };
 
@@ -222,7 +248,7 @@ namespace Hermes
 
       virtual ~BottomValFilter();
     protected:
-      virtual void filter_fn(int n, Hermes::vector<double*> values, double* result);
+      virtual void filter_fn(int n, const Hermes::vector<double*>& values, double* result);
       Hermes::vector<double> limits;
     };
 
@@ -238,7 +264,7 @@ namespace Hermes
 
       virtual ~ValFilter();
     protected:
-      virtual void filter_fn(int n, Hermes::vector<double*> values, double* result);
+      virtual void filter_fn(int n, const Hermes::vector<double*>& values, double* result);
       Hermes::vector<double> low_limits;
       Hermes::vector<double> high_limits;
     };
@@ -254,7 +280,8 @@ namespace Hermes
       virtual ~DiffFilter();
 
     protected:
-      virtual void filter_fn(int n, Hermes::vector<Scalar*> values, Scalar* result);
+      virtual void filter_fn(int n, const Hermes::vector<Scalar*>& values, Scalar* result);
+      virtual int fuse(FusedFilter<Scalar>* fused, const int* inputs) const;
     };
 
     /// @ingroup meshFunctions
@@ -268,7 +295,8 @@ namespace Hermes
       virtual ~SumFilter();
 
     protected:
-      virtual void filter_fn(int n, Hermes::vector<Scalar*> values, Scalar* result);
+      virtual void filter_fn(int n, const Hermes::vector<Scalar*>& values, Scalar* result);
+      virtual int fuse(FusedFilter<Scalar>* fused, const int* inputs) const;
     };
 
     /// @ingroup meshFunctions
@@ -282,7 +310,8 @@ namespace Hermes
       virtual ~SquareFilter();
 
     protected:
-      virtual void filter_fn(int n, Hermes::vector<Scalar*> values, Scalar* result);
+      virtual void filter_fn(int n, const Hermes::vector<Scalar*>& values, Scalar* result);
+      virtual int fuse(FusedFilter<Scalar>* fused, const int* inputs) const;
     };
 
     /// @ingroup meshFunctions
@@ -296,7 +325,8 @@ namespace Hermes
       virtual ~AbsFilter();
 
     protected:
-      virtual void filter_fn(int n, Hermes::vector<double*> values, double* result);
+      virtual void filter_fn(int n, const Hermes::vector<double*>& values, double* result);
+      virtual int fuse(FusedFilter<double>* fused, const int* inputs) const;
     };
 
     /// @ingroup meshFunctions
@@ -351,7 +381,7 @@ namespace Hermes
       virtual ~AngleFilter();
 
     protected:
-      virtual void filter_fn(int n, Hermes::vector<std::complex<double>*> values, double* result);
+      virtual void filter_fn(int n, const Hermes::vector<std::complex<double>*>& values, double* result);
     };
 
     /// @ingroup meshFunctions
@@ -406,6 +436,111 @@ namespace Hermes
 
       virtual void set_active_element(Element* e);
     };
+
+    /// Operations of the FusedFilter expression nodes.
+    enum FusedFilterOperation
+    {
+      HERMES_FILTER_INPUT,
+      HERMES_FILTER_CONSTANT,
+      HERMES_FILTER_ADD,
+      HERMES_FILTER_SUB,
+      HERMES_FILTER_MUL,
+      HERMES_FILTER_DIV,
+      /// v * v
+      HERMES_FILTER_SQR,
+      /// |v|^2 (v * v for real functions)
+      HERMES_FILTER_NORM,
+      HERMES_FILTER_SQRT,
+      HERMES_FILTER_ABS
+    };
+
+    /// @ingroup meshFunctions
+    /// FusedFilter evaluates a whole expression of the input functions in a single pass.
+    /// A chain of nested filters (e.g. MagFilter of two DiffFilters) precalculates every intermediate filter
+    /// separately, and every filter over functions on different meshes constructs its own union mesh.
+    /// FusedFilter only precalculates the underlying functions, over one union mesh of all of them, and evaluates
+    /// the expression node by node in buffers allocated once per expression.
+    ///
+    /// The expression is either built by the add_*() methods, e.g. the magnitude of the difference of two
+    /// vector-valued solutions u, v:
+    ///   FusedFilter<double> f(Hermes::vector<MeshFunctionSharedPtr<double> >(u, v));
+    ///   int dx = f.add_operation(HERMES_FILTER_SUB, f.add_input(0, H2D_FN_VAL_0), f.add_input(1, H2D_FN_VAL_0));
+    ///   int dy = f.add_operation(HERMES_FILTER_SUB, f.add_input(0, H2D_FN_VAL_1), f.add_input(1, H2D_FN_VAL_1));
+    ///   f.set_expression(f.add_operation(HERMES_FILTER_SQRT, f.add_operation(HERMES_FILTER_ADD,
+    ///     f.add_operation(HERMES_FILTER_SQR, dx), f.add_operation(HERMES_FILTER_SQR, dy))));
+    /// or by flattening an existing filter chain, where the filters supporting it (Mag, Diff, Sum, Square, Abs)
+    /// are replaced by their expressions and all other functions become inputs:
+    ///   FusedFilter<double> f(MeshFunctionSharedPtr<double>(new MagFilter<double>(...)));
+    ///
+    /// The result is scalar-valued, derivatives are not defined.
+    template<typename Scalar>
+    class HERMES_API FusedFilter : public Filter<Scalar>
+    {
+    public:
+      /// The expression is to be built by the add_*() methods and set_expression().
+      FusedFilter(Hermes::vector<MeshFunctionSharedPtr<Scalar> > solutions);
+
+      /// Flattens the filter chain 'expression'.
+      FusedFilter(MeshFunctionSharedPtr<Scalar> expression);
+
+      virtual ~FusedFilter();
+
+      /// Value 'item' (H2D_FN_VAL_0, H2D_FN_DX_1, ...) of the input function 'function_index'.
+      /// \return Index of the node.
+      int add_input(int function_index, int item = H2D_FN_VAL_0);
+
+      /// \return Index of the node.
+      int add_constant(Scalar value);
+
+      /// Unary (b = -1) or binary operation of the nodes a, b.
+      /// \return Index of the node.
+      int add_operation(FusedFilterOperation operation, int a, int b = -1);
+
+      /// Sets the resulting node, allocates the buffers.
+      void set_expression(int root);
+
+      /// Number of the nodes of the expression.
+      int get_num_nodes() const;
+
+      virtual Func<Scalar>* get_pt_value(double x, double y, bool use_MeshHashGrid = false, Element* e = nullptr);
+
+      virtual MeshFunction<Scalar>* clone() const;
+
+      /// State querying helpers.
+      inline std::string getClassName() const { return "FusedFilter"; }
+
+    protected:
+      struct Node
+      {
+        FusedFilterOperation operation;
+        /// Operands, for HERMES_FILTER_INPUT the function index and the value type.
+        int a, b;
+        /// Component of the input function.
+        int component;
+        Scalar value;
+      };
+
+      Hermes::vector<Node> nodes;
+
+      /// Index of the resulting node.
+      int root;
+
+      /// Union of the items used of every input function.
+      int input_mask[H2D_MAX_COMPONENTS];
+
+      /// Results of the operations, H2D_MAX_INTEGRATION_POINTS_COUNT per node.
+      Scalar* buffers;
+
+      /// Values of the nodes for the current element (the input tables of the functions, or the buffers).
+      const Scalar** node_values;
+
+      /// Flattens a filter chain, returns the index of the node.
+      int add_function(MeshFunctionSharedPtr<Scalar> function, int item);
+
+      void evaluate_operation(const Node& node, int n, Scalar* result) const;
+
+      virtual void precalculate(int order, int mask);
+    };
   }
 }
 #endif
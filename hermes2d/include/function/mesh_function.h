@@ -79,6 +79,13 @@ namespace Hermes
       /// Return the value at the coordinates x,y.
       virtual Func<Scalar>* get_pt_value(double x, double y, bool use_MeshHashGrid = false, Element* e = nullptr) = 0;
 
+      /// Return the values (and optionally the derivatives) at the points (x[i], y[i]), i = 0, ..., count - 1.
+      /// The value of the component c at the point i is stored in values[c * count + i], the same holds for dx, dy.
+      /// Points that do not lie in any element get zero values.
+      /// The default implementation calls get_pt_value() point by point, Solution and the filters evaluate the points in batches.
+      /// \return The number of points that do not lie in any element.
+      virtual int get_pt_values(int count, const double* x, const double* y, Scalar* values, Scalar* dx = nullptr, Scalar* dy = nullptr, bool use_MeshHashGrid = true);
+
       /// Cloning function - for parallel OpenMP blocks.
       /// Designed to return an identical clone of this instance.
       virtual MeshFunction<Scalar>* clone() const = 0;
@@ -107,6 +107,11 @@ namespace Hermes
       void load_bson(const char* filename, SpaceSharedPtr<Scalar> space);
 #endif
 
+      /// Saves the solution to a file in the (memory-mapped) binary checkpoint format, see BinaryFileWriter.
+      void save_binary(const char* filename) const;
+      /// Loads the solution from a file previously created by Solution::save_binary().
+      void load_binary(const char* filename, SpaceSharedPtr<Scalar> space);
+
       /// Returns solution value or derivatives at element e, in its reference domain point (xi1, xi2).
       /// 'item' controls the returned value: 0 = value, 1 = dx, 2 = dy, 3 = dxx, 4 = dyy, 5 = dxy.
       /// NOTE: This function should be used for postprocessing only, it is not effective
@@ -133,6 +138,11 @@ namespace Hermes
       /// slow. Prefer Solution::get_ref_value if possible.
       virtual Func<Scalar>* get_pt_value(double x, double y, bool use_MeshHashGrid = false, Element* e = nullptr);
 
+      /// Batched version of get_pt_value(), see MeshFunction::get_pt_values().
+      /// The points are located in parallel, binned by their elements and evaluated element by element,
+      /// so that the reference map and the derivative coefficients are set up once per element.
+      virtual int get_pt_values(int count, const double* x, const double* y, Scalar* values, Scalar* dx = nullptr, Scalar* dy = nullptr, bool use_MeshHashGrid = true);
+
       /// Adds another mesh function on the given space.
       /// See method of parent class.
       virtual void add(MeshFunctionSharedPtr<Scalar> other_mesh_function, SpaceSharedPtr<Scalar> target_space);
@@ -207,11 +217,12 @@ namespace Hermes
       void load_exact_solution(int number_of_components, SpaceSharedPtr<Scalar> space, bool complexness,
         double x_real, double y_real, double x_complex, double y_complex);
 
-      /// Utility.
-      Scalar x[H2D_MAX_INTEGRATION_POINTS_COUNT], y[H2D_MAX_INTEGRATION_POINTS_COUNT], tx[H2D_MAX_INTEGRATION_POINTS_COUNT];
+      /// Utility - integration points transformed by the current sub-element matrix.
+      double x[H2D_MAX_INTEGRATION_POINTS_COUNT], y[H2D_MAX_INTEGRATION_POINTS_COUNT];
 
 #pragma region friends
       friend class RefMap;
+      friend class LoadBalancer;
       template<typename T> friend class KellyTypeAdapt;
       template<typename T> friend class Views::BaseView;
       template<typename T> friend class Views::VectorBaseView;
@@ -274,6 +285,11 @@ namespace Hermes
           Hermes::vector<MeshFunctionSharedPtr<Scalar> > solutions, Hermes::vector<PrecalcShapeset *> pss,
           Hermes::vector<bool> add_dir_lift = Hermes::vector<bool>(),
           Hermes::vector<int> start_indices = Hermes::vector<int>());
+
+      private:
+        /// Default start index of the space in a solution vector, counter is the number of DOFs of the preceding spaces.
+        /// The DOFs of interleaved spaces (Space::assign_dofs_interleaved()) are positions in the whole vector.
+        static int get_start_index(SpaceSharedPtr<Scalar> space, int counter);
 #pragma endregion
     };
   }
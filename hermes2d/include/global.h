@@ -30,6 +30,8 @@
 #define H2D_MAX_ELEMENT_SONS 4 ///< A maximum number of sons of an element.
 #define H2D_MAX_NUMBER_EDGES 4 ///< A maximum number of edges of an element.
 #define H2D_MAX_NUMBER_VERTICES 4 ///< A maximum number of vertices of an element.
+#define H2D_MAX_ORDER 10 ///< A maximum polynomial order of the shape functions (see Shapeset::get_max_order()).
+#define H2D_MAX_MONO_COEFFS ((H2D_MAX_ORDER + 1) * (H2D_MAX_ORDER + 1)) ///< A maximum number of monomial coefficients of a solution on an element.
 
 /// Internal.
 #define H2D_NUM_MODES 2 ///< A number of modes, see enum ElementMode2D.
@@ -38,6 +38,7 @@
 #include "mesh/mesh_reader_h2d.h"
 #include "mesh/mesh_reader_h2d_xml.h"
 #include "mesh/mesh_reader_h2d_bson.h"
+#include "mesh/mesh_reader_h2d_binary.h"
 #include "mesh/mesh_reader_h1d_xml.h"
 #include "mesh/mesh_reader_exodusii.h"
 
@@ -92,6 +93,7 @@
 #include "adapt/error_thread_calculator.h"
 #include "adapt/kelly_type_adapt.h"
 #include "neighbor_search.h"
+#include "load_balancer.h"
 #include "projections/ogprojection.h"
 #include "projections/ogprojection_nox.h"
 
@@ -0,0 +1,121 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+#ifndef __H2D_LOAD_BALANCER_H
+#define __H2D_LOAD_BALANCER_H
+
+#include "global.h"
+#include "mesh/traverse.h"
+#include "space/space.h"
+#include "function/mesh_function.h"
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    /// \brief Distribution of the items of an element-parallel loop (traversal states, elements to refine) among the threads.
+    ///
+    /// Every item gets an estimated cost (see the get_*_cost() methods - the costs of the elements of higher polynomial
+    /// orders are much higher than those of the low-order ones, splitting the items into equally long contiguous ranges
+    /// leaves the threads with very different amounts of work on hp-meshes).
+    /// The threads then either
+    /// - repeatedly take chunks of the remaining items (get_chunk()), whose cost is a fraction of the remaining cost
+    ///   (guided self-scheduling: large chunks first, small ones at the end to even out the finishing times), or
+    /// - process the contiguous ranges of (approximately) equal costs (get_range()), if the assignment of the items to the
+    ///   threads has to be deterministic.
+    /// The items are always handed out in their order, the chunks and ranges are contiguous.
+    ///
+    /// The time each thread spends working on the items (begin_thread(), end_thread()) is measured and can be reported.
+    class HERMES_API LoadBalancer
+    {
+    public:
+      /// Constructor.
+      /// \param[in] num_items Number of the items.
+      /// \param[in] num_threads Number of the threads processing the items.
+      LoadBalancer(int num_items, int num_threads);
+      ~LoadBalancer();
+
+      /// Sets the estimated cost of an item, the default is 1.
+      void set_cost(int item, double cost);
+
+      /// Prepares the distribution, to be called after all costs are set and before the parallel region.
+      void init();
+
+      /// The next chunk of items to be processed by the calling thread.
+      /// \return false if there are no items left.
+      /// \param[out] begin, end The items [begin, end).
+      bool get_chunk(int thread_number, int& begin, int& end);
+
+      /// The contiguous range of items of (approximately) the same cost for every thread, the ranges depend on the costs only.
+      /// \param[out] begin, end The items [begin, end).
+      void get_range(int thread_number, int& begin, int& end);
+      /// The first items of the ranges of the threads (num_threads + 1 entries, the last one is num_items).
+      const int* get_ranges() const;
+      /// Overrides the ranges calculated in init(), e.g. to repeat a previous distribution.
+      /// \param[in] range_starts See get_ranges().
+      void set_ranges(const int* range_starts);
+
+      /// Starts the measurement of the thread's busy time.
+      void begin_thread(int thread_number);
+      /// Ends the measurement of the thread's busy time.
+      void end_thread(int thread_number);
+
+      /// The busy time of a thread (in seconds).
+      double get_busy_time(int thread_number) const;
+      /// The number of items processed by a thread.
+      int get_num_items_processed(int thread_number) const;
+      /// The ratio of the maximum and the average busy time of the threads (1.0 for a perfect balance).
+      double get_imbalance() const;
+      /// Logs the busy times of the threads.
+      /// \param[in] loop_name The name of the loop in the log message.
+      void report(const Hermes::Mixins::Loggable* logger, const char* loop_name) const;
+
+      /// Number of the shape functions of an element of the (encoded) order.
+      static int get_num_shape_functions(Element* e, int order);
+
+      /// Cost of one element with the (encoded) polynomial order - the element matrix (num_shape_functions^2 entries)
+      /// integrated by a quadrature of ~ (order + 1)^2 points.
+      static double get_element_cost(Element* e, int order);
+
+      /// Cost of assembling one traversal state.
+      /// \param[in] spaces The spaces, the elements of the state belong to their meshes.
+      /// \param[in] num_forms The number of forms evaluated on the state.
+      template<typename Scalar>
+      static double get_assembling_cost(Traverse::State* state, const Hermes::vector<SpaceSharedPtr<Scalar> >& spaces, int num_forms);
+
+      /// Cost of evaluating functions on the elements of one traversal state (error calculation, linearization).
+      /// Only the polynomial orders of Solutions are known, the other functions count as linear.
+      /// \param[in] elements The elements of the state on the meshes of the functions (nullptr where there is none).
+      template<typename Scalar>
+      static double get_evaluation_cost(Element** elements, const MeshFunctionSharedPtr<Scalar>* functions, int num_functions);
+
+    protected:
+      int num_items;
+      int num_threads;
+      /// Costs of the items.
+      double* costs;
+      /// cumulative_costs[i] is the cost of the items [0, i).
+      double* cumulative_costs;
+      /// The first item not handed out by get_chunk().
+      int next_item;
+      /// See get_ranges().
+      int* range_starts;
+
+      /// Per-thread statistics.
+      Hermes::Mixins::TimeMeasurable* thread_timers;
+      int* thread_items;
+    };
+  }
+}
+#endif
@@ -126,16 +126,21 @@ namespace Hermes
       void update_refmap_coeffs(Element* e);
 
     private:
-      PrecalcShapeset ref_map_pss;
-
-      /// Transformation (2x2) matrix.
-      Trf* ctm;
-
       /// finally here are the coefficients of the higher-order basis functions
       /// that constitute the projected reference mapping:
       int nc; ///< number of coefficients
       double2* coeffs; ///< array of the coefficients
 
+      /// Returns the coefficients of the projected reference mapping of the element 'e' and their number 'nc'.
+      /// The sons created by refinement are not projected by the refinement, but here, on their first use by RefMap
+      /// (possibly by several threads at once, the first finished projection is kept). The number is only consistent
+      /// with the pointer as returned from here, do not read the member nc alongside.
+      double2* get_refmap_coeffs(Element* e, int& nc);
+
+      /// Projects the reference mapping of the element 'e' (to which this CurvMap belongs) to a new array of 'nc' coefficients.
+      /// Uses no state of this CurvMap other than the curves (the parent's ones for a son), i.e. is thread-safe.
+      double2* calc_refmap_coeffs(Element* e, int& nc) const;
+
       void get_mid_edge_points(Element* e, double2* pt, int n);
 
       /// Recursive calculation of the basis function N_i,k(int i, int k, double t, double* knot).
@@ -161,12 +166,13 @@ namespace Hermes
 
       /// Edge part of projection based interpolation ///////////////////////////////////////////////////
       /// Compute point (x, y) in reference element, edge vector (v1, v2)
-      void edge_coord(Element* e, int edge, double t, double2& x, double2& v) const;
-      void calc_edge_projection(Element* e, int edge, Curve** nurbs, int order, double2* proj) const;
+      /// 'ctm' is the transformation of the (son) element to the reference domain of 'e'.
+      static void edge_coord(Element* e, const Trf* ctm, int edge, double t, double2& x, double2& v);
+      static void calc_edge_projection(Element* e, const Trf* ctm, int edge, Curve** nurbs, int order, double2* proj);
 
       //// Bubble part of projection based interpolation /////////////////////////////////////////////////
-      void old_projection(Element* e, int order, double2* proj, double* old[2]);
-      void calc_bubble_projection(Element* e, Curve** nurbs, int order, double2* proj);
+      static void old_projection(Element* e, int order, double2* proj, double* old[2]);
+      static void calc_bubble_projection(Element* e, const Trf* ctm, Curve** nurbs, int order, double2* proj);
 
       static CurvMap* create_son_curv_map(Element* e, int son);
 
@@ -179,11 +185,13 @@ namespace Hermes
       template<typename T> friend class Adapt;
       template<typename T> friend class KellyTypeAdapt;
       friend class RefMap;
+      friend class MeshHashGrid;
       friend class Mesh;
       friend class MeshReader;
       friend class MeshReaderH2D;
       friend class MeshReaderH2DXML;
       friend class MeshReaderH2DBSON;
+      friend class MeshReaderH2DBinary;
 
       static bool warning_issued;
     };
@@ -206,6 +214,16 @@ namespace Hermes
       double** bubble_proj_matrix_tri; ///< projection matrix for triangle bubbles
       double** bubble_proj_matrix_quad; ///< projection matrix for quad bubbles
 
+      /// Values of the reference map shape function 'index' in the points of the 2D quadrature of the maximum order.
+      /// The projections use the untransformed shape functions only, so the values are shared by all elements.
+      /// Calculated on the first use (thread-safe).
+      const double* get_shape_values(int index, ElementMode2D mode);
+      double** shape_values[2];
+      int shape_values_count[2];
+
+      /// Values of the edge functions l_2, l_3, ... in the points of the 1D quadrature of the maximum order.
+      double** edge_fn_values;
+
       double* edge_p;  ///<  diagonal vector in cholesky factorization
       double* bubble_tri_p; ///<  diagonal vector in cholesky factorization
       int tri_bubble_np;
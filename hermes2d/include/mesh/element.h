@@ -64,7 +64,6 @@ namespace Hermes
       };
 
       int p1, p2; ///< parent id numbers
-      Node* next_hash; ///< next node in hash synonym list
 
       /// Returns true if the (vertex) node is constrained.
       bool is_constrained_vertex() const;
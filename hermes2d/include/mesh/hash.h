@@ -31,10 +31,112 @@ namespace Hermes
       class Orderizer;
     };
 
+    /// \brief Open-addressing (linear probing) table of node ids keyed on the parent ids (p1, p2), p1 <= p2.
+    ///
+    /// The keys are stored in the table itself, so that a search does not have to touch the nodes,
+    /// the capacity grows with the number of stored nodes. Removal shifts the following entries back (no tombstones).
+    ///
+    class HERMES_API NodeHashTable
+    {
+    public:
+      NodeHashTable();
+      ~NodeHashTable();
+
+      /// Allocates an empty table for at least 'size' entries without growing.
+      void init(int size);
+
+      /// Frees all memory.
+      void free();
+
+      /// Copies another table (the node ids are the same in the copy of the node array).
+      void copy(const NodeHashTable& other);
+
+      /// Returns the id of the node with parents p1 and p2, -1 if there is none.
+      inline int find(int p1, int p2) const
+      {
+        for (unsigned int i = slot(p1, p2);; i = (i + 1) & mask)
+        {
+          const Entry& entry = entries[i];
+          if (entry.id == -1)
+            return -1;
+          if (entry.p1 == p1 && entry.p2 == p2)
+            return entry.id;
+        }
+      }
+
+      /// Inserts a node id, the key must not be present.
+      void insert(int p1, int p2, int id);
+
+      /// Inserts count node ids (the keys must not be present) in parallel: the entries are sorted by the block
+      /// of slots of their key, the blocks are filled by the threads, the entries not fitting in their block are
+      /// inserted at the end.
+      void insert(int count, const int* p1s, const int* p2s, const int* ids);
+
+      /// Removes the node id stored under the key, if present.
+      void remove(int p1, int p2, int id);
+
+      /// Number of stored node ids.
+      int get_count() const;
+
+      /// Number of slots.
+      int get_capacity() const;
+
+    private:
+      struct Entry
+      {
+        int p1, p2;
+        /// -1 for an empty slot.
+        int id;
+      };
+
+      /// Stores the entry in the first empty slot from its home slot on (the capacity is sufficient).
+      void place(int p1, int p2, int id);
+
+      Entry* entries;
+      unsigned int mask;
+      int shift;
+      int count;
+
+      /// Fibonacci hashing of the key pair, the top bits select the slot.
+      inline unsigned int slot(int p1, int p2) const
+      {
+        uint64_t key = ((uint64_t)(unsigned int)p1 << 32) | (unsigned int)p2;
+        return (unsigned int)((key * 0x9E3779B97F4A7C15ULL) >> shift);
+      }
+
+      /// Doubles the capacity and reinserts all entries.
+      void grow();
+    };
+
+    /// \brief Results of the node searches of Mesh::refine_all_elements(), found in advance (in parallel).
+    ///
+    /// The searches of an element are answered in the order in which its refinement makes them: by the node found
+    /// in advance (if it still exists), by the node created by the neighbor or the son sharing the edge (a slot),
+    /// or by a new node. The tables are not updated during the refinement, they are rebuilt at its end.
+    ///
+    struct NodeSearchPlan
+    {
+      /// For every search: id of the node found in advance, -1 if there was none.
+      int* found_ids;
+      /// For every search: slot in which the neighbor (or the other son) sharing the edge finds the created node,
+      /// -1 if not shared.
+      int* slots;
+      /// Ids of the nodes created for the slots, -1 if not created yet.
+      int* slot_ids;
+      /// Index of the next search.
+      int next;
+      /// Slot of the last search.
+      int slot;
+      /// Numbers of the vertex and edge nodes (that would be) in the tables and their maxima (for the sizes
+      /// of the rebuilt tables).
+      int vertex_count, edge_count, max_vertex_count, max_edge_count;
+    };
+
     /// \brief Stores and searches node tables.
     ///
     /// HashTable is a base class for Mesh. It serves as a container for all nodes
-    /// of a mesh. Moreover, it has node searching functions based on hash tables.
+    /// of a mesh. Moreover, it has node searching functions based on hash tables,
+    /// one for the vertex nodes and one for the edge nodes, growing with the number of nodes.
     ///
     class HERMES_API HashTable : public Hermes::Mixins::Loggable
     {
@@ -45,7 +147,8 @@ namespace Hermes
       /// Returns the maximum node id number plus one.
       int get_max_node_id() const;
 
-      static const int H2D_DEFAULT_HASH_SIZE = 0x8000; // 32K entries
+      /// Default initial capacity of the node tables, they grow as needed.
+      static const int H2D_DEFAULT_HASH_SIZE = 0x400;
 
       Node* add_node();
 
@@ -75,15 +178,26 @@ namespace Hermes
       Array<Node> nodes; ///< Array storing all nodes
 
       /// Initializes the hash table.
-      /// \param size[in] Hash table size; must be a power of two.
+      /// \param size[in] Initial hash table size (expected number of vertex / edge nodes); must be a power of two.
       void init(int size = H2D_DEFAULT_HASH_SIZE);
 
       /// Copies another hash table contents
       void copy(const HashTable* ht);
 
       /// Reconstructs the hashtable, after, e.g., the nodes have been loaded from a file.
+      /// The tables are sized for all the nodes at once.
       void rebuild();
 
+      /// get_vertex_node() and get_edge_node() answer the searches from the plan and the tables are not updated
+      /// until unset_search_plan().
+      void set_search_plan(NodeSearchPlan* plan);
+
+      /// Stops using the search plan and rebuilds the tables, of the sizes they would have reached.
+      void unset_search_plan();
+
+      /// Initial size of the tables for saving (see init()).
+      int get_hash_size() const;
+
       /// Frees all memory used by the instance.
       void free();
 
@@ -96,23 +210,24 @@ namespace Hermes
       // Internal members
     private:
 
-      Node** v_table; ///< Vertex node hash table
-      Node** e_table; ///< Edge node hash table
+      /// Answers the next search of the plan: the id of the node, -1 if it has to be created.
+      int find_planned_node(int p1, int p2, int type);
 
-      int mask;
+      /// Registers the node created for the last search of the plan (instead of inserting it into a table).
+      void add_planned_node(Node* node);
 
-      inline int hash(int p1, int p2) const { return (984120265*p1 + 125965121*p2) & mask; }
+      /// Inserts all nodes with parents into the (empty) tables.
+      void insert_all_nodes();
 
-      /// Searches a list of hash synonyms given the first list item.
-      /// Returns the node matching the parent ids p1 and p2.
-      Node* search_list(Node* node, int p1, int p2) const;
+      NodeSearchPlan* search_plan;
 
-      /// Creates a copy of a hash synonym list.
-      void copy_list(Node** ptr, Node* node);
+      NodeHashTable v_table; ///< Vertex node hash table
+      NodeHashTable e_table; ///< Edge node hash table
 
       friend struct Node;
       friend class MeshUtil;
       friend class MeshReaderH2D;
+      friend class MeshReaderH2DBinary;
       template<typename Scalar> friend class NeighborSearch;
       template<typename Scalar> friend class Space;
       template<typename Scalar> friend class H1Space;
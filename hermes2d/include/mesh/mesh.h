@@ -27,6 +27,7 @@ namespace Hermes
   {
     class Element;
     class HashTable;
+    class RefMapCache;
 
     template<typename Scalar> class Space;
     template<typename Scalar> class KellyTypeAdapt;
@@ -100,6 +101,19 @@ namespace Hermes
       MeshHashGrid* meshHashGrid;
 #pragma endregion
 
+#pragma region RefMapCache
+      /// Enables or disables the cache of the reference mapping data (jacobians, inverse reference maps,
+      /// physical coordinates of the integration points, edge tangents) of the non-affine elements, shared
+      /// by all assembling threads and mesh functions over this mesh. Worth it for curved and general
+      /// quadrilateral elements evaluated repeatedly (Newton iterations, error calculations).
+      /// The cache is cleared when the mesh changes.
+      /// \param[in] max_memory_size Limit of the memory of the cache in bytes, 0 for no limit.
+      void set_geometry_cache(bool enabled, unsigned long max_memory_size = 0);
+
+      /// Returns the cache of the reference mapping data, nullptr if not enabled.
+      RefMapCache* get_geometry_cache() const;
+#pragma endregion
+
 #pragma region MarkerArea
       double get_marker_area(int marker);
 
@@ -289,6 +303,7 @@ namespace Hermes
         friend class Space<double>;
         friend class Space<std::complex<double> >;
         friend class Mesh;
+        friend class MeshReaderH2DBinary;
       };
 
       /// Frees all data associated with the mesh.
@@ -319,6 +334,9 @@ namespace Hermes
 
       unsigned seq;
 
+      /// Cache of the reference mapping data.
+      RefMapCache* geometry_cache;
+
       /// For internal use.
       void initial_single_check();
 
@@ -385,6 +403,7 @@ namespace Hermes
       friend class MeshHashGrid;
       friend class MeshReaderH2D;
       friend class MeshReaderH2DBSON;
+      friend class MeshReaderH2DBinary;
       friend class MeshReaderH2DXML;
       friend class MeshReaderH1DXML;
       friend class MeshReaderExodusII;
@@ -442,6 +461,18 @@ namespace Hermes
       void refine_quad(Element* e, int refinement, Element** sons_out = nullptr);
       void refine_triangle_to_triangles(Element* e, Element** sons = nullptr);
 
+      /// Maximum number of node searches of refine_element(e, 0) (of a quad).
+      static const int H2D_MAX_REFINEMENT_NODE_SEARCHES = 21;
+
+      /// Makes the node searches of refine_element(e, 0) in advance (see NodeSearchPlan), for any element refined
+      /// in the same refine_all_elements().
+      /// \return false if a search can not be planned (a node that only a previous refinement of e could have made).
+      bool plan_node_searches(Element* e, int* found_ids, int* slots) const;
+
+      /// Projects the reference mappings of the curved top-level elements and sets the inverse reference map orders
+      /// of all used elements, in parallel. Used by the mesh readers once the curves are assigned.
+      void update_refmap_coeffs();
+
       /// Computing vector length.
       static double vector_length(double a_1, double a_2);
 
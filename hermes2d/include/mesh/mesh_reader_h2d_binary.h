@@ -0,0 +1,60 @@
+// This file is part of Hermes2D
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, see <http://www.gnu.prg/licenses/>.
+
+#ifndef _MESH_READER_H2D_BINARY_H_
+#define _MESH_READER_H2D_BINARY_H_
+
+#include "mesh_reader.h"
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    /// Mesh reader from the (memory-mapped) binary checkpoint format, see BinaryFileWriter.
+    ///
+    /// Unlike the other readers, the complete mesh (all nodes and elements including the refinement tree,
+    /// curvilinear mappings, ...) is stored as flat arrays. Loading thus does not replay the refinements,
+    /// it only copies the arrays and fixes up the pointers. The element and node ids are preserved.
+    /// Only arcs are supported as curved edges (as in MeshReaderH2DBSON).
+    ///
+    /// @ingroup mesh_readers
+    /// Typical usage:
+    /// MeshSharedPtr mesh;
+    /// Hermes::Hermes2D::MeshReaderH2DBinary mloader;
+    /// try
+    /// {
+    ///&nbsp;mloader.load("mesh.h2db", mesh);
+    /// }
+    /// catch(Exceptions::MeshLoadFailureException& e)
+    /// {
+    ///&nbsp;e.print_msg();
+    ///&nbsp;return -1;
+    /// }
+    ///
+    class HERMES_API MeshReaderH2DBinary : public MeshReader
+    {
+    public:
+      MeshReaderH2DBinary();
+      virtual ~MeshReaderH2DBinary();
+
+      /// This method loads a single mesh from a file.
+      virtual void load(const char *filename, MeshSharedPtr mesh);
+
+      /// This method saves a single mesh to a file.
+      void save(const char *filename, MeshSharedPtr mesh);
+    };
+  }
+}
+#endif
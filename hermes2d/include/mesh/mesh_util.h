@@ -28,6 +28,8 @@ namespace Hermes
     class Nurbs;
     typedef std::tr1::shared_ptr<Hermes::Hermes2D::Mesh> MeshSharedPtr;
 
+    /// A node of the quadtree in MeshHashGrid.
+    /// Leaves store the elements whose bounding boxes intersect the node, together with the boxes.
     class MeshHashGridElement
     {
     public:
@@ -38,28 +40,43 @@ namespace Hermes
       Hermes::Hermes2D::Element* getElement(double x, double y);
 
     private:
-      inline bool belongs(double x, double y);
-      bool belongs(Hermes::Hermes2D::Element* element);
-      void insert(Hermes::Hermes2D::Element* element);
+      /// An element together with its bounding box.
+      struct Item
+      {
+        Hermes::Hermes2D::Element* element;
+        double2 p1, p2;
+      };
+
+      inline bool belongs(const Item& item) const;
+      void insert(const Item& item);
+      /// Removes the element from all leaves its bounding box intersects, merges sparse subtrees.
+      void remove(const Item& item);
+      /// Whether the leaf holds too many items (and splitting it makes sense).
+      inline bool needs_split() const;
+      /// Splits the leaf into four sons and distributes the items, optionally splits the sons recursively.
+      /// Does nothing (and returns false) if no son would get fewer items than this leaf, the leaf is then marked
+      /// unsplittable until an item that misses one of the sons is inserted.
+      bool split(bool recursive);
+      /// Turns the node with leaf sons back to a leaf.
+      void merge_sons();
 
       double lower_left_x;
       double lower_left_y;
       double upper_right_x;
       double upper_right_y;
 
-      Hermes::Hermes2D::Element** elements;
-      int element_count;
+      Hermes::vector<Item> items;
       MeshHashGridElement* m_sons[2][2];
       int m_depth;
 
-      static const int MAX_ELEMENTS = 50;
-      static const int MAX_DEPTH = 10;
+      static const int MAX_ELEMENTS = 16;
+      static const int MAX_DEPTH = 24;
       bool m_active;
+      /// All items of the leaf intersect all four sons (see split()).
+      bool m_unsplittable;
       friend class MeshHashGrid;
     };
 
-#define GRID_SIZE 50
-
     class MeshUtil
     {
     public:
@@ -84,14 +101,19 @@ namespace Hermes
       static Arc* load_arc(MeshSharedPtr mesh, int id, Node** en, int p1, int p2, double angle, bool skip_check = false);
     };
 
+    /// Spatial index for point location: a quadtree over the bounding boxes of the active elements.
+    ///
+    /// Leaves are split adaptively (up to MeshHashGridElement::MAX_DEPTH), so that strongly graded meshes do not end up
+    /// with most elements in a few cells. The tree is built in parallel and updated incrementally by Mesh::refine_element()
+    /// and Mesh::unrefine_element_id(), other changes to the mesh make it rebuild.
     class MeshHashGrid
     {
     public:
       MeshHashGrid(Mesh* mesh);
       ~MeshHashGrid();
 
-      // smallest box interval_x X interval_y in which element is contained. If element is curvilinear, has to be made larger
-      // if we knew more about the shape of curvilinear element, this increase could be smaller
+      /// Smallest box in which the element is contained. Curvilinear elements are sampled along the (exact) curved edges,
+      /// the box is then slightly enlarged to also cover the projected reference mapping.
       static void elementBoundingBox(Hermes::Hermes2D::Element* element, double2& p1, double2& p2);
 
       Hermes::Hermes2D::Element* getElement(double x, double y);
@@ -99,13 +121,28 @@ namespace Hermes
       int get_mesh_seq() const;
 
     private:
-      MeshHashGridElement* m_grid[GRID_SIZE][GRID_SIZE];
+      /// Incremental update after the element e has been refined.
+      void element_refined(Element* e, int mesh_seq);
+      /// Incremental update before the sons of e are removed in unrefinement.
+      void element_sons_to_be_removed(Element* e);
+      /// Incremental update after the element e has been made active again.
+      void element_unrefined(Element* e, int mesh_seq);
+
+      /// Inserts the element with its bounding box, stores the item for the removal.
+      void insert(Element* e);
+      /// Removes the element with the box it has been inserted with - the box recalculated from a (curvilinear) element
+      /// need not be the same, and the element would then remain in some leaves.
+      void remove(Element* e);
 
-      double intervals_x[GRID_SIZE + 1];
-      double intervals_y[GRID_SIZE + 1];
+      MeshHashGridElement* root;
+
+      /// The inserted items, indexed by the element id (element == nullptr if not inserted).
+      Hermes::vector<MeshHashGridElement::Item> inserted_items;
 
       /// For detecting changes to the mesh that would require the hashgrid to be recalculated.
       int mesh_seq;
+
+      friend class Mesh;
     };
 
     class MarkerArea
@@ -29,6 +29,89 @@ namespace Hermes
     class Element;
     class Mesh;
 
+    /// @ingroup meshFunctions
+    /// \brief Cache of the reference mapping data of the non-affine (curved and general quadrilateral) elements.
+    ///
+    /// Stores the jacobians (also multiplied by the quadrature weights), the inverse reference maps, the physical
+    /// coordinates of the integration points and the edge tangents, keyed by (element id, sub-element index,
+    /// quadrature order). Owned by the Mesh (see Mesh::set_geometry_cache()) and shared by all RefMaps over that
+    /// mesh and all threads: the entries are immutable once inserted and are looked up without locking.
+    /// The cache is cleared when the sequence number of the mesh changes (refinements, loading); changing the
+    /// coordinates of the vertices without changing the sequence number is not detected.
+    /// Only the standard quadrature (g_quad_2d_std) is cached.
+    class HERMES_API RefMapCache
+    {
+    public:
+      /// \param[in] max_memory_size Limit of the memory used by the entries in bytes, 0 for no limit.
+      /// No entries are inserted once the limit is reached.
+      RefMapCache(const Mesh* mesh, unsigned long max_memory_size = 0);
+      ~RefMapCache();
+
+      /// Types of the cached data, nonnegative values are the edge numbers of the tangents.
+      enum DataType
+      {
+        /// Jacobians, jacobians x weights and inverse reference maps.
+        InverseRefMap = -1,
+        /// Physical x and y coordinates.
+        PhysicalCoordinates = -2
+      };
+
+      /// One cached item.
+      struct Entry
+      {
+        int element_id;
+        uint64_t sub_idx;
+        int order;
+        int type;
+        Entry* next;
+        /// Number of doubles in data.
+        int size;
+        double* data;
+      };
+
+      /// Clears the cache if the mesh changed since the last call.
+      /// Reallocates the hash table without locking, i.e. must not be called in a parallel region.
+      void validate();
+
+      /// The cache belongs to the current state of the mesh, i.e. it may be used.
+      bool is_valid() const;
+
+      /// Removes all entries.
+      void clear();
+
+      /// Returns the data stored for the key, nullptr if there are none.
+      const double* find(int element_id, uint64_t sub_idx, int order, int type) const;
+
+      /// Allocates an entry with space for size doubles, to be filled by the caller and passed to insert().
+      /// Returns nullptr if the memory limit has been reached.
+      Entry* create_entry(int element_id, uint64_t sub_idx, int order, int type, int size);
+
+      /// Makes the entry visible to all threads and takes its ownership.
+      /// If an entry with the same key has been inserted in the meantime by another thread, the entry is deleted.
+      void insert(Entry* entry);
+
+      /// Memory used by the entries and the hash table in bytes.
+      unsigned long get_memory_size() const;
+
+      /// Number of the entries.
+      unsigned int get_num_entries() const;
+
+    private:
+      inline unsigned int hash(int element_id, uint64_t sub_idx, int order, int type) const;
+      void free_entries();
+
+      const Mesh* mesh;
+      /// Mesh sequence number the entries belong to.
+      unsigned mesh_seq;
+
+      Entry** buckets;
+      unsigned int num_buckets;
+      unsigned int num_entries;
+
+      unsigned long memory_size;
+      unsigned long max_memory_size;
+    };
+
     /// @ingroup meshFunctions
     /// \brief Represents the reference mapping.
     ///
@@ -67,6 +150,10 @@ namespace Hermes
       /// If the point (x, y) does not lie in e, then (xi1, xi2) will not lie in the reference domain.
       static void untransform(Element* e, double x, double y, double& xi1, double& xi2);
 
+      /// Transforms count points of the element e back to the reference domain at once, the reference map of the
+      /// element is set up only once and the Newton iterations of the points run together.
+      static void untransform(Element* e, int count, const double* x, const double* y, double* xi1, double* xi2);
+
       /// Returns the element pointer located at physical coordinates x, y.
       /// \param[in] x Physical x-coordinate.
       /// \param[in] y Physical y-coordinate.
@@ -129,6 +216,17 @@ namespace Hermes
         return this->jacobian;
       }
 
+      /// Returns the jacobian of the reference map multiplied by the quadrature weights at the integration
+      /// points of the specified order. Intended for non-constant jacobian elements.
+      inline double* get_jacobian_x_weights(int order)
+      {
+        if (this->is_const)
+          throw Hermes::Exceptions::Exception("RefMap::get_jacobian_x_weights() called with a const jacobian.");
+        if (order != this->jacobian_calculated)
+          this->calc_inv_ref_map(order);
+        return this->jacobian_x_weights;
+      }
+
       /// Returns the inverse matrices of the reference map precalculated at the
       /// integration points of the specified order. Intended for non-constant
       /// jacobian elements.
@@ -163,6 +261,10 @@ namespace Hermes
 
       static bool is_parallelogram(Element* e);
 
+      /// Sets the cache of the reference mapping data of the mesh the elements belong to, nullptr for none.
+      /// See Mesh::set_geometry_cache().
+      void set_geometry_cache(RefMapCache* geometry_cache);
+
       static void set_element_iro_cache(Element* element);
 
     private:
@@ -183,6 +285,7 @@ namespace Hermes
 
       /// For non-constant ref. map.
       double jacobian[H2D_MAX_INTEGRATION_POINTS_COUNT];
+      double jacobian_x_weights[H2D_MAX_INTEGRATION_POINTS_COUNT];
       int jacobian_calculated;
       double2x2 inv_ref_map[H2D_MAX_INTEGRATION_POINTS_COUNT];
       int inv_ref_map_calculated;
@@ -202,6 +305,15 @@ namespace Hermes
 
       Quad2D* quad_2d;
 
+      /// Cache of the mesh, used for non-constant ref. maps.
+      RefMapCache* geometry_cache;
+
+      /// Whether the data of the active element go through the cache.
+      inline bool use_geometry_cache() const
+      {
+        return this->geometry_cache && !this->is_const && this->quad_2d == &g_quad_2d_std && this->geometry_cache->is_valid();
+      }
+
       void calc_inv_ref_map(int order);
 
       /// Quickly calculates the (hard-coded) reference mapping for elements with constant jacobians
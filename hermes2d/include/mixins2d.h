@@ -37,11 +37,17 @@ namespace Hermes
       /// \brief Class utilizes parallel calculation
       class HERMES_API Parallel
       {
+      public:
+        /// Log the busy times of the threads in the element-parallel loops (see LoadBalancer).
+        void set_report_load_balance(bool to_set = true);
+
       protected:
         Parallel();
       protected:
         int num_threads_used;
         std::string exceptionMessageCaughtInParallelBlock;
+        /// See set_report_load_balance().
+        bool report_load_balance;
       };
     }
   }
@@ -110,6 +110,10 @@ namespace Hermes
       ///
       void set_active_edge(int edge);
 
+      /// Move the neighborhood to another active element of the same mesh, so that one instance (and its allocated
+      /// transformations) may be reused for the edges of many elements. The active edge has to be set afterwards.
+      void set_central_element(Element* el);
+
       /// Enhancement of set_active_edge for multimesh assembling.
       bool set_active_edge_multimesh(const int& edge);
 
@@ -28,12 +28,11 @@ namespace Hermes
     // TODO LIST:
     //
     // (1) With explicit and diagonally implicit methods, the matrix is treated
-    //     in the same way as with fully implicit ones. To make this more
-    //     efficient, with explicit and diagonally implicit methods one should
-    //     first only solve for the upper left block, then eliminate all blocks
-    //     under it, then solve for block at position 22, eliminate all blocks
-    //     under it, etc. Currently this is not done and everything is left to
-    //     the matrix solver.
+    //     in the same way as with fully implicit ones by default. With
+    //     set_stage_sequential(), diagonally implicit methods solve the stages
+    //     one after another (see rk_time_step_newton_sequential()), and with
+    //     set_explicit_stages(), explicit methods avoid the Newton's loop
+    //     altogether (see rk_time_step_explicit()).
     //
     // (2) In example 03-timedep-adapt-space-and-time with implicit Euler
     //     method, Newton's method takes much longer than in 01-timedep-adapt-space-only
@@ -91,6 +90,22 @@ namespace Hermes
       void set_start_from_zero_K_vector();
       void set_residual_as_solutions();
       void set_block_diagonal_jacobian();
+      /// For diagonally implicit (and explicit) Butcher's tables, solve the stages one after another
+      /// on a system of the original size instead of the num_stages times bigger monolithic one.
+      /// Together with set_freeze_jacobian(), one factorization is reused for all stages sharing
+      /// the diagonal coefficient (SDIRK methods). Ignored for fully implicit tables.
+      void set_stage_sequential(bool to_set = true);
+      /// For explicit Butcher's tables, compute every stage as K_i = M^{-1} F(t + c_i h, Y_n + h \sum_{j < i} a_{ij} K_j)
+      /// with a cached inverse of the mass matrix, instead of the Newton's method on the block stage system (the default).
+      /// May be switched on and off between the time steps.
+      void set_explicit_stages(bool to_set = true);
+      /// With set_explicit_stages(), replace the mass matrix by its row-sum lumped (diagonal) version.
+      /// Only used for spaces other than L2, for which the exact element-wise block inverse is always used.
+      void set_lumped_mass(bool to_set = true);
+
+      /// Time step satisfying the CFL condition dt <= cfl_number * h_e / ((2 p_e + 1) * max_speed) on all active
+      /// elements of all spaces, where h_e is the element diameter and p_e the element polynomial order.
+      double get_cfl_time_step(double max_speed, double cfl_number = 1.0) const;
 
       /// Destructor.
       ~RungeKutta();
@@ -160,6 +175,31 @@ namespace Hermes
       /// Updates the augmented weak formulation.
       void update_stage_wf(Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns_time_prev);
 
+      /// Creates the weak formulation of a single stage of a diagonally implicit method,
+      /// i.e. of the size of the original problem.
+      void create_sequential_stage_wf(unsigned int size);
+
+      /// Updates the single-stage weak formulation for the stage stage_i.
+      void update_sequential_stage_wf(Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns_time_prev, unsigned int stage_i);
+
+      /// The stage-sequential version of rk_time_step_newton() for diagonally implicit methods.
+      /// For every stage i, the Newton's method solves M K_i - F(t + c_i h, Y_n + h \sum_{j <= i} a_{ij} K_j) = 0,
+      /// whose Jacobian M - h a_{ii} J_F has the size of the original problem.
+      void rk_time_step_newton_sequential(Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns_time_prev, Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns_time_new, Hermes::vector<MeshFunctionSharedPtr<Scalar> > error_fns);
+
+      /// The explicit version of rk_time_step_newton(). Every stage is given by K_i = M^{-1} F(t + c_i h, Y_n + h \sum_{j < i} a_{ij} K_j),
+      /// i.e. only the residual is assembled and the cached inverse of the mass matrix is applied.
+      void rk_time_step_explicit(Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns_time_prev, Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns_time_new, Hermes::vector<MeshFunctionSharedPtr<Scalar> > error_fns);
+
+      /// Assembles the mass matrix and prepares its inverse (if the spaces changed since the last call).
+      void init_mass_inverse();
+
+      /// result = M^{-1} rhs.
+      void apply_mass_inverse(Scalar* rhs, Scalar* result);
+
+      /// Calculates the new time level solution (and the error functions) from the stage vectors in K_vector.
+      void calculate_time_level_solution(Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns_time_prev, Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns_time_new, Hermes::vector<MeshFunctionSharedPtr<Scalar> > error_fns);
+
       // Prepare u_ext_vec.
       void prepare_u_ext_vec();
 
@@ -196,8 +236,36 @@ namespace Hermes
       WeakForm<Scalar> stage_wf_left;
       DiscreteProblem<Scalar>* stage_dp_left;
 
+      /// Single-stage weak formulation and discrete problem (stage-sequential mode), size ndof times ndof.
+      WeakForm<Scalar> stage_wf_sequential;
+      DiscreteProblem<Scalar>* stage_dp_sequential;
+
+      /// How M^{-1} is applied in the explicit mode.
+      enum MassInverseType
+      {
+        MassInverseElementBlocks,
+        MassInverseLumped,
+        MassInverseFactorized
+      };
+      MassInverseType mass_inverse_type;
+      /// Seqs of the spaces the mass inverse was prepared for.
+      Hermes::vector<int> mass_inverse_spaces_seqs;
+      /// Element blocks of M^{-1} (L2 spaces): dofs of every block, and the dense (row-major) inverses.
+      Hermes::vector<int> mass_inverse_block_offsets;
+      Hermes::vector<int> mass_inverse_block_dofs;
+      Hermes::vector<int> mass_inverse_value_offsets;
+      Hermes::vector<Scalar> mass_inverse_values;
+      /// Lumped mass matrix diagonal.
+      Hermes::vector<Scalar> mass_lumped_diagonal;
+      /// Solver with the factorized mass matrix (matrix_left).
+      Hermes::Solvers::LinearMatrixSolver<Scalar>* mass_solver;
+      Hermes::Algebra::Vector<Scalar>* mass_rhs;
+
       bool start_from_zero_K_vector;
       bool block_diagonal_jacobian;
+      bool stage_sequential;
+      bool explicit_stages;
+      bool lumped_mass;
       bool residual_as_vector;
 
       /// Number of previous calls to rk_time_step_newton().
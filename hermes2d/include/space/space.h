@@ -29,6 +29,8 @@ namespace Hermes
 {
   namespace Hermes2D
   {
+    class BinaryFileReader;
+
     template<typename Scalar>
     class HERMES_API SpaceSharedPtr : public std::tr1::shared_ptr<Hermes::Hermes2D::Space<Scalar> >
     {
@@ -183,6 +185,10 @@ namespace Hermes
       /// Internal. Used by DiscreteProblem to detect changes in the space.
       int get_seq() const;
 
+      /// Internal. Used by DiscreteProblem to detect changes of the essential BC values (update_essential_bc_values()),
+      /// which do not change the seq.
+      unsigned int get_bc_values_seq() const;
+
       /// Obtains an boundary conditions
       EssentialBCs<Scalar>* get_essential_bcs() const;
 
@@ -241,10 +247,21 @@ namespace Hermes
       /// \param first_dof[in] The DOF number of the first basis function.
       /// \param stride[in] The difference between the DOF numbers of successive basis functions.
       /// \return The number of basis functions contained in the space.
-      virtual int assign_dofs(int first_dof = 0);
+      virtual int assign_dofs(int first_dof = 0, int stride = 1);
 
       /// \brief Assings the degrees of freedom to all Spaces in the Hermes::vector.
+      /// The DOFs of the spaces follow each other (stride 1), also if they were interleaved by assign_dofs_interleaved()
+      /// before. Note that the solvers (NewtonSolver, LinearSolver, PicardSolver, RungeKutta) number the DOFs this way.
       static int assign_dofs(Hermes::vector<SpaceSharedPtr<Scalar> > spaces);
+
+      /// \brief Assings the degrees of freedom to all Spaces in the Hermes::vector, interleaved by nodes.
+      /// The i-th space gets the DOF numbers i, i + n, i + 2n, ... (n = spaces.size()), so that for spaces
+      /// with the same type and element orders (e.g. components of a displacement), the components
+      /// of one node are consecutive - the block size of BSRMatrix (Hermes::matrixBlockSize) is then n.
+      /// All spaces must have the same number of DOFs, otherwise the numbering is not interleaved.
+      /// The solution vector of such spaces is indexed by the DOF numbers, Solution::vector_to_solution() of one of them
+      /// takes the whole vector with the first DOF of the space as the start index (the default of vector_to_solutions()).
+      static int assign_dofs_interleaved(Hermes::vector<SpaceSharedPtr<Scalar> > spaces);
 #pragma endregion
 
 #pragma region Mesh handling
@@ -264,6 +281,8 @@ namespace Hermes
 
       /// Updates essential BC values. Typically used for time-dependent
       /// essential boundary conditions.
+      /// After assign_dofs(), only the projections on the edges of time-dependent conditions are recalculated
+      /// (in parallel, in place), see EssentialBoundaryCondition::set_time_independent().
       void update_essential_bc_values();
 
       static void update_essential_bc_values(Hermes::vector<SpaceSharedPtr<Scalar> >& spaces, double time);
@@ -289,6 +308,13 @@ namespace Hermes
       /// This method is here for rapid re-loading.
       void load_bson(const char *filename);
 #endif
+
+      /// Saves this space into a file in the (memory-mapped) binary checkpoint format, see BinaryFileWriter.
+      void save_binary(const char* filename) const;
+      /// Loads a space from a file in the binary checkpoint format.
+      static SpaceSharedPtr<Scalar> load_binary(const char *filename, MeshSharedPtr mesh, EssentialBCs<Scalar>* essential_bcs = nullptr, Shapeset* shapeset = nullptr);
+      /// This method is here for rapid re-loading.
+      void load_binary(const char *filename);
 #pragma endregion
 
       /// Copy from Space instance 'space'
@@ -370,6 +396,8 @@ namespace Hermes
 
       /// For equation systems.
       int first_dof, next_dof;
+      /// The difference between the DOF numbers of successive basis functions.
+      int stride;
 
       /// Tracking changes.
       unsigned int seq;
@@ -377,6 +405,8 @@ namespace Hermes
       unsigned int seq_assigned;
       /// Tracking changes - mesh.
       int mesh_seq;
+      /// Tracking changes - essential BC values.
+      unsigned int bc_values_seq;
 
       struct BaseComponent
       {
@@ -466,8 +496,25 @@ namespace Hermes
       Hermes::vector<Scalar*> bc_data_projections;
       Hermes::vector<typename Space<Scalar>::BaseComponent*> bc_data_base_components;
 
+      /// Boundary edge with an essential condition and its projection.
+      struct BCEdge
+      {
+        Element* e;
+        int surf_num;
+        EssentialBoundaryCondition<Scalar>* bc;
+        int order;
+        Scalar* proj;
+      };
+      /// The edges of the current DOF assignment, filled by the first update_essential_bc_values() after assign_dofs().
+      Hermes::vector<BCEdge> bc_data_edges;
+      bool bc_data_edges_valid;
+
       void precalculate_projection_matrix(int nv, double**& mat, double*& p);
-      void update_edge_bc(Element* e, SurfPos* surf_pos);
+      /// Finds the edge in 'edges' if it has an essential condition (and resets its projection).
+      void update_edge_bc(Element* e, SurfPos* surf_pos, Hermes::vector<BCEdge>& edges);
+      /// Projections of the edges, in parallel; 'time_dependent_only' - the time-independent edges are skipped
+      /// and the projections are overwritten in place.
+      void calculate_bc_projections(bool time_dependent_only);
 
       /// Called by Space to update constraining relationships between shape functions due
       /// to hanging nodes in the mesh. As this is space-specific, this function is reimplemented
@@ -483,6 +530,10 @@ namespace Hermes
       /// Used in loading.
       static SpaceSharedPtr<Scalar> init_empty_space(SpaceType spaceType, MeshSharedPtr mesh, Shapeset* shapeset);
 
+      /// Internal.
+      /// Reads the element data in load_binary().
+      void load_binary_element_data(BinaryFileReader& reader);
+
       struct EdgeInfo
       {
         Node* node;
@@ -108,6 +108,12 @@ namespace Hermes
         /// Get the 'curvature' epsilon determining the tolerance of catching the shape of curved elements.
         double get_curvature_epsilon() const;
 
+        /// Keep the linearized topology (vertices, triangles, edges) between calls of process_solution(), as long as the meshes
+        /// do not change. Subsequent calls then skip the refinement decisions and only evaluate the values (and displacements)
+        /// in the stored vertices - suitable for time series on an unchanged mesh.
+        /// Default: false.
+        void set_keep_topology(bool to_set = true);
+
         /// Free the instance.
         void free();
 
@@ -159,6 +165,21 @@ namespace Hermes
         // Finish - contour triangles calculation etc.
         void finish(MeshFunctionSharedPtr<double>* sln);
 
+        /// Removes the vertices shared by more threads (FileExport), so that the output does not depend on the number of threads.
+        /// \param[in] reuse_mapping Use the mapping of vertices calculated in the previous call (for a replayed topology).
+        void merge_thread_vertices(bool reuse_mapping);
+
+        /// See set_keep_topology().
+        bool keep_topology;
+        /// The kept topology is being replayed in this processing.
+        bool replaying_topology;
+        /// Seq numbers of the meshes the kept topology belongs to, empty if there is none.
+        Hermes::vector<unsigned int> topology_mesh_seqs;
+        int topology_num_states;
+        /// The ranges of the states processed by the threads in the kept topology (see LoadBalancer::get_ranges()), a thread
+        /// has to replay the refinements of the same states.
+        Hermes::vector<int> topology_thread_ranges;
+
         Traverse::State** states;
 
         int num_states;
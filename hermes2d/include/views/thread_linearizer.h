@@ -133,6 +133,24 @@ namespace Hermes
         double curvature_epsilon;
 
 
+        /// Keeping of the linearized topology (see LinearizerMultidimensional::set_keep_topology()).
+        bool keep_topology;
+        /// The topology recorded in the last processing is replayed, only the values are evaluated.
+        bool replaying;
+        /// Vertex indices returned by get_vertex() (-index - 1 if the call did not create the vertex).
+        Hermes::vector<int> recorded_vertices;
+        unsigned int recorded_vertices_position;
+        /// Decisions whether (and how) to split the (sub-)elements.
+        Hermes::vector<int> recorded_splits;
+        unsigned int recorded_splits_position;
+        /// Vertex count after the recording (before removing the duplicates of vertices of the previous threads).
+        int recorded_vertex_count;
+        /// Start of the replay.
+        void init_replay();
+
+        /// Indices of the vertices in the vertex output of the whole LinearizerMultidimensional (FileExport).
+        Hermes::vector<int> global_vertex_indices;
+
         /// Keep?
         bool user_specified_max, user_specified_min;
         double user_specified_max_value, user_specified_min_value;
@@ -278,6 +278,13 @@ namespace Hermes
       /// scaling factor
       void setScalingFactor(double scalingFactor);
 
+      /// Declares the form constant - i.e. its value depends neither on the time, nor on the previous iterations, nor on
+      /// any external function that may change between assemblings.
+      /// The element integrals of constant matrix forms are calculated only in the first assembling and reused
+      /// afterwards, until the spaces or the meshes change. Does not have any effect on vector forms.
+      void set_constant(bool to_set = true);
+      bool is_constant() const;
+
       unsigned int i;
 
     protected:
@@ -312,6 +319,8 @@ namespace Hermes
       void set_uExtOffset(int u_ext_offset);
       /// Form will be always multiplied (scaled) with this number.
       double scaling_factor;
+      /// See set_constant().
+      bool constant;
       /// For time-dependent right-hand side functions.
       /// E.g. for Runge-Kutta methods. Otherwise the one time for the whole WeakForm can be used.
       void set_current_stage_time(double time);
@@ -367,6 +376,13 @@ namespace Hermes
       virtual ~MatrixFormVol();
 
       virtual MatrixFormVol* clone() const;
+
+      /// If the form is mass * u * v + (diffusion \nabla u) . \nabla v + (advection . \nabla u) v with constant coefficients
+      /// (in the physical coordinates), returns true and the coefficients. The local matrices on affine elements are then
+      /// calculated from the reference element integrals (see ReferenceIntegralTable) instead of the quadrature.
+      /// The default implementation returns false, the default forms of the library (DefaultMatrixFormVol, ...) return the
+      /// coefficients only for their own type, so their descendants are integrated by the quadrature unless they override this too.
+      virtual bool get_reference_coefficients(Scalar& mass, Scalar diffusion[2][2], Scalar advection[2]) const;
     };
 
     /// \brief Abstract, base class for matrix Surface form - i.e. MatrixForm, where the integration is with respect to 1D-Lebesgue measure (element domain-boundary edges).
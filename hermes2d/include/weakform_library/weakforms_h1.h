@@ -52,6 +52,8 @@ namespace Hermes
 
         virtual MatrixFormVol<Scalar>* clone() const;
 
+        virtual bool get_reference_coefficients(Scalar& mass, Scalar diffusion[2][2], Scalar advection[2]) const;
+
       private:
 
         Hermes2DFunction<Scalar>* coeff;
@@ -85,6 +87,8 @@ namespace Hermes
 
         virtual MatrixFormVol<Scalar>* clone() const;
 
+        virtual bool get_reference_coefficients(Scalar& mass, Scalar diffusion[2][2], Scalar advection[2]) const;
+
       private:
         int idx_j;
 
@@ -113,6 +117,8 @@ namespace Hermes
 
         virtual MatrixFormVol<Scalar>* clone() const;
 
+        virtual bool get_reference_coefficients(Scalar& mass, Scalar diffusion[2][2], Scalar advection[2]) const;
+
       private:
         int idx_j;
 
@@ -150,6 +156,8 @@ namespace Hermes
 
         virtual MatrixFormVol<Scalar>* clone() const;
 
+        virtual bool get_reference_coefficients(Scalar& mass, Scalar diffusion[2][2], Scalar advection[2]) const;
+
       private:
         int idx_j;
         Hermes1DFunction<Scalar>* coeff1, *coeff2;
@@ -596,7 +596,7 @@ namespace Hermes
                 }
 
                 // This is to make the form usable in rk_time_step_newton().
-                virtual MatrixFormSurf<Scalar>* clone() {
+                virtual MatrixFormSurf<Scalar>* clone() const {
                   return new Jacobian(*this);
                 }
 
@@ -636,7 +636,7 @@ namespace Hermes
                 }
 
                 // This is to make the form usable in rk_time_step_newton().
-                virtual VectorFormSurf<Scalar>* clone() {
+                virtual VectorFormSurf<Scalar>* clone() const {
                   return new Residual(*this);
                 }
 
@@ -699,7 +699,7 @@ namespace Hermes
                 }
 
                 // This is to make the form usable in rk_time_step_newton().
-                virtual MatrixFormVol<Scalar>* clone() {
+                virtual MatrixFormVol<Scalar>* clone() const {
                   return new Jacobian(*this);
                 }
 
@@ -760,7 +760,7 @@ namespace Hermes
                 }
 
                 // This is to make the form usable in rk_time_step_newton().
-                virtual VectorFormVol<Scalar>* clone() {
+                virtual VectorFormVol<Scalar>* clone() const {
                   return new Residual(*this);
                 }
 
@@ -824,7 +824,7 @@ namespace Hermes
                 }
 
                 // This is to make the form usable in rk_time_step_newton().
-                virtual MatrixFormVol<Scalar>* clone() {
+                virtual MatrixFormVol<Scalar>* clone() const {
                   return new Jacobian(*this);
                 }
 
@@ -847,7 +847,7 @@ namespace Hermes
                   GenericForm(matprop, geom_type),
                   g(g), keff(keff)
                 {
-                  this->wf->set_ext(iterates);
+                  this->set_ext(iterates);
                   if(g >= iterates.size())
                     throw Hermes::Exceptions::Exception(E_INVALID_GROUP_INDEX);
                 }
@@ -862,7 +862,7 @@ namespace Hermes
                   g(g), keff(keff)
                 {
                   this->set_area(area);
-                  this->wf->set_ext(iterates);
+                  this->set_ext(iterates);
                   if(g >= iterates.size())
                     throw Hermes::Exceptions::Exception(E_INVALID_GROUP_INDEX);
                 }
@@ -876,7 +876,7 @@ namespace Hermes
                   GenericForm(matprop, mesh, geom_type),
                   g(g), keff(keff)
                 {
-                  this->wf->set_ext(iterates);
+                  this->set_ext(iterates);
                   if(g >= iterates.size())
                     throw Hermes::Exceptions::Exception(E_INVALID_GROUP_INDEX);
                 }
@@ -891,7 +891,7 @@ namespace Hermes
                   g(g), keff(keff)
                 {
                   this->set_area(area);
-                  this->wf->set_ext(iterates);
+                  this->set_ext(iterates);
                   if(g >= iterates.size())
                     throw Hermes::Exceptions::Exception(E_INVALID_GROUP_INDEX);
                 }
@@ -911,7 +911,7 @@ namespace Hermes
                 }
 
                 // This is to make the form usable in rk_time_step_newton().
-                virtual VectorFormVol<Scalar>* clone() {
+                virtual VectorFormVol<Scalar>* clone() const {
                   return new OuterIterationForm(*this);
                 }
 
@@ -974,7 +974,7 @@ namespace Hermes
                 }
 
                 // This is to make the form usable in rk_time_step_newton().
-                virtual VectorFormVol<Scalar>* clone() {
+                virtual VectorFormVol<Scalar>* clone() const {
                   return new Residual(*this);
                 }
 
@@ -1034,7 +1034,7 @@ namespace Hermes
                 }
 
                 // This is to make the form usable in rk_time_step_newton().
-                virtual MatrixFormVol<Scalar>* clone() {
+                virtual MatrixFormVol<Scalar>* clone() const {
                   return new Jacobian(*this);
                 }
 
@@ -1094,7 +1094,7 @@ namespace Hermes
                 }
 
                 // This is to make the form usable in rk_time_step_newton().
-                virtual VectorFormVol<Scalar>* clone() {
+                virtual VectorFormVol<Scalar>* clone() const {
                   return new Residual(*this);
                 }
 
@@ -1154,7 +1154,7 @@ namespace Hermes
                 }
 
                 // This is to make the form usable in rk_time_step_newton().
-                virtual VectorFormVol<Scalar>* clone() {
+                virtual VectorFormVol<Scalar>* clone() const {
                   return new LinearForm(*this);
                 }
 
@@ -1243,7 +1243,93 @@ namespace Hermes
             rank1 nu;
             rank1 Sigma_f;
 
-            void filter_fn(int n, Hermes::vector<double*> values, double* result);
+            void filter_fn(int n, const Hermes::vector<double*>& values, double* result);
+          };
+
+          /// \brief Driver of the k-eigenvalue (criticality) problem L phi = 1 / keff F phi.
+          /// L (diffusion, removal, scattering and the boundary terms) is assembled once from the matrix forms of
+          /// the given weak form (typically CompleteWeakForms::Diffusion::DefaultWeakFormSourceIteration with the
+          /// vacuum boundary forms added), the fission operator F once from FissionYield::Jacobian forms. L is
+          /// factorized once, every outer (source) iteration is then one product with F (the fission source) and
+          /// one solution with the factorized operator.
+          /// Accelerations of the plain source iteration:
+          /// - Wielandt shift: after a few plain iterations, L - F / ke with ke = keff + delta_keff is factorized
+          /// (once) and used instead of L, which lowers the dominance ratio,
+          /// - Chebyshev extrapolation of the flux iterates, the dominance ratio is estimated from the plain
+          /// iterations and adapted after every Chebyshev cycle.
+          /// The flux is normalized so that the sum of the fission source vector is one. Zero Dirichlet
+          /// conditions only (nonzero Dirichlet values would make the problem affine).
+          class HERMES_API CriticalityIteration : public Hermes::Mixins::Loggable, public Hermes::Mixins::TimeMeasurable
+          {
+          public:
+            CriticalityIteration(const MaterialProperties::Diffusion::MaterialPropertyMaps& matprop, WeakForm<double>* wf,
+              Hermes::vector<SpaceSharedPtr<double> > spaces, GeomType geom_type = HERMES_PLANAR);
+            virtual ~CriticalityIteration();
+
+            /// Convergence: relative change of keff and relative change of the flux vector, defaults 1e-6 and 1e-5.
+            void set_tolerance(double keff_tol, double flux_tol);
+            /// Maximum number of outer iterations, default 500.
+            void set_max_iterations(int max_iterations);
+            /// Wielandt shift ke = keff + delta_keff applied after 'power_iterations' plain iterations,
+            /// delta_keff <= 0 switches it off (default).
+            void set_wielandt_shift(double delta_keff, int power_iterations = 5);
+            /// Chebyshev extrapolation in cycles of 'cycle_length' iterations, starting after 'power_iterations'
+            /// plain iterations (after the Wielandt shift if that is used), default off.
+            void set_chebyshev_extrapolation(bool to_set = true, int cycle_length = 6, int power_iterations = 5);
+
+            /// Solves the problem.
+            /// \param[in] initial_flux The initial flux vector (ones if nullptr).
+            /// \return true if converged.
+            bool solve(double* initial_flux = nullptr);
+
+            double get_keff() const;
+            int get_num_iters() const;
+            /// The flux vector, use Solution<double>::vector_to_solutions() to get the group fluxes.
+            double* get_sln_vector();
+            /// keff of all outer iterations.
+            const Hermes::vector<double>& get_keff_history() const;
+            /// Durations of all outer iterations (in seconds).
+            const Hermes::vector<double>& get_iteration_times() const;
+
+          protected:
+            /// Assembles L and F.
+            void assemble();
+            /// Factorizes L - F / shift_keff, L for shift_keff <= 0.
+            void factorize(double shift_keff);
+            /// result = F x.
+            void multiply_fission(const double* x, double* result) const;
+            /// One source iteration from 'flux', normalized as 'flux', returns the keff estimate.
+            double source_iteration(const double* flux, double* next_flux);
+
+            WeakForm<double>* wf;
+            WeakForm<double>* fission_wf;
+            Hermes::vector<SpaceSharedPtr<double> > spaces;
+            int ndof;
+
+            CSCMatrix<double>* diffusion_matrix;
+            CSCMatrix<double>* fission_matrix;
+            CSCMatrix<double>* operator_matrix;
+            /// Copy of operator_matrix of the type of the direct solver (without UMFPACK).
+            SparseMatrix<double>* solver_matrix;
+            SimpleVector<double>* rhs;
+            Hermes::Solvers::LinearMatrixSolver<double>* matrix_solver;
+            /// The shift of the factorized operator, 0 for L.
+            double shift_keff;
+
+            double keff_tol;
+            double flux_tol;
+            int max_iterations;
+            double wielandt_delta_keff;
+            int wielandt_power_iterations;
+            bool chebyshev;
+            int chebyshev_cycle_length;
+            int chebyshev_power_iterations;
+
+            double keff;
+            int num_iters;
+            double* sln_vector;
+            Hermes::vector<double> keff_history;
+            Hermes::vector<double> iteration_times;
           };
         }
       }
@@ -17,6 +17,7 @@
 #include "projections/ogprojection.h"
 #include "refinement_selectors/candidates.h"
 #include "function/exact_solution.h"
+#include "load_balancer.h"
 
 namespace Hermes
 {
@@ -289,56 +290,72 @@ namespace Hermes
         ogProjection.project_global(ref_space, this->errorCalculator->fine_solutions[i], rslns[i]);
       }
 
+      // The elements are distributed among the threads according to their polynomial orders (the number and the size
+      // of the candidates grow with the order).
+      LoadBalancer loadBalancer(attempted_element_refinements_count, this->num_threads_used);
+      for (int id_to_refine = 0; id_to_refine < attempted_element_refinements_count; id_to_refine++)
+      {
+        typename ErrorCalculator<Scalar>::ElementReference element_reference = this->errorCalculator->get_element_reference(id_to_refine);
+        loadBalancer.set_cost(id_to_refine, LoadBalancer::get_element_cost(meshes[element_reference.comp]->get_element(element_reference.element_id), this->spaces[element_reference.comp]->get_element_order(element_reference.element_id)));
+      }
+      loadBalancer.init();
+
       // Parallel section
 #pragma omp parallel num_threads(this->num_threads_used)
       {
         int thread_number = omp_get_thread_num();
-        int start = (attempted_element_refinements_count / this->num_threads_used) * thread_number;
-        int end = (attempted_element_refinements_count / this->num_threads_used) * (thread_number + 1);
-        if (thread_number == this->num_threads_used - 1)
-          end = attempted_element_refinements_count;
+        loadBalancer.begin_thread(thread_number);
 
         // rslns cloning.
         Hermes::vector<MeshFunctionSharedPtr<Scalar> > current_rslns;
         for (unsigned int i = 0; i < this->num; i++)
           current_rslns.push_back(rslns[i]->clone());
 
-        for (int id_to_refine = start; id_to_refine < end; id_to_refine++)
+        int start, end;
+        while (this->exceptionMessageCaughtInParallelBlock.empty() && loadBalancer.get_chunk(thread_number, start, end))
         {
-          try
+          for (int id_to_refine = start; id_to_refine < end; id_to_refine++)
           {
-            // Get the appropriate element reference from the error calculator.
-            typename ErrorCalculator<Scalar>::ElementReference element_reference = this->errorCalculator->get_element_reference(id_to_refine);
-            int element_id = element_reference.element_id;
-            int component = element_reference.comp;
-            int current_order = this->spaces[component]->get_element_order(element_id);
+            try
+            {
+              // Get the appropriate element reference from the error calculator.
+              typename ErrorCalculator<Scalar>::ElementReference element_reference = this->errorCalculator->get_element_reference(id_to_refine);
+              int element_id = element_reference.element_id;
+              int component = element_reference.comp;
+              int current_order = this->spaces[component]->get_element_order(element_id);
 
-            // Get refinement suggestion.
-            ElementToRefine elem_ref(element_id, component);
+              // Get refinement suggestion.
+              ElementToRefine elem_ref(element_id, component);
 
-            // Rsln[comp] may be unset if refinement_selectors[comp] == HOnlySelector or POnlySelector
-            if (refinement_selectors[component]->select_refinement(meshes[component]->get_element(element_id), current_order, current_rslns[component].get(), elem_ref))
-            {
-              // Put this refinement to the storage.
-              elements_to_refine[id_to_refine] = elem_ref;
-              element_refinement_location[component][element_id] = &elements_to_refine[id_to_refine];
+              // Rsln[comp] may be unset if refinement_selectors[comp] == HOnlySelector or POnlySelector
+              if (refinement_selectors[component]->select_refinement(meshes[component]->get_element(element_id), current_order, current_rslns[component].get(), elem_ref))
+              {
+                // Put this refinement to the storage.
+                elements_to_refine[id_to_refine] = elem_ref;
+                element_refinement_location[component][element_id] = &elements_to_refine[id_to_refine];
+              }
+              else
+                elements_to_refine[id_to_refine] = ElementToRefine(-1, -1);
             }
-            else
-              elements_to_refine[id_to_refine] = ElementToRefine(-1, -1);
-          }
-          catch (Hermes::Exceptions::Exception& e)
-          {
+            catch (Hermes::Exceptions::Exception& e)
+            {
 #pragma omp critical (exceptionMessageCaughtInParallelBlock)
-            this->exceptionMessageCaughtInParallelBlock = e.info();
-          }
-          catch (std::exception& e)
-          {
+              this->exceptionMessageCaughtInParallelBlock = e.info();
+            }
+            catch (std::exception& e)
+            {
 #pragma omp critical (exceptionMessageCaughtInParallelBlock)
-            this->exceptionMessageCaughtInParallelBlock = e.what();
+              this->exceptionMessageCaughtInParallelBlock = e.what();
+            }
           }
         }
+
+        loadBalancer.end_thread(thread_number);
       }
 
+      if (this->report_load_balance)
+        loadBalancer.report(this, "Refinement selection");
+
       if (!this->exceptionMessageCaughtInParallelBlock.empty())
       {
         this->deinit_adapt(element_refinement_location);
@@ -17,6 +17,7 @@
 #include "function/exact_solution.h"
 #include "adapt/error_thread_calculator.h"
 #include "norm_form.h"
+#include "load_balancer.h"
 
 namespace Hermes
 {
@@ -169,13 +170,16 @@ namespace Hermes
       Traverse trav(this->component_count);
       Traverse::State** states = trav.get_states(meshes, num_states);
 
+      // The states are distributed among the threads according to the polynomial orders of the fine solutions.
+      LoadBalancer loadBalancer(num_states, this->num_threads_used);
+      for (int state_i = 0; state_i < num_states; state_i++)
+        loadBalancer.set_cost(state_i, LoadBalancer::get_evaluation_cost(states[state_i]->e + this->component_count, &this->fine_solutions[0], this->component_count));
+      loadBalancer.init();
+
 #pragma omp parallel num_threads(this->num_threads_used)
       {
         int thread_number = omp_get_thread_num();
-        int start = (num_states / this->num_threads_used) * thread_number;
-        int end = (num_states / this->num_threads_used) * (thread_number + 1);
-        if (thread_number == this->num_threads_used - 1)
-          end = num_states;
+        loadBalancer.begin_thread(thread_number);
 
         try
         {
@@ -183,8 +187,12 @@ namespace Hermes
           ErrorThreadCalculator<Scalar> errorThreadCalculator(this);
 
           // Do the work.
-          for (int state_i = start; state_i < end; state_i++)
-            errorThreadCalculator.evaluate_one_state(states[state_i]);
+          int start, end;
+          while (this->exceptionMessageCaughtInParallelBlock.empty() && loadBalancer.get_chunk(thread_number, start, end))
+          {
+            for (int state_i = start; state_i < end; state_i++)
+              errorThreadCalculator.evaluate_one_state(states[state_i]);
+          }
         }
         catch (Hermes::Exceptions::Exception& e)
         {
@@ -196,8 +204,13 @@ namespace Hermes
 #pragma omp critical (exceptionMessageCaughtInParallelBlock)
           this->exceptionMessageCaughtInParallelBlock = e.what();
         }
+
+        loadBalancer.end_thread(thread_number);
       }
 
+      if (this->report_load_balance)
+        loadBalancer.report(this, "Error calculation");
+
       for (int i = 0; i < num_states; i++)
         delete states[i];
       free_with_check(states);
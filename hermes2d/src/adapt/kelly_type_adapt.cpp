@@ -13,797 +13,626 @@
 // You should have received a copy of the GNU General Public License
 // along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
 
-/*
-#include "kelly_type_adapt.h"
+#include "adapt/kelly_type_adapt.h"
+#include "discrete_problem/discrete_problem_helpers.h"
+#include "mesh/refmap.h"
+#include "forms.h"
+#include "load_balancer.h"
 
 namespace Hermes
 {
   namespace Hermes2D
   {
-    static const int H2D_DG_INNER_EDGE_INT = -1234567;
-    static const std::string H2D_DG_INNER_EDGE = "-1234567";
+    template<typename Scalar>
+    KellyTypeAdapt<Scalar>::ErrorEstimatorForm::ErrorEstimatorForm(int i, std::string area, Hermes::vector<MeshFunctionSharedPtr<Scalar> > ext)
+      : i(i), area(area), ext(ext)
+    {
+    }
 
     template<typename Scalar>
-    BasicKellyAdapt<Scalar>::ErrorEstimatorFormKelly::ErrorEstimatorFormKelly(int i, double const_by_laplacian) : KellyTypeAdapt<Scalar>::ErrorEstimatorForm(i, H2D_DG_INNER_EDGE), const_by_laplacian(const_by_laplacian)
-    {}
+    void KellyTypeAdapt<Scalar>::ErrorEstimatorForm::setAsInterface()
+    {
+      this->area = H2D_DG_INNER_EDGE;
+    }
 
     template<typename Scalar>
-    void KellyTypeAdapt<Scalar>::ErrorEstimatorForm::setAsInterface() 
-    { 
-      this->set_area(H2D_DG_INNER_EDGE);
+    Hermes::Ord KellyTypeAdapt<Scalar>::ErrorEstimatorForm::ord(int n, double *wt, Func<Hermes::Ord> *u_ext[],
+      DiscontinuousFunc<Hermes::Ord> *u, Geom<Hermes::Ord> *e, Func<Ord> **ext) const
+    {
+      throw Exceptions::MethodNotOverridenException("KellyTypeAdapt::ErrorEstimatorForm::ord().");
+      return Hermes::Ord();
     }
 
     template<typename Scalar>
-    KellyTypeAdapt<Scalar>::KellyTypeAdapt(Hermes::vector< SpaceSharedPtr<Scalar> >& spaces_,
-                                           bool ignore_visited_segments_,
-                                           Hermes::vector<const InterfaceEstimatorScalingFunction*> interface_scaling_fns_,
-                                           Hermes::vector<NormType > norms_)
-      : Adapt<Scalar>(spaces_, norms_)
+    BasicKellyAdapt<Scalar>::ErrorEstimatorFormKelly::ErrorEstimatorFormKelly(int i, double const_by_laplacian)
+      : KellyTypeAdapt<Scalar>::ErrorEstimatorForm(i, H2D_DG_INNER_EDGE), const_by_laplacian(const_by_laplacian)
     {
-      error_estimators_surf.reserve(this->num);
-      error_estimators_vol.reserve(this->num);
+    }
 
-      if(interface_scaling_fns_.size() == 0)
+    template<typename Scalar>
+    KellyTypeAdapt<Scalar>::KellyTypeAdapt(Hermes::vector<SpaceSharedPtr<Scalar> > spaces,
+      bool ignore_visited_segments_,
+      Hermes::vector<const InterfaceEstimatorScalingFunction*> interface_scaling_fns_,
+      Hermes::vector<NormType> norms_,
+      CalculatedErrorType errorType)
+      : ErrorCalculator<Scalar>(errorType), ignore_visited_segments(ignore_visited_segments_)
+    {
+      if (interface_scaling_fns_.empty())
       {
-        interface_scaling_fns_.reserve(this->num);
-        for (int i = 0; i < this->num; i++)
+        for (unsigned int i = 0; i < spaces.size(); i++)
           interface_scaling_fns_.push_back(new ScaleByElementDiameter);
       }
-      use_aposteriori_interface_scaling = true;
-      interface_scaling_fns = interface_scaling_fns_;
-      interface_scaling_const = boundary_scaling_const = volumetric_scaling_const = 1.0;
-      ignore_visited_segments = ignore_visited_segments_;
+      else if (interface_scaling_fns_.size() != spaces.size())
+        throw Exceptions::LengthException(3, interface_scaling_fns_.size(), spaces.size());
 
-      element_markers_conversion = spaces_[0]->get_mesh()->element_markers_conversion;
-      boundary_markers_conversion = spaces_[0]->get_mesh()->boundary_markers_conversion;
+      this->interface_scaling_fns = interface_scaling_fns_;
+      this->init(spaces, norms_);
     }
 
     template<typename Scalar>
-    KellyTypeAdapt<Scalar>::KellyTypeAdapt(SpaceSharedPtr<Scalar> space_,
-                                           bool ignore_visited_segments_,
-                                           const InterfaceEstimatorScalingFunction* interface_scaling_fn_,
-                                           NormType norm_)
-      : Adapt<Scalar>(space_, norm_)
+    KellyTypeAdapt<Scalar>::KellyTypeAdapt(SpaceSharedPtr<Scalar> space,
+      bool ignore_visited_segments_,
+      const InterfaceEstimatorScalingFunction* interface_scaling_fn_,
+      NormType norm_,
+      CalculatedErrorType errorType)
+      : ErrorCalculator<Scalar>(errorType), ignore_visited_segments(ignore_visited_segments_)
     {
-      if(interface_scaling_fn_ == nullptr)
-        interface_scaling_fns.push_back(new ScaleByElementDiameter);
+      if (interface_scaling_fn_ == nullptr)
+        this->interface_scaling_fns.push_back(new ScaleByElementDiameter);
       else
-        interface_scaling_fns.push_back(interface_scaling_fn_);
+        this->interface_scaling_fns.push_back(interface_scaling_fn_);
 
-      use_aposteriori_interface_scaling = true;
+      Hermes::vector<SpaceSharedPtr<Scalar> > spaces;
+      spaces.push_back(space);
+      Hermes::vector<NormType> norms;
+      norms.push_back(norm_);
+      this->init(spaces, norms);
+    }
 
-      interface_scaling_const = boundary_scaling_const = volumetric_scaling_const = 1.0;
-      ignore_visited_segments = ignore_visited_segments_;
+    template<typename Scalar>
+    void KellyTypeAdapt<Scalar>::init(Hermes::vector<SpaceSharedPtr<Scalar> > spaces, Hermes::vector<NormType> norms)
+    {
+      if (spaces.size() > H2D_MAX_COMPONENTS)
+        throw Exceptions::ValueException("components", spaces.size(), H2D_MAX_COMPONENTS);
+      if (!norms.empty() && norms.size() != spaces.size())
+        throw Exceptions::LengthException(4, norms.size(), spaces.size());
+
+      this->component_count = spaces.size();
+      this->use_aposteriori_interface_scaling = true;
+      this->interface_scaling_const = this->boundary_scaling_const = this->volumetric_scaling_const = 1.0;
 
-      element_markers_conversion = space_->get_mesh()->element_markers_conversion;
-      boundary_markers_conversion = space_->get_mesh()->boundary_markers_conversion;
+      // Norm forms used for making the errors relative, one per component (the same as in OGProjection).
+      for (int i = 0; i < this->component_count; i++)
+      {
+        NormType norm = norms.empty() ? HERMES_UNSET_NORM : norms[i];
+        if (norm == HERMES_UNSET_NORM)
+        {
+          switch (spaces[i]->get_type())
+          {
+          case HERMES_H1_SPACE: norm = HERMES_H1_NORM; break;
+          case HERMES_HCURL_SPACE: norm = HERMES_HCURL_NORM; break;
+          case HERMES_HDIV_SPACE: norm = HERMES_HDIV_NORM; break;
+          case HERMES_L2_SPACE: norm = HERMES_L2_NORM; break;
+          case HERMES_L2_MARKERWISE_CONST_SPACE: norm = HERMES_L2_NORM; break;
+          default: throw Hermes::Exceptions::Exception("Unknown space type in KellyTypeAdapt<Scalar>::KellyTypeAdapt().");
+          }
+        }
+        this->add_error_form(new DefaultNormFormVol<Scalar>(i, i, norm));
+      }
     }
 
     template<typename Scalar>
-    bool KellyTypeAdapt<Scalar>::adapt(double thr, int strat, int regularize, double to_be_processed)
+    KellyTypeAdapt<Scalar>::~KellyTypeAdapt()
     {
-      Hermes::vector<RefinementSelectors::Selector<Scalar> *> refinement_selectors;
-      RefinementSelectors::HOnlySelector<Scalar> selector;
-      for (int i = 0; i < this->num; i++)
-        refinement_selectors.push_back(&selector);
+      for (unsigned int i = 0; i < error_estimators_surf.size(); i++)
+        delete error_estimators_surf[i];
+      error_estimators_surf.clear();
+
+      for (unsigned int i = 0; i < error_estimators_vol.size(); i++)
+        delete error_estimators_vol[i];
+      error_estimators_vol.clear();
+
+      for (unsigned int i = 0; i < interface_scaling_fns.size(); i++)
+        delete interface_scaling_fns[i];
+      interface_scaling_fns.clear();
 
-      return Adapt<Scalar>::adapt(refinement_selectors, thr, strat, regularize, to_be_processed);
+      for (unsigned int i = 0; i < this->mfvol.size(); i++)
+        delete this->mfvol[i];
     }
 
     template<typename Scalar>
     void KellyTypeAdapt<Scalar>::add_error_estimator_vol(typename KellyTypeAdapt<Scalar>::ErrorEstimatorForm* form)
     {
-      if(form->i < 0 || form->i >= this->num)
-        throw Exceptions::ValueException("component number", form->i, 0, this->num);
+      if (form->i < 0 || form->i >= this->component_count)
+        throw Exceptions::ValueException("component number", form->i, 0, this->component_count);
 
-      form->adapt = this;
       this->error_estimators_vol.push_back(form);
     }
 
     template<typename Scalar>
     void KellyTypeAdapt<Scalar>::add_error_estimator_surf(typename KellyTypeAdapt<Scalar>::ErrorEstimatorForm* form)
     {
-      if(form->i < 0 || form->i >= this->num)
-        throw Exceptions::ValueException("component number", form->i, 0, this->num);
+      if (form->i < 0 || form->i >= this->component_count)
+        throw Exceptions::ValueException("component number", form->i, 0, this->component_count);
 
-      form->adapt = this;
       this->error_estimators_surf.push_back(form);
     }
 
     template<typename Scalar>
-    double KellyTypeAdapt<Scalar>::calc_err_internal(Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns,
-                                                     Hermes::vector<double>* component_errors,
-                                                     unsigned int error_flags)
+    bool KellyTypeAdapt<Scalar>::isOkay() const
     {
-      if(slns.size() != this->num)
-        throw Hermes::Exceptions::LengthException(0, slns.size(), this->num);
+      if (this->coarse_solutions.size() != this->component_count)
+        throw Exceptions::LengthException(0, this->coarse_solutions.size(), this->component_count);
 
-      this->tick();
-
-      for (int i = 0; i < this->num; i++)
+      for (int i = 0; i < this->component_count; i++)
       {
-        Solution<Scalar>* solution = dynamic_cast<Solution<Scalar>*>(slns[i].get());
-        if(solution == nullptr)
-          throw Exceptions::Exception("Passed solution is in fact not a Solution instance in KellyTypeAdapt::calc_err_*().");
-
-        this->sln[i] = solution;
-        this->sln[i]->set_quad_2d(&g_quad_2d_std);
+        if (dynamic_cast<Solution<Scalar>*>(this->coarse_solutions[i].get()) == nullptr)
+          throw Exceptions::Exception("Passed solution is in fact not a Solution instance in KellyTypeAdapt::calculate_errors().");
       }
 
-      this->have_coarse_solutions = true;
+      if (this->error_estimators_vol.empty() && this->error_estimators_surf.empty())
+        throw Exceptions::Exception("No error estimators passed to KellyTypeAdapt via add_error_estimator_vol() / add_error_estimator_surf().");
 
-      MeshSharedPtr* meshes = malloc_with_check(this->num, this);
-      Transformable** fns = malloc_with_check(this->num, this);
-
-      this->num_act_elems = 0;
-      for (int i = 0; i < this->num; i++)
-      {
-        meshes[i] = (this->sln[i]->get_mesh());
-        fns[i] = (this->sln[i]);
+      return true;
+    }
 
-        this->num_act_elems += meshes[i]->get_num_active_elements();
-        int max = meshes[i]->get_max_element_id();
+    template<typename Scalar>
+    void KellyTypeAdapt<Scalar>::calculate_errors(MeshFunctionSharedPtr<Scalar> sln, bool sort_and_store)
+    {
+      Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns;
+      slns.push_back(sln);
+      this->calculate_errors(slns, sort_and_store);
+    }
 
-        if(this->errors[i] != nullptr) free_with_check(this->errors[i]);
-        this->errors[i] = malloc_with_check(max, this);
-        memset(this->errors[i], 0, sizeof(double) * max);
-      }
+    template<typename Scalar>
+    void KellyTypeAdapt<Scalar>::init_interface_edges()
+    {
+      this->interface_edges.clear();
 
-      double total_norm = 0.0;
+      for (int i = 0; i < this->component_count; i++)
+      {
+        bool has_interface_estimator = false;
+        for (unsigned int iest = 0; iest < this->error_estimators_surf.size(); iest++)
+        if (this->error_estimators_surf[iest]->i == i && this->error_estimators_surf[iest]->area == H2D_DG_INNER_EDGE)
+          has_interface_estimator = true;
+        if (!has_interface_estimator)
+          continue;
+
+        MeshSharedPtr mesh = this->coarse_solutions[i]->get_mesh();
+        Element* e;
+        for_all_active_elements(e, mesh)
+        {
+          for (int isurf = 0; isurf < e->get_nvert(); isurf++)
+          {
+            if (e->en[isurf]->bnd)
+              continue;
 
-      bool calc_norm = false;
-      if((error_flags & this->HERMES_ELEMENT_ERROR_MASK) == HERMES_ELEMENT_ERROR_REL ||
-        (error_flags & this->HERMES_TOTAL_ERROR_MASK) == HERMES_TOTAL_ERROR_REL) calc_norm = true;
+            // With ignore_visited_segments, every interface (segment) has exactly one owner:
+            // - the element with the lower id if the neighbor is of the same size,
+            // - the smaller element if the neighbor is bigger.
+            // Across an irregular edge, there is no neighbor on either side of the edge node, the bigger element
+            // is recognized by the vertex node in the middle of its edge (as in NeighborSearch::set_active_edge()).
+            if (this->ignore_visited_segments)
+            {
+              Element* neighbor = e->get_neighbor(isurf);
+              if (neighbor != nullptr)
+              {
+                if (!neighbor->active || neighbor->id < e->id)
+                  continue;
+              }
+              else if (mesh->peek_vertex_node(e->en[isurf]->p1, e->en[isurf]->p2) != nullptr)
+                continue;
+            }
 
-      double *norms = nullptr;
-      if(calc_norm)
-      {
-        norms = malloc_with_check(this->num, this);
-        memset(norms, 0, this->num * sizeof(double));
+            this->interface_edges.push_back(InterfaceEdge(i, e, isurf));
+          }
+        }
       }
+    }
 
-      double *errors_components = malloc_with_check(this->num, this);
-      memset(errors_components, 0, this->num * sizeof(double));
-      this->errors_squared_sum = 0.0;
-      double total_error = 0.0;
+    template<typename Scalar>
+    void KellyTypeAdapt<Scalar>::calculate_errors(Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns, bool sort_and_store)
+    {
+      this->coarse_solutions = slns;
+      // The errors are calculated from the solutions themselves, Adapt uses these for projections.
+      this->fine_solutions = slns;
 
-      bool bnd[H2D_MAX_NUMBER_EDGES];
-      SurfPos surf_pos[H2D_MAX_NUMBER_EDGES];
-      Traverse::State *ee;
-      Traverse trav(this->num);
+      this->check();
+      this->tick();
 
-      // Reset the e->visited status of each element of each mesh (most likely it will be set to true from
-      // the latest assembling procedure).
-      if(ignore_visited_segments)
+      this->init_data_storage();
+      this->init_interface_edges();
+
+      // External functions of all estimators, traversed together with the solutions.
+      this->ext_functions.clear();
+      this->ext_offsets_vol.clear();
+      this->ext_offsets_surf.clear();
+      for (unsigned int iest = 0; iest < this->error_estimators_vol.size(); iest++)
       {
-        for (int i = 0; i < this->num; i++)
-        {
-          Element* e;
-          for_all_active_elements(e, meshes[i])
-            e->visited = false;
-        }
+        this->ext_offsets_vol.push_back(this->ext_functions.size());
+        for (unsigned int j = 0; j < this->error_estimators_vol[iest]->ext.size(); j++)
+          this->ext_functions.push_back(this->error_estimators_vol[iest]->ext[j]);
       }
-
-      // Begin the multimesh traversal.
-      trav.begin(this->num, meshes, fns);
-      while ((ee = trav.get_next_state()) != nullptr)
+      for (unsigned int iest = 0; iest < this->error_estimators_surf.size(); iest++)
       {
-        bnd[0] = ee->bnd[0];
-        bnd[1] = ee->bnd[1];
-        bnd[2] = ee->bnd[2];
-        bnd[3] = ee->bnd[3];
-
-        surf_pos[0].marker = ee->rep->en[0]->marker;
-        surf_pos[1].marker = ee->rep->en[1]->marker;
-        surf_pos[2].marker = ee->rep->en[2]->marker;
-        surf_pos[3].marker = ee->rep->en[3]->marker;
-
-        surf_pos[0].surf_num = 0;
-        surf_pos[1].surf_num = 1;
-        surf_pos[2].surf_num = 2;
-        surf_pos[3].surf_num = 3;
-
-        // Go through all solution components.
-        for (int i = 0; i < this->num; i++)
-        {
-          if(ee->e[i] == nullptr)
-            continue;
-
-          // Set maximum integration order for use in integrals, see limit_order()
-          update_limit_table(ee->e[i]->get_mode());
+        this->ext_offsets_surf.push_back(this->ext_functions.size());
+        if (this->error_estimators_surf[iest]->area != H2D_DG_INNER_EDGE)
+        for (unsigned int j = 0; j < this->error_estimators_surf[iest]->ext.size(); j++)
+          this->ext_functions.push_back(this->error_estimators_surf[iest]->ext[j]);
+      }
 
-          RefMap *rm = this->sln[i]->get_refmap();
+      Hermes::vector<MeshSharedPtr> meshes;
+      for (int i = 0; i < this->component_count; i++)
+        meshes.push_back(this->coarse_solutions[i]->get_mesh());
+      for (unsigned int j = 0; j < this->ext_functions.size(); j++)
+        meshes.push_back(this->ext_functions[j]->get_mesh());
 
-          double err = 0.0;
+      int num_states;
+      Traverse trav(this->component_count);
+      Traverse::State** states = trav.get_states(meshes, num_states);
+      int num_edges = this->interface_edges.size();
 
-          // Go through all volumetric error estimators.
-          for (unsigned int iest = 0; iest < error_estimators_vol.size(); iest++)
-          {
-            // Skip current error estimator if it is assigned to a different component or geometric area
-            // different from that of the current active element.
+      ThreadData* thread_data = calloc_with_check<KellyTypeAdapt<Scalar>, ThreadData>(this->num_threads_used, this);
 
-            if(error_estimators_vol[iest]->i != i)
-              continue;
+      // The states are distributed among the threads according to the polynomial orders of the solutions.
+      LoadBalancer loadBalancer(num_states, this->num_threads_used), edgeLoadBalancer(num_edges, this->num_threads_used);
+      for (int state_i = 0; state_i < num_states; state_i++)
+        loadBalancer.set_cost(state_i, LoadBalancer::get_evaluation_cost(states[state_i]->e, &this->coarse_solutions[0], this->component_count));
+      loadBalancer.init();
 
-            if(error_estimators_vol[iest]->area != HERMES_ANY)
-              if(!element_markers_conversion.get_internal_marker(error_estimators_vol[iest]->area).valid || element_markers_conversion.get_internal_marker(error_estimators_vol[iest]->area).marker != ee->e[i]->marker)
-                continue;
+      this->exceptionMessageCaughtInParallelBlock.clear();
+#pragma omp parallel num_threads(this->num_threads_used)
+      {
+        int thread_number = omp_get_thread_num();
+        ThreadData& data = thread_data[thread_number];
+        loadBalancer.begin_thread(thread_number);
 
-            err += eval_volumetric_estimator(error_estimators_vol[iest], rm);
-          }
+        try
+        {
+          this->init_thread_data(data);
 
-          // Go through all surface error estimators (includes both interface and boundary est's).
-          for (unsigned int iest = 0; iest < error_estimators_surf.size(); iest++)
+          // Volumetric and boundary parts.
+          int start, end;
+          while (this->exceptionMessageCaughtInParallelBlock.empty() && loadBalancer.get_chunk(thread_number, start, end))
           {
-            if(error_estimators_surf[iest]->i != i)
-              continue;
-
-            for (int isurf = 0; isurf < ee->e[i]->get_nvert(); isurf++)
-            {
-              if(bnd[isurf])   // Boundary
-              {
-                if(error_estimators_surf[iest]->area != HERMES_ANY)
-                {
-                  if(!boundary_markers_conversion.get_internal_marker(error_estimators_surf[iest]->area).valid)
-                    continue;
-                  int imarker = boundary_markers_conversion.get_internal_marker(error_estimators_surf[iest]->area).marker;
-
-                  if(imarker == H2D_DG_INNER_EDGE_INT)
-                    continue;
-                  if(imarker != surf_pos[isurf].marker)
-                    continue;
-                }
-
-                err += eval_boundary_estimator(error_estimators_surf[iest], rm, &surf_pos[isurf]);
-              }
-              else              // Interface
-              {
-                if(error_estimators_surf[iest]->area != H2D_DG_INNER_EDGE)
-                  continue;
-
-                // BEGIN COPY FROM DISCRETE_PROBLEM.CPP
-
-                // 5 is for bits per page in the array.
-                LightArray<NeighborSearch<Scalar>*> neighbor_searches(5);
-                unsigned int num_neighbors = 0;
-                NeighborNode* root;
-                int ns_index;
-
-                // Determine the minimum mesh seq in this stage.
-                unsigned int min_dg_mesh_seq = 0;
-                for(unsigned int j = 0; j < this->spaces.size(); j++)
-                  if(this->spaces[j]->get_mesh()->get_seq() < min_dg_mesh_seq || j == 0)
-                    min_dg_mesh_seq = this->spaces[j]->get_mesh()->get_seq();
-
-                ns_index = meshes[i]->get_seq() - min_dg_mesh_seq; // = 0 for single mesh
-
-                // Initialize the NeighborSearches.
-                this->dp.init_neighbors(neighbor_searches, ee, min_dg_mesh_seq);
-
-                // Create a multimesh tree;
-                root = new NeighborNode(nullptr, 0);
-                this->dp.build_multimesh_tree(root, neighbor_searches);
-
-                // Update all NeighborSearches according to the multimesh tree.
-                // After this, all NeighborSearches in neighbor_searches should have the same count
-                // of neighbors and proper set of transformations
-                // for the central and the neighbor element(s) alike.
-                // Also check that every NeighborSearch has the same number of neighbor elements.
-                for(unsigned int j = 0; j < neighbor_searches.get_size(); j++)
-                {
-                  if(neighbor_searches.present(j))
-                  {
-                    NeighborSearch<Scalar>* ns = neighbor_searches.get(j);
-                    this->dp.update_neighbor_search(ns, root);
-                    if(num_neighbors == 0)
-                      num_neighbors = ns->n_neighbors;
-                    if(ns->n_neighbors != num_neighbors)
-                      throw Hermes::Exceptions::Exception("Num_neighbors of different NeighborSearches not matching in KellyTypeAdapt<Scalar>::calc_err_internal.");
-                  }
-                }
-
-                // Go through all segments of the currently processed interface (segmentation is caused
-                // by hanging nodes on the other side of the interface).
-                for (unsigned int neighbor = 0; neighbor < num_neighbors; neighbor++)
-                {
-                  if(ignore_visited_segments)
-                  {
-                    bool processed = true;
-                    for(unsigned int j = 0; j < neighbor_searches.get_size(); j++)
-                      if(neighbor_searches.present(j))
-                        if(!neighbor_searches.get(j)->neighbors.at(neighbor)->visited)
-                        {
-                          processed = false;
-                          break;
-                        }
-
-                    if(processed) continue;
-                  }
-
-                  // We do not use cache_e and cache_jwt here.
-
-                  // Set the active segment in all NeighborSearches
-                  for(unsigned int j = 0; j < neighbor_searches.get_size(); j++)
-                  {
-                    if(neighbor_searches.present(j))
-                    {
-                      neighbor_searches.get(j)->active_segment = neighbor;
-                      neighbor_searches.get(j)->neighb_el = neighbor_searches.get(j)->neighbors[neighbor];
-                      neighbor_searches.get(j)->neighbor_edge = neighbor_searches.get(j)->neighbor_edges[neighbor];
-                    }
-                  }
-
-                  // Push all the necessary transformations to all functions of this stage.
-                  // The important thing is that the transformations to the current subelement are already there.
-                  // Also store the current neighbor element and neighbor edge in neighb_el, neighbor_edge.
-                  for(unsigned int fns_i = 0; fns_i < this->num; fns_i++)
-                  {
-                    NeighborSearch<Scalar> *ns = neighbor_searches.get(meshes[fns_i]->get_seq() - min_dg_mesh_seq);
-                    if(ns->central_transformations[neighbor])
-                      ns->central_transformations[neighbor]->apply_on(fns[fns_i]);
-                  }
-
-                  // END COPY FROM DISCRETE_PROBLEM.CPP
-                  rm->force_transform(this->sln[i]->get_transform(), this->sln[i]->get_ctm());
-
-                  // The estimate is multiplied by 0.5 in order to distribute the error equally onto
-                  // the two neighboring elements.
-                  double central_err = 0.5 * eval_interface_estimator(error_estimators_surf[iest],
-                                                                      rm, &surf_pos[isurf], neighbor_searches,
-                                                                      ns_index);
-                  double neighb_err = central_err;
-
-                  // Scale the error estimate by the scaling function dependent on the element diameter
-                  // (use the central element's diameter).
-                  if(use_aposteriori_interface_scaling && interface_scaling_fns[i])
-                    if(!element_markers_conversion.get_user_marker(ee->e[i]->marker).valid)
-                      throw Hermes::Exceptions::Exception("Marker not valid.");
-                    else
-                      central_err *= interface_scaling_fns[i]->value(ee->e[i]->get_diameter(), element_markers_conversion.get_user_marker(ee->e[i]->marker).marker);
-
-                  // In the case this edge will be ignored when calculating the error for the element on
-                  // the other side, add the now computed error to that element as well.
-                  if(ignore_visited_segments)
-                  {
-                    Element *neighb = neighbor_searches.get(ns_index)->neighb_el;
-
-                    // Scale the error estimate by the scaling function dependent on the element diameter
-                    // (use the diameter of the element on the other side).
-                    if(use_aposteriori_interface_scaling && interface_scaling_fns[i])
-                      if(!element_markers_conversion.get_user_marker(neighb->marker).valid)
-                      throw Hermes::Exceptions::Exception("Marker not valid.");
-                    else
-                      neighb_err *= interface_scaling_fns[i]->value(neighb->get_diameter(), element_markers_conversion.get_user_marker(neighb->marker).marker);
-
-                    errors_components[i] += central_err + neighb_err;
-                    total_error += central_err + neighb_err;
-                    this->errors[i][ee->e[i]->id] += central_err;
-                    this->errors[i][neighb->id] += neighb_err;
-                  }
-                  else
-                    err += central_err;
-
-                  // BEGIN COPY FROM DISCRETE_PROBLEM.CPP
-
-                  // Clear the transformations from the RefMaps and all functions.
-                  for(unsigned int fns_i = 0; fns_i < this->num; fns_i++)
-                    fns[fns_i]->set_transform(neighbor_searches.get(meshes[fns_i]->get_seq() - min_dg_mesh_seq)->original_central_el_transform);
-
-                  rm->set_transform(neighbor_searches.get(ns_index)->original_central_el_transform);
-
-                  // END COPY FROM DISCRETE_PROBLEM.CPP
-                }
-
-                // BEGIN COPY FROM DISCRETE_PROBLEM.CPP
-
-                // Delete the multimesh tree;
-                delete root;
-
-                // Delete the neighbor_searches array.
-                for(unsigned int j = 0; j < neighbor_searches.get_size(); j++)
-                  if(neighbor_searches.present(j))
-                    delete neighbor_searches.get(j);
-
-                // END COPY FROM DISCRETE_PROBLEM.CPP
-              }
-            }
+            for (int state_i = start; state_i < end; state_i++)
+              this->evaluate_one_state(states[state_i], data);
           }
 
-          if(calc_norm)
+          // Interfaces.
+          while (this->exceptionMessageCaughtInParallelBlock.empty() && edgeLoadBalancer.get_chunk(thread_number, start, end))
           {
-            double nrm = eval_solution_norm(this->norm_form[i][i], rm, this->sln[i]);
-            norms[i] += nrm;
-            total_norm += nrm;
+            for (int edge_i = start; edge_i < end; edge_i++)
+              this->evaluate_interface(this->interface_edges[edge_i], data);
           }
-
-          errors_components[i] += err;
-          total_error += err;
-          this->errors[i][ee->e[i]->id] += err;
-
-          ee->e[i]->visited = true;
         }
-      }
-      trav.finish();
-
-      // Store the calculation for each solution component separately.
-      if(component_errors != nullptr)
-      {
-        component_errors->clear();
-        for (int i = 0; i < this->num; i++)
+        catch (Hermes::Exceptions::Exception& e)
         {
-          if((error_flags & this->HERMES_TOTAL_ERROR_MASK) == HERMES_TOTAL_ERROR_ABS)
-            component_errors->push_back(sqrt(errors_components[i]));
-          else if((error_flags & this->HERMES_TOTAL_ERROR_MASK) == HERMES_TOTAL_ERROR_REL)
-            component_errors->push_back(sqrt(errors_components[i]/norms[i]));
-          else
-          {
-            throw Hermes::Exceptions::Exception("Unknown total error type (0x%x).", error_flags & this->HERMES_TOTAL_ERROR_MASK);
-            return -1.0;
-          }
+#pragma omp critical (exceptionMessageCaughtInParallelBlock)
+          this->exceptionMessageCaughtInParallelBlock = e.info();
+        }
+        catch (std::exception& e)
+        {
+#pragma omp critical (exceptionMessageCaughtInParallelBlock)
+          this->exceptionMessageCaughtInParallelBlock = e.what();
         }
+
+        loadBalancer.end_thread(thread_number);
       }
 
-      this->tick();
-      this->error_time = this->accumulated();
+      if (this->report_load_balance)
+        loadBalancer.report(this, "Error estimation");
+
+      for (int i = 0; i < num_states; i++)
+        delete states[i];
+      free_with_check(states);
 
-      // Make the error relative if needed.
-      if((error_flags & this->HERMES_ELEMENT_ERROR_MASK) == HERMES_ELEMENT_ERROR_REL)
+      // Sum up the thread-local contributions.
+      if (this->exceptionMessageCaughtInParallelBlock.empty())
       {
-        for (int i = 0; i < this->num; i++)
+        for (int i = 0; i < this->component_count; i++)
         {
-          Element* e;
-          for_all_active_elements(e, meshes[i])
-            this->errors[i][e->id] /= norms[i];
+          int num_elements_i = this->coarse_solutions[i]->get_mesh()->get_max_element_id();
+#pragma omp parallel for num_threads(this->num_threads_used)
+          for (int element_i = 0; element_i < num_elements_i; element_i++)
+          {
+            for (int thread_i = 0; thread_i < this->num_threads_used; thread_i++)
+            {
+              this->errors[i][element_i] += thread_data[thread_i].errors[i][element_i];
+              this->norms[i][element_i] += thread_data[thread_i].norms[i][element_i];
+            }
+          }
         }
       }
 
-      this->errors_squared_sum = total_error;
-
-      // Element error mask is used here, because this variable is used in the adapt()
-      // function, where the processed error (sum of errors of processed element errors)
-      // is matched to this variable.
-      if((error_flags & this->HERMES_ELEMENT_ERROR_MASK) == HERMES_ELEMENT_ERROR_REL)
-        this->errors_squared_sum /= total_norm;
+      // Clean after ourselves.
+      for (int thread_i = 0; thread_i < this->num_threads_used; thread_i++)
+        this->free_thread_data(thread_data[thread_i]);
+      free_with_check(thread_data);
+      this->ext_functions.clear();
+      this->interface_edges.clear();
 
-      // Prepare an ordered list of elements according to an error.
-      this->fill_regular_queue(meshes);
-      this->have_errors = true;
+      if (!this->exceptionMessageCaughtInParallelBlock.empty())
+        throw Hermes::Exceptions::Exception(this->exceptionMessageCaughtInParallelBlock.c_str());
 
-      if(calc_norm)
-        free_with_check(norms);
-      free_with_check(errors_components);
+      // Sums calculation & error postprocessing.
+      this->postprocess_error();
 
-      // Return error value.
-      if((error_flags & this->HERMES_TOTAL_ERROR_MASK) == HERMES_TOTAL_ERROR_ABS)
-        return sqrt(total_error);
-      else if((error_flags & this->HERMES_TOTAL_ERROR_MASK) == HERMES_TOTAL_ERROR_REL)
-        return sqrt(total_error / total_norm);
-      else
+      if (sort_and_store)
       {
-        throw Hermes::Exceptions::Exception("Unknown total error type (0x%x).", error_flags & this->HERMES_TOTAL_ERROR_MASK);
-        return -1.0;
+        std::qsort(this->element_references, this->num_act_elems, sizeof(typename ErrorCalculator<Scalar>::ElementReference), &this->compareElementReference);
+        this->elements_stored = true;
       }
+      else
+        this->elements_stored = false;
+
+      this->tick();
+      this->info("\tKellyTypeAdapt: error estimates calculated in %f s.", this->last());
     }
 
     template<typename Scalar>
-    double KellyTypeAdapt<Scalar>::eval_solution_norm(typename Adapt<Scalar>::MatrixFormVolError* form,
-                                                      RefMap *rm, MeshFunctionSharedPtr<Scalar> sln)
+    void KellyTypeAdapt<Scalar>::init_thread_data(ThreadData& data)
     {
-      // Determine the integration order.
-      int inc = (sln->get_num_components() == 2) ? 1 : 0;
-      Func<Hermes::Ord>* ou = init_fn_ord(sln->get_fn_order() + inc);
-
-      double fake_wt = 1.0;
-      Geom<Hermes::Ord>* fake_e = init_geom_ord();
-      Hermes::Ord o = form->ord(1, &fake_wt, nullptr, ou, ou, fake_e, nullptr);
-      int order = rm->get_inv_ref_order();
-      order += o.get_order();
+      data.slns = malloc_with_check<Solution<Scalar>*>(this->component_count);
+      data.u = malloc_with_check<Func<Scalar>*>(this->component_count);
+      data.u_discontinuous = malloc_with_check<DiscontinuousFunc<Scalar>*>(this->component_count);
+      for (int i = 0; i < this->component_count; i++)
+      {
+        data.slns[i] = static_cast<Solution<Scalar>*>(this->coarse_solutions[i]->clone());
+        data.u[i] = preallocate_fn<Scalar>();
+        // Only points to the arrays of data.u[i], the number of points is updated in init_solution_values().
+        data.u_discontinuous[i] = new DiscontinuousFunc<Scalar>(data.u[i], false, false);
+        data.neighbor_searches[i] = nullptr;
+        data.errors[i] = calloc_with_check<double>(this->coarse_solutions[i]->get_mesh()->get_max_element_id());
+        data.norms[i] = calloc_with_check<double>(this->coarse_solutions[i]->get_mesh()->get_max_element_id());
+      }
 
-      limit_order(order, rm->get_active_element()->get_mode());
+      data.ext = malloc_with_check<MeshFunction<Scalar>*>(this->ext_functions.size());
+      for (unsigned int j = 0; j < this->ext_functions.size(); j++)
+        data.ext[j] = this->ext_functions[j]->clone();
+
+      // Enough for the external functions of any of the estimators.
+      data.ext_fns_count = 0;
+      for (unsigned int iest = 0; iest < this->error_estimators_vol.size(); iest++)
+        data.ext_fns_count = std::max<int>(data.ext_fns_count, this->error_estimators_vol[iest]->ext.size());
+      for (unsigned int iest = 0; iest < this->error_estimators_surf.size(); iest++)
+        data.ext_fns_count = std::max<int>(data.ext_fns_count, this->error_estimators_surf[iest]->ext.size());
+      data.ext_fns = malloc_with_check<Func<Scalar>*>(data.ext_fns_count);
+      for (int j = 0; j < data.ext_fns_count; j++)
+        data.ext_fns[j] = preallocate_fn<Scalar>();
+    }
 
-      ou->free_ord(); delete ou;
-      delete fake_e;
+    template<typename Scalar>
+    void KellyTypeAdapt<Scalar>::free_thread_data(ThreadData& data)
+    {
+      // The thread may have failed before allocating anything.
+      if (!data.slns)
+        return;
 
-      // Evaluate the form.
-      Quad2D* quad = sln->get_quad_2d();
-      double3* pt = quad->get_points(order, sln->get_active_element()->get_mode());
-      int np = quad->get_num_points(order, sln->get_active_element()->get_mode());
+      for (int i = 0; i < this->component_count; i++)
+      {
+        delete data.slns[i];
+        // The discontinuous function would delete data.u[i] as its central component.
+        data.u_discontinuous[i]->fn_central = nullptr;
+        delete data.u_discontinuous[i];
+        delete data.u[i];
+        if (data.neighbor_searches[i])
+          delete data.neighbor_searches[i];
+        free_with_check(data.errors[i]);
+        free_with_check(data.norms[i]);
+      }
+      free_with_check(data.slns);
+      free_with_check(data.u);
+      free_with_check(data.u_discontinuous);
+
+      for (unsigned int j = 0; j < this->ext_functions.size(); j++)
+        delete data.ext[j];
+      free_with_check(data.ext);
+      for (int j = 0; j < data.ext_fns_count; j++)
+        delete data.ext_fns[j];
+      free_with_check(data.ext_fns);
+    }
 
-      // Initialize geometry and jacobian*weights.
-      Geom<double>* e = init_geom_vol(rm, order);
-      double* jac = rm->get_jacobian(order);
-      double* jwt = malloc_with_check(np, this);
-      for(int i = 0; i < np; i++)
-        jwt[i] = pt[i][2] * jac[i];
+    template<typename Scalar>
+    void KellyTypeAdapt<Scalar>::init_solution_values(ThreadData& data, int order)
+    {
+      for (int i = 0; i < this->component_count; i++)
+      {
+        init_fn_preallocated(data.u[i], data.slns[i], order);
+        data.u_discontinuous[i]->np = data.u[i]->np;
+      }
+    }
 
-      // Function values.
-      Func<Scalar>* u = init_fn(sln.get(), order);
-      Scalar res = form->value(np, jwt, nullptr, u, u, e, nullptr);
+    template<typename Scalar>
+    double KellyTypeAdapt<Scalar>::eval_estimator(ErrorEstimatorForm* form, int ext_offset, ThreadData& data, int order, int n, double* jwt, Geom<double>* geometry)
+    {
+      for (unsigned int j = 0; j < form->ext.size(); j++)
+        init_fn_preallocated(data.ext_fns[j], data.ext[ext_offset + j], order);
 
-      e->free(); delete e;
-      free_with_check(jwt);
-      u->free_fn(); delete u;
+      Scalar res = form->value(n, jwt, data.u, data.u_discontinuous[form->i], geometry, data.ext_fns);
 
       return std::abs(res);
     }
 
     template<typename Scalar>
-    double KellyTypeAdapt<Scalar>::eval_volumetric_estimator(typename KellyTypeAdapt<Scalar>::ErrorEstimatorForm* err_est_form,
-                                                             RefMap *rm)
+    void KellyTypeAdapt<Scalar>::evaluate_one_state(Traverse::State* current_state, ThreadData& data)
     {
-      // Determine the integration order.
-      int inc = (this->sln[err_est_form->i]->get_num_components() == 2) ? 1 : 0;
-
-      Func<Hermes::Ord>** oi = malloc_with_check(this->num, this);
-      for (int i = 0; i < this->num; i++)
-        oi[i] = init_fn_ord(this->sln[i]->get_fn_order() + inc);
-
-      // Polynomial order of additional external functions.
-      Func<Hermes::Ord>** fake_ext_fn = malloc_with_check(err_est_form->ext.size(), this);
-      for (int i = 0; i < err_est_form->ext.size(); i++)
-        fake_ext_fn[i] = init_fn_ord(err_est_form->ext[i]->get_fn_order());
-
-      double fake_wt = 1.0;
-      Geom<Hermes::Ord>* fake_e = init_geom_ord();
-
-      DiscontinuousFunc<Hermes::Ord> oi_i(oi[err_est_form->i], false, false);
-
-      Hermes::Ord o = err_est_form->ord(1, &fake_wt, oi, &oi_i, fake_e, fake_ext_fn);
-      int order = rm->get_inv_ref_order();
-      order += o.get_order();
-
-      limit_order(order, rm->get_active_element()->get_mode());
-
-      // Clean up.
-      for (int i = 0; i < this->num; i++)
-      {
-        if(oi[i] != nullptr)
-        {
-          oi[i]->free_ord();
-          delete oi[i];
-        }
-      }
-      free_with_check(oi);
-      delete fake_e;
-      for(int i = 0; i < err_est_form->ext.size(); i++)
-        fake_ext_fn[i]->free_ord();
-      free_with_check(fake_ext_fn);
-
-      // eval the form
-      Quad2D* quad = this->sln[err_est_form->i]->get_quad_2d();
-      double3* pt = quad->get_points(order, rm->get_active_element()->get_mode());
-      int np = quad->get_num_points(order, rm->get_active_element()->get_mode());
-
-      // Initialize geometry and jacobian*weights
-      Geom<double>* e = init_geom_vol(rm, order);
-      double* jac = rm->get_jacobian(order);
-      double* jwt = malloc_with_check(np, this);
-      for(int i = 0; i < np; i++)
-        jwt[i] = pt[i][2] * jac[i];
-
-      // Function values.
-      Func<Scalar>** ui = malloc_with_check(this->num, this);
-
-      for (int i = 0; i < this->num; i++)
-        ui[i] = init_fn(this->sln[i], order);
-
-      Func<Scalar>** ext_fn = malloc_with_check(err_est_form->ext.size(), this);
-      for (unsigned i = 0; i < err_est_form->ext.size(); i++)
+      for (int i = 0; i < this->component_count; i++)
       {
-        if(err_est_form->ext[i] != nullptr)
-          ext_fn[i] = init_fn(err_est_form->ext[i].get(), order);
-        else
-          ext_fn[i] = nullptr;
+        data.slns[i]->set_active_element(current_state->e[i]);
+        data.slns[i]->set_transform(current_state->sub_idx[i]);
       }
-
-      DiscontinuousFunc<Scalar> ui_i(ui[err_est_form->i], false, false);
-
-      Scalar res = volumetric_scaling_const * err_est_form->value(np, jwt, ui, &ui_i, e, ext_fn);
-
-      for (int i = 0; i < this->num; i++)
+      for (unsigned int j = 0; j < this->ext_functions.size(); j++)
       {
-        if(ui[i] != nullptr)
-        {
-          ui[i]->free_fn();
-          delete ui[i];
-        }
+        data.ext[j]->set_active_element(current_state->e[this->component_count + j]);
+        data.ext[j]->set_transform(current_state->sub_idx[this->component_count + j]);
       }
-      free_with_check(ui);
 
-      for(int i = 0; i < err_est_form->ext.size(); i++)
-        fake_ext_fn[i]->free_fn();
-      free_with_check(fake_ext_fn);
+      // Max order imposement.
+      int order = g_quad_2d_std.get_max_order(current_state->rep->get_mode());
 
-      e->free();
-      delete e;
+      RefMap** refmaps = malloc_with_check<RefMap*>(this->component_count);
+      for (int i = 0; i < this->component_count; i++)
+        refmaps[i] = data.slns[i]->get_refmap();
 
-      free_with_check(jwt);
+      // Volumetric estimators and norms.
+      Geom<double>* geometry;
+      double* jacobian_x_weights;
+      int n_quadrature_points = init_geometry_points(refmaps, this->component_count, order, geometry, jacobian_x_weights);
+      this->init_solution_values(data, order);
 
-      return std::abs(res);
-    }
+      for (unsigned int iest = 0; iest < this->error_estimators_vol.size(); iest++)
+      {
+        ErrorEstimatorForm* form = this->error_estimators_vol[iest];
+        Element* e = current_state->e[form->i];
 
-    template<typename Scalar>
-    double KellyTypeAdapt<Scalar>::eval_boundary_estimator(typename KellyTypeAdapt<Scalar>::ErrorEstimatorForm* err_est_form,
-                                                           RefMap *rm, SurfPos* surf_pos)
-    {
-      // Determine the integration order.
-      int inc = (this->sln[err_est_form->i]->get_num_components() == 2) ? 1 : 0;
-      Func<Hermes::Ord>** oi = malloc_with_check(this->num, this);
-      for (int i = 0; i < this->num; i++)
-        oi[i] = init_fn_ord(this->sln[i]->get_edge_fn_order(surf_pos->surf_num) + inc);
-
-      // Polynomial order of additional external functions.
-      Func<Hermes::Ord>** fake_ext_fn = malloc_with_check(err_est_form->ext.size(), this);
-      for (int i = 0; i < err_est_form->ext.size(); i++)
-        fake_ext_fn[i] = init_fn_ord(err_est_form->ext[i]->get_fn_order());
-
-      double fake_wt = 1.0;
-      Geom<Hermes::Ord>* fake_e = init_geom_ord();
-      DiscontinuousFunc<Hermes::Ord> oi_i(oi[err_est_form->i], false, false);
-      Hermes::Ord o = err_est_form->ord(1, &fake_wt, oi, &oi_i, fake_e, fake_ext_fn);
-      int order = rm->get_inv_ref_order();
-      order += o.get_order();
-
-      limit_order(order, rm->get_active_element()->get_mode());
-
-      // Clean up.
-      for (int i = 0; i < this->num; i++)
-        if(oi[i] != nullptr)
+        if (form->area != HERMES_ANY)
         {
-          oi[i]->free_ord();
-          delete oi[i];
+          Mesh::MarkersConversion::IntValid marker = this->coarse_solutions[form->i]->get_mesh()->get_element_markers_conversion().get_internal_marker(form->area);
+          if (!marker.valid || marker.marker != e->marker)
+            continue;
         }
 
-      free_with_check(oi);
-      delete fake_e;
-      for(int i = 0; i < err_est_form->ext.size(); i++)
-        fake_ext_fn[i]->free_ord();
-      free_with_check(fake_ext_fn);
-
-      // Evaluate the form.
-      Quad2D* quad = this->sln[err_est_form->i]->get_quad_2d();
-      int eo = quad->get_edge_points(surf_pos->surf_num, order, rm->get_active_element()->get_mode());
-      double3* pt = quad->get_points(eo, rm->get_active_element()->get_mode());
-      int np = quad->get_num_points(eo, rm->get_active_element()->get_mode());
-
-      // Initialize geometry and jacobian*weights.
-      double3* tan;
-      Geom<double>* e = init_geom_surf(rm, surf_pos->surf_num, surf_pos->marker, eo, tan);
-      double* jwt = malloc_with_check(np, this);
-      for(int i = 0; i < np; i++)
-        jwt[i] = pt[i][2] * tan[i][2];
-
-      // Function values
-      Func<Scalar>** ui = malloc_with_check(this->num, this);
-      for (int i = 0; i < this->num; i++)
-        ui[i] = init_fn(this->sln[i], eo);
-
-      Func<Scalar>** ext_fn = malloc_with_check(err_est_form->ext.size(), this);
-      for (unsigned i = 0; i < err_est_form->ext.size(); i++)
-      {
-        if(err_est_form->ext[i] != nullptr)
-          ext_fn[i] = init_fn(err_est_form->ext[i].get(), order);
-        else
-          ext_fn[i] = nullptr;
+        data.errors[form->i][e->id] += this->volumetric_scaling_const * this->eval_estimator(form, this->ext_offsets_vol[iest], data, order, n_quadrature_points, jacobian_x_weights, geometry);
       }
 
-      DiscontinuousFunc<Scalar> ui_i(ui[err_est_form->i], false, false);
+      for (int i = 0; i < this->component_count; i++)
+        data.norms[i][current_state->e[i]->id] += std::abs(this->mfvol[i]->value(n_quadrature_points, jacobian_x_weights, data.u[i], data.u[i], geometry));
 
-      Scalar res = boundary_scaling_const *
-        err_est_form->value(np, jwt, ui, &ui_i, e, ext_fn);
+      geometry->free();
+      delete geometry;
+      free_with_check(jacobian_x_weights);
 
-      for (int i = 0; i < this->num; i++)
-        if(ui[i] != nullptr)
+      // Boundary estimators.
+      if (current_state->isBnd)
+      {
+        for (current_state->isurf = 0; current_state->isurf < current_state->rep->nvert; current_state->isurf++)
         {
-          ui[i]->free_fn();
-          delete ui[i];
-        }
+          if (!current_state->bnd[current_state->isurf])
+            continue;
+
+          int surf_order = order;
+          n_quadrature_points = init_surface_geometry_points(refmaps, this->component_count, surf_order, current_state->isurf, current_state->rep->en[current_state->isurf]->marker, geometry, jacobian_x_weights);
+          this->init_solution_values(data, surf_order);
+
+          for (unsigned int iest = 0; iest < this->error_estimators_surf.size(); iest++)
+          {
+            ErrorEstimatorForm* form = this->error_estimators_surf[iest];
+            if (form->area == H2D_DG_INNER_EDGE)
+              continue;
 
-      free_with_check(ui);
-      for(int i = 0; i < err_est_form->ext.size(); i++)
-        fake_ext_fn[i]->free_fn();
-      free_with_check(fake_ext_fn);
+            Element* e = current_state->e[form->i];
+            if (form->area != HERMES_ANY)
+            {
+              Mesh::MarkersConversion::IntValid marker = this->coarse_solutions[form->i]->get_mesh()->get_boundary_markers_conversion().get_internal_marker(form->area);
+              if (!marker.valid || marker.marker != e->en[current_state->isurf]->marker)
+                continue;
+            }
 
-      e->free();
-      delete e;
+            // Edges are parameterized from 0 to 1 while integration weights are defined in (-1, 1).
+            data.errors[form->i][e->id] += 0.5 * this->boundary_scaling_const * this->eval_estimator(form, this->ext_offsets_surf[iest], data, surf_order, n_quadrature_points, jacobian_x_weights, geometry);
+          }
 
-      free_with_check(jwt);
+          geometry->free();
+          delete geometry;
+          free_with_check(jacobian_x_weights);
+        }
+      }
 
-      return std::abs(0.5*res);   // Edges are parameterized from 0 to 1 while integration weights
-                                  // are defined in (-1, 1). Thus multiplying with 0.5 to correct
-                                  // the weights.
+      free_with_check(refmaps);
     }
 
     template<typename Scalar>
-    double KellyTypeAdapt<Scalar>::eval_interface_estimator(typename KellyTypeAdapt<Scalar>::ErrorEstimatorForm* err_est_form,
-                                                            RefMap *rm, SurfPos* surf_pos,
-                                                            LightArray<NeighborSearch<Scalar>*>& neighbor_searches,
-                                                            int neighbor_index)
+    void KellyTypeAdapt<Scalar>::evaluate_interface(const InterfaceEdge& edge, ThreadData& data)
     {
-      NeighborSearch<Scalar>* nbs = neighbor_searches.get(neighbor_index);
-      Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns;
-      for (int i = 0; i < this->num; i++)
-        slns.push_back(this->sln[i]);
-
-      // Determine integration order.
-      Func<Hermes::Ord>** fake_ext_fns = malloc_with_check(err_est_form->ext.size(), this);
-      for (unsigned int j = 0; j < err_est_form->ext.size(); j++)
-      {
-        int inc = (err_est_form->ext[j]->get_num_components() == 2) ? 1 : 0;
-        int central_order = err_est_form->ext[j]->get_edge_fn_order(neighbor_searches.get(err_est_form->ext[j]->get_mesh()->get_seq())->active_edge) + inc;
-        int neighbor_order = err_est_form->ext[j]->get_edge_fn_order(neighbor_searches.get(err_est_form->ext[j]->get_mesh()->get_seq())->neighbor_edge.local_num_of_edge) + inc;
-        fake_ext_fns[j] = new DiscontinuousFunc<Hermes::Ord>(init_fn_ord(central_order), init_fn_ord(neighbor_order));
-      }
-
-      // Polynomial order of geometric attributes (eg. for multiplication of a solution with coordinates, normals, etc.).
-      Geom<Hermes::Ord>* fake_e = new InterfaceGeom<Hermes::Ord>(init_geom_ord(), nbs->neighb_el->marker, nbs->neighb_el->id, Hermes::Ord(nbs->neighb_el->get_diameter()));
-      double fake_wt = 1.0;
-      DiscontinuousFunc<Hermes::Ord> fake_ext_fns_i(fake_ext_fns[err_est_form->i], false, false);
-      
-      Hermes::Ord o = err_est_form->ord(1, &fake_wt, fake_ext_fns, &fake_ext_fns_i, fake_e, nullptr);
+      int i = edge.component;
+      Element* e = edge.e;
+      Solution<Scalar>* sln = data.slns[i];
+      MeshSharedPtr mesh = this->coarse_solutions[i]->get_mesh();
 
-      int order = rm->get_inv_ref_order();
-      order += o.get_order();
+      sln->set_active_element(e);
+      sln->set_transform(0);
 
-      limit_order(order, rm->get_active_element()->get_mode());
+      if (data.neighbor_searches[i] == nullptr)
+        data.neighbor_searches[i] = new NeighborSearch<Scalar>(e, mesh);
+      else
+        data.neighbor_searches[i]->set_central_element(e);
+      NeighborSearch<Scalar>& ns = *data.neighbor_searches[i];
+      ns.set_active_edge(edge.isurf);
 
-      // Clean up.
-      for (int i = 0; i < this->num; i++)
+      // Go through all segments of the currently processed interface (segmentation is caused
+      // by hanging nodes on the other side of the interface).
+      for (int neighbor_i = 0; neighbor_i < ns.get_num_neighbors(); neighbor_i++)
       {
-        fake_ext_fns[i]->free_ord();
-        delete fake_ext_fns[i];
-      }
-      free_with_check(fake_ext_fns);
+        ns.active_segment = neighbor_i;
+        ns.neighb_el = ns.neighbors[neighbor_i];
+        ns.neighbor_edge = ns.neighbor_edges[neighbor_i];
 
-      fake_e->free_ord();
-      delete fake_e;
+        if (ns.central_transformations[neighbor_i])
+          ns.central_transformations[neighbor_i]->apply_on(sln);
 
-      //delete fake_ext;
+        int order = g_quad_2d_std.get_max_order(e->get_mode());
+        ns.set_quad_order(order);
 
-      Quad2D* quad = this->sln[err_est_form->i]->get_quad_2d();
-      int eo = quad->get_edge_points(surf_pos->surf_num, order, rm->get_active_element()->get_mode());
-      int np = quad->get_num_points(eo, rm->get_active_element()->get_mode());
-      double3* pt = quad->get_points(eo, rm->get_active_element()->get_mode());
+        RefMap* refmap = sln->get_refmap();
+        Geom<double>* geometry;
+        double* jacobian_x_weights;
+        int n_quadrature_points = init_surface_geometry_points(&refmap, 1, order, edge.isurf, e->en[edge.isurf]->marker, geometry, jacobian_x_weights);
+        InterfaceGeom<double>* interface_geometry = new InterfaceGeom<double>(geometry, ns.neighb_el->marker, ns.neighb_el->id, ns.neighb_el->diameter);
 
-      // Initialize geometry and jacobian*weights (do not use the NeighborSearch caching mechanism).
-      double3* tan;
-      Geom<double>* e = new InterfaceGeom<double>(init_geom_surf(rm, surf_pos->surf_num, surf_pos->marker, eo, tan),
-                                                  nbs->neighb_el->marker,
-                                                  nbs->neighb_el->id,
-                                                  nbs->neighb_el->get_diameter());
+        DiscontinuousFunc<Scalar>* u = ns.init_ext_fn(sln);
 
-      double* jwt = malloc_with_check(np, this);
-      for(int i = 0; i < np; i++)
-        jwt[i] = pt[i][2] * tan[i][2];
+        for (unsigned int iest = 0; iest < this->error_estimators_surf.size(); iest++)
+        {
+          ErrorEstimatorForm* form = this->error_estimators_surf[iest];
+          if (form->i != i || form->area != H2D_DG_INNER_EDGE)
+            continue;
 
-      // Function values.
-      DiscontinuousFunc<Scalar>** ui = this->dp.init_ext_fns(slns, neighbor_searches, order, 0);
+          // Edges are parameterized from 0 to 1 while integration weights are defined in (-1, 1),
+          // the second 0.5 distributes the error equally onto the two neighboring elements.
+          double central_err = 0.5 * 0.5 * std::abs(this->interface_scaling_const * form->value(n_quadrature_points, jacobian_x_weights, nullptr, u, interface_geometry, nullptr));
+          double neighb_err = central_err;
 
-      Scalar res = interface_scaling_const *
-        err_est_form->value(np, jwt, nullptr, ui[err_est_form->i], e, nullptr);
+          // Scale the error estimate by the scaling function dependent on the element diameter.
+          if (this->use_aposteriori_interface_scaling && this->interface_scaling_fns[i])
+          {
+            Mesh::MarkersConversion::StringValid marker = mesh->get_element_markers_conversion().get_user_marker(e->marker);
+            if (!marker.valid)
+              throw Hermes::Exceptions::Exception("Marker not valid.");
+            central_err *= this->interface_scaling_fns[i]->value(e->diameter, marker.marker);
+          }
 
-      if(ui != nullptr)
-      {
-        for(unsigned int i = 0; i < slns.size(); i++)
-          ui[i]->free_fn();
-        free_with_check(ui);
-      }
+          data.errors[i][e->id] += central_err;
+
+          // This edge is not evaluated from the other side, add the error to that element as well.
+          if (this->ignore_visited_segments)
+          {
+            Element* neighb = ns.neighb_el;
+            if (this->use_aposteriori_interface_scaling && this->interface_scaling_fns[i])
+            {
+              Mesh::MarkersConversion::StringValid marker = mesh->get_element_markers_conversion().get_user_marker(neighb->marker);
+              if (!marker.valid)
+                throw Hermes::Exceptions::Exception("Marker not valid.");
+              neighb_err *= this->interface_scaling_fns[i]->value(neighb->diameter, marker.marker);
+            }
 
-      e->free();
-      delete e;
+            data.errors[i][neighb->id] += neighb_err;
+          }
+        }
 
-      free_with_check(jwt);
+        delete u;
+        interface_geometry->free();
+        delete interface_geometry;
+        free_with_check(jacobian_x_weights);
 
-      return std::abs(0.5*res);   // Edges are parameterized from 0 to 1 while integration weights
-                                  // are defined in (-1, 1). Thus multiplying with 0.5 to correct
-                                  // the weights.
+        // Clear the transformations.
+        sln->set_transform(ns.original_central_el_transform);
+      }
     }
 
-    // #endif
     template HERMES_API class KellyTypeAdapt<double>;
     template HERMES_API class KellyTypeAdapt<std::complex<double> >;
     template HERMES_API class BasicKellyAdapt<double>;
     template HERMES_API class BasicKellyAdapt<std::complex<double> >;
   }
 }
-*/
\ No newline at end of file
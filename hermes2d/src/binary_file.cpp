@@ -0,0 +1,213 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "binary_file.h"
+
+#ifndef _WINDOWS
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    static const char H2D_BINARY_FILE_MAGIC[4] = { 'H', '2', 'D', 'B' };
+
+    /// Sections are padded to this number of bytes, so that all arrays in the mapping are aligned.
+    static const uint64_t H2D_BINARY_FILE_ALIGNMENT = 8;
+
+    static bool is_little_endian()
+    {
+      uint32_t test = 1;
+      return *((char*)&test) == 1;
+    }
+
+    BinaryFileWriter::BinaryFileWriter(const char* filename, BinaryFileKind kind) : filename(filename)
+    {
+      if (!is_little_endian())
+        throw Exceptions::Exception("The binary checkpoint format is only supported on little-endian platforms.");
+
+      this->file = fopen(filename, "wb");
+      if (this->file == nullptr)
+        throw Exceptions::IOException(Exceptions::IOException::Write, filename);
+
+      // Header: magic, version, kind, padding.
+      uint32_t header[4] = { 0, H2D_BINARY_FILE_VERSION, (uint32_t)kind, 0 };
+      memcpy(header, H2D_BINARY_FILE_MAGIC, 4);
+      if (fwrite(header, sizeof(header), 1, this->file) != 1)
+        throw Exceptions::IOException(Exceptions::IOException::Write, filename);
+    }
+
+    BinaryFileWriter::~BinaryFileWriter()
+    {
+      if (this->file)
+        fclose(this->file);
+    }
+
+    void BinaryFileWriter::close()
+    {
+      FILE* file = this->file;
+      this->file = nullptr;
+      if (file && fclose(file) != 0)
+        throw Exceptions::IOException(Exceptions::IOException::Write, this->filename);
+    }
+
+    void BinaryFileWriter::write_raw(const void* data, uint64_t item_size, uint64_t count)
+    {
+      uint64_t section_header[2] = { count, item_size };
+      if (fwrite(section_header, sizeof(section_header), 1, this->file) != 1)
+        throw Exceptions::IOException(Exceptions::IOException::Write, this->filename);
+
+      uint64_t bytes = item_size * count;
+      if (bytes > 0 && fwrite(data, 1, bytes, this->file) != bytes)
+        throw Exceptions::IOException(Exceptions::IOException::Write, this->filename);
+
+      static const char padding[H2D_BINARY_FILE_ALIGNMENT] = { 0 };
+      uint64_t padding_bytes = (H2D_BINARY_FILE_ALIGNMENT - bytes % H2D_BINARY_FILE_ALIGNMENT) % H2D_BINARY_FILE_ALIGNMENT;
+      if (padding_bytes > 0 && fwrite(padding, 1, padding_bytes, this->file) != padding_bytes)
+        throw Exceptions::IOException(Exceptions::IOException::Write, this->filename);
+    }
+
+    void BinaryFileWriter::write_string(const std::string& string)
+    {
+      this->write(string.c_str(), string.length());
+    }
+
+    BinaryFileReader::BinaryFileReader(const char* filename, BinaryFileKind kind) : data(nullptr), size(0), position(0), mapped(false), filename(filename)
+    {
+      if (!is_little_endian())
+        throw Exceptions::Exception("The binary checkpoint format is only supported on little-endian platforms.");
+
+#ifndef _WINDOWS
+      int fd = open(filename, O_RDONLY);
+      if (fd == -1)
+        throw Exceptions::IOException(Exceptions::IOException::Read, filename);
+
+      struct stat file_stat;
+      if (fstat(fd, &file_stat) == -1)
+      {
+        close(fd);
+        throw Exceptions::IOException(Exceptions::IOException::Read, filename);
+      }
+      this->size = file_stat.st_size;
+
+      if (this->size > 0)
+      {
+        void* mapping = mmap(nullptr, this->size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
+        {
+          close(fd);
+          throw Exceptions::IOException(Exceptions::IOException::Read, filename);
+        }
+        // The arrays are read sequentially.
+        madvise(mapping, this->size, MADV_SEQUENTIAL);
+        this->data = (char*)mapping;
+        this->mapped = true;
+      }
+      close(fd);
+#else
+      FILE* file = fopen(filename, "rb");
+      if (file == nullptr)
+        throw Exceptions::IOException(Exceptions::IOException::Read, filename);
+      _fseeki64(file, 0, SEEK_END);
+      this->size = _ftelli64(file);
+      rewind(file);
+      this->data = malloc_with_check<char>(this->size);
+      if (fread(this->data, 1, this->size, file) != this->size)
+      {
+        fclose(file);
+        free_with_check(this->data);
+        throw Exceptions::IOException(Exceptions::IOException::Read, filename);
+      }
+      fclose(file);
+#endif
+
+      uint32_t header[4];
+      if (this->size < sizeof(header))
+      {
+        this->release();
+        throw Exceptions::Exception("Binary file %s is too short.", filename);
+      }
+      memcpy(header, this->data, sizeof(header));
+      this->position = sizeof(header);
+
+      if (memcmp(header, H2D_BINARY_FILE_MAGIC, 4))
+      {
+        this->release();
+        throw Exceptions::Exception("File %s is not a Hermes2D binary file.", filename);
+      }
+      if (header[1] != H2D_BINARY_FILE_VERSION)
+      {
+        this->release();
+        throw Exceptions::Exception("Binary file %s has version %u, version %u expected.", filename, header[1], H2D_BINARY_FILE_VERSION);
+      }
+      if (header[2] != (uint32_t)kind)
+      {
+        this->release();
+        throw Exceptions::Exception("Binary file %s contains different data than expected.", filename);
+      }
+    }
+
+    BinaryFileReader::~BinaryFileReader()
+    {
+      this->release();
+    }
+
+    void BinaryFileReader::release()
+    {
+      if (this->data == nullptr)
+        return;
+#ifndef _WINDOWS
+      if (this->mapped)
+        munmap(this->data, this->size);
+#else
+      free_with_check(this->data);
+#endif
+      this->data = nullptr;
+    }
+
+    const char* BinaryFileReader::read_raw(uint64_t item_size, uint64_t& count)
+    {
+      uint64_t section_header[2];
+      if (this->position + sizeof(section_header) > this->size)
+        throw Exceptions::Exception("Binary file %s: unexpected end of file.", this->filename.c_str());
+      memcpy(section_header, this->data + this->position, sizeof(section_header));
+      this->position += sizeof(section_header);
+
+      count = section_header[0];
+      if (section_header[1] != item_size)
+        throw Exceptions::Exception("Binary file %s: wrong item size (%i instead of %i).", this->filename.c_str(), (int)section_header[1], (int)item_size);
+
+      uint64_t bytes = item_size * count;
+      if (this->position + bytes > this->size)
+        throw Exceptions::Exception("Binary file %s: unexpected end of file.", this->filename.c_str());
+
+      const char* section = this->data + this->position;
+      this->position += bytes + (H2D_BINARY_FILE_ALIGNMENT - bytes % H2D_BINARY_FILE_ALIGNMENT) % H2D_BINARY_FILE_ALIGNMENT;
+
+      return section;
+    }
+
+    std::string BinaryFileReader::read_string()
+    {
+      uint64_t count;
+      const char* characters = this->read<char>(count);
+      return std::string(characters, count);
+    }
+  }
+}
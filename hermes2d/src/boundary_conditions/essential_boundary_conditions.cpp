@@ -28,6 +28,8 @@ namespace Hermes
     {
       current_time = 0.0;
       value_const = 0.0;
+      time_independent = false;
+      thread_safe = true;
     }
 
     template<typename Scalar>
@@ -36,6 +38,8 @@ namespace Hermes
       markers.push_back(marker);
       current_time = 0.0;
       value_const = 0.0;
+      time_independent = false;
+      thread_safe = true;
     }
 
     template<typename Scalar>
@@ -55,16 +59,42 @@ namespace Hermes
       return current_time;
     }
 
+    template<typename Scalar>
+    void EssentialBoundaryCondition<Scalar>::set_time_independent(bool to_set)
+    {
+      time_independent = to_set;
+    }
+
+    template<typename Scalar>
+    bool EssentialBoundaryCondition<Scalar>::is_time_independent() const
+    {
+      return time_independent;
+    }
+
+    template<typename Scalar>
+    void EssentialBoundaryCondition<Scalar>::set_thread_safe(bool to_set)
+    {
+      thread_safe = to_set;
+    }
+
+    template<typename Scalar>
+    bool EssentialBoundaryCondition<Scalar>::is_thread_safe() const
+    {
+      return thread_safe;
+    }
+
     template<typename Scalar>
     DefaultEssentialBCConst<Scalar>::DefaultEssentialBCConst(Hermes::vector<std::string> markers, Scalar value_const) : EssentialBoundaryCondition<Scalar>(markers)
     {
       this->value_const = value_const;
+      this->time_independent = true;
     }
 
     template<typename Scalar>
     DefaultEssentialBCConst<Scalar>::DefaultEssentialBCConst(std::string marker, Scalar value_const) : EssentialBoundaryCondition<Scalar>(Hermes::vector<std::string>())
     {
       this->value_const = value_const;
+      this->time_independent = true;
       this->markers.push_back(marker);
     }
 
@@ -18,6 +18,7 @@
 #include "discrete_problem.h"
 #include "function/exact_solution.h"
 #include "mesh/traverse.h"
+#include "load_balancer.h"
 #include "space/space.h"
 #include "function/solution.h"
 #include "api2d.h"
@@ -57,6 +58,16 @@ namespace Hermes
 
       this->nonlinear = true;
       this->add_dirichlet_lift = false;
+      this->report_constant_forms_time_saved = false;
+      this->reuse_congruent_elements = false;
+      this->use_reference_integrals = true;
+
+      this->u_ext_sln_cache = nullptr;
+      this->u_ext_coeff_vec_cache = nullptr;
+      this->u_ext_space_seqs_cache = nullptr;
+      this->u_ext_bc_values_seqs_cache = nullptr;
+      this->u_ext_ndof_cache = 0;
+      this->u_ext_sln_cache_in_threads = false;
 
       // Local number of threads - to avoid calling it over and over again, and against faults caused by the
       // value being changed while assembling.
@@ -85,6 +96,38 @@ namespace Hermes
         delete[] this->threadAssembler;
         this->threadAssembler = nullptr;
       }
+
+      this->free_u_ext_cache();
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::free_u_ext_cache()
+    {
+      if (this->u_ext_sln_cache)
+      {
+        for (int i = 0; i < this->spaces_size; i++)
+          delete this->u_ext_sln_cache[i];
+        delete[] this->u_ext_sln_cache;
+        this->u_ext_sln_cache = nullptr;
+      }
+      free_with_check(this->u_ext_coeff_vec_cache);
+      free_with_check(this->u_ext_space_seqs_cache);
+      free_with_check(this->u_ext_bc_values_seqs_cache);
+      this->u_ext_ndof_cache = 0;
+      this->u_ext_sln_cache_in_threads = false;
+    }
+
+    template<typename Scalar>
+    bool DiscreteProblem<Scalar>::u_ext_cache_valid(Scalar* coeff_vec, int ndof) const
+    {
+      if (!this->u_ext_sln_cache || this->u_ext_ndof_cache != ndof)
+        return false;
+
+      for (int i = 0; i < this->spaces_size; i++)
+      if (this->u_ext_space_seqs_cache[i] != this->spaces[i]->get_seq() || this->u_ext_bc_values_seqs_cache[i] != this->spaces[i]->get_bc_values_seq())
+        return false;
+
+      return memcmp(this->u_ext_coeff_vec_cache, coeff_vec, ndof * sizeof(Scalar)) == 0;
     }
 
     template<typename Scalar>
@@ -156,6 +199,36 @@ namespace Hermes
 
       this->selectiveAssembler.set_weak_formulation(wf_);
       this->selectiveAssembler.matrix_structure_reusable = false;
+
+      // The forms may have changed.
+      this->constantFormCache.free();
+      for (int i = 0; i < this->num_threads_used; i++)
+      if (this->threadAssembler[i]->congruentElementCache)
+        this->threadAssembler[i]->congruentElementCache->free();
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::set_report_constant_forms_time_saved(bool to_set)
+    {
+      this->report_constant_forms_time_saved = to_set;
+    }
+
+    template<typename Scalar>
+    double DiscreteProblem<Scalar>::get_constant_forms_time_saved() const
+    {
+      return this->constantFormCache.get_total_time_saved();
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::set_reuse_congruent_elements(bool to_set)
+    {
+      this->reuse_congruent_elements = to_set;
+    }
+
+    template<typename Scalar>
+    void DiscreteProblem<Scalar>::set_reference_integrals(bool to_set)
+    {
+      this->use_reference_integrals = to_set;
     }
 
     template<typename Scalar>
@@ -187,6 +260,8 @@ namespace Hermes
         spacesToSet[i]->check();
       }
 
+      this->free_u_ext_cache();
+
       this->spaces_size = spacesToSet.size();
       this->spaces = spacesToSet;
 
@@ -225,28 +300,41 @@ namespace Hermes
     template<typename Scalar>
     void DiscreteProblem<Scalar>::assemble(Scalar* coeff_vec, SparseMatrix<Scalar>* mat, Vector<Scalar>* rhs)
     {
-      Solution<Scalar>** u_ext_sln = nullptr;
+      if (!(this->nonlinear && coeff_vec))
+      {
+        assemble((Solution<Scalar>**)nullptr, mat, rhs);
+        return;
+      }
 
-      if (this->nonlinear && coeff_vec)
+      // The previous iterates are kept for the next assembling at the same coefficient vector
+      // (typically the jacobian following the residual at the same Newton iterate).
+      int ndof = Space<Scalar>::get_num_dofs(this->spaces);
+      if (!this->u_ext_cache_valid(coeff_vec, ndof))
       {
-        u_ext_sln = new Solution<Scalar>*[spaces_size];
+        this->free_u_ext_cache();
+
+        this->u_ext_sln_cache = new Solution<Scalar>*[spaces_size];
         int first_dof = 0;
         for (int i = 0; i < this->spaces_size; i++)
         {
-          u_ext_sln[i] = new Solution<Scalar>(spaces[i]->get_mesh());
-          Solution<Scalar>::vector_to_solution(coeff_vec, spaces[i], u_ext_sln[i], !this->rungeKutta, first_dof);
+          this->u_ext_sln_cache[i] = new Solution<Scalar>(spaces[i]->get_mesh());
+          Solution<Scalar>::vector_to_solution(coeff_vec, spaces[i], this->u_ext_sln_cache[i], !this->rungeKutta, first_dof);
           first_dof += spaces[i]->get_num_dofs();
         }
-      }
 
-      assemble(u_ext_sln, mat, rhs);
-
-      if (this->nonlinear && coeff_vec)
-      {
+        this->u_ext_coeff_vec_cache = malloc_with_check<Scalar>(ndof);
+        memcpy(this->u_ext_coeff_vec_cache, coeff_vec, ndof * sizeof(Scalar));
+        this->u_ext_space_seqs_cache = malloc_with_check<int>(this->spaces_size);
+        this->u_ext_bc_values_seqs_cache = malloc_with_check<unsigned int>(this->spaces_size);
         for (int i = 0; i < this->spaces_size; i++)
-          delete u_ext_sln[i];
-        delete[] u_ext_sln;
+        {
+          this->u_ext_space_seqs_cache[i] = this->spaces[i]->get_seq();
+          this->u_ext_bc_values_seqs_cache[i] = this->spaces[i]->get_bc_values_seq();
+        }
+        this->u_ext_ndof_cache = ndof;
       }
+
+      assemble(this->u_ext_sln_cache, mat, rhs);
     }
 
     template<typename Scalar>
@@ -268,6 +356,11 @@ namespace Hermes
           meshes.push_back(spaces[space_i]->get_mesh());
       }
 
+      // The geometry caches may be reallocated only here, not in the parallel assembling.
+      for (unsigned int mesh_i = 0; mesh_i < meshes.size(); mesh_i++)
+      if (meshes[mesh_i]->get_geometry_cache())
+        meshes[mesh_i]->get_geometry_cache()->validate();
+
       // Important.
       // This must be here, because the weakforms may have changed since set_weak_formulation (where the following calls
       // used to be in development). And since the following clones the passed WeakForm, this has to be called
@@ -305,47 +398,105 @@ namespace Hermes
         // Is this a DG assembling.
         bool is_DG = this->wf->is_DG();
 
+        // Are there any constant matrix forms whose integrals can be reused.
+        bool use_constant_form_cache = false;
+        if (this->current_mat || this->add_dirichlet_lift)
+        {
+          for (unsigned int form_i = 0; form_i < this->wf->mfvol.size(); form_i++)
+          if (this->wf->mfvol[form_i]->constant)
+            use_constant_form_cache = true;
+          for (unsigned int form_i = 0; form_i < this->wf->mfsurf.size(); form_i++)
+          if (this->wf->mfsurf[form_i]->constant)
+            use_constant_form_cache = true;
+        }
+        if (use_constant_form_cache)
+        {
+          this->constantFormCache.prepare(this->spaces, meshes, num_states);
+          this->constantFormCache.begin_statistics();
+        }
+        unsigned int congruent_element_lookups = 0, congruent_element_hits = 0;
+        for (int i = 0; i < this->num_threads_used; i++)
+        {
+          this->threadAssembler[i]->constantFormCache = use_constant_form_cache ? &this->constantFormCache : nullptr;
+          this->threadAssembler[i]->measure_constant_form_time = this->report_constant_forms_time_saved;
+          this->threadAssembler[i]->use_reference_integrals = this->use_reference_integrals;
+
+          if (this->reuse_congruent_elements && !this->threadAssembler[i]->congruentElementCache)
+            this->threadAssembler[i]->congruentElementCache = new DiscreteProblemCongruentElementCache<Scalar>();
+          if (!this->reuse_congruent_elements && this->threadAssembler[i]->congruentElementCache)
+          {
+            delete this->threadAssembler[i]->congruentElementCache;
+            this->threadAssembler[i]->congruentElementCache = nullptr;
+          }
+          if (this->threadAssembler[i]->congruentElementCache)
+          {
+            congruent_element_lookups -= this->threadAssembler[i]->congruentElementCache->get_lookups();
+            congruent_element_hits -= this->threadAssembler[i]->congruentElementCache->get_hits();
+          }
+        }
+
+        // The threads still hold their copies of the cached previous iterates from the last assembling.
+        bool u_ext_unchanged = u_ext_sln && u_ext_sln == this->u_ext_sln_cache && this->u_ext_sln_cache_in_threads;
+        this->u_ext_sln_cache_in_threads = false;
+
+        // The states are distributed among the threads according to their polynomial orders.
+        LoadBalancer loadBalancer(num_states, this->num_threads_used);
+        int num_volumetric_forms = this->wf->mfvol.size() + this->wf->vfvol.size();
+        int num_surface_forms = this->wf->mfsurf.size() + this->wf->vfsurf.size();
+        for (int state_i = 0; state_i < num_states; state_i++)
+          loadBalancer.set_cost(state_i, LoadBalancer::get_assembling_cost(states[state_i], this->spaces, num_volumetric_forms + (states[state_i]->isBnd ? num_surface_forms : 0)));
+        loadBalancer.init();
+
 #pragma omp parallel num_threads(this->num_threads_used)
         {
           int thread_number = omp_get_thread_num();
-          int start = (num_states / this->num_threads_used) * thread_number;
-          int end = (num_states / this->num_threads_used) * (thread_number + 1);
-          if (thread_number == this->num_threads_used - 1)
-            end = num_states;
+          loadBalancer.begin_thread(thread_number);
 
           try
           {
-            this->threadAssembler[thread_number]->init_assembling(u_ext_sln, spaces, this->nonlinear, this->add_dirichlet_lift);
+            this->threadAssembler[thread_number]->init_assembling(u_ext_sln, spaces, this->nonlinear, this->add_dirichlet_lift, u_ext_unchanged);
 
             DiscreteProblemDGAssembler<Scalar>* dgAssembler;
             if (is_DG)
               dgAssembler = new DiscreteProblemDGAssembler<Scalar>(this->threadAssembler[thread_number], this->spaces, meshes);
 
-            for (int state_i = start; state_i < end; state_i++)
+            int start, end;
+            while (this->exceptionMessageCaughtInParallelBlock.empty() && loadBalancer.get_chunk(thread_number, start, end))
             {
-              // Exception already thrown -> exit the loop.
-              if (!this->exceptionMessageCaughtInParallelBlock.empty())
-                break;
+              for (int state_i = start; state_i < end; state_i++)
+              {
+                // Exception already thrown -> exit the loop.
+                if (!this->exceptionMessageCaughtInParallelBlock.empty())
+                  break;
 
-              Traverse::State* current_state = states[state_i];
+                Traverse::State* current_state = states[state_i];
 
-              this->threadAssembler[thread_number]->init_assembling_one_state(spaces, current_state);
+                this->threadAssembler[thread_number]->current_state_index = state_i;
+                this->threadAssembler[thread_number]->init_assembling_one_state(spaces, current_state);
 
-              this->threadAssembler[thread_number]->assemble_one_state();
+                this->threadAssembler[thread_number]->assemble_one_state();
 
-              if (is_DG)
-              {
-                dgAssembler->init_assembling_one_state(current_state);
-                dgAssembler->assemble_one_state();
-                dgAssembler->deinit_assembling_one_state();
+                if (is_DG)
+                {
+                  dgAssembler->init_assembling_one_state(current_state);
+                  dgAssembler->assemble_one_state();
+                  dgAssembler->deinit_assembling_one_state();
+                }
+                this->threadAssembler[thread_number]->deinit_assembling_one_state();
               }
-              this->threadAssembler[thread_number]->deinit_assembling_one_state();
             }
 
             if (is_DG)
               delete dgAssembler;
 
             this->threadAssembler[thread_number]->deinit_assembling();
+
+            if (use_constant_form_cache)
+            {
+#pragma omp critical (constantFormCacheStatistics)
+              this->constantFormCache.add_statistics(this->threadAssembler[thread_number]->constant_form_blocks_integrated,
+                this->threadAssembler[thread_number]->constantFormTimer.accumulated(), this->threadAssembler[thread_number]->constant_form_blocks_reused);
+            }
           }
           catch (Hermes::Exceptions::Exception& e)
           {
@@ -357,6 +508,42 @@ namespace Hermes
 #pragma omp critical (exceptionMessageCaughtInParallelBlock)
             this->exceptionMessageCaughtInParallelBlock = e.what();
           }
+
+          loadBalancer.end_thread(thread_number);
+        }
+
+        if (this->report_load_balance)
+          loadBalancer.report(this, "Assembling");
+
+        if (this->exceptionMessageCaughtInParallelBlock.empty())
+          this->u_ext_sln_cache_in_threads = this->nonlinear && u_ext_sln && u_ext_sln == this->u_ext_sln_cache;
+
+        if (use_constant_form_cache && this->reuse_congruent_elements)
+        {
+          unsigned int congruent_element_entries = 0;
+          for (int i = 0; i < this->num_threads_used; i++)
+          {
+            // An interrupted assembling may have left some of the integrals unfinished.
+            if (!this->exceptionMessageCaughtInParallelBlock.empty())
+              this->threadAssembler[i]->congruentElementCache->free();
+            congruent_element_lookups += this->threadAssembler[i]->congruentElementCache->get_lookups();
+            congruent_element_hits += this->threadAssembler[i]->congruentElementCache->get_hits();
+            congruent_element_entries += this->threadAssembler[i]->congruentElementCache->get_num_entries();
+          }
+          if (this->exceptionMessageCaughtInParallelBlock.empty())
+            this->info("Congruent elements: %u of %u local matrices reused, %u distinct local matrices stored.", congruent_element_hits, congruent_element_lookups, congruent_element_entries);
+        }
+
+        if (use_constant_form_cache)
+        {
+          // An interrupted assembling may have left some of the integrals unfinished.
+          if (!this->exceptionMessageCaughtInParallelBlock.empty())
+            this->constantFormCache.free();
+          else if (this->report_constant_forms_time_saved)
+          {
+            this->constantFormCache.end_statistics();
+            this->info("Constant forms: reused cached integrals, time saved approx. %f s (total %f s).", this->constantFormCache.get_last_time_saved(), this->constantFormCache.get_total_time_saved());
+          }
         }
       }
 
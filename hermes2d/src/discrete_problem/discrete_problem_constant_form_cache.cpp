@@ -0,0 +1,251 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "discrete_problem/discrete_problem_constant_form_cache.h"
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    template<typename Scalar>
+    DiscreteProblemConstantFormCache<Scalar>::DiscreteProblemConstantFormCache()
+      : blocks(nullptr), num_states(0), integrated_blocks(0), integration_time(0.), last_reused_blocks(0), total_time_saved(0.)
+    {
+    }
+
+    template<typename Scalar>
+    DiscreteProblemConstantFormCache<Scalar>::~DiscreteProblemConstantFormCache()
+    {
+      this->free();
+    }
+
+    template<typename Scalar>
+    void DiscreteProblemConstantFormCache<Scalar>::free()
+    {
+      if (this->blocks)
+      {
+        for (int state_i = 0; state_i < this->num_states; state_i++)
+        for (unsigned int block_i = 0; block_i < this->blocks[state_i].size(); block_i++)
+          free_with_check(this->blocks[state_i][block_i].values);
+        delete[] this->blocks;
+        this->blocks = nullptr;
+      }
+      this->num_states = 0;
+      this->seqs.clear();
+      this->integrated_blocks = 0;
+      this->integration_time = 0.;
+    }
+
+    template<typename Scalar>
+    void DiscreteProblemConstantFormCache<Scalar>::prepare(const Hermes::vector<SpaceSharedPtr<Scalar> >& spaces, const Hermes::vector<MeshSharedPtr>& meshes, int num_states_)
+    {
+      Hermes::vector<int> new_seqs;
+      for (unsigned int space_i = 0; space_i < spaces.size(); space_i++)
+        new_seqs.push_back(spaces[space_i]->get_seq());
+      for (unsigned int mesh_i = 0; mesh_i < meshes.size(); mesh_i++)
+        new_seqs.push_back(meshes[mesh_i]->get_seq());
+
+      if (this->blocks && num_states_ == this->num_states && new_seqs == this->seqs)
+        return;
+
+      this->free();
+      this->seqs = new_seqs;
+      this->num_states = num_states_;
+      this->blocks = new Hermes::vector<Block>[num_states_];
+    }
+
+    template<typename Scalar>
+    Scalar* DiscreteProblemConstantFormCache<Scalar>::get(int state_i, int form_key) const
+    {
+      const Hermes::vector<Block>& state_blocks = this->blocks[state_i];
+      for (unsigned int block_i = 0; block_i < state_blocks.size(); block_i++)
+      if (state_blocks[block_i].form_key == form_key)
+        return state_blocks[block_i].values;
+      return nullptr;
+    }
+
+    template<typename Scalar>
+    Scalar* DiscreteProblemConstantFormCache<Scalar>::insert(int state_i, int form_key, int size)
+    {
+      Block block;
+      block.form_key = form_key;
+      block.values = malloc_with_check<Scalar>(size);
+      this->blocks[state_i].push_back(block);
+      return block.values;
+    }
+
+    template<typename Scalar>
+    void DiscreteProblemConstantFormCache<Scalar>::begin_statistics()
+    {
+      this->last_reused_blocks = 0;
+    }
+
+    template<typename Scalar>
+    void DiscreteProblemConstantFormCache<Scalar>::end_statistics()
+    {
+      this->total_time_saved += this->get_last_time_saved();
+    }
+
+    template<typename Scalar>
+    void DiscreteProblemConstantFormCache<Scalar>::add_statistics(int integrated_blocks_, double integration_time_, int reused_blocks_)
+    {
+      this->integrated_blocks += integrated_blocks_;
+      this->integration_time += integration_time_;
+      this->last_reused_blocks += reused_blocks_;
+    }
+
+    template<typename Scalar>
+    double DiscreteProblemConstantFormCache<Scalar>::get_last_time_saved() const
+    {
+      if (this->integrated_blocks == 0)
+        return 0.;
+      return this->integration_time * this->last_reused_blocks / this->integrated_blocks;
+    }
+
+    template<typename Scalar>
+    double DiscreteProblemConstantFormCache<Scalar>::get_total_time_saved() const
+    {
+      return this->total_time_saved;
+    }
+
+    template<typename Scalar>
+    DiscreteProblemCongruentElementCache<Scalar>::DiscreteProblemCongruentElementCache()
+      : current_key_length(0), current_hash(0), lookups(0), hits(0)
+    {
+    }
+
+    template<typename Scalar>
+    DiscreteProblemCongruentElementCache<Scalar>::~DiscreteProblemCongruentElementCache()
+    {
+      this->free();
+    }
+
+    template<typename Scalar>
+    void DiscreteProblemCongruentElementCache<Scalar>::free()
+    {
+      for (typename std::map<uint64_t, Entry>::iterator it = this->entries.begin(); it != this->entries.end(); ++it)
+      {
+        free_with_check(it->second.key);
+        free_with_check(it->second.values);
+      }
+      this->entries.clear();
+      this->lookups = 0;
+      this->hits = 0;
+    }
+
+    /// Relative quantisation - the exponent and the first 30 bits of the mantissa.
+    static void quantise(double value, int* target)
+    {
+      int exponent;
+      double mantissa = frexp(value, &exponent);
+      target[0] = (mantissa == 0.) ? 0 : exponent;
+      target[1] = (int)std::floor(mantissa * (1 << 30) + 0.5);
+    }
+
+    template<typename Scalar>
+    void DiscreteProblemCongruentElementCache<Scalar>::set_key(int form_key, int order, RefMap* rep_refmap, uint64_t sub_idx_i, uint64_t sub_idx_j, AsmList<Scalar>* als_i, AsmList<Scalar>* als_j)
+    {
+      int* key = this->current_key;
+      *key++ = form_key;
+      *key++ = rep_refmap->get_active_element()->get_mode();
+      *key++ = order;
+      *key++ = (int)(sub_idx_i & 0xffffffff);
+      *key++ = (int)(sub_idx_i >> 32);
+      *key++ = (int)(sub_idx_j & 0xffffffff);
+      *key++ = (int)(sub_idx_j >> 32);
+
+      // The inverse reference map relative to its largest entry (exact for congruent elements up to rounding),
+      // together with the scale and the jacobian.
+      double2x2* inv_ref_map = rep_refmap->get_const_inv_ref_map();
+      double scale = std::max(std::max(std::abs((*inv_ref_map)[0][0]), std::abs((*inv_ref_map)[0][1])), std::max(std::abs((*inv_ref_map)[1][0]), std::abs((*inv_ref_map)[1][1])));
+      for (int i = 0; i < 2; i++)
+      for (int j = 0; j < 2; j++)
+        *key++ = (int)std::floor((*inv_ref_map)[i][j] / scale * (1 << 30) + 0.5);
+      quantise(scale, key);
+      key += 2;
+      quantise(rep_refmap->get_const_jacobian(), key);
+      key += 2;
+
+      *key++ = als_i->cnt;
+      memcpy(key, als_i->idx, als_i->cnt * sizeof(int));
+      key += als_i->cnt;
+      *key++ = als_j->cnt;
+      memcpy(key, als_j->idx, als_j->cnt * sizeof(int));
+      key += als_j->cnt;
+
+      this->current_key_length = key - this->current_key;
+
+      // FNV-1a.
+      this->current_hash = 14695981039346656037ULL;
+      for (int i = 0; i < this->current_key_length; i++)
+      {
+        this->current_hash ^= (uint64_t)(unsigned int)this->current_key[i];
+        this->current_hash *= 1099511628211ULL;
+      }
+    }
+
+    template<typename Scalar>
+    Scalar* DiscreteProblemCongruentElementCache<Scalar>::get()
+    {
+      this->lookups++;
+      typename std::map<uint64_t, Entry>::iterator it = this->entries.find(this->current_hash);
+      if (it == this->entries.end())
+        return nullptr;
+      // Hash collision - the entry belongs to another key, the integrals will not be stored.
+      if (it->second.key_length != this->current_key_length || memcmp(it->second.key, this->current_key, this->current_key_length * sizeof(int)))
+        return nullptr;
+      this->hits++;
+      return it->second.values;
+    }
+
+    template<typename Scalar>
+    Scalar* DiscreteProblemCongruentElementCache<Scalar>::insert(int size)
+    {
+      if (this->entries.find(this->current_hash) != this->entries.end())
+        return nullptr;
+
+      Entry entry;
+      entry.key_length = this->current_key_length;
+      entry.key = malloc_with_check<int>(this->current_key_length);
+      memcpy(entry.key, this->current_key, this->current_key_length * sizeof(int));
+      entry.values = malloc_with_check<Scalar>(size);
+      this->entries.insert(std::pair<uint64_t, Entry>(this->current_hash, entry));
+      return entry.values;
+    }
+
+    template<typename Scalar>
+    unsigned int DiscreteProblemCongruentElementCache<Scalar>::get_lookups() const
+    {
+      return this->lookups;
+    }
+
+    template<typename Scalar>
+    unsigned int DiscreteProblemCongruentElementCache<Scalar>::get_hits() const
+    {
+      return this->hits;
+    }
+
+    template<typename Scalar>
+    unsigned int DiscreteProblemCongruentElementCache<Scalar>::get_num_entries() const
+    {
+      return this->entries.size();
+    }
+
+    template class HERMES_API DiscreteProblemConstantFormCache<double>;
+    template class HERMES_API DiscreteProblemConstantFormCache<std::complex<double> >;
+    template class HERMES_API DiscreteProblemCongruentElementCache<double>;
+    template class HERMES_API DiscreteProblemCongruentElementCache<std::complex<double> >;
+  }
+}
@@ -131,11 +131,7 @@ namespace Hermes
           jacobian_x_weights[i] = pt[i][2] * jac;
       }
       else
-      {
-        double* jac = rep_reference_mapping->get_jacobian(order);
-        for (int i = 0; i < np; i++)
-          jacobian_x_weights[i] = pt[i][2] * jac[i];
-      }
+        memcpy(jacobian_x_weights, rep_reference_mapping->get_jacobian_x_weights(order), np * sizeof(double));
       return np;
     }
 
@@ -155,11 +151,7 @@ namespace Hermes
           jacobian_x_weights[i] = pt[i][2] * jac;
       }
       else
-      {
-        double* jac = rep_reference_mapping->get_jacobian(order);
-        for (int i = 0; i < np; i++)
-          jacobian_x_weights[i] = pt[i][2] * jac[i];
-      }
+        memcpy(jacobian_x_weights, rep_reference_mapping->get_jacobian_x_weights(order), np * sizeof(double));
       return np;
     }
 
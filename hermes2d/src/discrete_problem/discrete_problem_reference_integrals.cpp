@@ -0,0 +1,207 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "discrete_problem/discrete_problem_reference_integrals.h"
+#include "quadrature/quad_all.h"
+#include "api2d.h"
+#include <fstream>
+#include <map>
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    /// All tables, the key combines the shapeset id, the mode and the order.
+    class ReferenceIntegralTableRegistry
+    {
+    public:
+      ~ReferenceIntegralTableRegistry()
+      {
+        this->free();
+      }
+
+      void free();
+
+      std::map<int, ReferenceIntegralTable*> tables;
+    };
+
+    static ReferenceIntegralTableRegistry reference_integral_tables;
+
+    static inline int reference_integral_table_key(int shapeset_id, ElementMode2D mode, int order)
+    {
+      return (shapeset_id * 2 + (int)mode) * (H2D_ORDER_MASK + 1) + order;
+    }
+
+    ReferenceIntegralTable::ReferenceIntegralTable(Shapeset* shapeset, ElementMode2D mode, int order)
+      : shapeset_id(shapeset->get_id()), mode(mode), order(order), max_index(shapeset->get_max_index(mode)), positions(nullptr), count(0), values(nullptr)
+    {
+      this->positions = malloc_with_check<int>(this->max_index + 1);
+      for (int index = 0; index <= this->max_index; index++)
+      {
+        int index_order = shapeset->get_order(index, mode);
+        if (mode == HERMES_MODE_QUAD)
+          index_order = std::max(H2D_GET_H_ORDER(index_order), H2D_GET_V_ORDER(index_order));
+        this->positions[index] = (index_order <= order) ? this->count++ : -1;
+      }
+
+      if (!this->load())
+      {
+        this->calculate(shapeset);
+        this->save();
+      }
+    }
+
+    ReferenceIntegralTable::~ReferenceIntegralTable()
+    {
+      free_with_check(this->positions);
+      free_with_check(this->values);
+    }
+
+    const ReferenceIntegralTable* ReferenceIntegralTable::get(Shapeset* shapeset, ElementMode2D mode, int order)
+    {
+      // The products of the shape functions have to be integrated exactly.
+      if (order < 0 || order > H2D_ORDER_MASK || 2 * order > g_quad_2d_std.get_safe_max_order(mode) || shapeset->get_num_components() != 1)
+        return nullptr;
+
+      ReferenceIntegralTable* table;
+#pragma omp critical (ReferenceIntegralTables)
+      {
+        int key = reference_integral_table_key(shapeset->get_id(), mode, order);
+        std::map<int, ReferenceIntegralTable*>::iterator it = reference_integral_tables.tables.find(key);
+        if (it == reference_integral_tables.tables.end())
+        {
+          table = new ReferenceIntegralTable(shapeset, mode, order);
+          reference_integral_tables.tables.insert(std::pair<int, ReferenceIntegralTable*>(key, table));
+        }
+        else
+          table = it->second;
+      }
+      return table;
+    }
+
+    void ReferenceIntegralTableRegistry::free()
+    {
+      for (std::map<int, ReferenceIntegralTable*>::iterator it = this->tables.begin(); it != this->tables.end(); ++it)
+        delete it->second;
+      this->tables.clear();
+    }
+
+    void ReferenceIntegralTable::free_all()
+    {
+#pragma omp critical (ReferenceIntegralTables)
+      reference_integral_tables.free();
+    }
+
+    unsigned long ReferenceIntegralTable::get_memory_size() const
+    {
+      return (this->max_index + 1) * sizeof(int) + (unsigned long)NumIntegralTypes * this->count * this->count * sizeof(double);
+    }
+
+    void ReferenceIntegralTable::calculate(Shapeset* shapeset)
+    {
+      int quad_order = 2 * this->order;
+      int np = g_quad_2d_std.get_num_points(quad_order, this->mode);
+      double3* pt = g_quad_2d_std.get_points(quad_order, this->mode);
+
+      // Values, xi_0 and xi_1 derivatives of all the functions at the points.
+      double* fns = malloc_with_check<double>(3 * this->count * np);
+      for (int index = 0; index <= this->max_index; index++)
+      {
+        int position = this->positions[index];
+        if (position < 0)
+          continue;
+        double* fn = fns + 3 * position * np;
+        for (int i = 0; i < np; i++)
+        {
+          fn[i] = shapeset->get_fn_value(index, pt[i][0], pt[i][1], 0, this->mode);
+          fn[np + i] = shapeset->get_dx_value(index, pt[i][0], pt[i][1], 0, this->mode);
+          fn[2 * np + i] = shapeset->get_dy_value(index, pt[i][0], pt[i][1], 0, this->mode);
+        }
+      }
+
+      int size = this->count * this->count;
+      this->values = calloc_with_check<double>(NumIntegralTypes * size);
+      for (int row = 0; row < this->count; row++)
+      {
+        double* v = fns + 3 * row * np;
+        for (int col = 0; col < this->count; col++)
+        {
+          double* u = fns + 3 * col * np;
+          double* target = this->values + row * this->count + col;
+          for (int i = 0; i < np; i++)
+          {
+            double w = pt[i][2];
+            target[Mass * size] += w * u[i] * v[i];
+            for (int a = 0; a < 2; a++)
+            for (int b = 0; b < 2; b++)
+              target[(Stiffness + 2 * a + b) * size] += w * u[(b + 1) * np + i] * v[(a + 1) * np + i];
+            for (int b = 0; b < 2; b++)
+              target[(Advection + b) * size] += w * u[(b + 1) * np + i] * v[i];
+          }
+        }
+      }
+
+      free_with_check(fns);
+    }
+
+    std::string ReferenceIntegralTable::get_file_name() const
+    {
+      std::stringstream ss;
+      ss << Hermes2DApi.get_text_param_value(precalculatedFormsDirPath) << "reference_integrals_" << this->shapeset_id << '_' << (int)this->mode << '_' << this->order << ".dat";
+      return ss.str();
+    }
+
+    bool ReferenceIntegralTable::save() const
+    {
+      std::ofstream out(this->get_file_name().c_str(), std::ios::out | std::ios::binary);
+      if (!out.good())
+        return false;
+
+      int header[5] = { this->shapeset_id, (int)this->mode, this->order, this->max_index, this->count };
+      out.write((const char*)header, sizeof(header));
+      out.write((const char*)this->positions, (this->max_index + 1) * sizeof(int));
+      out.write((const char*)this->values, NumIntegralTypes * this->count * this->count * sizeof(double));
+      return out.good();
+    }
+
+    bool ReferenceIntegralTable::load()
+    {
+      std::ifstream in(this->get_file_name().c_str(), std::ios::in | std::ios::binary);
+      if (!in.good())
+        return false;
+
+      int header[5];
+      in.read((char*)header, sizeof(header));
+      if (!in.good() || header[0] != this->shapeset_id || header[1] != (int)this->mode || header[2] != this->order || header[3] != this->max_index || header[4] != this->count)
+        return false;
+
+      int* stored_positions = malloc_with_check<int>(this->max_index + 1);
+      in.read((char*)stored_positions, (this->max_index + 1) * sizeof(int));
+      bool positions_match = in.good() && memcmp(stored_positions, this->positions, (this->max_index + 1) * sizeof(int)) == 0;
+      free_with_check(stored_positions);
+      if (!positions_match)
+        return false;
+
+      this->values = malloc_with_check<double>(NumIntegralTypes * this->count * this->count);
+      in.read((char*)this->values, NumIntegralTypes * this->count * this->count * sizeof(double));
+      if (!in.good())
+      {
+        free_with_check(this->values);
+        return false;
+      }
+      return true;
+    }
+  }
+}
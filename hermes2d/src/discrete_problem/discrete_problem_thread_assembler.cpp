@@ -28,7 +28,9 @@ namespace Hermes
     DiscreteProblemThreadAssembler<Scalar>::DiscreteProblemThreadAssembler(DiscreteProblemSelectiveAssembler<Scalar>* selectiveAssembler) :
       pss(nullptr), refmaps(nullptr), u_ext(nullptr),
       selectiveAssembler(selectiveAssembler), integrationOrderCalculator(selectiveAssembler),
-      ext_funcs(nullptr), ext_funcs_allocated_size(0), ext_funcs_local(nullptr), ext_funcs_local_allocated_size(0)
+      ext_funcs(nullptr), ext_funcs_allocated_size(0), ext_funcs_local(nullptr), ext_funcs_local_allocated_size(0),
+      current_state_index(-1), constantFormCache(nullptr), constant_form_blocks_integrated(0), constant_form_blocks_reused(0), measure_constant_form_time(false),
+      congruentElementCache(nullptr), congruent_element_key_set(false), use_reference_integrals(true), reference_integrals_shapeset_id(-1)
     {
     }
 
@@ -93,7 +95,7 @@ namespace Hermes
     }
 
     template<typename Scalar>
-    void DiscreteProblemThreadAssembler<Scalar>::init_assembling(Solution<Scalar>** u_ext_sln, const Hermes::vector<SpaceSharedPtr<Scalar> >& spaces, bool nonlinear_, bool add_dirichlet_lift_)
+    void DiscreteProblemThreadAssembler<Scalar>::init_assembling(Solution<Scalar>** u_ext_sln, const Hermes::vector<SpaceSharedPtr<Scalar> >& spaces, bool nonlinear_, bool add_dirichlet_lift_, bool u_ext_unchanged)
     {
       // Init the memory pool - if PJLIB is linked, it will do the magic, if not, it will initialize the pointer to null.
       this->init_funcs_memory_pool();
@@ -102,6 +104,15 @@ namespace Hermes
       this->nonlinear = nonlinear_;
       this->add_dirichlet_lift = add_dirichlet_lift_;
 
+      // Constant forms statistics.
+      this->constant_form_blocks_integrated = 0;
+      this->constant_form_blocks_reused = 0;
+      this->constantFormTimer.reset();
+
+      // Geometry caches of the meshes (these may have been enabled or disabled since init_spaces()).
+      for (unsigned j = 0; j < this->spaces_size; j++)
+        refmaps[j]->set_geometry_cache(spaces[j]->get_mesh()->get_geometry_cache());
+
       // Transformables setup.
       fns.clear();
       // - precalc shapesets.
@@ -132,7 +143,8 @@ namespace Hermes
       // - u_ext.
       if (this->nonlinear)
       {
-        init_u_ext(spaces, u_ext_sln);
+        if (!(u_ext_unchanged && this->u_ext))
+          init_u_ext(spaces, u_ext_sln);
         for (unsigned j = 0; j < this->wf->get_neq(); j++)
         {
           fns.push_back(u_ext[j]);
@@ -448,8 +460,11 @@ namespace Hermes
 
       if (this->rungeKutta)
       {
+        // The stage vectors in u_ext only hold h \sum_{j} a_{ij} K_j, the previous time level solution belongs to all of them.
+        int num_stages = this->spaces_size / this->RK_original_spaces_count;
         for (int ext_i = 0; ext_i < ext.size(); ext_i++)
-          u_ext_func[ext_i]->add(target_array[ext.size() - this->RK_original_spaces_count + ext_i]);
+          for (int stage_i = 0; stage_i < num_stages; stage_i++)
+            u_ext_func[stage_i * this->RK_original_spaces_count + ext_i]->add(target_array[ext.size() - this->RK_original_spaces_count + ext_i]);
       }
     }
 
@@ -472,7 +487,8 @@ namespace Hermes
           int form_i = this->wf->mfvol[current_mfvol_i]->i;
           int form_j = this->wf->mfvol[current_mfvol_i]->j;
 
-          this->assemble_matrix_form(this->wf->mfvol[current_mfvol_i], order, funcs[form_j], funcs[form_i], &als[form_i], &als[form_j], n_quadrature_points, geometry, jacobian_x_weights);
+          this->assemble_matrix_form(this->wf->mfvol[current_mfvol_i], order, funcs[form_j], funcs[form_i], &als[form_i], &als[form_j], n_quadrature_points, geometry, jacobian_x_weights,
+            current_mfvol_i);
         }
       }
       if (this->current_rhs)
@@ -518,7 +534,8 @@ namespace Hermes
               int form_j = this->wf->mfsurf[current_mfsurf_i]->j;
 
               this->assemble_matrix_form(this->wf->mfsurf[current_mfsurf_i], orderSurface[isurf], funcsSurface[isurf][form_j], funcsSurface[isurf][form_i],
-                &alsSurface[isurf][form_i], &alsSurface[isurf][form_j], n_quadrature_pointsSurface[isurf], geometrySurface[isurf], jacobian_x_weightsSurface[isurf]);
+                &alsSurface[isurf][form_i], &alsSurface[isurf][form_j], n_quadrature_pointsSurface[isurf], geometrySurface[isurf], jacobian_x_weightsSurface[isurf],
+                this->wf->mfvol.size() + current_mfsurf_i * H2D_MAX_NUMBER_EDGES + isurf);
             }
           }
 
@@ -541,7 +558,7 @@ namespace Hermes
 
     template<typename Scalar>
     void DiscreteProblemThreadAssembler<Scalar>::assemble_matrix_form(MatrixForm<Scalar>* form, int order, Func<double>** base_fns, Func<double>** test_fns,
-      AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, int n_quadrature_points, Geom<double>* geometry, double* jacobian_x_weights)
+      AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, int n_quadrature_points, Geom<double>* geometry, double* jacobian_x_weights, int constant_form_key)
     {
       bool surface_form = (dynamic_cast<MatrixFormVol<Scalar>*>(form) == nullptr);
 
@@ -550,18 +567,60 @@ namespace Hermes
       bool tra = (form->i != form->j) && (form->sym != 0);
       bool sym = (form->i == form->j) && (form->sym == 1);
 
+      // Integrals of constant forms are stored without the coefficients of the assembly lists.
+      bool constant_form = form->constant && constant_form_key >= 0;
+      Scalar* cached_values = nullptr;
+      if (constant_form)
+        cached_values = this->get_constant_form_integrals(form, order, current_als_i, current_als_j, constant_form_key, surface_form);
+
       Func<Scalar>** ext_local = this->ext_funcs;
-      // If the user supplied custom ext functions for this form.
-      if (form->ext.size() > 0 || form->u_ext_fn.size() > 0)
+      Func<Scalar>** u_ext_local = this->u_ext_funcs;
+      if (!cached_values)
       {
-        this->init_ext_values(this->ext_funcs_local, form->ext, (form->u_ext_fn.size() > 0 ? form->u_ext_fn : this->wf->u_ext_fn), order, this->u_ext_funcs, geometry);
-        ext_local = this->ext_funcs_local;
+        // If the user supplied custom ext functions for this form.
+        if (form->ext.size() > 0 || form->u_ext_fn.size() > 0)
+        {
+          this->init_ext_values(this->ext_funcs_local, form->ext, (form->u_ext_fn.size() > 0 ? form->u_ext_fn : this->wf->u_ext_fn), order, this->u_ext_funcs, geometry);
+          ext_local = this->ext_funcs_local;
+        }
+
+        // Account for the previous time level solution previously inserted at the back of ext.
+        if (this->rungeKutta)
+          u_ext_local += form->u_ext_offset;
       }
 
-      // Account for the previous time level solution previously inserted at the back of ext.
-      Func<Scalar>** u_ext_local = this->u_ext_funcs;
-      if (this->rungeKutta)
-        u_ext_local += form->u_ext_offset;
+      // Nothing stored yet: integrate all pairs, regardless of the current DOFs and coefficients (they differ between
+      // assemblings, and between congruent elements).
+      if (!cached_values && constant_form)
+      {
+        cached_values = this->insert_constant_form_integrals(current_als_i, current_als_j, constant_form_key);
+        if (cached_values)
+        {
+          if (this->measure_constant_form_time)
+            this->constantFormTimer.tick(Hermes::Mixins::TimeMeasurable::HERMES_SKIP);
+
+          if (surface_form || !this->calculate_reference_integrals(form, order, current_als_i, current_als_j, cached_values))
+          {
+            for (unsigned int i = 0; i < current_als_i->cnt; i++)
+            {
+              for (unsigned int j = (sym ? i : 0); j < current_als_j->cnt; j++)
+              {
+                cached_values[i * current_als_j->cnt + j] = form->value(n_quadrature_points, jacobian_x_weights, u_ext_local, base_fns[j], test_fns[i], geometry, ext_local);
+                if (sym)
+                  cached_values[j * current_als_j->cnt + i] = cached_values[i * current_als_j->cnt + j];
+              }
+            }
+          }
+          this->constant_form_blocks_integrated++;
+
+          if (this->measure_constant_form_time)
+            this->constantFormTimer.tick();
+        }
+      }
+
+      // Forms with constant coefficients on affine elements, not stored.
+      if (!cached_values && !surface_form && this->calculate_reference_integrals(form, order, current_als_i, current_als_j, this->reference_integral_values))
+        cached_values = this->reference_integral_values;
 
       // Actual form-specific calculation.
       for (unsigned int i = 0; i < current_als_i->cnt; i++)
@@ -588,7 +647,8 @@ namespace Hermes
           Func<double>* u = base_fns[j];
           Func<double>* v = test_fns[i];
 
-          Scalar val = block_scaling_coefficient * form->value(n_quadrature_points, jacobian_x_weights, u_ext_local, u, v, geometry, ext_local) * form->scaling_factor * current_als_j->coef[j] * current_als_i->coef[i];
+          Scalar integral = cached_values ? cached_values[i * current_als_j->cnt + j] : form->value(n_quadrature_points, jacobian_x_weights, u_ext_local, u, v, geometry, ext_local);
+          Scalar val = block_scaling_coefficient * integral * form->scaling_factor * current_als_j->coef[j] * current_als_i->coef[i];
 
           if (current_als_j->dof[j] >= 0)
           {
@@ -646,6 +706,147 @@ namespace Hermes
       }
     }
 
+    template<typename Scalar>
+    Scalar* DiscreteProblemThreadAssembler<Scalar>::get_constant_form_integrals(MatrixForm<Scalar>* form, int order, AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, int constant_form_key, bool surface_form)
+    {
+      this->congruent_element_key_set = false;
+
+      if (this->constantFormCache)
+      {
+        Scalar* values = this->constantFormCache->get(this->current_state_index, constant_form_key);
+        if (values)
+        {
+          this->constant_form_blocks_reused++;
+          return values;
+        }
+      }
+
+      if (this->congruentElementCache && !surface_form && this->rep_refmap->is_jacobian_const())
+      {
+        this->congruentElementCache->set_key(constant_form_key, order, this->rep_refmap, this->pss[form->i]->get_transform(), this->pss[form->j]->get_transform(), current_als_i, current_als_j);
+        this->congruent_element_key_set = true;
+        return this->congruentElementCache->get();
+      }
+
+      return nullptr;
+    }
+
+    template<typename Scalar>
+    Scalar* DiscreteProblemThreadAssembler<Scalar>::insert_constant_form_integrals(AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, int constant_form_key)
+    {
+      if (this->congruent_element_key_set)
+        return this->congruentElementCache->insert(current_als_i->cnt * current_als_j->cnt);
+      if (this->constantFormCache)
+        return this->constantFormCache->insert(this->current_state_index, constant_form_key, current_als_i->cnt * current_als_j->cnt);
+      return nullptr;
+    }
+
+    template<typename Scalar>
+    bool DiscreteProblemThreadAssembler<Scalar>::calculate_reference_integrals(MatrixForm<Scalar>* form, int quadrature_order, AsmList<Scalar>* current_als_i, AsmList<Scalar>* current_als_j, Scalar* target)
+    {
+      if (!this->use_reference_integrals)
+        return false;
+
+      // Affine elements, not sub-elements (multi-mesh).
+      RefMap* refmap = this->refmaps[form->i];
+      if (!refmap->is_jacobian_const() || !this->refmaps[form->j]->is_jacobian_const() || this->pss[form->i]->get_transform() != 0 || this->pss[form->j]->get_transform() != 0)
+        return false;
+
+      Shapeset* shapeset = this->pss[form->i]->get_shapeset();
+      if (shapeset->get_id() != this->pss[form->j]->get_shapeset()->get_id())
+        return false;
+
+      Scalar mass, diffusion[2][2], advection[2];
+      if (!static_cast<MatrixFormVol<Scalar>*>(form)->get_reference_coefficients(mass, diffusion, advection))
+        return false;
+
+      // The table of the highest order of the shape functions, constrained functions are not in the tables.
+      ElementMode2D mode = refmap->get_active_element()->get_mode();
+      int order = 0;
+      AsmList<Scalar>* current_als[2] = { current_als_i, current_als_j };
+      for (int als_i = 0; als_i < 2; als_i++)
+      {
+        for (unsigned int i = 0; i < current_als[als_i]->cnt; i++)
+        {
+          int index = current_als[als_i]->idx[i];
+          if (index < 0)
+            return false;
+          int index_order = shapeset->get_order(index, mode);
+          if (mode == HERMES_MODE_QUAD)
+            index_order = std::max(H2D_GET_H_ORDER(index_order), H2D_GET_V_ORDER(index_order));
+          order = std::max(order, index_order);
+        }
+      }
+
+      // The polynomial degree of the integrand in the variable with the highest one: on triangles the total degree of the products
+      // of the values (mass), of a gradient and a value (advection), of the gradients (diffusion); on quads the products are
+      // of the degree 2 * order in at least one of the variables. The quadrature of a lower order is not exact.
+      int degree = 2 * order;
+      if (mode == HERMES_MODE_TRIANGLE && mass == 0.)
+        degree -= (advection[0] != 0. || advection[1] != 0.) ? 1 : 2;
+      if (quadrature_order < degree)
+        return false;
+
+      if (shapeset->get_id() != this->reference_integrals_shapeset_id)
+      {
+        memset(this->reference_integral_tables_looked_up, 0, sizeof(this->reference_integral_tables_looked_up));
+        this->reference_integrals_shapeset_id = shapeset->get_id();
+      }
+      if (!this->reference_integral_tables_looked_up[mode][order])
+      {
+        this->reference_integral_tables[mode][order] = ReferenceIntegralTable::get(shapeset, mode, order);
+        this->reference_integral_tables_looked_up[mode][order] = true;
+      }
+      const ReferenceIntegralTable* table = this->reference_integral_tables[mode][order];
+      if (!table)
+        return false;
+
+      // Coefficients of the reference integrals: with the inverse reference map m (d/dx_k = m[k][a] d/dxi_a),
+      // (K grad u) . grad v = m[k][a] K[k][l] m[l][b] du/dxi_b dv/dxi_a, (c . grad u) = c[l] m[l][b] du/dxi_b.
+      double2x2& m = *refmap->get_const_inv_ref_map();
+      double jacobian = refmap->get_const_jacobian();
+      Scalar coefficients[ReferenceIntegralTable::NumIntegralTypes];
+      coefficients[ReferenceIntegralTable::Mass] = mass * jacobian;
+      for (int a = 0; a < 2; a++)
+      {
+        for (int b = 0; b < 2; b++)
+        {
+          Scalar c = 0.;
+          for (int k = 0; k < 2; k++)
+          for (int l = 0; l < 2; l++)
+            c += m[k][a] * diffusion[k][l] * m[l][b];
+          coefficients[ReferenceIntegralTable::Stiffness + 2 * a + b] = c * jacobian;
+        }
+      }
+      for (int b = 0; b < 2; b++)
+        coefficients[ReferenceIntegralTable::Advection + b] = (advection[0] * m[0][b] + advection[1] * m[1][b]) * jacobian;
+
+      // Only the present terms.
+      int num_types = 0;
+      int types[ReferenceIntegralTable::NumIntegralTypes];
+      for (int type = 0; type < ReferenceIntegralTable::NumIntegralTypes; type++)
+      {
+        if (coefficients[type] != 0.)
+          types[num_types++] = type;
+      }
+
+      int count = table->get_count();
+      for (unsigned int i = 0; i < current_als_i->cnt; i++)
+      {
+        int row_offset = table->get_position(current_als_i->idx[i]) * count;
+        for (unsigned int j = 0; j < current_als_j->cnt; j++)
+        {
+          int position = row_offset + table->get_position(current_als_j->idx[j]);
+          Scalar integral = 0.;
+          for (int type_i = 0; type_i < num_types; type_i++)
+            integral += coefficients[types[type_i]] * table->get_values(types[type_i])[position];
+          target[i * current_als_j->cnt + j] = integral;
+        }
+      }
+
+      return true;
+    }
+
     template<typename Scalar>
     void DiscreteProblemThreadAssembler<Scalar>::assemble_vector_form(VectorForm<Scalar>* form, int order, Func<double>** test_fns,
       AsmList<Scalar>* current_als_i, int n_quadrature_points, Geom<double>* geometry, double* jacobian_x_weights)
@@ -708,11 +909,21 @@ namespace Hermes
 
       free_with_check(ext_funcs, true);
       free_with_check(ext_funcs_local, true);
+
+      if (this->congruentElementCache)
+      {
+        delete this->congruentElementCache;
+        this->congruentElementCache = nullptr;
+      }
     }
 
     template<typename Scalar>
     void DiscreteProblemThreadAssembler<Scalar>::free_spaces()
     {
+      // The shape functions may change.
+      if (this->congruentElementCache)
+        this->congruentElementCache->free();
+
       if (!this->pss)
         return;
 
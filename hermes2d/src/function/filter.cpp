@@ -33,7 +33,7 @@ namespace Hermes
     {
       this->num = num;
       if (num > H2D_MAX_COMPONENTS)
-        throw Hermes::Exceptions::Exception("Attempt to create an instance of Filter with more than 10 MeshFunctions.");
+        throw Hermes::Exceptions::Exception("Attempt to create an instance of Filter with more than %d MeshFunctions.", H2D_MAX_COMPONENTS);
       for (int i = 0; i < this->num; i++)
         this->sln[i] = solutions[i];
       this->init();
@@ -44,7 +44,7 @@ namespace Hermes
     {
       this->num = solutions.size();
       if (num > H2D_MAX_COMPONENTS)
-        throw Hermes::Exceptions::Exception("Attempt to create an instance of Filter with more than 10 MeshFunctions.");
+        throw Hermes::Exceptions::Exception("Attempt to create an instance of Filter with more than %d MeshFunctions.", H2D_MAX_COMPONENTS);
       for (int i = 0; i < this->num; i++)
         this->sln[i] = solutions.at(i);
       this->init();
@@ -55,7 +55,7 @@ namespace Hermes
     {
       this->num = solutions.size();
       if (num > H2D_MAX_COMPONENTS)
-        throw Hermes::Exceptions::Exception("Attempt to create an instance of Filter with more than 10 MeshFunctions.");
+        throw Hermes::Exceptions::Exception("Attempt to create an instance of Filter with more than %d MeshFunctions.", H2D_MAX_COMPONENTS);
       for (int i = 0; i < this->num; i++)
         this->sln[i] = solutions.at(i);
       this->init();
@@ -209,7 +209,7 @@ namespace Hermes
     {
       this->num = solutions.size();
       if (this->num > H2D_MAX_COMPONENTS)
-        throw Hermes::Exceptions::Exception("Attempt to create an instance of Filter with more than 10 MeshFunctions.");
+        throw Hermes::Exceptions::Exception("Attempt to create an instance of Filter with more than %d MeshFunctions.", H2D_MAX_COMPONENTS);
       if (items.size() != (unsigned) this->num)
       if (items.size() > 0)
         throw Hermes::Exceptions::Exception("Attempt to create an instance of SimpleFilter with different supplied number of MeshFunctions than the number of types of data used from them.");
@@ -262,50 +262,111 @@ namespace Hermes
       for (int i = 0; i < this->num; i++)
         this->sln[i]->set_quad_order(order, item[i]);
 
+      if (filter_values.size() != (unsigned) this->num)
+        filter_values.resize(this->num);
+
       for (int j = 0; j < this->num_components; j++)
       {
         // obtain corresponding tables
-        Scalar* tab[H2D_MAX_COMPONENTS];
         for (int i = 0; i < this->num; i++)
         {
           int a = 0, b = 0, mask = item[i];
           if (mask >= 0x40) { a = 1; mask >>= 6; }
           while (!(mask & 1)) { mask >>= 1; b++; }
-          tab[i] = const_cast<Scalar*>(this->sln[i]->get_values(this->num_components == 1 ? a : j, b));
-          if (tab[i] == nullptr)
+          filter_values[i] = const_cast<Scalar*>(this->sln[i]->get_values(this->num_components == 1 ? a : j, b));
+          if (filter_values[i] == nullptr)
             throw Hermes::Exceptions::Exception("Value of 'item%d' is incorrect in filter definition.", i + 1);
         }
 
-        Hermes::vector<Scalar*> values;
-        for (int i = 0; i < this->num; i++)
-          values.push_back(tab[i]);
-
         // apply the filter
-        filter_fn(np, values, this->values[j][0]);
+        filter_fn(np, filter_values, this->values[j][0]);
       }
+
+      Function<Scalar>::precalculate(order, mask);
     }
 
     template<typename Scalar>
     Func<Scalar>* SimpleFilter<Scalar>::get_pt_value(double x, double y, bool use_MeshHashGrid, Element* e)
     {
+      if (filter_values.size() != (unsigned) this->num)
+        filter_values.resize(this->num);
+
       Scalar val[H2D_MAX_COMPONENTS];
       for (int i = 0; i < this->num; i++)
-        val[i] = this->sln[i]->get_pt_value(x, y, use_MeshHashGrid, e)->val[0];
+      {
+        Func<Scalar>* sln_value = this->sln[i]->get_pt_value(x, y, use_MeshHashGrid, e);
+        if (sln_value == nullptr)
+          return nullptr;
+        val[i] = sln_value->val[0];
+        delete sln_value;
+        filter_values[i] = &val[i];
+      }
 
       Func<Scalar>* toReturn = new Func<Scalar>(1, 1);
 
       Scalar result;
-      Hermes::vector<Scalar*> values;
-      for (int i = 0; i < this->num; i++)
-        values.push_back(&val[i]);
 
       // apply the filter
-      filter_fn(1, values, &result);
+      filter_fn(1, filter_values, &result);
 
       toReturn->val[0] = result;
       return toReturn;
     }
 
+    template<typename Scalar>
+    int SimpleFilter<Scalar>::get_pt_values(int count, const double* x, const double* y, Scalar* values, Scalar* dx, Scalar* dy, bool use_MeshHashGrid)
+    {
+      if (dx || dy)
+        throw Hermes::Exceptions::Exception("SimpleFilter not defined for derivatives.");
+
+      // evaluate all solutions
+      Scalar* sln_values[H2D_MAX_COMPONENTS];
+      Scalar* sln_derivatives[H2D_MAX_COMPONENTS];
+      int a[H2D_MAX_COMPONENTS], b[H2D_MAX_COMPONENTS];
+      int points_outside = 0;
+      for (int i = 0; i < this->num; i++)
+      {
+        int mask = item[i];
+        a[i] = 0;
+        b[i] = 0;
+        if (mask >= 0x40) { a[i] = 1; mask >>= 6; }
+        while (!(mask & 1)) { mask >>= 1; b[i]++; }
+        if (b[i] > 2)
+          throw Hermes::Exceptions::Exception("Value of 'item%d' is incorrect in filter definition.", i + 1);
+
+        sln_values[i] = malloc_with_check<Scalar>(count * this->sln[i]->get_num_components());
+        sln_derivatives[i] = b[i] > 0 ? malloc_with_check<Scalar>(count) : nullptr;
+        int sln_points_outside = this->sln[i]->get_pt_values(count, x, y, sln_values[i], b[i] == 1 ? sln_derivatives[i] : nullptr, b[i] == 2 ? sln_derivatives[i] : nullptr, use_MeshHashGrid);
+        points_outside = std::max(points_outside, sln_points_outside);
+      }
+
+      if (filter_values.size() != (unsigned) this->num)
+        filter_values.resize(this->num);
+
+      for (int j = 0; j < this->num_components; j++)
+      {
+        for (int i = 0; i < this->num; i++)
+          filter_values[i] = b[i] > 0 ? sln_derivatives[i] : sln_values[i] + (this->num_components == 1 ? a[i] : j) * count;
+
+        // apply the filter
+        filter_fn(count, filter_values, values + j * count);
+      }
+
+      for (int i = 0; i < this->num; i++)
+      {
+        free_with_check(sln_values[i]);
+        free_with_check(sln_derivatives[i]);
+      }
+
+      return points_outside;
+    }
+
+    template<typename Scalar>
+    int SimpleFilter<Scalar>::fuse(FusedFilter<Scalar>* fused, const int* inputs) const
+    {
+      return -1;
+    }
+
     ComplexFilter::ComplexFilter() : Filter<double>()
     {
       this->num = 0;
@@ -378,6 +439,8 @@ namespace Hermes
       filter_fn(np, const_cast<std::complex<double>*>(this->sln_complex->get_values(0, 0)), this->values[0][0]);
       if (num_components > 1)
         filter_fn(np, const_cast<std::complex<double>*>(this->sln_complex->get_values(1, 0)), this->values[1][0]);
+
+      Function<double>::precalculate(order, mask);
     }
 
     Func<double>* ComplexFilter::get_pt_value(double x, double y, bool use_MeshHashGrid, Element* e)
@@ -446,46 +509,109 @@ namespace Hermes
       for (int i = 0; i < this->num; i++)
         this->sln[i]->set_quad_order(order, H2D_FN_DEFAULT);
 
+      if (values_vector.size() != (unsigned) this->num)
+      {
+        values_vector.resize(this->num);
+        dx_vector.resize(this->num);
+        dy_vector.resize(this->num);
+      }
+
       for (int j = 0; j < this->num_components; j++)
       {
         // obtain solution tables
         double *x, *y;
-        const Scalar *val[H2D_MAX_COMPONENTS], *dx[H2D_MAX_COMPONENTS], *dy[H2D_MAX_COMPONENTS];
         x = this->sln[0]->get_refmap()->get_phys_x(order);
         y = this->sln[0]->get_refmap()->get_phys_y(order);
 
         for (int i = 0; i < this->num; i++)
         {
-          val[i] = this->sln[i]->get_fn_values(j);
-          dx[i] = this->sln[i]->get_dx_values(j);
-          dy[i] = this->sln[i]->get_dy_values(j);
-        }
-
-        Hermes::vector<const Scalar *> values_vector;
-        Hermes::vector<const Scalar *> dx_vector;
-        Hermes::vector<const Scalar *> dy_vector;
-
-        for (int i = 0; i < this->num; i++)
-        {
-          values_vector.push_back(val[i]);
-          dx_vector.push_back(dx[i]);
-          dy_vector.push_back(dy[i]);
+          values_vector[i] = this->sln[i]->get_fn_values(j);
+          dx_vector[i] = this->sln[i]->get_dx_values(j);
+          dy_vector[i] = this->sln[i]->get_dy_values(j);
         }
 
         // apply the filter
         filter_fn(np, x, y, values_vector, dx_vector, dy_vector, this->values[j][0], this->values[j][1], this->values[j][2]);
       }
+
+      Function<Scalar>::precalculate(order, mask);
+    }
+
+    template<typename Scalar>
+    int DXDYFilter<Scalar>::get_pt_values(int count, const double* x, const double* y, Scalar* values, Scalar* dx, Scalar* dy, bool use_MeshHashGrid)
+    {
+      if (this->num_components > 1)
+        throw Hermes::Exceptions::Exception("Derivatives of vector functions not implemented yet.");
+
+      if (values_vector.size() != (unsigned) this->num)
+      {
+        values_vector.resize(this->num);
+        dx_vector.resize(this->num);
+        dy_vector.resize(this->num);
+      }
+
+      // evaluate all solutions including derivatives
+      Scalar* buffer = malloc_with_check<Scalar>(3 * this->num * count + 2 * count);
+      int points_outside = 0;
+      for (int i = 0; i < this->num; i++)
+      {
+        Scalar* sln_values = buffer + 3 * i * count;
+        int sln_points_outside = this->sln[i]->get_pt_values(count, x, y, sln_values, sln_values + count, sln_values + 2 * count, use_MeshHashGrid);
+        points_outside = std::max(points_outside, sln_points_outside);
+        values_vector[i] = sln_values;
+        dx_vector[i] = sln_values + count;
+        dy_vector[i] = sln_values + 2 * count;
+      }
+
+      // the derivatives of the result are always calculated by filter_fn
+      Scalar* rslt_dx = dx ? dx : buffer + 3 * this->num * count;
+      Scalar* rslt_dy = dy ? dy : buffer + (3 * this->num + 1) * count;
+
+      // apply the filter
+      filter_fn(count, const_cast<double*>(x), const_cast<double*>(y), values_vector, dx_vector, dy_vector, values, rslt_dx, rslt_dy);
+
+      free_with_check(buffer);
+      return points_outside;
     }
 
     template<typename Scalar>
     Func<Scalar>* DXDYFilter<Scalar>::get_pt_value(double x, double y, bool use_MeshHashGrid, Element* e)
     {
-      this->warn("DXDYFilter<Scalar>::get_pt_value not implemented.");
-      return 0;
+      if (this->num_components > 1)
+        throw Hermes::Exceptions::Exception("Derivatives of vector functions not implemented yet.");
+
+      if (values_vector.size() != (unsigned) this->num)
+      {
+        values_vector.resize(this->num);
+        dx_vector.resize(this->num);
+        dy_vector.resize(this->num);
+      }
+
+      Scalar val[H2D_MAX_COMPONENTS], dx[H2D_MAX_COMPONENTS], dy[H2D_MAX_COMPONENTS];
+      for (int i = 0; i < this->num; i++)
+      {
+        Func<Scalar>* sln_value = this->sln[i]->get_pt_value(x, y, use_MeshHashGrid, e);
+        if (sln_value == nullptr)
+          return nullptr;
+        val[i] = sln_value->val[0];
+        dx[i] = sln_value->dx[0];
+        dy[i] = sln_value->dy[0];
+        delete sln_value;
+        values_vector[i] = &val[i];
+        dx_vector[i] = &dx[i];
+        dy_vector[i] = &dy[i];
+      }
+
+      Func<Scalar>* toReturn = new Func<Scalar>(1, 1);
+
+      // apply the filter
+      filter_fn(1, &x, &y, values_vector, dx_vector, dy_vector, toReturn->val, toReturn->dx, toReturn->dy);
+
+      return toReturn;
     }
 
     template<typename Scalar>
-    void MagFilter<Scalar>::filter_fn(int n, Hermes::vector<Scalar*> values, Scalar* result)
+    void MagFilter<Scalar>::filter_fn(int n, const Hermes::vector<Scalar*>& values, Scalar* result)
     {
       for (int i = 0; i < n; i++)
 
@@ -497,6 +623,15 @@ namespace Hermes
       }
     };
 
+    template<typename Scalar>
+    int MagFilter<Scalar>::fuse(FusedFilter<Scalar>* fused, const int* inputs) const
+    {
+      int node = fused->add_operation(HERMES_FILTER_SQR, inputs[0]);
+      for (int i = 1; i < this->num; i++)
+        node = fused->add_operation(HERMES_FILTER_ADD, node, fused->add_operation(HERMES_FILTER_SQR, inputs[i]));
+      return fused->add_operation(HERMES_FILTER_SQRT, node);
+    }
+
     template<typename Scalar>
     MagFilter<Scalar>::MagFilter(Hermes::vector<MeshFunctionSharedPtr<Scalar> > solutions, Hermes::vector<int> items) : SimpleFilter<Scalar>(solutions, items)
     {
@@ -530,7 +665,7 @@ namespace Hermes
       return filter;
     }
 
-    void TopValFilter::filter_fn(int n, Hermes::vector<double*> values, double* result)
+    void TopValFilter::filter_fn(int n, const Hermes::vector<double*>& values, double* result)
     {
       for (int i = 0; i < n; i++)
       {
@@ -574,7 +709,7 @@ namespace Hermes
       return filter;
     }
 
-    void BottomValFilter::filter_fn(int n, Hermes::vector<double*> values, double* result)
+    void BottomValFilter::filter_fn(int n, const Hermes::vector<double*>& values, double* result)
     {
       for (int i = 0; i < n; i++)
       {
@@ -618,7 +753,7 @@ namespace Hermes
       return filter;
     }
 
-    void ValFilter::filter_fn(int n, Hermes::vector<double*> values, double* result)
+    void ValFilter::filter_fn(int n, const Hermes::vector<double*>& values, double* result)
     {
       for (int i = 0; i < n; i++)
       {
@@ -667,11 +802,17 @@ namespace Hermes
     }
 
     template<typename Scalar>
-    void DiffFilter<Scalar>::filter_fn(int n, Hermes::vector<Scalar*> values, Scalar* result)
+    void DiffFilter<Scalar>::filter_fn(int n, const Hermes::vector<Scalar*>& values, Scalar* result)
     {
       for (int i = 0; i < n; i++) result[i] = values.at(0)[i] - values.at(1)[i];
     };
 
+    template<typename Scalar>
+    int DiffFilter<Scalar>::fuse(FusedFilter<Scalar>* fused, const int* inputs) const
+    {
+      return fused->add_operation(HERMES_FILTER_SUB, inputs[0], inputs[1]);
+    }
+
     template<typename Scalar>
     DiffFilter<Scalar>::DiffFilter(Hermes::vector<MeshFunctionSharedPtr<Scalar> > solutions, Hermes::vector<int> items) : SimpleFilter<Scalar>(solutions, items) {}
 
@@ -695,7 +836,7 @@ namespace Hermes
     }
 
     template<typename Scalar>
-    void SumFilter<Scalar>::filter_fn(int n, Hermes::vector<Scalar*> values, Scalar* result)
+    void SumFilter<Scalar>::filter_fn(int n, const Hermes::vector<Scalar*>& values, Scalar* result)
     {
       for (int i = 0; i < n; i++)
       {
@@ -705,6 +846,15 @@ namespace Hermes
       }
     };
 
+    template<typename Scalar>
+    int SumFilter<Scalar>::fuse(FusedFilter<Scalar>* fused, const int* inputs) const
+    {
+      int node = inputs[0];
+      for (int i = 1; i < this->num; i++)
+        node = fused->add_operation(HERMES_FILTER_ADD, node, inputs[i]);
+      return node;
+    }
+
     template<typename Scalar>
     SumFilter<Scalar>::SumFilter(Hermes::vector<MeshFunctionSharedPtr<Scalar> > solutions, Hermes::vector<int> items) : SimpleFilter<Scalar>(solutions, items) {}
 
@@ -728,19 +878,25 @@ namespace Hermes
     }
 
     template<>
-    void SquareFilter<double>::filter_fn(int n, Hermes::vector<double *> v1, double* result)
+    void SquareFilter<double>::filter_fn(int n, const Hermes::vector<double *>& v1, double* result)
     {
       for (int i = 0; i < n; i++)
         result[i] = sqr(v1.at(0)[i]);
     };
 
     template<>
-    void SquareFilter<std::complex<double> >::filter_fn(int n, Hermes::vector<std::complex<double> *> v1, std::complex<double> * result)
+    void SquareFilter<std::complex<double> >::filter_fn(int n, const Hermes::vector<std::complex<double> *>& v1, std::complex<double> * result)
     {
       for (int i = 0; i < n; i++)
         result[i] = std::norm(v1.at(0)[i]);
     };
 
+    template<typename Scalar>
+    int SquareFilter<Scalar>::fuse(FusedFilter<Scalar>* fused, const int* inputs) const
+    {
+      return fused->add_operation(HERMES_FILTER_NORM, inputs[0]);
+    }
+
     template<typename Scalar>
     SquareFilter<Scalar>::SquareFilter(Hermes::vector<MeshFunctionSharedPtr<Scalar> > solutions, Hermes::vector<int> items)
       : SimpleFilter<Scalar>(solutions, items)
@@ -768,12 +924,17 @@ namespace Hermes
       return filter;
     }
 
-    void AbsFilter::filter_fn(int n, Hermes::vector<double*> v1, double * result)
+    void AbsFilter::filter_fn(int n, const Hermes::vector<double*>& v1, double * result)
     {
       for (int i = 0; i < n; i++)
         result[i] = std::abs(v1.at(0)[i]);
     };
 
+    int AbsFilter::fuse(FusedFilter<double>* fused, const int* inputs) const
+    {
+      return fused->add_operation(HERMES_FILTER_ABS, inputs[0]);
+    }
+
     AbsFilter::AbsFilter(Hermes::vector<MeshFunctionSharedPtr<double> > solutions, Hermes::vector<int> items)
       : SimpleFilter<double>(solutions, items)
     {
@@ -878,7 +1039,7 @@ namespace Hermes
     {
     }
 
-    void AngleFilter::filter_fn(int n, Hermes::vector<std::complex<double>*> v1, double* result)
+    void AngleFilter::filter_fn(int n, const Hermes::vector<std::complex<double>*>& v1, double* result)
     {
       for (int i = 0; i < n; i++)
         result[i] = atan2(v1.at(0)[i].imag(), v1.at(0)[i].real());
@@ -930,6 +1091,8 @@ namespace Hermes
         // Von Mises stress
         this->values[0][0][i] = 1.0 / sqrt(2.0) * sqrt(sqr(tx - ty) + sqr(ty - tz) + sqr(tz - tx) + 6 * sqr(txy));
       }
+
+      Function<double>::precalculate(order, mask);
     }
 
     Func<double>* VonMisesFilter::get_pt_value(double x, double y, bool use_MeshHashGrid, Element* e)
@@ -1016,6 +1179,8 @@ namespace Hermes
       }
       this->nodes->add(node, order);
       this->cur_node = node;
+
+      Function<Scalar>::precalculate(order, mask);
     }
 
     template<typename Scalar>
@@ -1066,6 +1231,314 @@ namespace Hermes
       }
     }
 
+    template<typename Scalar>
+    FusedFilter<Scalar>::FusedFilter(Hermes::vector<MeshFunctionSharedPtr<Scalar> > solutions) : Filter<Scalar>(solutions), root(-1), buffers(nullptr), node_values(nullptr)
+    {
+      memset(input_mask, 0, sizeof(input_mask));
+    }
+
+    template<typename Scalar>
+    FusedFilter<Scalar>::FusedFilter(MeshFunctionSharedPtr<Scalar> expression) : Filter<Scalar>(), root(-1), buffers(nullptr), node_values(nullptr)
+    {
+      this->num = 0;
+      this->unimesh = false;
+      memset(input_mask, 0, sizeof(input_mask));
+
+      int node = add_function(expression, H2D_FN_VAL_0);
+      Filter<Scalar>::init();
+      set_expression(node);
+    }
+
+    template<typename Scalar>
+    FusedFilter<Scalar>::~FusedFilter()
+    {
+      free_with_check(buffers);
+      free_with_check(node_values);
+    }
+
+    template<typename Scalar>
+    int FusedFilter<Scalar>::add_function(MeshFunctionSharedPtr<Scalar> function, int item)
+    {
+      if (function->get_num_components() == 1)
+        item &= H2D_FN_COMPONENT_0;
+
+      SimpleFilter<Scalar>* filter = dynamic_cast<SimpleFilter<Scalar>*>(function.get());
+      if (filter != nullptr && filter->get_num_components() == 1 && item == H2D_FN_VAL_0)
+      {
+        // State to return to if the filter can not be fused.
+        unsigned int num_nodes = nodes.size();
+        int num_functions = this->num;
+        int mask[H2D_MAX_COMPONENTS];
+        memcpy(mask, input_mask, sizeof(mask));
+
+        int inputs[H2D_MAX_COMPONENTS];
+        for (int i = 0; i < filter->num; i++)
+          inputs[i] = add_function(filter->sln[i], filter->item[i]);
+
+        int node = filter->fuse(this, inputs);
+        if (node >= 0)
+          return node;
+
+        nodes.resize(num_nodes);
+        for (int i = num_functions; i < this->num; i++)
+          this->sln[i] = MeshFunctionSharedPtr<Scalar>();
+        this->num = num_functions;
+        memcpy(input_mask, mask, sizeof(mask));
+      }
+
+      // The function is an input, each one is precalculated only once.
+      int function_index = -1;
+      for (int i = 0; i < this->num; i++)
+      if (this->sln[i].get() == function.get())
+        function_index = i;
+
+      if (function_index == -1)
+      {
+        if (this->num == H2D_MAX_COMPONENTS)
+          throw Hermes::Exceptions::Exception("Attempt to create an instance of FusedFilter with more than %d MeshFunctions.", H2D_MAX_COMPONENTS);
+        this->sln[this->num] = function;
+        function_index = this->num++;
+      }
+
+      return add_input(function_index, item);
+    }
+
+    template<typename Scalar>
+    int FusedFilter<Scalar>::add_input(int function_index, int item)
+    {
+      if (function_index < 0 || function_index >= this->num)
+        throw Hermes::Exceptions::ValueException("function_index", function_index, this->num);
+      if ((item & H2D_FN_COMPONENT_0) && (item & H2D_FN_COMPONENT_1))
+        throw Hermes::Exceptions::Exception("The item of a FusedFilter input has to select one component.");
+
+      Node node;
+      node.operation = HERMES_FILTER_INPUT;
+      node.a = function_index;
+      node.b = 0;
+      node.component = 0;
+      node.value = 0.;
+
+      int mask = item;
+      if (mask >= 0x40) { node.component = 1; mask >>= 6; }
+      if (mask == 0 || (mask & (mask - 1)))
+        throw Hermes::Exceptions::Exception("The item of a FusedFilter input has to select one value.");
+      while (!(mask & 1)) { mask >>= 1; node.b++; }
+
+      input_mask[function_index] |= item;
+      nodes.push_back(node);
+      return nodes.size() - 1;
+    }
+
+    template<typename Scalar>
+    int FusedFilter<Scalar>::add_constant(Scalar value)
+    {
+      Node node;
+      node.operation = HERMES_FILTER_CONSTANT;
+      node.a = node.b = -1;
+      node.component = 0;
+      node.value = value;
+
+      nodes.push_back(node);
+      return nodes.size() - 1;
+    }
+
+    template<typename Scalar>
+    int FusedFilter<Scalar>::add_operation(FusedFilterOperation operation, int a, int b)
+    {
+      if (operation == HERMES_FILTER_INPUT || operation == HERMES_FILTER_CONSTANT)
+        throw Hermes::Exceptions::Exception("Inputs and constants are added to a FusedFilter by add_input(), add_constant().");
+
+      bool binary = (operation == HERMES_FILTER_ADD || operation == HERMES_FILTER_SUB || operation == HERMES_FILTER_MUL || operation == HERMES_FILTER_DIV);
+      if (a < 0 || a >= (int)nodes.size())
+        throw Hermes::Exceptions::ValueException("a", a, nodes.size());
+      if (binary && (b < 0 || b >= (int)nodes.size()))
+        throw Hermes::Exceptions::ValueException("b", b, nodes.size());
+
+      Node node;
+      node.operation = operation;
+      node.a = a;
+      node.b = binary ? b : -1;
+      node.component = 0;
+      node.value = 0.;
+
+      nodes.push_back(node);
+      return nodes.size() - 1;
+    }
+
+    template<typename Scalar>
+    void FusedFilter<Scalar>::set_expression(int root)
+    {
+      if (root < 0 || root >= (int)nodes.size())
+        throw Hermes::Exceptions::ValueException("root", root, nodes.size());
+      this->root = root;
+
+      // The nodes only depend on the preceding ones, the nodes after the root are not evaluated.
+      free_with_check(buffers);
+      free_with_check(node_values);
+      buffers = malloc_with_check<Scalar>((root + 1) * H2D_MAX_INTEGRATION_POINTS_COUNT);
+      node_values = malloc_with_check<const Scalar*>(root + 1);
+    }
+
+    template<typename Scalar>
+    int FusedFilter<Scalar>::get_num_nodes() const
+    {
+      return nodes.size();
+    }
+
+    static inline double fused_filter_norm(double value)
+    {
+      return value * value;
+    }
+
+    static inline std::complex<double> fused_filter_norm(std::complex<double> value)
+    {
+      return std::norm(value);
+    }
+
+    template<typename Scalar>
+    void FusedFilter<Scalar>::evaluate_operation(const Node& node, int n, Scalar* result) const
+    {
+      const Scalar* a = node.a >= 0 ? node_values[node.a] : nullptr;
+      const Scalar* b = node.b >= 0 ? node_values[node.b] : nullptr;
+
+      switch (node.operation)
+      {
+      case HERMES_FILTER_CONSTANT:
+        for (int i = 0; i < n; i++) result[i] = node.value;
+        break;
+      case HERMES_FILTER_ADD:
+        for (int i = 0; i < n; i++) result[i] = a[i] + b[i];
+        break;
+      case HERMES_FILTER_SUB:
+        for (int i = 0; i < n; i++) result[i] = a[i] - b[i];
+        break;
+      case HERMES_FILTER_MUL:
+        for (int i = 0; i < n; i++) result[i] = a[i] * b[i];
+        break;
+      case HERMES_FILTER_DIV:
+        for (int i = 0; i < n; i++) result[i] = a[i] / b[i];
+        break;
+      case HERMES_FILTER_SQR:
+        for (int i = 0; i < n; i++) result[i] = a[i] * a[i];
+        break;
+      case HERMES_FILTER_NORM:
+        for (int i = 0; i < n; i++) result[i] = fused_filter_norm(a[i]);
+        break;
+      case HERMES_FILTER_SQRT:
+        for (int i = 0; i < n; i++) result[i] = std::sqrt(a[i]);
+        break;
+      case HERMES_FILTER_ABS:
+        for (int i = 0; i < n; i++) result[i] = std::abs(a[i]);
+        break;
+      default:
+        throw Hermes::Exceptions::Exception("Unknown operation in FusedFilter.");
+      }
+    }
+
+    template<typename Scalar>
+    void FusedFilter<Scalar>::precalculate(int order, int mask)
+    {
+#ifdef H2D_USE_SECOND_DERIVATIVES
+      if (mask & (H2D_FN_DX | H2D_FN_DY | H2D_FN_DXX | H2D_FN_DYY | H2D_FN_DXY))
+#else
+      if (mask & (H2D_FN_DX | H2D_FN_DY))
+#endif
+        throw Hermes::Exceptions::Exception("FusedFilter not defined for derivatives.");
+      if (root < 0)
+        throw Hermes::Exceptions::Exception("The expression of FusedFilter has not been set.");
+
+      Quad2D* quad = this->quads[this->cur_quad];
+      int np = quad->get_num_points(order, this->element->get_mode());
+
+      // precalculate all input functions
+      for (int i = 0; i < this->num; i++)
+      if (input_mask[i])
+        this->sln[i]->set_quad_order(order, input_mask[i]);
+
+      for (int k = 0; k <= root; k++)
+      {
+        const Node& node = nodes[k];
+        if (node.operation == HERMES_FILTER_INPUT)
+        {
+          node_values[k] = this->sln[node.a]->get_values(node.component, node.b);
+          if (node_values[k] == nullptr)
+            throw Hermes::Exceptions::Exception("Value of the input node %d is not available in FusedFilter.", k);
+        }
+        else
+        {
+          // The root is evaluated directly to the values of this function.
+          Scalar* result = (k == root) ? this->values[0][0] : buffers + k * H2D_MAX_INTEGRATION_POINTS_COUNT;
+          evaluate_operation(node, np, result);
+          node_values[k] = result;
+        }
+      }
+
+      if (nodes[root].operation == HERMES_FILTER_INPUT)
+        memcpy(this->values[0][0], node_values[root], np * sizeof(Scalar));
+
+      Function<Scalar>::precalculate(order, mask);
+    }
+
+    template<typename Scalar>
+    Func<Scalar>* FusedFilter<Scalar>::get_pt_value(double x, double y, bool use_MeshHashGrid, Element* e)
+    {
+      if (root < 0)
+        throw Hermes::Exceptions::Exception("The expression of FusedFilter has not been set.");
+
+      Func<Scalar>* sln_values[H2D_MAX_COMPONENTS];
+      for (int i = 0; i < this->num; i++)
+        sln_values[i] = input_mask[i] ? this->sln[i]->get_pt_value(x, y, use_MeshHashGrid, e) : nullptr;
+
+      // One value per node.
+      Scalar* point_values = buffers;
+      for (int k = 0; k <= root; k++)
+      {
+        const Node& node = nodes[k];
+        if (node.operation == HERMES_FILTER_INPUT)
+        {
+          Func<Scalar>* value = sln_values[node.a];
+          if (value == nullptr)
+            throw Hermes::Exceptions::Exception("Point (%g, %g) is not in the domain of the input function %d of FusedFilter.", x, y, node.a);
+          if (this->sln[node.a]->get_num_components() > 1)
+          {
+            if (node.b > 0)
+              throw Hermes::Exceptions::Exception("Derivatives of vector functions not available in FusedFilter::get_pt_value().");
+            point_values[k] = node.component ? value->val1[0] : value->val0[0];
+          }
+          else
+          {
+            if (node.b > 2)
+              throw Hermes::Exceptions::Exception("Second derivatives not available in FusedFilter::get_pt_value().");
+            point_values[k] = node.b == 0 ? value->val[0] : (node.b == 1 ? value->dx[0] : value->dy[0]);
+          }
+        }
+        else
+          evaluate_operation(node, 1, point_values + k);
+        node_values[k] = point_values + k;
+      }
+
+      for (int i = 0; i < this->num; i++)
+        delete sln_values[i];
+
+      Func<Scalar>* toReturn = new Func<Scalar>(1, 1);
+      toReturn->val[0] = point_values[root];
+      return toReturn;
+    }
+
+    template<typename Scalar>
+    MeshFunction<Scalar>* FusedFilter<Scalar>::clone() const
+    {
+      Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns;
+      for (int i = 0; i < this->num; i++)
+        slns.push_back(this->sln[i]->clone());
+      FusedFilter<Scalar>* filter = new FusedFilter<Scalar>(slns);
+      filter->nodes = this->nodes;
+      memcpy(filter->input_mask, this->input_mask, sizeof(input_mask));
+      if (this->root >= 0)
+        filter->set_expression(this->root);
+      return filter;
+    }
+
     template class HERMES_API Filter<double>;
     template class HERMES_API Filter<std::complex<double> >;
     template class HERMES_API SimpleFilter<double>;
@@ -1080,5 +1553,7 @@ namespace Hermes
     template class HERMES_API SumFilter<std::complex<double> >;
     template class HERMES_API SquareFilter<double>;
     template class HERMES_API SquareFilter<std::complex<double> >;
+    template class HERMES_API FusedFilter<double>;
+    template class HERMES_API FusedFilter<std::complex<double> >;
   }
 }
@@ -14,6 +14,7 @@
 // along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "solution.h"
+#include "forms.h"
 
 namespace Hermes
 {
@@ -122,6 +123,47 @@ namespace Hermes
       init();
     }
 
+    template<typename Scalar>
+    int MeshFunction<Scalar>::get_pt_values(int count, const double* x, const double* y, Scalar* values, Scalar* dx, Scalar* dy, bool use_MeshHashGrid)
+    {
+      if (this->num_components > 1 && (dx || dy))
+        throw Exceptions::Exception("Derivatives of vector functions not implemented yet.");
+
+      int points_outside = 0;
+      for (int i = 0; i < count; i++)
+      {
+        Func<Scalar>* value = this->get_pt_value(x[i], y[i], use_MeshHashGrid);
+        if (value == nullptr)
+        {
+          for (int component = 0; component < this->num_components; component++)
+            values[component * count + i] = 0.0;
+          if (dx)
+            dx[i] = 0.0;
+          if (dy)
+            dy[i] = 0.0;
+          points_outside++;
+          continue;
+        }
+
+        if (this->num_components == 1)
+        {
+          values[i] = value->val[0];
+          if (dx)
+            dx[i] = value->dx[0];
+          if (dy)
+            dy[i] = value->dy[0];
+        }
+        else
+        {
+          values[i] = value->val0[0];
+          values[count + i] = value->val1[0];
+        }
+        delete value;
+      }
+
+      return points_outside;
+    }
+
     template<typename Scalar>
     void MeshFunction<Scalar>::add(MeshFunctionSharedPtr<Scalar> other_mesh_function, SpaceSharedPtr<Scalar> target_space)
     {
@@ -284,6 +326,8 @@ namespace Hermes
 
       Function<Scalar>::set_active_element(e);
       mode = e->get_mode();
+      if (this->mesh)
+        refmap->set_geometry_cache(this->mesh->get_geometry_cache());
       refmap->set_active_element(e);
     }
 
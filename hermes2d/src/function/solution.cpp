@@ -18,6 +18,7 @@
 #include "solution_h2d_xml.h"
 #include "ogprojection.h"
 #include "api2d.h"
+#include "binary_file.h"
 #include "algebra/dense_matrix_operations.h"
 #include "util/memory_handling.h"
 
@@ -353,6 +354,8 @@ namespace Hermes
         throw Exceptions::Exception("Provided 'space' is not up to date.");
       if (space->shapeset != pss->shapeset)
         throw Exceptions::Exception("Provided 'space' and 'pss' must have the same shapesets.");
+      if (space->stride > 1 && start_index != space->first_dof)
+        throw Exceptions::Exception("The DOFs of the provided 'space' are interleaved with other spaces, 'start_index' must be its first DOF (%d).", space->first_dof);
 
       if (Solution<Scalar>::static_verbose_output)
         Hermes::Mixins::Loggable::Static::info("Solution: set_coeff_vector - solution being freed.");
@@ -380,6 +383,10 @@ namespace Hermes
       // Obtain element orders, allocate mono_coeffs.
       Element* e;
       num_coeffs = 0;
+      int num_active_elements = 0;
+      Element** active_elements = malloc_with_check<Solution<Scalar>, Element*>(this->mesh->get_num_active_elements(), this);
+      bool mono_matrix_used[2][11];
+      memset(mono_matrix_used, 0, sizeof(mono_matrix_used));
       for_all_active_elements(e, this->mesh)
       {
         this->mode = e->get_mode();
@@ -397,54 +404,107 @@ namespace Hermes
         if (o < space->shapeset->get_max_order())
           o++;
 
-        num_coeffs += this->mode ? sqr(o + 1) : (o + 1)*(o + 2) / 2;
+        int np = this->mode ? sqr(o + 1) : (o + 1)*(o + 2) / 2;
+        for (int l = 0; l < this->num_components; l++)
+          elem_coeffs[l][e->id] = num_coeffs + l * np;
+        num_coeffs += np * this->num_components;
         elem_orders[e->id] = o;
+        active_elements[num_active_elements++] = e;
+        mono_matrix_used[this->mode][o] = true;
       }
-      num_coeffs *= this->num_components;
       free_with_check(mono_coeffs);
       mono_coeffs = malloc_with_check<Solution<Scalar>, Scalar>(num_coeffs, this);
 
+      // The LU-decomposed monomial matrices are shared, they are calculated before the parallel part.
+      for (int mode = 0; mode <= 1; mode++)
+      for (int order = 0; order <= 10; order++)
+      if (mono_matrix_used[mode][order])
+      {
+        this->mode = (ElementMode2D)mode;
+        calc_mono_matrix(mode, order);
+      }
+
       // Express the solution on elements as a linear combination of monomials.
+      // The elements are split among the threads, the pages of mono_coeffs are first touched by the threads calculating
+      // the coefficients (see HermesCommonApi numThreads).
       Quad2D* quad = &g_quad_2d_cheb;
       pss->set_quad_2d(quad);
-      Scalar* mono = mono_coeffs;
-      for_all_active_elements(e, this->mesh)
+      int num_threads_used = HermesCommonApi.get_integral_param_value(numThreads);
+      if (num_coeffs < HERMES_FIRST_TOUCH_MIN_SIZE)
+        num_threads_used = 1;
+      std::string exceptionMessageCaughtInParallelBlock;
+#pragma omp parallel num_threads(num_threads_used)
       {
-        this->mode = e->get_mode();
-        o = elem_orders[e->id];
-        int np = quad->get_num_points(o, e->get_mode());
-
-        AsmList<Scalar> al;
-        space->get_element_assembly_list(e, &al);
-        pss->set_active_element(e);
-
-        for (int l = 0; l < this->num_components; l++)
+        int thread_number = omp_get_thread_num();
+        int num_threads = omp_get_num_threads();
+        int start = (num_active_elements / num_threads) * thread_number;
+        int end = (num_active_elements / num_threads) * (thread_number + 1);
+        if (thread_number == num_threads - 1)
+          end = num_active_elements;
+
+        PrecalcShapeset* thread_pss = pss;
+        try
         {
-          // Obtain solution values for the current element.
-          Scalar* val = mono;
-          elem_coeffs[l][e->id] = (int)(mono - mono_coeffs);
-          memset(val, 0, sizeof(Scalar)*np);
-          for (unsigned int k = 0; k < al.cnt; k++)
+          if (thread_number > 0)
           {
-            pss->set_active_shape(al.idx[k]);
-            pss->set_quad_order(o, H2D_FN_VAL);
-            int dof = al.dof[k];
-            double dir_lift_coeff = add_dir_lift ? 1.0 : 0.0;
-            // By subtracting space->first_dof we make sure that it does not matter where the
-            // enumeration of dofs in the space starts. This ca be either zero or there can be some
-            // offset. By adding start_index we move to the desired section of coeff_vec.
-            Scalar coef = al.coef[k] * (dof >= 0 ? coeff_vec[dof - space->first_dof + start_index] : dir_lift_coeff);
-            const double* shape = pss->get_fn_values(l);
-            for (int i = 0; i < np; i++)
-              val[i] += shape[i] * coef;
+            thread_pss = new PrecalcShapeset(pss->shapeset);
+            thread_pss->set_quad_2d(quad);
           }
-          mono += np;
 
-          // solve for the monomial coefficients
-          calc_mono_matrix(this->mode, o);
-          lubksb<double, Scalar>(mono_lu.mat[this->mode][o], np, mono_lu.perm[this->mode][o], val);
+          AsmList<Scalar> al;
+          for (int element_i = start; element_i < end; element_i++)
+          {
+            Element* element = active_elements[element_i];
+            ElementMode2D mode = element->get_mode();
+            int order = elem_orders[element->id];
+            int np = quad->get_num_points(order, mode);
+
+            space->get_element_assembly_list(element, &al);
+            thread_pss->set_active_element(element);
+
+            for (int l = 0; l < this->num_components; l++)
+            {
+              // Obtain solution values for the current element.
+              Scalar* val = mono_coeffs + elem_coeffs[l][element->id];
+              memset(val, 0, sizeof(Scalar)*np);
+              for (unsigned int k = 0; k < al.cnt; k++)
+              {
+                thread_pss->set_active_shape(al.idx[k]);
+                thread_pss->set_quad_order(order, H2D_FN_VAL);
+                int dof = al.dof[k];
+                double dir_lift_coeff = add_dir_lift ? 1.0 : 0.0;
+                // By subtracting space->first_dof we make sure that it does not matter where the
+                // enumeration of dofs in the space starts. This ca be either zero or there can be some
+                // offset. By adding start_index we move to the desired section of coeff_vec.
+                Scalar coef = al.coef[k] * (dof >= 0 ? coeff_vec[dof - space->first_dof + start_index] : dir_lift_coeff);
+                const double* shape = thread_pss->get_fn_values(l);
+                for (int i = 0; i < np; i++)
+                  val[i] += shape[i] * coef;
+              }
+
+              // solve for the monomial coefficients
+              lubksb<double, Scalar>(mono_lu.mat[mode][order], np, mono_lu.perm[mode][order], val);
+            }
+          }
         }
+        catch (Hermes::Exceptions::Exception& exception)
+        {
+#pragma omp critical (exceptionMessageCaughtInParallelBlock)
+          exceptionMessageCaughtInParallelBlock = exception.info();
+        }
+        catch (std::exception& exception)
+        {
+#pragma omp critical (exceptionMessageCaughtInParallelBlock)
+          exceptionMessageCaughtInParallelBlock = exception.what();
+        }
+
+        if (thread_pss != pss)
+          delete thread_pss;
       }
+      free_with_check(active_elements);
+
+      if (!exceptionMessageCaughtInParallelBlock.empty())
+        throw Hermes::Exceptions::Exception(exceptionMessageCaughtInParallelBlock.c_str());
 
       if (this->mesh == nullptr) throw Hermes::Exceptions::Exception("mesh == nullptr");
       init_dxdy_buffer();
@@ -470,7 +530,7 @@ namespace Hermes
         int counter = 0;
         for (int i = 0; i < spaces.size(); i++)
         {
-          start_indices_new.push_back(counter);
+          start_indices_new.push_back(get_start_index(spaces[i], counter));
           counter += spaces[i]->get_num_dofs();
         }
       }
@@ -495,6 +555,12 @@ namespace Hermes
       }
     }
 
+    template<typename Scalar>
+    int Solution<Scalar>::get_start_index(SpaceSharedPtr<Scalar> space, int counter)
+    {
+      return space->stride > 1 ? space->first_dof : counter;
+    }
+
     template<typename Scalar>
     void Solution<Scalar>::vector_to_solution(const Scalar* solution_vector, SpaceSharedPtr<Scalar> space,
       Solution<Scalar>* solution, bool add_dir_lift, int start_index)
@@ -537,7 +603,7 @@ namespace Hermes
         int counter = 0;
         for (int i = 0; i < spaces.size(); i++)
         {
-          start_indices_new.push_back(counter);
+          start_indices_new.push_back(get_start_index(spaces[i], counter));
           counter += spaces[i]->get_num_dofs();
         }
       }
@@ -576,7 +642,7 @@ namespace Hermes
       int counter = 0;
       for (int i = 0; i < spaces.size(); i++)
       {
-        start_indices_new.push_back(counter);
+        start_indices_new.push_back(get_start_index(spaces[i], counter));
         counter += spaces[i]->get_num_dofs();
       }
 
@@ -603,7 +669,7 @@ namespace Hermes
       int counter = 0;
       for (int i = 0; i < spaces.size(); i++)
       {
-        start_indices_new.push_back(counter);
+        start_indices_new.push_back(get_start_index(spaces[i], counter));
         counter += spaces[i]->get_num_dofs();
       }
 
@@ -648,7 +714,7 @@ namespace Hermes
         int counter = 0;
         for (int i = 0; i < spaces.size(); i++)
         {
-          start_indices_new.push_back(counter);
+          start_indices_new.push_back(get_start_index(spaces[i], counter));
           counter += spaces[i]->get_num_dofs();
         }
       }
@@ -700,11 +766,12 @@ namespace Hermes
     void Solution<Scalar>::set_dirichlet_lift(SpaceSharedPtr<Scalar> space, PrecalcShapeset* pss)
     {
       space_type = space->get_type();
-      int ndof = space->get_num_dofs();
+      int ndof = space->first_dof + space->get_num_dofs() * space->stride;
       Scalar *temp = malloc_with_check<Solution<Scalar>, Scalar>(ndof, this);
       memset(temp, 0, sizeof(Scalar)*ndof);
       bool add_dir_lift = true;
-      int start_index = 0;
+      // Only the Dirichlet lift is set, the zero coefficients are indexed by the DOF numbers.
+      int start_index = space->first_dof;
       this->set_coeff_vector(space, pss, temp, add_dir_lift, start_index);
       free_with_check(temp);
     }
@@ -785,7 +852,7 @@ namespace Hermes
     void Solution<Scalar>::init_dxdy_buffer()
     {
       free_with_check(dxdy_buffer);
-      dxdy_buffer = malloc_with_check<Solution<Scalar>, Scalar>(this->num_components * 5 * 121, this);
+      dxdy_buffer = malloc_with_check<Solution<Scalar>, Scalar>(this->num_components * 5 * H2D_MAX_MONO_COEFFS, this);
     }
 
     template<typename Scalar>
@@ -822,25 +889,87 @@ namespace Hermes
         throw Hermes::Exceptions::Exception("Uninitialized solution.");
     }
 
-    template<typename Scalar>
-    static inline void set_vec_num(int n, Scalar* y, Scalar num)
+    /// Number of points evaluated together by the fused Horner kernel; the loops over the points of a block
+    /// have a fixed length and are vectorised by the compiler (SSE / AVX / AVX-512 depending on the target).
+    static const int H2D_HORNER_BLOCK = 8;
+
+    /// Evaluates the monomial expansions of all requested quantities (values, derivatives) in one block of points
+    /// using Horner's scheme. The points are read once for all quantities, the partial results stay in registers.
+    /// \param[in] ORDER The polynomial order if known at compile time (the loops are then unrolled), -1 otherwise.
+    /// \param[in] QUAD Quad element (full tensor expansion), triangle otherwise.
+    /// \param[in] n Number of valid points in the block (the rest is padding).
+    template<typename Scalar, int ORDER, bool QUAD>
+    static inline void horner_block(int o, int num_quantities, Scalar** coeffs, Scalar** results, const double* x, const double* y, int offset, int n)
     {
-      for (int i = 0; i < n; i++)
-        y[i] = num;
+      const int order = (ORDER < 0) ? o : ORDER;
+
+      double bx[H2D_HORNER_BLOCK], by[H2D_HORNER_BLOCK];
+      for (int p = 0; p < H2D_HORNER_BLOCK; p++)
+      {
+        bx[p] = (p < n) ? x[offset + p] : 0.;
+        by[p] = (p < n) ? y[offset + p] : 0.;
+      }
+
+      for (int q = 0; q < num_quantities; q++)
+      {
+        Scalar* mono = coeffs[q];
+        Scalar result[H2D_HORNER_BLOCK], row[H2D_HORNER_BLOCK];
+        for (int i = 0; i <= order; i++)
+        {
+          Scalar c = *mono++;
+          for (int p = 0; p < H2D_HORNER_BLOCK; p++)
+            row[p] = c;
+          for (int j = 1; j <= (QUAD ? order : i); j++)
+          {
+            c = *mono++;
+            for (int p = 0; p < H2D_HORNER_BLOCK; p++)
+              row[p] = row[p] * bx[p] + c;
+          }
+
+          if (!i)
+          {
+            for (int p = 0; p < H2D_HORNER_BLOCK; p++)
+              result[p] = row[p];
+          }
+          else
+          {
+            for (int p = 0; p < H2D_HORNER_BLOCK; p++)
+              result[p] = result[p] * by[p] + row[p];
+          }
+        }
+
+        Scalar* target = results[q] + offset;
+        for (int p = 0; p < n; p++)
+          target[p] = result[p];
+      }
     }
 
-    template<typename Scalar>
-    static inline void vec_x_vec_p_num(int n, Scalar* y, Scalar* x, Scalar num)
+    template<typename Scalar, int ORDER, bool QUAD>
+    static void horner_points(int o, int num_quantities, Scalar** coeffs, Scalar** results, const double* x, const double* y, int np)
     {
-      for (int i = 0; i < n; i++)
-        y[i] = y[i] * x[i] + num;
+      for (int offset = 0; offset < np; offset += H2D_HORNER_BLOCK)
+        horner_block<Scalar, ORDER, QUAD>(o, num_quantities, coeffs, results, x, y, offset, std::min(H2D_HORNER_BLOCK, np - offset));
     }
 
-    template<typename Scalar>
-    static inline void vec_x_vec_p_vec(int n, Scalar* y, Scalar* x, Scalar* z)
+    /// Fused evaluation of all requested quantities in all points, specialised for the common orders.
+    template<typename Scalar, bool QUAD>
+    static void horner_fused(int o, int num_quantities, Scalar** coeffs, Scalar** results, const double* x, const double* y, int np)
     {
-      for (int i = 0; i < n; i++)
-        y[i] = y[i] * x[i] + z[i];
+      switch (o)
+      {
+      case 0: horner_points<Scalar, 0, QUAD>(o, num_quantities, coeffs, results, x, y, np); break;
+      case 1: horner_points<Scalar, 1, QUAD>(o, num_quantities, coeffs, results, x, y, np); break;
+      case 2: horner_points<Scalar, 2, QUAD>(o, num_quantities, coeffs, results, x, y, np); break;
+      case 3: horner_points<Scalar, 3, QUAD>(o, num_quantities, coeffs, results, x, y, np); break;
+      case 4: horner_points<Scalar, 4, QUAD>(o, num_quantities, coeffs, results, x, y, np); break;
+      case 5: horner_points<Scalar, 5, QUAD>(o, num_quantities, coeffs, results, x, y, np); break;
+      case 6: horner_points<Scalar, 6, QUAD>(o, num_quantities, coeffs, results, x, y, np); break;
+      case 7: horner_points<Scalar, 7, QUAD>(o, num_quantities, coeffs, results, x, y, np); break;
+      case 8: horner_points<Scalar, 8, QUAD>(o, num_quantities, coeffs, results, x, y, np); break;
+      case 9: horner_points<Scalar, 9, QUAD>(o, num_quantities, coeffs, results, x, y, np); break;
+      case 10: horner_points<Scalar, 10, QUAD>(o, num_quantities, coeffs, results, x, y, np); break;
+      default: horner_points<Scalar, -1, QUAD>(o, num_quantities, coeffs, results, x, y, np); break;
+      }
     }
 
     template<typename Scalar>
@@ -976,32 +1105,28 @@ namespace Hermes
         }
 
         // obtain the solution values, this is the core of the whole module
+        // all requested quantities are evaluated in one sweep over the points
         int o = elem_orders[this->element->id];
+        Scalar* coeffs[H2D_MAX_SOLUTION_COMPONENTS * H2D_NUM_FUNCTION_VALUES];
+        Scalar* results[H2D_MAX_SOLUTION_COMPONENTS * H2D_NUM_FUNCTION_VALUES];
+        int num_quantities = 0;
         for (l = 0; l < this->num_components; l++)
         {
           for (k = 0; k < H2D_NUM_FUNCTION_VALUES; k++)
           {
             if (mask & this->idx2mask[k][l])
             {
-              Scalar* result = this->values[l][k];
-
-              // calculate the solution values using Horner's scheme
-              Scalar* mono = dxdy_coeffs[l][k];
-              for (i = 0; i <= o; i++)
-              {
-                set_vec_num(np, tx, *mono++);
-                for (j = 1; j <= (this->mode ? o : i); j++)
-                  vec_x_vec_p_num(np, tx, x, *mono++);
-
-                if (!i)
-                  memcpy(result, tx, sizeof(Scalar)*np);
-                else
-                  vec_x_vec_p_vec(np, result, y, tx);
-              }
+              coeffs[num_quantities] = dxdy_coeffs[l][k];
+              results[num_quantities++] = this->values[l][k];
             }
           }
         }
 
+        if (this->mode == HERMES_MODE_QUAD)
+          horner_fused<Scalar, true>(o, num_quantities, coeffs, results, x, y, np);
+        else
+          horner_fused<Scalar, false>(o, num_quantities, coeffs, results, x, y, np);
+
         // transform gradient or vector solution, if required
         if (transform)
           transform_values(order, mask, np);
@@ -1725,6 +1850,69 @@ namespace Hermes
     }
 #endif
 
+    template<typename Scalar>
+    void Solution<Scalar>::save_binary(const char* filename) const
+    {
+      // Check.
+      this->check();
+
+      if (this->sln_type != HERMES_SLN)
+        throw Hermes::Exceptions::SolutionSaveFailureException("Only solutions given by coefficients can be saved in the binary format.");
+
+      BinaryFileWriter writer(filename, HERMES_BINARY_SOLUTION);
+
+      // Space type, complexness and counts.
+      int data[4] = { this->get_space_type(), (int)(sizeof(Scalar) / sizeof(double)), this->num_components, this->num_elems };
+      writer.write(data, 4);
+
+      // Coefficients, orders, element offsets for each component.
+      writer.write(this->mono_coeffs, this->num_coeffs);
+      writer.write(this->elem_orders, this->num_elems);
+      for (int component_i = 0; component_i < this->num_components; component_i++)
+        writer.write(this->elem_coeffs[component_i], this->num_elems);
+
+      writer.close();
+    }
+
+    template<typename Scalar>
+    void Solution<Scalar>::load_binary(const char* filename, SpaceSharedPtr<Scalar> space)
+    {
+      free();
+      this->mesh = space->get_mesh();
+      this->space_type = space->get_type();
+
+      BinaryFileReader reader(filename, HERMES_BINARY_SOLUTION);
+
+      const int* data = reader.read<int>(4, "solution data");
+      if (data[0] != this->space_type)
+        throw Exceptions::SolutionLoadFailureException("Mismatched space / saved solution (space type).");
+      if (data[1] != sizeof(Scalar) / sizeof(double))
+        throw Exceptions::SolutionLoadFailureException("Mismatched real / complex saved solution.");
+      if (data[2] != space->get_shapeset()->get_num_components())
+        throw Exceptions::SolutionLoadFailureException("Mismatched space / saved solution.");
+
+      this->sln_type = HERMES_SLN;
+      this->num_components = data[2];
+      this->num_elems = data[3];
+
+      uint64_t count;
+      const Scalar* mono_coeffs = reader.read<Scalar>(count);
+      this->num_coeffs = (int)count;
+      this->mono_coeffs = malloc_with_check<Solution<Scalar>, Scalar>(this->num_coeffs, this);
+      memcpy(this->mono_coeffs, mono_coeffs, this->num_coeffs * sizeof(Scalar));
+
+      this->elem_orders = malloc_with_check<Solution<Scalar>, int>(this->num_elems, this);
+      memcpy(this->elem_orders, reader.read<int>(this->num_elems, "element orders"), this->num_elems * sizeof(int));
+
+      for (int component_i = 0; component_i < this->num_components; component_i++)
+      {
+        this->elem_coeffs[component_i] = malloc_with_check<Solution<Scalar>, int>(this->num_elems, this);
+        memcpy(this->elem_coeffs[component_i], reader.read<int>(this->num_elems, "element coefficients"), this->num_elems * sizeof(int));
+      }
+
+      init_dxdy_buffer();
+    }
+
     template<typename Scalar>
     bool Solution<Scalar>::isOkay() const
     {
@@ -1765,25 +1953,31 @@ namespace Hermes
         throw Exceptions::Exception("Space types not compliant in Solution::load().");
     }
 
+    /// Evaluates the polynomial given by the monomial coefficients mono at the reference point (xi1, xi2) by the Horner scheme.
     template<typename Scalar>
-    Scalar Solution<Scalar>::get_ref_value(Element* e, double xi1, double xi2, int component, int item)
+    static inline Scalar evaluate_mono(int mode, int o, const Scalar* mono, double xi1, double xi2)
     {
-      if (e == nullptr)
-        throw Exceptions::NullException(1);
-
-      set_active_element(e);
-
-      int o = elem_orders[e->id];
-      Scalar* mono = dxdy_coeffs[component][item];
       Scalar result = 0.0;
       int k = 0;
       for (int i = 0; i <= o; i++)
       {
         Scalar row = mono[k++];
-        for (int j = 0; j < (this->mode ? o : i); j++)
+        for (int j = 0; j < (mode ? o : i); j++)
           row = row * xi1 + mono[k++];
         result = result * xi2 + row;
       }
+      return result;
+    }
+
+    template<typename Scalar>
+    Scalar Solution<Scalar>::get_ref_value(Element* e, double xi1, double xi2, int component, int item)
+    {
+      if (e == nullptr)
+        throw Exceptions::NullException(1);
+
+      set_active_element(e);
+
+      Scalar result = evaluate_mono(this->mode, elem_orders[e->id], dxdy_coeffs[component][item], xi1, xi2);
 
       this->invalidate_values();
       return result;
@@ -2012,6 +2206,155 @@ namespace Hermes
       }
     }
 
+    template<typename Scalar>
+    int Solution<Scalar>::get_pt_values(int count, const double* x, const double* y, Scalar* values, Scalar* dx, Scalar* dy, bool use_MeshHashGrid)
+    {
+      if (sln_type != HERMES_SLN)
+        return MeshFunction<Scalar>::get_pt_values(count, x, y, values, dx, dy, use_MeshHashGrid);
+
+      if (this->num_components > 1 && (dx || dy))
+        throw Exceptions::Exception("Derivatives of vector functions not implemented yet.");
+
+      if (count == 0)
+        return 0;
+
+      int num_threads = HermesCommonApi.get_integral_param_value(numThreads);
+
+      // Locate the points, their reference coordinates are calculated after the binning, element by element.
+      int* point_elements = malloc_with_check<int>(count);
+
+      // The MeshHashGrid is created lazily, do that outside of the parallel region.
+      if (use_MeshHashGrid)
+        this->mesh->element_on_physical_coordinates(x[0], y[0]);
+
+#pragma omp parallel for num_threads(num_threads)
+      for (int i = 0; i < count; i++)
+      {
+        Element* e = RefMap::element_on_physical_coordinates(use_MeshHashGrid, this->mesh, x[i], y[i]);
+        point_elements[i] = e ? e->id : -1;
+      }
+
+      // Bin the points by elements (counting sort), points outside of the mesh go to the bin 0.
+      int max_element_id = this->mesh->get_max_element_id();
+      int* bin_offsets = calloc_with_check<int>(max_element_id + 2);
+      for (int i = 0; i < count; i++)
+        bin_offsets[point_elements[i] + 2]++;
+      for (int bin = 2; bin < max_element_id + 2; bin++)
+        bin_offsets[bin] += bin_offsets[bin - 1];
+      int* sorted_points = malloc_with_check<int>(count);
+      for (int i = 0; i < count; i++)
+        sorted_points[bin_offsets[point_elements[i] + 1]++] = i;
+
+      // The coordinates in the order of the bins.
+      double* sorted_x = malloc_with_check<double>(count);
+      double* sorted_y = malloc_with_check<double>(count);
+      double* sorted_xi1 = malloc_with_check<double>(count);
+      double* sorted_xi2 = malloc_with_check<double>(count);
+      for (int sorted_i = 0; sorted_i < count; sorted_i++)
+      {
+        sorted_x[sorted_i] = x[sorted_points[sorted_i]];
+        sorted_y[sorted_i] = y[sorted_points[sorted_i]];
+      }
+
+      // After the previous loop, bin_offsets[id] is the start of the bin of the element id, bin_offsets[id + 1] its end.
+      int points_outside = bin_offsets[0];
+      for (int sorted_i = 0; sorted_i < points_outside; sorted_i++)
+      {
+        int i = sorted_points[sorted_i];
+        for (int component = 0; component < this->num_components; component++)
+          values[component * count + i] = 0.0;
+        if (dx)
+          dx[i] = 0.0;
+        if (dy)
+          dy[i] = 0.0;
+      }
+
+      // Evaluate element by element.
+      bool need_refmap = dx || dy || this->num_components > 1;
+#pragma omp parallel num_threads(num_threads)
+      {
+        RefMap* refmap = need_refmap ? new RefMap() : nullptr;
+        Scalar dx_coeffs[H2D_MAX_MONO_COEFFS], dy_coeffs[H2D_MAX_MONO_COEFFS];
+
+#pragma omp for schedule(dynamic, 64)
+        for (int element_id = 0; element_id < max_element_id; element_id++)
+        {
+          int bin_start = bin_offsets[element_id], bin_end = bin_offsets[element_id + 1];
+          if (bin_start == bin_end)
+            continue;
+
+          Element* e = this->mesh->get_element(element_id);
+          int mode = e->get_mode();
+          int o = elem_orders[element_id];
+          if (refmap)
+            refmap->set_active_element(e);
+          RefMap::untransform(e, bin_end - bin_start, sorted_x + bin_start, sorted_y + bin_start, sorted_xi1 + bin_start, sorted_xi2 + bin_start);
+
+          if (this->num_components == 1)
+          {
+            Scalar* mono = mono_coeffs + elem_coeffs[0][element_id];
+            if (dx || dy)
+            {
+              make_dx_coeffs(mode, o, mono, dx_coeffs);
+              make_dy_coeffs(mode, o, mono, dy_coeffs);
+            }
+
+            for (int sorted_i = bin_start; sorted_i < bin_end; sorted_i++)
+            {
+              int i = sorted_points[sorted_i];
+              double xi1 = sorted_xi1[sorted_i], xi2 = sorted_xi2[sorted_i];
+              values[i] = evaluate_mono(mode, o, mono, xi1, xi2);
+              if (dx || dy)
+              {
+                double2x2 m;
+                double xx, yy;
+                refmap->inv_ref_map_at_point(xi1, xi2, xx, yy, m);
+                Scalar ref_dx = evaluate_mono(mode, o, dx_coeffs, xi1, xi2);
+                Scalar ref_dy = evaluate_mono(mode, o, dy_coeffs, xi1, xi2);
+                if (dx)
+                  dx[i] = m[0][0] * ref_dx + m[0][1] * ref_dy;
+                if (dy)
+                  dy[i] = m[1][0] * ref_dx + m[1][1] * ref_dy;
+              }
+            }
+          }
+          else // vector solution
+          {
+            Scalar* mono_0 = mono_coeffs + elem_coeffs[0][element_id];
+            Scalar* mono_1 = mono_coeffs + elem_coeffs[1][element_id];
+            for (int sorted_i = bin_start; sorted_i < bin_end; sorted_i++)
+            {
+              int i = sorted_points[sorted_i];
+              double xi1 = sorted_xi1[sorted_i], xi2 = sorted_xi2[sorted_i];
+              double2x2 m;
+              double xx, yy;
+              refmap->inv_ref_map_at_point(xi1, xi2, xx, yy, m);
+              Scalar vx = evaluate_mono(mode, o, mono_0, xi1, xi2);
+              Scalar vy = evaluate_mono(mode, o, mono_1, xi1, xi2);
+              values[i] = m[0][0] * vx + m[0][1] * vy;
+              values[count + i] = m[1][0] * vx + m[1][1] * vy;
+            }
+          }
+        }
+
+        if (refmap)
+          delete refmap;
+      }
+
+      free_with_check(point_elements);
+      free_with_check(sorted_x);
+      free_with_check(sorted_y);
+      free_with_check(sorted_xi1);
+      free_with_check(sorted_xi2);
+      free_with_check(bin_offsets);
+      free_with_check(sorted_points);
+
+      if (points_outside > 0)
+        this->warn("%i points do not lie in any element.", points_outside);
+
+      return points_outside;
+    }
+
     template class HERMES_API Solution<double>;
     template class HERMES_API Solution<std::complex<double> >;
   }
@@ -0,0 +1,215 @@
+// This file is part of Hermes2D.
+//
+// Hermes2D is free software: you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation, either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D.  If not, see <http://www.gnu.org/licenses/>.
+
+#include "load_balancer.h"
+#include "function/solution.h"
+#include <algorithm>
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    LoadBalancer::LoadBalancer(int num_items, int num_threads) : num_items(num_items), num_threads(num_threads), next_item(0)
+    {
+      if (num_threads < 1)
+        throw Exceptions::ValueException("num_threads", num_threads, 1);
+
+      this->costs = malloc_with_check<double>(std::max(num_items, 1));
+      for (int i = 0; i < num_items; i++)
+        this->costs[i] = 1.;
+      this->cumulative_costs = malloc_with_check<double>(num_items + 1);
+      this->range_starts = malloc_with_check<int>(num_threads + 1);
+
+      this->thread_timers = new Hermes::Mixins::TimeMeasurable[num_threads];
+      this->thread_items = calloc_with_check<int>(num_threads);
+
+      this->init();
+    }
+
+    LoadBalancer::~LoadBalancer()
+    {
+      free_with_check(this->costs);
+      free_with_check(this->cumulative_costs);
+      free_with_check(this->range_starts);
+      delete[] this->thread_timers;
+      free_with_check(this->thread_items);
+    }
+
+    void LoadBalancer::set_cost(int item, double cost)
+    {
+      this->costs[item] = cost;
+    }
+
+    void LoadBalancer::init()
+    {
+      this->cumulative_costs[0] = 0.;
+      for (int i = 0; i < this->num_items; i++)
+        this->cumulative_costs[i + 1] = this->cumulative_costs[i] + this->costs[i];
+      this->next_item = 0;
+
+      // The ranges start at the first items reaching the multiples of 1 / num_threads of the total cost.
+      double total_cost = this->cumulative_costs[this->num_items];
+      this->range_starts[0] = 0;
+      for (int i = 1; i < this->num_threads; i++)
+        this->range_starts[i] = std::max(this->range_starts[i - 1], (int)(std::lower_bound(this->cumulative_costs, this->cumulative_costs + this->num_items, total_cost * i / this->num_threads) - this->cumulative_costs));
+      this->range_starts[this->num_threads] = this->num_items;
+
+      for (int i = 0; i < this->num_threads; i++)
+      {
+        this->thread_items[i] = 0;
+        this->thread_timers[i].reset();
+      }
+    }
+
+    bool LoadBalancer::get_chunk(int thread_number, int& begin, int& end)
+    {
+#pragma omp critical (LoadBalancerChunk)
+      {
+        begin = this->next_item;
+        end = begin;
+        if (begin < this->num_items)
+        {
+          // The chunk takes (at least one item and) 1 / (2 * num_threads) of the remaining cost.
+          double target = this->cumulative_costs[begin] + (this->cumulative_costs[this->num_items] - this->cumulative_costs[begin]) / (2. * this->num_threads);
+          end = (int)(std::upper_bound(this->cumulative_costs + begin + 1, this->cumulative_costs + this->num_items + 1, target) - this->cumulative_costs) - 1;
+          end = std::max(end, begin + 1);
+          this->next_item = end;
+        }
+      }
+
+      this->thread_items[thread_number] += end - begin;
+      return begin < end;
+    }
+
+    void LoadBalancer::get_range(int thread_number, int& begin, int& end)
+    {
+      begin = this->range_starts[thread_number];
+      end = this->range_starts[thread_number + 1];
+      this->thread_items[thread_number] = end - begin;
+    }
+
+    const int* LoadBalancer::get_ranges() const
+    {
+      return this->range_starts;
+    }
+
+    void LoadBalancer::set_ranges(const int* range_starts)
+    {
+      memcpy(this->range_starts, range_starts, (this->num_threads + 1) * sizeof(int));
+    }
+
+    void LoadBalancer::begin_thread(int thread_number)
+    {
+      this->thread_timers[thread_number].tick_reset();
+    }
+
+    void LoadBalancer::end_thread(int thread_number)
+    {
+      this->thread_timers[thread_number].tick();
+    }
+
+    double LoadBalancer::get_busy_time(int thread_number) const
+    {
+      return this->thread_timers[thread_number].accumulated();
+    }
+
+    int LoadBalancer::get_num_items_processed(int thread_number) const
+    {
+      return this->thread_items[thread_number];
+    }
+
+    double LoadBalancer::get_imbalance() const
+    {
+      double max_time = 0., sum_time = 0.;
+      for (int i = 0; i < this->num_threads; i++)
+      {
+        max_time = std::max(max_time, this->get_busy_time(i));
+        sum_time += this->get_busy_time(i);
+      }
+      return sum_time > 0. ? max_time * this->num_threads / sum_time : 1.;
+    }
+
+    void LoadBalancer::report(const Hermes::Mixins::Loggable* logger, const char* loop_name) const
+    {
+      for (int i = 0; i < this->num_threads; i++)
+        logger->info("%s: thread %i busy %f s, %i items.", loop_name, i, this->get_busy_time(i), this->get_num_items_processed(i));
+      logger->info("%s: load imbalance (max / average busy time) %f.", loop_name, this->get_imbalance());
+    }
+
+    int LoadBalancer::get_num_shape_functions(Element* e, int order)
+    {
+      if (e->get_mode() == HERMES_MODE_TRIANGLE)
+      {
+        int p = std::max(H2D_GET_H_ORDER(order), H2D_GET_V_ORDER(order));
+        return (p + 1) * (p + 2) / 2;
+      }
+      else
+        return (H2D_GET_H_ORDER(order) + 1) * (H2D_GET_V_ORDER(order) + 1);
+    }
+
+    double LoadBalancer::get_element_cost(Element* e, int order)
+    {
+      double num_shape_functions = get_num_shape_functions(e, order);
+      int p = std::max(H2D_GET_H_ORDER(order), H2D_GET_V_ORDER(order));
+      return num_shape_functions * num_shape_functions * (p + 1) * (p + 1);
+    }
+
+    template<typename Scalar>
+    double LoadBalancer::get_assembling_cost(Traverse::State* state, const Hermes::vector<SpaceSharedPtr<Scalar> >& spaces, int num_forms)
+    {
+      // The local matrix has (sum of the numbers of shape functions)^2 entries, all of them are integrated by the quadrature
+      // of the highest order.
+      int num_shape_functions = 0, max_order = 0;
+      for (unsigned int i = 0; i < spaces.size(); i++)
+      {
+        if (!state->e[i])
+          continue;
+        int order = spaces[i]->get_element_order(state->e[i]->id);
+        if (order < 0)
+          continue;
+        num_shape_functions += get_num_shape_functions(state->e[i], order);
+        max_order = std::max(max_order, std::max(H2D_GET_H_ORDER(order), H2D_GET_V_ORDER(order)));
+      }
+
+      return (double)std::max(num_forms, 1) * num_shape_functions * num_shape_functions * (max_order + 1) * (max_order + 1);
+    }
+
+    template<typename Scalar>
+    double LoadBalancer::get_evaluation_cost(Element** elements, const MeshFunctionSharedPtr<Scalar>* functions, int num_functions)
+    {
+      // The (monomial) coefficients of the functions evaluated in ~ (order + 1)^2 quadrature points.
+      double cost = 0.;
+      for (int i = 0; i < num_functions; i++)
+      {
+        Element* e = elements[i];
+        if (!e)
+          continue;
+
+        int order = 1;
+        Solution<Scalar>* solution = dynamic_cast<Solution<Scalar>*>(functions[i].get());
+        if (solution && solution->get_type() == HERMES_SLN && solution->elem_orders && e->id < solution->num_elems)
+          order = solution->elem_orders[e->id];
+
+        cost += (double)get_num_shape_functions(e, H2D_MAKE_QUAD_ORDER(order, order)) * (order + 1) * (order + 1);
+      }
+      return cost;
+    }
+
+    template HERMES_API double LoadBalancer::get_assembling_cost<double>(Traverse::State* state, const Hermes::vector<SpaceSharedPtr<double> >& spaces, int num_forms);
+    template HERMES_API double LoadBalancer::get_assembling_cost<std::complex<double> >(Traverse::State* state, const Hermes::vector<SpaceSharedPtr<std::complex<double> > >& spaces, int num_forms);
+    template HERMES_API double LoadBalancer::get_evaluation_cost<double>(Element** elements, const MeshFunctionSharedPtr<double>* functions, int num_functions);
+    template HERMES_API double LoadBalancer::get_evaluation_cost<std::complex<double> >(Element** elements, const MeshFunctionSharedPtr<std::complex<double> >* functions, int num_functions);
+  }
+}
@@ -60,6 +60,67 @@ namespace Hermes
 
       this->precalculate_cholesky_projection_matrices_bubble();
       this->precalculate_cholesky_projection_matrix_edge();
+
+      // Shape function values - filled on first use.
+      for (int mode = HERMES_MODE_TRIANGLE; mode <= HERMES_MODE_QUAD; mode++)
+      {
+        this->shape_values_count[mode] = ref_map_shapeset.get_max_index((ElementMode2D)mode) + 1;
+        this->shape_values[mode] = calloc_with_check<double*>(this->shape_values_count[mode]);
+      }
+
+      // Edge function values.
+      int mo1 = g_quad_1d_std.get_max_order();
+      int np = g_quad_1d_std.get_num_points(mo1);
+      double2* pt = g_quad_1d_std.get_points(mo1);
+      this->edge_fn_values = new_matrix<double>(edge_proj_matrix_size, np);
+      for (int i = 0; i < edge_proj_matrix_size; i++)
+      {
+        for (int j = 0; j < np; j++)
+        {
+          double t = pt[j][0];
+          double fi = 0;
+          switch (i + 2)
+          {
+          case 0:
+            fi = l0(t);
+            break;
+          case 1:
+            fi = l1(t);
+            break;
+          case 2:
+            fi = l2(t);
+            break;
+          case 3:
+            fi = l3(t);
+            break;
+          case 4:
+            fi = l4(t);
+            break;
+          case 5:
+            fi = l5(t);
+            break;
+          case 6:
+            fi = l6(t);
+            break;
+          case 7:
+            fi = l7(t);
+            break;
+          case 8:
+            fi = l8(t);
+            break;
+          case 9:
+            fi = l9(t);
+            break;
+          case 10:
+            fi = l10(t);
+            break;
+          case 11:
+            fi = l11(t);
+            break;
+          }
+          this->edge_fn_values[i][j] = fi;
+        }
+      }
     }
 
     CurvMapStatic::~CurvMapStatic()
@@ -67,9 +128,44 @@ namespace Hermes
       free_with_check(edge_proj_matrix, true);
       free_with_check(bubble_proj_matrix_tri, true);
       free_with_check(bubble_proj_matrix_quad, true);
+      free_with_check(edge_fn_values, true);
       free_with_check(edge_p);
       free_with_check(bubble_tri_p);
       free_with_check(bubble_quad_p);
+
+      for (int mode = HERMES_MODE_TRIANGLE; mode <= HERMES_MODE_QUAD; mode++)
+      {
+        for (int i = 0; i < this->shape_values_count[mode]; i++)
+          free_with_check(this->shape_values[mode][i]);
+        free_with_check(this->shape_values[mode]);
+      }
+    }
+
+    const double* CurvMapStatic::get_shape_values(int index, ElementMode2D mode)
+    {
+      if (this->shape_values[mode][index] == nullptr)
+      {
+        int mo2 = g_quad_2d_std.get_max_order(mode);
+        int np = g_quad_2d_std.get_num_points(mo2, mode);
+        double3* pt = g_quad_2d_std.get_points(mo2, mode);
+
+        double* values = malloc_with_check<double>(np);
+        for (int j = 0; j < np; j++)
+          values[j] = ref_map_shapeset.get_fn_value(index, pt[j][0], pt[j][1], 0, mode);
+
+#pragma omp critical (CurvMapStaticShapeValues)
+        {
+          if (this->shape_values[mode][index] == nullptr)
+          {
+            // The values have to be complete before they are reachable by the lock-free readers.
+#pragma omp flush
+            this->shape_values[mode][index] = values;
+            values = nullptr;
+          }
+        }
+        free_with_check(values);
+      }
+      return this->shape_values[mode][index];
     }
 
     double** CurvMapStatic::calculate_bubble_projection_matrix(int* indices, ElementMode2D mode)
@@ -315,21 +411,28 @@ namespace Hermes
       return  0.5 * (y + 1);
     }
 
-    CurvMap::CurvMap() : ref_map_pss(PrecalcShapeset(&ref_map_shapeset))
+    CurvMap::CurvMap()
     {
+      nc = 0;
       coeffs = nullptr;
-      ctm = nullptr;
       memset(curves, 0, sizeof(Curve*)* H2D_MAX_NUMBER_EDGES);
     }
 
-    CurvMap::CurvMap(const CurvMap* cm) : ref_map_pss(PrecalcShapeset(&ref_map_shapeset))
+    CurvMap::CurvMap(const CurvMap* cm)
     {
-      this->nc = cm->nc;
       this->order = cm->order;
-      /// \todo Find out if this is safe.
-      this->ctm = cm->ctm;
-      this->coeffs = malloc_with_check<double2>(nc, true);
-      memcpy(coeffs, cm->coeffs, sizeof(double2)* nc);
+      // The coefficients of a son may not have been calculated yet.
+      if (cm->coeffs)
+      {
+        this->nc = cm->nc;
+        this->coeffs = malloc_with_check<double2>(nc, true);
+        memcpy(coeffs, cm->coeffs, sizeof(double2)* nc);
+      }
+      else
+      {
+        this->nc = 0;
+        this->coeffs = nullptr;
+      }
 
       this->toplevel = cm->toplevel;
       if (this->toplevel)
@@ -702,7 +805,7 @@ namespace Hermes
         calc_ref_map_tri(e, curve, xi_1, xi_2, f[0], f[1]);
     }
 
-    void CurvMap::edge_coord(Element* e, int edge, double t, double2& x, double2& v) const
+    void CurvMap::edge_coord(Element* e, const Trf* ctm, int edge, double t, double2& x, double2& v)
     {
       int mode = e->get_mode();
       double2 a, b;
@@ -720,7 +823,7 @@ namespace Hermes
       v[0] /= lenght; v[1] /= lenght;
     }
 
-    void CurvMap::calc_edge_projection(Element* e, int edge, Curve** nurbs, int order, double2* proj) const
+    void CurvMap::calc_edge_projection(Element* e, const Trf* ctm, int edge, Curve** nurbs, int order, double2* proj)
     {
       int i, j, k;
       int mo1 = g_quad_1d_std.get_max_order();
@@ -751,7 +854,7 @@ namespace Hermes
       {
         double2 x, v;
         double t = pt[j][0];
-        edge_coord(e, edge, t, x, v);
+        edge_coord(e, ctm, edge, t, x, v);
         calc_ref_map(e, nurbs, x[0], x[1], fn[j]);
 
         for (k = 0; k < 2; k++)
@@ -763,51 +866,9 @@ namespace Hermes
       {
         for (i = 0; i < ne; i++)
         {
+          const double* fi = curvMapStatic.edge_fn_values[i];
           for (j = 0; j < np; j++)
-          {
-            double t = pt[j][0];
-            double fi = 0;
-            switch (i + 2)
-            {
-            case 0:
-              fi = l0(t);
-              break;
-            case 1:
-              fi = l1(t);
-              break;
-            case 2:
-              fi = l2(t);
-              break;
-            case 3:
-              fi = l3(t);
-              break;
-            case 4:
-              fi = l4(t);
-              break;
-            case 5:
-              fi = l5(t);
-              break;
-            case 6:
-              fi = l6(t);
-              break;
-            case 7:
-              fi = l7(t);
-              break;
-            case 8:
-              fi = l8(t);
-              break;
-            case 9:
-              fi = l9(t);
-              break;
-            case 10:
-              fi = l10(t);
-              break;
-            case 11:
-              fi = l11(t);
-              break;
-            }
-            rhside[k][i] += pt[j][1] * (fi * fn[j][k]);
-          }
+            rhside[k][i] += pt[j][1] * (fi[j] * fn[j][k]);
         }
         // solve
         cholsl(curvMapStatic.edge_proj_matrix, ne, curvMapStatic.edge_p, rhside[k], rhside[k]);
@@ -825,9 +886,7 @@ namespace Hermes
       {
         // vertex basis functions in all integration points
         int index_v = ref_map_shapeset.get_vertex_index(k, e->get_mode());
-        ref_map_pss.set_active_shape(index_v);
-        ref_map_pss.set_quad_order(mo2, H2D_FN_VAL_0);
-        const double* vd = ref_map_pss.get_fn_values();
+        const double* vd = curvMapStatic.get_shape_values(index_v, e->get_mode());
 
         for (int m = 0; m < 2; m++)   // part 0 or 1
         for (int j = 0; j < np; j++)
@@ -837,9 +896,7 @@ namespace Hermes
         {
           // edge basis functions in all integration points
           int index_e = ref_map_shapeset.get_edge_index(k, 0, ii + 2, e->get_mode());
-          ref_map_pss.set_active_shape(index_e);
-          ref_map_pss.set_quad_order(mo2, H2D_FN_VAL_0);
-          const double* ed = ref_map_pss.get_fn_values();
+          const double* ed = curvMapStatic.get_shape_values(index_e, e->get_mode());
 
           for (int m = 0; m < 2; m++)  //part 0 or 1
           for (int j = 0; j < np; j++)
@@ -848,10 +905,8 @@ namespace Hermes
       }
     }
 
-    void CurvMap::calc_bubble_projection(Element* e, Curve** curve, int order, double2* proj)
+    void CurvMap::calc_bubble_projection(Element* e, const Trf* ctm, Curve** curve, int order, double2* proj)
     {
-      ref_map_pss.set_active_element(e);
-
       int i, j, k;
       int mo2 = g_quad_2d_std.get_max_order(e->get_mode());
       int np = g_quad_2d_std.get_num_points(mo2, e->get_mode());
@@ -891,9 +946,7 @@ namespace Hermes
         {
           // bubble basis functions in all integration points
           int index_i = ref_map_shapeset.get_bubble_indices(qo, e->get_mode())[i];
-          ref_map_pss.set_active_shape(index_i);
-          ref_map_pss.set_quad_order(mo2, H2D_FN_VAL_0);
-          const double *bfn = ref_map_pss.get_fn_values();
+          const double *bfn = curvMapStatic.get_shape_values(index_i, e->get_mode());
 
           for (j = 0; j < np; j++) // over all integration points
             rhside[k][i] += pt[j][2] * (bfn[j] * (fn[j][k] - old[k][j]));
@@ -917,34 +970,29 @@ namespace Hermes
       delete[] fn;
     }
 
-    void CurvMap::update_refmap_coeffs(Element* e)
+    double2* CurvMap::calc_refmap_coeffs(Element* e, int& nc) const
     {
-      ref_map_pss.set_quad_2d(&g_quad_2d_std);
-      ref_map_pss.set_active_element(e);
-
       // allocate projection coefficients
       int nv = e->get_nvert();
       int ne = order - 1;
       int qo = e->is_quad() ? H2D_MAKE_QUAD_ORDER(order, order) : order;
       int nb = ref_map_shapeset.get_num_bubbles(qo, e->get_mode());
       nc = nv + nv*ne + nb;
-      this->coeffs = realloc_with_check<double2>(this->coeffs, nc);
+      double2* coeffs = malloc_with_check<double2>(nc, true);
 
       // WARNING: do not change the format of the array 'coeffs'. If it changes,
       // RefMap::set_active_element() has to be changed too.
+      Transformable tran;
+      tran.set_active_element(e);
       Curve** curves;
       if (toplevel == false)
       {
-        ref_map_pss.set_active_element(e);
-        ref_map_pss.set_transform(this->sub_idx);
+        tran.set_transform(this->sub_idx);
         curves = parent->cm->curves;
       }
       else
-      {
-        ref_map_pss.reset_transform();
         curves = e->cm->curves;
-      }
-      ctm = ref_map_pss.get_ctm();
+      Trf ctm = *tran.get_ctm();
 
       // calculation of new_ projection coefficients
       // vertex part
@@ -959,12 +1007,52 @@ namespace Hermes
 
       // edge part
       for (int edge = 0; edge < e->get_nvert(); edge++)
-        calc_edge_projection(e, edge, curves, order, coeffs);
+        calc_edge_projection(e, &ctm, edge, curves, order, coeffs);
 
       //bubble part
-      calc_bubble_projection(e, curves, order, coeffs);
+      calc_bubble_projection(e, &ctm, curves, order, coeffs);
+
+      return coeffs;
+    }
+
+    void CurvMap::update_refmap_coeffs(Element* e)
+    {
+      int new_nc;
+      double2* new_coeffs = this->calc_refmap_coeffs(e, new_nc);
+      free_with_check(this->coeffs, true);
+      this->nc = new_nc;
+      this->coeffs = new_coeffs;
+
+      RefMap::set_element_iro_cache(this->toplevel ? e : this->parent);
+    }
+
+    double2* CurvMap::get_refmap_coeffs(Element* e, int& nc)
+    {
+      double2* coeffs = this->coeffs;
+      if (coeffs == nullptr)
+      {
+        int new_nc;
+        double2* new_coeffs = this->calc_refmap_coeffs(e, new_nc);
+
+#pragma omp critical (CurvMapRefMapCoeffs)
+        {
+          if (this->coeffs == nullptr)
+          {
+            this->nc = new_nc;
+            // The coefficients and their number have to be complete before they are reachable by the lock-free readers.
+#pragma omp flush
+            this->coeffs = new_coeffs;
+            new_coeffs = nullptr;
+          }
+          coeffs = this->coeffs;
+        }
+        free_with_check(new_coeffs, true);
+      }
 
-      RefMap::set_element_iro_cache(e);
+      // Pairs with the flush of the writer: the number is read only after the pointer has been seen.
+#pragma omp flush
+      nc = this->nc;
+      return coeffs;
     }
 
     void CurvMap::get_mid_edge_points(Element* e, double2* pt, int n)
@@ -980,7 +1068,7 @@ namespace Hermes
         curves = e->cm->curves;
       }
 
-      ctm = tran.get_ctm();
+      Trf* ctm = tran.get_ctm();
       double xi_1, xi_2;
       for (int i = 0; i < n; i++)
       {
@@ -21,40 +21,250 @@ namespace Hermes
 {
   namespace Hermes2D
   {
-    HashTable::HashTable()
+    NodeHashTable::NodeHashTable() : entries(nullptr), mask(0), shift(64), count(0)
     {
-      v_table = nullptr; e_table = nullptr;
     }
 
-    HashTable::~HashTable()
+    NodeHashTable::~NodeHashTable()
     {
       free();
     }
 
-    void HashTable::init(int size)
+    void NodeHashTable::init(int size)
+    {
+      free();
+
+      // Keep the load factor below 1/2.
+      int capacity = 16;
+      while (capacity < 2 * size)
+        capacity *= 2;
+
+      this->mask = capacity - 1;
+      this->shift = 64;
+      while (capacity > 1)
+      {
+        capacity >>= 1;
+        this->shift--;
+      }
+      this->count = 0;
+      this->entries = malloc_with_check<Entry>(this->mask + 1);
+      memset(this->entries, 0xff, (this->mask + 1) * sizeof(Entry));
+    }
+
+    void NodeHashTable::free()
+    {
+      free_with_check(this->entries);
+      this->count = 0;
+    }
+
+    void NodeHashTable::copy(const NodeHashTable& other)
     {
-      v_table = e_table = nullptr;
+      free();
+      this->mask = other.mask;
+      this->shift = other.shift;
+      this->count = other.count;
+      this->entries = malloc_with_check<Entry>(this->mask + 1);
+      memcpy(this->entries, other.entries, (this->mask + 1) * sizeof(Entry));
+    }
+
+    void NodeHashTable::place(int p1, int p2, int id)
+    {
+      unsigned int i = slot(p1, p2);
+      while (this->entries[i].id != -1)
+        i = (i + 1) & this->mask;
+      this->entries[i].p1 = p1;
+      this->entries[i].p2 = p2;
+      this->entries[i].id = id;
+    }
+
+    void NodeHashTable::insert(int p1, int p2, int id)
+    {
+      if (2 * (this->count + 1) > (int)(this->mask + 1))
+        this->grow();
+
+      this->place(p1, p2, id);
+      this->count++;
+    }
+
+    void NodeHashTable::insert(int count, const int* p1s, const int* p2s, const int* ids)
+    {
+      while (2 * (this->count + count) > (int)(this->mask + 1))
+        this->grow();
+
+      // Blocks of 2^12 slots.
+      const int block_bits = 12;
+      int num_blocks = (this->mask + 1) >> block_bits;
+      int num_threads = HermesCommonApi.get_integral_param_value(numThreads);
+      if (num_blocks < 2 || num_threads < 2)
+      {
+        for (int i = 0; i < count; i++)
+          this->place(p1s[i], p2s[i], ids[i]);
+        this->count += count;
+        return;
+      }
+
+      // Home slots of the entries, the entries sorted by their blocks (stable, the same order for any number of threads).
+      unsigned int* homes = malloc_with_check<unsigned int>(count);
+      int* order = malloc_with_check<int>(count);
+      int* block_starts = malloc_with_check<int>(num_blocks + 1);
+      int* thread_block_starts = calloc_with_check<int>(num_threads * num_blocks);
+
+#pragma omp parallel num_threads(num_threads)
+      {
+        int thread_number = omp_get_thread_num();
+        int used_threads = omp_get_num_threads();
+        int start = (int)((long long)count * thread_number / used_threads);
+        int end = (int)((long long)count * (thread_number + 1) / used_threads);
+        int* starts = thread_block_starts + thread_number * num_blocks;
+
+        for (int i = start; i < end; i++)
+        {
+          homes[i] = slot(p1s[i], p2s[i]);
+          starts[homes[i] >> block_bits]++;
+        }
+
+#pragma omp barrier
+#pragma omp single
+        {
+          int position = 0;
+          for (int block = 0; block < num_blocks; block++)
+          {
+            block_starts[block] = position;
+            for (int thread_i = 0; thread_i < used_threads; thread_i++)
+            {
+              int block_count = thread_block_starts[thread_i * num_blocks + block];
+              thread_block_starts[thread_i * num_blocks + block] = position;
+              position += block_count;
+            }
+          }
+          block_starts[num_blocks] = position;
+        }
 
-      mask = size-1;
-      if(size & mask) throw Hermes::Exceptions::Exception("Parameter 'size' must be a power of two.");
+        for (int i = start; i < end; i++)
+          order[starts[homes[i] >> block_bits]++] = i;
+
+#pragma omp barrier
+
+        // Every thread writes only the slots of its blocks, an entry whose probing would leave its block is marked (~i).
+#pragma omp for schedule(dynamic, 1)
+        for (int block = 0; block < num_blocks; block++)
+        {
+          unsigned int block_end = (unsigned int)(block + 1) << block_bits;
+          for (int k = block_starts[block]; k < block_starts[block + 1]; k++)
+          {
+            int i = order[k];
+            unsigned int slot_i = homes[i];
+            while (slot_i < block_end && this->entries[slot_i].id != -1)
+              slot_i++;
+            if (slot_i == block_end)
+            {
+              order[k] = ~i;
+              continue;
+            }
+            this->entries[slot_i].p1 = p1s[i];
+            this->entries[slot_i].p2 = p2s[i];
+            this->entries[slot_i].id = ids[i];
+          }
+        }
+      }
 
-      // allocate and initialize the hash tables
-      v_table = new Node*[size];
-      e_table = new Node*[size];
+      for (int k = 0; k < count; k++)
+      {
+        if (order[k] < 0)
+          this->place(p1s[~order[k]], p2s[~order[k]], ids[~order[k]]);
+      }
+      this->count += count;
 
-      memset(v_table, 0, size * sizeof(Node*));
-      memset(e_table, 0, size * sizeof(Node*));
+      free_with_check(homes);
+      free_with_check(order);
+      free_with_check(block_starts);
+      free_with_check(thread_block_starts);
     }
 
-    void HashTable::copy_list(Node** ptr, Node* node)
+    void NodeHashTable::remove(int p1, int p2, int id)
     {
-      while (node != nullptr)
+      if (p1 > p2) std::swap(p1, p2);
+      unsigned int i = slot(p1, p2);
+      for (;; i = (i + 1) & this->mask)
+      {
+        if (this->entries[i].id == -1)
+          return;
+        if (this->entries[i].id == id)
+          break;
+      }
+
+      // Shift back the entries of the cluster that would not be found after emptying the slot i.
+      unsigned int j = i;
+      while (true)
       {
-        *ptr = &nodes[node->id];
-        ptr = &((*ptr)->next_hash);
-        node = node->next_hash;
+        j = (j + 1) & this->mask;
+        if (this->entries[j].id == -1)
+          break;
+        unsigned int home = slot(this->entries[j].p1, this->entries[j].p2);
+        // The entry j may stay if its home lies cyclically in (i, j].
+        if ((i < j) ? (i < home && home <= j) : (i < home || home <= j))
+          continue;
+        this->entries[i] = this->entries[j];
+        i = j;
       }
-      *ptr = nullptr;
+      this->entries[i].id = -1;
+      this->count--;
+    }
+
+    void NodeHashTable::grow()
+    {
+      Entry* old_entries = this->entries;
+      unsigned int old_capacity = this->mask + 1;
+
+      this->mask = 2 * old_capacity - 1;
+      this->shift--;
+      this->entries = malloc_with_check<Entry>(this->mask + 1);
+      memset(this->entries, 0xff, (this->mask + 1) * sizeof(Entry));
+
+      for (unsigned int i = 0; i < old_capacity; i++)
+      {
+        if (old_entries[i].id == -1)
+          continue;
+        unsigned int j = slot(old_entries[i].p1, old_entries[i].p2);
+        while (this->entries[j].id != -1)
+          j = (j + 1) & this->mask;
+        this->entries[j] = old_entries[i];
+      }
+
+      free_with_check(old_entries);
+    }
+
+    int NodeHashTable::get_count() const
+    {
+      return this->count;
+    }
+
+    int NodeHashTable::get_capacity() const
+    {
+      return this->mask + 1;
+    }
+
+    HashTable::HashTable() : search_plan(nullptr)
+    {
+    }
+
+    HashTable::~HashTable()
+    {
+      free();
+    }
+
+    void HashTable::init(int size)
+    {
+      if (size & (size - 1))
+        throw Hermes::Exceptions::Exception("Parameter 'size' must be a power of two.");
+
+      v_table.init(size);
+      e_table.init(size);
+    }
+
+    int HashTable::get_hash_size() const
+    {
+      return std::max(this->v_table.get_capacity(), this->e_table.get_capacity()) / 2;
     }
 
     Node* HashTable::get_node(int id) const
@@ -83,76 +293,183 @@ namespace Hermes
     {
       free();
       nodes.copy(ht->nodes);
-      mask = ht->mask;
 
-      v_table = new Node*[mask + 1];
-      e_table = new Node*[mask + 1];
-      for (int i = 0; i <= mask; i++)
-      {
-        copy_list(v_table + i, ht->v_table[i]);
-        copy_list(e_table + i, ht->e_table[i]);
-      }
+      // The node ids are preserved by the copy, the tables are copied as they are.
+      v_table.copy(ht->v_table);
+      e_table.copy(ht->e_table);
     }
 
     void HashTable::rebuild()
     {
-      memset(v_table, 0, (mask + 1) * sizeof(Node*));
-      memset(e_table, 0, (mask + 1) * sizeof(Node*));
-
+      // Size the tables for all nodes, so that they do not grow during the build.
+      int vertex_count = 0, edge_count = 0;
       Node* node;
       for_all_nodes(node, this)
       {
-        int p1 = node->p1, p2 = node->p2;
-        if(p1 > p2) std::swap(p1, p2);
-        int idx = hash(p1, p2);
+        if (node->type == HERMES_TYPE_VERTEX)
+          vertex_count++;
+        else
+          edge_count++;
+      }
+      v_table.init(vertex_count);
+      e_table.init(edge_count);
+
+      this->insert_all_nodes();
+    }
+
+    void HashTable::insert_all_nodes()
+    {
+      int max_node_id = this->get_max_node_id();
+      int num_threads = HermesCommonApi.get_integral_param_value(numThreads);
 
-        if(node->type == HERMES_TYPE_VERTEX)
+      // The keys are gathered by the threads from consecutive id ranges, in the order of the ids.
+      int* vertex_starts = calloc_with_check<int>(num_threads + 1);
+      int* edge_starts = calloc_with_check<int>(num_threads + 1);
+      int* vertex_keys = nullptr, *edge_keys = nullptr;
+
+#pragma omp parallel num_threads(num_threads)
+      {
+        int thread_number = omp_get_thread_num();
+        int used_threads = omp_get_num_threads();
+        int start = (int)((long long)max_node_id * thread_number / used_threads);
+        int end = (int)((long long)max_node_id * (thread_number + 1) / used_threads);
+
+        for (int id = start; id < end; id++)
         {
-          node->next_hash = v_table[idx];
-          v_table[idx] = node;
+          Node* node = &nodes[id];
+          // Top-level vertex nodes have no parents.
+          if (!node->used || node->p1 < 0 || node->p2 < 0)
+            continue;
+          if (node->type == HERMES_TYPE_VERTEX)
+            vertex_starts[thread_number + 1]++;
+          else
+            edge_starts[thread_number + 1]++;
         }
-        else
+
+#pragma omp barrier
+#pragma omp single
+        {
+          for (int thread_i = 0; thread_i < used_threads; thread_i++)
+          {
+            vertex_starts[thread_i + 1] += vertex_starts[thread_i];
+            edge_starts[thread_i + 1] += edge_starts[thread_i];
+          }
+          // p1s, p2s, ids.
+          vertex_keys = malloc_with_check<int>(3 * vertex_starts[used_threads] + 1);
+          edge_keys = malloc_with_check<int>(3 * edge_starts[used_threads] + 1);
+          vertex_starts[num_threads] = vertex_starts[used_threads];
+          edge_starts[num_threads] = edge_starts[used_threads];
+        }
+
+        int vertex_count = vertex_starts[num_threads], edge_count = edge_starts[num_threads];
+        int vertex_i = vertex_starts[thread_number], edge_i = edge_starts[thread_number];
+        for (int id = start; id < end; id++)
         {
-          node->next_hash = e_table[idx];
-          e_table[idx] = node;
+          Node* node = &nodes[id];
+          if (!node->used || node->p1 < 0 || node->p2 < 0)
+            continue;
+          int p1 = node->p1, p2 = node->p2;
+          if (p1 > p2) std::swap(p1, p2);
+
+          if (node->type == HERMES_TYPE_VERTEX)
+          {
+            vertex_keys[vertex_i] = p1;
+            vertex_keys[vertex_count + vertex_i] = p2;
+            vertex_keys[2 * vertex_count + vertex_i++] = id;
+          }
+          else
+          {
+            edge_keys[edge_i] = p1;
+            edge_keys[edge_count + edge_i] = p2;
+            edge_keys[2 * edge_count + edge_i++] = id;
+          }
         }
       }
+
+      int vertex_count = vertex_starts[num_threads], edge_count = edge_starts[num_threads];
+      v_table.insert(vertex_count, vertex_keys, vertex_keys + vertex_count, vertex_keys + 2 * vertex_count);
+      e_table.insert(edge_count, edge_keys, edge_keys + edge_count, edge_keys + 2 * edge_count);
+
+      free_with_check(vertex_starts);
+      free_with_check(edge_starts);
+      free_with_check(vertex_keys);
+      free_with_check(edge_keys);
     }
 
-    void HashTable::free()
+    void HashTable::set_search_plan(NodeSearchPlan* plan)
     {
-      nodes.free();
-      if(v_table != nullptr)
+      this->search_plan = plan;
+      plan->vertex_count = plan->max_vertex_count = v_table.get_count();
+      plan->edge_count = plan->max_edge_count = e_table.get_count();
+    }
+
+    void HashTable::unset_search_plan()
+    {
+      // The tables grow when they become half full (see NodeHashTable::insert()).
+      int vertex_capacity = v_table.get_capacity(), edge_capacity = e_table.get_capacity();
+      while (2 * this->search_plan->max_vertex_count > vertex_capacity)
+        vertex_capacity *= 2;
+      while (2 * this->search_plan->max_edge_count > edge_capacity)
+        edge_capacity *= 2;
+      this->search_plan = nullptr;
+
+      v_table.init(vertex_capacity / 2);
+      e_table.init(edge_capacity / 2);
+      this->insert_all_nodes();
+    }
+
+    int HashTable::find_planned_node(int p1, int p2, int type)
+    {
+      NodeSearchPlan* plan = this->search_plan;
+      int search = plan->next++;
+      plan->slot = plan->slots[search];
+
+      // The node found in advance may have been removed since (and its id reused).
+      int id = plan->found_ids[search];
+      if (id != -1)
       {
-        delete [] v_table;
-        v_table = nullptr;
+        Node* node = &nodes[id];
+        if (node->used && node->type == type && node->p1 == p1 && node->p2 == p2)
+          return id;
       }
-      if(e_table != nullptr)
+
+      if (plan->slot != -1 && plan->slot_ids[plan->slot] != -1)
       {
-        delete [] e_table;
-        e_table = nullptr;
+        id = plan->slot_ids[plan->slot];
+        if (nodes[id].p1 != p1 || nodes[id].p2 != p2)
+          throw Hermes::Exceptions::Exception("The node search plan does not match the searches of the refinement.");
+        return id;
       }
+
+      return -1;
     }
 
-    inline Node* HashTable::search_list(Node* node, int p1, int p2) const
+    void HashTable::add_planned_node(Node* node)
     {
-      while (node != nullptr)
-      {
-        if(node->p1 == p1 && node->p2 == p2)
-          return node;
-        node = node->next_hash;
-      }
-      return nullptr;
+      NodeSearchPlan* plan = this->search_plan;
+      if (plan->slot != -1)
+        plan->slot_ids[plan->slot] = node->id;
+
+      if (node->type == HERMES_TYPE_VERTEX)
+        plan->max_vertex_count = std::max(plan->max_vertex_count, ++plan->vertex_count);
+      else
+        plan->max_edge_count = std::max(plan->max_edge_count, ++plan->edge_count);
+    }
+
+    void HashTable::free()
+    {
+      nodes.free();
+      v_table.free();
+      e_table.free();
     }
 
     Node* HashTable::get_vertex_node(int p1, int p2)
     {
-      // search for the node in the vertex hashtable
+      // search for the node in the vertex hashtable (or in the search plan)
       if(p1 > p2) std::swap(p1, p2);
-      int i = hash(p1, p2);
-      Node* node = search_list(v_table[i], p1, p2);
-      if(node != nullptr) 
-        return node;
+      int id = this->search_plan ? this->find_planned_node(p1, p2, HERMES_TYPE_VERTEX) : v_table.find(p1, p2);
+      if(id != -1)
+        return &nodes[id];
 
       // not found - create a new_ one
       Node* newnode = nodes.add();
@@ -168,19 +485,21 @@ namespace Hermes
       newnode->y = (nodes[p1].y + nodes[p2].y) * 0.5;
 
       // insert into hashtable
-      newnode->next_hash = v_table[i];
-      v_table[i] = newnode;
+      if (this->search_plan)
+        this->add_planned_node(newnode);
+      else
+        v_table.insert(p1, p2, newnode->id);
 
       return newnode;
     }
 
     Node* HashTable::get_edge_node(int p1, int p2)
     {
-      // search for the node in the edge hashtable
+      // search for the node in the edge hashtable (or in the search plan)
       if(p1 > p2) std::swap(p1, p2);
-      int i = hash(p1, p2);
-      Node* node = search_list(e_table[i], p1, p2);
-      if(node != nullptr) return node;
+      int id = this->search_plan ? this->find_planned_node(p1, p2, HERMES_TYPE_EDGE) : e_table.find(p1, p2);
+      if(id != -1)
+        return &nodes[id];
 
       // not found - create a new_ one
       Node* newnode = nodes.add();
@@ -195,8 +514,10 @@ namespace Hermes
       newnode->elem[0] = newnode->elem[1] = nullptr;
 
       // insert into hashtable
-      newnode->next_hash = e_table[i];
-      e_table[i] = newnode;
+      if (this->search_plan)
+        this->add_planned_node(newnode);
+      else
+        e_table.insert(p1, p2, newnode->id);
 
       return newnode;
     }
@@ -204,31 +525,24 @@ namespace Hermes
     Node* HashTable::peek_vertex_node(int p1, int p2) const
     {
       if(p1 > p2) std::swap(p1, p2);
-      return search_list(v_table[hash(p1, p2)], p1, p2);
+      int id = v_table.find(p1, p2);
+      return (id == -1) ? nullptr : &nodes[id];
     }
 
     Node* HashTable::peek_edge_node(int p1, int p2) const
     {
       if(p1 > p2) std::swap(p1, p2);
-      return search_list(e_table[hash(p1, p2)], p1, p2);
+      int id = e_table.find(p1, p2);
+      return (id == -1) ? nullptr : &nodes[id];
     }
 
     void HashTable::remove_vertex_node(int id)
     {
       // remove the node from the hash table
-      int i = hash(nodes[id].p1, nodes[id].p2);
-      Node** ptr = v_table + i;
-      Node* node = *ptr;
-      while (node != nullptr)
-      {
-        if(node->id == id)
-        {
-          *ptr = node->next_hash;
-          break;
-        }
-        ptr = &node->next_hash;
-        node = *ptr;
-      }
+      if (this->search_plan)
+        this->search_plan->vertex_count--;
+      else
+        v_table.remove(nodes[id].p1, nodes[id].p2, id);
 
       // remove node from the array
       nodes.remove(id);
@@ -237,22 +551,13 @@ namespace Hermes
     void HashTable::remove_edge_node(int id)
     {
       // remove the node from the hash table
-      int i = hash(nodes[id].p1, nodes[id].p2);
-      Node** ptr = e_table + i;
-      Node* node = *ptr;
-      while (node != nullptr)
-      {
-        if(node->id == id)
-        {
-          *ptr = node->next_hash;
-          break;
-        }
-        ptr = &node->next_hash;
-        node = *ptr;
-      }
+      if (this->search_plan)
+        this->search_plan->edge_count--;
+      else
+        e_table.remove(nodes[id].p1, nodes[id].p2, id);
 
       // remove node from the array
       nodes.remove(id);
     }
   }
-}
\ No newline at end of file
+}
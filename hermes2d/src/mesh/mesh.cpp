@@ -31,13 +31,15 @@ namespace Hermes
     static const std::string H2D_DG_INNER_EDGE = "-54125631";
 
     Mesh::Mesh() : HashTable(), meshHashGrid(nullptr), nbase(0), nactive(0), ntopvert(0), ninitial(0), seq(g_mesh_seq++),
-      bounding_box_calculated(0)
+      geometry_cache(nullptr), bounding_box_calculated(0)
     {
     }
 
     Mesh::~Mesh()
     {
       free();
+      if (this->geometry_cache)
+        delete this->geometry_cache;
     }
 
     bool Mesh::isOkay() const
@@ -120,7 +122,6 @@ namespace Hermes
         node->type = HERMES_TYPE_VERTEX;
         node->bnd = 0;
         node->p1 = node->p2 = -1;
-        node->next_hash = nullptr;
         node->x = verts[i][0];
         node->y = verts[i][1];
       }
@@ -439,11 +440,6 @@ namespace Hermes
       sons[2] = create_triangle(e->marker, x2, x1, e->vn[2], cm[2]);
       sons[3] = create_triangle(e->marker, x1, x2, x0, cm[3]);
 
-      // update coefficients of curved reference mapping
-      for (int i = 0; i < 4; i++)
-      if (sons[i]->is_curved())
-        sons[i]->cm->update_refmap_coeffs(sons[i]);
-
       // deactivate this element and unregister from its nodes
       e->active = 0;
       this->nactive += 3;
@@ -644,14 +640,6 @@ namespace Hermes
       }
       else assert(0);
 
-      // update coefficients of curved reference mapping
-      for (i = 0; i < 4; i++)
-      if (sons[i])
-      {
-        if(sons[i]->cm)
-          sons[i]->cm->update_refmap_coeffs(sons[i]);
-      }
-
       // set pointers to parent element for sons
       for (int i = 0; i < 4; i++)
       if (sons[i] != nullptr)
@@ -722,6 +710,9 @@ namespace Hermes
     {
       this->refinements.push_back(std::pair<unsigned int, int>(e->id, refinement));
 
+      // An up-to-date hash grid is updated instead of being rebuilt.
+      bool update_hash_grid = this->meshHashGrid && this->meshHashGrid->get_mesh_seq() == this->seq;
+
       if (e->is_triangle())
       {
         if (refinement == 3)
@@ -740,6 +731,9 @@ namespace Hermes
           e->sons[i]->iro_cache = e->iro_cache;
 
       this->seq = g_mesh_seq++;
+
+      if (update_hash_grid)
+        this->meshHashGrid->element_refined(e, this->seq);
     }
 
     void Mesh::refine_element_id(int id, int refinement)
@@ -754,6 +748,43 @@ namespace Hermes
       this->refine_element(e, refinement);
     }
 
+    void Mesh::update_refmap_coeffs()
+    {
+      std::string exceptionMessageCaughtInParallelBlock;
+      int max_element_id = this->get_max_element_id();
+
+#pragma omp parallel for schedule(dynamic, 16) num_threads(HermesCommonApi.get_integral_param_value(numThreads))
+      for (int id = 0; id < max_element_id; id++)
+      {
+        if (!exceptionMessageCaughtInParallelBlock.empty())
+          continue;
+        Element* e = this->get_element_fast(id);
+        if (!e->used)
+          continue;
+        try
+        {
+          // update_refmap_coeffs() sets the iro_cache as well.
+          if (e->cm != nullptr && e->cm->toplevel)
+            e->cm->update_refmap_coeffs(e);
+          else
+            RefMap::set_element_iro_cache(e);
+        }
+        catch (Hermes::Exceptions::Exception& exception)
+        {
+#pragma omp critical (exceptionMessageCaughtInParallelBlock)
+          exceptionMessageCaughtInParallelBlock = exception.info();
+        }
+        catch (std::exception& exception)
+        {
+#pragma omp critical (exceptionMessageCaughtInParallelBlock)
+          exceptionMessageCaughtInParallelBlock = exception.what();
+        }
+      }
+
+      if (!exceptionMessageCaughtInParallelBlock.empty())
+        throw Hermes::Exceptions::Exception(exceptionMessageCaughtInParallelBlock.c_str());
+    }
+
     void Mesh::refine_all_elements(int refinement, bool mark_as_initial)
     {
       ninitial = this->get_max_element_id();
@@ -761,12 +792,97 @@ namespace Hermes
       if (refinement == -1)
         return;
 
+      // Every element changes, rebuilding the hash grid (when needed) is cheaper than updating it.
+      if (this->meshHashGrid)
+      {
+        delete this->meshHashGrid;
+        this->meshHashGrid = nullptr;
+      }
+
+      // Pre-size the arrays, every element gets (at most) four sons, the number of nodes grows (roughly) four times.
+      this->elements.reserve(this->get_max_element_id() + H2D_MAX_ELEMENT_SONS * this->nactive);
+      this->nodes.reserve(H2D_MAX_ELEMENT_SONS * this->get_max_node_id());
+
       elements.set_append_only(true);
 
-      Element* e;
+      // The elements are refined one by one in the order of their ids (so that all ids are identical to refining
+      // element by element). For the default refinement, the node searches of all elements are made in advance
+      // in parallel, the refinement itself does not search or update the node tables, they are rebuilt in parallel
+      // at the end. The projection of the curved reference mappings of the sons is done on their first use.
+      bool refined = false;
+      if (refinement == 0)
+      {
+        Hermes::vector<int> active_ids;
+        Element* e;
+        for_all_active_elements(e, this)
+          active_ids.push_back(e->id);
+        int count = active_ids.size();
+
+        NodeSearchPlan plan;
+        plan.found_ids = malloc_with_check<int>(H2D_MAX_REFINEMENT_NODE_SEARCHES * count);
+        plan.slots = malloc_with_check<int>(H2D_MAX_REFINEMENT_NODE_SEARCHES * count);
+        plan.slot_ids = nullptr;
+
+        bool planned = true;
+#pragma omp parallel for schedule(dynamic, 256) reduction(&&: planned) num_threads(HermesCommonApi.get_integral_param_value(numThreads))
+        for (int k = 0; k < count; k++)
+          planned = this->plan_node_searches(this->get_element_fast(active_ids[k]), plan.found_ids + H2D_MAX_REFINEMENT_NODE_SEARCHES * k,
+          plan.slots + H2D_MAX_REFINEMENT_NODE_SEARCHES * k) && planned;
+
+        if (planned)
+        {
+          // Three slots (the mid-edge vertex node, the edge nodes of the halves) for every edge node, four (the edge
+          // nodes inside) for every element.
+          int slot_count = 3 * this->get_max_node_id() + H2D_MAX_ELEMENT_SONS * this->get_max_element_id();
+          plan.slot_ids = malloc_with_check<int>(slot_count);
+          memset(plan.slot_ids, 0xff, slot_count * sizeof(int));
+
+          this->set_search_plan(&plan);
+          try
+          {
+            for (int k = 0; k < count; k++)
+            {
+              e = this->get_element_fast(active_ids[k]);
+              plan.next = H2D_MAX_REFINEMENT_NODE_SEARCHES * k;
+              // The mid-edge (and mid-element) vertex nodes, the edge nodes of the sons.
+              int searches = e->get_nvert() + (e->is_quad() ? 1 : 0) + H2D_MAX_ELEMENT_SONS * e->get_nvert();
+              refine_element(e, 0);
+              if (plan.next != H2D_MAX_REFINEMENT_NODE_SEARCHES * k + searches)
+                throw Hermes::Exceptions::Exception("The node search plan does not match the searches of the refinement.");
+            }
+          }
+          catch (...)
+          {
+            this->unset_search_plan();
+            free_with_check(plan.found_ids);
+            free_with_check(plan.slots);
+            free_with_check(plan.slot_ids);
+            elements.set_append_only(false);
+            throw;
+          }
+          this->unset_search_plan();
+          refined = true;
+        }
 
-      for_all_active_elements(e, this)
-        refine_element(e, refinement);
+        free_with_check(plan.found_ids);
+        free_with_check(plan.slots);
+        free_with_check(plan.slot_ids);
+      }
+
+      if (!refined)
+      {
+        try
+        {
+          Element* e;
+          for_all_active_elements(e, this)
+            refine_element(e, refinement);
+        }
+        catch (...)
+        {
+          elements.set_append_only(false);
+          throw;
+        }
+      }
 
       elements.set_append_only(false);
 
@@ -774,6 +890,82 @@ namespace Hermes
         ninitial = this->get_max_element_id();
     }
 
+    // The vertices of the searches of refine_quad(e, 0) and refine_triangle_to_triangles(e), in their order: 0 - 3 the
+    // vertices of e, 4 + i the mid-edge vertex of the edge i, 8 the mid-element vertex of a quad.
+    static const int quad_son_vertices[H2D_MAX_ELEMENT_SONS][4] = { { 0, 4, 8, 7 }, { 4, 1, 5, 8 }, { 8, 5, 2, 6 }, { 7, 8, 6, 3 } };
+    static const int triangle_son_vertices[H2D_MAX_ELEMENT_SONS][3] = { { 0, 4, 6 }, { 4, 1, 5 }, { 6, 5, 2 }, { 5, 6, 4 } };
+
+    bool Mesh::plan_node_searches(Element* e, int* found_ids, int* slots) const
+    {
+      int nvert = e->get_nvert();
+
+      // Ids of the vertices of the searches, -1 if the node does not exist yet.
+      int ids[9];
+      for (int i = 0; i < 9; i++)
+        ids[i] = (i < nvert) ? e->vn[i]->id : -1;
+
+      int search = 0;
+
+      // The mid-edge vertex nodes exist (hanging nodes), or the first of e and the neighbor sharing the edge creates them.
+      for (int i = 0; i < nvert; i++)
+      {
+        Node* node = this->peek_vertex_node(ids[i], ids[e->next_vert(i)]);
+        ids[4 + i] = found_ids[search] = node ? node->id : -1;
+        slots[search++] = node ? -1 : 3 * e->en[i]->id;
+      }
+
+      // The mid-element vertex node is new.
+      if (nvert == 4)
+      {
+        if (ids[4] != -1 && ids[6] != -1 && this->peek_vertex_node(ids[4], ids[6]))
+          return false;
+        found_ids[search] = slots[search] = -1;
+        search++;
+      }
+
+      for (int son = 0; son < H2D_MAX_ELEMENT_SONS; son++)
+      {
+        const int* son_vertices = (nvert == 4) ? quad_son_vertices[son] : triangle_son_vertices[son];
+        for (int i = 0; i < nvert; i++)
+        {
+          int a = son_vertices[i], b = son_vertices[(i + 1) % nvert];
+          found_ids[search] = slots[search] = -1;
+
+          // A half of an edge of e.
+          if (a < 4 || b < 4)
+          {
+            int vertex = std::min(a, b), mid_edge = std::max(a, b);
+            int edge = mid_edge - 4;
+            if (ids[mid_edge] == -1)
+            {
+              // Shared with the neighbor, the halves are told apart by the order of the vertex ids of the edge.
+              int other_vertex = (vertex == edge) ? e->next_vert(edge) : edge;
+              slots[search] = 3 * e->en[edge]->id + ((ids[vertex] < ids[other_vertex]) ? 1 : 2);
+            }
+            else
+            {
+              // Exists if the neighbor is refined, it may be removed by the refinement of the neighbor's son first.
+              Node* node = this->peek_edge_node(ids[vertex], ids[mid_edge]);
+              found_ids[search] = node ? node->id : -1;
+            }
+          }
+          // An edge inside e is new, shared by two sons.
+          else
+          {
+            if (ids[a] != -1 && ids[b] != -1 && this->peek_edge_node(ids[a], ids[b]))
+              return false;
+            // Quad: the edge from the mid-element vertex, triangle: the edge opposite to a mid-edge vertex.
+            int inner_edge = (nvert == 4) ? std::min(a, b) - 4 : 11 - a - b;
+            slots[search] = 3 * this->get_max_node_id() + H2D_MAX_ELEMENT_SONS * e->id + inner_edge;
+          }
+
+          search++;
+        }
+      }
+
+      return true;
+    }
+
     static int rtb_marker;
     static bool rtb_aniso;
     static char* rtb_vert;
@@ -993,8 +1185,16 @@ namespace Hermes
       if (e->sons[i] != nullptr)
         unrefine_element_id(e->sons[i]->id);
 
+      // An up-to-date hash grid is updated instead of being rebuilt.
+      bool update_hash_grid = this->meshHashGrid && this->meshHashGrid->get_mesh_seq() == this->seq;
+      if (update_hash_grid)
+        this->meshHashGrid->element_sons_to_be_removed(e);
+
       unrefine_element_internal(e);
       seq = g_mesh_seq++;
+
+      if (update_hash_grid)
+        this->meshHashGrid->element_unrefined(e, seq);
     }
 
     void Mesh::unrefine_all_elements(bool keep_initial_refinements)
@@ -1140,9 +1340,16 @@ namespace Hermes
 
       this->refinements = mesh->refinements;
 
-      Element* e;
-      for_all_used_elements(e, this)
+      // Pointer fix-up: all elements and nodes are independent of each other.
+      int num_threads = HermesCommonApi.get_integral_param_value(numThreads);
+      int max_element_id = this->get_max_element_id();
+#pragma omp parallel for num_threads(num_threads) private(i)
+      for (int id = 0; id < max_element_id; id++)
       {
+        Element* e = this->get_element_fast(id);
+        if (!e->used)
+          continue;
+
         // update vertex node pointers
         for (i = 0; i < e->get_nvert(); i++)
           e->vn[i] = &nodes[e->vn[i]->id];
@@ -1175,11 +1382,18 @@ namespace Hermes
       }
 
       // update element pointers in edge nodes
-      Node* node;
-      for_all_edge_nodes(node, this)
-      for (i = 0; i < 2; i++)
-      if (node->elem[i] != nullptr)
-        node->elem[i] = &elements[node->elem[i]->id];
+      int max_node_id = this->get_max_node_id();
+#pragma omp parallel for num_threads(num_threads) private(i)
+      for (int id = 0; id < max_node_id; id++)
+      {
+        Node* node = this->get_node(id);
+        if (node->used && node->type == HERMES_TYPE_EDGE)
+        {
+          for (i = 0; i < 2; i++)
+          if (node->elem[i] != nullptr)
+            node->elem[i] = &elements[node->elem[i]->id];
+        }
+      }
 
       nbase = mesh->nbase;
       nactive = mesh->nactive;
@@ -1266,7 +1480,10 @@ namespace Hermes
       HashTable::free();
 
       if (this->meshHashGrid)
+      {
         delete this->meshHashGrid;
+        this->meshHashGrid = nullptr;
+      }
 
       this->boundary_markers_conversion.conversion_table.clear();
       this->boundary_markers_conversion.conversion_table_inverse.clear();
@@ -1298,6 +1515,22 @@ namespace Hermes
       return this->meshHashGrid->getElement(x, y);
     }
 
+    void Mesh::set_geometry_cache(bool enabled, unsigned long max_memory_size)
+    {
+      if (this->geometry_cache)
+      {
+        delete this->geometry_cache;
+        this->geometry_cache = nullptr;
+      }
+      if (enabled)
+        this->geometry_cache = new RefMapCache(this, max_memory_size);
+    }
+
+    RefMapCache* Mesh::get_geometry_cache() const
+    {
+      return this->geometry_cache;
+    }
+
     double Mesh::get_marker_area(int marker)
     {
       std::map<int, MarkerArea*>::iterator area = marker_areas.find(marker);
@@ -1653,11 +1886,6 @@ namespace Hermes
       sons[1] = this->create_quad(e->marker, x0, e->vn[1], x1, mid, cm[1]);
       sons[2] = this->create_quad(e->marker, x1, e->vn[2], x2, mid, cm[2]);
 
-      // update coefficients of curved reference mapping
-      for (int i = 0; i < 3; i++)
-      if (sons[i]->is_curved())
-        sons[i]->cm->update_refmap_coeffs(sons[i]);
-
       // deactivate this element and unregister from its nodes
       e->active = 0;
       if (this != nullptr)
@@ -1823,14 +2051,6 @@ namespace Hermes
         sons[3] = nullptr;
       }
 
-      // update coefficients of curved reference mapping
-      for (int i = 0; i < 2; i++)
-      {
-        if (sons[i]->is_curved())
-        {
-          sons[i]->cm->update_refmap_coeffs(sons[i]);
-        }
-      }
       nactive += 2;
       // now the original edge nodes may no longer exist...
       // set correct boundary status and markers for the new_ nodes
@@ -2404,11 +2624,6 @@ namespace Hermes
       }
       else assert(0);
 
-      // update coefficients of curved reference mapping
-      for (i = 0; i < 4; i++)
-      if (sons[i] != nullptr && sons[i]->cm != nullptr)
-        sons[i]->cm->update_refmap_coeffs(sons[i]);
-
       //set pointers to parent element for sons
       for (int i = 0; i < 4; i++)
       if (sons[i] != nullptr)
@@ -73,7 +73,6 @@ namespace Hermes
           node->type = HERMES_TYPE_VERTEX;
           node->bnd = 0;
           node->p1 = node->p2 = -1;
-          node->next_hash = nullptr;
 
           // variables matching.
           std::string x = parsed_xml_mesh->v().at(vertices_i % vertices_count).x();
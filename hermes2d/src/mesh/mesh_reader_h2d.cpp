@@ -199,7 +199,6 @@ namespace Hermes
         node->type = HERMES_TYPE_VERTEX;
         node->bnd = 0;
         node->p1 = node->p2 = -1;
-        node->next_hash = nullptr;
         node->x = m.x_vertex[i];
         node->y = m.y_vertex[i];
       }
@@ -340,13 +339,7 @@ namespace Hermes
       }
 
       // update refmap coeffs of curvilinear elements
-      Element* e;
-      for_all_used_elements(e, mesh)
-      {
-        if (e->cm != nullptr)
-          e->cm->update_refmap_coeffs(e);
-        RefMap::set_element_iro_cache(e);
-      }
+      mesh->update_refmap_coeffs();
 
       //// refinements /////////////////////////////////////////////////////////////
       if(m.n_ref > 0)
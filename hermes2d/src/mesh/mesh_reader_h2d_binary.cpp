@@ -0,0 +1,627 @@
+// This file is part of Hermes2D
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, see <http://www.gnu.prg/licenses/>.
+
+#include "mesh_reader_h2d_binary.h"
+#include "binary_file.h"
+#include "mesh.h"
+#include "api2d.h"
+
+using namespace std;
+
+namespace Hermes
+{
+  namespace Hermes2D
+  {
+    /// Values of the element curvature flag.
+    enum
+    {
+      H2D_BINARY_NOT_CURVED = 0,
+      H2D_BINARY_CURVED_TOPLEVEL = 1,
+      H2D_BINARY_CURVED_SON = 2
+    };
+
+    /// Values of the curve type flag (toplevel curved elements, per edge).
+    enum
+    {
+      H2D_BINARY_NO_CURVE = 0,
+      H2D_BINARY_ARC = 1
+    };
+
+    MeshReaderH2DBinary::MeshReaderH2DBinary()
+    {
+    }
+
+    MeshReaderH2DBinary::~MeshReaderH2DBinary()
+    {
+    }
+
+    static void save_markers(BinaryFileWriter& writer, const Mesh::MarkersConversion& markers_conversion, int max_marker)
+    {
+      Hermes::vector<int> internal_markers;
+      Hermes::vector<int> lengths;
+      std::string characters;
+      for (int marker = 0; marker <= max_marker; marker++)
+      {
+        Mesh::MarkersConversion::StringValid user_marker = markers_conversion.get_user_marker(marker);
+        if (!user_marker.valid)
+          continue;
+        internal_markers.push_back(marker);
+        lengths.push_back(user_marker.marker.length());
+        characters.append(user_marker.marker);
+      }
+
+      writer.write(internal_markers.empty() ? nullptr : &internal_markers[0], internal_markers.size());
+      writer.write(lengths.empty() ? nullptr : &lengths[0], lengths.size());
+      writer.write_string(characters);
+    }
+
+    static void load_markers(const char* filename, BinaryFileReader& reader, Hermes::vector<std::pair<int, std::string> >& markers)
+    {
+      uint64_t count;
+      const int* internal_markers = reader.read<int>(count);
+      const int* lengths = reader.read<int>(count, "marker lengths");
+      std::string characters = reader.read_string();
+
+      int position = 0;
+      for (uint64_t i = 0; i < count; i++)
+      {
+        if (lengths[i] < 0 || position + lengths[i] > (int)characters.length())
+          throw Exceptions::MeshLoadFailureException("Binary mesh file %s: wrong length of marker %d.", filename, internal_markers[i]);
+        markers.push_back(std::pair<int, std::string>(internal_markers[i], characters.substr(position, lengths[i])));
+        position += lengths[i];
+      }
+    }
+
+    /// Throws if id is not the id of a used item (node or element) of the file.
+    static void check_id(const char* filename, int id, int count, const char* used, const char* what)
+    {
+      if (id < 0 || id >= count || !used[id])
+        throw Exceptions::MeshLoadFailureException("Binary mesh file %s: %s %d does not exist.", filename, what, id);
+    }
+
+    /// Throws if the node id does not refer to a used node of the given type.
+    static void check_node_id(const char* filename, int id, int count, const char* used, const char* type, int expected_type, const char* what)
+    {
+      check_id(filename, id, count, used, what);
+      if (type[id] != expected_type)
+        throw Exceptions::MeshLoadFailureException("Binary mesh file %s: %s %d has a wrong type.", filename, what, id);
+    }
+
+    void MeshReaderH2DBinary::save(const char *filename, MeshSharedPtr mesh)
+    {
+      BinaryFileWriter writer(filename, HERMES_BINARY_MESH);
+
+      // Mesh data.
+      int mesh_data[5] = { mesh->get_hash_size(), mesh->nbase, mesh->ntopvert, mesh->ninitial, mesh->nactive };
+      writer.write(mesh_data, 5);
+
+      // Nodes //
+      int node_count = mesh->get_max_node_id();
+      char* node_used = calloc_with_check<char>(node_count);
+      char* node_type = calloc_with_check<char>(node_count);
+      char* node_bnd = calloc_with_check<char>(node_count);
+      int* node_ref = calloc_with_check<int>(node_count);
+      int* node_parents = calloc_with_check<int>(2 * node_count);
+      double* node_coordinates = calloc_with_check<double>(2 * node_count);
+      int* node_marker = calloc_with_check<int>(node_count);
+      int* node_elements = calloc_with_check<int>(2 * node_count);
+
+      for (int id = 0; id < node_count; id++)
+      {
+        Node* node = &mesh->nodes[id];
+        node_elements[2 * id] = node_elements[2 * id + 1] = -1;
+        if (!node->used)
+          continue;
+        node_used[id] = 1;
+        node_type[id] = node->type;
+        node_bnd[id] = node->bnd;
+        node_ref[id] = node->ref;
+        node_parents[2 * id] = node->p1;
+        node_parents[2 * id + 1] = node->p2;
+        if (node->type == HERMES_TYPE_VERTEX)
+        {
+          node_coordinates[2 * id] = node->x;
+          node_coordinates[2 * id + 1] = node->y;
+        }
+        else
+        {
+          node_marker[id] = node->marker;
+          for (int i = 0; i < 2; i++)
+            if (node->elem[i])
+              node_elements[2 * id + i] = node->elem[i]->id;
+        }
+      }
+
+      writer.write(node_used, node_count);
+      writer.write(node_type, node_count);
+      writer.write(node_bnd, node_count);
+      writer.write(node_ref, node_count);
+      writer.write(node_parents, 2 * node_count);
+      writer.write(node_coordinates, 2 * node_count);
+      writer.write(node_marker, node_count);
+      writer.write(node_elements, 2 * node_count);
+
+      free_with_check(node_used);
+      free_with_check(node_type);
+      free_with_check(node_bnd);
+      free_with_check(node_ref);
+      free_with_check(node_parents);
+      free_with_check(node_coordinates);
+      free_with_check(node_marker);
+      free_with_check(node_elements);
+
+      // Elements //
+      int element_count = mesh->get_max_element_id();
+      char* element_used = calloc_with_check<char>(element_count);
+      char* element_active = calloc_with_check<char>(element_count);
+      char* element_nvert = calloc_with_check<char>(element_count);
+      char* element_curved = calloc_with_check<char>(element_count);
+      int* element_marker = calloc_with_check<int>(element_count);
+      int* element_parent = calloc_with_check<int>(element_count);
+      int* element_iro_cache = calloc_with_check<int>(element_count);
+      int* element_vertices = calloc_with_check<int>(H2D_MAX_NUMBER_VERTICES * element_count);
+      int* element_edges_or_sons = calloc_with_check<int>(H2D_MAX_NUMBER_EDGES * element_count);
+      double* element_area = calloc_with_check<double>(element_count);
+      double* element_diameter = calloc_with_check<double>(element_count);
+
+      // Curvilinear mappings.
+      Hermes::vector<int> cm_orders, cm_coeff_counts, cm_parents;
+      Hermes::vector<uint64_t> cm_sub_idxs;
+      Hermes::vector<double> cm_coeffs;
+      Hermes::vector<char> curve_types;
+      Hermes::vector<double> arc_angles, arc_points;
+
+      int max_element_marker = 0;
+      for (int id = 0; id < element_count; id++)
+      {
+        Element* e = mesh->get_element_fast(id);
+        element_parent[id] = -1;
+        for (int i = 0; i < H2D_MAX_NUMBER_VERTICES; i++)
+          element_vertices[H2D_MAX_NUMBER_VERTICES * id + i] = element_edges_or_sons[H2D_MAX_NUMBER_EDGES * id + i] = -1;
+        if (!e->used)
+          continue;
+
+        element_used[id] = 1;
+        element_active[id] = e->active;
+        element_nvert[id] = e->get_nvert();
+        element_marker[id] = e->marker;
+        max_element_marker = std::max(max_element_marker, e->marker);
+        element_iro_cache[id] = e->iro_cache;
+        element_area[id] = e->area;
+        element_diameter[id] = e->diameter;
+        if (e->parent)
+          element_parent[id] = e->parent->id;
+
+        for (unsigned int i = 0; i < e->get_nvert(); i++)
+          element_vertices[H2D_MAX_NUMBER_VERTICES * id + i] = e->vn[i]->id;
+
+        if (e->active)
+        {
+          for (unsigned int i = 0; i < e->get_nvert(); i++)
+            element_edges_or_sons[H2D_MAX_NUMBER_EDGES * id + i] = e->en[i]->id;
+        }
+        else
+        {
+          for (int i = 0; i < H2D_MAX_ELEMENT_SONS; i++)
+            if (e->sons[i])
+              element_edges_or_sons[H2D_MAX_NUMBER_EDGES * id + i] = e->sons[i]->id;
+        }
+
+        if (e->cm)
+        {
+          CurvMap* cm = e->cm;
+          element_curved[id] = cm->toplevel ? H2D_BINARY_CURVED_TOPLEVEL : H2D_BINARY_CURVED_SON;
+          cm_orders.push_back(cm->order);
+          cm_coeff_counts.push_back(cm->coeffs ? cm->nc : 0);
+          if (cm->coeffs)
+          {
+            for (int i = 0; i < cm->nc; i++)
+            {
+              cm_coeffs.push_back(cm->coeffs[i][0]);
+              cm_coeffs.push_back(cm->coeffs[i][1]);
+            }
+          }
+
+          if (cm->toplevel)
+          {
+            for (int i = 0; i < H2D_MAX_NUMBER_EDGES; i++)
+            {
+              if (cm->curves[i] == nullptr)
+                curve_types.push_back(H2D_BINARY_NO_CURVE);
+              else if (cm->curves[i]->type == ArcType)
+              {
+                Arc* arc = (Arc*)cm->curves[i];
+                curve_types.push_back(H2D_BINARY_ARC);
+                arc_angles.push_back(arc->angle);
+                for (int point_i = 0; point_i < Arc::np; point_i++)
+                  for (int j = 0; j < 3; j++)
+                    arc_points.push_back(arc->pt[point_i][j]);
+              }
+              else
+                throw Exceptions::Exception("Binary mesh format can not operate with general NURBS so far.");
+            }
+          }
+          else
+          {
+            cm_parents.push_back(cm->parent->id);
+            cm_sub_idxs.push_back(cm->sub_idx);
+          }
+        }
+      }
+
+      writer.write(element_used, element_count);
+      writer.write(element_active, element_count);
+      writer.write(element_nvert, element_count);
+      writer.write(element_curved, element_count);
+      writer.write(element_marker, element_count);
+      writer.write(element_parent, element_count);
+      writer.write(element_iro_cache, element_count);
+      writer.write(element_vertices, H2D_MAX_NUMBER_VERTICES * element_count);
+      writer.write(element_edges_or_sons, H2D_MAX_NUMBER_EDGES * element_count);
+      writer.write(element_area, element_count);
+      writer.write(element_diameter, element_count);
+
+      free_with_check(element_used);
+      free_with_check(element_active);
+      free_with_check(element_nvert);
+      free_with_check(element_curved);
+      free_with_check(element_marker);
+      free_with_check(element_parent);
+      free_with_check(element_iro_cache);
+      free_with_check(element_vertices);
+      free_with_check(element_edges_or_sons);
+      free_with_check(element_area);
+      free_with_check(element_diameter);
+
+      writer.write(cm_orders.empty() ? nullptr : &cm_orders[0], cm_orders.size());
+      writer.write(cm_coeff_counts.empty() ? nullptr : &cm_coeff_counts[0], cm_coeff_counts.size());
+      writer.write(cm_coeffs.empty() ? nullptr : &cm_coeffs[0], cm_coeffs.size());
+      writer.write(cm_parents.empty() ? nullptr : &cm_parents[0], cm_parents.size());
+      writer.write(cm_sub_idxs.empty() ? nullptr : &cm_sub_idxs[0], cm_sub_idxs.size());
+      writer.write(curve_types.empty() ? nullptr : &curve_types[0], curve_types.size());
+      writer.write(arc_angles.empty() ? nullptr : &arc_angles[0], arc_angles.size());
+      writer.write(arc_points.empty() ? nullptr : &arc_points[0], arc_points.size());
+
+      // Markers //
+      int max_boundary_marker = 0;
+      Node* node;
+      for_all_edge_nodes(node, mesh)
+        max_boundary_marker = std::max(max_boundary_marker, node->marker);
+      save_markers(writer, mesh->element_markers_conversion, std::max(max_element_marker, mesh->element_markers_conversion.size()));
+      save_markers(writer, mesh->boundary_markers_conversion, std::max(max_boundary_marker, mesh->boundary_markers_conversion.size()));
+
+      // Refinements //
+      Hermes::vector<int> refinement_ids, refinement_types;
+      for (unsigned int refinement_i = 0; refinement_i < mesh->refinements.size(); refinement_i++)
+      {
+        refinement_ids.push_back(mesh->refinements[refinement_i].first);
+        refinement_types.push_back(mesh->refinements[refinement_i].second);
+      }
+      writer.write(refinement_ids.empty() ? nullptr : &refinement_ids[0], refinement_ids.size());
+      writer.write(refinement_types.empty() ? nullptr : &refinement_types[0], refinement_types.size());
+
+      writer.close();
+    }
+
+    void MeshReaderH2DBinary::load(const char *filename, MeshSharedPtr mesh)
+    {
+      if (!mesh)
+        throw Exceptions::NullException(1);
+
+      mesh->free();
+
+      BinaryFileReader reader(filename, HERMES_BINARY_MESH);
+
+      // Mesh data.
+      const int* mesh_data = reader.read<int>(5, "mesh data");
+      mesh->init(mesh_data[0]);
+      mesh->nbase = mesh_data[1];
+      mesh->ntopvert = mesh_data[2];
+      mesh->ninitial = mesh_data[3];
+      mesh->nactive = mesh_data[4];
+
+      // Nodes //
+      uint64_t count;
+      const char* node_used = reader.read<char>(count);
+      int node_count = (int)count;
+      const char* node_type = reader.read<char>(node_count, "node types");
+      const char* node_bnd = reader.read<char>(node_count, "node boundary flags");
+      const int* node_ref = reader.read<int>(node_count, "node references");
+      const int* node_parents = reader.read<int>(2 * node_count, "node parents");
+      const double* node_coordinates = reader.read<double>(2 * node_count, "node coordinates");
+      const int* node_marker = reader.read<int>(node_count, "node markers");
+      const int* node_elements = reader.read<int>(2 * node_count, "node elements");
+
+      // The references are checked before anything is built.
+      for (int id = 0; id < node_count; id++)
+      {
+        if (!node_used[id])
+          continue;
+        if (node_type[id] != HERMES_TYPE_VERTEX && node_type[id] != HERMES_TYPE_EDGE)
+          throw Exceptions::MeshLoadFailureException("Binary mesh file %s: node %d has an unknown type.", filename, id);
+        for (int i = 0; i < 2; i++)
+        {
+          if (node_parents[2 * id + i] < -1 || node_parents[2 * id + i] >= node_count)
+            throw Exceptions::MeshLoadFailureException("Binary mesh file %s: parent %d of node %d out of range.", filename, node_parents[2 * id + i], id);
+        }
+      }
+
+      mesh->nodes.reserve(node_count);
+      for (int id = 0; id < node_count; id++)
+      {
+        Node* node = mesh->nodes.add();
+        assert(node->id == id);
+        node->type = node_type[id];
+        node->bnd = node_bnd[id];
+        node->ref = node_ref[id];
+        node->p1 = node_parents[2 * id];
+        node->p2 = node_parents[2 * id + 1];
+        if (node->type == HERMES_TYPE_VERTEX)
+        {
+          node->x = node_coordinates[2 * id];
+          node->y = node_coordinates[2 * id + 1];
+        }
+        else
+          node->marker = node_marker[id];
+      }
+
+      // Elements //
+      const char* element_used = reader.read<char>(count);
+      int element_count = (int)count;
+      const char* element_active = reader.read<char>(element_count, "element activity");
+      const char* element_nvert = reader.read<char>(element_count, "element vertex counts");
+      const char* element_curved = reader.read<char>(element_count, "element curvature");
+      const int* element_marker = reader.read<int>(element_count, "element markers");
+      const int* element_parent = reader.read<int>(element_count, "element parents");
+      const int* element_iro_cache = reader.read<int>(element_count, "element iro cache");
+      const int* element_vertices = reader.read<int>(H2D_MAX_NUMBER_VERTICES * element_count, "element vertices");
+      const int* element_edges_or_sons = reader.read<int>(H2D_MAX_NUMBER_EDGES * element_count, "element edges");
+      const double* element_area = reader.read<double>(element_count, "element areas");
+      const double* element_diameter = reader.read<double>(element_count, "element diameters");
+
+      for (int id = 0; id < node_count; id++)
+      {
+        if (!node_used[id] || node_type[id] != HERMES_TYPE_EDGE)
+          continue;
+        for (int i = 0; i < 2; i++)
+        {
+          if (node_elements[2 * id + i] != -1)
+            check_id(filename, node_elements[2 * id + i], element_count, element_used, "element");
+        }
+      }
+
+      for (int id = 0; id < element_count; id++)
+      {
+        if (!element_used[id])
+          continue;
+        int nvert = element_nvert[id];
+        if (nvert != 3 && nvert != 4)
+          throw Exceptions::MeshLoadFailureException("Binary mesh file %s: element %d has %d vertices.", filename, id, nvert);
+        if (element_marker[id] < 0)
+          throw Exceptions::MeshLoadFailureException("Binary mesh file %s: element %d has a negative marker.", filename, id);
+        if (element_curved[id] != H2D_BINARY_NOT_CURVED && element_curved[id] != H2D_BINARY_CURVED_TOPLEVEL && element_curved[id] != H2D_BINARY_CURVED_SON)
+          throw Exceptions::MeshLoadFailureException("Binary mesh file %s: element %d has an unknown curvature flag.", filename, id);
+        if (element_parent[id] != -1)
+          check_id(filename, element_parent[id], element_count, element_used, "element");
+        for (int i = 0; i < nvert; i++)
+          check_node_id(filename, element_vertices[H2D_MAX_NUMBER_VERTICES * id + i], node_count, node_used, node_type, HERMES_TYPE_VERTEX, "vertex node");
+        if (element_active[id])
+        {
+          for (int i = 0; i < nvert; i++)
+            check_node_id(filename, element_edges_or_sons[H2D_MAX_NUMBER_EDGES * id + i], node_count, node_used, node_type, HERMES_TYPE_EDGE, "edge node");
+        }
+        else
+        {
+          for (int i = 0; i < H2D_MAX_ELEMENT_SONS; i++)
+          {
+            if (element_edges_or_sons[H2D_MAX_NUMBER_EDGES * id + i] != -1)
+              check_id(filename, element_edges_or_sons[H2D_MAX_NUMBER_EDGES * id + i], element_count, element_used, "element");
+          }
+        }
+      }
+
+      mesh->elements.reserve(element_count);
+      for (int id = 0; id < element_count; id++)
+      {
+        Element* e = mesh->elements.add();
+        assert(e->id == id);
+        e->active = element_active[id];
+        e->nvert = element_nvert[id];
+        e->marker = element_marker[id];
+        e->iro_cache = element_iro_cache[id];
+        e->area = element_area[id];
+        e->diameter = element_diameter[id];
+        e->visited = false;
+        e->center_set = false;
+        e->cm = nullptr;
+      }
+
+      // Pointer fix-up (all nodes and elements exist now).
+      for (int id = 0; id < node_count; id++)
+      {
+        Node* node = &mesh->nodes[id];
+        if (node_used[id] && node->type == HERMES_TYPE_EDGE)
+        {
+          for (int i = 0; i < 2; i++)
+            node->elem[i] = node_elements[2 * id + i] == -1 ? nullptr : mesh->get_element_fast(node_elements[2 * id + i]);
+        }
+      }
+
+      for (int id = 0; id < element_count; id++)
+      {
+        if (!element_used[id])
+          continue;
+        Element* e = mesh->get_element_fast(id);
+        e->parent = element_parent[id] == -1 ? nullptr : mesh->get_element_fast(element_parent[id]);
+        for (unsigned int i = 0; i < e->get_nvert(); i++)
+          e->vn[i] = &mesh->nodes[element_vertices[H2D_MAX_NUMBER_VERTICES * id + i]];
+        if (e->active)
+        {
+          for (unsigned int i = 0; i < e->get_nvert(); i++)
+            e->en[i] = &mesh->nodes[element_edges_or_sons[H2D_MAX_NUMBER_EDGES * id + i]];
+        }
+        else
+        {
+          for (int i = 0; i < H2D_MAX_ELEMENT_SONS; i++)
+          {
+            int son_id = element_edges_or_sons[H2D_MAX_NUMBER_EDGES * id + i];
+            e->sons[i] = son_id == -1 ? nullptr : mesh->get_element_fast(son_id);
+          }
+        }
+      }
+
+      // Curvilinear mappings //
+      uint64_t cm_count;
+      const int* cm_orders = reader.read<int>(cm_count);
+      const int* cm_coeff_counts = reader.read<int>(cm_count, "curved map coefficient counts");
+      uint64_t coeffs_count, son_cm_count, curve_count, arc_count;
+      const double* cm_coeffs = reader.read<double>(coeffs_count);
+      const int* cm_parents = reader.read<int>(son_cm_count);
+      const uint64_t* cm_sub_idxs = reader.read<uint64_t>(son_cm_count, "curved map sub-element indices");
+      const char* curve_types = reader.read<char>(curve_count);
+      const double* arc_angles = reader.read<double>(arc_count);
+      const double* arc_points = reader.read<double>(arc_count * Arc::np * 3, "arc control points");
+
+      int cm_i = 0, coeff_i = 0, son_cm_i = 0, curve_i = 0, arc_i = 0;
+      for (int id = 0; id < element_count; id++)
+      {
+        if (!element_used[id] || element_curved[id] == H2D_BINARY_NOT_CURVED)
+          continue;
+        Element* e = mesh->get_element_fast(id);
+
+        if (cm_i >= (int)cm_count)
+          throw Exceptions::MeshLoadFailureException("Binary mesh file %s: missing curved map of element %d.", filename, id);
+        if (cm_orders[cm_i] < 0 || cm_orders[cm_i] > H2D_MAX_ORDER)
+          throw Exceptions::MeshLoadFailureException("Binary mesh file %s: curved map of element %d has order %d.", filename, id, cm_orders[cm_i]);
+        if (cm_coeff_counts[cm_i] < 0 || coeff_i + 2 * (uint64_t)cm_coeff_counts[cm_i] > coeffs_count)
+          throw Exceptions::MeshLoadFailureException("Binary mesh file %s: wrong coefficient count of the curved map of element %d.", filename, id);
+        if (element_curved[id] == H2D_BINARY_CURVED_TOPLEVEL)
+        {
+          if (curve_i + H2D_MAX_NUMBER_EDGES > (int)curve_count)
+            throw Exceptions::MeshLoadFailureException("Binary mesh file %s: missing curves of element %d.", filename, id);
+          for (int i = 0, element_arc_i = arc_i; i < H2D_MAX_NUMBER_EDGES; i++)
+          {
+            char curve_type = curve_types[curve_i + i];
+            if (curve_type != H2D_BINARY_NO_CURVE && curve_type != H2D_BINARY_ARC)
+              throw Exceptions::MeshLoadFailureException("Binary mesh file %s: unknown curve type on edge %d of element %d.", filename, i, id);
+            if (curve_type == H2D_BINARY_ARC && (i >= element_nvert[id] || element_arc_i++ >= (int)arc_count))
+              throw Exceptions::MeshLoadFailureException("Binary mesh file %s: wrong curve on edge %d of element %d.", filename, i, id);
+          }
+        }
+        else
+        {
+          if (son_cm_i >= (int)son_cm_count)
+            throw Exceptions::MeshLoadFailureException("Binary mesh file %s: missing parent of the curved map of element %d.", filename, id);
+          check_id(filename, cm_parents[son_cm_i], element_count, element_used, "element");
+          // The curves of the son are taken from the parent.
+          if (element_curved[cm_parents[son_cm_i]] != H2D_BINARY_CURVED_TOPLEVEL)
+            throw Exceptions::MeshLoadFailureException("Binary mesh file %s: parent %d of the curved map of element %d is not curved.", filename, cm_parents[son_cm_i], id);
+        }
+
+        CurvMap* cm = new CurvMap;
+        cm->order = cm_orders[cm_i];
+        cm->nc = cm_coeff_counts[cm_i];
+        if (cm->nc > 0)
+        {
+          cm->coeffs = malloc_with_check<double2>(cm->nc, true);
+          memcpy(cm->coeffs, cm_coeffs + coeff_i, cm->nc * sizeof(double2));
+          coeff_i += 2 * cm->nc;
+        }
+        cm_i++;
+
+        if (element_curved[id] == H2D_BINARY_CURVED_TOPLEVEL)
+        {
+          cm->toplevel = true;
+          for (int i = 0; i < H2D_MAX_NUMBER_EDGES; i++)
+          {
+            if (curve_types[curve_i++] == H2D_BINARY_ARC)
+            {
+              Arc* arc = new Arc(arc_angles[arc_i]);
+              memcpy(arc->pt, arc_points + arc_i * Arc::np * 3, Arc::np * sizeof(double3));
+              cm->curves[i] = arc;
+              arc_i++;
+            }
+          }
+        }
+        else
+        {
+          cm->toplevel = false;
+          cm->parent = mesh->get_element_fast(cm_parents[son_cm_i]);
+          cm->sub_idx = cm_sub_idxs[son_cm_i];
+          son_cm_i++;
+        }
+
+        e->cm = cm;
+      }
+
+      // Unused items are removed after all the items have their ids.
+      for (int id = 0; id < node_count; id++)
+        if (!node_used[id])
+          mesh->nodes.remove(id);
+      for (int id = 0; id < element_count; id++)
+        if (!element_used[id])
+          mesh->elements.remove(id);
+
+      mesh->rebuild();
+
+      // Markers //
+      Hermes::vector<std::pair<int, std::string> > markers;
+      load_markers(filename, reader, markers);
+      for (unsigned int i = 0; i < markers.size(); i++)
+      {
+        mesh->element_markers_conversion.conversion_table.insert(markers[i]);
+        mesh->element_markers_conversion.conversion_table_inverse.insert(std::pair<std::string, int>(markers[i].second, markers[i].first));
+        mesh->element_markers_conversion.min_marker_unused = std::max(mesh->element_markers_conversion.min_marker_unused, markers[i].first + 1);
+      }
+      markers.clear();
+      load_markers(filename, reader, markers);
+      for (unsigned int i = 0; i < markers.size(); i++)
+      {
+        mesh->boundary_markers_conversion.conversion_table.insert(markers[i]);
+        mesh->boundary_markers_conversion.conversion_table_inverse.insert(std::pair<std::string, int>(markers[i].second, markers[i].first));
+        mesh->boundary_markers_conversion.min_marker_unused = std::max(mesh->boundary_markers_conversion.min_marker_unused, markers[i].first + 1);
+      }
+
+      // All markers of the elements and of the boundary edges have their user markers.
+      for (int id = 0; id < element_count; id++)
+      {
+        if (element_used[id] && !mesh->element_markers_conversion.get_user_marker(element_marker[id]).valid)
+          throw Exceptions::MeshLoadFailureException("Binary mesh file %s: unknown marker %d of element %d.", filename, element_marker[id], id);
+      }
+      for (int id = 0; id < node_count; id++)
+      {
+        if (node_used[id] && node_type[id] == HERMES_TYPE_EDGE && node_bnd[id] && !mesh->boundary_markers_conversion.get_user_marker(node_marker[id]).valid)
+          throw Exceptions::MeshLoadFailureException("Binary mesh file %s: unknown marker %d of boundary edge %d.", filename, node_marker[id], id);
+      }
+
+      // Refinements //
+      uint64_t refinement_count;
+      const int* refinement_ids = reader.read<int>(refinement_count);
+      const int* refinement_types = reader.read<int>(refinement_count, "refinement types");
+      for (uint64_t refinement_i = 0; refinement_i < refinement_count; refinement_i++)
+      {
+        if (refinement_ids[refinement_i] < 0 || refinement_ids[refinement_i] >= element_count)
+          throw Exceptions::MeshLoadFailureException("Binary mesh file %s: refined element %d out of range.", filename, refinement_ids[refinement_i]);
+      }
+      for (uint64_t refinement_i = 0; refinement_i < refinement_count; refinement_i++)
+        mesh->refinements.push_back(std::pair<unsigned int, int>(refinement_ids[refinement_i], refinement_types[refinement_i]));
+
+      mesh->seq = g_mesh_seq++;
+
+      if (HermesCommonApi.get_integral_param_value(checkMeshesOnLoad))
+        mesh->initial_single_check();
+    }
+  }
+}
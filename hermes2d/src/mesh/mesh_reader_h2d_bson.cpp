@@ -101,7 +101,6 @@ namespace Hermes
         node->type = HERMES_TYPE_VERTEX;
         node->bnd = 0;
         node->p1 = node->p2 = -1;
-        node->next_hash = nullptr;
         node->x = vertex_xes[vertex_i];
         node->y = vertex_yes[vertex_i];
       }
@@ -304,12 +303,7 @@ namespace Hermes
       }
 
       // update refmap coeffs of curvilinear elements
-      for_all_used_elements(e, mesh)
-      {
-        if (e->cm != nullptr)
-          e->cm->update_refmap_coeffs(e);
-        RefMap::set_element_iro_cache(e);
-      }
+      mesh->update_refmap_coeffs();
 
       delete [] p1s;
       delete [] p2s;
@@ -866,7 +860,6 @@ namespace Hermes
             node->type = HERMES_TYPE_VERTEX;
             node->bnd = 0;
             node->p1 = node->p2 = -1;
-            node->next_hash = nullptr;
 
             // assignment.
             node->x = vertices[vertex_number].x;
@@ -1028,12 +1021,7 @@ namespace Hermes
           }
 
           // update refmap coeffs of curvilinear elements
-          for_all_used_elements(e, meshes[subdomains_i])
-          {
-            if (e->cm != nullptr)
-              e->cm->update_refmap_coeffs(e);
-            RefMap::set_element_iro_cache(e);
-          }
+          meshes[subdomains_i]->update_refmap_coeffs();
 
           // refinements.
           if(!subdomains.at(subdomains_i).refinements.empty() && subdomains.at(subdomains_i).refinements.size() > 0)
@@ -1138,7 +1126,6 @@ namespace Hermes
         node->type = HERMES_TYPE_VERTEX;
         node->bnd = 0;
         node->p1 = node->p2 = -1;
-        node->next_hash = nullptr;
 
         if(vertices[vertex_i].i > H2D_MAX_NODE_ID - 1)
           throw Exceptions::MeshLoadFailureException("The index 'i' of vertex in the mesh file must be lower than %i.", H2D_MAX_NODE_ID);
@@ -1258,12 +1245,7 @@ namespace Hermes
       }
 
       // update refmap coeffs of curvilinear elements
-      for_all_used_elements(e, mesh)
-      {
-        if (e->cm != nullptr)
-          e->cm->update_refmap_coeffs(e);
-        RefMap::set_element_iro_cache(e);
-      }
+      mesh->update_refmap_coeffs();
     }
   }
 }
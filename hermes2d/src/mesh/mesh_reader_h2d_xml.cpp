@@ -303,7 +303,6 @@ namespace Hermes
               node->type = HERMES_TYPE_VERTEX;
               node->bnd = 0;
               node->p1 = node->p2 = -1;
-              node->next_hash = nullptr;
 
               // variables matching.
               std::string x = parsed_xml_domain->vertices().v().at(vertex_number).x();
@@ -522,12 +521,7 @@ namespace Hermes
             }
 
             // update refmap coeffs of curvilinear elements
-            for_all_used_elements(e, meshes[subdomains_i])
-            {
-              if (e->cm != nullptr)
-                e->cm->update_refmap_coeffs(e);
-              RefMap::set_element_iro_cache(e);
-            }
+            meshes[subdomains_i]->update_refmap_coeffs();
 
             // refinements.
             if (parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements().present() && parsed_xml_domain->subdomains().subdomain().at(subdomains_i).refinements()->ref().size() > 0)
@@ -775,7 +769,6 @@ namespace Hermes
           node->type = HERMES_TYPE_VERTEX;
           node->bnd = 0;
           node->p1 = node->p2 = -1;
-          node->next_hash = nullptr;
 
           // variables matching.
           std::string x = parsed_xml_mesh->vertices().v().at(vertex_i).x();
@@ -925,12 +918,7 @@ namespace Hermes
         }
 
         // update refmap coeffs of curvilinear elements
-        for_all_used_elements(e, mesh)
-        {
-          if (e->cm != nullptr)
-            e->cm->update_refmap_coeffs(e);
-          RefMap::set_element_iro_cache(e);
-        }
+        mesh->update_refmap_coeffs();
       }
       catch (const xml_schema::exception& e)
       {
@@ -1003,7 +991,6 @@ namespace Hermes
           node->type = HERMES_TYPE_VERTEX;
           node->bnd = 0;
           node->p1 = node->p2 = -1;
-          node->next_hash = nullptr;
 
           // variables matching.
           std::string x = parsed_xml_domain->vertices().v().at(vertex_i).x();
@@ -163,85 +163,139 @@ namespace Hermes
       return curve;
     }
 
+    /// Number of segments each edge of a curvilinear element is sampled with in MeshHashGrid::elementBoundingBox().
+    static const int H2D_BOUNDING_BOX_EDGE_SEGMENTS = 8;
+
+    /// Number of quadtree levels split serially in the MeshHashGrid constructor, the subtrees are then built in parallel.
+    static const int H2D_MESH_HASH_GRID_SERIAL_LEVELS = 3;
+
     MeshHashGrid::MeshHashGrid(Mesh* mesh) : mesh_seq(mesh->get_seq())
     {
-      mesh->calc_bounding_box();
-
-      // create grid
-      double interval_len_x = (mesh->top_right_x - mesh->bottom_left_x) / GRID_SIZE;
-      double interval_len_y = (mesh->top_right_y - mesh->bottom_left_y) / GRID_SIZE;
+      // bounding boxes of all active elements
+      Hermes::vector<MeshHashGridElement::Item> items;
+      items.reserve(mesh->get_num_active_elements());
+      Element *element;
+      for_all_active_elements(element, mesh)
+      {
+        MeshHashGridElement::Item item;
+        item.element = element;
+        items.push_back(item);
+      }
 
-      intervals_x[0] = mesh->bottom_left_x;
-      intervals_y[0] = mesh->bottom_left_y;
+      int item_count = items.size();
+#pragma omp parallel for num_threads(HermesCommonApi.get_integral_param_value(numThreads))
+      for (int i = 0; i < item_count; i++)
+        elementBoundingBox(items[i].element, items[i].p1, items[i].p2);
 
-      for (int i = 1; i < GRID_SIZE; i++)
+      // the root covers all the boxes (curvilinear elements may reach out of the bounding box of the vertices)
+      double2 p1 = { std::numeric_limits<double>::max(), std::numeric_limits<double>::max() };
+      double2 p2 = { -std::numeric_limits<double>::max(), -std::numeric_limits<double>::max() };
+      for (int i = 0; i < item_count; i++)
       {
-        intervals_x[i] = intervals_x[i - 1] + interval_len_x;
-        intervals_y[i] = intervals_y[i - 1] + interval_len_y;
+        p1[0] = std::min(p1[0], items[i].p1[0]);
+        p1[1] = std::min(p1[1], items[i].p1[1]);
+        p2[0] = std::max(p2[0], items[i].p2[0]);
+        p2[1] = std::max(p2[1], items[i].p2[1]);
       }
 
-      intervals_x[GRID_SIZE] = mesh->top_right_x;
-      intervals_y[GRID_SIZE] = mesh->top_right_y;
+      MeshHashGridElement::Item empty_item;
+      empty_item.element = nullptr;
+      this->inserted_items.assign(mesh->get_max_element_id(), empty_item);
+      for (int i = 0; i < item_count; i++)
+        this->inserted_items[items[i].element->id] = items[i];
 
-      for (int i = 0; i < GRID_SIZE; i++)
+      this->root = new MeshHashGridElement(p1[0], p1[1], p2[0], p2[1]);
+      this->root->items.swap(items);
+
+      // split the top levels serially
+      Hermes::vector<MeshHashGridElement*> subtrees;
+      subtrees.push_back(this->root);
+      for (int level = 0; level < H2D_MESH_HASH_GRID_SERIAL_LEVELS; level++)
       {
-        for (int j = 0; j < GRID_SIZE; j++)
+        Hermes::vector<MeshHashGridElement*> next_subtrees;
+        for (unsigned int subtree_i = 0; subtree_i < subtrees.size(); subtree_i++)
         {
-          m_grid[i][j] = new MeshHashGridElement(intervals_x[i], intervals_y[j], intervals_x[i + 1], intervals_y[j + 1]);
+          MeshHashGridElement* subtree = subtrees[subtree_i];
+          if (subtree->needs_split() && subtree->split(false))
+          {
+            for (int i = 0; i < 2; i++)
+            for (int j = 0; j < 2; j++)
+              next_subtrees.push_back(subtree->m_sons[i][j]);
+          }
+          else
+            next_subtrees.push_back(subtree);
         }
+        subtrees.swap(next_subtrees);
       }
 
-      // assign elements
-      Element *element;
-      double2 p1, p2;
-      int x_min, x_max, y_min, y_max;
-      for_all_active_elements(element, mesh)
+      // build the subtrees in parallel
+      int subtree_count = subtrees.size();
+#pragma omp parallel for schedule(dynamic) num_threads(HermesCommonApi.get_integral_param_value(numThreads))
+      for (int subtree_i = 0; subtree_i < subtree_count; subtree_i++)
       {
-        elementBoundingBox(element, p1, p2);
-
-        x_min = 0;
-        while (intervals_x[x_min + 1] < p1[0])
-          x_min++;
-
-        x_max = GRID_SIZE - 1;
-        while (intervals_x[x_max] > p2[0])
-          x_max--;
+        if (subtrees[subtree_i]->needs_split())
+          subtrees[subtree_i]->split(true);
+      }
+    }
 
-        y_min = 0;
-        while (intervals_y[y_min + 1] < p1[1])
-          y_min++;
+    MeshHashGrid::~MeshHashGrid()
+    {
+      delete this->root;
+    }
 
-        y_max = GRID_SIZE - 1;
-        while (intervals_y[y_max] > p2[1])
-          y_max--;
+    void MeshHashGrid::insert(Element* e)
+    {
+      MeshHashGridElement::Item item;
+      item.element = e;
+      elementBoundingBox(e, item.p1, item.p2);
+      if (e->id >= (int)this->inserted_items.size())
+      {
+        MeshHashGridElement::Item empty_item;
+        empty_item.element = nullptr;
+        this->inserted_items.resize(e->id + 1, empty_item);
+      }
+      this->inserted_items[e->id] = item;
+      this->root->insert(item);
+    }
 
-        assert((x_max >= x_min) && (y_max >= y_min));
+    void MeshHashGrid::remove(Element* e)
+    {
+      if (e->id >= (int)this->inserted_items.size() || this->inserted_items[e->id].element != e)
+        return;
+      this->root->remove(this->inserted_items[e->id]);
+      this->inserted_items[e->id].element = nullptr;
+    }
 
-        for (int i = x_min; i <= x_max; i++)
-        {
-          for (int j = y_min; j <= y_max; j++)
-          {
-            assert(m_grid[i][j]->belongs(element));
-            m_grid[i][j]->insert(element);
-          }
-        }
+    void MeshHashGrid::element_refined(Element* e, int mesh_seq)
+    {
+      this->remove(e);
+      for (int i = 0; i < H2D_MAX_ELEMENT_SONS; i++)
+      {
+        if (e->sons[i] != nullptr)
+          this->insert(e->sons[i]);
       }
+
+      this->mesh_seq = mesh_seq;
     }
 
-    MeshHashGrid::~MeshHashGrid()
+    void MeshHashGrid::element_sons_to_be_removed(Element* e)
     {
-      for (int i = 0; i < GRID_SIZE; i++)
+      for (int i = 0; i < H2D_MAX_ELEMENT_SONS; i++)
       {
-        for (int j = 0; j < GRID_SIZE; j++)
-        {
-          delete m_grid[i][j];
-        }
+        if (e->sons[i] != nullptr)
+          this->remove(e->sons[i]);
       }
     }
 
-    MeshHashGridElement::MeshHashGridElement(double lower_left_x, double lower_left_y, double upper_right_x, double upper_right_y, int depth) : lower_left_x(lower_left_x), lower_left_y(lower_left_y), upper_right_x(upper_right_x), upper_right_y(upper_right_y), m_depth(depth), m_active(true), element_count(0)
+    void MeshHashGrid::element_unrefined(Element* e, int mesh_seq)
+    {
+      this->insert(e);
+
+      this->mesh_seq = mesh_seq;
+    }
+
+    MeshHashGridElement::MeshHashGridElement(double lower_left_x, double lower_left_y, double upper_right_x, double upper_right_y, int depth) : lower_left_x(lower_left_x), lower_left_y(lower_left_y), upper_right_x(upper_right_x), upper_right_y(upper_right_y), m_depth(depth), m_active(true), m_unsplittable(false)
     {
-      this->elements = new Element*[MAX_ELEMENTS];
       for (int i = 0; i < 2; i++)
       for (int j = 0; j < 2; j++)
         m_sons[i][j] = nullptr;
@@ -249,100 +303,175 @@ namespace Hermes
 
     MeshHashGridElement::~MeshHashGridElement()
     {
-      if (elements)
-        delete[] elements;
       for (int i = 0; i < 2; i++)
       for (int j = 0; j < 2; j++)
       if (m_sons[i][j])
         delete m_sons[i][j];
     }
 
-    bool MeshHashGridElement::belongs(Element *element)
+    bool MeshHashGridElement::belongs(const Item& item) const
     {
-      double2 p1, p2;
-      MeshHashGrid::elementBoundingBox(element, p1, p2);
-      return ((p1[0] <= upper_right_x) && (p2[0] >= lower_left_x) && (p1[1] <= upper_right_y) && (p2[1] >= lower_left_y));
+      return ((item.p1[0] <= upper_right_x) && (item.p2[0] >= lower_left_x) && (item.p1[1] <= upper_right_y) && (item.p2[1] >= lower_left_y));
     }
 
-    void MeshHashGridElement::insert(Element *element)
+    bool MeshHashGridElement::needs_split() const
     {
-      if (m_active)
-      {
-        elements[element_count++] = element;
+      return (this->items.size() > MAX_ELEMENTS) && (m_depth < MAX_DEPTH) && !m_unsplittable;
+    }
+
+    bool MeshHashGridElement::split(bool recursive)
+    {
+      double xx[3] = { lower_left_x, (lower_left_x + upper_right_x) / 2., upper_right_x };
+      double yy[3] = { lower_left_y, (lower_left_y + upper_right_y) / 2., upper_right_y };
 
-        if ((element_count >= MAX_ELEMENTS) && (m_depth < MAX_DEPTH))
+      bool progress = false;
+      for (int i = 0; i < 2; i++)
+      {
+        for (int j = 0; j < 2; j++)
         {
-          m_active = false;
-          double xx[3] = { lower_left_x, (lower_left_x + upper_right_x) / 2., upper_right_x };
-          double yy[3] = { lower_left_y, (lower_left_y + upper_right_y) / 2., upper_right_y };
-          for (int i = 0; i < 2; i++)
+          m_sons[i][j] = new MeshHashGridElement(xx[i], yy[j], xx[i + 1], yy[j + 1], m_depth + 1);
+          for (unsigned int item_i = 0; item_i < this->items.size(); item_i++)
           {
-            double x0 = xx[i];
-            double x1 = xx[i + 1];
-            for (int j = 0; j < 2; j++)
-            {
-              double y0 = yy[j];
-              double y1 = yy[j + 1];
+            if (m_sons[i][j]->belongs(this->items[item_i]))
+              m_sons[i][j]->items.push_back(this->items[item_i]);
+          }
+          if (m_sons[i][j]->items.size() < this->items.size())
+            progress = true;
+        }
+      }
+
+      // all the boxes overlap the whole leaf, splitting would only multiply the items
+      if (!progress)
+      {
+        for (int i = 0; i < 2; i++)
+        for (int j = 0; j < 2; j++)
+        {
+          delete m_sons[i][j];
+          m_sons[i][j] = nullptr;
+        }
+        m_unsplittable = true;
+        return false;
+      }
 
-              assert(m_sons[i][j] == nullptr);
+      m_active = false;
+      Hermes::vector<Item>().swap(this->items);
 
-              m_sons[i][j] = new MeshHashGridElement(x0, y0, x1, y1, m_depth + 1);
+      if (recursive)
+      {
+        for (int i = 0; i < 2; i++)
+        for (int j = 0; j < 2; j++)
+        if (m_sons[i][j]->needs_split())
+          m_sons[i][j]->split(true);
+      }
 
-              for (int elem_i = 0; elem_i < this->element_count; elem_i++)
-              {
-                if (m_sons[i][j]->belongs(elements[elem_i]))
-                  m_sons[i][j]->insert(elements[elem_i]);
-              }
-            }
-          }
+      return true;
+    }
+
+    void MeshHashGridElement::insert(const Item& item)
+    {
+      if (m_active)
+      {
+        this->items.push_back(item);
 
-          delete[] elements;
-          elements = nullptr;
+        // an item missing one of the sons makes the split worthwhile again
+        if (m_unsplittable)
+        {
+          double middle_x = (lower_left_x + upper_right_x) / 2.;
+          double middle_y = (lower_left_y + upper_right_y) / 2.;
+          if (item.p1[0] > middle_x || item.p2[0] < middle_x || item.p1[1] > middle_y || item.p2[1] < middle_y)
+            m_unsplittable = false;
         }
+
+        if (this->needs_split())
+          this->split(true);
       }
       else
       {
         for (int i = 0; i < 2; i++)
+        for (int j = 0; j < 2; j++)
+        if (m_sons[i][j]->belongs(item))
+          m_sons[i][j]->insert(item);
+      }
+    }
+
+    void MeshHashGridElement::remove(const Item& item)
+    {
+      if (m_active)
+      {
+        for (unsigned int item_i = 0; item_i < this->items.size(); item_i++)
         {
-          for (int j = 0; j < 2; j++)
+          if (this->items[item_i].element == item.element)
           {
-            assert(m_sons[i][j]);
-            if (m_sons[i][j]->belongs(element))
-              m_sons[i][j]->insert(element);
+            this->items[item_i] = this->items.back();
+            this->items.pop_back();
+            break;
           }
         }
+        return;
+      }
+
+      bool leaf_sons = true;
+      unsigned int son_items = 0;
+      for (int i = 0; i < 2; i++)
+      {
+        for (int j = 0; j < 2; j++)
+        {
+          if (m_sons[i][j]->belongs(item))
+            m_sons[i][j]->remove(item);
+          leaf_sons = leaf_sons && m_sons[i][j]->m_active;
+          son_items += m_sons[i][j]->items.size();
+        }
       }
+
+      // coarsened region, merge the sons back
+      if (leaf_sons && son_items <= MAX_ELEMENTS / 2)
+        merge_sons();
     }
 
-    bool MeshHashGridElement::belongs(double x, double y)
+    void MeshHashGridElement::merge_sons()
     {
-      return (x >= lower_left_x) && (x <= upper_right_x) && (y <= lower_left_y) && (y >= upper_right_y);
+      for (int i = 0; i < 2; i++)
+      {
+        for (int j = 0; j < 2; j++)
+        {
+          // items overlapping more sons are stored in each of them
+          for (unsigned int son_item_i = 0; son_item_i < m_sons[i][j]->items.size(); son_item_i++)
+          {
+            const Item& son_item = m_sons[i][j]->items[son_item_i];
+            bool found = false;
+            for (unsigned int item_i = 0; item_i < this->items.size() && !found; item_i++)
+              found = (this->items[item_i].element == son_item.element);
+            if (!found)
+              this->items.push_back(son_item);
+          }
+          delete m_sons[i][j];
+          m_sons[i][j] = nullptr;
+        }
+      }
+      m_active = true;
     }
 
     Element* MeshHashGridElement::getElement(double x, double y)
     {
-      if (m_active)
+      MeshHashGridElement* node = this;
+      while (!node->m_active)
       {
-        for (int elem_i = 0; elem_i < this->element_count; elem_i++)
-        if (RefMap::is_element_on_physical_coordinates(elements[elem_i], x, y))
-          return elements[elem_i];
-
-        return nullptr;
+        int i = (x > (node->lower_left_x + node->upper_right_x) / 2.) ? 1 : 0;
+        int j = (y > (node->lower_left_y + node->upper_right_y) / 2.) ? 1 : 0;
+        node = node->m_sons[i][j];
       }
-      else
+
+      for (unsigned int item_i = 0; item_i < node->items.size(); item_i++)
       {
-        Element* element;
-        for (int i = 0; i < 2; i++)
-        {
-          for (int j = 0; j < 2; j++)
-          {
-            element = m_sons[i][j]->getElement(x, y);
-            if (element)
-              return element;
-          }
-        }
-        return nullptr;
+        const Item& item = node->items[item_i];
+        if (!item.element->active)
+          continue;
+        if (x >= item.p1[0] && x <= item.p2[0] && y >= item.p1[1] && y <= item.p2[1])
+        if (RefMap::is_element_on_physical_coordinates(item.element, x, y))
+          return item.element;
       }
+
+      return nullptr;
     }
 
     void MeshHashGrid::elementBoundingBox(Element *element, double2 &p1, double2 &p2)
@@ -366,32 +495,48 @@ namespace Hermes
 
       if (element->is_curved())
       {
-        // todo: should be improved
-        double diameter_x = p2[0] - p1[0];
-        p2[0] += diameter_x;
-        p1[0] -= diameter_x;
-
-        double diameter_y = p2[1] - p1[1];
-        p2[1] += diameter_y;
-        p1[1] -= diameter_y;
+        // sample the edges (all edges of refined curvilinear elements are curved)
+        int mode = element->get_mode();
+        double2 pt[H2D_MAX_NUMBER_EDGES * H2D_BOUNDING_BOX_EDGE_SEGMENTS];
+        int n = 0;
+        for (int edge = 0; edge < element->get_nvert(); edge++)
+        {
+          const double* a = CurvMap::ref_vert[mode][edge];
+          const double* b = CurvMap::ref_vert[mode][element->next_vert(edge)];
+          for (int i = 1; i < H2D_BOUNDING_BOX_EDGE_SEGMENTS; i++, n++)
+          {
+            double t = (double)i / H2D_BOUNDING_BOX_EDGE_SEGMENTS;
+            pt[n][0] = (1. - t) * a[0] + t * b[0];
+            pt[n][1] = (1. - t) * a[1] + t * b[1];
+          }
+        }
+        element->cm->get_mid_edge_points(element, pt, n);
+
+        for (int i = 0; i < n; i++)
+        {
+          p1[0] = std::min(p1[0], pt[i][0]);
+          p1[1] = std::min(p1[1], pt[i][1]);
+          p2[0] = std::max(p2[0], pt[i][0]);
+          p2[1] = std::max(p2[1], pt[i][1]);
+        }
+
+        // the sampling and the projection of the reference mapping are not exact
+        double margin_x = 0.1 * (p2[0] - p1[0]);
+        double margin_y = 0.1 * (p2[1] - p1[1]);
+        p1[0] -= margin_x;
+        p2[0] += margin_x;
+        p1[1] -= margin_y;
+        p2[1] += margin_y;
       }
     }
 
     Element* MeshHashGrid::getElement(double x, double y)
     {
-      int i = 0;
-      while ((i < GRID_SIZE) && (intervals_x[i + 1] < x))
-        i++;
-
-      int j = 0;
-      while ((j < GRID_SIZE) && (intervals_y[j + 1] < y))
-        j++;
-
       // this means that x or y is outside mesh, but it can hapen
-      if ((i >= GRID_SIZE) || (j >= GRID_SIZE))
+      if (x < root->lower_left_x || x > root->upper_right_x || y < root->lower_left_y || y > root->upper_right_y)
         return nullptr;
       else
-        return m_grid[i][j]->getElement(x, y);
+        return root->getElement(x, y);
     }
 
     int MeshHashGrid::get_mesh_seq() const
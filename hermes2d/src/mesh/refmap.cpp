@@ -21,7 +21,140 @@ namespace Hermes
 {
   namespace Hermes2D
   {
-    RefMap::RefMap() : ref_map_shapeset(H1ShapesetJacobi()), ref_map_pss(PrecalcShapeset(&ref_map_shapeset))
+    RefMapCache::RefMapCache(const Mesh* mesh, unsigned long max_memory_size) : mesh(mesh), mesh_seq(mesh->get_seq()),
+      buckets(nullptr), num_buckets(0), num_entries(0), memory_size(0), max_memory_size(max_memory_size)
+    {
+    }
+
+    RefMapCache::~RefMapCache()
+    {
+      this->free_entries();
+      free_with_check(this->buckets);
+    }
+
+    unsigned int RefMapCache::hash(int element_id, uint64_t sub_idx, int order, int type) const
+    {
+      uint64_t key = ((uint64_t)element_id * 0x9E3779B97F4A7C15ULL) ^ (sub_idx * 0xC2B2AE3D27D4EB4FULL) ^ ((uint64_t)(order * 8 + type + 2) * 0x165667B19E3779F9ULL);
+      return (unsigned int)(key ^ (key >> 32)) & (this->num_buckets - 1);
+    }
+
+    void RefMapCache::free_entries()
+    {
+      for (unsigned int i = 0; i < this->num_buckets; i++)
+      {
+        Entry* entry = this->buckets[i];
+        while (entry)
+        {
+          Entry* next = entry->next;
+          delete[] entry->data;
+          delete entry;
+          entry = next;
+        }
+        this->buckets[i] = nullptr;
+      }
+      this->num_entries = 0;
+      this->memory_size = this->num_buckets * sizeof(Entry*);
+    }
+
+    void RefMapCache::clear()
+    {
+      this->free_entries();
+      free_with_check(this->buckets);
+      this->num_buckets = 0;
+      this->memory_size = 0;
+    }
+
+    void RefMapCache::validate()
+    {
+      if (this->is_valid())
+        return;
+
+      this->clear();
+      this->mesh_seq = this->mesh->get_seq();
+
+      // A few entries per element.
+      this->num_buckets = 1024;
+      while (this->num_buckets < 4 * (unsigned int)this->mesh->get_max_element_id())
+        this->num_buckets *= 2;
+      this->buckets = calloc_with_check<Entry*>(this->num_buckets);
+      this->memory_size = this->num_buckets * sizeof(Entry*);
+    }
+
+    bool RefMapCache::is_valid() const
+    {
+      return this->buckets && this->mesh_seq == this->mesh->get_seq();
+    }
+
+    const double* RefMapCache::find(int element_id, uint64_t sub_idx, int order, int type) const
+    {
+      for (Entry* entry = this->buckets[this->hash(element_id, sub_idx, order, type)]; entry; entry = entry->next)
+      {
+        if (entry->element_id == element_id && entry->sub_idx == sub_idx && entry->order == order && entry->type == type)
+          return entry->data;
+      }
+      return nullptr;
+    }
+
+    RefMapCache::Entry* RefMapCache::create_entry(int element_id, uint64_t sub_idx, int order, int type, int size)
+    {
+      if (this->max_memory_size > 0)
+      {
+        bool full;
+#pragma omp critical (RefMapCacheInsert)
+        full = this->memory_size + sizeof(Entry) + size * sizeof(double) > this->max_memory_size;
+        if (full)
+          return nullptr;
+      }
+
+      Entry* entry = new Entry;
+      entry->element_id = element_id;
+      entry->sub_idx = sub_idx;
+      entry->order = order;
+      entry->type = type;
+      entry->next = nullptr;
+      entry->size = size;
+      entry->data = new double[size];
+      return entry;
+    }
+
+    void RefMapCache::insert(Entry* entry)
+    {
+      bool inserted = false;
+#pragma omp critical (RefMapCacheInsert)
+      {
+        // Other threads may have filled the cache since create_entry().
+        unsigned long entry_memory_size = sizeof(Entry) + entry->size * sizeof(double);
+        bool full = this->max_memory_size > 0 && this->memory_size + entry_memory_size > this->max_memory_size;
+        if (!full && !this->find(entry->element_id, entry->sub_idx, entry->order, entry->type))
+        {
+          Entry** bucket = this->buckets + this->hash(entry->element_id, entry->sub_idx, entry->order, entry->type);
+          entry->next = *bucket;
+          // The entry has to be complete before it is reachable by the lock-free readers.
+#pragma omp flush
+          *bucket = entry;
+          this->num_entries++;
+          this->memory_size += entry_memory_size;
+          inserted = true;
+        }
+      }
+      if (!inserted)
+      {
+        delete[] entry->data;
+        delete entry;
+      }
+    }
+
+    unsigned long RefMapCache::get_memory_size() const
+    {
+      return this->memory_size;
+    }
+
+    unsigned int RefMapCache::get_num_entries() const
+    {
+      return this->num_entries;
+    }
+
+    RefMap::RefMap() : ref_map_shapeset(H1ShapesetJacobi()), ref_map_pss(PrecalcShapeset(&ref_map_shapeset)), geometry_cache(nullptr)
     {
       quad_2d = nullptr;
       set_quad_2d(&g_quad_2d_std);
@@ -67,10 +200,21 @@ namespace Hermes
       this->reinit_storage();
     }
 
+    void RefMap::set_geometry_cache(RefMapCache* geometry_cache)
+    {
+      this->geometry_cache = geometry_cache;
+      this->reinit_storage();
+    }
+
     void RefMap::set_active_element(Element* e)
     {
       this->reinit_storage();
 
+      // The cache may be (re)allocated only outside the parallel regions, where it is validated before (see
+      // DiscreteProblem::init_assembling()); a stale cache is not used in a parallel region.
+      if (this->geometry_cache && !omp_in_parallel())
+        this->geometry_cache->validate();
+
       Transformable::set_active_element(e);
       ref_map_pss.set_active_element(e);
 
@@ -103,8 +247,7 @@ namespace Hermes
         memcpy(indices + k, ref_map_shapeset.get_bubble_indices(o, e->get_mode()),
           ref_map_shapeset.get_num_bubbles(o, e->get_mode()) * sizeof(int));
 
-        coeffs = e->cm->coeffs;
-        nc = e->cm->nc;
+        coeffs = e->cm->get_refmap_coeffs(e, nc);
       }
 
       this->inv_ref_order = this->element->iro_cache;
@@ -127,12 +270,11 @@ namespace Hermes
 #endif
         return;
       }
+      RefMap rm;
+      rm.set_active_element(element);
+      int iro = rm.calc_inv_ref_order();
 #pragma omp critical (element_iro_cache_setting)
-      {
-        RefMap rm;
-        rm.set_active_element(element);
-        element->iro_cache = rm.calc_inv_ref_order();
-      }
+      element->iro_cache = iro;
     }
 
     void RefMap::reinit_storage()
@@ -165,6 +307,21 @@ namespace Hermes
     {
       int i, j, np = quad_2d->get_num_points(order, element->get_mode());
 
+      bool use_cache = this->use_geometry_cache();
+      if (use_cache)
+      {
+        const double* cached = this->geometry_cache->find(element->id, sub_idx, order, RefMapCache::InverseRefMap);
+        if (cached)
+        {
+          memcpy(this->jacobian, cached, np * sizeof(double));
+          memcpy(this->jacobian_x_weights, cached + np, np * sizeof(double));
+          memcpy(this->inv_ref_map, cached + 2 * np, np * sizeof(double2x2));
+          this->inv_ref_map_calculated = order;
+          this->jacobian_calculated = order;
+          return;
+        }
+      }
+
       // construct jacobi matrices of the direct reference map for all integration points
       ref_map_pss.force_transform(sub_idx, ctm);
 
@@ -221,8 +378,24 @@ namespace Hermes
         jac[i] *= trj;
       }
 
+      double3* pt = quad_2d->get_points(order, element->get_mode());
+      for (i = 0; i < np; i++)
+        this->jacobian_x_weights[i] = pt[i][2] * jac[i];
+
       this->inv_ref_map_calculated = order;
       this->jacobian_calculated = order;
+
+      if (use_cache)
+      {
+        RefMapCache::Entry* entry = this->geometry_cache->create_entry(element->id, sub_idx, order, RefMapCache::InverseRefMap, 6 * np);
+        if (entry)
+        {
+          memcpy(entry->data, this->jacobian, np * sizeof(double));
+          memcpy(entry->data + np, this->jacobian_x_weights, np * sizeof(double));
+          memcpy(entry->data + 2 * np, this->inv_ref_map, np * sizeof(double2x2));
+          this->geometry_cache->insert(entry);
+        }
+      }
     }
 
     bool RefMap::is_parallelogram(Element* e)
@@ -255,6 +428,22 @@ namespace Hermes
     {
       // transform all x coordinates of the integration points
       int i, j, np = quad_2d->get_num_points(order, element->get_mode());
+
+      // With the cache, both coordinates are calculated and stored together.
+      bool use_cache = this->use_geometry_cache();
+      if (use_cache)
+      {
+        const double* cached = this->geometry_cache->find(element->id, sub_idx, order, RefMapCache::PhysicalCoordinates);
+        if (cached)
+        {
+          memcpy(this->phys_x, cached, np * sizeof(double));
+          memcpy(this->phys_y, cached + np, np * sizeof(double));
+          this->phys_x_calculated = order;
+          this->phys_y_calculated = order;
+          return;
+        }
+      }
+
       double* x = this->phys_x;
       memset(x, 0, np * sizeof(double));
       ref_map_pss.force_transform(sub_idx, ctm);
@@ -267,10 +456,31 @@ namespace Hermes
           x[j] += coeffs[i][0] * fn[j];
       }
       this->phys_x_calculated = order;
+
+      if (use_cache)
+      {
+        if (order != this->phys_y_calculated)
+          this->calc_phys_y(order);
+        RefMapCache::Entry* entry = this->geometry_cache->create_entry(element->id, sub_idx, order, RefMapCache::PhysicalCoordinates, 2 * np);
+        if (entry)
+        {
+          memcpy(entry->data, this->phys_x, np * sizeof(double));
+          memcpy(entry->data + np, this->phys_y, np * sizeof(double));
+          this->geometry_cache->insert(entry);
+        }
+      }
     }
 
     void RefMap::calc_phys_y(int order)
     {
+      // The cached coordinates are handled together in calc_phys_x().
+      if (this->use_geometry_cache() && order != this->phys_x_calculated)
+      {
+        this->calc_phys_x(order);
+        if (order == this->phys_y_calculated)
+          return;
+      }
+
       // transform all y coordinates of the integration points
       int i, j, np = quad_2d->get_num_points(order, element->get_mode());
       double* y = this->phys_y;
@@ -310,6 +520,18 @@ namespace Hermes
       }
       else
       {
+        bool use_cache = this->use_geometry_cache();
+        if (use_cache)
+        {
+          const double* cached = this->geometry_cache->find(element->id, sub_idx, eo, edge);
+          if (cached)
+          {
+            memcpy(tan, cached, np * sizeof(double3));
+            this->tan_calculated[edge] = eo;
+            return;
+          }
+        }
+
         // construct jacobi matrices of the direct reference map at integration points along the edge
         double2x2 m[15];
         assert(np <= 15);
@@ -347,6 +569,16 @@ namespace Hermes
           t[1] *= inorm;
           t[2] *= (edge == 0 || edge == 2) ? ctm->m[0] : ctm->m[1];
         }
+
+        if (use_cache)
+        {
+          RefMapCache::Entry* entry = this->geometry_cache->create_entry(element->id, sub_idx, eo, edge, 3 * np);
+          if (entry)
+          {
+            memcpy(entry->data, tan, np * sizeof(double3));
+            this->geometry_cache->insert(entry);
+          }
+        }
       }
 
       this->tan_calculated[edge] = eo;
@@ -537,6 +769,11 @@ namespace Hermes
 #endif
 
     void RefMap::untransform(Element* e, double x, double y, double& xi1, double& xi2)
+    {
+      untransform(e, 1, &x, &y, &xi1, &xi2);
+    }
+
+    void RefMap::untransform(Element* e, int count, const double* x, const double* y, double* xi1, double* xi2)
     {
       const double TOL = Hermes::HermesSqrtEpsilon;
 
@@ -574,15 +811,12 @@ namespace Hermes
         memcpy(local_indices + k, shapeset.get_bubble_indices(o, e->get_mode()),
           shapeset.get_num_bubbles(o, e->get_mode()) * sizeof(int));
 
-        local_coeffs = e->cm->coeffs;
-        local_nc = e->cm->nc;
+        local_coeffs = e->cm->get_refmap_coeffs(e, local_nc);
       }
 
       // Constant reference mapping.
       if (!e->is_curved() && (e->is_triangle() || is_parallelogram(e)))
       {
-        double dx = e->vn[0]->x - x;
-        double dy = e->vn[0]->y - y;
         int k = e->is_triangle() ? 2 : 3;
         double m[2][2] =
         {
@@ -602,52 +836,86 @@ namespace Hermes
         const_inv_ref_map[0][1] = -m[1][0] * ij;
         const_inv_ref_map[1][1] = m[0][0] * ij;
 
-        xi1 = -1.0 - (const_inv_ref_map[0][0] * dx + const_inv_ref_map[1][0] * dy);
-        xi2 = -1.0 - (const_inv_ref_map[0][1] * dx + const_inv_ref_map[1][1] * dy);
+        for (int p = 0; p < count; p++)
+        {
+          double dx = e->vn[0]->x - x[p];
+          double dy = e->vn[0]->y - y[p];
+          xi1[p] = -1.0 - (const_inv_ref_map[0][0] * dx + const_inv_ref_map[1][0] * dy);
+          xi2[p] = -1.0 - (const_inv_ref_map[0][1] * dx + const_inv_ref_map[1][1] * dy);
+        }
+        return;
       }
-      else
+
+      // The points are iterated in chunks, every shape function is evaluated for all unconverged points of the
+      // chunk in turn; a point leaves the iteration once it converges or gets far from the reference domain.
+      const int CHUNK_SIZE = 32;
+      int active[CHUNK_SIZE];
+      double xi1_old[CHUNK_SIZE], xi2_old[CHUNK_SIZE], vx[CHUNK_SIZE], vy[CHUNK_SIZE];
+      double2x2 tmp[CHUNK_SIZE];
+      for (int chunk_start = 0; chunk_start < count; chunk_start += CHUNK_SIZE)
       {
-        double xi1_old = 0.0, xi2_old = 0.0;
-        double vx, vy;
-        double2x2 m;
+        int num_active = std::min(CHUNK_SIZE, count - chunk_start);
+        for (int a = 0; a < num_active; a++)
+        {
+          active[a] = chunk_start + a;
+          xi1_old[a] = xi2_old[a] = 0.0;
+        }
+
         int it = 0; // number of Newton iterations
-        while (1)
+        while (num_active > 0)
         {
-          double2x2 tmp;
-          memset(tmp, 0, sizeof(double2x2));
-          vx = vy = 0;
+          memset(tmp, 0, num_active * sizeof(double2x2));
+          memset(vx, 0, num_active * sizeof(double));
+          memset(vy, 0, num_active * sizeof(double));
           for (int i = 0; i < local_nc; i++)
           {
-            double val = shapeset.get_fn_value(local_indices[i], xi1_old, xi2_old, 0, e->get_mode());
-            vx += local_coeffs[i][0] * val;
-            vy += local_coeffs[i][1] * val;
-
-            double dx = shapeset.get_dx_value(local_indices[i], xi1_old, xi2_old, 0, e->get_mode());
-            double dy = shapeset.get_dy_value(local_indices[i], xi1_old, xi2_old, 0, e->get_mode());
-            tmp[0][0] += local_coeffs[i][0] * dx;
-            tmp[0][1] += local_coeffs[i][0] * dy;
-            tmp[1][0] += local_coeffs[i][1] * dx;
-            tmp[1][1] += local_coeffs[i][1] * dy;
+            for (int a = 0; a < num_active; a++)
+            {
+              double val = shapeset.get_fn_value(local_indices[i], xi1_old[a], xi2_old[a], 0, e->get_mode());
+              vx[a] += local_coeffs[i][0] * val;
+              vy[a] += local_coeffs[i][1] * val;
+
+              double dx = shapeset.get_dx_value(local_indices[i], xi1_old[a], xi2_old[a], 0, e->get_mode());
+              double dy = shapeset.get_dy_value(local_indices[i], xi1_old[a], xi2_old[a], 0, e->get_mode());
+              tmp[a][0][0] += local_coeffs[i][0] * dx;
+              tmp[a][0][1] += local_coeffs[i][0] * dy;
+              tmp[a][1][0] += local_coeffs[i][1] * dx;
+              tmp[a][1][1] += local_coeffs[i][1] * dy;
+            }
           }
 
-          // inverse matrix
-          double jac = tmp[0][0] * tmp[1][1] - tmp[0][1] * tmp[1][0];
-          m[0][0] = tmp[1][1] / jac;
-          m[0][1] = -tmp[1][0] / jac;
-          m[1][0] = -tmp[0][1] / jac;
-          m[1][1] = tmp[0][0] / jac;
-
-          xi1 = xi1_old - (m[0][0] * (vx - x) + m[1][0] * (vy - y));
-          xi2 = xi2_old - (m[0][1] * (vx - x) + m[1][1] * (vy - y));
-          if (fabs(xi1 - xi1_old) < TOL && fabs(xi2 - xi2_old) < TOL) return;
-          if (it > 1 && (xi1 > 1.5 || xi2 > 1.5 || xi1 < -1.5 || xi2 < -1.5)) return;
-          if (it > 100)
+          int still_active = 0;
+          for (int a = 0; a < num_active; a++)
           {
-            Hermes::Mixins::Loggable::Static::warn("Could not find reference coordinates - Newton method did not converge.");
-            return;
+            int p = active[a];
+
+            // inverse matrix
+            double2x2 m;
+            double jac = tmp[a][0][0] * tmp[a][1][1] - tmp[a][0][1] * tmp[a][1][0];
+            m[0][0] = tmp[a][1][1] / jac;
+            m[0][1] = -tmp[a][1][0] / jac;
+            m[1][0] = -tmp[a][0][1] / jac;
+            m[1][1] = tmp[a][0][0] / jac;
+
+            xi1[p] = xi1_old[a] - (m[0][0] * (vx[a] - x[p]) + m[1][0] * (vy[a] - y[p]));
+            xi2[p] = xi2_old[a] - (m[0][1] * (vx[a] - x[p]) + m[1][1] * (vy[a] - y[p]));
+            if (fabs(xi1[p] - xi1_old[a]) < TOL && fabs(xi2[p] - xi2_old[a]) < TOL)
+              continue;
+            if (it > 1 && (xi1[p] > 1.5 || xi2[p] > 1.5 || xi1[p] < -1.5 || xi2[p] < -1.5))
+              continue;
+            if (it > 100)
+            {
+              Hermes::Mixins::Loggable::Static::warn("Could not find reference coordinates - Newton method did not converge.");
+              continue;
+            }
+
+            // The slots of the points left so far are reused, still_active <= a.
+            active[still_active] = p;
+            xi1_old[still_active] = xi1[p];
+            xi2_old[still_active] = xi2[p];
+            still_active++;
           }
-          xi1_old = xi1;
-          xi2_old = xi2;
+          num_active = still_active;
           it++;
         }
       }
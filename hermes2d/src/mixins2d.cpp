@@ -30,9 +30,14 @@ namespace Hermes
       }
 
 
-      Parallel::Parallel() : num_threads_used(HermesCommonApi.get_integral_param_value(numThreads))
+      Parallel::Parallel() : num_threads_used(HermesCommonApi.get_integral_param_value(numThreads)), report_load_balance(false)
       {
       }
+
+      void Parallel::set_report_load_balance(bool to_set)
+      {
+        this->report_load_balance = to_set;
+      }
     }
   }
 }
@@ -173,6 +173,17 @@ namespace Hermes
       neighborhood_type = H2D_DG_NOT_INITIALIZED;
     }
 
+    template<typename Scalar>
+    void NeighborSearch<Scalar>::set_central_element(Element* el)
+    {
+      if (el == nullptr || el->active != 1)
+        throw Exceptions::Exception("You must pass an active element to NeighborSearch::set_central_element().");
+
+      reset_neighb_info();
+      central_el = el;
+      original_central_el_transform = 0;
+    }
+
     template<typename Scalar>
     void NeighborSearch<Scalar>::set_active_edge(int edge)
     {
@@ -28,7 +28,7 @@ namespace Hermes
     template<typename Scalar>
     RungeKutta<Scalar>::RungeKutta(WeakForm<Scalar>* wf, Hermes::vector<SpaceSharedPtr<Scalar> > spaces, ButcherTable* bt)
       : wf(wf), bt(bt), num_stages(bt->get_size()), stage_wf_right(bt->get_size() * spaces.size()),
-      stage_wf_left(spaces.size()), start_from_zero_K_vector(false), block_diagonal_jacobian(false), residual_as_vector(true), iteration(0),
+      stage_wf_left(spaces.size()), stage_wf_sequential(spaces.size()), start_from_zero_K_vector(false), block_diagonal_jacobian(false), stage_sequential(false), explicit_stages(false), lumped_mass(false), residual_as_vector(true), iteration(0),
       freeze_jacobian(false), newton_tol(1e-6), newton_max_iter(20), newton_damping_coeff(1.0), newton_max_allowed_residual_norm(1e10)
     {
       for(unsigned int i = 0; i < spaces.size(); i++)
@@ -58,12 +58,15 @@ namespace Hermes
 
       this->stage_dp_left = nullptr;
       this->stage_dp_right = nullptr;
+      this->stage_dp_sequential = nullptr;
+      this->mass_solver = nullptr;
+      this->mass_rhs = nullptr;
     }
 
     template<typename Scalar>
     RungeKutta<Scalar>::RungeKutta(WeakForm<Scalar>* wf, SpaceSharedPtr<Scalar> space, ButcherTable* bt)
       : wf(wf), bt(bt), num_stages(bt->get_size()), stage_wf_right(bt->get_size() * 1),
-      stage_wf_left(1), start_from_zero_K_vector(false), block_diagonal_jacobian(false), residual_as_vector(true), iteration(0),
+      stage_wf_left(1), stage_wf_sequential(1), start_from_zero_K_vector(false), block_diagonal_jacobian(false), stage_sequential(false), explicit_stages(false), lumped_mass(false), residual_as_vector(true), iteration(0),
       freeze_jacobian(false), newton_tol(1e-6), newton_max_iter(20), newton_damping_coeff(1.0), newton_max_allowed_residual_norm(1e10)
     {
       this->spaces.push_back(space);
@@ -89,6 +92,9 @@ namespace Hermes
 
       this->stage_dp_left = nullptr;
       this->stage_dp_right = nullptr;
+      this->stage_dp_sequential = nullptr;
+      this->mass_solver = nullptr;
+      this->mass_rhs = nullptr;
     }
 
     template<typename Scalar>
@@ -120,6 +126,8 @@ namespace Hermes
 
       if(this->stage_dp_left != nullptr)
         this->stage_dp_left->set_spaces(this->spaces);
+      if(this->stage_dp_sequential != nullptr)
+        this->stage_dp_sequential->set_spaces(this->spaces);
     }
 
     template<typename Scalar>
@@ -148,6 +156,8 @@ namespace Hermes
 
       if(this->stage_dp_left != nullptr)
         this->stage_dp_left->set_space(space);
+      if(this->stage_dp_sequential != nullptr)
+        this->stage_dp_sequential->set_space(space);
     }
 
     template<typename Scalar>
@@ -217,6 +227,47 @@ namespace Hermes
       this->block_diagonal_jacobian = true;
     }
 
+    template<typename Scalar>
+    void RungeKutta<Scalar>::set_stage_sequential(bool to_set)
+    {
+      this->stage_sequential = to_set;
+    }
+
+    template<typename Scalar>
+    void RungeKutta<Scalar>::set_explicit_stages(bool to_set)
+    {
+      this->explicit_stages = to_set;
+    }
+
+    template<typename Scalar>
+    void RungeKutta<Scalar>::set_lumped_mass(bool to_set)
+    {
+      if(this->lumped_mass != to_set)
+        this->mass_inverse_spaces_seqs.clear();
+      this->lumped_mass = to_set;
+    }
+
+    template<typename Scalar>
+    double RungeKutta<Scalar>::get_cfl_time_step(double max_speed, double cfl_number) const
+    {
+      if(max_speed <= 0.)
+        throw Exceptions::ValueException("max_speed", max_speed, 0.);
+
+      double time_step = std::numeric_limits<double>::max();
+      for(unsigned int space_i = 0; space_i < spaces.size(); space_i++)
+      {
+        Element* e;
+        for_all_active_elements(e, spaces[space_i]->get_mesh())
+        {
+          int order = spaces[space_i]->get_element_order(e->id);
+          int p = std::max(H2D_GET_H_ORDER(order), H2D_GET_V_ORDER(order));
+          time_step = std::min(time_step, cfl_number * e->diameter / ((2 * p + 1) * max_speed));
+        }
+      }
+
+      return time_step;
+    }
+
     template<typename Scalar>
     void RungeKutta<Scalar>::set_freeze_jacobian()
     {
@@ -250,6 +301,12 @@ namespace Hermes
         delete stage_dp_left;
       if(stage_dp_right != nullptr)
         delete stage_dp_right;
+      if(stage_dp_sequential != nullptr)
+        delete stage_dp_sequential;
+      if(mass_solver != nullptr)
+        delete mass_solver;
+      if(mass_rhs != nullptr)
+        delete mass_rhs;
       delete solver;
       delete matrix_right;
       delete matrix_left;
@@ -291,13 +348,36 @@ namespace Hermes
       Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns_time_new,
       Hermes::vector<MeshFunctionSharedPtr<Scalar> > error_fns)
     {
+      if(this->stage_dp_left == nullptr)
+        this->init();
+
+      // The single-stage problem for the explicit and the stage-sequential mode, created on the first time step
+      // in one of them (the modes may be switched on at any time).
+      bool explicit_step = this->explicit_stages && this->bt->is_explicit();
+      bool sequential_step = this->stage_sequential && this->bt->is_diagonally_implicit();
+      if((explicit_step || sequential_step) && this->stage_dp_sequential == nullptr)
+      {
+        this->create_sequential_stage_wf(spaces.size());
+        this->stage_wf_sequential.set_verbose_output(this->get_verbose_output());
+        this->stage_dp_sequential = new DiscreteProblem<Scalar>(&stage_wf_sequential, spaces);
+      }
+
+      if(explicit_step)
+      {
+        this->rk_time_step_explicit(slns_time_prev, slns_time_new, error_fns);
+        return;
+      }
+
+      if(sequential_step)
+      {
+        this->rk_time_step_newton_sequential(slns_time_prev, slns_time_new, error_fns);
+        return;
+      }
+
       this->tick();
 
       int ndof = Space<Scalar>::get_num_dofs(spaces);
 
-      if(this->stage_dp_left == nullptr)
-        this->init();
-
       // Creates the stage weak formulation.
       update_stage_wf(slns_time_prev);
 
@@ -458,6 +538,19 @@ namespace Hermes
         throw Exceptions::ValueException("Newton iterations", it, newton_max_iter);
       }
 
+      this->calculate_time_level_solution(slns_time_prev, slns_time_new, error_fns);
+
+      iteration++;
+      this->tick();
+      this->info("\tRunge-Kutta: time step duration: %f s.\n", this->last());
+    }
+
+    template<typename Scalar>
+    void RungeKutta<Scalar>::calculate_time_level_solution(Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns_time_prev,
+      Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns_time_new, Hermes::vector<MeshFunctionSharedPtr<Scalar> > error_fns)
+    {
+      int ndof = Space<Scalar>::get_num_dofs(spaces);
+
       // Project previous time level solution on the stage space,
       // to be able to add them together. The result of the projection
       // will be stored in the vector coeff_vec.
@@ -489,6 +582,363 @@ namespace Hermes
 
       // Clean up.
       delete [] coeff_vec;
+    }
+
+    template<typename Scalar>
+    void RungeKutta<Scalar>::rk_time_step_newton_sequential(Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns_time_prev,
+      Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns_time_new,
+      Hermes::vector<MeshFunctionSharedPtr<Scalar> > error_fns)
+    {
+      this->tick();
+
+      int ndof = Space<Scalar>::get_num_dofs(spaces);
+
+      // Check whether the user provided a nonzero B2-row if he wants temporal error estimation.
+      if(error_fns != Hermes::vector<MeshFunctionSharedPtr<Scalar> >() && bt->is_embedded() == false)
+        throw Hermes::Exceptions::Exception("rk_time_step_newton_sequential(): R-K method must be embedded if temporal error estimate is requested.");
+
+      info("\tRunge-Kutta: time step (stage-sequential), time: %f, time step: %f", this->time, this->time_step);
+
+      // Zero utility vectors. Only the first ndof entries of u_ext_vec and vector_left are used here.
+      if(start_from_zero_K_vector || !iteration)
+        memset(K_vector, 0, num_stages * ndof * sizeof(Scalar));
+
+      // Assemble the mass matrix M of size ndof times ndof.
+      Space<Scalar>::assign_dofs(spaces);
+      stage_dp_left->assemble(matrix_left);
+
+      // The Jacobian of the previous stage is kept factorized, the structure does not change
+      // within a time step.
+      bool factorization_available = false;
+      double factorized_diagonal_coefficient = 0.;
+
+      for (unsigned int stage_i = 0; stage_i < num_stages; stage_i++)
+      {
+        double diagonal_coefficient = bt->get_A(stage_i, stage_i);
+
+        // Set the correct time to the essential boundary conditions and the forms.
+        Space<Scalar>::update_essential_bc_values(spaces, this->time + bt->get_C(stage_i) * this->time_step);
+        update_sequential_stage_wf(slns_time_prev, stage_i);
+
+        Scalar* K_stage = K_vector + stage_i * ndof;
+
+        // Initial guess - the previous stage is typically closer than the last time step.
+        if(stage_i > 0 && (start_from_zero_K_vector || !iteration))
+          memcpy(K_stage, K_stage - ndof, ndof * sizeof(Scalar));
+
+        double residual_norm;
+        int it = 1;
+        while (true)
+        {
+          // Prepare vector h\sum_{j = 1}^i a_{ij} K_j (the stages after stage_i do not contribute).
+          for (int idx = 0; idx < ndof; idx++)
+          {
+            Scalar increment = 0;
+            for (unsigned int stage_j = 0; stage_j <= stage_i; stage_j++)
+              increment += bt->get_A(stage_i, stage_j) * K_vector[stage_j * ndof + idx];
+            u_ext_vec[idx] = this->time_step * increment;
+          }
+
+          // Reinitialize filters.
+          if(this->filters_to_reinit.size() > 0)
+          {
+            Solution<Scalar>::vector_to_solutions(u_ext_vec, spaces, slns_time_new);
+
+            for(unsigned int filters_i = 0; filters_i < this->filters_to_reinit.size(); filters_i++)
+              filters_to_reinit.at(filters_i)->reinit();
+          }
+
+          // Residual M K_i - F(...).
+          matrix_left->multiply_with_vector(K_stage, vector_left, true);
+          stage_dp_sequential->set_RK(spaces.size(), true);
+          stage_dp_sequential->assemble(u_ext_vec, nullptr, vector_right);
+          vector_right->add_vector(vector_left);
+          vector_right->change_sign();
+
+          if(this->output_rhsOn && (this->output_rhsIterations == -1 || this->output_rhsIterations >= it))
+          {
+            char* fileName = new char[this->RhsFilename.length() + 5];
+            sprintf(fileName, "%s%i", this->RhsFilename.c_str(), it);
+            vector_right->export_to_file(fileName, this->RhsVarname.c_str(), this->RhsFormat, this->rhs_number_format);
+          }
+
+          // Measure the residual norm.
+          if(residual_as_vector)
+            residual_norm = get_l2_norm(vector_right);
+          else
+          {
+            Hermes::vector<MeshFunctionSharedPtr<Scalar> > meshFns;
+            for(unsigned int i = 0; i < spaces.size(); i++)
+              meshFns.push_back(residuals_vector[i]);
+            Solution<Scalar>::vector_to_solutions(vector_right, spaces, meshFns, false);
+
+            DefaultNormCalculator<Scalar, HERMES_L2_NORM> errorCalculator(meshFns.size());
+            residual_norm = errorCalculator.calculate_norms(meshFns);
+          }
+
+          if(it == 1)
+            this->info("\tRunge-Kutta: stage %d, Newton initial residual norm: %g", stage_i, residual_norm);
+          else
+            this->info("\tRunge-Kutta: stage %d, Newton iteration %d, residual norm: %g", stage_i, it-1, residual_norm);
+
+          if(residual_norm > newton_max_allowed_residual_norm)
+            throw Exceptions::ValueException("residual norm", residual_norm, newton_max_allowed_residual_norm);
+
+          if((residual_norm < newton_tol || it > newton_max_iter) && it > 1)
+            break;
+
+          // With a frozen Jacobian, the factorization of M - h a_{ii} J_F is reused for all stages
+          // with the same diagonal coefficient.
+          bool reuse_factorization = freeze_jacobian && factorization_available
+            && std::abs(diagonal_coefficient - factorized_diagonal_coefficient) < Hermes::HermesSqrtEpsilon;
+
+          if(reuse_factorization)
+            solver->set_reuse_scheme(HERMES_REUSE_MATRIX_STRUCTURE_COMPLETELY);
+          else
+          {
+            stage_dp_sequential->set_RK(spaces.size(), true);
+            stage_dp_sequential->assemble(u_ext_vec, matrix_right, nullptr);
+            matrix_right->add_sparse_matrix(matrix_left);
+
+            if(this->output_matrixOn && (this->output_matrixIterations == -1 || this->output_matrixIterations >= it))
+            {
+              char* fileName = new char[this->matrixFilename.length() + 5];
+              sprintf(fileName, "%s%i", this->matrixFilename.c_str(), it);
+              matrix_right->export_to_file(fileName, this->matrixVarname.c_str(), this->matrixFormat, this->matrix_number_format);
+            }
+
+            matrix_right->finish();
+            solver->set_reuse_scheme(factorization_available ? HERMES_REUSE_MATRIX_REORDERING : HERMES_CREATE_STRUCTURE_FROM_SCRATCH);
+            factorization_available = true;
+            factorized_diagonal_coefficient = diagonal_coefficient;
+          }
+
+          solver->solve();
+
+          // Add \deltaK^{n + 1} to K^n.
+          for (int i = 0; i < ndof; i++)
+            K_stage[i] += newton_damping_coeff * solver->get_sln_vector()[i];
+
+          it++;
+        }
+
+        // If max number of iterations was exceeded, fail.
+        if(it >= newton_max_iter)
+        {
+          this->tick();
+          this->info("\tRunge-Kutta: time step duration: %f s.\n", this->last());
+          throw Exceptions::ValueException("Newton iterations", it, newton_max_iter);
+        }
+      }
+
+      this->calculate_time_level_solution(slns_time_prev, slns_time_new, error_fns);
+
+      iteration++;
+      this->tick();
+      this->info("\tRunge-Kutta: time step duration: %f s.\n", this->last());
+    }
+
+    template<typename Scalar>
+    void RungeKutta<Scalar>::init_mass_inverse()
+    {
+      bool spaces_changed = (this->mass_inverse_spaces_seqs.size() != spaces.size());
+      for(unsigned int i = 0; i < spaces.size() && !spaces_changed; i++)
+        if(spaces[i]->get_seq() != this->mass_inverse_spaces_seqs[i])
+          spaces_changed = true;
+      if(!spaces_changed)
+        return;
+
+      int ndof = Space<Scalar>::get_num_dofs(spaces);
+
+      Space<Scalar>::assign_dofs(spaces);
+      stage_dp_left->assemble(matrix_left);
+
+      // With L2 spaces only, the mass matrix is block diagonal with one block per element.
+      bool all_l2 = true;
+      for(unsigned int i = 0; i < spaces.size(); i++)
+        if(spaces[i]->get_type() != HERMES_L2_SPACE)
+          all_l2 = false;
+
+      if(all_l2)
+        this->mass_inverse_type = MassInverseElementBlocks;
+      else if(lumped_mass)
+        this->mass_inverse_type = MassInverseLumped;
+      else
+        this->mass_inverse_type = MassInverseFactorized;
+
+      switch(this->mass_inverse_type)
+      {
+      case MassInverseElementBlocks:
+        {
+          mass_inverse_block_offsets.clear();
+          mass_inverse_block_dofs.clear();
+          mass_inverse_value_offsets.clear();
+          mass_inverse_values.clear();
+          mass_inverse_block_offsets.push_back(0);
+          mass_inverse_value_offsets.push_back(0);
+
+          AsmList<Scalar> al;
+          int* indx = malloc_with_check<int>(H2D_MAX_LOCAL_BASIS_SIZE);
+          Scalar** block = DenseMatrixOperations::new_matrix<Scalar>(H2D_MAX_LOCAL_BASIS_SIZE, H2D_MAX_LOCAL_BASIS_SIZE);
+          Scalar* column = malloc_with_check<Scalar>(H2D_MAX_LOCAL_BASIS_SIZE);
+          for(unsigned int space_i = 0; space_i < spaces.size(); space_i++)
+          {
+            Element* e;
+            for_all_active_elements(e, spaces[space_i]->get_mesh())
+            {
+              spaces[space_i]->get_element_assembly_list(e, &al);
+              int cnt = al.cnt;
+              if(cnt == 0)
+                continue;
+
+              for(int i = 0; i < cnt; i++)
+                for(int j = 0; j < cnt; j++)
+                  block[i][j] = matrix_left->get(al.dof[i], al.dof[j]);
+
+              double d;
+              DenseMatrixOperations::ludcmp(block, cnt, indx, &d);
+
+              // The inverse column by column, stored row-major.
+              int value_offset = mass_inverse_values.size();
+              mass_inverse_values.resize(value_offset + cnt * cnt);
+              for(int j = 0; j < cnt; j++)
+              {
+                memset(column, 0, cnt * sizeof(Scalar));
+                column[j] = 1.0;
+                DenseMatrixOperations::lubksb(block, cnt, indx, column);
+                for(int i = 0; i < cnt; i++)
+                  mass_inverse_values[value_offset + i * cnt + j] = column[i];
+              }
+
+              for(int i = 0; i < cnt; i++)
+                mass_inverse_block_dofs.push_back(al.dof[i]);
+              mass_inverse_block_offsets.push_back(mass_inverse_block_dofs.size());
+              mass_inverse_value_offsets.push_back(mass_inverse_values.size());
+            }
+          }
+          free_with_check(column);
+          free_with_check(block);
+          free_with_check(indx);
+        }
+        break;
+      case MassInverseLumped:
+        {
+          // Row sums (M is symmetric).
+          Scalar* ones = malloc_with_check<Scalar>(ndof);
+          for(int i = 0; i < ndof; i++)
+            ones[i] = 1.0;
+          mass_lumped_diagonal.resize(ndof);
+          Scalar* diagonal = &mass_lumped_diagonal[0];
+          matrix_left->multiply_with_vector(ones, diagonal, true);
+          free_with_check(ones);
+        }
+        break;
+      case MassInverseFactorized:
+        {
+          if(mass_solver == nullptr)
+          {
+            mass_rhs = create_vector<Scalar>();
+            mass_solver = create_linear_solver(matrix_left, mass_rhs);
+          }
+          mass_rhs->alloc(ndof);
+          mass_solver->set_reuse_scheme(HERMES_CREATE_STRUCTURE_FROM_SCRATCH);
+        }
+        break;
+      }
+
+      this->mass_inverse_spaces_seqs.clear();
+      for(unsigned int i = 0; i < spaces.size(); i++)
+        this->mass_inverse_spaces_seqs.push_back(spaces[i]->get_seq());
+    }
+
+    template<typename Scalar>
+    void RungeKutta<Scalar>::apply_mass_inverse(Scalar* rhs, Scalar* result)
+    {
+      int ndof = Space<Scalar>::get_num_dofs(spaces);
+
+      switch(this->mass_inverse_type)
+      {
+      case MassInverseElementBlocks:
+        for(unsigned int block_i = 0; block_i < mass_inverse_block_offsets.size() - 1; block_i++)
+        {
+          int* dofs = &mass_inverse_block_dofs[mass_inverse_block_offsets[block_i]];
+          int cnt = mass_inverse_block_offsets[block_i + 1] - mass_inverse_block_offsets[block_i];
+          Scalar* inverse = &mass_inverse_values[mass_inverse_value_offsets[block_i]];
+          for(int i = 0; i < cnt; i++)
+          {
+            Scalar value = 0.;
+            for(int j = 0; j < cnt; j++)
+              value += inverse[i * cnt + j] * rhs[dofs[j]];
+            result[dofs[i]] = value;
+          }
+        }
+        break;
+      case MassInverseLumped:
+        for(int i = 0; i < ndof; i++)
+          result[i] = rhs[i] / mass_lumped_diagonal[i];
+        break;
+      case MassInverseFactorized:
+        mass_rhs->set_vector(rhs);
+        mass_solver->solve();
+        // The factorization is done once and reused for all stages and time steps.
+        mass_solver->set_reuse_scheme(HERMES_REUSE_MATRIX_STRUCTURE_COMPLETELY);
+        memcpy(result, mass_solver->get_sln_vector(), ndof * sizeof(Scalar));
+        break;
+      }
+    }
+
+    template<typename Scalar>
+    void RungeKutta<Scalar>::rk_time_step_explicit(Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns_time_prev,
+      Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns_time_new,
+      Hermes::vector<MeshFunctionSharedPtr<Scalar> > error_fns)
+    {
+      this->tick();
+
+      int ndof = Space<Scalar>::get_num_dofs(spaces);
+
+      // Check whether the user provided a nonzero B2-row if he wants temporal error estimation.
+      if(error_fns != Hermes::vector<MeshFunctionSharedPtr<Scalar> >() && bt->is_embedded() == false)
+        throw Hermes::Exceptions::Exception("rk_time_step_explicit(): R-K method must be embedded if temporal error estimate is requested.");
+
+      info("\tRunge-Kutta: explicit time step, time: %f, time step: %f", this->time, this->time_step);
+
+      // No global Jacobian, only the mass matrix (cached as long as the spaces do not change).
+      this->init_mass_inverse();
+      Space<Scalar>::assign_dofs(spaces);
+
+      for (unsigned int stage_i = 0; stage_i < num_stages; stage_i++)
+      {
+        Space<Scalar>::update_essential_bc_values(spaces, this->time + bt->get_C(stage_i) * this->time_step);
+        update_sequential_stage_wf(slns_time_prev, stage_i);
+
+        // Prepare vector h\sum_{j < i} a_{ij} K_j.
+        for (int idx = 0; idx < ndof; idx++)
+        {
+          Scalar increment = 0;
+          for (unsigned int stage_j = 0; stage_j < stage_i; stage_j++)
+            increment += bt->get_A(stage_i, stage_j) * K_vector[stage_j * ndof + idx];
+          u_ext_vec[idx] = this->time_step * increment;
+        }
+
+        // Reinitialize filters.
+        if(this->filters_to_reinit.size() > 0)
+        {
+          Solution<Scalar>::vector_to_solutions(u_ext_vec, spaces, slns_time_new);
+
+          for(unsigned int filters_i = 0; filters_i < this->filters_to_reinit.size(); filters_i++)
+            filters_to_reinit.at(filters_i)->reinit();
+        }
+
+        // The single-stage residual is -F(...) (the vector forms are scaled by -1).
+        stage_dp_sequential->set_RK(spaces.size(), true);
+        stage_dp_sequential->assemble(u_ext_vec, nullptr, vector_right);
+        vector_right->change_sign();
+        vector_right->extract(vector_left);
+
+        this->apply_mass_inverse(vector_left, K_vector + stage_i * ndof);
+      }
+
+      this->calculate_time_level_solution(slns_time_prev, slns_time_new, error_fns);
 
       iteration++;
       this->tick();
@@ -682,10 +1132,12 @@ namespace Hermes
       // external solutions, and anter them as blocks to the
       // new_ stage Jacobian. If block_diagonal_jacobian = true
       // then only diagonal blocks are considered.
+      // The coefficient a_ij itself is applied by stage_dp_right,
+      // which gets the Butcher's table as the block weights.
       for (unsigned int m = 0; m < mfvol.size(); m++)
       {
         MatrixFormVol<Scalar> *mfv_ij = mfvol[m];
-        mfv_ij->scaling_factor = -this->time_step * bt->get_A(mfv_ij->i / spaces.size(), mfv_ij->j / spaces.size());
+        mfv_ij->scaling_factor = -this->time_step;
         mfv_ij->set_current_stage_time(this->time + bt->get_C(mfv_ij->i / spaces.size()) * this->time_step);
       }
 
@@ -695,7 +1147,7 @@ namespace Hermes
       for (unsigned int m = 0; m < mfsurf.size(); m++)
       {
         MatrixFormSurf<Scalar> *mfs_ij = mfsurf[m];
-        mfs_ij->scaling_factor = -this->time_step * bt->get_A(mfs_ij->i / spaces.size(), mfs_ij->j / spaces.size());
+        mfs_ij->scaling_factor = -this->time_step;
         mfs_ij->set_current_stage_time(this->time + bt->get_C(mfs_ij->i / spaces.size()) * this->time_step);
       }
 
@@ -718,6 +1170,76 @@ namespace Hermes
       }
     }
 
+    template<typename Scalar>
+    void RungeKutta<Scalar>::create_sequential_stage_wf(unsigned int size)
+    {
+      stage_wf_sequential.delete_all();
+
+      // The original forms, the matrix forms are scaled by -h a_{ii} in update_sequential_stage_wf(),
+      // the vector forms form the right-hand side -F(...).
+      for (unsigned int m = 0; m < wf->mfvol.size(); m++)
+      {
+        MatrixFormVol<Scalar>* mfv = wf->mfvol[m]->clone();
+        mfv->u_ext_offset = 0;
+        stage_wf_sequential.add_matrix_form(mfv);
+      }
+
+      for (unsigned int m = 0; m < wf->mfsurf.size(); m++)
+      {
+        MatrixFormSurf<Scalar>* mfs = wf->mfsurf[m]->clone();
+        mfs->u_ext_offset = 0;
+        stage_wf_sequential.add_matrix_form_surf(mfs);
+      }
+
+      for (unsigned int m = 0; m < wf->vfvol.size(); m++)
+      {
+        VectorFormVol<Scalar>* vfv = wf->vfvol[m]->clone();
+        vfv->scaling_factor = -1.0;
+        vfv->u_ext_offset = 0;
+        stage_wf_sequential.add_vector_form(vfv);
+      }
+
+      for (unsigned int m = 0; m < wf->vfsurf.size(); m++)
+      {
+        VectorFormSurf<Scalar>* vfs = wf->vfsurf[m]->clone();
+        vfs->scaling_factor = -1.0;
+        vfs->u_ext_offset = 0;
+        stage_wf_sequential.add_vector_form_surf(vfs);
+      }
+    }
+
+    template<typename Scalar>
+    void RungeKutta<Scalar>::update_sequential_stage_wf(Hermes::vector<MeshFunctionSharedPtr<Scalar> > slns_time_prev, unsigned int stage_i)
+    {
+      if(this->wf->global_integration_order_set)
+        this->stage_wf_sequential.set_global_integration_order(this->wf->global_integration_order);
+
+      // The previous time level solution is added to u_ext from the back of ext.
+      stage_wf_sequential.ext.clear();
+      for(unsigned int slns_time_prev_i = 0; slns_time_prev_i < slns_time_prev.size(); slns_time_prev_i++)
+        stage_wf_sequential.ext.push_back(slns_time_prev[slns_time_prev_i]);
+
+      double stage_time = this->time + bt->get_C(stage_i) * this->time_step;
+
+      for (unsigned int m = 0; m < stage_wf_sequential.mfvol.size(); m++)
+      {
+        stage_wf_sequential.mfvol[m]->scaling_factor = -this->time_step * bt->get_A(stage_i, stage_i);
+        stage_wf_sequential.mfvol[m]->set_current_stage_time(stage_time);
+      }
+
+      for (unsigned int m = 0; m < stage_wf_sequential.mfsurf.size(); m++)
+      {
+        stage_wf_sequential.mfsurf[m]->scaling_factor = -this->time_step * bt->get_A(stage_i, stage_i);
+        stage_wf_sequential.mfsurf[m]->set_current_stage_time(stage_time);
+      }
+
+      for (unsigned int m = 0; m < stage_wf_sequential.vfvol.size(); m++)
+        stage_wf_sequential.vfvol[m]->set_current_stage_time(stage_time);
+
+      for (unsigned int m = 0; m < stage_wf_sequential.vfsurf.size(); m++)
+        stage_wf_sequential.vfsurf[m]->set_current_stage_time(stage_time);
+    }
+
     template<typename Scalar>
     void RungeKutta<Scalar>::prepare_u_ext_vec()
     {
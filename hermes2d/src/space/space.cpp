@@ -24,6 +24,7 @@
 #include "space_hdiv.h"
 #include "space_h2d_xml.h"
 #include "api2d.h"
+#include "binary_file.h"
 
 namespace Hermes
 {
@@ -91,9 +92,13 @@ namespace Hermes
       this->mesh_seq = -1;
       this->seq = g_space_seq++;
       this->seq_assigned = -1;
+      this->bc_values_seq = 0;
       this->ndof = 0;
+      this->first_dof = this->next_dof = 0;
+      this->stride = 1;
       this->proj_mat = nullptr;
       this->chol_p = nullptr;
+      this->bc_data_edges_valid = false;
       this->vertex_functions_count = this->edge_functions_count = this->bubble_functions_count = 0;
 
       if (essential_bcs != nullptr)
@@ -293,7 +298,7 @@ namespace Hermes
     int Space<Scalar>::get_max_dof() const
     {
       check();
-      return next_dof - 1;
+      return next_dof - stride;
     }
 
     template<typename Scalar>
@@ -388,6 +393,28 @@ namespace Hermes
       return ndof;
     }
 
+    template<typename Scalar>
+    int Space<Scalar>::assign_dofs_interleaved(Hermes::vector<SpaceSharedPtr<Scalar> > spaces)
+    {
+      int n = spaces.size();
+
+      int space_ndof = spaces[0]->assign_dofs(0, n);
+      bool same_ndof = true;
+      for (int i = 1; i < n; i++)
+      {
+        if (spaces[i]->assign_dofs(i, n) != space_ndof)
+          same_ndof = false;
+      }
+      if (same_ndof)
+        return n * space_ndof;
+
+      Hermes::Mixins::Loggable::Static::warn("The spaces do not have the same number of DOFs, the DOFs are not interleaved.");
+      int ndof = 0;
+      for (int i = 0; i < n; i++)
+        ndof += spaces[i]->assign_dofs(ndof);
+      return ndof;
+    }
+
     template<typename Scalar>
     void Space<Scalar>::set_uniform_order(int order, std::string marker)
     {
@@ -838,6 +865,12 @@ namespace Hermes
       return seq;
     }
 
+    template<typename Scalar>
+    unsigned int Space<Scalar>::get_bc_values_seq() const
+    {
+      return bc_values_seq;
+    }
+
     template<typename Scalar>
     void Space<Scalar>::distribute_orders(MeshSharedPtr mesh, int* parents)
     {
@@ -857,7 +890,7 @@ namespace Hermes
     }
 
     template<typename Scalar>
-    int Space<Scalar>::assign_dofs(int first_dof)
+    int Space<Scalar>::assign_dofs(int first_dof, int stride)
     {
       if (ndata == nullptr || edata == nullptr || !nsize || !esize)
         return false;
@@ -876,10 +909,13 @@ namespace Hermes
 
       if (first_dof < 0)
         throw Hermes::Exceptions::ValueException("first_dof", first_dof, 0);
+      if (stride < 1)
+        throw Hermes::Exceptions::ValueException("stride", stride, 1);
 
       resize_tables();
 
       this->first_dof = next_dof = first_dof;
+      this->stride = stride;
 
       reset_dof_assignment();
       assign_vertex_dofs();
@@ -893,7 +929,7 @@ namespace Hermes
 
       mesh_seq = mesh->get_seq();
       seq_assigned = this->seq;
-      this->ndof = next_dof - first_dof;
+      this->ndof = (next_dof - first_dof) / stride;
 
       this->check();
       return this->ndof;
@@ -988,7 +1024,7 @@ namespace Hermes
       if (!ed->n) return;
 
       int* indices = shapeset->get_bubble_indices(ed->order, e->get_mode());
-      for (int i = 0, dof = ed->bdof; i < ed->n; i++, dof++, indices++)
+      for (int i = 0, dof = ed->bdof; i < ed->n; i++, dof += this->stride, indices++)
         al->add_triplet(*indices, dof, 1.0);
     }
 
@@ -996,6 +1032,9 @@ namespace Hermes
     void Space<Scalar>::set_essential_bcs(EssentialBCs<Scalar>* essential_bcs)
     {
       this->essential_bcs = essential_bcs;
+      // The next update looks the edges up again (the projections stay owned by bc_data_projections).
+      this->bc_data_edges.clear();
+      this->bc_data_edges_valid = false;
     }
 
     template<typename Scalar>
@@ -1029,7 +1068,7 @@ namespace Hermes
     }
 
     template<typename Scalar>
-    void Space<Scalar>::update_edge_bc(Element* e, SurfPos* surf_pos)
+    void Space<Scalar>::update_edge_bc(Element* e, SurfPos* surf_pos, Hermes::vector<BCEdge>& edges)
     {
       if (!e->used)
         return;
@@ -1046,21 +1085,60 @@ namespace Hermes
         EssentialBoundaryCondition<Scalar> *bc = this->essential_bcs->get_boundary_condition(this->mesh->boundary_markers_conversion.get_user_marker(en->marker).marker);
         if (bc != nullptr)
         {
-          int order = get_edge_order_internal(en);
-          surf_pos->marker = en->marker;
-          nd->edge_bc_proj = get_bc_projection(surf_pos, order, bc);
-          bc_data_projections.push_back(nd->edge_bc_proj);
-
-          int i = surf_pos->surf_num, j = e->next_vert(i);
-          ndata[e->vn[i]->id].vertex_bc_coef = nd->edge_bc_proj + 0;
-          ndata[e->vn[j]->id].vertex_bc_coef = nd->edge_bc_proj + 1;
+          BCEdge edge = { e, surf_pos->surf_num, bc, get_edge_order_internal(en), nullptr };
+          edges.push_back(edge);
         }
       }
     }
 
+    template<typename Scalar>
+    void Space<Scalar>::calculate_bc_projections(bool time_dependent_only)
+    {
+      int num_edges = this->bc_data_edges.size();
+      int num_threads = std::min(HermesCommonApi.get_integral_param_value(numThreads), std::max(num_edges / 16, 1));
+
+      // The values of the conditions not flagged as thread-safe are evaluated in one thread.
+      for (int i = 0; i < num_edges && num_threads > 1; i++)
+      {
+        EssentialBoundaryCondition<Scalar>* bc = this->bc_data_edges[i].bc;
+        if (!bc->is_thread_safe() && !(time_dependent_only && bc->is_time_independent()))
+          num_threads = 1;
+      }
+
+      // get_bc_projection() only reads the space data and the (precalculated) Cholesky factors proj_mat, chol_p.
+#pragma omp parallel for schedule(dynamic, 4) num_threads(num_threads)
+      for (int i = 0; i < num_edges; i++)
+      {
+        BCEdge& edge = this->bc_data_edges[i];
+        if (time_dependent_only && edge.bc->is_time_independent())
+          continue;
+
+        Element* e = edge.e;
+        Node* en = e->en[edge.surf_num];
+        SurfPos surf_pos = { en->marker, edge.surf_num, e, e->vn[edge.surf_num]->id, e->vn[e->next_vert(edge.surf_num)]->id, 0.0, 0.0, 1.0 };
+        Scalar* proj = get_bc_projection(&surf_pos, edge.order, edge.bc);
+        if (time_dependent_only)
+        {
+          memcpy(edge.proj, proj, (edge.order + 1) * sizeof(Scalar));
+          free_with_check(proj);
+        }
+        else
+          edge.proj = proj;
+      }
+    }
+
     template<typename Scalar>
     void Space<Scalar>::update_essential_bc_values()
     {
+      this->bc_values_seq++;
+
+      if (this->bc_data_edges_valid)
+      {
+        // The vertex coefficients point into the projections, overwriting them updates everything.
+        this->calculate_bc_projections(true);
+        return;
+      }
+
       Element* e;
       for_all_active_elements(e, mesh)
       {
@@ -1070,10 +1148,24 @@ namespace Hermes
           if (e->vn[i]->bnd && e->vn[j]->bnd)
           {
             SurfPos surf_pos = { 0, i, e, e->vn[i]->id, e->vn[j]->id, 0.0, 0.0, 1.0 };
-            update_edge_bc(e, &surf_pos);
+            update_edge_bc(e, &surf_pos, this->bc_data_edges);
           }
         }
       }
+
+      this->calculate_bc_projections(false);
+
+      // In the order of the traversal (the vertices shared by two edges get the coefficient of the latter).
+      for (unsigned int i = 0; i < this->bc_data_edges.size(); i++)
+      {
+        BCEdge& edge = this->bc_data_edges[i];
+        e = edge.e;
+        ndata[e->en[edge.surf_num]->id].edge_bc_proj = edge.proj;
+        bc_data_projections.push_back(edge.proj);
+        ndata[e->vn[edge.surf_num]->id].vertex_bc_coef = edge.proj + 0;
+        ndata[e->vn[e->next_vert(edge.surf_num)]->id].vertex_bc_coef = edge.proj + 1;
+      }
+      this->bc_data_edges_valid = true;
     }
 
     template<typename Scalar>
@@ -1085,6 +1177,8 @@ namespace Hermes
         free_with_check(bc_data_base_components[i]);
       bc_data_projections.clear();
       bc_data_base_components.clear();
+      bc_data_edges.clear();
+      bc_data_edges_valid = false;
     }
 
     template<typename Scalar>
@@ -1241,6 +1335,7 @@ namespace Hermes
           space->shapeset = new L2Shapeset;
           space->own_shapeset = true;
         }
+        else
         {
           if (shapeset->get_space_type() != HERMES_L2_SPACE)
             throw Hermes::Exceptions::SpaceLoadFailureException("Wrong shapeset / Wrong spaceType in Space loading subroutine.");
@@ -1522,6 +1617,104 @@ namespace Hermes
     }
 #endif
 
+    template<typename Scalar>
+    void Space<Scalar>::save_binary(const char *filename) const
+    {
+      // Check.
+      this->check();
+
+      BinaryFileWriter writer(filename, HERMES_BINARY_SPACE);
+
+      // Space type.
+      writer.write_value<int>(this->get_type());
+
+      // Element data.
+      int element_count = this->mesh->get_max_element_id();
+      int* orders = malloc_with_check<int>(element_count);
+      int* bdofs = malloc_with_check<int>(element_count);
+      int* ns = malloc_with_check<int>(element_count);
+      char* changed = malloc_with_check<char>(element_count);
+      for (int _id = 0; _id < element_count; _id++)
+      {
+        orders[_id] = this->edata[_id].order;
+        bdofs[_id] = this->edata[_id].bdof;
+        ns[_id] = this->edata[_id].n;
+        changed[_id] = this->edata[_id].changed_in_last_adaptation;
+      }
+      writer.write(orders, element_count);
+      writer.write(bdofs, element_count);
+      writer.write(ns, element_count);
+      writer.write(changed, element_count);
+
+      free_with_check(orders);
+      free_with_check(bdofs);
+      free_with_check(ns);
+      free_with_check(changed);
+
+      writer.close();
+    }
+
+    template<typename Scalar>
+    void Space<Scalar>::load_binary_element_data(BinaryFileReader& reader)
+    {
+      int element_count = this->mesh->get_max_element_id();
+      uint64_t count;
+      const int* orders = reader.read<int>(count);
+      if (count != element_count)
+        throw Exceptions::Exception("Mesh and saved space mixed in Space<Scalar>::load_binary.");
+      const int* bdofs = reader.read<int>(element_count, "bdofs");
+      const int* ns = reader.read<int>(element_count, "ns");
+      const char* changed = reader.read<char>(element_count, "changed");
+
+      this->resize_tables();
+
+      for (int _id = 0; _id < element_count; _id++)
+      {
+        this->edata[_id].order = orders[_id];
+        this->edata[_id].bdof = bdofs[_id];
+        this->edata[_id].n = ns[_id];
+        this->edata[_id].changed_in_last_adaptation = changed[_id];
+      }
+
+      this->seq = g_space_seq++;
+
+      this->assign_dofs();
+    }
+
+    template<typename Scalar>
+    SpaceSharedPtr<Scalar> Space<Scalar>::load_binary(const char *filename, MeshSharedPtr mesh, EssentialBCs<Scalar>* essential_bcs, Shapeset* shapeset)
+    {
+      BinaryFileReader reader(filename, HERMES_BINARY_SPACE);
+
+      SpaceSharedPtr<Scalar> space = Space<Scalar>::init_empty_space((SpaceType)reader.read_value<int>(), mesh, shapeset);
+      space->mesh_seq = space->mesh->get_seq();
+
+      // L2 space does not have any (strong) essential BCs.
+      if (essential_bcs != nullptr && space->get_type() != HERMES_L2_SPACE && space->get_type() != HERMES_L2_MARKERWISE_CONST_SPACE)
+      {
+        space->essential_bcs = essential_bcs;
+        for (typename Hermes::vector<EssentialBoundaryCondition<Scalar>*>::const_iterator it = essential_bcs->begin(); it != essential_bcs->end(); it++)
+        for (unsigned int i = 0; i < (*it)->markers.size(); i++)
+        if (space->get_mesh()->boundary_markers_conversion.conversion_table_inverse.find((*it)->markers.at(i)) == space->get_mesh()->boundary_markers_conversion.conversion_table_inverse.end())
+          throw Hermes::Exceptions::Exception("A boundary condition defined on a non-existent marker.");
+      }
+
+      space->load_binary_element_data(reader);
+
+      return space;
+    }
+
+    template<typename Scalar>
+    void Space<Scalar>::load_binary(const char *filename)
+    {
+      BinaryFileReader reader(filename, HERMES_BINARY_SPACE);
+
+      if (reader.read_value<int>() != this->get_type())
+        throw Exceptions::Exception("Saved Space is not of the same type as the current one in loading.");
+
+      this->load_binary_element_data(reader);
+    }
+
     namespace Mixins
     {
       template<typename Scalar>
@@ -129,7 +129,7 @@ namespace Hermes
               else
               {
                 nd->dof = this->next_dof;
-                this->next_dof++;
+                this->next_dof += this->stride;
                 this->vertex_functions_count++;
               }
               nd->n = 1;
@@ -171,19 +171,19 @@ namespace Hermes
                 else
                 {
                   nd->dof = this->next_dof;
-                  this->next_dof += ndofs;
+                  this->next_dof += ndofs * this->stride;
                   this->edge_functions_count += ndofs;
                 }
                 else
                 {
                   nd->dof = this->next_dof;
-                  this->next_dof += ndofs;
+                  this->next_dof += ndofs * this->stride;
                   this->edge_functions_count += ndofs;
                 }
                 else
                 {
                   nd->dof = this->next_dof;
-                  this->next_dof += ndofs;
+                  this->next_dof += ndofs * this->stride;
                   this->edge_functions_count += ndofs;
                 }
               }
@@ -206,7 +206,7 @@ namespace Hermes
         typename Space<Scalar>::ElementData* ed = &this->edata[e->id];
         ed->bdof = this->next_dof;
         ed->n = this->shapeset->get_num_bubbles(ed->order, e->get_mode());
-        this->next_dof += ed->n;
+        this->next_dof += ed->n * this->stride;
         this->bubble_functions_count += ed->n;
       }
     }
@@ -243,7 +243,7 @@ namespace Hermes
         if (nd->dof >= 0)
         {
           int ori = (e->vn[surf_num]->id < e->vn[e->next_vert(surf_num)]->id) ? 0 : 1;
-          for (int j = 0, dof = nd->dof; j < nd->n; j++, dof++)
+          for (int j = 0, dof = nd->dof; j < nd->n; j++, dof += this->stride)
             al->add_triplet(this->shapeset->get_edge_index(surf_num, ori, j + 2, e->get_mode()), dof, 1.0);
         }
         else
@@ -261,7 +261,7 @@ namespace Hermes
         if (part < 0) part ^= ~0;
 
         nd = &this->ndata[nd->base->id];
-        for (int j = 0, dof = nd->dof; j < nd->n; j++, dof++)
+        for (int j = 0, dof = nd->dof; j < nd->n; j++, dof += this->stride)
           al->add_triplet(this->shapeset->get_constrained_edge_index(surf_num, j + 2, ori, part, e->get_mode()), dof, 1.0);
       }
     }
@@ -514,7 +514,7 @@ namespace Hermes
           nd = &this->ndata[en->id];
           for (k = 0; k < nd->n; k++, edge_dofs++)
           {
-            edge_dofs->dof = nd->dof + k;
+            edge_dofs->dof = nd->dof + k * this->stride;
             edge_dofs->coef = this->shapeset->get_fn_value(this->shapeset->get_edge_index(0, ei[i]->ori, k + 2, e->get_mode()), mid, -1.0, 0, e->get_mode());
           }
         }
@@ -121,19 +121,19 @@ namespace Hermes
           else
           {
             this->ndata[en->id].dof = this->next_dof;
-            this->next_dof += ndofs;
+            this->next_dof += ndofs * this->stride;
             this->edge_functions_count += ndofs;
           }
           else
           {
             this->ndata[en->id].dof = this->next_dof;
-            this->next_dof += ndofs;
+            this->next_dof += ndofs * this->stride;
             this->edge_functions_count += ndofs;
           }
           else
           {
             this->ndata[en->id].dof = this->next_dof;
-            this->next_dof += ndofs;
+            this->next_dof += ndofs * this->stride;
             this->edge_functions_count += ndofs;
           }
         }
@@ -152,7 +152,7 @@ namespace Hermes
         typename Space<Scalar>::ElementData* ed = &this->edata[e->id];
         ed->bdof = this->next_dof;
         ed->n = this->shapeset->get_num_bubbles(ed->order, e->get_mode());
-        this->next_dof += ed->n;
+        this->next_dof += ed->n * this->stride;
         this->bubble_functions_count += ed->n;
       }
     }
@@ -168,7 +168,7 @@ namespace Hermes
         if (nd->dof >= 0)
         {
           int ori = (e->vn[surf_num]->id < e->vn[e->next_vert(surf_num)]->id) ? 0 : 1;
-          for (int j = 0, dof = nd->dof; j < nd->n; j++, dof++)
+          for (int j = 0, dof = nd->dof; j < nd->n; j++, dof += this->stride)
             al->add_triplet(this->shapeset->get_edge_index(surf_num, ori, j, e->get_mode()), dof, 1.0);
         }
         else
@@ -184,7 +184,7 @@ namespace Hermes
         if (part < 0) part ^= ~0;
 
         nd = &this->ndata[nd->base->id]; // ccc
-        for (int j = 0, dof = nd->dof; j < nd->n; j++, dof++)
+        for (int j = 0, dof = nd->dof; j < nd->n; j++, dof += this->stride)
           al->add_triplet(this->shapeset->get_constrained_edge_index(surf_num, j, ori, part, e->get_mode()), dof, 1.0);
       }
     }
@@ -102,7 +102,7 @@ namespace Hermes
         typename Space<Scalar>::ElementData* ed = &this->edata[e->id];
         ed->bdof = this->next_dof;
         ed->n = this->shapeset->get_num_bubbles(ed->order, e->get_mode()); //FIXME: this function might return invalid value because retrieved bubble functions for non-uniform orders might be invalid for the given order.
-        this->next_dof += ed->n;
+        this->next_dof += ed->n * this->stride;
         this->bubble_functions_count += ed->n;
       }
     }
@@ -126,7 +126,7 @@ namespace Hermes
       if (!ed->n) return;
 
       int* indices = this->shapeset->get_bubble_indices(ed->order, e->get_mode());
-      for (int i = 0, dof = ed->bdof; i < ed->n; i++, dof++)
+      for (int i = 0, dof = ed->bdof; i < ed->n; i++, dof += this->stride)
       {
         //printf("triplet: %d, %d, %f\n", *indices, dof, 1.0);
         al->add_triplet(*indices++, dof, 1.0);
@@ -160,11 +160,11 @@ namespace Hermes
       for_all_active_elements(e, this->mesh)
       {
         typename Space<Scalar>::ElementData* ed = &this->edata[e->id];
-        ed->bdof = this->next_dof + e->marker - 1;
+        ed->bdof = this->next_dof + (e->marker - 1) * this->stride;
         ed->n = 1;
         max_marker = std::max(max_marker, e->marker);
       }
-      this->next_dof += max_marker;
+      this->next_dof += max_marker * this->stride;
       this->bubble_functions_count = max_marker;
     }
 
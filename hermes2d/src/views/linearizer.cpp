@@ -17,6 +17,7 @@
 #include "refmap.h"
 #include "traverse.h"
 #include "exact_solution.h"
+#include "load_balancer.h"
 #include "api2d.h"
 
 namespace Hermes
@@ -41,7 +42,8 @@ namespace Hermes
 
       template<typename LinearizerDataDimensions>
       LinearizerMultidimensional<LinearizerDataDimensions>::LinearizerMultidimensional(LinearizerOutputType linearizerOutputType, bool auto_max) :
-        states(nullptr), num_states(0), dmult(1.0), curvature_epsilon(1e-5), linearizerOutputType(linearizerOutputType), criterion(LinearizerCriterionFixed(1))
+        states(nullptr), num_states(0), dmult(1.0), curvature_epsilon(1e-5), linearizerOutputType(linearizerOutputType), criterion(LinearizerCriterionFixed(1)),
+        keep_topology(false), replaying_topology(false), topology_num_states(0)
       {
         xdisp = nullptr;
         user_xdisp = false;
@@ -68,12 +70,21 @@ namespace Hermes
       void LinearizerMultidimensional<LinearizerDataDimensions>::set_criterion(LinearizerCriterion criterion)
       {
         this->criterion = criterion;
+        this->topology_mesh_seqs.clear();
       }
 
       template<typename LinearizerDataDimensions>
       void LinearizerMultidimensional<LinearizerDataDimensions>::set_curvature_epsilon(double curvature_epsilon)
       {
         this->curvature_epsilon = curvature_epsilon;
+        this->topology_mesh_seqs.clear();
+      }
+
+      template<typename LinearizerDataDimensions>
+      void LinearizerMultidimensional<LinearizerDataDimensions>::set_keep_topology(bool to_set)
+      {
+        this->keep_topology = to_set;
+        this->topology_mesh_seqs.clear();
       }
 
       template<typename LinearizerDataDimensions>
@@ -97,6 +108,7 @@ namespace Hermes
         }
         if (xdisp || ydisp)
           this->dmult = dmult;
+        this->topology_mesh_seqs.clear();
       }
 
       template<typename LinearizerDataDimensions>
@@ -170,13 +182,39 @@ namespace Hermes
         Traverse trav_master(ydisp == nullptr ? (xdisp == nullptr ? 1 : 2) : (xdisp == nullptr ? 2 : 3));
         states = trav_master.get_states(this->meshes, this->num_states);
 
+        // The kept topology can be replayed if the meshes have not changed.
+        this->replaying_topology = false;
+        if (this->keep_topology)
+        {
+          Hermes::vector<unsigned int> mesh_seqs;
+          for (unsigned int i = 0; i < this->meshes.size(); i++)
+            mesh_seqs.push_back(this->meshes[i]->get_seq());
+          this->replaying_topology = (mesh_seqs == this->topology_mesh_seqs && this->num_states == this->topology_num_states);
+          this->topology_mesh_seqs = mesh_seqs;
+          this->topology_num_states = this->num_states;
+        }
+        for (int i = 0; i < this->num_threads_used; i++)
+          this->threadLinearizerMultidimensional[i]->replaying = this->replaying_topology;
+
+        // The states are distributed among the threads according to the polynomial orders of the solutions, in contiguous
+        // ranges of equal costs (the processing of a thread depends on its states).
+        LoadBalancer loadBalancer(this->num_states, num_threads_used);
+        if (this->replaying_topology)
+          loadBalancer.set_ranges(&this->topology_thread_ranges[0]);
+        else
+        {
+          for (int state_i = 0; state_i < this->num_states; state_i++)
+            loadBalancer.set_cost(state_i, LoadBalancer::get_evaluation_cost(states[state_i]->e, sln, LinearizerDataDimensions::dimension));
+          loadBalancer.init();
+          this->topology_thread_ranges.assign(loadBalancer.get_ranges(), loadBalancer.get_ranges() + num_threads_used + 1);
+        }
+
 #pragma omp parallel shared(trav_master) num_threads(num_threads_used)
         {
           int thread_number = omp_get_thread_num();
-          int start = (this->num_states / num_threads_used) * thread_number;
-          int end = (this->num_states / num_threads_used) * (thread_number + 1);
-          if (thread_number == num_threads_used - 1)
-            end = this->num_states;
+          int start, end;
+          loadBalancer.get_range(thread_number, start, end);
+          loadBalancer.begin_thread(thread_number);
 
           try
           {
@@ -184,8 +222,12 @@ namespace Hermes
 
             this->threadLinearizerMultidimensional[thread_number]->init_processing(sln, this);
 
-            for (int state_i = start; state_i < end; state_i++)
-              max_value_for_adaptive_refinements = std::max(max_value_for_adaptive_refinements, this->threadLinearizerMultidimensional[thread_number]->get_max_value(states[state_i]));
+            // Only used in the refinement decisions.
+            if (!this->replaying_topology)
+            {
+              for (int state_i = start; state_i < end; state_i++)
+                max_value_for_adaptive_refinements = std::max(max_value_for_adaptive_refinements, this->threadLinearizerMultidimensional[thread_number]->get_max_value(states[state_i]));
+            }
 
             this->threadLinearizerMultidimensional[thread_number]->max_value_approx = max_value_for_adaptive_refinements;
 
@@ -211,8 +253,13 @@ namespace Hermes
 #pragma omp critical (exceptionMessageCaughtInParallelBlock)
             this->exceptionMessageCaughtInParallelBlock = e.what();
           }
+
+          loadBalancer.end_thread(thread_number);
         }
 
+        if (this->report_load_balance)
+          loadBalancer.report(this, "Linearization");
+
         // Free states.
         if (this->states)
         {
@@ -224,6 +271,10 @@ namespace Hermes
           this->num_states = 0;
         }
 
+        // A partially processed topology can not be kept.
+        if (!this->exceptionMessageCaughtInParallelBlock.empty())
+          this->topology_mesh_seqs.clear();
+
         // Finish.
         this->finish(sln);
 
@@ -269,32 +320,135 @@ namespace Hermes
         // regularize the linear mesh
         if (this->exceptionMessageCaughtInParallelBlock.empty())
         {
-          find_min_max();
           // Polish triangle vertex indices for FileExport case.
           if (this->linearizerOutputType == FileExport)
+            this->merge_thread_vertices(this->replaying_topology);
+          find_min_max();
+        }
+
+        // select old quadratrues
+        for (int k = 0; k < LinearizerDataDimensions::dimension; k++)
+          sln[k]->set_quad_2d(old_quad[k]);
+
+        // Unlock data.
+        this->unlock_data();
+      }
+
+      /// Vertex of one of the threads, for sorting by coordinates.
+      struct LinearizerThreadVertex
+      {
+        double x, y;
+        int thread, index;
+      };
+
+      static bool compare_linearizer_thread_vertices(const LinearizerThreadVertex& a, const LinearizerThreadVertex& b)
+      {
+        if (a.x != b.x)
+          return a.x < b.x;
+        if (a.y != b.y)
+          return a.y < b.y;
+        if (a.thread != b.thread)
+          return a.thread < b.thread;
+        return a.index < b.index;
+      }
+
+      template<typename LinearizerDataDimensions>
+      void LinearizerMultidimensional<LinearizerDataDimensions>::merge_thread_vertices(bool reuse_mapping)
+      {
+        ThreadLinearizerMultidimensional<LinearizerDataDimensions>** threads = this->threadLinearizerMultidimensional;
+
+        if (!reuse_mapping)
+        {
+          // Vertices of all threads sorted by coordinates, vertices shared by threads end up next to each other.
+          Hermes::vector<LinearizerThreadVertex> sorted_vertices;
+          for (int i = 0; i < this->num_threads_used; i++)
+          {
+            threads[i]->global_vertex_indices.assign(threads[i]->vertex_count, 0);
+            for (int j = 0; j < threads[i]->vertex_count; j++)
+            {
+              LinearizerThreadVertex vertex = { threads[i]->vertices[j][0], threads[i]->vertices[j][1], i, j };
+              sorted_vertices.push_back(vertex);
+            }
+          }
+          std::sort(sorted_vertices.begin(), sorted_vertices.end(), compare_linearizer_thread_vertices);
+
+          // Mark duplicates (-1 - position of the original in sorted_vertices), also within one thread (the vertices of the
+          // neighbors of a hanging node are not found in the hash table). Vertices with the same coordinates but different
+          // values are discontinuities and are kept.
+          unsigned int group_start = 0;
+          for (unsigned int i = 1; i < sorted_vertices.size(); i++)
+          {
+            LinearizerThreadVertex& vertex = sorted_vertices[i];
+            if (vertex.x != sorted_vertices[group_start].x || vertex.y != sorted_vertices[group_start].y)
+            {
+              group_start = i;
+              continue;
+            }
+            for (unsigned int j = group_start; j < i; j++)
+            {
+              LinearizerThreadVertex& original = sorted_vertices[j];
+              if (threads[original.thread]->global_vertex_indices[original.index] < 0)
+                continue;
+              bool same_value = true;
+              for (int k = 0; k < LinearizerDataDimensions::dimension; k++)
+              {
+                double value = threads[vertex.thread]->vertices[vertex.index][2 + k];
+                double original_value = threads[original.thread]->vertices[original.index][2 + k];
+                if (fabs(value - original_value) > Hermes::HermesSqrtEpsilon * std::max(1., fabs(original_value)))
+                  same_value = false;
+              }
+              if (same_value)
+              {
+                threads[vertex.thread]->global_vertex_indices[vertex.index] = -1 - (int)j;
+                break;
+              }
+            }
+          }
+
+          // Global indices, threads in order.
+          int running_count = 0;
+          for (int i = 0; i < this->num_threads_used; i++)
           {
-            int running_count = 0;
-            for (int i = 0; i < this->num_threads_used; i++)
+            for (int j = 0; j < threads[i]->vertex_count; j++)
             {
-              if (i > 0)
+              int& global_index = threads[i]->global_vertex_indices[j];
+              if (global_index < 0)
               {
-                for (int j = 0; j < this->threadLinearizerMultidimensional[i]->triangle_count; j++)
-                {
-                  for (int k = 0; k < 3; k++)
-                    this->threadLinearizerMultidimensional[i]->triangle_indices[j][k] += running_count;
-                }
+                LinearizerThreadVertex& original = sorted_vertices[-1 - global_index];
+                global_index = threads[original.thread]->global_vertex_indices[original.index];
               }
-              running_count += this->threadLinearizerMultidimensional[i]->vertex_count;
+              else
+                global_index = running_count++;
             }
           }
         }
 
-        // select old quadratrues
-        for (int k = 0; k < LinearizerDataDimensions::dimension; k++)
-          sln[k]->set_quad_2d(old_quad[k]);
+        // Remove the duplicates and renumber the triangles.
+        int running_count = 0;
+        for (int i = 0; i < this->num_threads_used; i++)
+        {
+          int kept_count = 0;
+          for (int j = 0; j < threads[i]->vertex_count; j++)
+          {
+            // The originals are numbered in the order of the vertices, duplicates point back.
+            int global_index = threads[i]->global_vertex_indices[j];
+            if (global_index == running_count + kept_count)
+            {
+              if (global_index - running_count != j)
+                memcpy(threads[i]->vertices[global_index - running_count], threads[i]->vertices[j], sizeof(typename LinearizerDataDimensions::vertex_t));
+              kept_count++;
+            }
+          }
 
-        // Unlock data.
-        this->unlock_data();
+          for (int j = 0; j < threads[i]->triangle_count; j++)
+          {
+            for (int k = 0; k < 3; k++)
+              threads[i]->triangle_indices[j][k] = threads[i]->global_vertex_indices[threads[i]->triangle_indices[j][k]];
+          }
+
+          threads[i]->vertex_count = kept_count;
+          running_count += kept_count;
+        }
       }
 
       template<typename LinearizerDataDimensions>
@@ -330,6 +484,7 @@ namespace Hermes
       {
         for (int i = 0; i < this->num_threads_used; i++)
           this->threadLinearizerMultidimensional[i]->free();
+        this->topology_mesh_seqs.clear();
       }
 
       template<typename LinearizerDataDimensions>
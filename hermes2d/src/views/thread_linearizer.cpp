@@ -38,7 +38,8 @@ namespace Hermes
     namespace Views
     {
       template<typename LinearizerDataDimensions>
-      ThreadLinearizerMultidimensional<LinearizerDataDimensions>::ThreadLinearizerMultidimensional(LinearizerMultidimensional<LinearizerDataDimensions>* linearizer) : user_specified_max(false), user_specified_min(false), criterion(linearizer->criterion)
+      ThreadLinearizerMultidimensional<LinearizerDataDimensions>::ThreadLinearizerMultidimensional(LinearizerMultidimensional<LinearizerDataDimensions>* linearizer) : user_specified_max(false), user_specified_min(false), criterion(linearizer->criterion),
+        keep_topology(false), replaying(false), recorded_vertices_position(0), recorded_splits_position(0), recorded_vertex_count(0)
       {
         vertex_size = 0;
         triangle_size = 0;
@@ -68,6 +69,7 @@ namespace Hermes
         this->user_ydisp = linearizer->user_ydisp;
         this->dmult = linearizer->dmult;
         this->linearizerOutputType = linearizer->linearizerOutputType;
+        this->keep_topology = linearizer->keep_topology;
 
         for (int k = 0; k < LinearizerDataDimensions::dimension; k++)
         {
@@ -91,6 +93,10 @@ namespace Hermes
         free_with_check(this->triangle_markers, true);
         free_with_check(this->hash_table, true);
         free_with_check(this->info, true);
+
+        this->recorded_vertices.clear();
+        this->recorded_splits.clear();
+        this->global_vertex_indices.clear();
       }
 
       template<typename LinearizerDataDimensions>
@@ -146,7 +152,28 @@ namespace Hermes
         }
 
         // Init storage data & counts.
-        this->reallocate(sln[0]->get_mesh());
+        if (this->replaying)
+          this->init_replay();
+        else
+        {
+          // A previously kept topology.
+          free_with_check(this->hash_table, true);
+          free_with_check(this->info, true);
+          this->reallocate(sln[0]->get_mesh());
+          this->recorded_vertices.clear();
+          this->recorded_splits.clear();
+        }
+      }
+
+      template<typename LinearizerDataDimensions>
+      void ThreadLinearizerMultidimensional<LinearizerDataDimensions>::init_replay()
+      {
+        // All vertices are rewritten, triangles and edges are added anew.
+        this->vertex_count = this->recorded_vertex_count;
+        this->triangle_count = 0;
+        this->edges_count = 0;
+        this->recorded_vertices_position = 0;
+        this->recorded_splits_position = 0;
       }
 
       template<typename LinearizerDataDimensions>
@@ -187,8 +214,17 @@ namespace Hermes
         for (unsigned int j = 0; j < (LinearizerDataDimensions::dimension + (this->user_xdisp ? 1 : 0) + (this->user_ydisp ? 1 : 0)); j++)
           delete fns[j];
 
-        free_with_check(this->hash_table, true);
-        free_with_check(this->info, true);
+        // The vertex hash table is needed for the edges in the replay.
+        if (this->keep_topology)
+        {
+          if (!this->replaying)
+            this->recorded_vertex_count = this->vertex_count;
+        }
+        else
+        {
+          free_with_check(this->hash_table, true);
+          free_with_check(this->info, true);
+        }
       }
 
       template<typename LinearizerDataDimensions>
@@ -274,14 +310,20 @@ namespace Hermes
         const double* values[LinearizerDataDimensions::dimension];
         double* physical_x;
         double* physical_y;
-        for (int k = 0; k < LinearizerDataDimensions::dimension; k++)
+        int* vertex_indices = tri_indices[0];
+
+        // In the replay, the values are only needed for the new vertices.
+        int split = this->replaying ? this->recorded_splits[this->recorded_splits_position++] : -1;
+        if (split != 0)
         {
-          fns[k]->set_quad_order(1, item[k]);
-          values[k] = fns[k]->get_values(component[k], value_type[k]);
+          for (int k = 0; k < LinearizerDataDimensions::dimension; k++)
+          {
+            fns[k]->set_quad_order(1, item[k]);
+            values[k] = fns[k]->get_values(component[k], value_type[k]);
+          }
         }
-        int* vertex_indices = tri_indices[0];
 
-        if (curved)
+        if (curved && split != 0)
         {
           // obtain physical element coordinates
           RefMap* refmap = fns[0]->get_refmap();
@@ -313,15 +355,20 @@ namespace Hermes
         };
 
         // determine whether or not to split the element
-        int split;
-        if (level == MAX_LINEARIZER_DIVISION_LEVEL)
-          split = 0;
-        else
+        if (!this->replaying)
         {
-          if (this->criterion.adaptive)
-            this->split_decision(split, iv0, iv1, iv2, 0, rep_element->get_mode(), values, physical_x, physical_y, vertex_indices);
+          if (level == MAX_LINEARIZER_DIVISION_LEVEL)
+            split = 0;
           else
-            split = (level < this->criterion.refinement_level);
+          {
+            if (this->criterion.adaptive)
+              this->split_decision(split, iv0, iv1, iv2, 0, rep_element->get_mode(), values, physical_x, physical_y, vertex_indices);
+            else
+              split = (level < this->criterion.refinement_level);
+          }
+
+          if (this->keep_topology)
+            this->recorded_splits.push_back(split);
         }
 
         // split the triangle if the error is too large, otherwise produce a linear triangle
@@ -386,13 +433,19 @@ namespace Hermes
         double* physical_y;
         int* vertex_indices = quad_indices[0];
         bool flip = this->quad_flip(iv0, iv1, iv2, iv3);
-        for (int k = 0; k < LinearizerDataDimensions::dimension; k++)
+
+        // In the replay, the values are only needed for the new vertices.
+        int split = this->replaying ? this->recorded_splits[this->recorded_splits_position++] : -1;
+        if (split != 0)
         {
-          fns[k]->set_quad_order(1, item[k]);
-          values[k] = fns[k]->get_values(component[k], value_type[k]);
+          for (int k = 0; k < LinearizerDataDimensions::dimension; k++)
+          {
+            fns[k]->set_quad_order(1, item[k]);
+            values[k] = fns[k]->get_values(component[k], value_type[k]);
+          }
         }
 
-        if (curved)
+        if (curved && split != 0)
         {
           // obtain physical element coordinates
           RefMap* refmap = fns[0]->get_refmap();
@@ -432,15 +485,20 @@ namespace Hermes
           (this->vertices[iv1][LinearizerDataDimensions::dimension + 1] + this->vertices[iv3][LinearizerDataDimensions::dimension + 1]) * 0.5;
 
         // determine whether or not to split the element
-        int split;
-        if (level == MAX_LINEARIZER_DIVISION_LEVEL)
-          split = 0;
-        else
+        if (!this->replaying)
         {
-          if (this->criterion.adaptive)
-            this->split_decision(split, iv0, iv1, iv2, 0, rep_element->get_mode(), values, physical_x, physical_y, vertex_indices);
+          if (level == MAX_LINEARIZER_DIVISION_LEVEL)
+            split = 0;
           else
-            split = (level < this->criterion.refinement_level ? 3 : 0);
+          {
+            if (this->criterion.adaptive)
+              this->split_decision(split, iv0, iv1, iv2, 0, rep_element->get_mode(), values, physical_x, physical_y, vertex_indices);
+            else
+              split = (level < this->criterion.refinement_level ? 3 : 0);
+          }
+
+          if (this->keep_topology)
+            this->recorded_splits.push_back(split);
         }
 
         // split the quad if the error is too large, otherwise produce two linear triangles
@@ -715,6 +773,20 @@ namespace Hermes
       template<typename LinearizerDataDimensions>
       int ThreadLinearizerMultidimensional<LinearizerDataDimensions>::get_vertex(int p1, int p2, double x, double y, double* value)
       {
+        // Replay - the vertex is known, only (re-)write the values if this call created it.
+        if (this->replaying)
+        {
+          int recorded = this->recorded_vertices[this->recorded_vertices_position++];
+          if (recorded < 0)
+            return -recorded - 1;
+
+          this->vertices[recorded][0] = x;
+          this->vertices[recorded][1] = y;
+          for (int k = 0; k < LinearizerDataDimensions::dimension; k++)
+            this->vertices[recorded][2 + k] = value[k];
+          return recorded;
+        }
+
         // search for an existing vertex
         if (p1 > p2)
           std::swap(p1, p2);
@@ -736,7 +808,11 @@ namespace Hermes
                   check_value = false;
               }
               if (check_value)
+              {
+                if (this->keep_topology)
+                  this->recorded_vertices.push_back(-i - 1);
                 return i;
+              }
             }
             // note that we won't return a vertex with a different value than the required one;
             // this takes care for discontinuities in the solution, where more vertices
@@ -756,6 +832,8 @@ namespace Hermes
         this->info[i][1] = p2;
         this->info[i][2] = hash_table[index];
         this->hash_table[index] = i;
+        if (this->keep_topology)
+          this->recorded_vertices.push_back(i);
         return i;
       }
 
@@ -282,7 +282,7 @@ namespace Hermes
     }
 
     template<typename Scalar>
-    Form<Scalar>::Form(int i) : scaling_factor(1.0), u_ext_offset(0), wf(nullptr), assembleEverywhere(false), i(i)
+    Form<Scalar>::Form(int i) : scaling_factor(1.0), constant(false), u_ext_offset(0), wf(nullptr), assembleEverywhere(false), i(i)
     {
       areas.push_back(HERMES_ANY);
       stage_time = 0.0;
@@ -329,6 +329,18 @@ namespace Hermes
       this->scaling_factor = scalingFactor;
     }
 
+    template<typename Scalar>
+    void Form<Scalar>::set_constant(bool to_set)
+    {
+      this->constant = to_set;
+    }
+
+    template<typename Scalar>
+    bool Form<Scalar>::is_constant() const
+    {
+      return this->constant;
+    }
+
     template<typename Scalar>
     void Form<Scalar>::set_uExtOffset(int u_ext_offset)
     {
@@ -373,6 +385,7 @@ namespace Hermes
       this->u_ext_offset = other_form->u_ext_offset;
       this->stage_time = other_form->stage_time;
       this->scaling_factor = other_form->scaling_factor;
+      this->constant = other_form->constant;
     }
 
     template<typename Scalar>
@@ -432,6 +445,12 @@ namespace Hermes
       return nullptr;
     }
 
+    template<typename Scalar>
+    bool MatrixFormVol<Scalar>::get_reference_coefficients(Scalar& mass, Scalar diffusion[2][2], Scalar advection[2]) const
+    {
+      return false;
+    }
+
     template<typename Scalar>
     MatrixFormSurf<Scalar>::MatrixFormSurf(unsigned int i, unsigned int j) :
       MatrixForm<Scalar>(i, j)
@@ -15,6 +15,7 @@
 
 #include "weakform_library/weakforms_h1.h"
 #include "weakform_library/integrals_h1.h"
+#include <typeinfo>
 
 namespace Hermes
 {
@@ -161,6 +162,18 @@ namespace Hermes
         return new DefaultMatrixFormVol<Scalar>(this->i, this->j, this->areas, this->coeff, this->sym, this->gt);
       }
 
+      template<typename Scalar>
+      bool DefaultMatrixFormVol<Scalar>::get_reference_coefficients(Scalar& mass, Scalar diffusion[2][2], Scalar advection[2]) const
+      {
+        // Descendants may change value() (the same in the other default forms below).
+        if (typeid(*this) != typeid(DefaultMatrixFormVol<Scalar>) || gt != HERMES_PLANAR || !coeff->is_constant())
+          return false;
+        mass = coeff->value(0., 0.);
+        diffusion[0][0] = diffusion[0][1] = diffusion[1][0] = diffusion[1][1] = 0.;
+        advection[0] = advection[1] = 0.;
+        return true;
+      }
+
       template<typename Scalar>
       DefaultJacobianDiffusion<Scalar>::DefaultJacobianDiffusion(int i, int j, std::string area,
         Hermes1DFunction<Scalar>* coeff,
@@ -294,6 +307,18 @@ namespace Hermes
         return new DefaultJacobianDiffusion<Scalar>(this->i, this->j, this->areas, this->coeff, this->sym, this->gt);
       }
 
+      template<typename Scalar>
+      bool DefaultJacobianDiffusion<Scalar>::get_reference_coefficients(Scalar& mass, Scalar diffusion[2][2], Scalar advection[2]) const
+      {
+        if (typeid(*this) != typeid(DefaultJacobianDiffusion<Scalar>) || gt != HERMES_PLANAR || !coeff->is_constant())
+          return false;
+        mass = 0.;
+        diffusion[0][0] = diffusion[1][1] = coeff->value(0.);
+        diffusion[0][1] = diffusion[1][0] = 0.;
+        advection[0] = advection[1] = 0.;
+        return true;
+      }
+
       template<typename Scalar>
       DefaultMatrixFormDiffusion<Scalar>::DefaultMatrixFormDiffusion(int i, int j, std::string area,
         Hermes1DFunction<Scalar>* coeff,
@@ -392,6 +417,18 @@ namespace Hermes
         return new DefaultMatrixFormDiffusion<Scalar>(this->i, this->j, this->areas, this->coeff, this->sym, this->gt);
       }
 
+      template<typename Scalar>
+      bool DefaultMatrixFormDiffusion<Scalar>::get_reference_coefficients(Scalar& mass, Scalar diffusion[2][2], Scalar advection[2]) const
+      {
+        if (typeid(*this) != typeid(DefaultMatrixFormDiffusion<Scalar>) || gt != HERMES_PLANAR)
+          return false;
+        mass = 0.;
+        diffusion[0][0] = diffusion[1][1] = this->coeff->value(0.);
+        diffusion[0][1] = diffusion[1][0] = 0.;
+        advection[0] = advection[1] = 0.;
+        return true;
+      }
+
       template<typename Scalar>
       DefaultJacobianAdvection<Scalar>::DefaultJacobianAdvection(int i, int j, std::string area,
         Hermes1DFunction<Scalar>* coeff1,
@@ -495,6 +532,18 @@ namespace Hermes
         return new DefaultJacobianAdvection<Scalar>(this->i, this->j, this->areas, this->coeff1, this->coeff2, this->gt);
       }
 
+      template<typename Scalar>
+      bool DefaultJacobianAdvection<Scalar>::get_reference_coefficients(Scalar& mass, Scalar diffusion[2][2], Scalar advection[2]) const
+      {
+        if (typeid(*this) != typeid(DefaultJacobianAdvection<Scalar>) || !coeff1->is_constant() || !coeff2->is_constant())
+          return false;
+        mass = 0.;
+        diffusion[0][0] = diffusion[0][1] = diffusion[1][0] = diffusion[1][1] = 0.;
+        advection[0] = coeff1->value(0.);
+        advection[1] = coeff2->value(0.);
+        return true;
+      }
+
       template<typename Scalar>
       DefaultVectorFormVol<Scalar>::DefaultVectorFormVol(int i, std::string area,
         Hermes2DFunction<Scalar>* coeff,
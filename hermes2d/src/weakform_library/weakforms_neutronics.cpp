@@ -15,6 +15,7 @@
 
 #include "weakform_library/weakforms_neutronics.h"
 #include "weakform_library/integrals_h1.h"
+#include "discrete_problem.h"
 
 #include <algorithm>
 #include <iomanip>
@@ -895,7 +896,7 @@ namespace Hermes
 
         namespace SupportClasses
         {
-          void SourceFilter::filter_fn(int n, Hermes::vector<double*> values, double* result)
+          void SourceFilter::filter_fn(int n, const Hermes::vector<double*>& values, double* result)
           {
             for (int i = 0; i < n; i++)
             {
@@ -904,6 +905,360 @@ namespace Hermes
                 result[i] += nu[j] * Sigma_f[j] * values.at(j)[i];
             }
           }
+
+          /// c = a + factor * b, the matrices are assembled on the same spaces (sorted row indices in the columns).
+          static CSCMatrix<double>* add_csc_matrices(CSCMatrix<double>* a, CSCMatrix<double>* b, double factor)
+          {
+            int size = a->get_size();
+            int* a_Ap = a->get_Ap(), *a_Ai = a->get_Ai(), *b_Ap = b->get_Ap(), *b_Ai = b->get_Ai();
+            double* a_Ax = a->get_Ax(), *b_Ax = b->get_Ax();
+
+            int* Ap = malloc_with_check<int>(size + 1);
+            int* Ai = malloc_with_check<int>(a->get_nnz() + b->get_nnz());
+            double* Ax = malloc_with_check<double>(a->get_nnz() + b->get_nnz());
+            int nnz = 0;
+            for (int col = 0; col < size; col++)
+            {
+              Ap[col] = nnz;
+              int i = a_Ap[col], j = b_Ap[col];
+              while (i < a_Ap[col + 1] || j < b_Ap[col + 1])
+              {
+                int a_row = (i < a_Ap[col + 1]) ? a_Ai[i] : size;
+                int b_row = (j < b_Ap[col + 1]) ? b_Ai[j] : size;
+                Ai[nnz] = std::min(a_row, b_row);
+                Ax[nnz] = 0.;
+                if (a_row <= b_row)
+                  Ax[nnz] += a_Ax[i++];
+                if (b_row <= a_row)
+                  Ax[nnz] += factor * b_Ax[j++];
+                nnz++;
+              }
+            }
+            Ap[size] = nnz;
+
+            CSCMatrix<double>* c = new CSCMatrix<double>();
+            c->create(size, nnz, Ap, Ai, Ax);
+            free_with_check(Ap);
+            free_with_check(Ai);
+            free_with_check(Ax);
+            return c;
+          }
+
+          CriticalityIteration::CriticalityIteration(const MaterialProperties::Diffusion::MaterialPropertyMaps& matprop, WeakForm<double>* wf,
+            Hermes::vector<SpaceSharedPtr<double> > spaces, GeomType geom_type)
+            : wf(wf), fission_wf(nullptr), spaces(spaces), ndof(Space<double>::get_num_dofs(spaces)),
+            diffusion_matrix(nullptr), fission_matrix(nullptr), operator_matrix(nullptr), solver_matrix(nullptr), rhs(nullptr), matrix_solver(nullptr), shift_keff(0.),
+            keff_tol(1e-6), flux_tol(1e-5), max_iterations(500),
+            wielandt_delta_keff(0.), wielandt_power_iterations(5), chebyshev(false), chebyshev_cycle_length(6), chebyshev_power_iterations(5),
+            keff(1.), num_iters(0), sln_vector(nullptr)
+          {
+            if (spaces.size() != matprop.get_G())
+              throw Hermes::Exceptions::Exception(MaterialProperties::Messages::E_INVALID_SIZE);
+
+            bool1 chi_nnz = matprop.get_fission_multigroup_structure();
+            this->fission_wf = new WeakForm<double>(matprop.get_G());
+            for (unsigned int gto = 0; gto < matprop.get_G(); gto++)
+            {
+              if (!chi_nnz[gto])
+                continue;
+              for (unsigned int gfrom = 0; gfrom < matprop.get_G(); gfrom++)
+                this->fission_wf->add_matrix_form(new ElementaryForms::Diffusion::FissionYield::Jacobian<double>(gto, gfrom, matprop, spaces[gto]->get_mesh(), geom_type));
+            }
+          }
+
+          CriticalityIteration::~CriticalityIteration()
+          {
+            delete this->fission_wf;
+            delete this->matrix_solver;
+            delete this->solver_matrix;
+            if (this->operator_matrix != this->diffusion_matrix)
+              delete this->operator_matrix;
+            delete this->diffusion_matrix;
+            delete this->fission_matrix;
+            delete this->rhs;
+            free_with_check(this->sln_vector);
+          }
+
+          void CriticalityIteration::set_tolerance(double keff_tol, double flux_tol)
+          {
+            this->keff_tol = keff_tol;
+            this->flux_tol = flux_tol;
+          }
+
+          void CriticalityIteration::set_max_iterations(int max_iterations)
+          {
+            if (max_iterations < 1)
+              throw Hermes::Exceptions::ValueException("max_iterations", max_iterations, 1);
+            this->max_iterations = max_iterations;
+          }
+
+          void CriticalityIteration::set_wielandt_shift(double delta_keff, int power_iterations)
+          {
+            this->wielandt_delta_keff = delta_keff;
+            this->wielandt_power_iterations = std::max(power_iterations, 1);
+          }
+
+          void CriticalityIteration::set_chebyshev_extrapolation(bool to_set, int cycle_length, int power_iterations)
+          {
+            if (cycle_length < 2)
+              throw Hermes::Exceptions::ValueException("cycle_length", cycle_length, 2);
+            this->chebyshev = to_set;
+            this->chebyshev_cycle_length = cycle_length;
+            // Two iterates differences are needed for the dominance ratio estimate.
+            this->chebyshev_power_iterations = std::max(power_iterations, 3);
+          }
+
+          double CriticalityIteration::get_keff() const
+          {
+            return this->keff;
+          }
+
+          int CriticalityIteration::get_num_iters() const
+          {
+            return this->num_iters;
+          }
+
+          double* CriticalityIteration::get_sln_vector()
+          {
+            return this->sln_vector;
+          }
+
+          const Hermes::vector<double>& CriticalityIteration::get_keff_history() const
+          {
+            return this->keff_history;
+          }
+
+          const Hermes::vector<double>& CriticalityIteration::get_iteration_times() const
+          {
+            return this->iteration_times;
+          }
+
+          void CriticalityIteration::assemble()
+          {
+            // The groups are numbered one after another (as in the solvers).
+            Space<double>::assign_dofs(this->spaces);
+
+            this->diffusion_matrix = new CSCMatrix<double>();
+            DiscreteProblem<double> dp_diffusion(this->wf, this->spaces);
+            dp_diffusion.assemble(this->diffusion_matrix);
+
+            // FissionYield::Jacobian is -F (the residual form L - F).
+            this->fission_matrix = new CSCMatrix<double>();
+            DiscreteProblem<double> dp_fission(this->fission_wf, this->spaces);
+            dp_fission.assemble(this->fission_matrix);
+            if (this->fission_matrix->get_size() != this->ndof)
+              throw Hermes::Exceptions::Exception("CriticalityIteration: there is no fission source.");
+
+            this->rhs = new SimpleVector<double>(this->ndof);
+          }
+
+          void CriticalityIteration::factorize(double shift_keff)
+          {
+            delete this->matrix_solver;
+            delete this->solver_matrix;
+            this->solver_matrix = nullptr;
+            if (this->operator_matrix != this->diffusion_matrix)
+              delete this->operator_matrix;
+
+            this->shift_keff = shift_keff;
+            if (shift_keff > 0.)
+              this->operator_matrix = add_csc_matrices(this->diffusion_matrix, this->fission_matrix, 1. / shift_keff);
+            else
+              this->operator_matrix = this->diffusion_matrix;
+
+#ifdef WITH_UMFPACK
+            this->matrix_solver = new Hermes::Solvers::UMFPackLinearMatrixSolver<double>(this->operator_matrix, this->rhs);
+#else
+            // The solver casts the matrix to its own type.
+            this->solver_matrix = create_matrix<double>(true);
+            this->operator_matrix->copy_to(this->solver_matrix);
+            this->matrix_solver = Hermes::Solvers::create_linear_solver<double>(this->solver_matrix, this->rhs, true);
+#endif
+          }
+
+          void CriticalityIteration::multiply_fission(const double* x, double* result) const
+          {
+            int* Ap = this->fission_matrix->get_Ap();
+            int* Ai = this->fission_matrix->get_Ai();
+            double* Ax = this->fission_matrix->get_Ax();
+            memset(result, 0, this->ndof * sizeof(double));
+            for (int col = 0; col < this->ndof; col++)
+            {
+              for (int k = Ap[col]; k < Ap[col + 1]; k++)
+                result[Ai[k]] -= Ax[k] * x[col];
+            }
+          }
+
+          double CriticalityIteration::source_iteration(const double* flux, double* next_flux)
+          {
+            double* source = this->rhs->v;
+            this->multiply_fission(flux, source);
+            double total_source = 0.;
+            for (int i = 0; i < this->ndof; i++)
+              total_source += source[i];
+
+            // The factorization is done in the first solve and reused in all others.
+            this->matrix_solver->solve();
+            this->matrix_solver->set_reuse_scheme(Hermes::Solvers::HERMES_REUSE_MATRIX_STRUCTURE_COMPLETELY);
+            memcpy(next_flux, this->matrix_solver->get_sln_vector(), this->ndof * sizeof(double));
+
+            // The eigenvalue of the iteration operator (L - F / ke)^-1 F from the fission sources.
+            this->multiply_fission(next_flux, source);
+            double next_total_source = 0.;
+            for (int i = 0; i < this->ndof; i++)
+              next_total_source += source[i];
+            double gamma = next_total_source / total_source;
+
+            for (int i = 0; i < this->ndof; i++)
+              next_flux[i] *= 1. / gamma;
+
+            // gamma = 1 / (1 / keff - 1 / ke).
+            return (this->shift_keff > 0.) ? 1. / (1. / this->shift_keff + 1. / gamma) : gamma;
+          }
+
+          bool CriticalityIteration::solve(double* initial_flux)
+          {
+            this->tick();
+            if (!this->diffusion_matrix)
+              this->assemble();
+            this->factorize(0.);
+            this->tick();
+            this->info("\tCriticalityIteration: %i DOFs, assembling and factorization setup %f s.", this->ndof, this->last());
+
+            this->keff_history.clear();
+            this->iteration_times.clear();
+            free_with_check(this->sln_vector);
+            this->sln_vector = malloc_with_check<double>(this->ndof);
+            double* flux = this->sln_vector;
+            double* next_flux = malloc_with_check<double>(this->ndof);
+            double* previous_flux = malloc_with_check<double>(this->ndof);
+
+            // Normalization: the sum of the fission source is one.
+            for (int i = 0; i < this->ndof; i++)
+              flux[i] = initial_flux ? initial_flux[i] : 1.;
+            this->multiply_fission(flux, next_flux);
+            double total_source = 0.;
+            for (int i = 0; i < this->ndof; i++)
+              total_source += next_flux[i];
+            if (total_source == 0.)
+              throw Hermes::Exceptions::Exception("CriticalityIteration: zero fission source of the initial flux.");
+            for (int i = 0; i < this->ndof; i++)
+              flux[i] /= total_source;
+            memcpy(previous_flux, flux, this->ndof * sizeof(double));
+
+            // Plain iterations with the current operator, the last two flux changes (for the dominance ratio).
+            int plain_iterations = 0;
+            double flux_change = 0., previous_flux_change = 0.;
+            // Chebyshev cycle: position in the cycle, dominance ratio, flux change at the cycle start.
+            int chebyshev_position = -1;
+            double dominance_ratio = 0., cycle_start_flux_change = 0.;
+
+            bool converged = false;
+            double keff_old = 0.;
+            for (this->num_iters = 1; this->num_iters <= this->max_iterations && !converged; this->num_iters++)
+            {
+              this->tick();
+
+              if (this->wielandt_delta_keff > 0. && this->shift_keff == 0. && this->num_iters > this->wielandt_power_iterations)
+              {
+                this->factorize(this->keff + this->wielandt_delta_keff);
+                this->info("\tCriticalityIteration: Wielandt shift ke = %f.", this->shift_keff);
+                plain_iterations = 0;
+                chebyshev_position = -1;
+              }
+
+              double keff_new = this->source_iteration(flux, next_flux);
+
+              // Chebyshev extrapolation, x_(p+1) = x_p + alpha (G x_p - x_p) + beta (x_p - x_(p-1)).
+              bool wielandt_pending = (this->wielandt_delta_keff > 0. && this->shift_keff == 0.);
+              if (this->chebyshev && !wielandt_pending && chebyshev_position < 0 && plain_iterations >= this->chebyshev_power_iterations)
+              {
+                dominance_ratio = flux_change / previous_flux_change;
+                if (dominance_ratio > 0. && dominance_ratio < 1.)
+                {
+                  chebyshev_position = 0;
+                  cycle_start_flux_change = flux_change;
+                }
+              }
+              if (chebyshev_position >= 0)
+              {
+                double alpha, beta;
+                if (chebyshev_position == 0)
+                {
+                  alpha = 2. / (2. - dominance_ratio);
+                  beta = 0.;
+                }
+                else
+                {
+                  double gamma = acosh(2. / dominance_ratio - 1.);
+                  alpha = 4. / dominance_ratio * cosh(chebyshev_position * gamma) / cosh((chebyshev_position + 1) * gamma);
+                  beta = cosh((chebyshev_position - 1) * gamma) / cosh((chebyshev_position + 1) * gamma);
+                }
+                for (int i = 0; i < this->ndof; i++)
+                  next_flux[i] = flux[i] + alpha * (next_flux[i] - flux[i]) + beta * (flux[i] - previous_flux[i]);
+                chebyshev_position++;
+              }
+              else
+                plain_iterations++;
+
+              double flux_norm = 0.;
+              previous_flux_change = flux_change;
+              flux_change = 0.;
+              for (int i = 0; i < this->ndof; i++)
+              {
+                flux_change += (next_flux[i] - flux[i]) * (next_flux[i] - flux[i]);
+                flux_norm += next_flux[i] * next_flux[i];
+              }
+              flux_change = sqrt(flux_change);
+
+              // End of the Chebyshev cycle: if the flux converged slower than the Chebyshev polynomial
+              // predicts, the dominance ratio is underestimated; the estimate from the observed reduction.
+              if (chebyshev_position == this->chebyshev_cycle_length)
+              {
+                double gamma = acosh(2. / dominance_ratio - 1.);
+                double predicted = 1. / cosh(this->chebyshev_cycle_length * gamma);
+                double reduction = flux_change / cycle_start_flux_change;
+                if (reduction > predicted)
+                {
+                  double z = cosh(acosh(reduction / predicted) / this->chebyshev_cycle_length);
+                  dominance_ratio = std::min(0.5 * dominance_ratio * (1. + z), 0.999);
+                }
+                chebyshev_position = 0;
+                cycle_start_flux_change = flux_change;
+              }
+
+              double* swap = previous_flux;
+              previous_flux = flux;
+              flux = next_flux;
+              next_flux = swap;
+
+              keff_old = this->keff;
+              this->keff = keff_new;
+              converged = this->num_iters > 1 && std::abs(keff_new - keff_old) < this->keff_tol * keff_new && flux_change < this->flux_tol * sqrt(flux_norm);
+
+              this->tick();
+              this->keff_history.push_back(keff_new);
+              this->iteration_times.push_back(this->last());
+              this->info("\tCriticalityIteration: iteration %i, keff = %.10f, keff change %g, flux change %g, %f s.",
+                this->num_iters, keff_new, std::abs(keff_new - keff_old) / keff_new, flux_change / sqrt(flux_norm), this->last());
+            }
+            this->num_iters--;
+
+            if (flux != this->sln_vector)
+            {
+              memcpy(this->sln_vector, flux, this->ndof * sizeof(double));
+              if (next_flux == this->sln_vector)
+                next_flux = flux;
+              else
+                previous_flux = flux;
+            }
+            free_with_check(next_flux);
+            free_with_check(previous_flux);
+
+            if (!converged)
+              this->warn("CriticalityIteration: not converged in %i iterations.", this->max_iterations);
+            return converged;
+          }
         }
       }
       namespace Monoenergetic
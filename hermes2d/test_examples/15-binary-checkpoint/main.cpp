@@ -0,0 +1,121 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+
+// Saves a refined curved mesh, an H1 space and a solution in the binary checkpoint format,
+// compares the loading times with the XML (and BSON) formats and checks that the data loaded
+// from the binary files are identical to the original ones.
+
+const int INIT_REF_NUM = 6;
+const int P_INIT = 3;
+
+static bool compare_solutions(MeshFunctionSharedPtr<double> sln, MeshFunctionSharedPtr<double> sln_loaded)
+{
+  for (int i = 1; i < 10; i++)
+  {
+    for (int j = 1; j < 10; j++)
+    {
+      Func<double>* value = sln->get_pt_value(i / 10., j / 10.);
+      Func<double>* value_loaded = sln_loaded->get_pt_value(i / 10., j / 10.);
+      bool equal = std::abs(value->val[0] - value_loaded->val[0]) < 1e-12;
+      delete value;
+      delete value_loaded;
+      if (!equal)
+        return false;
+    }
+  }
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  Hermes::Mixins::TimeMeasurable cpu_time;
+
+  // Load and refine the mesh.
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("domain.mesh", mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh->refine_all_elements();
+
+  // Space and a solution with an arbitrary coefficient vector.
+  SpaceSharedPtr<double> space(new H1Space<double>(mesh, P_INIT));
+  int ndof = space->get_num_dofs();
+  double* coeff_vec = new double[ndof];
+  for (int i = 0; i < ndof; i++)
+    coeff_vec[i] = std::sin((double)i);
+  MeshFunctionSharedPtr<double> sln(new Solution<double>());
+  Solution<double>::vector_to_solution(coeff_vec, space, sln);
+  delete[] coeff_vec;
+
+  // XML.
+  MeshReaderH2DXML mloader_xml;
+  mloader_xml.save("checkpoint-mesh.xml", mesh);
+  space->save("checkpoint-space.xml");
+  ((Solution<double>*)sln.get())->save("checkpoint-sln.xml");
+
+  cpu_time.tick();
+  MeshSharedPtr mesh_xml(new Mesh);
+  mloader_xml.load("checkpoint-mesh.xml", mesh_xml);
+  SpaceSharedPtr<double> space_xml = Space<double>::load("checkpoint-space.xml", mesh_xml);
+  MeshFunctionSharedPtr<double> sln_xml(new Solution<double>());
+  ((Solution<double>*)sln_xml.get())->load("checkpoint-sln.xml", space_xml);
+  cpu_time.tick();
+  std::cout << "XML loading: " << cpu_time.last() << " s." << std::endl;
+
+#ifdef WITH_BSON
+  // BSON.
+  MeshReaderH2DBSON mloader_bson;
+  mloader_bson.save("checkpoint-mesh.bson", mesh);
+  space->save_bson("checkpoint-space.bson");
+  ((Solution<double>*)sln.get())->save_bson("checkpoint-sln.bson");
+
+  cpu_time.tick();
+  MeshSharedPtr mesh_bson(new Mesh);
+  mloader_bson.load("checkpoint-mesh.bson", mesh_bson);
+  SpaceSharedPtr<double> space_bson = Space<double>::load_bson("checkpoint-space.bson", mesh_bson);
+  MeshFunctionSharedPtr<double> sln_bson(new Solution<double>());
+  ((Solution<double>*)sln_bson.get())->load_bson("checkpoint-sln.bson", space_bson);
+  cpu_time.tick();
+  std::cout << "BSON loading: " << cpu_time.last() << " s." << std::endl;
+#endif
+
+  // Binary.
+  MeshReaderH2DBinary mloader_binary;
+  mloader_binary.save("checkpoint-mesh.h2db", mesh);
+  space->save_binary("checkpoint-space.h2db");
+  ((Solution<double>*)sln.get())->save_binary("checkpoint-sln.h2db");
+
+  cpu_time.tick();
+  MeshSharedPtr mesh_binary(new Mesh);
+  mloader_binary.load("checkpoint-mesh.h2db", mesh_binary);
+  SpaceSharedPtr<double> space_binary = Space<double>::load_binary("checkpoint-space.h2db", mesh_binary);
+  MeshFunctionSharedPtr<double> sln_binary(new Solution<double>());
+  ((Solution<double>*)sln_binary.get())->load_binary("checkpoint-sln.h2db", space_binary);
+  cpu_time.tick();
+  std::cout << "Binary loading: " << cpu_time.last() << " s." << std::endl;
+
+  // Checks.
+  if (mesh_binary->get_num_elements() != mesh->get_num_elements() || mesh_binary->get_num_active_elements() != mesh->get_num_active_elements()
+    || mesh_binary->get_max_element_id() != mesh->get_max_element_id())
+  {
+    std::cout << "Failure - mesh!";
+    return -1;
+  }
+
+  if (space_binary->get_num_dofs() != ndof)
+  {
+    std::cout << "Failure - space!";
+    return -1;
+  }
+
+  if (!compare_solutions(sln, sln_binary))
+  {
+    std::cout << "Failure - solution!";
+    return -1;
+  }
+
+  std::cout << "Success!";
+  return 0;
+}
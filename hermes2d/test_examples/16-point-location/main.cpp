@@ -0,0 +1,157 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+
+// Point location on a strongly graded mesh: compares the lookup latency of the spatial index (MeshHashGrid)
+// with the search through all elements, checks that both find the same elements, also after the index has
+// been updated by refinements and unrefinements. The updates are repeated on a mesh of curvilinear elements,
+// whose bounding boxes are sampled, so that no unrefined son stays in the index.
+
+// Number of refinements towards the corner (0, 0).
+const int GRADING_LEVELS = 16;
+const int POINT_COUNT = 20000;
+
+// Refines all active elements having the vertex (0, 0).
+static void refine_towards_corner(MeshSharedPtr mesh)
+{
+  Hermes::vector<int> ids;
+  Element* e;
+  for_all_active_elements(e, mesh)
+  {
+    for (unsigned int i = 0; i < e->get_nvert(); i++)
+    if (e->vn[i]->x == 0. && e->vn[i]->y == 0.)
+      ids.push_back(e->id);
+  }
+  for (unsigned int i = 0; i < ids.size(); i++)
+    mesh->refine_element_id(ids[i]);
+}
+
+static bool check_points(MeshSharedPtr mesh, const double* x, const double* y)
+{
+  Hermes::Mixins::TimeMeasurable cpu_time;
+
+  Element** hash_grid_elements = new Element*[POINT_COUNT];
+  cpu_time.tick();
+  for (int i = 0; i < POINT_COUNT; i++)
+    hash_grid_elements[i] = RefMap::element_on_physical_coordinates(true, mesh, x[i], y[i]);
+  cpu_time.tick();
+  std::cout << "Elements: " << mesh->get_num_active_elements() << ", lookup (index): " << cpu_time.last() / POINT_COUNT * 1e6 << " us, ";
+
+  bool success = true;
+  cpu_time.tick();
+  for (int i = 0; i < POINT_COUNT; i++)
+  if (RefMap::element_on_physical_coordinates(false, mesh, x[i], y[i]) != hash_grid_elements[i])
+    success = false;
+  cpu_time.tick();
+  std::cout << "lookup (search): " << cpu_time.last() / POINT_COUNT * 1e6 << " us." << std::endl;
+
+  delete[] hash_grid_elements;
+  return success;
+}
+
+// Refinements and unrefinements of the curvilinear elements in the half y > x of the annulus, the points are
+// checked after each of them.
+static bool check_curved(const double* x, const double* y)
+{
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("annulus.mesh", mesh);
+  mesh->refine_all_elements();
+  mesh->refine_all_elements();
+
+  bool success = check_points(mesh, x, y);
+  for (int cycle = 0; cycle < 3; cycle++)
+  {
+    Hermes::vector<int> ids;
+    Element* e;
+    for_all_active_elements(e, mesh)
+    if (e->vn[0]->y > e->vn[0]->x)
+      ids.push_back(e->id);
+    for (unsigned int i = 0; i < ids.size(); i++)
+      mesh->refine_element_id(ids[i]);
+    success = success && check_points(mesh, x, y);
+
+    ids.clear();
+    for_all_inactive_elements(e, mesh)
+    {
+      bool leaf_sons = true;
+      for (int i = 0; i < 4; i++)
+      if (e->sons[i] && !e->sons[i]->active)
+        leaf_sons = false;
+      if (leaf_sons && e->vn[0]->y > e->vn[0]->x)
+        ids.push_back(e->id);
+    }
+    for (unsigned int i = 0; i < ids.size(); i++)
+      mesh->unrefine_element_id(ids[i]);
+    success = success && check_points(mesh, x, y);
+  }
+  return success;
+}
+
+int main(int argc, char* argv[])
+{
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("square.mesh", mesh);
+  mesh->refine_all_elements();
+  mesh->refine_all_elements();
+  for (int i = 0; i < GRADING_LEVELS; i++)
+    refine_towards_corner(mesh);
+
+  // Points, half of them concentrated in the graded corner.
+  double* x = new double[POINT_COUNT];
+  double* y = new double[POINT_COUNT];
+  srand(12345);
+  for (int i = 0; i < POINT_COUNT; i++)
+  {
+    double scale = (i % 2) ? 1. : 1e-3;
+    x[i] = scale * rand() / RAND_MAX;
+    y[i] = scale * rand() / RAND_MAX;
+  }
+
+  bool success = check_points(mesh, x, y);
+
+  // Incremental updates of the index.
+  refine_towards_corner(mesh);
+  success = success && check_points(mesh, x, y);
+
+  Element* e;
+  Hermes::vector<int> ids;
+  for_all_inactive_elements(e, mesh)
+  {
+    bool leaf_sons = true;
+    for (int i = 0; i < 4; i++)
+    if (e->sons[i] && !e->sons[i]->active)
+      leaf_sons = false;
+    if (leaf_sons && e->vn[0]->x + e->vn[0]->y > 0.5)
+      ids.push_back(e->id);
+  }
+  for (unsigned int i = 0; i < ids.size(); i++)
+    mesh->unrefine_element_id(ids[i]);
+  success = success && check_points(mesh, x, y);
+
+  // Points in the annulus.
+  for (int i = 0; i < POINT_COUNT; i++)
+  {
+    double r = 1. + (double)rand() / RAND_MAX;
+    double phi = M_PI / 2. * rand() / RAND_MAX;
+    x[i] = r * std::cos(phi);
+    y[i] = r * std::sin(phi);
+  }
+  success = success && check_curved(x, y);
+
+  delete[] x;
+  delete[] y;
+
+  if (success)
+  {
+    std::cout << "Success!";
+    return 0;
+  }
+  else
+  {
+    std::cout << "Failure!";
+    return -1;
+  }
+}
@@ -0,0 +1,188 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+
+// Uniform refinements of a square up to more than a million elements: measures the time of refine_all_elements()
+// (dominated by the vertex and edge node lookups in the mesh hash tables), of the mesh copy and of the unrefinement,
+// checks that every active element finds its own edge nodes and that no vertex node has been duplicated.
+// refine_all_elements() (node searches made in advance in parallel) has to give the same mesh as refining the elements
+// one by one (refine_by_criterion()), also on a mesh with triangles, a curved edge and hanging nodes.
+
+const int REFINEMENTS = 10;
+
+// Exposes the vertex node search.
+class TestMesh : public Mesh
+{
+public:
+  using Mesh::peek_vertex_node;
+};
+
+static int refine_all_criterion(Element* e)
+{
+  return 0;
+}
+
+static bool same_nodes(Node* a, Node* b)
+{
+  if ((a == nullptr) != (b == nullptr))
+    return false;
+  return a == nullptr || a->id == b->id;
+}
+
+static bool same_elements(Element* a, Element* b)
+{
+  if ((a == nullptr) != (b == nullptr))
+    return false;
+  return a == nullptr || a->id == b->id;
+}
+
+// Same elements and nodes (with the same ids, bitwise the same coordinates), the nodes are found in the tables.
+static bool same_meshes(TestMesh* a, TestMesh* b)
+{
+  if (a->get_max_element_id() != b->get_max_element_id() || a->get_max_node_id() != b->get_max_node_id()
+    || a->get_num_active_elements() != b->get_num_active_elements())
+    return false;
+
+  for (int id = 0; id < a->get_max_element_id(); id++)
+  {
+    Element* ea = a->get_element_fast(id), *eb = b->get_element_fast(id);
+    if (ea->used != eb->used)
+      return false;
+    if (!ea->used)
+      continue;
+    if (ea->active != eb->active || ea->marker != eb->marker || ea->get_nvert() != eb->get_nvert() || !same_elements(ea->parent, eb->parent)
+      || ea->is_curved() != eb->is_curved() || ea->area != eb->area || ea->diameter != eb->diameter || ea->iro_cache != eb->iro_cache)
+      return false;
+    for (unsigned int i = 0; i < ea->get_nvert(); i++)
+    {
+      if (!same_nodes(ea->vn[i], eb->vn[i]))
+        return false;
+      if (ea->active && !same_nodes(ea->en[i], eb->en[i]))
+        return false;
+    }
+    for (int i = 0; !ea->active && i < H2D_MAX_ELEMENT_SONS; i++)
+    {
+      if (!same_elements(ea->sons[i], eb->sons[i]))
+        return false;
+    }
+  }
+
+  for (int id = 0; id < a->get_max_node_id(); id++)
+  {
+    Node* na = a->get_node(id), *nb = b->get_node(id);
+    if (na->used != nb->used)
+      return false;
+    if (!na->used)
+      continue;
+    if (na->type != nb->type || na->ref != nb->ref || na->bnd != nb->bnd || na->p1 != nb->p1 || na->p2 != nb->p2)
+      return false;
+    if (na->type == HERMES_TYPE_VERTEX)
+    {
+      if (na->x != nb->x || na->y != nb->y)
+        return false;
+      if (na->p1 >= 0 && a->peek_vertex_node(na->p1, na->p2) != na)
+        return false;
+    }
+    else
+    {
+      if (na->marker != nb->marker || !same_elements(na->elem[0], nb->elem[0]) || !same_elements(na->elem[1], nb->elem[1]))
+        return false;
+      if (a->peek_edge_node(na->p1, na->p2) != na)
+        return false;
+    }
+  }
+  return true;
+}
+
+// Refines the mesh by refine_all_elements() and a copy element by element, compares them.
+static bool check_refine_all_elements(MeshSharedPtr mesh)
+{
+  MeshSharedPtr mesh_serial(new TestMesh);
+  mesh_serial->copy(mesh);
+  mesh->refine_all_elements();
+  mesh_serial->refine_by_criterion(refine_all_criterion);
+  return same_meshes((TestMesh*)mesh.get(), (TestMesh*)mesh_serial.get());
+}
+
+// Every edge node of an active element is found by its vertices.
+static bool check_edge_nodes(MeshSharedPtr mesh)
+{
+  Element* e;
+  for_all_active_elements(e, mesh)
+  {
+    for (unsigned int i = 0; i < e->get_nvert(); i++)
+    if (mesh->peek_edge_node(e->vn[i]->id, e->vn[e->next_vert(i)]->id) != e->en[i])
+      return false;
+  }
+  return true;
+}
+
+int main(int argc, char* argv[])
+{
+  MeshSharedPtr mesh(new TestMesh);
+  MeshReaderH2D mloader;
+  mloader.load("square.mesh", mesh);
+
+  Hermes::Mixins::TimeMeasurable cpu_time;
+  bool success = true;
+
+  for (int i = 0; i < REFINEMENTS; i++)
+  {
+    cpu_time.tick();
+    mesh->refine_all_elements();
+    cpu_time.tick();
+    std::cout << "Elements: " << mesh->get_num_active_elements() << ", refine_all_elements: " << cpu_time.last() << " s." << std::endl;
+  }
+
+  // A grid of n x n quads.
+  int n = 1 << REFINEMENTS;
+  success = success && (mesh->get_num_active_elements() == n * n);
+  success = success && (mesh->get_num_vertex_nodes() == (n + 1) * (n + 1));
+  success = success && check_edge_nodes(mesh);
+
+  MeshSharedPtr mesh_copy(new Mesh);
+  cpu_time.tick();
+  mesh_copy->copy(mesh);
+  cpu_time.tick();
+  std::cout << "Mesh copy: " << cpu_time.last() << " s." << std::endl;
+  success = success && check_edge_nodes(mesh_copy);
+
+  cpu_time.tick();
+  mesh->unrefine_all_elements();
+  cpu_time.tick();
+  std::cout << "unrefine_all_elements: " << cpu_time.last() << " s." << std::endl;
+  success = success && (mesh->get_num_active_elements() == n * n / 4);
+  success = success && check_edge_nodes(mesh);
+
+  // Regular (after the unrefinement) and with hanging nodes.
+  bool same = check_refine_all_elements(mesh);
+  mesh->refine_towards_vertex(0, 3);
+  same = same && check_refine_all_elements(mesh);
+
+  MeshSharedPtr mixed_mesh(new TestMesh);
+  mloader.load("mixed.mesh", mixed_mesh);
+  for (int i = 0; i < 2; i++)
+    same = same && check_refine_all_elements(mixed_mesh);
+  Element* e;
+  int last_active_id = -1;
+  for_all_active_elements(e, mixed_mesh)
+    last_active_id = e->id;
+  mixed_mesh->refine_element_id(last_active_id);
+  mixed_mesh->refine_towards_vertex(3, 2);
+  for (int i = 0; i < 2; i++)
+    same = same && check_refine_all_elements(mixed_mesh);
+  std::cout << "refine_all_elements " << (same ? "equals" : "differs from") << " the element by element refinement." << std::endl;
+  success = success && same;
+
+  if (success)
+  {
+    std::cout << "Success!";
+    return 0;
+  }
+  else
+  {
+    std::cout << "Failure!";
+    return -1;
+  }
+}
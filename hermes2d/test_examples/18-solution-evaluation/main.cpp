@@ -0,0 +1,175 @@
+#include "hermes2d.h"
+#include "../test_utils.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+
+// Evaluation of Solution values and derivatives in integration points (Solution::precalculate) for polynomial
+// orders 1 - 10 on triangles and quads: measures the time per element of the fused evaluation of all requested
+// quantities against the previous one-quantity-at-a-time Horner scheme (ReferenceSolution below), checks the values
+// of both against each other and against the evaluation in single points (Solution::get_pt_value), which does not
+// use the monomial expansion.
+
+const int MAX_ORDER = 10;
+const int REPETITIONS = 20;
+
+// Solution::precalculate before the quantities were fused: the monomial expansion of every quantity is summed
+// separately, one Horner scheme in x per power of y.
+class ReferenceSolution : public Solution<double>
+{
+protected:
+  virtual void precalculate(int order, int mask)
+  {
+    if (this->sln_type != HERMES_SLN || this->num_components != 1)
+    {
+      Solution<double>::precalculate(order, mask);
+      return;
+    }
+
+    Quad2D* quad = this->quads[this->cur_quad];
+    int np = quad->get_num_points(order, this->mode);
+
+    if (this->transform)
+    {
+      if ((mask & H2D_FN_DX_0) || (mask & H2D_FN_DY_0))
+        mask |= H2D_GRAD;
+#ifdef H2D_USE_SECOND_DERIVATIVES
+      if ((mask & H2D_FN_DXX_0) || (mask & H2D_FN_DXY_0) || (mask & H2D_FN_DYY_0))
+        mask |= H2D_SECOND;
+#endif
+    }
+
+    double3* pt = quad->get_points(order, this->element->get_mode());
+    for (int i = 0; i < np; i++)
+    {
+      this->x[i] = pt[i][0] * this->ctm->m[0] + this->ctm->t[0];
+      this->y[i] = pt[i][1] * this->ctm->m[1] + this->ctm->t[1];
+    }
+
+    double tx[H2D_MAX_INTEGRATION_POINTS_COUNT];
+    int o = this->elem_orders[this->element->id];
+    for (int k = 0; k < H2D_NUM_FUNCTION_VALUES; k++)
+    {
+      if (!(mask & this->idx2mask[k][0]))
+        continue;
+
+      double* result = this->values[0][k];
+      double* mono = this->dxdy_coeffs[0][k];
+      for (int i = 0; i <= o; i++)
+      {
+        for (int n = 0; n < np; n++)
+          tx[n] = *mono;
+        mono++;
+        for (int j = 1; j <= (this->mode ? o : i); j++, mono++)
+          for (int n = 0; n < np; n++)
+            tx[n] = tx[n] * this->x[n] + *mono;
+
+        if (!i)
+          memcpy(result, tx, sizeof(double) * np);
+        else
+          for (int n = 0; n < np; n++)
+            result[n] = result[n] * this->y[n] + tx[n];
+      }
+    }
+
+    if (this->transform)
+      this->transform_values(order, mask, np);
+
+    Function<double>::precalculate(order, mask);
+  }
+};
+
+// Time of REPETITIONS evaluations on the active element.
+static double measure(MeshFunctionSharedPtr<double> sln, int quad_order)
+{
+  Hermes::Mixins::TimeMeasurable cpu_time;
+  cpu_time.tick();
+  for (int i = 0; i < REPETITIONS; i++)
+    sln->set_quad_order(quad_order, H2D_FN_DEFAULT);
+  cpu_time.tick();
+  return cpu_time.last();
+}
+
+static bool check_order(MeshSharedPtr mesh, int order)
+{
+  SpaceSharedPtr<double> space(new H1Space<double>(mesh, order));
+  double* coeff_vec = random_coefficients(space->get_num_dofs(), order);
+  MeshFunctionSharedPtr<double> sln(new Solution<double>);
+  Solution<double>::vector_to_solution(coeff_vec, space, sln);
+  MeshFunctionSharedPtr<double> ref_sln(new ReferenceSolution);
+  Solution<double>::vector_to_solution(coeff_vec, space, ref_sln);
+  delete[] coeff_vec;
+
+  double time[2] = { 0., 0. };
+  double ref_time[2] = { 0., 0. };
+  int count[2] = { 0, 0 };
+  bool success = true;
+
+  Element* e;
+  for_all_active_elements(e, mesh)
+  {
+    // The quadrature tables are indexed by a single order on quads too.
+    ElementMode2D mode = e->get_mode();
+    int quad_order = std::min(2 * order, g_quad_2d_std.get_max_order(mode));
+
+    sln->set_active_element(e);
+    ref_sln->set_active_element(e);
+    ref_time[mode] += measure(ref_sln, quad_order);
+    time[mode] += measure(sln, quad_order);
+    count[mode] += REPETITIONS;
+
+    // Check a few of the points.
+    const double* val = sln->get_fn_values();
+    const double* dx = sln->get_dx_values();
+    const double* dy = sln->get_dy_values();
+    const double* ref_val = ref_sln->get_fn_values();
+    const double* ref_dx = ref_sln->get_dx_values();
+    const double* ref_dy = ref_sln->get_dy_values();
+    double* x = sln->get_refmap()->get_phys_x(quad_order);
+    double* y = sln->get_refmap()->get_phys_y(quad_order);
+    int np = g_quad_2d_std.get_num_points(quad_order, e->get_mode());
+    for (int i = 0; i < np; i++)
+      if (std::abs(ref_val[i] - val[i]) > 1e-12 * (1. + std::abs(ref_val[i])) || std::abs(ref_dx[i] - dx[i]) > 1e-10 * (1. + std::abs(ref_dx[i]))
+        || std::abs(ref_dy[i] - dy[i]) > 1e-10 * (1. + std::abs(ref_dy[i])))
+        success = false;
+    for (int i = 0; i < np; i += 7)
+    {
+      Func<double>* value = sln->get_pt_value(x[i], y[i], true, e);
+      if (std::abs(value->val[0] - val[i]) > 1e-8 || std::abs(value->dx[0] - dx[i]) > 1e-6 || std::abs(value->dy[0] - dy[i]) > 1e-6)
+        success = false;
+      delete value;
+    }
+  }
+
+  std::cout << "Order " << order << ": triangle " << ref_time[HERMES_MODE_TRIANGLE] / count[HERMES_MODE_TRIANGLE] * 1e6
+    << " us (per quantity) / " << time[HERMES_MODE_TRIANGLE] / count[HERMES_MODE_TRIANGLE] * 1e6
+    << " us (fused), quad " << ref_time[HERMES_MODE_QUAD] / count[HERMES_MODE_QUAD] * 1e6
+    << " us (per quantity) / " << time[HERMES_MODE_QUAD] / count[HERMES_MODE_QUAD] * 1e6 << " us (fused)." << std::endl;
+
+  return success;
+}
+
+int main(int argc, char* argv[])
+{
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("domain.mesh", mesh);
+  mesh->refine_all_elements();
+  mesh->refine_all_elements();
+  mesh->refine_all_elements();
+
+  bool success = true;
+  for (int order = 1; order <= MAX_ORDER; order++)
+    success = check_order(mesh, order) && success;
+
+  if (success)
+  {
+    std::cout << "Success!";
+    return 0;
+  }
+  else
+  {
+    std::cout << "Failure!";
+    return -1;
+  }
+}
@@ -0,0 +1,126 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+
+// Block sparse matrix (BSRMatrix) of a system of two coupled equations with node-interleaved DOFs
+// (Space::assign_dofs_interleaved): measures the assembling and the matrix-vector product time compared to
+// the CSC matrix with the contiguous DOF numbering, checks that both matrices (and the BSR matrix converted
+// to CSC) give the same products and that the solution vectors of both numberings give the same solutions.
+
+const int INIT_REF_NUM = 5;
+const int P_INIT = 3;
+const int SPMV_REPETITIONS = 50;
+
+// Time of SPMV_REPETITIONS products, the result is left in y.
+static double multiply(SparseMatrix<double>* matrix, double* x, double* y)
+{
+  Hermes::Mixins::TimeMeasurable cpu_time;
+  cpu_time.tick();
+  for (int i = 0; i < SPMV_REPETITIONS; i++)
+    matrix->multiply_with_vector(x, y, true);
+  cpu_time.tick();
+  return cpu_time.last();
+}
+
+int main(int argc, char* argv[])
+{
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("square.mesh", mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh->refine_all_elements();
+
+  SpaceSharedPtr<double> space_u(new H1Space<double>(mesh, P_INIT));
+  SpaceSharedPtr<double> space_v(new H1Space<double>(mesh, P_INIT));
+  Hermes::vector<SpaceSharedPtr<double> > spaces(space_u, space_v);
+
+  WeakForm<double> wf(2);
+  wf.add_matrix_form(new DefaultJacobianDiffusion<double>(0, 0));
+  wf.add_matrix_form(new DefaultJacobianDiffusion<double>(1, 1));
+  wf.add_matrix_form(new DefaultMatrixFormVol<double>(0, 1));
+  wf.add_matrix_form(new DefaultMatrixFormVol<double>(1, 0));
+
+  Hermes::Mixins::TimeMeasurable cpu_time;
+
+  // Contiguous numbering, CSC matrix.
+  Space<double>::assign_dofs(spaces);
+  int ndof = space_u->get_num_dofs();
+  CSCMatrix<double> csc_matrix;
+  DiscreteProblem<double> dp_csc(&wf, spaces);
+  cpu_time.tick();
+  dp_csc.assemble(&csc_matrix);
+  cpu_time.tick();
+  std::cout << "DOFs: " << 2 * ndof << ", CSC assembling: " << cpu_time.last() << " s." << std::endl;
+
+  // Interleaved numbering, BSR matrix.
+  Space<double>::assign_dofs_interleaved(spaces);
+  BSRMatrix<double> bsr_matrix(2);
+  DiscreteProblem<double> dp_bsr(&wf, spaces);
+  cpu_time.tick();
+  dp_bsr.assemble(&bsr_matrix);
+  cpu_time.tick();
+  std::cout << "Blocks: " << bsr_matrix.get_num_blocks() << ", BSR assembling: " << cpu_time.last() << " s." << std::endl;
+
+  bool success = (bsr_matrix.get_size() == csc_matrix.get_size());
+
+  // The DOF k of the space s is s * ndof + k in the contiguous numbering, 2 * k + s in the interleaved one.
+  double* x_csc = new double[2 * ndof];
+  double* x_bsr = new double[2 * ndof];
+  double* y_csc = new double[2 * ndof];
+  double* y_bsr = new double[2 * ndof];
+  srand(12345);
+  for (int s = 0; s < 2; s++)
+  for (int k = 0; k < ndof; k++)
+    x_bsr[2 * k + s] = x_csc[s * ndof + k] = 2. * rand() / RAND_MAX - 1.;
+
+  std::cout << "SpMV: CSC " << multiply(&csc_matrix, x_csc, y_csc) / SPMV_REPETITIONS * 1e3 << " ms, ";
+  std::cout << "BSR " << multiply(&bsr_matrix, x_bsr, y_bsr) / SPMV_REPETITIONS * 1e3 << " ms." << std::endl;
+  for (int s = 0; s < 2; s++)
+  for (int k = 0; k < ndof; k++)
+  if (std::abs(y_bsr[2 * k + s] - y_csc[s * ndof + k]) > 1e-10 * (1. + std::abs(y_csc[s * ndof + k])))
+    success = false;
+
+  CSCMatrix<double> converted_matrix;
+  cpu_time.tick();
+  bsr_matrix.convert_to_csc(&converted_matrix);
+  cpu_time.tick();
+  std::cout << "Conversion to CSC: " << cpu_time.last() << " s." << std::endl;
+  multiply(&converted_matrix, x_bsr, y_csc);
+  for (int i = 0; i < 2 * ndof; i++)
+  if (std::abs(y_bsr[i] - y_csc[i]) > 1e-10 * (1. + std::abs(y_bsr[i])))
+    success = false;
+
+  // The same coefficients as solutions, with the interleaved numbering and after renumbering contiguously.
+  MeshFunctionSharedPtr<double> u_bsr(new Solution<double>), v_bsr(new Solution<double>);
+  MeshFunctionSharedPtr<double> u_csc(new Solution<double>), v_csc(new Solution<double>);
+  Solution<double>::vector_to_solutions(x_bsr, spaces, Hermes::vector<MeshFunctionSharedPtr<double> >(u_bsr, v_bsr));
+  Space<double>::assign_dofs(spaces);
+  Solution<double>::vector_to_solutions(x_csc, spaces, Hermes::vector<MeshFunctionSharedPtr<double> >(u_csc, v_csc));
+  double point_x[2] = { 0.3, 0.71 }, point_y[2] = { 0.45, 0.2 };
+  double values[4][2];
+  u_bsr->get_pt_values(2, point_x, point_y, values[0]);
+  u_csc->get_pt_values(2, point_x, point_y, values[1]);
+  v_bsr->get_pt_values(2, point_x, point_y, values[2]);
+  v_csc->get_pt_values(2, point_x, point_y, values[3]);
+  for (int i = 0; i < 2; i++)
+  if (std::abs(values[0][i] - values[1][i]) > 1e-12 || std::abs(values[2][i] - values[3][i]) > 1e-12)
+    success = false;
+
+  delete[] x_csc;
+  delete[] x_bsr;
+  delete[] y_csc;
+  delete[] y_bsr;
+
+  if (success)
+  {
+    std::cout << "Success!";
+    return 0;
+  }
+  else
+  {
+    std::cout << "Failure!";
+    return -1;
+  }
+}
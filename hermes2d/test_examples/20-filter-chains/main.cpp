@@ -0,0 +1,110 @@
+#include "hermes2d.h"
+#include "../test_utils.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+
+// Magnitude of the difference of two vector fields given by pairs of solutions on different meshes, as a chain
+// of nested filters (MagFilter of two DiffFilters) and as the same chain flattened to one FusedFilter: measures
+// the time of the evaluation on all elements, checks that both give the same integral and point values.
+// Also checks an expression built directly by the FusedFilter methods against SumFilter.
+
+const int INIT_REF_NUM = 4;
+const int P_INIT = 3;
+const int QUAD_ORDER = 8;
+
+// Integral of the function over the domain, evaluated on all elements of its mesh.
+static double integrate(MeshFunctionSharedPtr<double> function, double& time)
+{
+  Hermes::Mixins::TimeMeasurable cpu_time;
+  cpu_time.tick();
+  double result = 0.;
+  Element* e;
+  for_all_active_elements(e, function->get_mesh())
+  {
+    // The tables of both modes are indexed by the total order.
+    int order = QUAD_ORDER;
+    function->set_active_element(e);
+    function->set_quad_order(order, H2D_FN_VAL);
+    const double* values = function->get_fn_values();
+
+    double3* points = g_quad_2d_std.get_points(order, e->get_mode());
+    int np = g_quad_2d_std.get_num_points(order, e->get_mode());
+    RefMap* refmap = function->get_refmap();
+    double* jacobian = refmap->is_jacobian_const() ? nullptr : refmap->get_jacobian(order);
+    for (int i = 0; i < np; i++)
+      result += points[i][2] * values[i] * (jacobian ? jacobian[i] : refmap->get_const_jacobian());
+  }
+  cpu_time.tick();
+  time = cpu_time.last();
+  return result;
+}
+
+static bool check_points(MeshFunctionSharedPtr<double> f1, MeshFunctionSharedPtr<double> f2)
+{
+  bool success = true;
+  for (int i = 1; i < 10; i++)
+  for (int j = 1; j < 10; j++)
+  {
+    Func<double>* v1 = f1->get_pt_value(i * 0.1, j * 0.1 + 0.01, true);
+    Func<double>* v2 = f2->get_pt_value(i * 0.1, j * 0.1 + 0.01, true);
+    if (std::abs(v1->val[0] - v2->val[0]) > 1e-10)
+      success = false;
+    delete v1;
+    delete v2;
+  }
+  return success;
+}
+
+int main(int argc, char* argv[])
+{
+  MeshSharedPtr mesh_u(new Mesh), mesh_v(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("square.mesh", mesh_u);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh_u->refine_all_elements();
+  mesh_v->copy(mesh_u);
+  mesh_u->refine_towards_vertex(0, 3);
+  mesh_v->refine_towards_vertex(2, 3);
+
+  SpaceSharedPtr<double> space_u(new H1Space<double>(mesh_u, P_INIT)), space_v(new H1Space<double>(mesh_v, P_INIT));
+  MeshFunctionSharedPtr<double> u_x = random_solution(space_u, 1), u_y = random_solution(space_u, 2);
+  MeshFunctionSharedPtr<double> v_x = random_solution(space_v, 3), v_y = random_solution(space_v, 4);
+
+  // The nested chain.
+  MeshFunctionSharedPtr<double> diff_x(new DiffFilter<double>(Hermes::vector<MeshFunctionSharedPtr<double> >(u_x, v_x)));
+  MeshFunctionSharedPtr<double> diff_y(new DiffFilter<double>(Hermes::vector<MeshFunctionSharedPtr<double> >(u_y, v_y)));
+  MeshFunctionSharedPtr<double> nested(new MagFilter<double>(Hermes::vector<MeshFunctionSharedPtr<double> >(diff_x, diff_y)));
+
+  // The same chain flattened, the four solutions are its inputs.
+  FusedFilter<double>* fused_filter = new FusedFilter<double>(nested);
+  MeshFunctionSharedPtr<double> fused(fused_filter);
+  std::cout << "Fused expression nodes: " << fused_filter->get_num_nodes() << std::endl;
+
+  double time_nested, time_fused;
+  double integral_nested = integrate(nested, time_nested);
+  double integral_fused = integrate(fused, time_fused);
+  std::cout << "Nested filters: " << time_nested << " s, fused filter: " << time_fused << " s." << std::endl;
+
+  bool success = std::abs(integral_nested - integral_fused) < 1e-10 * (1. + std::abs(integral_nested));
+  success = check_points(nested, fused) && success;
+
+  // Built directly: u_x + v_x.
+  FusedFilter<double>* sum_filter = new FusedFilter<double>(Hermes::vector<MeshFunctionSharedPtr<double> >(u_x, v_x));
+  sum_filter->set_expression(sum_filter->add_operation(HERMES_FILTER_ADD, sum_filter->add_input(0), sum_filter->add_input(1)));
+  MeshFunctionSharedPtr<double> sum(sum_filter);
+  MeshFunctionSharedPtr<double> sum_nested(new SumFilter<double>(Hermes::vector<MeshFunctionSharedPtr<double> >(u_x, v_x)));
+  success = std::abs(integrate(sum, time_fused) - integrate(sum_nested, time_nested)) < 1e-10 && success;
+  success = check_points(sum, sum_nested) && success;
+
+  if (success)
+  {
+    std::cout << "Success!";
+    return 0;
+  }
+  else
+  {
+    std::cout << "Failure!";
+    return -1;
+  }
+}
@@ -0,0 +1,137 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Solvers;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+using namespace Hermes::Hermes2D::WeakFormsElasticity;
+
+// Mixed precision iterative refinement (MixedPrecisionLinearMatrixSolver) for the Poisson equation and for linear
+// elasticity: reports the memory of the CSC matrix and of the single precision copy with its ILU(0) factors, the solve
+// time and the numbers of iterations, checks that the residual with respect to the double precision matrix reaches
+// double precision levels. The solver created for Hermes::SOLVER_MIXED_PRECISION (create_linear_solver()) has to give the
+// same solution. With UMFPACK available, the solution is also compared to the direct solve.
+
+const int INIT_REF_NUM = 5;
+const int P_INIT = 3;
+const double LAMBDA = 1.;
+const double MU = 0.5;
+
+static bool solve_and_compare(WeakForm<double>* wf, Hermes::vector<SpaceSharedPtr<double> >& spaces)
+{
+  Hermes::Mixins::TimeMeasurable cpu_time;
+
+  // The spaces are numbered one after another (as in the solvers).
+  Space<double>::assign_dofs(spaces);
+  CSCMatrix<double> csc_matrix;
+  SimpleVector<double> csc_rhs;
+  DiscreteProblem<double> dp_csc(wf, spaces);
+  dp_csc.assemble(&csc_matrix, &csc_rhs);
+
+  MixedPrecisionLinearMatrixSolver<double> mixed_solver(&csc_matrix, &csc_rhs);
+  cpu_time.tick();
+  mixed_solver.solve();
+  cpu_time.tick();
+
+  int ndof = csc_matrix.get_size();
+  unsigned long csc_memory = (ndof + 1 + csc_matrix.get_nnz()) * sizeof(int) + csc_matrix.get_nnz() * sizeof(double);
+  std::cout << "DOFs: " << ndof << ", memory: CSC matrix " << csc_memory << " B, single precision copy and ILU(0) factors "
+    << mixed_solver.get_factorization_memory_size() << " B." << std::endl;
+  std::cout << "Mixed precision solve: " << cpu_time.last() << " s, " << mixed_solver.get_num_iters() << " refinement steps, "
+    << mixed_solver.get_num_inner_iters() << " single precision iterations." << std::endl;
+  double* sln = mixed_solver.get_sln_vector();
+
+  // Residual with respect to the double precision matrix.
+  double* product = nullptr;
+  csc_matrix.multiply_with_vector(sln, product, false);
+  double residual_norm = 0., rhs_norm = 0.;
+  for (int i = 0; i < ndof; i++)
+  {
+    residual_norm += (csc_rhs.get(i) - product[i]) * (csc_rhs.get(i) - product[i]);
+    rhs_norm += csc_rhs.get(i) * csc_rhs.get(i);
+  }
+  free_with_check(product);
+  std::cout << "Relative residual: solver " << mixed_solver.get_residual_norm() << ", recomputed " << std::sqrt(residual_norm / rhs_norm) << "." << std::endl;
+  bool success = std::sqrt(residual_norm / rhs_norm) < 1e-12;
+
+  // The same solver through the solver type.
+  HermesCommonApi.set_integral_param_value(matrixSolverType, SOLVER_MIXED_PRECISION);
+  SparseMatrix<double>* matrix = create_matrix<double>();
+  Vector<double>* rhs = create_vector<double>();
+  LinearMatrixSolver<double>* linear_solver = create_linear_solver<double>(matrix, rhs);
+  HermesCommonApi.set_integral_param_value(matrixSolverType, SOLVER_UMFPACK);
+  DiscreteProblem<double> dp(wf, spaces);
+  dp.assemble(matrix, rhs);
+  linear_solver->solve();
+  double linear_solver_difference = 0., sln_max = 0.;
+  for (int i = 0; i < ndof; i++)
+  {
+    linear_solver_difference = std::max(linear_solver_difference, std::abs(linear_solver->get_sln_vector()[i] - sln[i]));
+    sln_max = std::max(sln_max, std::abs(sln[i]));
+  }
+  delete linear_solver;
+  delete matrix;
+  delete rhs;
+  std::cout << "Solver created for SOLVER_MIXED_PRECISION: difference " << linear_solver_difference << "." << std::endl;
+  success = linear_solver_difference < 1e-10 * sln_max && success;
+
+#ifdef WITH_UMFPACK
+  UMFPackLinearMatrixSolver<double> direct_solver(&csc_matrix, &csc_rhs);
+  cpu_time.tick();
+  direct_solver.solve();
+  cpu_time.tick();
+  std::cout << "UMFPACK solve: " << cpu_time.last() << " s." << std::endl;
+  double difference_norm = 0., sln_norm = 0.;
+  for (int i = 0; i < ndof; i++)
+  {
+    difference_norm += (direct_solver.get_sln_vector()[i] - sln[i]) * (direct_solver.get_sln_vector()[i] - sln[i]);
+    sln_norm += sln[i] * sln[i];
+  }
+  success = std::sqrt(difference_norm / sln_norm) < 1e-8 && success;
+#endif
+
+  return success;
+}
+
+int main(int argc, char* argv[])
+{
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("square.mesh", mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh->refine_all_elements();
+
+  DefaultEssentialBCConst<double> bc_essential("Bdy", 0.0);
+  EssentialBCs<double> bcs(&bc_essential);
+
+  // Poisson equation.
+  SpaceSharedPtr<double> space(new H1Space<double>(mesh, &bcs, P_INIT));
+  WeakForm<double> wf_poisson(1);
+  wf_poisson.add_matrix_form(new DefaultJacobianDiffusion<double>(0, 0));
+  wf_poisson.add_vector_form(new DefaultVectorFormVol<double>(0, HERMES_ANY, new Hermes2DFunction<double>(1.0)));
+  Hermes::vector<SpaceSharedPtr<double> > spaces_poisson;
+  spaces_poisson.push_back(space);
+  bool success = solve_and_compare(&wf_poisson, spaces_poisson);
+
+  // Linear elasticity.
+  SpaceSharedPtr<double> space_x(new H1Space<double>(mesh, &bcs, P_INIT));
+  SpaceSharedPtr<double> space_y(new H1Space<double>(mesh, &bcs, P_INIT));
+  WeakForm<double> wf_elasticity(2);
+  wf_elasticity.add_matrix_form(new DefaultJacobianElasticity_0_0<double>(0, 0, LAMBDA, MU));
+  wf_elasticity.add_matrix_form(new DefaultJacobianElasticity_0_1<double>(0, 1, LAMBDA, MU));
+  wf_elasticity.add_matrix_form(new DefaultJacobianElasticity_1_1<double>(1, 1, LAMBDA, MU));
+  wf_elasticity.add_vector_form(new DefaultVectorFormVol<double>(1, HERMES_ANY, new Hermes2DFunction<double>(-1.0)));
+  Hermes::vector<SpaceSharedPtr<double> > spaces_elasticity(space_x, space_y);
+  success = solve_and_compare(&wf_elasticity, spaces_elasticity) && success;
+
+  if (success)
+  {
+    std::cout << "Success!";
+    return 0;
+  }
+  else
+  {
+    std::cout << "Failure!";
+    return -1;
+  }
+}
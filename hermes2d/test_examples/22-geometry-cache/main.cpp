@@ -0,0 +1,90 @@
+#include "hermes2d.h"
+#include "../test_utils.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+
+// Cache of the reference mapping data (Mesh::set_geometry_cache()) on a mesh of curved quadrilaterals:
+// measures the assembling time without the cache, with the cache being filled and with the cache filled,
+// reports the memory of the cache and checks that all matrices are the same, also after the mesh has been
+// refined (which has to clear the cache).
+
+const int INIT_REF_NUM = 4;
+const int P_INIT = 4;
+
+static double assemble(WeakForm<double>* wf, SpaceSharedPtr<double> space, CSCMatrix<double>* matrix, SimpleVector<double>* rhs)
+{
+  Hermes::Mixins::TimeMeasurable cpu_time;
+  DiscreteProblem<double> dp(wf, space);
+  cpu_time.tick();
+  dp.assemble(matrix, rhs);
+  cpu_time.tick();
+  return cpu_time.last();
+}
+
+static bool check(WeakForm<double>* wf, MeshSharedPtr mesh, EssentialBCs<double>* bcs)
+{
+  SpaceSharedPtr<double> space(new H1Space<double>(mesh, bcs, P_INIT));
+
+  CSCMatrix<double> matrix_previous, matrix_no_cache, matrix_filling, matrix_cached;
+  SimpleVector<double> rhs_previous, rhs_no_cache, rhs_filling, rhs_cached;
+
+  // With the cache as left by the previous check (if any) - filled for the mesh before the refinement.
+  if (!mesh->get_geometry_cache())
+    mesh->set_geometry_cache(true);
+  assemble(wf, space, &matrix_previous, &rhs_previous);
+
+  mesh->set_geometry_cache(false);
+  double time_no_cache = assemble(wf, space, &matrix_no_cache, &rhs_no_cache);
+  mesh->set_geometry_cache(true);
+  double time_filling = assemble(wf, space, &matrix_filling, &rhs_filling);
+  double time_cached = assemble(wf, space, &matrix_cached, &rhs_cached);
+
+  std::cout << "DOFs: " << space->get_num_dofs() << ", assembling: no cache " << time_no_cache << " s, filling the cache "
+    << time_filling << " s, cached " << time_cached << " s." << std::endl;
+  std::cout << "Cache entries: " << mesh->get_geometry_cache()->get_num_entries() << ", memory: "
+    << mesh->get_geometry_cache()->get_memory_size() << " B." << std::endl;
+
+  bool success = same_matrices(matrix_no_cache, matrix_previous, 1e-12) && same_matrices(matrix_no_cache, matrix_filling, 1e-12)
+    && same_matrices(matrix_no_cache, matrix_cached, 1e-12);
+  if (relative_difference(rhs_no_cache.v, rhs_cached.v, space->get_num_dofs()) > 1e-12)
+    success = false;
+  return success;
+}
+
+int main(int argc, char* argv[])
+{
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("domain.mesh", mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh->refine_all_elements();
+
+  DefaultEssentialBCConst<double> bc_essential("Inner", 0.0);
+  EssentialBCs<double> bcs(&bc_essential);
+
+  // Diffusion with a source, Robin condition on the curved boundary (uses the edge tangents).
+  WeakForm<double> wf(1);
+  wf.add_matrix_form(new DefaultJacobianDiffusion<double>(0, 0));
+  wf.add_matrix_form_surf(new DefaultMatrixFormSurf<double>(0, 0, "Outer"));
+  wf.add_vector_form(new DefaultVectorFormVol<double>(0, HERMES_ANY, new Hermes2DFunction<double>(1.0)));
+  wf.add_vector_form_surf(new DefaultVectorFormSurf<double>(0, "Outer", new Hermes2DFunction<double>(1.0)));
+
+  bool success = check(&wf, mesh, &bcs);
+
+  // The element ids are reused by the refinement, the cache has to be cleared.
+  mesh->refine_all_elements();
+  success = check(&wf, mesh, &bcs) && success;
+
+  if (success)
+  {
+    std::cout << "Success!";
+    return 0;
+  }
+  else
+  {
+    std::cout << "Failure!";
+    return -1;
+  }
+}
@@ -0,0 +1,117 @@
+#include "hermes2d.h"
+#include "../test_utils.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+
+// Local matrices of forms with constant coefficients on affine elements calculated from the reference element
+// integrals (DiscreteProblem::set_reference_integrals()): a mass + diffusion + advection problem on a mesh of
+// a parallelogram and two triangles, for the polynomial degrees 1 - 10. Measures the assembling time with and
+// without the reference integrals and checks that the matrices are the same. A descendant of DefaultMatrixFormVol that
+// scales its value() (as the time-dependent form in 00-quickShow) has to be integrated by the quadrature in both cases,
+// as well as DefaultMatrixFormDiffusion on quads, whose order is not sufficient for the exact integration.
+
+const int INIT_REF_NUM = 3;
+const double TAU = 0.25;
+
+// Mass form divided by the time step.
+class ScaledMassForm : public DefaultMatrixFormVol<double>
+{
+public:
+  ScaledMassForm() : DefaultMatrixFormVol<double>(0, 0, HERMES_ANY, new Hermes2DFunction<double>(2.0)) {};
+
+  virtual double value(int n, double *wt, Func<double> *u_ext[], Func<double> *u, Func<double> *v, Geom<double> *e, Func<double> **ext) const
+  {
+    return DefaultMatrixFormVol<double>::value(n, wt, u_ext, u, v, e, ext) / TAU;
+  }
+
+  MatrixFormVol<double>* clone() const
+  {
+    return new ScaledMassForm(*this);
+  }
+};
+
+static double assemble(WeakForm<double>* wf, SpaceSharedPtr<double> space, bool reference_integrals, CSCMatrix<double>* matrix)
+{
+  Hermes::Mixins::TimeMeasurable cpu_time;
+  DiscreteProblem<double> dp(wf, space);
+  dp.set_reference_integrals(reference_integrals);
+  cpu_time.tick();
+  dp.assemble(matrix);
+  cpu_time.tick();
+  return cpu_time.last();
+}
+
+int main(int argc, char* argv[])
+{
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("domain.mesh", mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh->refine_all_elements();
+
+  DefaultEssentialBCConst<double> bc_essential("Bdy", 0.0);
+  EssentialBCs<double> bcs(&bc_essential);
+
+  WeakForm<double> wf(1);
+  wf.add_matrix_form(new DefaultMatrixFormVol<double>(0, 0, HERMES_ANY, new Hermes2DFunction<double>(2.0)));
+  wf.add_matrix_form(new DefaultJacobianDiffusion<double>(0, 0, HERMES_ANY, new Hermes1DFunction<double>(1.5)));
+  wf.add_matrix_form(new DefaultJacobianAdvection<double>(0, 0, HERMES_ANY, new Hermes1DFunction<double>(0.3), new Hermes1DFunction<double>(-0.7)));
+
+  WeakForm<double> wf_scaled(1);
+  wf_scaled.add_matrix_form(new ScaledMassForm());
+
+  WeakForm<double> wf_diffusion(1);
+  wf_diffusion.add_matrix_form(new DefaultMatrixFormDiffusion<double>(0, 0, HERMES_ANY, new Hermes1DFunction<double>(-1.0)));
+
+  bool success = true;
+  for (int p = 1; p <= 10; p++)
+  {
+    SpaceSharedPtr<double> space(new H1Space<double>(mesh, &bcs, p));
+
+    // The first assembling with the reference integrals creates (or loads) the tables.
+    CSCMatrix<double> matrix_quadrature, matrix_reference, matrix_tables_created;
+    assemble(&wf, space, true, &matrix_tables_created);
+    double time_quadrature = assemble(&wf, space, false, &matrix_quadrature);
+    double time_reference = assemble(&wf, space, true, &matrix_reference);
+
+    std::cout << "p = " << p << ", DOFs: " << space->get_num_dofs() << ", assembling: quadrature " << time_quadrature
+      << " s, reference integrals " << time_reference << " s." << std::endl;
+
+    if (!same_matrices(matrix_quadrature, matrix_reference, 1e-10) || !same_matrices(matrix_quadrature, matrix_tables_created, 1e-10))
+    {
+      std::cout << "Matrices differ for p = " << p << "." << std::endl;
+      success = false;
+    }
+
+    CSCMatrix<double> matrix_scaled_quadrature, matrix_scaled_reference;
+    assemble(&wf_scaled, space, false, &matrix_scaled_quadrature);
+    assemble(&wf_scaled, space, true, &matrix_scaled_reference);
+    if (!same_matrices(matrix_scaled_quadrature, matrix_scaled_reference, 1e-10))
+    {
+      std::cout << "Matrices of the descendant form differ for p = " << p << "." << std::endl;
+      success = false;
+    }
+
+    CSCMatrix<double> matrix_diffusion_quadrature, matrix_diffusion_reference;
+    assemble(&wf_diffusion, space, false, &matrix_diffusion_quadrature);
+    assemble(&wf_diffusion, space, true, &matrix_diffusion_reference);
+    if (!same_matrices(matrix_diffusion_quadrature, matrix_diffusion_reference, 1e-10))
+    {
+      std::cout << "Matrices of the diffusion form differ for p = " << p << "." << std::endl;
+      success = false;
+    }
+  }
+
+  if (success)
+  {
+    std::cout << "Success!";
+    return 0;
+  }
+  else
+  {
+    std::cout << "Failure!";
+    return -1;
+  }
+}
@@ -0,0 +1,134 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+using namespace Hermes::Solvers;
+
+// Sparse generalized eigensolver (Hermes::Solvers::EigenSolver): the lowest eigenvalues of the Laplace operator
+// on the unit square with zero Dirichlet conditions, pi^2 (m^2 + n^2), found by the shift-invert Lanczos method
+// (symmetric stiffness and mass matrices), and of the convection-diffusion operator -laplace u + b . grad u, whose
+// eigenvalues are shifted by |b|^2 / 4, found by the shift-invert Arnoldi method (non-symmetric matrix), also with
+// a small Krylov subspace (restarts).
+
+const int INIT_REF_NUM = 3;
+const int P_INIT = 4;
+const int N_EIGS = 4;
+const double TARGET_VALUE = 0.;
+const double ADVECTION_X = 2.0;
+const double ADVECTION_Y = 1.0;
+const int SMALL_KRYLOV_DIMENSION = 8;
+
+static void assemble(WeakForm<double>* wf, SpaceSharedPtr<double> space, CSCMatrix<double>* matrix)
+{
+  DiscreteProblem<double> dp(wf, space);
+  dp.assemble(matrix);
+}
+
+static bool check_eigenvalues(EigenSolver<double>& solver, double shift)
+{
+  const double expected[N_EIGS] = { 2., 5., 5., 8. };
+  if (solver.get_n_eigs() != N_EIGS)
+    return false;
+
+  bool success = true;
+  for (int i = 0; i < N_EIGS; i++)
+  {
+    std::complex<double> eigenvalue = solver.get_complex_eigenvalue(i);
+    double exact = expected[i] * M_PI * M_PI + shift;
+    std::cout << "  lambda_" << i << " = " << eigenvalue.real() << " (exact " << exact << ")." << std::endl;
+    if (std::abs(eigenvalue.real() - exact) > 1e-4 * exact || std::abs(eigenvalue.imag()) > 1e-6 * exact)
+      success = false;
+  }
+  return success;
+}
+
+int main(int argc, char* argv[])
+{
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("domain.mesh", mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh->refine_all_elements();
+
+  DefaultEssentialBCConst<double> bc_essential("Bdy", 0.0);
+  EssentialBCs<double> bcs(&bc_essential);
+  SpaceSharedPtr<double> space(new H1Space<double>(mesh, &bcs, P_INIT));
+  std::cout << "DOFs: " << space->get_num_dofs() << std::endl;
+
+  WeakForm<double> wf_stiffness(1);
+  wf_stiffness.add_matrix_form(new DefaultJacobianDiffusion<double>(0, 0));
+  WeakForm<double> wf_mass(1);
+  wf_mass.add_matrix_form(new DefaultMatrixFormVol<double>(0, 0));
+  WeakForm<double> wf_convection_diffusion(1);
+  wf_convection_diffusion.add_matrix_form(new DefaultJacobianDiffusion<double>(0, 0));
+  wf_convection_diffusion.add_matrix_form(new DefaultJacobianAdvection<double>(0, 0, HERMES_ANY, new Hermes1DFunction<double>(ADVECTION_X), new Hermes1DFunction<double>(ADVECTION_Y)));
+
+  CSCMatrix<double> stiffness, mass, convection_diffusion;
+  assemble(&wf_stiffness, space, &stiffness);
+  assemble(&wf_mass, space, &mass);
+  assemble(&wf_convection_diffusion, space, &convection_diffusion);
+
+  Hermes::Mixins::TimeMeasurable cpu_time;
+  bool success = true;
+
+  // Lanczos.
+  EigenSolver<double> symmetric_solver(&stiffness, &mass);
+  symmetric_solver.set_symmetric();
+  cpu_time.tick();
+  symmetric_solver.solve(N_EIGS, TARGET_VALUE);
+  cpu_time.tick();
+  std::cout << "Symmetric problem: " << symmetric_solver.get_num_iters() << " restarts, " << cpu_time.last() << " s." << std::endl;
+  if (!check_eigenvalues(symmetric_solver, 0.))
+    success = false;
+
+  // The eigenvectors are B-orthonormal.
+  double* u, *v;
+  int n;
+  symmetric_solver.get_eigenvector(0, &u, &n);
+  symmetric_solver.get_eigenvector(1, &v, &n);
+  double* Bv = malloc_with_check<double>(n);
+  mass.multiply_with_vector(v, Bv, true);
+  double uBv = 0., vBv = 0.;
+  for (int i = 0; i < n; i++)
+  {
+    uBv += u[i] * Bv[i];
+    vBv += v[i] * Bv[i];
+  }
+  free_with_check(Bv);
+  if (std::abs(uBv) > 1e-8 || std::abs(vBv - 1.) > 1e-8)
+  {
+    std::cout << "Eigenvectors not B-orthonormal." << std::endl;
+    success = false;
+  }
+
+  // Arnoldi.
+  EigenSolver<double> nonsymmetric_solver(&convection_diffusion, &mass);
+  cpu_time.tick();
+  nonsymmetric_solver.solve(N_EIGS, TARGET_VALUE);
+  cpu_time.tick();
+  std::cout << "Non-symmetric problem: " << nonsymmetric_solver.get_num_iters() << " restarts, " << cpu_time.last() << " s." << std::endl;
+  if (!check_eigenvalues(nonsymmetric_solver, (ADVECTION_X * ADVECTION_X + ADVECTION_Y * ADVECTION_Y) / 4.))
+    success = false;
+
+  // Arnoldi with restarts (real Ritz vectors kept).
+  EigenSolver<double> restarted_solver(&convection_diffusion, &mass);
+  restarted_solver.set_krylov_dimension(SMALL_KRYLOV_DIMENSION);
+  cpu_time.tick();
+  restarted_solver.solve(N_EIGS, TARGET_VALUE);
+  cpu_time.tick();
+  std::cout << "Non-symmetric problem, Krylov dimension " << SMALL_KRYLOV_DIMENSION << ": " << restarted_solver.get_num_iters() << " restarts, " << cpu_time.last() << " s." << std::endl;
+  if (!check_eigenvalues(restarted_solver, (ADVECTION_X * ADVECTION_X + ADVECTION_Y * ADVECTION_Y) / 4.))
+    success = false;
+
+  if (success)
+  {
+    std::cout << "Success!";
+    return 0;
+  }
+  else
+  {
+    std::cout << "Failure!";
+    return -1;
+  }
+}
@@ -0,0 +1,117 @@
+#include "hermes2d.h"
+#include <iomanip>
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsNeutronics::Multigroup;
+using namespace Hermes::Hermes2D::WeakFormsNeutronics::Multigroup::MaterialProperties::Definitions;
+
+// Two-group k-eigenvalue problem of a homogeneous square core with zero flux on the boundary, solved by the
+// criticality driver (SupportClasses::CriticalityIteration) with the plain source iteration, the Wielandt shift,
+// the Chebyshev extrapolation and both. The keff of the homogeneous core follows from the buckling
+// B^2 = 2 (pi / a)^2: keff = (nuSigma_f1 + nuSigma_f2 Sigma_12 / (D_2 B^2 + Sigma_a2)) / (D_1 B^2 + Sigma_a1 + Sigma_12).
+
+const int INIT_REF_NUM = 3;
+const int P_INIT = 4;
+const double SIDE = 100.;
+
+const double D[2] = { 1.5, 0.4 };
+const double SIGMA_A[2] = { 0.01, 0.08 };
+const double SIGMA_12 = 0.02;
+const double NU = 2.5;
+const double SIGMA_F[2] = { 0.002, 0.04 };
+
+int main(int argc, char* argv[])
+{
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("domain.mesh", mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh->refine_all_elements();
+
+  std::set<std::string> materials;
+  materials.insert("core");
+  MaterialProperties::Diffusion::MaterialPropertyMaps matprop(2, materials);
+
+  MaterialPropertyMap1 D_map, Sigma_r_map, nu_map, Sigma_f_map, chi_map;
+  MaterialPropertyMap2 Sigma_s_map;
+  for (int g = 0; g < 2; g++)
+  {
+    D_map["core"].push_back(D[g]);
+    Sigma_r_map["core"].push_back(SIGMA_A[g] + (g == 0 ? SIGMA_12 : 0.));
+    nu_map["core"].push_back(NU);
+    Sigma_f_map["core"].push_back(SIGMA_F[g]);
+    chi_map["core"].push_back(g == 0 ? 1. : 0.);
+  }
+  Sigma_s_map["core"] = rank2(2, rank1(2, 0.));
+  Sigma_s_map["core"][1][0] = SIGMA_12;
+  bool2 Ss_nnz(2, bool1(2, false));
+  Ss_nnz[1][0] = true;
+  bool1 chi_nnz(2, false);
+  chi_nnz[0] = true;
+
+  matprop.set_D(D_map);
+  matprop.set_Sigma_r(Sigma_r_map);
+  matprop.set_Sigma_s(Sigma_s_map);
+  matprop.set_scattering_multigroup_structure(Ss_nnz);
+  matprop.set_nu(nu_map);
+  matprop.set_Sigma_f(Sigma_f_map);
+  matprop.set_chi(chi_map);
+  matprop.set_fission_multigroup_structure(chi_nnz);
+  matprop.validate();
+
+  DefaultEssentialBCConst<double> bc_essential("Bdy", 0.0);
+  EssentialBCs<double> bcs(&bc_essential);
+  Hermes::vector<SpaceSharedPtr<double> > spaces;
+  Hermes::vector<MeshFunctionSharedPtr<double> > iterates;
+  for (int g = 0; g < 2; g++)
+  {
+    spaces.push_back(SpaceSharedPtr<double>(new H1Space<double>(mesh, &bcs, P_INIT)));
+    iterates.push_back(MeshFunctionSharedPtr<double>(new ConstantSolution<double>(mesh, 1.0)));
+  }
+
+  CompleteWeakForms::Diffusion::DefaultWeakFormSourceIteration<double> wf(matprop, mesh, iterates, 1.0);
+
+  double B2 = 2. * M_PI * M_PI / (SIDE * SIDE);
+  double keff_exact = (NU * SIGMA_F[0] + NU * SIGMA_F[1] * SIGMA_12 / (D[1] * B2 + SIGMA_A[1])) / (D[0] * B2 + SIGMA_A[0] + SIGMA_12);
+
+  bool success = true;
+  const char* names[4] = { "source iteration", "Wielandt shift", "Chebyshev extrapolation", "Wielandt shift + Chebyshev extrapolation" };
+  int iterations[4];
+  for (int variant = 0; variant < 4; variant++)
+  {
+    SupportClasses::CriticalityIteration criticality(matprop, &wf, spaces);
+    criticality.set_tolerance(1e-9, 1e-8);
+    if (variant & 1)
+      criticality.set_wielandt_shift(0.1);
+    if (variant & 2)
+      criticality.set_chebyshev_extrapolation();
+
+    Hermes::Mixins::TimeMeasurable cpu_time;
+    cpu_time.tick();
+    bool converged = criticality.solve();
+    cpu_time.tick();
+    iterations[variant] = criticality.get_num_iters();
+
+    std::cout << names[variant] << ": keff = " << std::setprecision(10) << criticality.get_keff() << " (exact " << keff_exact << "), "
+      << iterations[variant] << " iterations, " << cpu_time.last() << " s." << std::endl;
+
+    if (!converged || std::abs(criticality.get_keff() - keff_exact) > 1e-6 * keff_exact)
+      success = false;
+  }
+
+  // The accelerations have to pay off.
+  if (iterations[1] >= iterations[0] || iterations[2] >= iterations[0])
+    success = false;
+
+  if (success)
+  {
+    std::cout << "Success!";
+    return 0;
+  }
+  else
+  {
+    std::cout << "Failure!";
+    return -1;
+  }
+}
@@ -0,0 +1,169 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+
+// Update of time-dependent essential boundary conditions (Space::update_essential_bc_values()): the Dirichlet
+// lift of a space updated over the time steps is compared with the lift of a space created at the final time.
+// The condition on the top edge depends on the time as well, but it is flagged time-independent, so its values
+// have to stay those of the initial time. A condition flagged as not thread-safe must never be evaluated by two
+// threads at once, and its lift has to be the same.
+
+const int INIT_REF_NUM = 5;
+const int P_INIT = 8;
+const int TIME_STEPS = 50;
+const double FINAL_TIME = 1.0;
+
+class TimeDependentBC : public EssentialBoundaryCondition<double>
+{
+public:
+  TimeDependentBC(std::string marker) : EssentialBoundaryCondition<double>(marker) {};
+
+  EssentialBoundaryCondition<double>::EssentialBCValueType get_value_type() const
+  {
+    return EssentialBoundaryCondition<double>::BC_FUNCTION;
+  }
+
+  double value(double x, double y, double n_x, double n_y, double t_x, double t_y) const
+  {
+    return (1. + this->get_current_time()) * std::sin(M_PI * x) * std::exp(x);
+  }
+};
+
+// The same condition recording whether value() was called in a parallel region of more than one thread.
+class SerialBC : public TimeDependentBC
+{
+public:
+  SerialBC(std::string marker) : TimeDependentBC(marker), concurrent(false)
+  {
+    this->set_thread_safe(false);
+  };
+
+  double value(double x, double y, double n_x, double n_y, double t_x, double t_y) const
+  {
+    if (omp_get_num_threads() > 1)
+      concurrent = true;
+    return TimeDependentBC::value(x, y, n_x, n_y, t_x, t_y);
+  }
+
+  mutable bool concurrent;
+};
+
+// Values of the Dirichlet lift of the space along the line y = const.
+static void lift_values(SpaceSharedPtr<double> space, double y, int count, double* values)
+{
+  double* zero = calloc_with_check<double>(space->get_num_dofs());
+  MeshFunctionSharedPtr<double> lift(new Solution<double>);
+  Solution<double>::vector_to_solution(zero, space, lift);
+  free_with_check(zero);
+
+  double* xs = malloc_with_check<double>(count);
+  double* ys = malloc_with_check<double>(count);
+  for (int i = 0; i < count; i++)
+  {
+    xs[i] = (i + 0.5) / count;
+    ys[i] = y;
+  }
+  lift->get_pt_values(count, xs, ys, values);
+  free_with_check(xs);
+  free_with_check(ys);
+}
+
+static double max_difference(const double* a, const double* b, int count)
+{
+  double result = 0.;
+  for (int i = 0; i < count; i++)
+    result = std::max(result, std::abs(a[i] - b[i]));
+  return result;
+}
+
+int main(int argc, char* argv[])
+{
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("domain.mesh", mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh->refine_all_elements();
+
+  // Updated space.
+  TimeDependentBC bc_bottom("Bottom"), bc_top("Top");
+  bc_top.set_time_independent();
+  DefaultEssentialBCConst<double> bc_sides("Sides", 0.0);
+  Hermes::vector<EssentialBoundaryCondition<double>*> bc_list;
+  bc_list.push_back(&bc_bottom);
+  bc_list.push_back(&bc_top);
+  bc_list.push_back(&bc_sides);
+  EssentialBCs<double> bcs(bc_list);
+  SpaceSharedPtr<double> space(new H1Space<double>(mesh, &bcs, P_INIT));
+  std::cout << "DOFs: " << space->get_num_dofs() << std::endl;
+
+  const int count = 100;
+  double top_initial[count];
+  lift_values(space, 1.0, count, top_initial);
+
+  Hermes::Mixins::TimeMeasurable cpu_time;
+  cpu_time.tick();
+  for (int step = 1; step <= TIME_STEPS; step++)
+    Space<double>::update_essential_bc_values(space, step * FINAL_TIME / TIME_STEPS);
+  cpu_time.tick();
+  std::cout << "Update of the essential BC values: " << cpu_time.last() / TIME_STEPS << " s per time step." << std::endl;
+
+  // Space created at the final time.
+  TimeDependentBC bc_bottom_final("Bottom");
+  bc_bottom_final.set_current_time(FINAL_TIME);
+  DefaultEssentialBCConst<double> bc_sides_final("Sides", 0.0);
+  Hermes::vector<EssentialBoundaryCondition<double>*> bc_list_final;
+  bc_list_final.push_back(&bc_bottom_final);
+  bc_list_final.push_back(&bc_sides_final);
+  EssentialBCs<double> bcs_final(bc_list_final);
+  SpaceSharedPtr<double> space_final(new H1Space<double>(mesh, &bcs_final, P_INIT));
+
+  double bottom[count], bottom_final[count], top[count];
+  lift_values(space, 0.0, count, bottom);
+  lift_values(space_final, 0.0, count, bottom_final);
+  lift_values(space, 1.0, count, top);
+
+  // Space with the bottom condition not thread-safe, updated with several threads.
+  int num_threads = HermesCommonApi.get_integral_param_value(numThreads);
+  HermesCommonApi.set_integral_param_value(numThreads, 4);
+  SerialBC bc_bottom_serial("Bottom");
+  DefaultEssentialBCConst<double> bc_sides_serial("Sides", 0.0);
+  Hermes::vector<EssentialBoundaryCondition<double>*> bc_list_serial;
+  bc_list_serial.push_back(&bc_bottom_serial);
+  bc_list_serial.push_back(&bc_sides_serial);
+  EssentialBCs<double> bcs_serial(bc_list_serial);
+  SpaceSharedPtr<double> space_serial(new H1Space<double>(mesh, &bcs_serial, P_INIT));
+  Space<double>::update_essential_bc_values(space_serial, FINAL_TIME);
+  HermesCommonApi.set_integral_param_value(numThreads, num_threads);
+
+  double bottom_serial[count];
+  lift_values(space_serial, 0.0, count, bottom_serial);
+
+  bool success = true;
+  double serial_difference = max_difference(bottom_serial, bottom_final, count);
+  std::cout << "Not thread-safe condition: difference " << serial_difference << (bc_bottom_serial.concurrent ? ", evaluated concurrently." : ".") << std::endl;
+  if (serial_difference > 1e-12 || bc_bottom_serial.concurrent)
+    success = false;
+
+  double bottom_difference = max_difference(bottom, bottom_final, count);
+  double top_difference = max_difference(top, top_initial, count);
+  std::cout << "Bottom edge difference: " << bottom_difference << ", top edge difference: " << top_difference << "." << std::endl;
+  if (bottom_difference > 1e-12 || top_difference > 1e-12)
+    success = false;
+
+  // The updated values are those of the final time (twice the initial ones).
+  for (int i = 0; i < count; i++)
+  if (std::abs(top[i]) > 1e-3 && std::abs(bottom[i] - 2. * top[i]) > 1e-10)
+    success = false;
+
+  if (success)
+  {
+    std::cout << "Success!";
+    return 0;
+  }
+  else
+  {
+    std::cout << "Failure!";
+    return -1;
+  }
+}
@@ -0,0 +1,102 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+
+// Curved elements: the reference mappings of the sons created by the refinement are projected on their first use
+// by RefMap. The element areas of a refined quarter of an annulus are calculated in parallel (the threads project
+// the sons concurrently) and compared with the areas calculated serially on a copy of the mesh, the total area
+// with the exact one.
+
+const int INIT_REF_NUM = 5;
+
+static double element_area(RefMap& refmap, Element* e)
+{
+  refmap.set_active_element(e);
+  int order = g_quad_2d_std.get_max_order(e->get_mode());
+  int np = g_quad_2d_std.get_num_points(order, e->get_mode());
+  double3* pt = g_quad_2d_std.get_points(order, e->get_mode());
+
+  double area = 0.;
+  if (refmap.is_jacobian_const())
+  {
+    for (int i = 0; i < np; i++)
+      area += pt[i][2] * refmap.get_const_jacobian();
+  }
+  else
+  {
+    double* jacobian = refmap.get_jacobian(order);
+    for (int i = 0; i < np; i++)
+      area += pt[i][2] * jacobian[i];
+  }
+  return area;
+}
+
+int main(int argc, char* argv[])
+{
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("domain.mesh", mesh);
+
+  Hermes::Mixins::TimeMeasurable cpu_time;
+  cpu_time.tick();
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh->refine_all_elements();
+  cpu_time.tick();
+  std::cout << "Refinement: " << cpu_time.last() << " s." << std::endl;
+
+  // The copy shares no coefficients with the original, none of the sons has been projected yet.
+  MeshSharedPtr mesh_copy(new Mesh);
+  mesh_copy->copy(mesh);
+
+  int num_elements = mesh->get_max_element_id();
+  double* areas = calloc_with_check<double>(num_elements);
+
+  cpu_time.tick();
+#pragma omp parallel num_threads(HermesCommonApi.get_integral_param_value(numThreads))
+  {
+    RefMap refmap;
+    refmap.set_quad_2d(&g_quad_2d_std);
+#pragma omp for schedule(dynamic, 1)
+    for (int id = 0; id < num_elements; id++)
+    {
+      Element* e = mesh->get_element_fast(id);
+      if (e->used && e->active)
+        areas[id] = element_area(refmap, e);
+    }
+  }
+  cpu_time.tick();
+  std::cout << "Element areas (parallel, first use): " << cpu_time.last() << " s." << std::endl;
+
+  bool success = true;
+  double area = 0.;
+  RefMap refmap;
+  refmap.set_quad_2d(&g_quad_2d_std);
+  for (int id = 0; id < num_elements; id++)
+  {
+    Element* e = mesh_copy->get_element_fast(id);
+    if (!e->used || !e->active)
+      continue;
+    double area_copy = element_area(refmap, e);
+    if (std::abs(area_copy - areas[id]) > 1e-14)
+      success = false;
+    area += area_copy;
+  }
+  free_with_check(areas);
+
+  double area_exact = 0.75 * M_PI;
+  std::cout << "Area: " << area << " (exact " << area_exact << ")." << std::endl;
+  if (std::abs(area - area_exact) > 1e-8)
+    success = false;
+
+  if (success)
+  {
+    std::cout << "Success!";
+    return 0;
+  }
+  else
+  {
+    std::cout << "Failure!";
+    return -1;
+  }
+}
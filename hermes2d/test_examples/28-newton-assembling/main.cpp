@@ -0,0 +1,171 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+
+// Assembling in the Newton's method: if the jacobian is not reused and the damping is manual, the residual and the jacobian
+// are needed at every iterate and they are assembled together. The solution is compared with the one of the Newton's method
+// with automatic damping and reused jacobian, the separately assembled residual and jacobian (the jacobian reusing
+// the previous iterates of the residual assembling) with the jointly assembled ones. The jacobian is not assembled at the
+// converged iterate. After an update of the (time-dependent) essential BC values, the Newton's method starting from the
+// last iterate of the same DiscreteProblem has to give the same solution as a new one.
+//
+// PDE: - div[lambda(u) grad u] - 1 = 0, lambda(u) = 1 + u^2, u = (1 + t) (x + 10) (y + 10) / 400 on the boundary.
+
+const int INIT_REF_NUM = 3;
+const int P_INIT = 2;
+const double NEWTON_TOL = 1e-10;
+
+class CustomNonlinearity : public Hermes1DFunction<double>
+{
+public:
+  CustomNonlinearity() : Hermes1DFunction<double>() { this->is_const = false; }
+
+  double value(double u) const { return 1. + u * u; }
+  Ord value(Ord u) const { return Ord(10); }
+  double derivative(double u) const { return 2. * u; }
+  Ord derivative(Ord u) const { return Ord(10); }
+};
+
+class CustomEssentialBCNonConst : public EssentialBoundaryCondition<double>
+{
+public:
+  CustomEssentialBCNonConst(std::string marker) : EssentialBoundaryCondition<double>(marker) {};
+
+  EssentialBoundaryCondition<double>::EssentialBCValueType get_value_type() const
+  {
+    return EssentialBoundaryCondition<double>::BC_FUNCTION;
+  }
+
+  double value(double x, double y, double n_x, double n_y, double t_x, double t_y) const
+  {
+    return (1. + this->get_current_time()) * (x + 10.) * (y + 10.) / 400.;
+  }
+};
+
+// Counts the assemblings.
+class CountingNewtonSolver : public NewtonSolver<double>
+{
+public:
+  CountingNewtonSolver(DiscreteProblem<double>* dp) : NewtonSolver<double>(dp), residuals(0), jacobians(0), both(0) {};
+  int residuals, jacobians, both;
+
+protected:
+  void assemble_residual(bool store_previous_residual) { residuals++; NewtonSolver<double>::assemble_residual(store_previous_residual); }
+  void assemble_jacobian(bool store_previous_jacobian) { jacobians++; NewtonSolver<double>::assemble_jacobian(store_previous_jacobian); }
+  void assemble(bool store_previous_jacobian, bool store_previous_residual) { both++; NewtonSolver<double>::assemble(store_previous_jacobian, store_previous_residual); }
+};
+
+int main(int argc, char* argv[])
+{
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("domain.mesh", mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh->refine_all_elements();
+
+  CustomEssentialBCNonConst bc_essential("Bdy");
+  EssentialBCs<double> bcs(&bc_essential);
+  SpaceSharedPtr<double> space(new H1Space<double>(mesh, &bcs, P_INIT));
+  int ndof = space->get_num_dofs();
+
+  CustomNonlinearity lambda;
+  Hermes2DFunction<double> src(-1.0);
+  DefaultWeakFormPoisson<double> wf(HERMES_ANY, &lambda, &src);
+
+  bool success = true;
+  double* solutions[2];
+  for (int variant = 0; variant < 2; variant++)
+  {
+    DiscreteProblem<double> dp(&wf, space);
+    CountingNewtonSolver newton(&dp);
+    newton.set_tolerance(NEWTON_TOL, Hermes::Solvers::ResidualNormAbsolute);
+    newton.set_max_allowed_iterations(100);
+    if (variant == 1)
+    {
+      newton.set_max_steps_with_reused_jacobian(0);
+      newton.set_manual_damping_coeff(true, 1.0);
+    }
+
+    Hermes::Mixins::TimeMeasurable cpu_time;
+    cpu_time.tick();
+    newton.solve();
+    cpu_time.tick();
+
+    std::cout << (variant == 0 ? "Automatic damping, reused jacobian: " : "Manual damping, no reused jacobian: ") << newton.get_num_iters() << " iterations, "
+      << newton.residuals << " residuals, " << newton.jacobians << " jacobians, " << newton.both << " residuals with jacobians assembled, " << cpu_time.last() << " s." << std::endl;
+
+    // One assembling per iteration (and the initial one), the jacobian not at the converged iterate (a separate one
+    // follows the residual if the convergence was expected and did not come).
+    if (variant == 1 && (newton.residuals + newton.both != newton.get_num_iters() + 1 || newton.both + newton.jacobians != newton.get_num_iters()))
+      success = false;
+
+    solutions[variant] = malloc_with_check<double>(ndof);
+    memcpy(solutions[variant], newton.get_sln_vector(), ndof * sizeof(double));
+  }
+
+  double difference = 0.;
+  for (int i = 0; i < ndof; i++)
+    difference = std::max(difference, std::abs(solutions[0][i] - solutions[1][i]));
+  std::cout << "Solution difference: " << difference << "." << std::endl;
+  if (difference > 1e-8)
+    success = false;
+
+  // Separate residual and jacobian (at the same iterate) vs. both at once.
+  DiscreteProblem<double> dp(&wf, space), dp_separate(&wf, space);
+  CSCMatrix<double> matrix, matrix_separate;
+  SimpleVector<double> rhs(ndof), rhs_separate(ndof);
+  dp.assemble(solutions[1], &matrix, &rhs);
+  dp_separate.assemble(solutions[1], &rhs_separate);
+  dp_separate.assemble(solutions[1], &matrix_separate);
+
+  double* product = malloc_with_check<double>(ndof);
+  double* product_separate = malloc_with_check<double>(ndof);
+  matrix.multiply_with_vector(solutions[1], product, true);
+  matrix_separate.multiply_with_vector(solutions[1], product_separate, true);
+  double matrix_difference = 0., rhs_difference = 0.;
+  for (int i = 0; i < ndof; i++)
+  {
+    matrix_difference = std::max(matrix_difference, std::abs(product[i] - product_separate[i]));
+    rhs_difference = std::max(rhs_difference, std::abs(rhs.get(i) - rhs_separate.get(i)));
+  }
+  std::cout << "Jacobian difference: " << matrix_difference << ", residual difference: " << rhs_difference << "." << std::endl;
+  if (matrix_difference > 1e-12 || rhs_difference > 1e-12)
+    success = false;
+
+  free_with_check(product);
+  free_with_check(product_separate);
+
+  // New essential BC values at the same coefficient vector.
+  DiscreteProblem<double> dp_time(&wf, space), dp_new(&wf, space);
+  NewtonSolver<double> newton_time(&dp_time), newton_new(&dp_new);
+  newton_time.set_tolerance(NEWTON_TOL, Hermes::Solvers::ResidualNormAbsolute);
+  newton_new.set_tolerance(NEWTON_TOL, Hermes::Solvers::ResidualNormAbsolute);
+  // The last assembling of the first solution is at its final iterate.
+  newton_time.solve();
+  memcpy(solutions[0], newton_time.get_sln_vector(), ndof * sizeof(double));
+  Space<double>::update_essential_bc_values(space, 1.0);
+  newton_time.solve(solutions[0]);
+  newton_new.solve(solutions[0]);
+  double time_difference = 0.;
+  for (int i = 0; i < ndof; i++)
+    time_difference = std::max(time_difference, std::abs(newton_time.get_sln_vector()[i] - newton_new.get_sln_vector()[i]));
+  std::cout << "Solution difference after the essential BC update: " << time_difference << "." << std::endl;
+  if (time_difference > 1e-8)
+    success = false;
+
+  free_with_check(solutions[0]);
+  free_with_check(solutions[1]);
+
+  if (success)
+  {
+    std::cout << "Success!";
+    return 0;
+  }
+  else
+  {
+    std::cout << "Failure!";
+    return -1;
+  }
+}
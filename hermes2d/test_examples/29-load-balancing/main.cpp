@@ -0,0 +1,197 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+
+// Load balancing of the element-parallel loops (LoadBalancer): on a mesh with high polynomial orders in one corner and
+// linear elements elsewhere, the chunks handed out to the threads have to cover all states exactly once, the contiguous
+// ranges have to be balanced better than the ranges of equal numbers of states. The parallel assembling and error
+// calculation (with the busy times of the threads reported) are compared with the serial ones.
+
+const int INIT_REF_NUM = 4;
+const int P_MAX = 9;
+const int NUM_THREADS_PARALLEL = 4;
+
+// Results of one assembling & error calculation.
+struct Results
+{
+  double* product;
+  double* rhs;
+  double error;
+};
+
+static void calculate(SpaceSharedPtr<double> space, int num_threads, Results& results)
+{
+  HermesCommonApi.set_integral_param_value(numThreads, num_threads);
+  int ndof = space->get_num_dofs();
+
+  Hermes2DFunction<double> src(-1.0);
+  DefaultWeakFormPoisson<double> wf(HERMES_ANY, nullptr, &src);
+  DiscreteProblem<double> dp(&wf, space);
+  dp.set_verbose_output(true);
+  dp.set_report_load_balance();
+  CSCMatrix<double> matrix;
+  SimpleVector<double> rhs(ndof);
+  dp.assemble(&matrix, &rhs);
+
+  double* coeffs = malloc_with_check<double>(ndof);
+  for (int i = 0; i < ndof; i++)
+    coeffs[i] = std::sin((double)i);
+  results.product = malloc_with_check<double>(ndof);
+  matrix.multiply_with_vector(coeffs, results.product, true);
+  results.rhs = malloc_with_check<double>(ndof);
+  rhs.extract(results.rhs);
+
+  MeshFunctionSharedPtr<double> sln(new Solution<double>);
+  Solution<double>::vector_to_solution(coeffs, space, sln);
+  MeshFunctionSharedPtr<double> fine_sln(new ConstantSolution<double>(space->get_mesh(), 1.0));
+  DefaultErrorCalculator<double, HERMES_H1_NORM> errorCalculator(AbsoluteError, 1);
+  errorCalculator.set_verbose_output(true);
+  errorCalculator.set_report_load_balance();
+  errorCalculator.calculate_errors(sln, fine_sln);
+  results.error = errorCalculator.get_total_error_squared();
+
+  free_with_check(coeffs);
+}
+
+int main(int argc, char* argv[])
+{
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("domain.mesh", mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh->refine_all_elements();
+
+  // The orders decrease from P_MAX in the corner (-10, -10) to 1.
+  SpaceSharedPtr<double> space(new H1Space<double>(mesh, 1));
+  Element* e;
+  for_all_active_elements(e, mesh)
+  {
+    double x = 0., y = 0.;
+    for (unsigned int i = 0; i < e->get_nvert(); i++)
+    {
+      x += e->vn[i]->x / e->get_nvert();
+      y += e->vn[i]->y / e->get_nvert();
+    }
+    double distance = std::sqrt((x + 10.) * (x + 10.) + (y + 10.) * (y + 10.));
+    int order = std::max(1, (int)(P_MAX * (1. - distance / 10.)));
+    if (order > 1)
+      space->set_element_order(e->id, order);
+  }
+  space->assign_dofs();
+  std::cout << "DOFs: " << space->get_num_dofs() << std::endl;
+
+  bool success = true;
+
+  // Chunks & ranges.
+  Hermes::vector<MeshSharedPtr> meshes;
+  meshes.push_back(mesh);
+  Hermes::vector<SpaceSharedPtr<double> > spaces;
+  spaces.push_back(space);
+  int num_states;
+  Traverse trav(1);
+  Traverse::State** states = trav.get_states(meshes, num_states);
+
+  LoadBalancer loadBalancer(num_states, NUM_THREADS_PARALLEL);
+  double* costs = malloc_with_check<double>(num_states);
+  for (int i = 0; i < num_states; i++)
+  {
+    costs[i] = LoadBalancer::get_assembling_cost(states[i], spaces, 1);
+    loadBalancer.set_cost(i, costs[i]);
+  }
+  loadBalancer.init();
+
+  int* processed = calloc_with_check<int>(num_states);
+#pragma omp parallel num_threads(NUM_THREADS_PARALLEL)
+  {
+    int thread_number = omp_get_thread_num();
+    int start, end;
+    while (loadBalancer.get_chunk(thread_number, start, end))
+    for (int i = start; i < end; i++)
+      processed[i]++;
+  }
+  int num_processed = 0;
+  for (int thread_i = 0; thread_i < NUM_THREADS_PARALLEL; thread_i++)
+    num_processed += loadBalancer.get_num_items_processed(thread_i);
+  for (int i = 0; i < num_states; i++)
+  if (processed[i] != 1)
+    success = false;
+  if (num_processed != num_states)
+    success = false;
+
+  double max_cost = 0., total_cost = 0., max_range_cost = 0., max_equal_range_cost = 0.;
+  for (int i = 0; i < num_states; i++)
+  {
+    max_cost = std::max(max_cost, costs[i]);
+    total_cost += costs[i];
+  }
+  int previous_end = 0;
+  for (int thread_i = 0; thread_i < NUM_THREADS_PARALLEL; thread_i++)
+  {
+    int start, end;
+    loadBalancer.get_range(thread_i, start, end);
+    if (start != previous_end)
+      success = false;
+    previous_end = end;
+
+    double range_cost = 0., equal_range_cost = 0.;
+    for (int i = start; i < end; i++)
+      range_cost += costs[i];
+    for (int i = thread_i * num_states / NUM_THREADS_PARALLEL; i < (thread_i + 1) * num_states / NUM_THREADS_PARALLEL; i++)
+      equal_range_cost += costs[i];
+    max_range_cost = std::max(max_range_cost, range_cost);
+    max_equal_range_cost = std::max(max_equal_range_cost, equal_range_cost);
+  }
+  if (previous_end != num_states)
+    success = false;
+  std::cout << "Maximum cost of a thread: " << max_range_cost << " (balanced), " << max_equal_range_cost << " (equal numbers of states), "
+    << total_cost / NUM_THREADS_PARALLEL << " (average)." << std::endl;
+  if (max_range_cost > total_cost / NUM_THREADS_PARALLEL + max_cost || max_range_cost > max_equal_range_cost)
+    success = false;
+
+  free_with_check(costs);
+  free_with_check(processed);
+  for (int i = 0; i < num_states; i++)
+    delete states[i];
+  free_with_check(states);
+
+  // Serial vs. parallel.
+  Results serial, parallel;
+  Hermes::Mixins::TimeMeasurable cpu_time;
+  cpu_time.tick();
+  calculate(space, 1, serial);
+  cpu_time.tick();
+  std::cout << "Serial: " << cpu_time.last() << " s." << std::endl;
+  calculate(space, NUM_THREADS_PARALLEL, parallel);
+  cpu_time.tick();
+  std::cout << "Parallel: " << cpu_time.last() << " s." << std::endl;
+
+  int ndof = space->get_num_dofs();
+  double matrix_difference = 0., rhs_difference = 0.;
+  for (int i = 0; i < ndof; i++)
+  {
+    matrix_difference = std::max(matrix_difference, std::abs(serial.product[i] - parallel.product[i]));
+    rhs_difference = std::max(rhs_difference, std::abs(serial.rhs[i] - parallel.rhs[i]));
+  }
+  double error_difference = std::abs(serial.error - parallel.error) / serial.error;
+  std::cout << "Jacobian difference: " << matrix_difference << ", residual difference: " << rhs_difference << ", error difference: " << error_difference << "." << std::endl;
+  if (matrix_difference > 1e-10 || rhs_difference > 1e-12 || error_difference > 1e-12)
+    success = false;
+
+  free_with_check(serial.product);
+  free_with_check(serial.rhs);
+  free_with_check(parallel.product);
+  free_with_check(parallel.rhs);
+
+  if (success)
+  {
+    std::cout << "Success!";
+    return 0;
+  }
+  else
+  {
+    std::cout << "Failure!";
+    return -1;
+  }
+}
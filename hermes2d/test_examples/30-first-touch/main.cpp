@@ -0,0 +1,167 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+
+// First-touch initialization of the big arrays (zero_first_touch()): a STREAM-like triad a = b + s * c is measured on
+// arrays zeroed serially and on arrays zeroed by the threads that then work on them (the difference only shows on
+// multi-socket machines with the threads bound to cores, e.g. OMP_PROC_BIND=close OMP_PLACES=cores, the bandwidths are
+// only reported). The row-parallel product of a CSRMatrix is compared with the one of a CSCMatrix assembled from the same
+// weak form, the coefficients of a Solution set in parallel with the serially set ones.
+
+const int INIT_REF_NUM = 5;
+const int P_INIT = 4;
+const int NUM_THREADS_PARALLEL = 4;
+const int STREAM_SIZE = 1 << 23;
+const int STREAM_REPEATS = 10;
+
+// The bandwidth (in GB/s) of the best of the triads on three arrays allocated & zeroed serially or by the first touch.
+static double triad_bandwidth(bool first_touch)
+{
+  double* a = malloc_with_check<double>(STREAM_SIZE);
+  double* b = malloc_with_check<double>(STREAM_SIZE);
+  double* c = malloc_with_check<double>(STREAM_SIZE);
+  if (first_touch)
+  {
+    zero_first_touch(a, STREAM_SIZE);
+    zero_first_touch(b, STREAM_SIZE);
+    zero_first_touch(c, STREAM_SIZE);
+  }
+  else
+  {
+    memset(a, 0, STREAM_SIZE * sizeof(double));
+    memset(b, 0, STREAM_SIZE * sizeof(double));
+    memset(c, 0, STREAM_SIZE * sizeof(double));
+  }
+
+  int num_threads = HermesCommonApi.get_integral_param_value(numThreads);
+#pragma omp parallel for schedule(static) num_threads(num_threads)
+  for (int i = 0; i < STREAM_SIZE; i++)
+  {
+    b[i] = 1.;
+    c[i] = 2.;
+  }
+
+  double best_time = std::numeric_limits<double>::max();
+  Hermes::Mixins::TimeMeasurable cpu_time;
+  for (int repeat = 0; repeat < STREAM_REPEATS; repeat++)
+  {
+    cpu_time.tick();
+#pragma omp parallel for schedule(static) num_threads(num_threads)
+    for (int i = 0; i < STREAM_SIZE; i++)
+      a[i] = b[i] + 3. * c[i];
+    cpu_time.tick();
+    best_time = std::min(best_time, cpu_time.last());
+  }
+
+  bool correct = (a[0] == 7. && a[STREAM_SIZE - 1] == 7.);
+  free_with_check(a);
+  free_with_check(b);
+  free_with_check(c);
+
+  if (!correct)
+    return -1.;
+  return 3. * STREAM_SIZE * sizeof(double) / std::max(best_time, 1e-9) / 1e9;
+}
+
+int main(int argc, char* argv[])
+{
+  HermesCommonApi.set_integral_param_value(numThreads, NUM_THREADS_PARALLEL);
+  bool success = true;
+
+  // STREAM triad.
+  double bandwidth_serial = triad_bandwidth(false);
+  double bandwidth_first_touch = triad_bandwidth(true);
+  std::cout << "Triad bandwidth: " << bandwidth_serial << " GB/s (serial initialization), " << bandwidth_first_touch << " GB/s (first touch)." << std::endl;
+  if (bandwidth_serial < 0. || bandwidth_first_touch < 0.)
+    success = false;
+
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("domain.mesh", mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh->refine_all_elements();
+  SpaceSharedPtr<double> space(new H1Space<double>(mesh, P_INIT));
+  int ndof = space->get_num_dofs();
+  std::cout << "DOFs: " << ndof << std::endl;
+
+  // CSR (row-parallel) vs. CSC matrix-vector product.
+  Hermes2DFunction<double> src(-1.0);
+  DefaultWeakFormPoisson<double> wf(HERMES_ANY, nullptr, &src);
+  DiscreteProblem<double> dp_csc(&wf, space), dp_csr(&wf, space);
+  CSCMatrix<double> matrix_csc;
+  CSRMatrix<double> matrix_csr;
+  dp_csc.assemble(&matrix_csc);
+  dp_csr.assemble(&matrix_csr);
+
+  double* coeffs = malloc_with_check<double>(ndof);
+  for (int i = 0; i < ndof; i++)
+    coeffs[i] = std::sin((double)i);
+  double* product_csc = malloc_with_check<double>(ndof);
+  double* product_csr = malloc_with_check<double>(ndof);
+  matrix_csc.multiply_with_vector(coeffs, product_csc, true);
+  Hermes::Mixins::TimeMeasurable cpu_time;
+  cpu_time.tick();
+  matrix_csr.multiply_with_vector(coeffs, product_csr, true);
+  cpu_time.tick();
+  std::cout << "CSR product: " << cpu_time.last() << " s." << std::endl;
+
+  double product_difference = 0.;
+  for (int i = 0; i < ndof; i++)
+    product_difference = std::max(product_difference, std::abs(product_csc[i] - product_csr[i]));
+  std::cout << "Product difference: " << product_difference << "." << std::endl;
+  if (product_difference > 1e-10)
+    success = false;
+
+  // The zeroed matrix keeps its structure.
+  matrix_csr.zero();
+  matrix_csr.multiply_with_vector(coeffs, product_csr, true);
+  for (int i = 0; i < ndof; i++)
+  if (product_csr[i] != 0.)
+    success = false;
+
+  free_with_check(product_csc);
+  free_with_check(product_csr);
+
+  // Solution coefficients: serial vs. parallel.
+  MeshFunctionSharedPtr<double> sln_serial(new Solution<double>), sln_parallel(new Solution<double>);
+  HermesCommonApi.set_integral_param_value(numThreads, 1);
+  cpu_time.tick();
+  Solution<double>::vector_to_solution(coeffs, space, sln_serial);
+  cpu_time.tick();
+  std::cout << "Solution coefficients (serial): " << cpu_time.last() << " s." << std::endl;
+  HermesCommonApi.set_integral_param_value(numThreads, NUM_THREADS_PARALLEL);
+  Solution<double>::vector_to_solution(coeffs, space, sln_parallel);
+  cpu_time.tick();
+  std::cout << "Solution coefficients (parallel): " << cpu_time.last() << " s." << std::endl;
+
+  const int num_points = 1000;
+  double x[num_points], y[num_points], values_serial[num_points], values_parallel[num_points];
+  for (int i = 0; i < num_points; i++)
+  {
+    x[i] = -9.99 + 19.98 * (i % 37) / 36.;
+    y[i] = -9.99 + 19.98 * i / (num_points - 1.);
+  }
+  sln_serial->get_pt_values(num_points, x, y, values_serial);
+  sln_parallel->get_pt_values(num_points, x, y, values_parallel);
+  double solution_difference = 0.;
+  for (int i = 0; i < num_points; i++)
+    solution_difference = std::max(solution_difference, std::abs(values_serial[i] - values_parallel[i]));
+  std::cout << "Solution difference: " << solution_difference << "." << std::endl;
+  if (solution_difference > 1e-12)
+    success = false;
+
+  free_with_check(coeffs);
+
+  if (success)
+  {
+    std::cout << "Success!";
+    return 0;
+  }
+  else
+  {
+    std::cout << "Failure!";
+    return -1;
+  }
+}
@@ -0,0 +1,146 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+
+// Explicit Runge-Kutta methods: the stages computed with the cached inverse of the mass matrix (set_explicit_stages())
+// have to give the same solution as the Newton's method on the block stage system (the default). The mass matrix
+// is factorized for an H1 space (heat equation du/dt = Laplace u + 1) and inverted element by element for an L2
+// space (du/dt = 1 - u).
+
+const int INIT_REF_NUM = 2;
+const int P_INIT = 2;
+const double NEWTON_TOL = 1e-12;
+
+// Residual - (grad u, grad v) of the heat equation, or - (u, v) of the reaction. The forms in the stage weak form are
+// clones with the stage index in i and the u_ext of the stage already offset, so the stage solution is u_ext[0].
+class CustomResidual : public VectorFormVol<double>
+{
+public:
+  CustomResidual(bool diffusion) : VectorFormVol<double>(0), diffusion(diffusion) {};
+
+  template<typename Real, typename Scalar>
+  Scalar vector_form(int n, double *wt, Func<Scalar> *u_ext[], Func<Real> *v) const
+  {
+    Scalar result = Scalar(0);
+    for (int i = 0; i < n; i++)
+    {
+      if (diffusion)
+        result -= wt[i] * (u_ext[0]->dx[i] * v->dx[i] + u_ext[0]->dy[i] * v->dy[i]);
+      else
+        result -= wt[i] * u_ext[0]->val[i] * v->val[i];
+    }
+    return result;
+  }
+
+  double value(int n, double *wt, Func<double> *u_ext[], Func<double> *v, Geom<double> *e, Func<double> **ext) const
+  {
+    return vector_form<double, double>(n, wt, u_ext, v);
+  }
+
+  Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *v, Geom<Ord> *e, Func<Ord> **ext) const
+  {
+    return vector_form<Ord, Ord>(n, wt, u_ext, v);
+  }
+
+  VectorFormVol<double>* clone() const { return new CustomResidual(*this); }
+
+  bool diffusion;
+};
+
+// Maximum difference of the solutions at a grid of points.
+static double difference(MeshFunctionSharedPtr<double> a, MeshFunctionSharedPtr<double> b)
+{
+  const int n = 21;
+  double x[n * n], y[n * n], values_a[n * n], values_b[n * n];
+  for (int i = 0; i < n; i++)
+  {
+    for (int j = 0; j < n; j++)
+    {
+      x[i * n + j] = i / (n - 1.);
+      y[i * n + j] = j / (n - 1.);
+    }
+  }
+  a->get_pt_values(n * n, x, y, values_a);
+  b->get_pt_values(n * n, x, y, values_b);
+
+  double result = 0.;
+  for (int i = 0; i < n * n; i++)
+    result = std::max(result, std::abs(values_a[i] - values_b[i]));
+  return result;
+}
+
+// Time steps with both variants, returns the difference of the results relative to the maximum of the solution.
+static double compare_variants(WeakForm<double>* wf, SpaceSharedPtr<double> space, ButcherTableType table, double time_step, int num_steps)
+{
+  ButcherTable bt(table);
+  MeshSharedPtr mesh = space->get_mesh();
+  MeshFunctionSharedPtr<double> slns[2];
+  Hermes::Mixins::TimeMeasurable cpu_time;
+
+  for (int variant = 0; variant < 2; variant++)
+  {
+    MeshFunctionSharedPtr<double> sln_time_prev(new ZeroSolution<double>(mesh));
+    slns[variant] = new Solution<double>(mesh);
+
+    RungeKutta<double> runge_kutta(wf, space, &bt);
+    runge_kutta.set_tolerance(NEWTON_TOL);
+    runge_kutta.set_time_step(time_step);
+    if (variant == 1)
+      runge_kutta.set_explicit_stages();
+
+    cpu_time.tick();
+    for (int step = 0; step < num_steps; step++)
+    {
+      runge_kutta.set_time(step * time_step);
+      runge_kutta.rk_time_step_newton(sln_time_prev, slns[variant]);
+      sln_time_prev->copy(slns[variant]);
+    }
+    cpu_time.tick();
+    std::cout << (variant == 0 ? "Newton's method: " : "Explicit stages: ") << cpu_time.last() << " s." << std::endl;
+  }
+
+  double maximum = difference(slns[0], MeshFunctionSharedPtr<double>(new ZeroSolution<double>(mesh)));
+  return difference(slns[0], slns[1]) / maximum;
+}
+
+int main(int argc, char* argv[])
+{
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("square.mesh", mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh->refine_all_elements();
+
+  // Heat equation (the right-hand side and its Jacobian).
+  DefaultEssentialBCConst<double> bc_essential("Bdy", 0.0);
+  EssentialBCs<double> bcs(&bc_essential);
+  SpaceSharedPtr<double> h1_space(new H1Space<double>(mesh, &bcs, P_INIT));
+  WeakForm<double> wf_heat(1);
+  wf_heat.add_matrix_form(new DefaultMatrixFormDiffusion<double>(0, 0, HERMES_ANY, new Hermes1DFunction<double>(-1.0)));
+  wf_heat.add_vector_form(new CustomResidual(true));
+  wf_heat.add_vector_form(new DefaultVectorFormVol<double>(0, HERMES_ANY, new Hermes2DFunction<double>(1.0)));
+  double heat_difference = compare_variants(&wf_heat, h1_space, Explicit_RK_4, 1e-5, 20);
+  std::cout << "H1 space, relative difference: " << heat_difference << "." << std::endl;
+
+  // Reaction.
+  SpaceSharedPtr<double> l2_space(new L2Space<double>(mesh, P_INIT));
+  WeakForm<double> wf_reaction(1);
+  wf_reaction.add_matrix_form(new DefaultMatrixFormVol<double>(0, 0, HERMES_ANY, new Hermes2DFunction<double>(-1.0)));
+  wf_reaction.add_vector_form(new CustomResidual(false));
+  wf_reaction.add_vector_form(new DefaultVectorFormVol<double>(0, HERMES_ANY, new Hermes2DFunction<double>(1.0)));
+  double reaction_difference = compare_variants(&wf_reaction, l2_space, Explicit_RK_3, 0.1, 10);
+  std::cout << "L2 space, relative difference: " << reaction_difference << "." << std::endl;
+
+  if (heat_difference < 1e-10 && reaction_difference < 1e-10)
+  {
+    std::cout << "Success!";
+    return 0;
+  }
+  else
+  {
+    std::cout << "Failure!";
+    return -1;
+  }
+}
@@ -0,0 +1,163 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+
+// Kelly-type error estimates: the element errors are checked against values known in closed form, the evaluation
+// of every interface once (ignore_visited_segments) against the evaluation from both sides, and the parallel
+// evaluation against the serial one.
+//
+// The hat function u = 1 - |x - 1| on (0, 2) x (0, 1) lies in the Q1 space of both meshes (the square [1, 2] x [0, 1]
+// next to the square [0, 1] x [0, 1], or to its four sons), the jump of its normal derivative across x = 1 is 2.
+// An interface segment of length l between the elements e1, e2 thus contributes (0.5 * 4 * l) * diam(e) to both
+// of them, the volumetric estimator \int_e u^2 is 1/3 on both squares.
+
+class HatFunction : public ExactSolutionScalar<double>
+{
+public:
+  HatFunction(MeshSharedPtr mesh) : ExactSolutionScalar<double>(mesh) {};
+
+  double value(double x, double y) const { return 1. - std::abs(x - 1.); }
+  void derivatives(double x, double y, double& dx, double& dy) const { dx = (x < 1. ? 1. : -1.); dy = 0.; }
+  Ord ord(double x, double y) const { return Ord(1); }
+  MeshFunction<double>* clone() const { return new HatFunction(this->mesh); }
+};
+
+class SmoothFunction : public ExactSolutionScalar<double>
+{
+public:
+  SmoothFunction(MeshSharedPtr mesh) : ExactSolutionScalar<double>(mesh) {};
+
+  double value(double x, double y) const { return std::sin(3. * x) * std::exp(y); }
+  void derivatives(double x, double y, double& dx, double& dy) const { dx = 3. * std::cos(3. * x) * std::exp(y); dy = value(x, y); }
+  Ord ord(double x, double y) const { return Ord(10); }
+  MeshFunction<double>* clone() const { return new SmoothFunction(this->mesh); }
+};
+
+// Volumetric estimator \int_e u^2.
+class SquareEstimatorForm : public KellyTypeAdapt<double>::ErrorEstimatorForm
+{
+public:
+  SquareEstimatorForm() : KellyTypeAdapt<double>::ErrorEstimatorForm(0) {};
+
+  double value(int n, double *wt, Func<double> *u_ext[], DiscontinuousFunc<double> *u, Geom<double> *e, Func<double> **ext) const
+  {
+    double result = 0.;
+    for (int i = 0; i < n; i++)
+      result += wt[i] * u->val[i] * u->val[i];
+    return result;
+  }
+};
+
+static KellyTypeAdapt<double>* create_estimator(SpaceSharedPtr<double> space, bool ignore_visited_segments, int num_threads)
+{
+  HermesCommonApi.set_integral_param_value(numThreads, num_threads);
+  KellyTypeAdapt<double>* estimator = new KellyTypeAdapt<double>(space, ignore_visited_segments, nullptr, HERMES_UNSET_NORM, AbsoluteError);
+  estimator->add_error_estimator_surf(new BasicKellyAdapt<double>::ErrorEstimatorFormKelly());
+  estimator->add_error_estimator_vol(new SquareEstimatorForm());
+  return estimator;
+}
+
+// Maximum difference of the element errors.
+static double difference(KellyTypeAdapt<double>* a, KellyTypeAdapt<double>* b, MeshSharedPtr mesh)
+{
+  double result = 0.;
+  Element* e;
+  for_all_active_elements(e, mesh)
+    result = std::max(result, std::abs(a->get_element_error_squared(0, e->id) - b->get_element_error_squared(0, e->id)));
+  return result;
+}
+
+// Checks the element errors of the hat function with the expected ones, returns the maximum difference.
+static double check_hat(MeshSharedPtr mesh, double* expected)
+{
+  SpaceSharedPtr<double> space(new H1Space<double>(mesh, 1));
+  MeshFunctionSharedPtr<double> exact(new HatFunction(mesh));
+  MeshFunctionSharedPtr<double> sln(new Solution<double>());
+  OGProjection<double>::project_global(space, exact, sln);
+
+  double result = 0.;
+  KellyTypeAdapt<double>* estimators[2];
+  for (int variant = 0; variant < 2; variant++)
+  {
+    estimators[variant] = create_estimator(space, variant == 0, 1);
+    estimators[variant]->calculate_errors(sln);
+
+    Element* e;
+    for_all_active_elements(e, mesh)
+    {
+      std::cout << "Element " << e->id << ": " << estimators[variant]->get_element_error_squared(0, e->id) << " (expected " << expected[e->id] << ")." << std::endl;
+      result = std::max(result, std::abs(estimators[variant]->get_element_error_squared(0, e->id) - expected[e->id]));
+    }
+  }
+
+  delete estimators[0];
+  delete estimators[1];
+  return result;
+}
+
+int main(int argc, char* argv[])
+{
+  bool success = true;
+
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("two.mesh", mesh);
+
+  // Two squares.
+  double expected[10];
+  expected[0] = expected[1] = 2. * std::sqrt(2.) + 1. / 3.;
+  double hat_difference = check_hat(mesh, expected);
+
+  // The left square refined: two interface segments of length 1/2 (the neighbors of diameter sqrt(2) / 2 at
+  // the hanging node), the left sons with the integrals of x^2 over their halves of (0, 1).
+  mesh->refine_element_id(0);
+  expected[1] = 2. * std::sqrt(2.) + 1. / 3.;
+  expected[2] = expected[5] = 1. / 48.;
+  expected[3] = expected[4] = std::sqrt(2.) / 2. + 7. / 48.;
+  hat_difference = std::max(hat_difference, check_hat(mesh, expected));
+  std::cout << "Hat function, maximum element error difference: " << hat_difference << "." << std::endl;
+  if (hat_difference > 1e-12)
+    success = false;
+
+  // Serial vs. parallel on an irregular mesh.
+  mesh->refine_element_id(3);
+  mesh->refine_element_id(1, 1);
+  for (int i = 0; i < 2; i++)
+    mesh->refine_all_elements();
+  SpaceSharedPtr<double> space(new H1Space<double>(mesh, 2));
+  MeshFunctionSharedPtr<double> exact(new SmoothFunction(mesh));
+  MeshFunctionSharedPtr<double> sln(new Solution<double>());
+  OGProjection<double>::project_global(space, exact, sln);
+
+  int num_threads = HermesCommonApi.get_integral_param_value(numThreads);
+  KellyTypeAdapt<double>* serial = create_estimator(space, true, 1);
+  KellyTypeAdapt<double>* parallel = create_estimator(space, true, 4);
+  KellyTypeAdapt<double>* both_sides = create_estimator(space, false, 4);
+  serial->calculate_errors(sln);
+  parallel->calculate_errors(sln);
+  both_sides->calculate_errors(sln);
+  HermesCommonApi.set_integral_param_value(numThreads, num_threads);
+
+  double parallel_difference = difference(serial, parallel, mesh) / serial->get_total_error_squared();
+  double both_sides_difference = difference(serial, both_sides, mesh) / serial->get_total_error_squared();
+  std::cout << "Total error estimate: " << serial->get_total_error_squared() << ", relative difference of the parallel evaluation: "
+    << parallel_difference << ", of the evaluation from both sides: " << both_sides_difference << "." << std::endl;
+  if (parallel_difference > 1e-12 || both_sides_difference > 1e-12)
+    success = false;
+
+  delete serial;
+  delete parallel;
+  delete both_sides;
+
+  if (success)
+  {
+    std::cout << "Success!";
+    return 0;
+  }
+  else
+  {
+    std::cout << "Failure!";
+    return -1;
+  }
+}
@@ -0,0 +1,183 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+
+// Diagonally implicit Runge-Kutta methods: the stages solved one after another on the system of the original size
+// (set_stage_sequential()), also with one factorization for all stages (set_freeze_jacobian()), have to give the
+// same solution and the same error estimate of the embedded method as the Newton's method on the monolithic stage
+// system (the default). The problem is the heat equation du/dt = Laplace u + 1 - u^2.
+
+const int INIT_REF_NUM = 2;
+const int P_INIT = 2;
+const double NEWTON_TOL = 1e-12;
+
+// Residual - (grad u, grad v) - (u^2, v). The stage solution is u_ext[0] in both the monolithic stage weak form,
+// whose clones have the u_ext of the stage already offset, and in the single-stage one.
+class CustomResidual : public VectorFormVol<double>
+{
+public:
+  CustomResidual() : VectorFormVol<double>(0) {};
+
+  template<typename Real, typename Scalar>
+  Scalar vector_form(int n, double *wt, Func<Scalar> *u_ext[], Func<Real> *v) const
+  {
+    Scalar result = Scalar(0);
+    for (int i = 0; i < n; i++)
+      result -= wt[i] * (u_ext[0]->dx[i] * v->dx[i] + u_ext[0]->dy[i] * v->dy[i] + u_ext[0]->val[i] * u_ext[0]->val[i] * v->val[i]);
+    return result;
+  }
+
+  double value(int n, double *wt, Func<double> *u_ext[], Func<double> *v, Geom<double> *e, Func<double> **ext) const
+  {
+    return vector_form<double, double>(n, wt, u_ext, v);
+  }
+
+  Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *v, Geom<Ord> *e, Func<Ord> **ext) const
+  {
+    return vector_form<Ord, Ord>(n, wt, u_ext, v);
+  }
+
+  VectorFormVol<double>* clone() const { return new CustomResidual(*this); }
+};
+
+// Jacobian - (grad u, grad v) - 2 (u_prev u, v).
+class CustomJacobian : public MatrixFormVol<double>
+{
+public:
+  CustomJacobian() : MatrixFormVol<double>(0, 0) {};
+
+  template<typename Real, typename Scalar>
+  Scalar matrix_form(int n, double *wt, Func<Scalar> *u_ext[], Func<Real> *u, Func<Real> *v) const
+  {
+    Scalar result = Scalar(0);
+    for (int i = 0; i < n; i++)
+      result -= wt[i] * (u->dx[i] * v->dx[i] + u->dy[i] * v->dy[i] + 2. * u_ext[0]->val[i] * u->val[i] * v->val[i]);
+    return result;
+  }
+
+  double value(int n, double *wt, Func<double> *u_ext[], Func<double> *u, Func<double> *v, Geom<double> *e, Func<double> **ext) const
+  {
+    return matrix_form<double, double>(n, wt, u_ext, u, v);
+  }
+
+  Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v, Geom<Ord> *e, Func<Ord> **ext) const
+  {
+    return matrix_form<Ord, Ord>(n, wt, u_ext, u, v);
+  }
+
+  MatrixFormVol<double>* clone() const { return new CustomJacobian(*this); }
+};
+
+// Maximum difference of the solutions at a grid of points.
+static double difference(MeshFunctionSharedPtr<double> a, MeshFunctionSharedPtr<double> b)
+{
+  const int n = 21;
+  double x[n * n], y[n * n], values_a[n * n], values_b[n * n];
+  for (int i = 0; i < n; i++)
+  {
+    for (int j = 0; j < n; j++)
+    {
+      x[i * n + j] = i / (n - 1.);
+      y[i * n + j] = j / (n - 1.);
+    }
+  }
+  a->get_pt_values(n * n, x, y, values_a);
+  b->get_pt_values(n * n, x, y, values_b);
+
+  double result = 0.;
+  for (int i = 0; i < n * n; i++)
+    result = std::max(result, std::abs(values_a[i] - values_b[i]));
+  return result;
+}
+
+// Time steps with the monolithic system (variant 0), the sequential stages switched on after the first step (1) and
+// the sequential stages with the frozen Jacobian (2), returns the maximum difference of the results to the monolithic ones relative to the
+// maximum of the solution. With an embedded table, the error functions of the last step are compared too, relative
+// to the same maximum: the error estimate is the difference of two nearly equal combinations of the stages, the
+// Newton's tolerance limits its relative accuracy.
+static double compare_variants(WeakForm<double>* wf, SpaceSharedPtr<double> space, ButcherTableType table, double time_step, int num_steps)
+{
+  ButcherTable bt(table);
+  MeshSharedPtr mesh = space->get_mesh();
+  MeshFunctionSharedPtr<double> zero(new ZeroSolution<double>(mesh));
+  MeshFunctionSharedPtr<double> slns[3];
+  MeshFunctionSharedPtr<double> error_fns[3];
+  Hermes::Mixins::TimeMeasurable cpu_time;
+  const char* names[3] = { "Monolithic system: ", "Sequential stages from the second step: ", "Sequential stages, frozen Jacobian: " };
+
+  for (int variant = 0; variant < 3; variant++)
+  {
+    MeshFunctionSharedPtr<double> sln_time_prev(new ZeroSolution<double>(mesh));
+    slns[variant] = new Solution<double>(mesh);
+    error_fns[variant] = new Solution<double>(mesh);
+
+    RungeKutta<double> runge_kutta(wf, space, &bt);
+    runge_kutta.set_tolerance(NEWTON_TOL);
+    runge_kutta.set_time_step(time_step);
+    if (variant == 2)
+    {
+      runge_kutta.set_stage_sequential();
+      runge_kutta.set_freeze_jacobian();
+    }
+
+    cpu_time.tick();
+    for (int step = 0; step < num_steps; step++)
+    {
+      if (variant == 1 && step == 1)
+        runge_kutta.set_stage_sequential();
+      runge_kutta.set_time(step * time_step);
+      if (bt.is_embedded())
+        runge_kutta.rk_time_step_newton(sln_time_prev, slns[variant], error_fns[variant]);
+      else
+        runge_kutta.rk_time_step_newton(sln_time_prev, slns[variant]);
+      sln_time_prev->copy(slns[variant]);
+    }
+    cpu_time.tick();
+    std::cout << names[variant] << cpu_time.last() << " s." << std::endl;
+  }
+
+  double maximum = difference(slns[0], zero);
+  double result = std::max(difference(slns[0], slns[1]), difference(slns[0], slns[2])) / maximum;
+  if (bt.is_embedded())
+  {
+    double error_maximum = difference(error_fns[0], zero);
+    std::cout << "Error estimate: " << error_maximum << "." << std::endl;
+    result = std::max(result, std::max(difference(error_fns[0], error_fns[1]), difference(error_fns[0], error_fns[2])) / maximum);
+  }
+  return result;
+}
+
+int main(int argc, char* argv[])
+{
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("square.mesh", mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh->refine_all_elements();
+
+  DefaultEssentialBCConst<double> bc_essential("Bdy", 0.0);
+  EssentialBCs<double> bcs(&bc_essential);
+  SpaceSharedPtr<double> space(new H1Space<double>(mesh, &bcs, P_INIT));
+  WeakForm<double> wf(1);
+  wf.add_matrix_form(new CustomJacobian());
+  wf.add_vector_form(new CustomResidual());
+  wf.add_vector_form(new DefaultVectorFormVol<double>(0, HERMES_ANY, new Hermes2DFunction<double>(1.0)));
+
+  double sdirk_difference = compare_variants(&wf, space, Implicit_SDIRK_2_2, 0.05, 10);
+  std::cout << "SDIRK-2-2, relative difference: " << sdirk_difference << "." << std::endl;
+  double embedded_difference = compare_variants(&wf, space, Implicit_SDIRK_CASH_3_23_embedded, 0.05, 10);
+  std::cout << "SDIRK-CASH-3-23 (embedded), relative difference: " << embedded_difference << "." << std::endl;
+
+  if (sdirk_difference < 1e-10 && embedded_difference < 1e-10)
+  {
+    std::cout << "Success!";
+    return 0;
+  }
+  else
+  {
+    std::cout << "Failure!";
+    return -1;
+  }
+}
@@ -0,0 +1,148 @@
+#include "hermes2d.h"
+#include "../test_utils.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+
+// Constant forms (Form::set_constant()): the element integrals of the constant matrix forms stored in the first
+// assembling and reused in the following ones have to give the same matrices and right-hand sides as the forms
+// integrated in every assembling. Over the time steps the values of the Dirichlet condition change (the lift has to
+// follow them), as well as a form that is not constant; after the refinement of the mesh the stored integrals have
+// to be discarded. The reference integrals are off, so that the constant forms are integrated by the quadrature.
+
+const int INIT_REF_NUM = 3;
+const int P_INIT = 4;
+const int TIME_STEPS = 10;
+const double TAU = 0.1;
+
+class TimeDependentBC : public EssentialBoundaryCondition<double>
+{
+public:
+  TimeDependentBC(std::string marker) : EssentialBoundaryCondition<double>(marker) {};
+
+  EssentialBoundaryCondition<double>::EssentialBCValueType get_value_type() const
+  {
+    return EssentialBoundaryCondition<double>::BC_FUNCTION;
+  }
+
+  double value(double x, double y, double n_x, double n_y, double t_x, double t_y) const
+  {
+    return (1. + this->get_current_time()) * std::sin(x) * std::exp(y);
+  }
+};
+
+// Reaction with the coefficient 1 + t, integrated in every assembling.
+class TimeDependentReaction : public MatrixFormVol<double>
+{
+public:
+  TimeDependentReaction() : MatrixFormVol<double>(0, 0) {};
+
+  double value(int n, double *wt, Func<double> *u_ext[], Func<double> *u, Func<double> *v, Geom<double> *e, Func<double> **ext) const
+  {
+    double result = 0.;
+    for (int i = 0; i < n; i++)
+      result += wt[i] * u->val[i] * v->val[i];
+    return result * (1. + this->wf->get_current_time());
+  }
+
+  Ord ord(int n, double *wt, Func<Ord> *u_ext[], Func<Ord> *u, Func<Ord> *v, Geom<Ord> *e, Func<Ord> **ext) const
+  {
+    return u->val[0] * v->val[0];
+  }
+
+  MatrixFormVol<double>* clone() const { return new TimeDependentReaction(*this); }
+};
+
+// Mass / TAU + diffusion + advection + a boundary mass, constant or not, and the time-dependent reaction.
+static void create_weakform(WeakForm<double>& wf, bool constant)
+{
+  MatrixFormVol<double>* mass = new DefaultMatrixFormVol<double>(0, 0, HERMES_ANY, new Hermes2DFunction<double>(1. / TAU));
+  MatrixFormVol<double>* diffusion = new DefaultJacobianDiffusion<double>(0, 0, HERMES_ANY, new Hermes1DFunction<double>(1.5));
+  MatrixFormVol<double>* advection = new DefaultJacobianAdvection<double>(0, 0, HERMES_ANY, new Hermes1DFunction<double>(0.3), new Hermes1DFunction<double>(-0.7));
+  MatrixFormSurf<double>* boundary = new DefaultMatrixFormSurf<double>(0, 0, HERMES_ANY, new Hermes2DFunction<double>(2.0));
+  mass->set_constant(constant);
+  diffusion->set_constant(constant);
+  advection->set_constant(constant);
+  boundary->set_constant(constant);
+  wf.add_matrix_form(mass);
+  wf.add_matrix_form(diffusion);
+  wf.add_matrix_form(advection);
+  wf.add_matrix_form_surf(boundary);
+  wf.add_matrix_form(new TimeDependentReaction());
+  wf.add_vector_form(new DefaultVectorFormVol<double>(0, HERMES_ANY, new Hermes2DFunction<double>(1.0)));
+}
+
+// Assembles both problems (DiscreteProblem reuses the structure of the matrices, they have to be the same in every
+// assembling), returns the maximum relative difference of the matrices and of the right-hand sides.
+static double compare(DiscreteProblem<double>* dp, DiscreteProblem<double>* dp_constant, CSCMatrix<double>* matrices, SimpleVector<double>* rhs, double time[2])
+{
+  Hermes::Mixins::TimeMeasurable cpu_time;
+  cpu_time.tick();
+  dp->assemble(&matrices[0], &rhs[0]);
+  cpu_time.tick();
+  time[0] += cpu_time.last();
+  dp_constant->assemble(&matrices[1], &rhs[1]);
+  cpu_time.tick();
+  time[1] += cpu_time.last();
+
+  return std::max(relative_difference(matrices[0], matrices[1]), relative_difference(rhs[0].v, rhs[1].v, rhs[0].get_size()));
+}
+
+int main(int argc, char* argv[])
+{
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("domain.mesh", mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh->refine_all_elements();
+
+  TimeDependentBC bc_essential("Bdy");
+  EssentialBCs<double> bcs(&bc_essential);
+  SpaceSharedPtr<double> space(new H1Space<double>(mesh, &bcs, P_INIT));
+
+  WeakForm<double> wf(1), wf_constant(1);
+  create_weakform(wf, false);
+  create_weakform(wf_constant, true);
+  DiscreteProblem<double> dp(&wf, space);
+  DiscreteProblem<double> dp_constant(&wf_constant, space);
+  dp.set_reference_integrals(false);
+  dp_constant.set_reference_integrals(false);
+
+  CSCMatrix<double> matrices[2];
+  SimpleVector<double> rhs[2];
+  double difference = 0.;
+  double time[2] = { 0., 0. };
+  for (int step = 0; step <= TIME_STEPS; step++)
+  {
+    // Halfway through, a refinement.
+    if (step == TIME_STEPS / 2)
+    {
+      mesh->refine_all_elements();
+      space->set_uniform_order(P_INIT);
+      space->assign_dofs();
+      dp.set_space(space);
+      dp_constant.set_space(space);
+    }
+
+    Space<double>::update_essential_bc_values(space, step * TAU);
+    wf.set_current_time(step * TAU);
+    wf_constant.set_current_time(step * TAU);
+    difference = std::max(difference, compare(&dp, &dp_constant, matrices, rhs, time));
+  }
+
+  std::cout << "Assembling: all forms integrated " << time[0] / (TIME_STEPS + 1) << " s, constant forms stored "
+    << time[1] / (TIME_STEPS + 1) << " s per step." << std::endl;
+  std::cout << "Maximum relative difference: " << difference << "." << std::endl;
+
+  if (difference < 1e-12)
+  {
+    std::cout << "Success!";
+    return 0;
+  }
+  else
+  {
+    std::cout << "Failure!";
+    return -1;
+  }
+}
@@ -0,0 +1,93 @@
+#include "hermes2d.h"
+#include "../test_utils.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::WeakFormsH1;
+
+// Local matrices of constant forms reused among congruent affine elements (DiscreteProblem::set_reuse_congruent_elements())
+// have to give the same matrices as the forms integrated on every element. A system of two equations on two meshes,
+// the second one a refinement of the first one, so that the elements of the first mesh are also integrated as
+// sub-elements; the first mesh is refined towards a vertex (hanging nodes) and anisotropically towards the boundary.
+// The reference integrals are off in both cases, measures the assembling time with and without the reuse for the
+// polynomial degrees 1 - 6.
+
+const int INIT_REF_NUM = 3;
+const int MAX_P = 6;
+
+static void create_weakform(WeakForm<double>& wf)
+{
+  Hermes::vector<MatrixFormVol<double>*> forms;
+  forms.push_back(new DefaultMatrixFormVol<double>(0, 0, HERMES_ANY, new Hermes2DFunction<double>(2.0)));
+  forms.push_back(new DefaultJacobianDiffusion<double>(0, 0, HERMES_ANY, new Hermes1DFunction<double>(1.5)));
+  forms.push_back(new DefaultJacobianAdvection<double>(0, 0, HERMES_ANY, new Hermes1DFunction<double>(0.3), new Hermes1DFunction<double>(-0.7)));
+  forms.push_back(new DefaultJacobianDiffusion<double>(1, 1, HERMES_ANY, new Hermes1DFunction<double>(0.5)));
+  forms.push_back(new DefaultMatrixFormVol<double>(0, 1, HERMES_ANY, new Hermes2DFunction<double>(-1.0)));
+  forms.push_back(new DefaultMatrixFormVol<double>(1, 0, HERMES_ANY, new Hermes2DFunction<double>(0.25)));
+  for (unsigned int i = 0; i < forms.size(); i++)
+  {
+    forms[i]->set_constant();
+    wf.add_matrix_form(forms[i]);
+  }
+  wf.add_vector_form(new DefaultVectorFormVol<double>(0, HERMES_ANY, new Hermes2DFunction<double>(1.0)));
+  wf.add_vector_form(new DefaultVectorFormVol<double>(1, HERMES_ANY, new Hermes2DFunction<double>(1.0)));
+}
+
+static double assemble(WeakForm<double>* wf, Hermes::vector<SpaceSharedPtr<double> > spaces, bool reuse, CSCMatrix<double>* matrix)
+{
+  Hermes::Mixins::TimeMeasurable cpu_time;
+  DiscreteProblem<double> dp(wf, spaces);
+  dp.set_reference_integrals(false);
+  dp.set_reuse_congruent_elements(reuse);
+  cpu_time.tick();
+  dp.assemble(matrix);
+  cpu_time.tick();
+  return cpu_time.last();
+}
+
+int main(int argc, char* argv[])
+{
+  MeshSharedPtr mesh(new Mesh), fine_mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("domain.mesh", mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh->refine_all_elements();
+  mesh->refine_towards_vertex(2, 2);
+  mesh->refine_towards_boundary("Bdy", 1, true);
+  fine_mesh->copy(mesh);
+  fine_mesh->refine_all_elements();
+
+  DefaultEssentialBCConst<double> bc_essential("Bdy", 0.0);
+  EssentialBCs<double> bcs(&bc_essential);
+
+  WeakForm<double> wf(2);
+  create_weakform(wf);
+
+  double difference = 0.;
+  for (int p = 1; p <= MAX_P; p++)
+  {
+    Hermes::vector<SpaceSharedPtr<double> > spaces;
+    spaces.push_back(SpaceSharedPtr<double>(new H1Space<double>(mesh, &bcs, p)));
+    spaces.push_back(SpaceSharedPtr<double>(new H1Space<double>(fine_mesh, &bcs, p)));
+
+    CSCMatrix<double> matrix, matrix_reused;
+    double time = assemble(&wf, spaces, false, &matrix);
+    double time_reused = assemble(&wf, spaces, true, &matrix_reused);
+    double p_difference = relative_difference(matrix, matrix_reused);
+    difference = std::max(difference, p_difference);
+
+    std::cout << "p = " << p << ", DOFs: " << Space<double>::get_num_dofs(spaces) << ", assembling: every element " << time
+      << " s, congruent elements reused " << time_reused << " s, relative difference " << p_difference << "." << std::endl;
+  }
+
+  if (difference < 1e-12)
+  {
+    std::cout << "Success!";
+    return 0;
+  }
+  else
+  {
+    std::cout << "Failure!";
+    return -1;
+  }
+}
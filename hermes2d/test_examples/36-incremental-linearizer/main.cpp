@@ -0,0 +1,196 @@
+#include "hermes2d.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+using namespace Hermes::Hermes2D::Views;
+
+// The linearized topology kept between frames on an unchanged mesh (Linearizer::set_keep_topology()): with a fixed
+// criterion, every frame has to give the same triangles as a full linearization of the same solution; with the
+// adaptive criterion (the refinement decided by the first frame), the values in the stored vertices have to be the
+// values of the current frame. The vertices with the same coordinates and values are merged (FileExport), the
+// exported mesh has to be the same for any number of threads.
+
+const int INIT_REF_NUM = 2;
+const int P_INIT = 3;
+const int FRAMES = 8;
+
+// A wave moving with the frame number.
+class WaveFunction : public ExactSolutionScalar<double>
+{
+public:
+  WaveFunction(MeshSharedPtr mesh, double phase) : ExactSolutionScalar<double>(mesh), phase(phase) {};
+
+  double value(double x, double y) const { return std::sin(2. * x + phase) * std::exp(y / 2.); }
+  void derivatives(double x, double y, double& dx, double& dy) const { dx = 2. * std::cos(2. * x + phase) * std::exp(y / 2.); dy = value(x, y) / 2.; }
+  Ord ord(double x, double y) const { return Ord(10); }
+  MeshFunction<double>* clone() const { return new WaveFunction(this->mesh, phase); }
+
+  double phase;
+};
+
+typedef std::vector<std::vector<double> > Triangles;
+
+// Order of the triangles by the coordinates of their vertices only, the values may differ in the last bits.
+static bool compare_coordinates(const std::vector<double>& a, const std::vector<double>& b)
+{
+  for (int i = 0; i < 3; i++)
+  {
+    for (int j = 0; j < 2; j++)
+    {
+      if (a[3 * i + j] != b[3 * i + j])
+        return a[3 * i + j] < b[3 * i + j];
+    }
+  }
+  return false;
+}
+
+// The triangles (coordinates and values of their vertices, the indices of the vertices refer to the vertices of all
+// threads), sorted so that the order of the threads does not matter.
+static Triangles get_triangles(Linearizer& lin)
+{
+  std::vector<ScalarLinearizerDataDimensions<LINEARIZER_DATA_TYPE>::vertex_t*> vertices;
+  for (Linearizer::Iterator<ScalarLinearizerDataDimensions<LINEARIZER_DATA_TYPE>::vertex_t> it = lin.vertices_begin(); !it.end; ++it)
+    vertices.push_back(&it.get());
+
+  Triangles result;
+  for (Linearizer::Iterator<triangle_indices_t> it = lin.triangle_indices_begin(); !it.end; ++it)
+  {
+    std::vector<double> triangle;
+    for (int i = 0; i < 3; i++)
+      for (int j = 0; j < 3; j++)
+        triangle.push_back((*vertices[it.get()[i]])[j]);
+    result.push_back(triangle);
+  }
+  std::sort(result.begin(), result.end(), compare_coordinates);
+  return result;
+}
+
+// Maximum difference of the triangles, 1 if their numbers differ.
+static double difference(const Triangles& a, const Triangles& b)
+{
+  if (a.size() != b.size())
+    return 1.;
+  double result = 0.;
+  for (unsigned int i = 0; i < a.size(); i++)
+    for (int j = 0; j < 9; j++)
+      result = std::max(result, std::abs(a[i][j] - b[i][j]));
+  return result;
+}
+
+// Maximum difference of the values in the vertices to the values of the solution in the same points.
+static double vertex_difference(Linearizer& lin, MeshFunctionSharedPtr<double> sln)
+{
+  std::vector<double> x, y, values;
+  for (Linearizer::Iterator<ScalarLinearizerDataDimensions<LINEARIZER_DATA_TYPE>::vertex_t> it = lin.vertices_begin(); !it.end; ++it)
+  {
+    x.push_back(it.get()[0]);
+    y.push_back(it.get()[1]);
+    values.push_back(it.get()[2]);
+  }
+  std::vector<double> sln_values(values.size());
+  if (sln->get_pt_values(values.size(), &x[0], &y[0], &sln_values[0]) > 0)
+    return 1.;
+
+  double result = 0.;
+  for (unsigned int i = 0; i < values.size(); i++)
+    result = std::max(result, std::abs(values[i] - sln_values[i]));
+  return result;
+}
+
+// Linearizes all frames by a linearizer keeping the topology and by a new one for every frame, returns the maximum
+// difference of the triangles (of the first frame only with the adaptive criterion, whose kept refinement belongs
+// to the first frame), the values of the adaptive one are checked in the vertices.
+static double compare_frames(MeshFunctionSharedPtr<double>* frames, LinearizerCriterion criterion, int num_threads)
+{
+  Hermes::Mixins::TimeMeasurable cpu_time;
+  double time[2] = { 0., 0. };
+  double result = 0.;
+
+  int default_num_threads = HermesCommonApi.get_integral_param_value(numThreads);
+  HermesCommonApi.set_integral_param_value(numThreads, num_threads);
+  Linearizer kept(FileExport);
+  kept.set_criterion(criterion);
+  kept.set_keep_topology();
+  for (int frame = 0; frame < FRAMES; frame++)
+  {
+    Linearizer full(FileExport);
+    full.set_criterion(criterion);
+
+    cpu_time.tick();
+    kept.process_solution(frames[frame]);
+    cpu_time.tick();
+    time[0] += cpu_time.last();
+    full.process_solution(frames[frame]);
+    cpu_time.tick();
+    time[1] += cpu_time.last();
+
+    if (!criterion.adaptive || frame == 0)
+      result = std::max(result, difference(get_triangles(kept), get_triangles(full)));
+    if (criterion.adaptive)
+      result = std::max(result, vertex_difference(kept, frames[frame]));
+  }
+
+  HermesCommonApi.set_integral_param_value(numThreads, default_num_threads);
+
+  std::cout << (criterion.adaptive ? "Adaptive" : "Fixed") << " criterion, " << num_threads << " thread(s), " << kept.get_triangle_count() << " triangles: topology kept "
+    << time[0] / FRAMES << " s, full linearization " << time[1] / FRAMES << " s per frame, difference " << result << "." << std::endl;
+  return result;
+}
+
+// Linearizes the frame with one and with four threads, returns the maximum difference of the triangles, 1 if the
+// numbers of the vertices differ. With the fixed criterion, the adaptive refinement decisions depend on the maximum
+// value in the states of the thread.
+static double compare_threads(MeshFunctionSharedPtr<double> frame)
+{
+  int num_threads = HermesCommonApi.get_integral_param_value(numThreads);
+  HermesCommonApi.set_integral_param_value(numThreads, 1);
+  Linearizer serial(FileExport);
+  HermesCommonApi.set_integral_param_value(numThreads, 4);
+  Linearizer parallel(FileExport);
+  HermesCommonApi.set_integral_param_value(numThreads, num_threads);
+
+  serial.set_criterion(LinearizerCriterionFixed(2));
+  parallel.set_criterion(LinearizerCriterionFixed(2));
+  serial.process_solution(frame);
+  parallel.process_solution(frame);
+
+  std::cout << "Vertices: one thread " << serial.get_vertex_count() << ", four threads " << parallel.get_vertex_count() << "." << std::endl;
+  if (serial.get_vertex_count() != parallel.get_vertex_count())
+    return 1.;
+  return difference(get_triangles(serial), get_triangles(parallel));
+}
+
+int main(int argc, char* argv[])
+{
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("domain.mesh", mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh->refine_all_elements();
+  mesh->refine_towards_vertex(3, 2);
+
+  SpaceSharedPtr<double> space(new H1Space<double>(mesh, P_INIT));
+  MeshFunctionSharedPtr<double> frames[FRAMES];
+  for (int frame = 0; frame < FRAMES; frame++)
+  {
+    MeshFunctionSharedPtr<double> exact(new WaveFunction(mesh, 0.4 * frame));
+    frames[frame] = new Solution<double>();
+    OGProjection<double>::project_global(space, exact, frames[frame]);
+  }
+
+  double fixed_difference = compare_frames(frames, LinearizerCriterionFixed(2), 1);
+  fixed_difference = std::max(fixed_difference, compare_frames(frames, LinearizerCriterionFixed(2), 4));
+  double adaptive_difference = compare_frames(frames, LinearizerCriterionAdaptive(1e-3), 1);
+  double threads_difference = compare_threads(frames[0]);
+
+  if (fixed_difference < 1e-12 && adaptive_difference < 1e-12 && threads_difference < 1e-12)
+  {
+    std::cout << "Success!";
+    return 0;
+  }
+  else
+  {
+    std::cout << "Failure!";
+    return -1;
+  }
+}
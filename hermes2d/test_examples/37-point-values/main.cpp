@@ -0,0 +1,126 @@
+#include "hermes2d.h"
+#include "../test_utils.h"
+
+using namespace Hermes;
+using namespace Hermes::Hermes2D;
+
+// Batched point evaluation (MeshFunction::get_pt_values()) of a solution, a SimpleFilter and a DXDYFilter on a mesh of
+// curved quadrilaterals, compared to get_pt_value() point by point: random points, many of them outside of the domain,
+// and points on the edges of the elements (the boundaries and the edges along the diagonal). The values and
+// derivatives have to be the same, the points outside have to give zeros and be counted.
+
+const int INIT_REF_NUM = 2;
+const int P_INIT = 4;
+const int NUM_RANDOM_POINTS = 100;
+const int NUM_EDGE_POINTS = 20;
+
+// Product of two functions with its derivatives.
+class ProductFilter : public DXDYFilter<double>
+{
+public:
+  ProductFilter(Hermes::vector<MeshFunctionSharedPtr<double> > solutions) : DXDYFilter<double>(solutions) {};
+
+  MeshFunction<double>* clone() const
+  {
+    Hermes::vector<MeshFunctionSharedPtr<double> > slns;
+    for (int i = 0; i < this->num; i++)
+      slns.push_back(this->sln[i]->clone());
+    return new ProductFilter(slns);
+  }
+
+protected:
+  void filter_fn(int n, double* x, double* y, const Hermes::vector<const double *>& values, const Hermes::vector<const double *>& dx, const Hermes::vector<const double *>& dy, double* rslt, double* rslt_dx, double* rslt_dy)
+  {
+    for (int i = 0; i < n; i++)
+    {
+      rslt[i] = values[0][i] * values[1][i];
+      rslt_dx[i] = dx[0][i] * values[1][i] + values[0][i] * dx[1][i];
+      rslt_dy[i] = dy[0][i] * values[1][i] + values[0][i] * dy[1][i];
+    }
+  }
+};
+
+// Compares get_pt_values() to get_pt_value() in all points, returns the maximum difference, 1 if a point is located
+// differently by the two.
+static double compare(MeshFunctionSharedPtr<double> function, const std::vector<double>& x, const std::vector<double>& y, bool derivatives, const char* name)
+{
+  int count = x.size();
+  std::vector<double> values(count), dx(count), dy(count);
+  int points_outside = function->get_pt_values(count, &x[0], &y[0], &values[0], derivatives ? &dx[0] : nullptr, derivatives ? &dy[0] : nullptr);
+
+  double result = 0.;
+  int missing = 0;
+  for (int i = 0; i < count; i++)
+  {
+    Func<double>* value = function->get_pt_value(x[i], y[i], true);
+    if (value == nullptr)
+    {
+      missing++;
+      result = std::max(result, std::abs(values[i]));
+      if (derivatives)
+        result = std::max(result, std::max(std::abs(dx[i]), std::abs(dy[i])));
+      continue;
+    }
+
+    result = std::max(result, std::abs(values[i] - value->val[0]));
+    if (derivatives)
+      result = std::max(result, std::max(std::abs(dx[i] - value->dx[0]), std::abs(dy[i] - value->dy[0])));
+    delete value;
+  }
+
+  std::cout << name << ": " << count - missing << " points inside, " << missing << " outside (" << points_outside << " reported), difference " << result << "." << std::endl;
+  if (missing != points_outside || missing == 0 || missing == count)
+    return 1.;
+  return result;
+}
+
+int main(int argc, char* argv[])
+{
+  MeshSharedPtr mesh(new Mesh);
+  MeshReaderH2D mloader;
+  mloader.load("domain.mesh", mesh);
+  for (int i = 0; i < INIT_REF_NUM; i++)
+    mesh->refine_all_elements();
+
+  SpaceSharedPtr<double> space(new H1Space<double>(mesh, P_INIT));
+  MeshFunctionSharedPtr<double> u = random_solution(space, 1), v = random_solution(space, 2);
+  // Only the warnings of the point location for the points outside.
+  u->set_verbose_output(false);
+  v->set_verbose_output(false);
+  MeshFunctionSharedPtr<double> magnitude(new MagFilter<double>(Hermes::vector<MeshFunctionSharedPtr<double> >(u, v)));
+  MeshFunctionSharedPtr<double> product(new ProductFilter(Hermes::vector<MeshFunctionSharedPtr<double> >(u, v)));
+
+  // The domain is a quarter of the annulus with radii 1 and 2, the points fill its bounding box and more.
+  std::vector<double> x, y;
+  srand(3);
+  for (int i = 0; i < NUM_RANDOM_POINTS; i++)
+  {
+    x.push_back(2.5 * rand() / RAND_MAX - 0.25);
+    y.push_back(2.5 * rand() / RAND_MAX - 0.25);
+  }
+  for (int i = 0; i <= NUM_EDGE_POINTS; i++)
+  {
+    double r = 1. + (double)i / NUM_EDGE_POINTS;
+    x.push_back(r);
+    y.push_back(0.);
+    x.push_back(0.);
+    y.push_back(r);
+    x.push_back(r * std::sqrt(0.5));
+    y.push_back(r * std::sqrt(0.5));
+  }
+
+  double difference = compare(u, x, y, true, "Solution");
+  difference = std::max(difference, compare(magnitude, x, y, false, "SimpleFilter"));
+  difference = std::max(difference, compare(product, x, y, true, "DXDYFilter"));
+
+  if (difference < 1e-12)
+  {
+    std::cout << "Success!";
+    return 0;
+  }
+  else
+  {
+    std::cout << "Failure!";
+    return -1;
+  }
+}
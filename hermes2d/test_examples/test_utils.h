@@ -0,0 +1,54 @@
+#ifndef __H2D_TEST_UTILS_H
+#define __H2D_TEST_UTILS_H
+
+#include "hermes2d.h"
+
+// Helpers shared by the test examples (#include "../test_utils.h").
+
+// Coefficients uniformly distributed in (-1, 1), the same for the same seed. The caller deletes the array.
+inline double* random_coefficients(int ndof, int seed)
+{
+  double* coeff_vec = new double[ndof];
+  srand(seed);
+  for (int i = 0; i < ndof; i++)
+    coeff_vec[i] = 2. * rand() / RAND_MAX - 1.;
+  return coeff_vec;
+}
+
+// Solution in the space with random coefficients (see random_coefficients()).
+inline Hermes::Hermes2D::MeshFunctionSharedPtr<double> random_solution(Hermes::Hermes2D::SpaceSharedPtr<double> space, int seed)
+{
+  double* coeff_vec = random_coefficients(space->get_num_dofs(), seed);
+  Hermes::Hermes2D::MeshFunctionSharedPtr<double> sln(new Hermes::Hermes2D::Solution<double>);
+  Hermes::Hermes2D::Solution<double>::vector_to_solution(coeff_vec, space, sln);
+  delete[] coeff_vec;
+  return sln;
+}
+
+// Maximum difference of the arrays relative to the maximum magnitude in the first one.
+inline double relative_difference(const double* a, const double* b, int count)
+{
+  double max_value = 0., result = 0.;
+  for (int i = 0; i < count; i++)
+  {
+    max_value = std::max(max_value, std::abs(a[i]));
+    result = std::max(result, std::abs(a[i] - b[i]));
+  }
+  return result / max_value;
+}
+
+// Relative difference of the entries of two matrices, 1 if their structures differ in the number of nonzeros.
+inline double relative_difference(Hermes::Algebra::CSCMatrix<double>& m1, Hermes::Algebra::CSCMatrix<double>& m2)
+{
+  if (m1.get_nnz() != m2.get_nnz())
+    return 1.;
+  return relative_difference(m1.get_Ax(), m2.get_Ax(), m1.get_nnz());
+}
+
+// The matrices are the same up to the tolerance relative to their largest entry.
+inline bool same_matrices(Hermes::Algebra::CSCMatrix<double>& m1, Hermes::Algebra::CSCMatrix<double>& m2, double tolerance)
+{
+  return relative_difference(m1, m2) <= tolerance;
+}
+
+#endif
@@ -37,6 +37,8 @@ namespace Hermes
     SOLVER_AMESOS = 6,
     SOLVER_AZTECOO = 7,
     SOLVER_EXTERNAL = 8,
+    /// Iterative refinement with single precision correction solves (MixedPrecisionLinearMatrixSolver).
+    SOLVER_MIXED_PRECISION = 9,
     SOLVER_EMPTY = 100
   };
 
@@ -0,0 +1,116 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file bsr_matrix.h
+\brief Block compressed sparse row (BSR) matrix class.
+*/
+#ifndef __HERMES_COMMON_BSR_MATRIX_H
+#define __HERMES_COMMON_BSR_MATRIX_H
+
+#include "algebra/cs_matrix.h"
+
+namespace Hermes
+{
+  namespace Algebra
+  {
+    /// \brief Block compressed sparse row matrix.
+    /// The matrix is divided into dense square blocks of size block_size x block_size, the sparsity pattern
+    /// (and the search for an entry) is stored per block. Suitable for systems of several equations
+    /// with the DOFs numbered by nodes (see Hermes2D::Space::assign_dofs_interleaved()), where the
+    /// components of one node couple with all the components of the neighboring nodes.
+    /// If the size is not divisible by block_size, the last block row / column is padded.
+    /// Solvers using the CSC format get the matrix through convert_to_csc().
+    template <typename Scalar>
+    class HERMES_API BSRMatrix : public SparseMatrix<Scalar>
+    {
+    public:
+      /// Constructor.
+      /// @param[in] block_size size of the dense blocks (number of components per node).
+      BSRMatrix(unsigned int block_size = 1);
+      virtual ~BSRMatrix();
+
+      /// Size of the dense blocks.
+      unsigned int get_block_size() const;
+      /// Number of the stored blocks.
+      unsigned int get_num_blocks() const;
+
+      /// The pages are stored per block row.
+      virtual void prealloc(unsigned int n);
+      /// Registers the block containing the entry (row, col).
+      virtual void pre_add_ij(unsigned int row, unsigned int col);
+
+      virtual void alloc();
+      virtual void free();
+      virtual Scalar get(unsigned int m, unsigned int n) const;
+      virtual void zero();
+      virtual void set_row_zero(unsigned int n);
+
+      virtual void add(unsigned int m, unsigned int n, Scalar v);
+      /// Adds a local matrix, the block of consecutive entries in one row is only searched for once.
+      virtual void add(unsigned int m, unsigned int n, Scalar *mat, int *rows, int *cols, const int size);
+
+      /// Product using dense block kernels, parallel over the block rows.
+      virtual void multiply_with_vector(Scalar* vector_in, Scalar*& vector_out, bool vector_out_initialized = false) const;
+      virtual void multiply_with_Scalar(Scalar value);
+
+      /// Number of the stored entries (including zeros inside of the blocks, excluding the padding).
+      virtual unsigned int get_nnz() const;
+      virtual double get_fill_in() const;
+
+      /// Exports the matrix converted to the CSC format.
+      virtual void export_to_file(const char *filename, const char *var_name, MatrixExportFormat fmt, char* number_format = "%lf");
+
+      /// Duplicates a matrix (including allocation).
+      virtual SparseMatrix<Scalar>* duplicate() const;
+
+      /// Fills the CSC matrix with the values of this matrix.
+      /// The target is (re)created if its size or number of nonzeros differ, otherwise only its arrays are overwritten,
+      /// the mapping of the entries is calculated once per alloc().
+      void convert_to_csc(CSCMatrix<Scalar>* target);
+
+    protected:
+      /// Index of the block (block_row, block_col) in Bj, -1 if not present.
+      int find_block(unsigned int block_row, unsigned int block_col) const;
+
+      /// Calculates csc_Ap, csc_Ai, csc_map.
+      void init_csc_map();
+
+      /// Size of the dense blocks.
+      unsigned int block_size;
+      /// Number of block rows (= block columns).
+      unsigned int num_block_rows;
+      /// Number of blocks.
+      unsigned int nnzb;
+      /// Number of stored entries within the matrix size.
+      unsigned int nnz;
+
+      /// Index to Bj, where each block row starts.
+      int *Bp;
+      /// Block column indices.
+      int *Bj;
+      /// Blocks (row-major), block k starts at Bx + k * block_size * block_size.
+      Scalar *Bx;
+
+      /// CSC structure and the indices of the CSC entries in Bx.
+      int *csc_Ap;
+      int *csc_Ai;
+      int *csc_map;
+    };
+  }
+}
+#endif
@@ -152,6 +152,10 @@ namespace Hermes
 
       /// Duplicates a matrix (including allocation).
       virtual CSMatrix<Scalar>* duplicate() const;
+
+      /// Fills an empty matrix of any type (typically from create_matrix(), for the configured solver) with the structure
+      /// and the values of this one.
+      void copy_to(SparseMatrix<Scalar>* target) const;
     };
 
     /// \brief General CSR Matrix class.
@@ -175,6 +179,9 @@ namespace Hermes
 
       virtual void add(unsigned int m, unsigned int n, Scalar v);
 
+      /// Parallel over the rows.
+      void multiply_with_vector(Scalar* vector_in, Scalar*& vector_out, bool vector_out_initialized) const;
+
       void export_to_file(const char *filename, const char *var_name, MatrixExportFormat fmt, char* number_format = "%lf");
       void import_from_file(const char *filename, const char *var_name, MatrixExportFormat fmt);
 
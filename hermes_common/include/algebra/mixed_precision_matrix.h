@@ -0,0 +1,113 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file mixed_precision_matrix.h
+\brief CSR matrix with the entries stored in single precision.
+*/
+#ifndef __HERMES_COMMON_MIXED_PRECISION_MATRIX_H
+#define __HERMES_COMMON_MIXED_PRECISION_MATRIX_H
+
+#include "algebra/cs_matrix.h"
+
+namespace Hermes
+{
+  namespace Algebra
+  {
+    /// Single precision counterpart of a Scalar type.
+    template<typename Scalar>
+    struct SinglePrecision
+    {
+    };
+
+    template<>
+    struct SinglePrecision<double>
+    {
+      typedef float type;
+    };
+
+    template<>
+    struct SinglePrecision<std::complex<double> >
+    {
+      typedef std::complex<float> type;
+    };
+
+    /// \brief Compressed sparse row matrix storing the entries in single precision.
+    /// The matrix is assembled and used through the usual (double precision) interface, only the stored values
+    /// are rounded, which halves the memory of the values and the memory traffic of the products.
+    /// multiply_with_vector() accumulates in double precision. MixedPrecisionLinearMatrixSolver keeps the rounded
+    /// copy of the system matrix (create_from()) for the single precision correction solves.
+    template <typename Scalar>
+    class HERMES_API MixedPrecisionCSRMatrix : public SparseMatrix<Scalar>
+    {
+    public:
+      typedef typename SinglePrecision<Scalar>::type LowScalar;
+
+      MixedPrecisionCSRMatrix();
+      virtual ~MixedPrecisionCSRMatrix();
+
+      /// The pages are stored per row.
+      virtual void pre_add_ij(unsigned int row, unsigned int col);
+
+      virtual void alloc();
+      virtual void free();
+      virtual Scalar get(unsigned int m, unsigned int n) const;
+      virtual void zero();
+      virtual void set_row_zero(unsigned int n);
+      virtual void add(unsigned int m, unsigned int n, Scalar v);
+
+      /// Product accumulated in double precision, parallel over the rows.
+      virtual void multiply_with_vector(Scalar* vector_in, Scalar*& vector_out, bool vector_out_initialized = false) const;
+      /// Product in single precision.
+      void multiply_with_vector(const LowScalar* vector_in, LowScalar* vector_out) const;
+      virtual void multiply_with_Scalar(Scalar value);
+
+      virtual unsigned int get_nnz() const;
+      virtual double get_fill_in() const;
+      /// Memory of the stored matrix in bytes.
+      unsigned long get_memory_size() const;
+
+      /// Exports the matrix converted to the CSC format.
+      virtual void export_to_file(const char *filename, const char *var_name, MatrixExportFormat fmt, char* number_format = "%lf");
+
+      /// Duplicates a matrix (including allocation).
+      virtual SparseMatrix<Scalar>* duplicate() const;
+
+      /// Replaces the contents by the entries of a CSC matrix, rounded to single precision.
+      void create_from(const CSCMatrix<Scalar>* matrix);
+
+      /// Exposes pointers to the CSR arrays.
+      int *get_Ap() const;
+      int *get_Ai() const;
+      LowScalar *get_Ax() const;
+
+    protected:
+      /// Index of the entry (m, n) in Ax, -1 if not present.
+      int find_entry(unsigned int m, unsigned int n) const;
+
+      /// Index to Ai / Ax, where each row starts.
+      int *Ap;
+      /// Column indices (sorted in each row).
+      int *Ai;
+      /// Entries.
+      LowScalar *Ax;
+      /// Number of entries.
+      unsigned int nnz;
+    };
+  }
+}
+#endif
@@ -32,12 +32,18 @@ namespace Hermes
   /// Enumeration of potential keys in the Api::parameters storage.
   enum HermesCommonApiParam
   {
+    /// Number of the OpenMP threads of the parallel loops.
+    /// The big arrays (matrices, vectors, solution coefficients) are first touched by the threads working on them, so on
+    /// multi-socket (NUMA) machines their pages are placed in the memory of these threads. This only pays off if the
+    /// threads stay where they are (e.g. OMP_PROC_BIND=close or spread, OMP_PLACES=cores) and numThreads does not change
+    /// between the allocation and the use of the arrays; it should not exceed the number of physical cores.
     numThreads,
     matrixSolverType,
     directMatrixSolverType,
     showInternalWarnings,
     checkMeshesOnLoad,
-    useAccelerators
+    useAccelerators,
+    matrixBlockSize
   };
 
   /// API Class containing settings for the whole HermesCommon.
@@ -84,12 +84,15 @@ namespace Hermes
     {
       free();
 
-      this->pages = realloc_with_check<Array, TYPE*>(this->pages, array.page_count, this);
+      // Only the pages actually holding items are copied (the source may have reserved more).
+      int used_page_count = (array.size + HERMES_PAGE_MASK) >> HERMES_PAGE_BITS;
+
+      this->pages = realloc_with_check<Array, TYPE*>(this->pages, used_page_count, this);
       this->unused = realloc_with_check<Array, int>(this->unused, array.unused_size, this);
 
       memcpy(this->unused, array.unused, array.unused_size * sizeof(int));
 
-      this->page_count = array.page_count;
+      this->page_count = used_page_count;
       this->size = array.size;
       this->nitems = array.nitems;
       this->unused_size = array.unused_size;
@@ -112,6 +115,20 @@ namespace Hermes
       size = nitems = nunused = page_count = unused_size = 0;
     }
 
+    /// Pre-allocates the pages so that items with ids up to (size - 1) can be appended
+    /// without any reallocation.
+    void reserve(int size)
+    {
+      int needed_page_count = (size + HERMES_PAGE_MASK) >> HERMES_PAGE_BITS;
+      if (needed_page_count <= this->page_count)
+        return;
+
+      this->pages = realloc_with_check<Array, TYPE*>(this->pages, needed_page_count, this);
+      for (int new_i = this->page_count; new_i < needed_page_count; new_i++)
+        pages[new_i] = malloc_with_check<Array, TYPE>(HERMES_PAGE_SIZE, this);
+      this->page_count = needed_page_count;
+    }
+
     /// Sets or resets the append-only mode. In append-only mode new
     /// elements are only added to the end of the array.
     /// This can be useful eg. when refining all elements of a mesh
@@ -139,7 +156,8 @@ namespace Hermes
       TYPE* item;
       if (!nunused || append_only)
       {
-        if (!(size & HERMES_PAGE_MASK))
+        // The page may already exist (reserve(), skip_slot()).
+        if ((size >> HERMES_PAGE_BITS) >= this->page_count)
         {
           this->pages = realloc_with_check <Array<TYPE>, TYPE*>(this->pages, this->page_count + 1, this);
           TYPE* new_page = malloc_with_check<Array<TYPE>, TYPE>(HERMES_PAGE_SIZE, this);
@@ -259,7 +277,7 @@ namespace Hermes
     /// This is a special-purpose function used to create empty element slots.
     TYPE* skip_slot()
     {
-      if (!(size & HERMES_PAGE_MASK))
+      if ((size >> HERMES_PAGE_BITS) >= this->page_count)
       {
         int local_page_count = this->page_count;
         this->page_count = std::max<int>(this->page_count + 1, (int)(this->page_count * 1.5));
@@ -23,8 +23,11 @@
 #include "exceptions.h"
 #include "algebra/vector.h"
 #include "algebra/cs_matrix.h"
+#include "algebra/bsr_matrix.h"
+#include "algebra/mixed_precision_matrix.h"
 #include "algebra/dense_matrix_operations.h"
 #include "solvers/linear_matrix_solver.h"
+#include "solvers/mixed_precision_solver.h"
 #include "solvers/nonlinear_matrix_solver.h"
 #include "solvers/picard_matrix_solver.h"
 #include "solvers/newton_matrix_solver.h"
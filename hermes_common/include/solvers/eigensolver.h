@@ -17,76 +17,111 @@
 // along with Hermes2D; if not, write to the Free Software
 // Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
 /*! \file eigensolver.h
-    \brief class for solving Eigenproblems. Currently using Python.
+\brief Sparse generalized eigensolver (shift-invert Lanczos / restarted Arnoldi).
 */
 #ifndef __HERMES_EIGENSOLVER_H
 #define __HERMES_EIGENSOLVER_H
 
-#include "config.h"
-#ifdef WITH_PYTHON
-
-#include "matrix.h"
-
-#include "python_API/python_api.h"
-
-// RCP
-#ifndef WITH_TRILINOS
-#include "Teuchos_RCP.hpp"
-#else
-#include "Teuchos_RCP.hpp"
-#endif
+#include "solvers/linear_matrix_solver.h"
+#include "algebra/cs_matrix.h"
 
 namespace Hermes
 {
-
-using Teuchos::RCP;
-using Teuchos::Ptr;
-using Teuchos::rcp;
-using Teuchos::null;
-
-
-template <typename Scalar>
-class HERMES_API EigenSolver
-{
-public:
-    EigenSolver(const RCP<Algebra::Matrix<Scalar> > &A, const RCP<Algebra::Matrix<Scalar> > &B);
-
-
-    // Solves for 'n_eigs' eigenvectors, around the 'target_value'. Use
-    // 'get_eigenvalue' and 'get_eigenvector' to retrieve the
-    // eigenvalues/eigenvectors:
-    void solve(int n_eigs = 4, double target_value = -1, double tol = 1e-6,
-            int max_iter = 150);
-
-    // Returns the number of calculated eigenvalues
-    int get_n_eigs()
+  namespace Solvers
+  {
+    /// \brief Solver of the generalized eigenproblem A x = lambda B x with sparse matrices.
+    /// The eigenvalues nearest to a target sigma are found using the shift-invert transformation:
+    /// the eigenvalues theta of OP = (A - sigma B)^-1 B with the largest magnitude give lambda = sigma + 1 / theta.
+    /// The matrix A - sigma B is factorized once by UMFPACK (by the default direct solver if Hermes is built without it).
+    /// - symmetric problems (A symmetric / hermitian, B symmetric positive definite, see set_symmetric()): Lanczos in the B-inner product,
+    /// the eigenvalues are real and the eigenvectors B-orthonormal,
+    /// - non-symmetric problems: Arnoldi, the eigenvalues may be complex, the eigenvectors are normalized in the Euclidean norm.
+    /// Both keep the wanted Ritz vectors when the Krylov subspace is full (thick / Krylov-Schur type implicit restart),
+    /// with full reorthogonalization. The orthogonalization and the products with B are parallelized by OpenMP.
+    /// The matrices may be CSCMatrix or CSRMatrix.
+    ///
+    /// @ingroup Solvers
+    template <typename Scalar>
+    class HERMES_API EigenSolver : public Hermes::Mixins::Loggable, public Hermes::Mixins::TimeMeasurable
     {
-        return this->n_eigs;
-    }
-    // Returns the i-th eigenvalue
-    double get_eigenvalue(int i);
-    // Returns the i-th eigenvector. A pointer will be returned into an
-    // internal array, as well as the size of the vector. You don't own the
-    // memory and it will be deallocated once the EigenSolver() class is
-    // deleted. You need to make a copy of it if you want to store it
-    // permanently.
-    void get_eigenvector(int i, double **vec, int *n);
-
-    void print_eigenvalues()
-    {
-        printf("Eigenvalues:\n");
-        for (int i = 0; i < this->get_n_eigs(); i++)
-            printf("%3d: %f\n", i, this->get_eigenvalue(i));
-    }
-
-private:
-    RCP<Algebra::Matrix<Scalar> > A, B;
-    int n_eigs;
-    Python p;
-};
-
+    public:
+      /// \param[in] B nullptr stands for the identity (standard eigenproblem).
+      EigenSolver(CSMatrix<Scalar>* A, CSMatrix<Scalar>* B = nullptr);
+      virtual ~EigenSolver();
+
+      /// The problem is symmetric (Lanczos), default false (Arnoldi).
+      void set_symmetric(bool to_set = true);
+      /// Dimension of the Krylov subspace, default max(2 * n_eigs + 1, 20).
+      void set_krylov_dimension(int krylov_dimension);
+
+      /// Solves for 'n_eigs' eigenpairs nearest to 'target_value' (sorted by the distance).
+      /// \param[in] tol Relative residual of the eigenpairs of the shift-inverted operator.
+      /// \param[in] max_iter Maximum number of restarts.
+      /// Use 'get_eigenvalue' and 'get_eigenvector' to retrieve the eigenvalues / eigenvectors.
+      void solve(int n_eigs = 4, double target_value = -1, double tol = 1e-6, int max_iter = 150);
+
+      /// Returns the number of calculated eigenvalues (the converged ones, may be lower than 'n_eigs').
+      int get_n_eigs() const;
+      /// Returns the number of restarts used.
+      int get_num_iters() const;
+
+      /// Returns the i-th eigenvalue (the real part for non-symmetric problems).
+      double get_eigenvalue(int i) const;
+      /// Returns the i-th eigenvalue.
+      std::complex<double> get_complex_eigenvalue(int i) const;
+
+      /// Returns the i-th eigenvector. A pointer will be returned into an
+      /// internal array, as well as the size of the vector. You don't own the
+      /// memory and it will be deallocated once the EigenSolver() class is
+      /// deleted. You need to make a copy of it if you want to store it
+      /// permanently.
+      /// For real matrices, these are the real parts, i.e. complex eigenvectors are only available through get_complex_eigenvector().
+      void get_eigenvector(int i, Scalar **vec, int *n);
+      /// Returns the i-th eigenvector, the same memory rules as in get_eigenvector() apply.
+      void get_complex_eigenvector(int i, std::complex<double> **vec, int *n);
+
+      void print_eigenvalues() const;
+
+    protected:
+      /// Factorizes A - sigma B.
+      void factorize(double target_value);
+      /// y = B x (parallel), y = x for B == nullptr.
+      void multiply_B(const std::complex<double>* x, std::complex<double>* y) const;
+      /// x = (A - sigma B)^-1 x.
+      void solve_shifted(std::complex<double>* x);
+      /// Orthogonalizes w against the first 'count' basis vectors (twice), stores the coefficients.
+      /// Returns the norm of w in the inner product of the problem, Bw is filled for symmetric problems.
+      double orthogonalize(std::complex<double>* w, std::complex<double>* Bw, int count, std::complex<double>* coefficients);
+      /// Releases the results and the work storage.
+      void free();
+
+      CSMatrix<Scalar>* A;
+      CSMatrix<Scalar>* B;
+      unsigned int size;
+      bool symmetric;
+      int krylov_dimension;
+
+      /// B in the CSR format (for the parallel products).
+      int* B_Ap;
+      int* B_Ai;
+      Scalar* B_Ax;
+
+      /// A - sigma B (of the type of the direct solver) and its solver.
+      SparseMatrix<Scalar>* shifted_matrix;
+      SimpleVector<Scalar>* shifted_rhs;
+      LinearMatrixSolver<Scalar>* shifted_solver;
+
+      /// Krylov basis (vectors of length size one after another) and for symmetric problems the products with B.
+      std::complex<double>* V;
+      std::complex<double>* BV;
+
+      /// Results.
+      int n_eigs;
+      int num_iters;
+      std::complex<double>* eigenvalues;
+      std::complex<double>* eigenvectors;
+      Scalar* eigenvectors_scalar;
+    };
+  }
 }
-
-#endif
-
 #endif
@@ -25,6 +25,7 @@
 #ifdef WITH_UMFPACK
 #include "solvers/linear_matrix_solver.h"
 #include "algebra/cs_matrix.h"
+#include "algebra/bsr_matrix.h"
 
 extern "C"
 {
@@ -53,6 +54,11 @@ namespace Hermes
       /// @param[in] m pointer to matrix
       /// @param[in] rhs pointer to right hand side vector
       UMFPackLinearMatrixSolver(CSCMatrix<Scalar> *m, SimpleVector<Scalar> *rhs);
+      /// Constructor of UMFPack solver for a block matrix.
+      /// The matrix is converted to the CSC format (owned by the solver) before every factorization.
+      /// @param[in] m pointer to matrix
+      /// @param[in] rhs pointer to right hand side vector
+      UMFPackLinearMatrixSolver(BSRMatrix<Scalar> *m, SimpleVector<Scalar> *rhs);
       virtual ~UMFPackLinearMatrixSolver();
       virtual void solve();
       virtual void free();
@@ -60,6 +66,8 @@ namespace Hermes
 
       /// Matrix to solve.
       CSCMatrix<Scalar> *m;
+      /// Block matrix to solve (converted into m), nullptr if m is the matrix to solve.
+      BSRMatrix<Scalar> *bsr_m;
       /// Right hand side vector.
       SimpleVector<Scalar> *rhs;
 
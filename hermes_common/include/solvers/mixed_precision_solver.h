@@ -0,0 +1,105 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file mixed_precision_solver.h
+\brief Mixed precision solver (iterative refinement) for single precision matrices.
+*/
+#ifndef __HERMES_COMMON_MIXED_PRECISION_SOLVER_H_
+#define __HERMES_COMMON_MIXED_PRECISION_SOLVER_H_
+
+#include "solvers/linear_matrix_solver.h"
+#include "algebra/mixed_precision_matrix.h"
+
+namespace Hermes
+{
+  namespace Solvers
+  {
+    /// \brief Mixed precision iterative refinement solver (Hermes::SOLVER_MIXED_PRECISION).
+    /// The solution and the residuals r = b - Ax are computed in double precision with the original CSC matrix,
+    /// the corrections A d = r are solved in single precision by BiCGStab with a rounded copy of the matrix
+    /// (MixedPrecisionCSRMatrix), preconditioned by ILU(0), whose factors are stored in single precision too.
+    /// The refinement stops when the residual (relative to the right hand side by default) meets the tolerance,
+    /// which may be set to double precision levels.
+    ///
+    /// The single precision copy and the ILU(0) factorization are reused with HERMES_REUSE_MATRIX_STRUCTURE_COMPLETELY.
+    ///
+    /// @ingroup Solvers
+    template <typename Scalar>
+    class HERMES_API MixedPrecisionLinearMatrixSolver : public LoopSolver<Scalar>
+    {
+    public:
+      typedef typename SinglePrecision<Scalar>::type LowScalar;
+
+      MixedPrecisionLinearMatrixSolver(CSCMatrix<Scalar> *m, SimpleVector<Scalar> *rhs);
+      virtual ~MixedPrecisionLinearMatrixSolver();
+
+      virtual void solve();
+      virtual void solve(Scalar* initial_guess);
+
+      virtual int get_matrix_size();
+
+      /// Number of the refinement steps.
+      virtual int get_num_iters();
+      /// Number of the single precision BiCGStab iterations in all refinement steps.
+      int get_num_inner_iters();
+      virtual double get_residual_norm();
+
+      /// Relative tolerance of the single precision solves (default 1e-4),
+      /// each refinement step reduces the residual roughly by this factor.
+      void set_inner_tolerance(double inner_tolerance);
+      /// Maximum number of BiCGStab iterations per refinement step (default 1000).
+      void set_max_inner_iters(int max_inner_iters);
+
+      /// Memory of the single precision copy of the matrix and of the ILU(0) factors in bytes.
+      unsigned long get_factorization_memory_size() const;
+
+    protected:
+      /// Rounds the matrix to single precision and computes the ILU(0) factors.
+      void factorize();
+      /// Applies the ILU(0) preconditioner: out = (LU)^-1 in.
+      void apply_preconditioner(const LowScalar* in, LowScalar* out) const;
+      /// Solves A d = r in single precision, r is normalized.
+      /// @return number of iterations.
+      int solve_correction(const LowScalar* r, LowScalar* d);
+
+      CSCMatrix<Scalar> *m;
+      SimpleVector<Scalar> *rhs;
+
+      /// Single precision copy of m.
+      MixedPrecisionCSRMatrix<Scalar> low_matrix;
+
+      /// ILU(0) factors in the sparsity pattern of low_matrix (the unit diagonal of L is not stored).
+      LowScalar* factors;
+      /// Positions of the diagonal entries in the rows.
+      int* diagonal;
+      /// Size of the matrix factorized.
+      unsigned int factorized_size;
+
+      /// Work vectors of BiCGStab.
+      LowScalar* work;
+
+      double inner_tolerance;
+      int max_inner_iters;
+
+      int num_iters;
+      int num_inner_iters;
+      double final_residual;
+    };
+  }
+}
+#endif
@@ -41,6 +41,9 @@ namespace Hermes
       /// Find out the convergence state.
       virtual NonlinearConvergenceState get_convergence_state();
 
+      /// The residual and the jacobian are independent, they can be assembled together.
+      virtual bool assemble_jacobian_with_residual() const;
+
       /// Common constructors code.
       /// Internal setting of default values (see individual set methods).
       void init_newton();
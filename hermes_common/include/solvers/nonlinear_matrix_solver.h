@@ -181,6 +181,11 @@ namespace Hermes
       bool force_reuse_jacobian_values(unsigned int& successful_steps_with_reused_jacobian);
       /// For deciding if the reused jacobian did not bring residual increase at this point.
       bool jacobian_reused_okay(unsigned int& successful_steps_with_reused_jacobian);
+      /// For deciding (without side effects) whether the jacobian will be reused after the damping factor has been found.
+      bool will_reuse_jacobian(unsigned int successful_steps_with_reused_jacobian) const;
+      /// Whether the convergence test at the current iterate is expected to pass (before its residual is assembled),
+      /// with the residual norm extrapolated from the last two ones assuming quadratic convergence.
+      bool convergence_expected();
 
       double sufficient_improvement_factor_jacobian;
       unsigned int max_steps_with_reused_jacobian;
@@ -193,6 +198,10 @@ namespace Hermes
       virtual void assemble_jacobian(bool store_previous_jacobian) = 0;
       virtual void assemble(bool store_previous_jacobian, bool store_previous_residual) = 0;
 
+      /// Whether the jacobian may be assembled together with the residual (in one assembling) at an iterate, at which
+      /// it is certainly needed for the next linear system. Not the case if the residual norm depends on the jacobian (Picard).
+      virtual bool assemble_jacobian_with_residual() const;
+
       /// \return Whether or not should the processing continue.
       virtual void on_damping_factor_updated();
       /// \return Whether or not should the processing continue.
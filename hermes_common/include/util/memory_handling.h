@@ -267,6 +267,46 @@ namespace Hermes
     }
   }
 
+  /// Arrays shorter than this are zeroed serially in zero_first_touch().
+  const int HERMES_FIRST_TOUCH_MIN_SIZE = 1 << 14;
+
+  /// Sets the (freshly allocated) array to zero in parallel.
+  /// The memory pages get mapped to the NUMA nodes of the threads touching them first: the items are distributed among
+  /// numThreads threads as by "omp parallel for schedule(static)", the parallel loops over the array should use the same
+  /// distribution (and the same number of threads) to work on local memory.
+  template<typename ArrayItem>
+  void zero_first_touch(ArrayItem* array, int size)
+  {
+    int num_threads = HermesCommonApi.get_integral_param_value(numThreads);
+    if (size < HERMES_FIRST_TOUCH_MIN_SIZE || num_threads < 2)
+    {
+      memset(array, 0, size * sizeof(ArrayItem));
+      return;
+    }
+#pragma omp parallel for schedule(static) num_threads(num_threads)
+    for (int i = 0; i < size; i++)
+      array[i] = ArrayItem(0);
+  }
+
+  /// Version of zero_first_touch() for the data of compressed (row / column / block row) storages: the rows are distributed
+  /// among the threads as by "omp parallel for schedule(static)", the row i is [row_starts[i] * entry_size, row_starts[i + 1] * entry_size).
+  template<typename ArrayItem>
+  void zero_first_touch(ArrayItem* array, const int* row_starts, int num_rows, int entry_size = 1)
+  {
+    int num_threads = HermesCommonApi.get_integral_param_value(numThreads);
+    if (row_starts[num_rows] * entry_size < HERMES_FIRST_TOUCH_MIN_SIZE || num_threads < 2)
+    {
+      memset(array, 0, row_starts[num_rows] * entry_size * sizeof(ArrayItem));
+      return;
+    }
+#pragma omp parallel for schedule(static) num_threads(num_threads)
+    for (int i = 0; i < num_rows; i++)
+    {
+      for (int j = row_starts[i] * entry_size; j < row_starts[i + 1] * entry_size; j++)
+        array[j] = ArrayItem(0);
+    }
+  }
+
   template<typename ArrayItem>
   void free_with_check(ArrayItem*& ptr, bool force_malloc = false)
   {
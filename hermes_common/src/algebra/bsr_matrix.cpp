@@ -0,0 +1,421 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file bsr_matrix.cpp
+\brief Block compressed sparse row (BSR) matrix class.
+*/
+#include "bsr_matrix.h"
+#include "util/memory_handling.h"
+#include "api.h"
+
+namespace Hermes
+{
+  namespace Algebra
+  {
+    static inline void bsr_atomic_add(double& target, double v)
+    {
+#pragma omp atomic
+      target += v;
+    }
+
+    static inline void bsr_atomic_add(std::complex<double>& target, std::complex<double> v)
+    {
+#pragma omp critical (BSRMatrixAdd)
+      target += v;
+    }
+
+    template<typename Scalar>
+    BSRMatrix<Scalar>::BSRMatrix(unsigned int block_size) : SparseMatrix<Scalar>(), block_size(block_size), num_block_rows(0), nnzb(0), nnz(0),
+      Bp(nullptr), Bj(nullptr), Bx(nullptr), csc_Ap(nullptr), csc_Ai(nullptr), csc_map(nullptr)
+    {
+      if (block_size == 0)
+        throw Hermes::Exceptions::ValueException("block_size", 0, 1);
+      this->size = 0;
+    }
+
+    template<typename Scalar>
+    BSRMatrix<Scalar>::~BSRMatrix()
+    {
+      free();
+    }
+
+    template<typename Scalar>
+    unsigned int BSRMatrix<Scalar>::get_block_size() const
+    {
+      return this->block_size;
+    }
+
+    template<typename Scalar>
+    unsigned int BSRMatrix<Scalar>::get_num_blocks() const
+    {
+      return this->nnzb;
+    }
+
+    template<typename Scalar>
+    void BSRMatrix<Scalar>::prealloc(unsigned int n)
+    {
+      this->size = n;
+      this->num_block_rows = (n + this->block_size - 1) / this->block_size;
+
+      this->pages = malloc_with_check<BSRMatrix<Scalar>, typename SparseMatrix<Scalar>::Page *>(this->num_block_rows, this);
+      memset(this->pages, 0, this->num_block_rows * sizeof(typename SparseMatrix<Scalar>::Page *));
+    }
+
+    template<typename Scalar>
+    void BSRMatrix<Scalar>::pre_add_ij(unsigned int row, unsigned int col)
+    {
+      unsigned int block_row = row / this->block_size;
+      int block_col = col / this->block_size;
+
+      // Consecutive entries of one block are very common, do not store them repeatedly.
+      typename SparseMatrix<Scalar>::Page* page = this->pages[block_row];
+      if (page != nullptr && page->count > 0 && page->idx[page->count - 1] == block_col)
+        return;
+
+      if (page == nullptr || page->count >= SparseMatrix<Scalar>::PAGE_SIZE)
+      {
+        typename SparseMatrix<Scalar>::Page *new_page = new typename SparseMatrix<Scalar>::Page;
+        new_page->count = 0;
+        new_page->next = page;
+        this->pages[block_row] = page = new_page;
+      }
+      page->idx[page->count++] = block_col;
+    }
+
+    template<typename Scalar>
+    void BSRMatrix<Scalar>::alloc()
+    {
+      assert(this->pages != nullptr);
+
+      free_with_check(Bp);
+      free_with_check(Bj);
+      free_with_check(Bx);
+      free_with_check(csc_Ap);
+      free_with_check(csc_Ai);
+      free_with_check(csc_map);
+
+      int total = 0;
+      for (unsigned int i = 0; i < this->num_block_rows; i++)
+      for (typename SparseMatrix<Scalar>::Page *page = this->pages[i]; page != nullptr; page = page->next)
+        total += page->count;
+
+      // sort the block indices and remove duplicities, insert into Bj
+      Bp = malloc_with_check<BSRMatrix<Scalar>, int>(this->num_block_rows + 1, this);
+      Bj = malloc_with_check<BSRMatrix<Scalar>, int>(total, this);
+      unsigned int i;
+      int pos = 0;
+      for (i = 0; i < this->num_block_rows; i++)
+      {
+        Bp[i] = pos;
+        pos += this->sort_and_store_indices(this->pages[i], Bj + pos, Bj + total);
+      }
+      Bp[i] = pos;
+
+      free_with_check(this->pages);
+      this->pages = nullptr;
+
+      this->nnzb = Bp[this->num_block_rows];
+      Bx = malloc_with_check<BSRMatrix<Scalar>, Scalar>(this->nnzb * this->block_size * this->block_size, this);
+      // The block rows are first touched by the threads working on them in multiply_with_vector().
+      zero_first_touch(Bx, Bp, this->num_block_rows, this->block_size * this->block_size);
+
+      // Entries within the matrix size (the last block row / column may be partial).
+      unsigned int last_block_size = this->size - (this->num_block_rows - 1) * this->block_size;
+      this->nnz = 0;
+      for (i = 0; i < this->num_block_rows; i++)
+      {
+        unsigned int rows = (i == this->num_block_rows - 1) ? last_block_size : this->block_size;
+        for (int k = Bp[i]; k < Bp[i + 1]; k++)
+          this->nnz += rows * ((Bj[k] == (int)this->num_block_rows - 1) ? last_block_size : this->block_size);
+      }
+    }
+
+    template<typename Scalar>
+    void BSRMatrix<Scalar>::free()
+    {
+      if (this->pages)
+      {
+        for (unsigned int i = 0; i < this->num_block_rows; i++)
+        {
+          typename SparseMatrix<Scalar>::Page *page = this->pages[i];
+          while (page != nullptr)
+          {
+            typename SparseMatrix<Scalar>::Page *tmp = page;
+            page = page->next;
+            delete tmp;
+          }
+        }
+        free_with_check(this->pages);
+        this->pages = nullptr;
+      }
+
+      this->nnzb = 0;
+      this->nnz = 0;
+      free_with_check(Bp);
+      free_with_check(Bj);
+      free_with_check(Bx);
+      free_with_check(csc_Ap);
+      free_with_check(csc_Ai);
+      free_with_check(csc_map);
+    }
+
+    template<typename Scalar>
+    int BSRMatrix<Scalar>::find_block(unsigned int block_row, unsigned int block_col) const
+    {
+      int length = Bp[block_row + 1] - Bp[block_row];
+      if (length == 0)
+        return -1;
+      int pos = CSMatrix<Scalar>::find_position(Bj + Bp[block_row], length, block_col);
+      return pos < 0 ? -1 : Bp[block_row] + pos;
+    }
+
+    template<typename Scalar>
+    Scalar BSRMatrix<Scalar>::get(unsigned int m, unsigned int n) const
+    {
+      int pos = find_block(m / this->block_size, n / this->block_size);
+      if (pos < 0)
+        return Scalar(0);
+      return Bx[(pos * this->block_size + m % this->block_size) * this->block_size + n % this->block_size];
+    }
+
+    template<typename Scalar>
+    void BSRMatrix<Scalar>::zero()
+    {
+      if (Bp)
+        zero_first_touch(Bx, Bp, this->num_block_rows, this->block_size * this->block_size);
+    }
+
+    template<typename Scalar>
+    void BSRMatrix<Scalar>::set_row_zero(unsigned int n)
+    {
+      unsigned int block_row = n / this->block_size;
+      for (int k = Bp[block_row]; k < Bp[block_row + 1]; k++)
+        memset(Bx + (k * this->block_size + n % this->block_size) * this->block_size, 0, sizeof(Scalar)* this->block_size);
+    }
+
+    template<typename Scalar>
+    void BSRMatrix<Scalar>::add(unsigned int m, unsigned int n, Scalar v)
+    {
+      if (v != 0.0)   // ignore zero values.
+      {
+        int pos = find_block(m / this->block_size, n / this->block_size);
+        // Make sure we are adding to an existing non-zero entry.
+        if (pos < 0)
+        {
+          this->info("BSRMatrix<Scalar>::add(): i = %d, j = %d.", m, n);
+          throw Hermes::Exceptions::Exception("Sparse matrix entry not found: [%i, %i]", m, n);
+        }
+
+        bsr_atomic_add(Bx[(pos * this->block_size + m % this->block_size) * this->block_size + n % this->block_size], v);
+      }
+    }
+
+    template<typename Scalar>
+    void BSRMatrix<Scalar>::add(unsigned int m, unsigned int n, Scalar *mat, int *rows, int *cols, const int size)
+    {
+      for (unsigned int i = 0; i < m; i++)
+      {
+        if (rows[i] < 0) // Dir. dof.
+          continue;
+
+        unsigned int block_row = rows[i] / this->block_size;
+        unsigned int row_in_block = rows[i] % this->block_size;
+        int last_block_col = -1;
+        Scalar* block_row_values = nullptr;
+        for (unsigned int j = 0; j < n; j++)
+        {
+          if (cols[j] < 0 || mat[i * size + j] == 0.0)
+            continue;
+
+          int block_col = cols[j] / this->block_size;
+          if (block_col != last_block_col)
+          {
+            int pos = find_block(block_row, block_col);
+            if (pos < 0)
+            {
+              this->info("BSRMatrix<Scalar>::add(): i = %d, j = %d.", rows[i], cols[j]);
+              throw Hermes::Exceptions::Exception("Sparse matrix entry not found: [%i, %i]", rows[i], cols[j]);
+            }
+            block_row_values = Bx + (pos * this->block_size + row_in_block) * this->block_size;
+            last_block_col = block_col;
+          }
+
+          bsr_atomic_add(block_row_values[cols[j] % this->block_size], mat[i * size + j]);
+        }
+      }
+    }
+
+    template<typename Scalar>
+    void BSRMatrix<Scalar>::multiply_with_vector(Scalar* vector_in, Scalar*& vector_out, bool vector_out_initialized) const
+    {
+      if (!vector_out_initialized)
+        vector_out = malloc_with_check<Scalar>(this->size);
+
+      // Padding of the partial last block.
+      unsigned int padded_size = this->num_block_rows * this->block_size;
+      Scalar* in = vector_in;
+      Scalar* out = vector_out;
+      if (padded_size != this->size)
+      {
+        in = calloc_with_check<Scalar>(padded_size);
+        memcpy(in, vector_in, sizeof(Scalar)* this->size);
+        out = malloc_with_check<Scalar>(padded_size);
+      }
+
+      const int b = this->block_size;
+      const int num_block_rows = this->num_block_rows;
+#pragma omp parallel for schedule(static) num_threads(Hermes::HermesCommonApi.get_integral_param_value(Hermes::numThreads))
+      for (int block_row = 0; block_row < num_block_rows; block_row++)
+      {
+        Scalar* y = out + block_row * b;
+        for (int r = 0; r < b; r++)
+          y[r] = Scalar(0);
+        for (int k = Bp[block_row]; k < Bp[block_row + 1]; k++)
+        {
+          const Scalar* x = in + Bj[k] * b;
+          const Scalar* block = Bx + k * b * b;
+          for (int r = 0; r < b; r++)
+          {
+            Scalar sum = y[r];
+            for (int c = 0; c < b; c++)
+              sum += block[r * b + c] * x[c];
+            y[r] = sum;
+          }
+        }
+      }
+
+      if (padded_size != this->size)
+      {
+        memcpy(vector_out, out, sizeof(Scalar)* this->size);
+        free_with_check(in);
+        free_with_check(out);
+      }
+    }
+
+    template<typename Scalar>
+    void BSRMatrix<Scalar>::multiply_with_Scalar(Scalar value)
+    {
+      unsigned int count = this->nnzb * this->block_size * this->block_size;
+      for (unsigned int i = 0; i < count; i++)
+        Bx[i] *= value;
+    }
+
+    template<typename Scalar>
+    unsigned int BSRMatrix<Scalar>::get_nnz() const
+    {
+      return this->nnz;
+    }
+
+    template<typename Scalar>
+    double BSRMatrix<Scalar>::get_fill_in() const
+    {
+      return this->nnz / (double)(this->size * this->size);
+    }
+
+    template<typename Scalar>
+    void BSRMatrix<Scalar>::init_csc_map()
+    {
+      const unsigned int b = this->block_size;
+
+      // Count the entries in the columns.
+      csc_Ap = calloc_with_check<BSRMatrix<Scalar>, int>(this->size + 1, this);
+      for (unsigned int block_row = 0; block_row < this->num_block_rows; block_row++)
+      {
+        unsigned int rows = std::min(b, this->size - block_row * b);
+        for (int k = Bp[block_row]; k < Bp[block_row + 1]; k++)
+        for (unsigned int c = 0; c < b && Bj[k] * b + c < this->size; c++)
+          csc_Ap[Bj[k] * b + c + 1] += rows;
+      }
+      for (unsigned int i = 0; i < this->size; i++)
+        csc_Ap[i + 1] += csc_Ap[i];
+
+      // Fill the columns, going through the block rows in ascending order keeps the row indices sorted.
+      csc_Ai = malloc_with_check<BSRMatrix<Scalar>, int>(this->nnz, this);
+      csc_map = malloc_with_check<BSRMatrix<Scalar>, int>(this->nnz, this);
+      int* position = malloc_with_check<BSRMatrix<Scalar>, int>(this->size, this);
+      memcpy(position, csc_Ap, this->size * sizeof(int));
+      for (unsigned int block_row = 0; block_row < this->num_block_rows; block_row++)
+      {
+        for (unsigned int r = 0; r < b && block_row * b + r < this->size; r++)
+        {
+          for (int k = Bp[block_row]; k < Bp[block_row + 1]; k++)
+          {
+            for (unsigned int c = 0; c < b && Bj[k] * b + c < this->size; c++)
+            {
+              int column = Bj[k] * b + c;
+              csc_Ai[position[column]] = block_row * b + r;
+              csc_map[position[column]++] = (k * b + r) * b + c;
+            }
+          }
+        }
+      }
+      free_with_check(position);
+    }
+
+    template<typename Scalar>
+    void BSRMatrix<Scalar>::convert_to_csc(CSCMatrix<Scalar>* target)
+    {
+      if (!csc_map)
+        init_csc_map();
+
+      if (target->get_size() != this->size || target->get_nnz() != this->nnz)
+      {
+        target->free();
+        // Bx holds at least nnz values, the correct ones are gathered below.
+        target->create(this->size, this->nnz, csc_Ap, csc_Ai, Bx);
+      }
+      else
+      {
+        memcpy(target->get_Ap(), csc_Ap, (this->size + 1) * sizeof(int));
+        memcpy(target->get_Ai(), csc_Ai, this->nnz * sizeof(int));
+      }
+
+      Scalar* Ax = target->get_Ax();
+      for (unsigned int i = 0; i < this->nnz; i++)
+        Ax[i] = Bx[csc_map[i]];
+    }
+
+    template<typename Scalar>
+    void BSRMatrix<Scalar>::export_to_file(const char *filename, const char *var_name, MatrixExportFormat fmt, char* number_format)
+    {
+      CSCMatrix<Scalar> csc_matrix;
+      this->convert_to_csc(&csc_matrix);
+      csc_matrix.export_to_file(filename, var_name, fmt, number_format);
+    }
+
+    template<typename Scalar>
+    SparseMatrix<Scalar>* BSRMatrix<Scalar>::duplicate() const
+    {
+      BSRMatrix<Scalar>* new_matrix = new BSRMatrix<Scalar>(this->block_size);
+      new_matrix->size = this->size;
+      new_matrix->num_block_rows = this->num_block_rows;
+      new_matrix->nnzb = this->nnzb;
+      new_matrix->nnz = this->nnz;
+      new_matrix->Bp = malloc_with_check<BSRMatrix<Scalar>, int>(this->num_block_rows + 1, new_matrix);
+      new_matrix->Bj = malloc_with_check<BSRMatrix<Scalar>, int>(this->nnzb, new_matrix);
+      new_matrix->Bx = malloc_with_check<BSRMatrix<Scalar>, Scalar>(this->nnzb * this->block_size * this->block_size, new_matrix);
+      memcpy(new_matrix->Bp, this->Bp, (this->num_block_rows + 1) * sizeof(int));
+      memcpy(new_matrix->Bj, this->Bj, this->nnzb * sizeof(int));
+      memcpy(new_matrix->Bx, this->Bx, this->nnzb * this->block_size * this->block_size * sizeof(Scalar));
+      return new_matrix;
+    }
+  }
+}
+
+template class HERMES_API Hermes::Algebra::BSRMatrix<double>;
+template class HERMES_API Hermes::Algebra::BSRMatrix<std::complex<double> >;
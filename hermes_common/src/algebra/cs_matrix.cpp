@@ -131,7 +131,8 @@ namespace Hermes
     void CSMatrix<Scalar>::alloc_data()
     {
       Ax = malloc_with_check<CSMatrix<Scalar>, Scalar>(nnz, this);
-      memset(Ax, 0, sizeof(Scalar)* nnz);
+      // The rows (CSR) / columns (CSC) are first touched by the threads working on them in multiply_with_vector().
+      zero_first_touch(Ax, Ap, this->size);
     }
 
     template<typename Scalar>
@@ -153,7 +154,8 @@ namespace Hermes
     template<typename Scalar>
     void CSMatrix<Scalar>::zero()
     {
-      memset(Ax, 0, sizeof(Scalar)* nnz);
+      if (Ap)
+        zero_first_touch(Ax, Ap, this->size);
     }
 
     template<typename Scalar>
@@ -728,6 +730,20 @@ namespace Hermes
       return new_matrix;
     }
 
+    template<typename Scalar>
+    void CSCMatrix<Scalar>::copy_to(SparseMatrix<Scalar>* target) const
+    {
+      target->prealloc(this->size);
+      for (unsigned int col = 0; col < this->size; col++)
+      for (int k = this->Ap[col]; k < this->Ap[col + 1]; k++)
+        target->pre_add_ij(this->Ai[k], col);
+      target->alloc();
+      for (unsigned int col = 0; col < this->size; col++)
+      for (int k = this->Ap[col]; k < this->Ap[col + 1]; k++)
+        target->add(this->Ai[k], col, this->Ax[k]);
+      target->finish();
+    }
+
     template<typename Scalar>
     CSRMatrix<Scalar>::CSRMatrix() : CSMatrix<Scalar>()
     {
@@ -761,6 +777,24 @@ namespace Hermes
       return CSMatrix<Scalar>::get(n, m);
     }
 
+    template<typename Scalar>
+    void CSRMatrix<Scalar>::multiply_with_vector(Scalar* vector_in, Scalar*& vector_out, bool vector_out_initialized) const
+    {
+      if (!vector_out_initialized)
+        vector_out = malloc_with_check<Scalar>(this->size);
+
+      // The same distribution of the rows among the threads as in zero_first_touch().
+      const int size = this->size;
+#pragma omp parallel for schedule(static) num_threads(Hermes::HermesCommonApi.get_integral_param_value(Hermes::numThreads))
+      for (int i = 0; i < size; i++)
+      {
+        Scalar sum = Scalar(0);
+        for (int k = this->Ap[i]; k < this->Ap[i + 1]; k++)
+          sum += this->Ax[k] * vector_in[this->Ai[k]];
+        vector_out[i] = sum;
+      }
+    }
+
     template<typename Scalar>
     void CSRMatrix<Scalar>::pre_add_ij(unsigned int row, unsigned int col)
     {
@@ -21,6 +21,7 @@
 */
 #include "common.h"
 #include "matrix.h"
+#include "bsr_matrix.h"
 #include "callstack.h"
 #include "util/memory_handling.h"
 
@@ -350,6 +351,8 @@ namespace Hermes
       case Hermes::SOLVER_UMFPACK:
       {
 #ifdef WITH_UMFPACK
+                                   if (Hermes::HermesCommonApi.get_integral_param_value(Hermes::matrixBlockSize) > 1)
+                                     return new BSRMatrix<double>(Hermes::HermesCommonApi.get_integral_param_value(Hermes::matrixBlockSize));
                                    return new CSCMatrix<double>;
 #else
                                    throw Hermes::Exceptions::Exception("UMFPACK was not installed.");
@@ -377,6 +380,12 @@ namespace Hermes
 #endif
                                    break;
       }
+      case Hermes::SOLVER_MIXED_PRECISION:
+      {
+                                           if (use_direct_solver)
+                                             throw Hermes::Exceptions::Exception("The iterative solver with single precision corrections selected as a direct solver.");
+                                           return new CSCMatrix<double>;
+      }
       default:
         throw Hermes::Exceptions::Exception("Unknown matrix solver requested in create_matrix().");
       }
@@ -435,6 +444,8 @@ namespace Hermes
       case Hermes::SOLVER_UMFPACK:
       {
 #ifdef WITH_UMFPACK
+                                   if (Hermes::HermesCommonApi.get_integral_param_value(Hermes::matrixBlockSize) > 1)
+                                     return new BSRMatrix<std::complex<double> >(Hermes::HermesCommonApi.get_integral_param_value(Hermes::matrixBlockSize));
                                    return new CSCMatrix<std::complex<double> >;
 #else
                                    throw Hermes::Exceptions::Exception("UMFPACK was not installed.");
@@ -462,6 +473,12 @@ namespace Hermes
 #endif
                                    break;
       }
+      case Hermes::SOLVER_MIXED_PRECISION:
+      {
+                                           if (use_direct_solver)
+                                             throw Hermes::Exceptions::Exception("The iterative solver with single precision corrections selected as a direct solver.");
+                                           return new CSCMatrix<std::complex<double> >;
+      }
       default:
         throw Hermes::Exceptions::Exception("Unknown matrix solver requested in create_matrix().");
       }
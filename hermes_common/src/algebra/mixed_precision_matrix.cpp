@@ -0,0 +1,330 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file mixed_precision_matrix.cpp
+\brief CSR matrix with the entries stored in single precision.
+*/
+#include "mixed_precision_matrix.h"
+#include "util/memory_handling.h"
+#include "api.h"
+
+namespace Hermes
+{
+  namespace Algebra
+  {
+    static inline void mixed_atomic_add(float& target, float v)
+    {
+#pragma omp atomic
+      target += v;
+    }
+
+    static inline void mixed_atomic_add(std::complex<float>& target, std::complex<float> v)
+    {
+#pragma omp critical (MixedPrecisionCSRMatrixAdd)
+      target += v;
+    }
+
+    template<typename Scalar>
+    MixedPrecisionCSRMatrix<Scalar>::MixedPrecisionCSRMatrix() : SparseMatrix<Scalar>(), Ap(nullptr), Ai(nullptr), Ax(nullptr), nnz(0)
+    {
+      this->size = 0;
+    }
+
+    template<typename Scalar>
+    MixedPrecisionCSRMatrix<Scalar>::~MixedPrecisionCSRMatrix()
+    {
+      free();
+    }
+
+    template<typename Scalar>
+    void MixedPrecisionCSRMatrix<Scalar>::pre_add_ij(unsigned int row, unsigned int col)
+    {
+      if (this->pages[row] == nullptr || this->pages[row]->count >= SparseMatrix<Scalar>::PAGE_SIZE)
+      {
+        typename SparseMatrix<Scalar>::Page *new_page = new typename SparseMatrix<Scalar>::Page;
+        new_page->count = 0;
+        new_page->next = this->pages[row];
+        this->pages[row] = new_page;
+      }
+      this->pages[row]->idx[this->pages[row]->count++] = col;
+    }
+
+    template<typename Scalar>
+    void MixedPrecisionCSRMatrix<Scalar>::alloc()
+    {
+      assert(this->pages != nullptr);
+
+      free_with_check(Ap);
+      free_with_check(Ai);
+      free_with_check(Ax);
+
+      // sort the indices and remove duplicities, insert into Ai
+      Ap = malloc_with_check<MixedPrecisionCSRMatrix<Scalar>, int>(this->size + 1, this);
+      int aisize = this->get_num_indices();
+      Ai = malloc_with_check<MixedPrecisionCSRMatrix<Scalar>, int>(aisize, this);
+      unsigned int i;
+      int pos = 0;
+      for (i = 0; i < this->size; i++)
+      {
+        Ap[i] = pos;
+        pos += this->sort_and_store_indices(this->pages[i], Ai + pos, Ai + aisize);
+      }
+      Ap[i] = pos;
+
+      free_with_check(this->pages);
+      this->pages = nullptr;
+
+      nnz = Ap[this->size];
+      Ax = malloc_with_check<MixedPrecisionCSRMatrix<Scalar>, LowScalar>(nnz, this);
+      // The rows are first touched by the threads working on them in multiply_with_vector().
+      zero_first_touch(Ax, Ap, this->size);
+    }
+
+    template<typename Scalar>
+    void MixedPrecisionCSRMatrix<Scalar>::free()
+    {
+      if (this->pages)
+      {
+        for (unsigned int i = 0; i < this->size; i++)
+        {
+          typename SparseMatrix<Scalar>::Page *page = this->pages[i];
+          while (page != nullptr)
+          {
+            typename SparseMatrix<Scalar>::Page *tmp = page;
+            page = page->next;
+            delete tmp;
+          }
+        }
+        free_with_check(this->pages);
+        this->pages = nullptr;
+      }
+
+      nnz = 0;
+      free_with_check(Ap);
+      free_with_check(Ai);
+      free_with_check(Ax);
+    }
+
+    template<typename Scalar>
+    int MixedPrecisionCSRMatrix<Scalar>::find_entry(unsigned int m, unsigned int n) const
+    {
+      int length = Ap[m + 1] - Ap[m];
+      if (length == 0)
+        return -1;
+      int pos = CSMatrix<Scalar>::find_position(Ai + Ap[m], length, n);
+      return pos < 0 ? -1 : Ap[m] + pos;
+    }
+
+    template<typename Scalar>
+    Scalar MixedPrecisionCSRMatrix<Scalar>::get(unsigned int m, unsigned int n) const
+    {
+      int pos = find_entry(m, n);
+      if (pos < 0)
+        return Scalar(0);
+      return Scalar(Ax[pos]);
+    }
+
+    template<typename Scalar>
+    void MixedPrecisionCSRMatrix<Scalar>::zero()
+    {
+      if (Ap)
+        zero_first_touch(Ax, Ap, this->size);
+    }
+
+    template<typename Scalar>
+    void MixedPrecisionCSRMatrix<Scalar>::set_row_zero(unsigned int n)
+    {
+      memset(Ax + Ap[n], 0, sizeof(LowScalar)* (Ap[n + 1] - Ap[n]));
+    }
+
+    template<typename Scalar>
+    void MixedPrecisionCSRMatrix<Scalar>::add(unsigned int m, unsigned int n, Scalar v)
+    {
+      if (v != 0.0)   // ignore zero values.
+      {
+        int pos = find_entry(m, n);
+        // Make sure we are adding to an existing non-zero entry.
+        if (pos < 0)
+        {
+          this->info("MixedPrecisionCSRMatrix<Scalar>::add(): i = %d, j = %d.", m, n);
+          throw Hermes::Exceptions::Exception("Sparse matrix entry not found: [%i, %i]", m, n);
+        }
+
+        mixed_atomic_add(Ax[pos], LowScalar(v));
+      }
+    }
+
+    template<typename Scalar>
+    void MixedPrecisionCSRMatrix<Scalar>::multiply_with_vector(Scalar* vector_in, Scalar*& vector_out, bool vector_out_initialized) const
+    {
+      if (!vector_out_initialized)
+        vector_out = malloc_with_check<Scalar>(this->size);
+
+      const int size = this->size;
+#pragma omp parallel for schedule(static) num_threads(Hermes::HermesCommonApi.get_integral_param_value(Hermes::numThreads))
+      for (int i = 0; i < size; i++)
+      {
+        Scalar sum = Scalar(0);
+        for (int k = Ap[i]; k < Ap[i + 1]; k++)
+          sum += Scalar(Ax[k]) * vector_in[Ai[k]];
+        vector_out[i] = sum;
+      }
+    }
+
+    template<typename Scalar>
+    void MixedPrecisionCSRMatrix<Scalar>::multiply_with_vector(const LowScalar* vector_in, LowScalar* vector_out) const
+    {
+      const int size = this->size;
+#pragma omp parallel for schedule(static) num_threads(Hermes::HermesCommonApi.get_integral_param_value(Hermes::numThreads))
+      for (int i = 0; i < size; i++)
+      {
+        LowScalar sum = LowScalar(0);
+        for (int k = Ap[i]; k < Ap[i + 1]; k++)
+          sum += Ax[k] * vector_in[Ai[k]];
+        vector_out[i] = sum;
+      }
+    }
+
+    template<typename Scalar>
+    void MixedPrecisionCSRMatrix<Scalar>::multiply_with_Scalar(Scalar value)
+    {
+      LowScalar low_value = LowScalar(value);
+      for (unsigned int i = 0; i < nnz; i++)
+        Ax[i] *= low_value;
+    }
+
+    template<typename Scalar>
+    unsigned int MixedPrecisionCSRMatrix<Scalar>::get_nnz() const
+    {
+      return nnz;
+    }
+
+    template<typename Scalar>
+    double MixedPrecisionCSRMatrix<Scalar>::get_fill_in() const
+    {
+      return nnz / (double)(this->size * this->size);
+    }
+
+    template<typename Scalar>
+    unsigned long MixedPrecisionCSRMatrix<Scalar>::get_memory_size() const
+    {
+      return (this->size + 1) * sizeof(int) + (unsigned long)nnz * (sizeof(int) + sizeof(LowScalar));
+    }
+
+    template<typename Scalar>
+    int *MixedPrecisionCSRMatrix<Scalar>::get_Ap() const
+    {
+      return Ap;
+    }
+
+    template<typename Scalar>
+    int *MixedPrecisionCSRMatrix<Scalar>::get_Ai() const
+    {
+      return Ai;
+    }
+
+    template<typename Scalar>
+    typename MixedPrecisionCSRMatrix<Scalar>::LowScalar *MixedPrecisionCSRMatrix<Scalar>::get_Ax() const
+    {
+      return Ax;
+    }
+
+    template<typename Scalar>
+    void MixedPrecisionCSRMatrix<Scalar>::export_to_file(const char *filename, const char *var_name, MatrixExportFormat fmt, char* number_format)
+    {
+      // Transposition to the CSC format, going through the rows in ascending order keeps the row indices sorted.
+      int* csc_Ap = calloc_with_check<int>(this->size + 1);
+      int* csc_Ai = malloc_with_check<int>(nnz);
+      Scalar* csc_Ax = malloc_with_check<Scalar>(nnz);
+      for (unsigned int k = 0; k < nnz; k++)
+        csc_Ap[Ai[k] + 1]++;
+      for (unsigned int i = 0; i < this->size; i++)
+        csc_Ap[i + 1] += csc_Ap[i];
+      int* position = malloc_with_check<int>(this->size);
+      memcpy(position, csc_Ap, this->size * sizeof(int));
+      for (unsigned int i = 0; i < this->size; i++)
+      {
+        for (int k = Ap[i]; k < Ap[i + 1]; k++)
+        {
+          csc_Ai[position[Ai[k]]] = i;
+          csc_Ax[position[Ai[k]]++] = Scalar(Ax[k]);
+        }
+      }
+      free_with_check(position);
+
+      CSCMatrix<Scalar> csc_matrix;
+      csc_matrix.create(this->size, nnz, csc_Ap, csc_Ai, csc_Ax);
+      csc_matrix.export_to_file(filename, var_name, fmt, number_format);
+
+      free_with_check(csc_Ap);
+      free_with_check(csc_Ai);
+      free_with_check(csc_Ax);
+    }
+
+    template<typename Scalar>
+    SparseMatrix<Scalar>* MixedPrecisionCSRMatrix<Scalar>::duplicate() const
+    {
+      MixedPrecisionCSRMatrix<Scalar>* new_matrix = new MixedPrecisionCSRMatrix<Scalar>();
+      new_matrix->size = this->size;
+      new_matrix->nnz = this->nnz;
+      new_matrix->Ap = malloc_with_check<MixedPrecisionCSRMatrix<Scalar>, int>(this->size + 1, new_matrix);
+      new_matrix->Ai = malloc_with_check<MixedPrecisionCSRMatrix<Scalar>, int>(this->nnz, new_matrix);
+      new_matrix->Ax = malloc_with_check<MixedPrecisionCSRMatrix<Scalar>, LowScalar>(this->nnz, new_matrix);
+      memcpy(new_matrix->Ap, this->Ap, (this->size + 1) * sizeof(int));
+      memcpy(new_matrix->Ai, this->Ai, this->nnz * sizeof(int));
+      memcpy(new_matrix->Ax, this->Ax, this->nnz * sizeof(LowScalar));
+      return new_matrix;
+    }
+
+    template<typename Scalar>
+    void MixedPrecisionCSRMatrix<Scalar>::create_from(const CSCMatrix<Scalar>* matrix)
+    {
+      free();
+      this->size = matrix->get_size();
+      nnz = matrix->get_nnz();
+      int* csc_Ap = matrix->get_Ap();
+      int* csc_Ai = matrix->get_Ai();
+      Scalar* csc_Ax = matrix->get_Ax();
+
+      // Transposition of the pattern: the columns are visited in ascending order, so the rows come out sorted.
+      Ap = calloc_with_check<MixedPrecisionCSRMatrix<Scalar>, int>(this->size + 1, this);
+      Ai = malloc_with_check<MixedPrecisionCSRMatrix<Scalar>, int>(nnz, this);
+      Ax = malloc_with_check<MixedPrecisionCSRMatrix<Scalar>, LowScalar>(nnz, this);
+      for (unsigned int k = 0; k < nnz; k++)
+        Ap[csc_Ai[k] + 1]++;
+      for (unsigned int row = 0; row < this->size; row++)
+        Ap[row + 1] += Ap[row];
+
+      int* positions = malloc_with_check<int>(this->size);
+      memcpy(positions, Ap, this->size * sizeof(int));
+      for (unsigned int col = 0; col < this->size; col++)
+      {
+        for (int k = csc_Ap[col]; k < csc_Ap[col + 1]; k++)
+        {
+          int position = positions[csc_Ai[k]]++;
+          Ai[position] = col;
+          Ax[position] = LowScalar(csc_Ax[k]);
+        }
+      }
+      free_with_check(positions);
+    }
+  }
+}
+
+template class HERMES_API Hermes::Algebra::MixedPrecisionCSRMatrix<double>;
+template class HERMES_API Hermes::Algebra::MixedPrecisionCSRMatrix<std::complex<double> >;
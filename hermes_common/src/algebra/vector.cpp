@@ -416,7 +416,8 @@ namespace Hermes
     template<typename Scalar>
     void SimpleVector<Scalar>::zero()
     {
-      memset(this->v, 0, this->size * sizeof(Scalar));
+      // First touch by the threads working on the entries in the parallel (row-wise) loops.
+      zero_first_touch(this->v, this->size);
     }
 
     template<typename Scalar>
@@ -562,6 +563,12 @@ namespace Hermes
 #endif
                                    break;
       }
+      case Hermes::SOLVER_MIXED_PRECISION:
+      {
+                                           if (use_direct_solver)
+                                             throw Hermes::Exceptions::Exception("The iterative solver with single precision corrections selected as a direct solver.");
+                                           return new SimpleVector<double>;
+      }
       default:
         throw Hermes::Exceptions::Exception("Unknown matrix solver requested in create_vector().");
       }
@@ -649,6 +656,12 @@ namespace Hermes
 #endif
                                    break;
       }
+      case Hermes::SOLVER_MIXED_PRECISION:
+      {
+                                           if (use_direct_solver)
+                                             throw Hermes::Exceptions::Exception("The iterative solver with single precision corrections selected as a direct solver.");
+                                           return new SimpleVector<std::complex<double> >;
+      }
       default:
         throw Hermes::Exceptions::Exception("Unknown matrix solver requested in create_vector().");
       }
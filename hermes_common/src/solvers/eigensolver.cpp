@@ -0,0 +1,918 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file eigensolver.cpp
+\brief Sparse generalized eigensolver (shift-invert Lanczos / restarted Arnoldi).
+*/
+#include "eigensolver.h"
+#include "solvers/interfaces/umfpack_solver.h"
+#include "util/memory_handling.h"
+#include "api.h"
+#include <limits>
+#include <type_traits>
+
+namespace Hermes
+{
+  namespace Solvers
+  {
+    typedef std::complex<double> Complex;
+
+    static const double eigensolver_epsilon = std::numeric_limits<double>::epsilon();
+
+    /// Transposition of compressed (CSC <-> CSR) arrays, the indices stay sorted.
+    template<typename Scalar>
+    static void compressed_transpose(unsigned int size, const int* Ap, const int* Ai, const Scalar* Ax, int*& tAp, int*& tAi, Scalar*& tAx)
+    {
+      int nnz = Ap[size];
+      tAp = calloc_with_check<int>(size + 1);
+      tAi = malloc_with_check<int>(nnz);
+      tAx = malloc_with_check<Scalar>(nnz);
+      for (int k = 0; k < nnz; k++)
+        tAp[Ai[k] + 1]++;
+      for (unsigned int i = 0; i < size; i++)
+        tAp[i + 1] += tAp[i];
+      int* position = malloc_with_check<int>(size);
+      memcpy(position, tAp, size * sizeof(int));
+      for (unsigned int i = 0; i < size; i++)
+      {
+        for (int k = Ap[i]; k < Ap[i + 1]; k++)
+        {
+          tAi[position[Ai[k]]] = i;
+          tAx[position[Ai[k]]++] = Ax[k];
+        }
+      }
+      free_with_check(position);
+    }
+
+    /// Compressed arrays of the matrix in the wanted orientation, a copy is made if the matrix is stored in the other one.
+    template<typename Scalar>
+    static bool compressed_arrays(CSMatrix<Scalar>* matrix, bool columns, int*& Ap, int*& Ai, Scalar*& Ax)
+    {
+      bool csc = (dynamic_cast<CSCMatrix<Scalar>*>(matrix) != nullptr);
+      if (!csc && dynamic_cast<CSRMatrix<Scalar>*>(matrix) == nullptr)
+        throw Exceptions::Exception("EigenSolver: the matrices have to be CSCMatrix or CSRMatrix.");
+      if (csc == columns)
+      {
+        Ap = matrix->get_Ap();
+        Ai = matrix->get_Ai();
+        Ax = matrix->get_Ax();
+        return false;
+      }
+      compressed_transpose(matrix->get_size(), matrix->get_Ap(), matrix->get_Ai(), matrix->get_Ax(), Ap, Ai, Ax);
+      return true;
+    }
+
+    /// Reduction of a dense (column-major, n x n) matrix to the upper Hessenberg form H = Z Hess Z^H by Householder reflections.
+    static void dense_hessenberg(Complex* H, Complex* Z, int n)
+    {
+      Complex* v = malloc_with_check<Complex>(n);
+      for (int k = 0; k < n - 2; k++)
+      {
+        double x_norm = 0.;
+        for (int i = k + 1; i < n; i++)
+          x_norm += std::norm(H[i + k * n]);
+        x_norm = sqrt(x_norm);
+        if (x_norm == 0.)
+          continue;
+
+        Complex x0 = H[k + 1 + k * n];
+        Complex alpha = (std::abs(x0) > 0. ? -x0 / std::abs(x0) : Complex(-1.)) * x_norm;
+        double v_norm = 0.;
+        for (int i = k + 1; i < n; i++)
+        {
+          v[i] = (i == k + 1) ? x0 - alpha : H[i + k * n];
+          v_norm += std::norm(v[i]);
+        }
+        if (v_norm == 0.)
+          continue;
+
+        // H = (I - 2 v v^H / |v|^2) H (I - 2 v v^H / |v|^2), Z = Z (I - 2 v v^H / |v|^2).
+        for (int j = 0; j < n; j++)
+        {
+          Complex s = 0.;
+          for (int i = k + 1; i < n; i++)
+            s += std::conj(v[i]) * H[i + j * n];
+          s *= 2. / v_norm;
+          for (int i = k + 1; i < n; i++)
+            H[i + j * n] -= s * v[i];
+        }
+        for (int i = 0; i < n; i++)
+        {
+          Complex s = 0., t = 0.;
+          for (int j = k + 1; j < n; j++)
+          {
+            s += H[i + j * n] * v[j];
+            t += Z[i + j * n] * v[j];
+          }
+          s *= 2. / v_norm;
+          t *= 2. / v_norm;
+          for (int j = k + 1; j < n; j++)
+          {
+            H[i + j * n] -= s * std::conj(v[j]);
+            Z[i + j * n] -= t * std::conj(v[j]);
+          }
+        }
+        for (int i = k + 2; i < n; i++)
+          H[i + k * n] = 0.;
+      }
+      free_with_check(v);
+    }
+
+    /// Plane rotation G = [c s; -conj(s) c] with G [x; y] = [r; 0].
+    static void dense_givens(Complex x, Complex y, double& c, Complex& s)
+    {
+      if (std::abs(y) == 0.)
+      {
+        c = 1.;
+        s = 0.;
+      }
+      else if (std::abs(x) == 0.)
+      {
+        c = 0.;
+        s = std::conj(y) / std::abs(y);
+      }
+      else
+      {
+        double norm = sqrt(std::norm(x) + std::norm(y));
+        c = std::abs(x) / norm;
+        s = (x / std::abs(x)) * std::conj(y) / norm;
+      }
+    }
+
+    /// Schur form of an upper Hessenberg matrix by the shifted QR algorithm: H := T (upper triangular), Z := Z Q.
+    static void dense_schur(Complex* H, Complex* Z, int n)
+    {
+      int hi = n - 1;
+      int iterations = 0;
+      while (hi > 0)
+      {
+        // Deflation.
+        int l = hi;
+        while (l > 0 && std::abs(H[l + (l - 1) * n]) > eigensolver_epsilon * (std::abs(H[l - 1 + (l - 1) * n]) + std::abs(H[l + l * n])))
+          l--;
+        if (l > 0)
+          H[l + (l - 1) * n] = 0.;
+        if (l == hi)
+        {
+          hi--;
+          iterations = 0;
+          continue;
+        }
+        if (++iterations > 30 * n)
+          throw Exceptions::Exception("EigenSolver: the QR algorithm for the projected problem did not converge.");
+
+        // Wilkinson shift (an exceptional one now and then).
+        Complex a = H[hi - 1 + (hi - 1) * n], b = H[hi - 1 + hi * n], c = H[hi + (hi - 1) * n], d = H[hi + hi * n];
+        Complex shift;
+        if (iterations % 10 == 0)
+          shift = d + std::abs(c);
+        else
+        {
+          Complex discriminant = sqrt(0.25 * (a - d) * (a - d) + b * c);
+          Complex mu_1 = 0.5 * (a + d) + discriminant, mu_2 = 0.5 * (a + d) - discriminant;
+          shift = (std::abs(mu_1 - d) < std::abs(mu_2 - d)) ? mu_1 : mu_2;
+        }
+
+        // Bulge chasing in the active block l..hi.
+        Complex x = H[l + l * n] - shift, y = H[l + 1 + l * n];
+        for (int k = l; k < hi; k++)
+        {
+          if (k > l)
+          {
+            x = H[k + (k - 1) * n];
+            y = H[k + 1 + (k - 1) * n];
+          }
+          double cos;
+          Complex sin;
+          dense_givens(x, y, cos, sin);
+
+          for (int j = (k > l ? k - 1 : l); j < n; j++)
+          {
+            Complex p = H[k + j * n], q = H[k + 1 + j * n];
+            H[k + j * n] = cos * p + sin * q;
+            H[k + 1 + j * n] = -std::conj(sin) * p + cos * q;
+          }
+          int last_row = std::min(k + 2, hi);
+          for (int i = 0; i <= last_row; i++)
+          {
+            Complex p = H[i + k * n], q = H[i + (k + 1) * n];
+            H[i + k * n] = cos * p + std::conj(sin) * q;
+            H[i + (k + 1) * n] = -sin * p + cos * q;
+          }
+          for (int i = 0; i < n; i++)
+          {
+            Complex p = Z[i + k * n], q = Z[i + (k + 1) * n];
+            Z[i + k * n] = cos * p + std::conj(sin) * q;
+            Z[i + (k + 1) * n] = -sin * p + cos * q;
+          }
+          if (k > l)
+            H[k + 1 + (k - 1) * n] = 0.;
+        }
+      }
+    }
+
+    /// Eigenvalues and eigenvectors (columns of vectors, normalized) of a dense (column-major, n x n) matrix.
+    static void dense_eigen(const Complex* matrix, int n, Complex* values, Complex* vectors)
+    {
+      Complex* T = malloc_with_check<Complex>(n * n);
+      Complex* Z = calloc_with_check<Complex>(n * n);
+      memcpy(T, matrix, n * n * sizeof(Complex));
+      for (int i = 0; i < n; i++)
+        Z[i + i * n] = 1.;
+
+      dense_hessenberg(T, Z, n);
+      dense_schur(T, Z, n);
+
+      double T_norm = 0.;
+      for (int i = 0; i < n * n; i++)
+        T_norm = std::max(T_norm, std::abs(T[i]));
+      double small = eigensolver_epsilon * std::max(T_norm, 1e-300);
+
+      // Eigenvectors of T by back substitution, transformed by Z.
+      Complex* x = malloc_with_check<Complex>(n);
+      for (int k = 0; k < n; k++)
+      {
+        values[k] = T[k + k * n];
+        x[k] = 1.;
+        for (int j = k - 1; j >= 0; j--)
+        {
+          Complex s = 0.;
+          for (int l = j + 1; l <= k; l++)
+            s += T[j + l * n] * x[l];
+          Complex denominator = T[j + j * n] - values[k];
+          if (std::abs(denominator) < small)
+            denominator = small;
+          x[j] = -s / denominator;
+        }
+
+        double norm = 0.;
+        for (int i = 0; i < n; i++)
+        {
+          Complex value = 0.;
+          for (int l = 0; l <= k; l++)
+            value += Z[i + l * n] * x[l];
+          vectors[i + k * n] = value;
+          norm += std::norm(value);
+        }
+        norm = sqrt(norm);
+        for (int i = 0; i < n; i++)
+          vectors[i + k * n] /= norm;
+      }
+
+      free_with_check(x);
+      free_with_check(T);
+      free_with_check(Z);
+    }
+
+    static inline void eigensolver_to_scalar(const Complex& value, double& target)
+    {
+      target = value.real();
+    }
+
+    static inline void eigensolver_to_scalar(const Complex& value, Complex& target)
+    {
+      target = value;
+    }
+
+    template<typename Scalar>
+    EigenSolver<Scalar>::EigenSolver(CSMatrix<Scalar>* A, CSMatrix<Scalar>* B) : A(A), B(B), size(A->get_size()), symmetric(false), krylov_dimension(0),
+      B_Ap(nullptr), B_Ai(nullptr), B_Ax(nullptr), shifted_matrix(nullptr), shifted_rhs(nullptr), shifted_solver(nullptr),
+      V(nullptr), BV(nullptr), n_eigs(0), num_iters(0), eigenvalues(nullptr), eigenvectors(nullptr), eigenvectors_scalar(nullptr)
+    {
+      if (B)
+      {
+        if (B->get_size() != this->size)
+          throw Exceptions::Exception("EigenSolver: the matrices A and B have different sizes.");
+
+        // Own copy of B in the CSR format.
+        int* Ap, *Ai;
+        Scalar* Ax;
+        if (compressed_arrays(B, false, Ap, Ai, Ax))
+        {
+          B_Ap = Ap;
+          B_Ai = Ai;
+          B_Ax = Ax;
+        }
+        else
+        {
+          B_Ap = malloc_with_check<int>(this->size + 1);
+          B_Ai = malloc_with_check<int>(Ap[this->size]);
+          B_Ax = malloc_with_check<Scalar>(Ap[this->size]);
+          memcpy(B_Ap, Ap, (this->size + 1) * sizeof(int));
+          memcpy(B_Ai, Ai, Ap[this->size] * sizeof(int));
+          memcpy(B_Ax, Ax, Ap[this->size] * sizeof(Scalar));
+        }
+      }
+    }
+
+    template<typename Scalar>
+    EigenSolver<Scalar>::~EigenSolver()
+    {
+      this->free();
+      free_with_check(B_Ap);
+      free_with_check(B_Ai);
+      free_with_check(B_Ax);
+    }
+
+    template<typename Scalar>
+    void EigenSolver<Scalar>::free()
+    {
+      free_with_check(V);
+      free_with_check(BV);
+      free_with_check(eigenvalues);
+      free_with_check(eigenvectors);
+      free_with_check(eigenvectors_scalar);
+      if (shifted_solver)
+      {
+        delete shifted_solver;
+        shifted_solver = nullptr;
+      }
+      if (shifted_matrix)
+      {
+        delete shifted_matrix;
+        shifted_matrix = nullptr;
+      }
+      if (shifted_rhs)
+      {
+        delete shifted_rhs;
+        shifted_rhs = nullptr;
+      }
+      n_eigs = 0;
+    }
+
+    template<typename Scalar>
+    void EigenSolver<Scalar>::set_symmetric(bool to_set)
+    {
+      this->symmetric = to_set;
+    }
+
+    template<typename Scalar>
+    void EigenSolver<Scalar>::set_krylov_dimension(int krylov_dimension)
+    {
+      this->krylov_dimension = krylov_dimension;
+    }
+
+    template<typename Scalar>
+    void EigenSolver<Scalar>::factorize(double target_value)
+    {
+      int* A_Ap, *A_Ai, *CB_Ap = nullptr, *CB_Ai = nullptr;
+      Scalar* A_Ax, *CB_Ax = nullptr;
+      bool A_copy = compressed_arrays(this->A, true, A_Ap, A_Ai, A_Ax);
+      bool B_copy = false;
+      if (this->B)
+        B_copy = compressed_arrays(this->B, true, CB_Ap, CB_Ai, CB_Ax);
+
+      // Merge the patterns column by column (the indices are sorted), the identity if B == nullptr.
+      int max_nnz = A_Ap[this->size] + (this->B ? CB_Ap[this->size] : this->size);
+      int* Ap = malloc_with_check<int>(this->size + 1);
+      int* Ai = malloc_with_check<int>(max_nnz);
+      Scalar* Ax = malloc_with_check<Scalar>(max_nnz);
+      int nnz = 0;
+      for (unsigned int col = 0; col < this->size; col++)
+      {
+        Ap[col] = nnz;
+        int a = A_Ap[col], a_end = A_Ap[col + 1];
+        int b = this->B ? CB_Ap[col] : 0, b_end = this->B ? CB_Ap[col + 1] : 1;
+        while (a < a_end || b < b_end)
+        {
+          int a_row = (a < a_end) ? A_Ai[a] : this->size;
+          int b_row = (b < b_end) ? (this->B ? CB_Ai[b] : (int)col) : this->size;
+          Scalar b_value = this->B ? CB_Ax[b] : Scalar(1.);
+          if (a_row < b_row)
+          {
+            Ai[nnz] = a_row;
+            Ax[nnz++] = A_Ax[a++];
+          }
+          else if (b_row < a_row)
+          {
+            Ai[nnz] = b_row;
+            Ax[nnz++] = -target_value * b_value;
+            b++;
+          }
+          else
+          {
+            Ai[nnz] = a_row;
+            Ax[nnz++] = A_Ax[a++] - target_value * b_value;
+            b++;
+          }
+        }
+      }
+      Ap[this->size] = nnz;
+
+      CSCMatrix<Scalar>* shifted_csc_matrix = new CSCMatrix<Scalar>();
+      shifted_csc_matrix->create(this->size, nnz, Ap, Ai, Ax);
+      this->shifted_rhs = new SimpleVector<Scalar>(this->size);
+#ifdef WITH_UMFPACK
+      this->shifted_matrix = shifted_csc_matrix;
+      this->shifted_solver = new UMFPackLinearMatrixSolver<Scalar>(shifted_csc_matrix, this->shifted_rhs);
+#else
+      // The solver casts the matrix to its own type.
+      this->shifted_matrix = create_matrix<Scalar>(true);
+      shifted_csc_matrix->copy_to(this->shifted_matrix);
+      delete shifted_csc_matrix;
+      this->shifted_solver = create_linear_solver<Scalar>(this->shifted_matrix, this->shifted_rhs, true);
+#endif
+
+      free_with_check(Ap);
+      free_with_check(Ai);
+      free_with_check(Ax);
+      if (A_copy)
+      {
+        free_with_check(A_Ap);
+        free_with_check(A_Ai);
+        free_with_check(A_Ax);
+      }
+      if (B_copy)
+      {
+        free_with_check(CB_Ap);
+        free_with_check(CB_Ai);
+        free_with_check(CB_Ax);
+      }
+    }
+
+    template<typename Scalar>
+    void EigenSolver<Scalar>::multiply_B(const Complex* x, Complex* y) const
+    {
+      if (!this->B)
+      {
+        memcpy(y, x, this->size * sizeof(Complex));
+        return;
+      }
+
+      const int size = this->size;
+#pragma omp parallel for num_threads(Hermes::HermesCommonApi.get_integral_param_value(Hermes::numThreads))
+      for (int i = 0; i < size; i++)
+      {
+        Complex sum = 0.;
+        for (int k = B_Ap[i]; k < B_Ap[i + 1]; k++)
+          sum += B_Ax[k] * x[B_Ai[k]];
+        y[i] = sum;
+      }
+    }
+
+    template<>
+    void EigenSolver<double>::solve_shifted(Complex* x)
+    {
+      // The real and the imaginary parts separately.
+      bool has_imaginary_part = false;
+      for (unsigned int i = 0; i < this->size; i++)
+      {
+        this->shifted_rhs->set(i, x[i].real());
+        if (x[i].imag() != 0.)
+          has_imaginary_part = true;
+      }
+      this->shifted_solver->solve();
+      this->shifted_solver->set_reuse_scheme(HERMES_REUSE_MATRIX_STRUCTURE_COMPLETELY);
+      double* sln = this->shifted_solver->get_sln_vector();
+
+      if (!has_imaginary_part)
+      {
+        for (unsigned int i = 0; i < this->size; i++)
+          x[i] = sln[i];
+        return;
+      }
+
+      double* real_part = malloc_with_check<double>(this->size);
+      memcpy(real_part, sln, this->size * sizeof(double));
+      for (unsigned int i = 0; i < this->size; i++)
+        this->shifted_rhs->set(i, x[i].imag());
+      this->shifted_solver->solve();
+      sln = this->shifted_solver->get_sln_vector();
+      for (unsigned int i = 0; i < this->size; i++)
+        x[i] = Complex(real_part[i], sln[i]);
+      free_with_check(real_part);
+    }
+
+    template<>
+    void EigenSolver<Complex>::solve_shifted(Complex* x)
+    {
+      this->shifted_rhs->set_vector(x);
+      this->shifted_solver->solve();
+      this->shifted_solver->set_reuse_scheme(HERMES_REUSE_MATRIX_STRUCTURE_COMPLETELY);
+      memcpy(x, this->shifted_solver->get_sln_vector(), this->size * sizeof(Complex));
+    }
+
+    template<typename Scalar>
+    double EigenSolver<Scalar>::orthogonalize(Complex* w, Complex* Bw, int count, Complex* coefficients)
+    {
+      const int size = this->size;
+      const int num_threads = Hermes::HermesCommonApi.get_integral_param_value(Hermes::numThreads);
+      // Basis in the inner product of the problem.
+      Complex* W_basis = this->symmetric ? this->BV : this->V;
+
+      for (int i = 0; i < count; i++)
+        coefficients[i] = 0.;
+      Complex* correction = malloc_with_check<Complex>(std::max(count, 1));
+
+      // Classical Gram-Schmidt, repeated once (enough for the orthogonality to the working precision).
+      for (int pass = 0; pass < 2 && count > 0; pass++)
+      {
+        for (int i = 0; i < count; i++)
+          correction[i] = 0.;
+#pragma omp parallel num_threads(num_threads)
+        {
+          Complex* partial = calloc_with_check<Complex>(count);
+#pragma omp for
+          for (int r = 0; r < size; r++)
+          {
+            for (int i = 0; i < count; i++)
+              partial[i] += std::conj(W_basis[i * size + r]) * w[r];
+          }
+#pragma omp critical (EigenSolverOrthogonalization)
+          for (int i = 0; i < count; i++)
+            correction[i] += partial[i];
+          free_with_check(partial);
+        }
+
+#pragma omp parallel for num_threads(num_threads)
+        for (int r = 0; r < size; r++)
+        {
+          for (int i = 0; i < count; i++)
+            w[r] -= correction[i] * V[i * size + r];
+        }
+
+        for (int i = 0; i < count; i++)
+          coefficients[i] += correction[i];
+      }
+      free_with_check(correction);
+
+      double norm_squared = 0.;
+      if (this->symmetric)
+      {
+        this->multiply_B(w, Bw);
+#pragma omp parallel for reduction(+:norm_squared) num_threads(num_threads)
+        for (int r = 0; r < size; r++)
+          norm_squared += (std::conj(w[r]) * Bw[r]).real();
+      }
+      else
+      {
+#pragma omp parallel for reduction(+:norm_squared) num_threads(num_threads)
+        for (int r = 0; r < size; r++)
+          norm_squared += std::norm(w[r]);
+      }
+      return sqrt(std::max(norm_squared, 0.));
+    }
+
+    template<typename Scalar>
+    void EigenSolver<Scalar>::solve(int n_eigs, double target_value, double tol, int max_iter)
+    {
+      this->tick();
+      this->free();
+
+      const int size = this->size;
+      if (n_eigs < 1 || n_eigs >= size)
+        throw Exceptions::ValueException("n_eigs", n_eigs, 1, size - 1);
+
+      // Dimension of the Krylov subspace.
+      int m = this->krylov_dimension > 0 ? this->krylov_dimension : std::max(2 * n_eigs + 1, 20);
+      m = std::min(m, size);
+      if (m <= n_eigs)
+        throw Exceptions::Exception("EigenSolver: the Krylov subspace dimension %i is too small for %i eigenvalues.", m, n_eigs);
+
+      this->factorize(target_value);
+
+      V = malloc_with_check<Complex>(size * (m + 1));
+      if (this->symmetric)
+        BV = malloc_with_check<Complex>(size * (m + 1));
+      // Projected matrix, (m + 1) x m, column-major.
+      const int ld = m + 1;
+      Complex* H = calloc_with_check<Complex>(ld * m);
+      Complex* coefficients = malloc_with_check<Complex>(m + 1);
+      Complex* H_m = malloc_with_check<Complex>(m * m);
+      Complex* theta = malloc_with_check<Complex>(m);
+      Complex* Y = malloc_with_check<Complex>(m * m);
+      Complex* Q = malloc_with_check<Complex>(m * m);
+      double* residuals = malloc_with_check<double>(m);
+      int* order = malloc_with_check<int>(m);
+
+      // Starting vector: the shift-inverted operator applied to a (reproducible) pseudo-random vector,
+      // which removes the components in the null space of B.
+      unsigned int seed = 12345;
+      for (int r = 0; r < size; r++)
+      {
+        seed = seed * 1103515245 + 12345;
+        V[r] = 0.5 + ((seed >> 16) & 0x7fff) / 32768.;
+      }
+      if (this->B)
+      {
+        multiply_B(V, V + size);
+        memcpy(V, V + size, size * sizeof(Complex));
+      }
+      this->solve_shifted(V);
+      double norm = orthogonalize(V, this->symmetric ? BV : nullptr, 0, coefficients);
+      for (int r = 0; r < size; r++)
+      {
+        V[r] /= norm;
+        if (this->symmetric)
+          BV[r] /= norm;
+      }
+
+      int k = 0, m_used = m, converged = 0;
+      bool invariant_subspace = false;
+      for (this->num_iters = 0;; this->num_iters++)
+      {
+        // Extension of the Krylov basis.
+        for (int j = k; j < m; j++)
+        {
+          Complex* w = V + (j + 1) * size;
+          if (this->symmetric)
+            memcpy(w, BV + j * size, size * sizeof(Complex));
+          else
+            multiply_B(V + j * size, w);
+          this->solve_shifted(w);
+
+          double beta = orthogonalize(w, this->symmetric ? BV + (j + 1) * size : nullptr, j + 1, coefficients);
+          double column_norm = beta * beta;
+          for (int i = 0; i <= j; i++)
+          {
+            H[i + j * ld] = coefficients[i];
+            column_norm += std::norm(coefficients[i]);
+          }
+          H[j + 1 + j * ld] = beta;
+
+          if (beta <= 1e3 * eigensolver_epsilon * sqrt(column_norm))
+          {
+            // The subspace is invariant, its Ritz pairs are exact.
+            m_used = j + 1;
+            invariant_subspace = true;
+            break;
+          }
+
+          for (int r = 0; r < size; r++)
+          {
+            w[r] /= beta;
+            if (this->symmetric)
+              BV[(j + 1) * size + r] /= beta;
+          }
+        }
+
+        // Ritz pairs, sorted by the magnitude (the largest ones belong to the eigenvalues nearest to the target).
+        for (int j = 0; j < m_used; j++)
+        for (int i = 0; i < m_used; i++)
+          H_m[i + j * m_used] = H[i + j * ld];
+        if (this->symmetric)
+        {
+          for (int j = 0; j < m_used; j++)
+          {
+            H_m[j + j * m_used] = H_m[j + j * m_used].real();
+            for (int i = 0; i < j; i++)
+            {
+              Complex value = 0.5 * (H_m[i + j * m_used] + std::conj(H_m[j + i * m_used]));
+              H_m[i + j * m_used] = value;
+              H_m[j + i * m_used] = std::conj(value);
+            }
+          }
+        }
+        dense_eigen(H_m, m_used, theta, Y);
+
+        for (int i = 0; i < m_used; i++)
+          order[i] = i;
+        for (int i = 1; i < m_used; i++)
+        {
+          int current = order[i], j = i;
+          for (; j > 0 && std::abs(theta[order[j - 1]]) < std::abs(theta[current]); j--)
+            order[j] = order[j - 1];
+          order[j] = current;
+        }
+
+        // Residual estimates |h_{m+1,m}| |y_m|.
+        double h_last = invariant_subspace ? 0. : std::abs(H[m_used + (m_used - 1) * ld]);
+        converged = 0;
+        for (int i = 0; i < std::min(n_eigs, m_used); i++)
+        {
+          residuals[i] = h_last * std::abs(Y[m_used - 1 + order[i] * m_used]);
+          if (residuals[i] <= tol * std::abs(theta[order[i]]))
+            converged++;
+        }
+
+        this->info("\tEigenSolver: restart %i, %i of %i eigenvalues converged.", this->num_iters, converged, n_eigs);
+        if (converged == n_eigs || invariant_subspace || m_used == size || this->num_iters >= max_iter)
+          break;
+
+        // Restart with the wanted Ritz vectors (orthonormalized), A V Q = V Q (Q^H H Q) + f h_{m+1,m} e_m^T Q.
+        int keep = n_eigs + (m - n_eigs) / 2;
+        // Real problems with real kept Ritz values: the Ritz vectors are rotated to real ones (the phase of the largest
+        // entry removed), so that the basis stays real and solve_shifted() needs one solve per vector.
+        bool real_ritz_vectors = std::is_same<Scalar, double>::value;
+        for (int c = 0; c < keep && real_ritz_vectors; c++)
+        if (std::abs(theta[order[c]].imag()) > 1e3 * eigensolver_epsilon * std::abs(theta[order[c]]))
+          real_ritz_vectors = false;
+        for (int c = 0; c < keep; c++)
+        {
+          memcpy(Q + c * m, Y + order[c] * m, m * sizeof(Complex));
+          if (real_ritz_vectors)
+          {
+            int largest = 0;
+            for (int i = 1; i < m; i++)
+            if (std::abs(Q[i + c * m]) > std::abs(Q[largest + c * m]))
+              largest = i;
+            Complex phase = std::conj(Q[largest + c * m]) / std::abs(Q[largest + c * m]);
+            for (int i = 0; i < m; i++)
+              Q[i + c * m] = (Q[i + c * m] * phase).real();
+          }
+          for (int pass = 0; pass < 2; pass++)
+          {
+            for (int p = 0; p < c; p++)
+            {
+              Complex dot = 0.;
+              for (int i = 0; i < m; i++)
+                dot += std::conj(Q[i + p * m]) * Q[i + c * m];
+              for (int i = 0; i < m; i++)
+                Q[i + c * m] -= dot * Q[i + p * m];
+            }
+          }
+          double q_norm = 0.;
+          for (int i = 0; i < m; i++)
+            q_norm += std::norm(Q[i + c * m]);
+          q_norm = sqrt(q_norm);
+          for (int i = 0; i < m; i++)
+            Q[i + c * m] /= q_norm;
+        }
+
+        // Q^H H Q into H_m (keep x keep).
+        for (int c = 0; c < keep; c++)
+        {
+          for (int i = 0; i < m; i++)
+          {
+            Complex value = 0.;
+            for (int j = 0; j < m; j++)
+              value += H[i + j * ld] * Q[j + c * m];
+            coefficients[i] = value;
+          }
+          for (int p = 0; p < keep; p++)
+          {
+            Complex value = 0.;
+            for (int i = 0; i < m; i++)
+              value += std::conj(Q[i + p * m]) * coefficients[i];
+            H_m[p + c * keep] = value;
+          }
+        }
+        Complex h_residual = H[m + (m - 1) * ld];
+        memset(H, 0, ld * m * sizeof(Complex));
+        for (int c = 0; c < keep; c++)
+        {
+          for (int p = 0; p < keep; p++)
+            H[p + c * ld] = H_m[p + c * keep];
+          H[keep + c * ld] = h_residual * Q[m - 1 + c * m];
+        }
+
+        // V := V Q, the last vector follows.
+        Complex* bases[2] = { V, BV };
+        for (int basis_i = 0; basis_i < (this->symmetric ? 2 : 1); basis_i++)
+        {
+          Complex* basis = bases[basis_i];
+#pragma omp parallel num_threads(Hermes::HermesCommonApi.get_integral_param_value(Hermes::numThreads))
+          {
+            Complex* row = malloc_with_check<Complex>(keep);
+#pragma omp for
+            for (int r = 0; r < size; r++)
+            {
+              for (int c = 0; c < keep; c++)
+              {
+                Complex value = 0.;
+                for (int i = 0; i < m; i++)
+                  value += basis[i * size + r] * Q[i + c * m];
+                row[c] = value;
+              }
+              for (int c = 0; c < keep; c++)
+                basis[c * size + r] = row[c];
+              basis[keep * size + r] = basis[m * size + r];
+            }
+            free_with_check(row);
+          }
+        }
+        k = keep;
+      }
+
+      if (converged < n_eigs)
+        this->warn("EigenSolver: only %i of %i eigenvalues converged in %i restarts.", converged, n_eigs, this->num_iters);
+
+      // The converged eigenpairs, lambda = sigma + 1 / theta, x = V y.
+      this->eigenvalues = malloc_with_check<Complex>(n_eigs);
+      this->eigenvectors = malloc_with_check<Complex>(n_eigs * size);
+      this->eigenvectors_scalar = malloc_with_check<Scalar>(n_eigs * size);
+      for (int i = 0; i < std::min(n_eigs, m_used); i++)
+      {
+        if (residuals[i] > tol * std::abs(theta[order[i]]))
+          continue;
+
+        Complex eigenvalue = target_value + 1. / theta[order[i]];
+        this->eigenvalues[this->n_eigs] = this->symmetric ? Complex(eigenvalue.real()) : eigenvalue;
+
+        Complex* x = this->eigenvectors + this->n_eigs * size;
+        Complex* y = Y + order[i] * m_used;
+#pragma omp parallel for num_threads(Hermes::HermesCommonApi.get_integral_param_value(Hermes::numThreads))
+        for (int r = 0; r < size; r++)
+        {
+          Complex value = 0.;
+          for (int j = 0; j < m_used; j++)
+            value += V[j * size + r] * y[j];
+          x[r] = value;
+        }
+
+        // The largest component real and positive (real vectors for real eigenpairs).
+        int largest = 0;
+        for (int r = 1; r < size; r++)
+        if (std::abs(x[r]) > std::abs(x[largest]))
+          largest = r;
+        Complex phase = std::conj(x[largest]) / std::abs(x[largest]);
+        for (int r = 0; r < size; r++)
+        {
+          x[r] *= phase;
+          eigensolver_to_scalar(x[r], this->eigenvectors_scalar[this->n_eigs * size + r]);
+        }
+
+        this->n_eigs++;
+      }
+
+      free_with_check(H);
+      free_with_check(coefficients);
+      free_with_check(H_m);
+      free_with_check(theta);
+      free_with_check(Y);
+      free_with_check(Q);
+      free_with_check(residuals);
+      free_with_check(order);
+      free_with_check(V);
+      free_with_check(BV);
+
+      this->tick();
+      this->info("\tEigenSolver: %i eigenvalues in %i restarts, %f s.", this->n_eigs, this->num_iters, this->last());
+    }
+
+    template<typename Scalar>
+    int EigenSolver<Scalar>::get_n_eigs() const
+    {
+      return this->n_eigs;
+    }
+
+    template<typename Scalar>
+    int EigenSolver<Scalar>::get_num_iters() const
+    {
+      return this->num_iters;
+    }
+
+    template<typename Scalar>
+    std::complex<double> EigenSolver<Scalar>::get_complex_eigenvalue(int i) const
+    {
+      if (i < 0 || i >= this->n_eigs)
+        throw Exceptions::ValueException("i", i, 0, this->n_eigs - 1);
+      return this->eigenvalues[i];
+    }
+
+    template<typename Scalar>
+    double EigenSolver<Scalar>::get_eigenvalue(int i) const
+    {
+      return this->get_complex_eigenvalue(i).real();
+    }
+
+    template<typename Scalar>
+    void EigenSolver<Scalar>::get_eigenvector(int i, Scalar **vec, int *n)
+    {
+      if (i < 0 || i >= this->n_eigs)
+        throw Exceptions::ValueException("i", i, 0, this->n_eigs - 1);
+      *vec = this->eigenvectors_scalar + i * this->size;
+      *n = this->size;
+    }
+
+    template<typename Scalar>
+    void EigenSolver<Scalar>::get_complex_eigenvector(int i, std::complex<double> **vec, int *n)
+    {
+      if (i < 0 || i >= this->n_eigs)
+        throw Exceptions::ValueException("i", i, 0, this->n_eigs - 1);
+      *vec = this->eigenvectors + i * this->size;
+      *n = this->size;
+    }
+
+    template<typename Scalar>
+    void EigenSolver<Scalar>::print_eigenvalues() const
+    {
+      printf("Eigenvalues:\n");
+      for (int i = 0; i < this->get_n_eigs(); i++)
+      {
+        if (this->symmetric)
+          printf("%3d: %f\n", i, this->get_eigenvalue(i));
+        else
+          printf("%3d: %f %+fi\n", i, this->eigenvalues[i].real(), this->eigenvalues[i].imag());
+      }
+    }
+  }
+}
+
+template class HERMES_API Hermes::Solvers::EigenSolver<double>;
+template class HERMES_API Hermes::Solvers::EigenSolver<std::complex<double> >;
@@ -45,15 +45,24 @@ namespace Hermes
 
     template<typename Scalar>
     UMFPackLinearMatrixSolver<Scalar>::UMFPackLinearMatrixSolver(CSCMatrix<Scalar> *m, SimpleVector<Scalar> *rhs)
-      : DirectSolver<Scalar>(m, rhs), m(m), rhs(rhs), symbolic(nullptr), numeric(nullptr)
+      : DirectSolver<Scalar>(m, rhs), m(m), bsr_m(nullptr), rhs(rhs), symbolic(nullptr), numeric(nullptr)
     {
         umfpack_di_defaults(Control);
       }
 
+    template<typename Scalar>
+    UMFPackLinearMatrixSolver<Scalar>::UMFPackLinearMatrixSolver(BSRMatrix<Scalar> *m, SimpleVector<Scalar> *rhs)
+      : DirectSolver<Scalar>(m, rhs), m(new CSCMatrix<Scalar>), bsr_m(m), rhs(rhs), symbolic(nullptr), numeric(nullptr)
+    {
+      umfpack_di_defaults(Control);
+    }
+
     template<typename Scalar>
     UMFPackLinearMatrixSolver<Scalar>::~UMFPackLinearMatrixSolver()
     {
       free();
+      if (bsr_m)
+        delete m;
     }
 
     template<typename Scalar>
@@ -65,7 +74,7 @@ namespace Hermes
     template<typename Scalar>
     int UMFPackLinearMatrixSolver<Scalar>::get_matrix_size()
     {
-      return m->get_size();
+      return bsr_m ? bsr_m->get_size() : m->get_size();
     }
 
     template<>
@@ -182,6 +191,9 @@ namespace Hermes
     template<>
     void UMFPackLinearMatrixSolver<double>::solve()
     {
+      if (bsr_m)
+        bsr_m->convert_to_csc(m);
+
       assert(m != nullptr);
       assert(rhs != nullptr);
       assert(m->get_size() == rhs->get_size());
@@ -207,6 +219,9 @@ namespace Hermes
     template<>
     void UMFPackLinearMatrixSolver<std::complex<double> >::solve()
     {
+      if (bsr_m)
+        bsr_m->convert_to_csc(m);
+
       assert(m != nullptr);
       assert(rhs != nullptr);
       assert(m->get_size() == rhs->get_size());
@@ -20,6 +20,7 @@
 \brief General linear solver functionality.
 */
 #include "linear_matrix_solver.h"
+#include "mixed_precision_solver.h"
 #include "solvers/interfaces/umfpack_solver.h"
 #include "solvers/interfaces/superlu_solver.h"
 #include "solvers/interfaces/amesos_solver.h"
@@ -237,6 +238,11 @@ namespace Hermes
       case Hermes::SOLVER_UMFPACK:
       {
 #ifdef WITH_UMFPACK
+                                   if (dynamic_cast<BSRMatrix<double>*>(matrix))
+                                   {
+                                     if (rhs != nullptr) return new UMFPackLinearMatrixSolver<double>(static_cast<BSRMatrix<double>*>(matrix), static_cast<SimpleVector<double>*>(rhs));
+                                     else return new UMFPackLinearMatrixSolver<double>(static_cast<BSRMatrix<double>*>(matrix), static_cast<SimpleVector<double>*>(rhs_dummy));
+                                   }
                                    if (rhs != nullptr) return new UMFPackLinearMatrixSolver<double>(static_cast<CSCMatrix<double>*>(matrix), static_cast<SimpleVector<double>*>(rhs));
                                    else return new UMFPackLinearMatrixSolver<double>(static_cast<CSCMatrix<double>*>(matrix), static_cast<SimpleVector<double>*>(rhs_dummy));
 #else
@@ -276,6 +282,13 @@ namespace Hermes
 #endif
                                    break;
       }
+      case Hermes::SOLVER_MIXED_PRECISION:
+      {
+                                           if (use_direct_solver)
+                                             throw Hermes::Exceptions::Exception("The iterative solver with single precision corrections selected as a direct solver.");
+                                           if (rhs != nullptr) return new MixedPrecisionLinearMatrixSolver<double>(static_cast<CSCMatrix<double>*>(matrix), static_cast<SimpleVector<double>*>(rhs));
+                                           else return new MixedPrecisionLinearMatrixSolver<double>(static_cast<CSCMatrix<double>*>(matrix), static_cast<SimpleVector<double>*>(rhs_dummy));
+      }
       default:
         throw Hermes::Exceptions::Exception("Unknown matrix solver requested in create_linear_solver().");
       }
@@ -342,6 +355,11 @@ namespace Hermes
       case Hermes::SOLVER_UMFPACK:
       {
 #ifdef WITH_UMFPACK
+                                   if (dynamic_cast<BSRMatrix<std::complex<double> >*>(matrix))
+                                   {
+                                     if (rhs != nullptr) return new UMFPackLinearMatrixSolver<std::complex<double> >(static_cast<BSRMatrix<std::complex<double> >*>(matrix), static_cast<SimpleVector<std::complex<double> >*>(rhs));
+                                     else return new UMFPackLinearMatrixSolver<std::complex<double> >(static_cast<BSRMatrix<std::complex<double> >*>(matrix), static_cast<SimpleVector<std::complex<double> >*>(rhs_dummy));
+                                   }
                                    if (rhs != nullptr) return new UMFPackLinearMatrixSolver<std::complex<double> >(static_cast<CSCMatrix<std::complex<double> >*>(matrix), static_cast<SimpleVector<std::complex<double> >*>(rhs));
                                    else return new UMFPackLinearMatrixSolver<std::complex<double> >(static_cast<CSCMatrix<std::complex<double> >*>(matrix), static_cast<SimpleVector<std::complex<double> >*>(rhs_dummy));
 #else
@@ -371,6 +389,13 @@ namespace Hermes
 #endif
                                    break;
       }
+      case Hermes::SOLVER_MIXED_PRECISION:
+      {
+                                           if (use_direct_solver)
+                                             throw Hermes::Exceptions::Exception("The iterative solver with single precision corrections selected as a direct solver.");
+                                           if (rhs != nullptr) return new MixedPrecisionLinearMatrixSolver<std::complex<double> >(static_cast<CSCMatrix<std::complex<double> >*>(matrix), static_cast<SimpleVector<std::complex<double> >*>(rhs));
+                                           else return new MixedPrecisionLinearMatrixSolver<std::complex<double> >(static_cast<CSCMatrix<std::complex<double> >*>(matrix), static_cast<SimpleVector<std::complex<double> >*>(rhs_dummy));
+      }
       default:
         throw Hermes::Exceptions::Exception("Unknown matrix solver requested in create_linear_solver().");
       }
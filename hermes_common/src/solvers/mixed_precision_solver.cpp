@@ -0,0 +1,353 @@
+// This file is part of HermesCommon
+//
+// Copyright (c) 2009 hp-FEM group at the University of Nevada, Reno (UNR).
+// Email: hpfem-group@unr.edu, home page: http://hpfem.org/.
+//
+// Hermes2D is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published
+// by the Free Software Foundation; either version 2 of the License,
+// or (at your option) any later version.
+//
+// Hermes2D is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with Hermes2D; if not, write to the Free Software
+// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+/*! \file mixed_precision_solver.cpp
+\brief Mixed precision solver (iterative refinement) with single precision correction solves.
+*/
+#include "mixed_precision_solver.h"
+#include "util/memory_handling.h"
+
+namespace Hermes
+{
+  namespace Solvers
+  {
+    static inline float mixed_conj(float v)
+    {
+      return v;
+    }
+
+    static inline std::complex<float> mixed_conj(std::complex<float> v)
+    {
+      return std::conj(v);
+    }
+
+    /// Inner product of single precision vectors, accumulated in double precision.
+    template<typename Scalar, typename LowScalar>
+    static Scalar mixed_dot(const LowScalar* a, const LowScalar* b, int n)
+    {
+      Scalar sum = Scalar(0);
+      for (int i = 0; i < n; i++)
+        sum += Scalar(mixed_conj(a[i])) * Scalar(b[i]);
+      return sum;
+    }
+
+    template<typename Scalar, typename LowScalar>
+    static double mixed_norm(const LowScalar* a, int n)
+    {
+      return std::sqrt(std::abs(mixed_dot<Scalar, LowScalar>(a, a, n)));
+    }
+
+    template<typename Scalar>
+    MixedPrecisionLinearMatrixSolver<Scalar>::MixedPrecisionLinearMatrixSolver(CSCMatrix<Scalar> *m, SimpleVector<Scalar> *rhs)
+      : LoopSolver<Scalar>(m, rhs), m(m), rhs(rhs), factors(nullptr), diagonal(nullptr), factorized_size(0), work(nullptr),
+      inner_tolerance(1e-4), max_inner_iters(1000), num_iters(0), num_inner_iters(0), final_residual(0.)
+    {
+      this->max_iters = 50;
+      this->tolerance = 1e-12;
+      this->toleranceType = RelativeTolerance;
+    }
+
+    template<typename Scalar>
+    MixedPrecisionLinearMatrixSolver<Scalar>::~MixedPrecisionLinearMatrixSolver()
+    {
+      free_with_check(factors);
+      free_with_check(diagonal);
+      free_with_check(work);
+    }
+
+    template<typename Scalar>
+    int MixedPrecisionLinearMatrixSolver<Scalar>::get_matrix_size()
+    {
+      return m->get_size();
+    }
+
+    template<typename Scalar>
+    int MixedPrecisionLinearMatrixSolver<Scalar>::get_num_iters()
+    {
+      return num_iters;
+    }
+
+    template<typename Scalar>
+    int MixedPrecisionLinearMatrixSolver<Scalar>::get_num_inner_iters()
+    {
+      return num_inner_iters;
+    }
+
+    template<typename Scalar>
+    double MixedPrecisionLinearMatrixSolver<Scalar>::get_residual_norm()
+    {
+      return final_residual;
+    }
+
+    template<typename Scalar>
+    void MixedPrecisionLinearMatrixSolver<Scalar>::set_inner_tolerance(double inner_tolerance)
+    {
+      this->inner_tolerance = inner_tolerance;
+    }
+
+    template<typename Scalar>
+    void MixedPrecisionLinearMatrixSolver<Scalar>::set_max_inner_iters(int max_inner_iters)
+    {
+      this->max_inner_iters = max_inner_iters;
+    }
+
+    template<typename Scalar>
+    unsigned long MixedPrecisionLinearMatrixSolver<Scalar>::get_factorization_memory_size() const
+    {
+      if (factors == nullptr)
+        return 0;
+      return low_matrix.get_memory_size() + factorized_size * sizeof(int) + (unsigned long)low_matrix.get_nnz() * sizeof(LowScalar);
+    }
+
+    template<typename Scalar>
+    void MixedPrecisionLinearMatrixSolver<Scalar>::factorize()
+    {
+      low_matrix.create_from(m);
+      int n = low_matrix.get_size();
+      int* Ap = low_matrix.get_Ap();
+      int* Ai = low_matrix.get_Ai();
+      unsigned int nnz = low_matrix.get_nnz();
+
+      free_with_check(factors);
+      free_with_check(diagonal);
+      free_with_check(work);
+      factors = malloc_with_check<LowScalar>(nnz);
+      memcpy(factors, low_matrix.get_Ax(), nnz * sizeof(LowScalar));
+      diagonal = malloc_with_check<int>(n);
+      work = malloc_with_check<LowScalar>(8 * n);
+
+      for (int i = 0; i < n; i++)
+      {
+        diagonal[i] = -1;
+        for (int k = Ap[i]; k < Ap[i + 1]; k++)
+        if (Ai[k] == i)
+          diagonal[i] = k;
+        if (diagonal[i] == -1)
+          throw Exceptions::LinearMatrixSolverException("ILU(0) factorization: missing diagonal entry in row %i.", i);
+      }
+
+      // ILU(0), the column indices are sorted, so the entries of L precede the diagonal in each row.
+      for (int i = 0; i < n; i++)
+      {
+        for (int p = Ap[i]; p < diagonal[i]; p++)
+        {
+          int k = Ai[p];
+          if (factors[diagonal[k]] == LowScalar(0))
+            throw Exceptions::LinearMatrixSolverException("ILU(0) factorization: zero pivot in row %i.", k);
+          factors[p] /= factors[diagonal[k]];
+
+          // Row i -= l_ik * (row k of U), restricted to the pattern of the row i.
+          LowScalar l = factors[p];
+          int q = p + 1, r = diagonal[k] + 1;
+          while (q < Ap[i + 1] && r < Ap[k + 1])
+          {
+            if (Ai[q] < Ai[r])
+              q++;
+            else if (Ai[q] > Ai[r])
+              r++;
+            else
+              factors[q++] -= l * factors[r++];
+          }
+        }
+      }
+
+      for (int i = 0; i < n; i++)
+      if (factors[diagonal[i]] == LowScalar(0))
+        throw Exceptions::LinearMatrixSolverException("ILU(0) factorization: zero pivot in row %i.", i);
+
+      factorized_size = n;
+    }
+
+    template<typename Scalar>
+    void MixedPrecisionLinearMatrixSolver<Scalar>::apply_preconditioner(const LowScalar* in, LowScalar* out) const
+    {
+      int n = low_matrix.get_size();
+      int* Ap = low_matrix.get_Ap();
+      int* Ai = low_matrix.get_Ai();
+
+      // L y = in (unit diagonal).
+      for (int i = 0; i < n; i++)
+      {
+        LowScalar sum = in[i];
+        for (int p = Ap[i]; p < diagonal[i]; p++)
+          sum -= factors[p] * out[Ai[p]];
+        out[i] = sum;
+      }
+
+      // U out = y.
+      for (int i = n - 1; i >= 0; i--)
+      {
+        LowScalar sum = out[i];
+        for (int p = diagonal[i] + 1; p < Ap[i + 1]; p++)
+          sum -= factors[p] * out[Ai[p]];
+        out[i] = sum / factors[diagonal[i]];
+      }
+    }
+
+    template<typename Scalar>
+    int MixedPrecisionLinearMatrixSolver<Scalar>::solve_correction(const LowScalar* r, LowScalar* d)
+    {
+      // Right-preconditioned BiCGStab, the coefficients and inner products are in double precision.
+      int n = m->get_size();
+      LowScalar* res = work;
+      LowScalar* r0 = work + n;
+      LowScalar* p = work + 2 * n;
+      LowScalar* v = work + 3 * n;
+      LowScalar* p_hat = work + 4 * n;
+      LowScalar* s = work + 5 * n;
+      LowScalar* s_hat = work + 6 * n;
+      LowScalar* t = work + 7 * n;
+
+      memcpy(res, r, n * sizeof(LowScalar));
+      memcpy(r0, r, n * sizeof(LowScalar));
+      memset(p, 0, n * sizeof(LowScalar));
+      memset(v, 0, n * sizeof(LowScalar));
+      memset(d, 0, n * sizeof(LowScalar));
+
+      // r is normalized, the tolerance is relative.
+      Scalar rho = 1., alpha = 1., omega = 1.;
+      int iteration = 0;
+      while (iteration < max_inner_iters)
+      {
+        Scalar rho_new = mixed_dot<Scalar, LowScalar>(r0, res, n);
+        if (rho_new == Scalar(0))
+          break;
+
+        LowScalar beta = LowScalar((rho_new / rho) * (alpha / omega));
+        LowScalar low_omega = LowScalar(omega);
+        for (int i = 0; i < n; i++)
+          p[i] = res[i] + beta * (p[i] - low_omega * v[i]);
+
+        apply_preconditioner(p, p_hat);
+        low_matrix.multiply_with_vector(p_hat, v);
+
+        Scalar r0_v = mixed_dot<Scalar, LowScalar>(r0, v, n);
+        if (r0_v == Scalar(0))
+          break;
+        alpha = rho_new / r0_v;
+        LowScalar low_alpha = LowScalar(alpha);
+        for (int i = 0; i < n; i++)
+          s[i] = res[i] - low_alpha * v[i];
+        iteration++;
+
+        if (mixed_norm<Scalar, LowScalar>(s, n) < inner_tolerance)
+        {
+          for (int i = 0; i < n; i++)
+            d[i] += low_alpha * p_hat[i];
+          break;
+        }
+
+        apply_preconditioner(s, s_hat);
+        low_matrix.multiply_with_vector(s_hat, t);
+
+        Scalar t_t = mixed_dot<Scalar, LowScalar>(t, t, n);
+        omega = (t_t == Scalar(0)) ? Scalar(0) : mixed_dot<Scalar, LowScalar>(t, s, n) / t_t;
+        low_omega = LowScalar(omega);
+        for (int i = 0; i < n; i++)
+        {
+          d[i] += low_alpha * p_hat[i] + low_omega * s_hat[i];
+          res[i] = s[i] - low_omega * t[i];
+        }
+        rho = rho_new;
+
+        if (omega == Scalar(0) || mixed_norm<Scalar, LowScalar>(res, n) < inner_tolerance)
+          break;
+      }
+
+      return iteration;
+    }
+
+    template<typename Scalar>
+    void MixedPrecisionLinearMatrixSolver<Scalar>::solve()
+    {
+      this->solve(nullptr);
+    }
+
+    template<typename Scalar>
+    void MixedPrecisionLinearMatrixSolver<Scalar>::solve(Scalar* initial_guess)
+    {
+      assert(m != nullptr);
+      assert(rhs != nullptr);
+      assert(m->get_size() == rhs->get_size());
+
+      this->tick();
+
+      int n = m->get_size();
+      if (this->reuse_scheme != HERMES_REUSE_MATRIX_STRUCTURE_COMPLETELY || factors == nullptr || factorized_size != (unsigned int)n)
+        factorize();
+
+      Scalar* x = malloc_with_check<Scalar>(n);
+      if (initial_guess)
+        memcpy(x, initial_guess, n * sizeof(Scalar));
+      else
+        memset(x, 0, n * sizeof(Scalar));
+      free_with_check(this->sln);
+      this->sln = x;
+
+      Scalar* residual = malloc_with_check<Scalar>(n);
+      LowScalar* low_residual = malloc_with_check<LowScalar>(n);
+      LowScalar* correction = malloc_with_check<LowScalar>(n);
+
+      double rhs_norm = 0.;
+      for (int i = 0; i < n; i++)
+        rhs_norm += std::norm(rhs->v[i]);
+      rhs_norm = std::sqrt(rhs_norm);
+
+      num_iters = 0;
+      num_inner_iters = 0;
+      while (true)
+      {
+        // r = b - Ax in double precision, with the original matrix.
+        m->multiply_with_vector(this->sln, residual, true);
+        double residual_norm = 0.;
+        for (int i = 0; i < n; i++)
+        {
+          residual[i] = rhs->v[i] - residual[i];
+          residual_norm += std::norm(residual[i]);
+        }
+        residual_norm = std::sqrt(residual_norm);
+
+        final_residual = (this->toleranceType == AbsoluteTolerance || rhs_norm == 0.) ? residual_norm : residual_norm / rhs_norm;
+        if (final_residual <= this->tolerance || residual_norm == 0.)
+          break;
+        if (num_iters == this->max_iters)
+        {
+          this->warn("MixedPrecisionLinearMatrixSolver: residual %g after %i refinement steps.", final_residual, num_iters);
+          break;
+        }
+
+        // A d = r / |r| in single precision.
+        for (int i = 0; i < n; i++)
+          low_residual[i] = LowScalar(residual[i] / residual_norm);
+        num_inner_iters += solve_correction(low_residual, correction);
+        for (int i = 0; i < n; i++)
+          this->sln[i] += residual_norm * Scalar(correction[i]);
+        num_iters++;
+      }
+
+      free_with_check(residual);
+      free_with_check(low_residual);
+      free_with_check(correction);
+
+      this->tick();
+    }
+
+    template class HERMES_API MixedPrecisionLinearMatrixSolver<double>;
+    template class HERMES_API MixedPrecisionLinearMatrixSolver<std::complex<double> >;
+  }
+}
@@ -58,6 +58,12 @@ namespace Hermes
         return NonlinearMatrixSolver<Scalar>::get_convergence_state();
     }
 
+    template<typename Scalar>
+    bool NewtonMatrixSolver<Scalar>::assemble_jacobian_with_residual() const
+    {
+      return true;
+    }
+
     template<typename Scalar>
     double NewtonMatrixSolver<Scalar>::update_solution_return_change_norm(Scalar* linear_system_solution)
     {
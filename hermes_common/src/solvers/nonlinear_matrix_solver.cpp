@@ -408,6 +408,36 @@ namespace Hermes
       return true;
     }
 
+    template<typename Scalar>
+    bool NonlinearMatrixSolver<Scalar>::will_reuse_jacobian(unsigned int successful_steps_with_reused_jacobian) const
+    {
+      return this->jacobian_reusable && (this->constant_jacobian || successful_steps_with_reused_jacobian < this->max_steps_with_reused_jacobian);
+    }
+
+    template<typename Scalar>
+    bool NonlinearMatrixSolver<Scalar>::convergence_expected()
+    {
+      if (this->get_current_iteration_number() >= this->max_allowed_iterations)
+        return true;
+
+      Hermes::vector<double>& residual_norms = this->get_parameter_value(this->p_residual_norms);
+      int residual_norms_count = residual_norms.size();
+      if (residual_norms_count < 2 || residual_norms.back() >= residual_norms[residual_norms_count - 2])
+        return false;
+
+      double ratio = residual_norms.back() / residual_norms[residual_norms_count - 2];
+      residual_norms.push_back(residual_norms.back() * ratio * ratio);
+      bool converged = (this->get_convergence_state() == Converged);
+      residual_norms.pop_back();
+      return converged;
+    }
+
+    template<typename Scalar>
+    bool NonlinearMatrixSolver<Scalar>::assemble_jacobian_with_residual() const
+    {
+      return false;
+    }
+
     template<typename Scalar>
     bool NonlinearMatrixSolver<Scalar>::do_initial_step_return_finished()
     {
@@ -533,11 +563,23 @@ namespace Hermes
 
 #pragma region damping_factor_loop
         this->info("\n\tNonlinearSolver: Damping factor handling:");
+        // The jacobian is needed at the iterate the damping factor search ends with iff it is not going to be reused
+        // and the iteration does not end there. If the search can not reject the iterate (manual damping), it is assembled
+        // together with the residual.
+        bool jacobian_assembled = false;
+        bool assemble_jacobian_now = this->manual_damping && this->assemble_jacobian_with_residual() && !this->will_reuse_jacobian(successful_steps_jacobian)
+          && !this->convergence_expected();
         // Loop searching for the damping factor.
         do
         {
-          // Assemble just the residual.
-          this->assemble_residual(false);
+          // Assemble the residual (and the jacobian if it is needed).
+          if (assemble_jacobian_now)
+          {
+            this->assemble(true, false);
+            jacobian_assembled = true;
+          }
+          else
+            this->assemble_residual(false);
           // Current residual norm.
           this->get_parameter_value(this->p_residual_norms).push_back(this->calculate_residual_norm());
 
@@ -639,9 +681,10 @@ namespace Hermes
         }
 #pragma endregion
 
-        // Reassemble the jacobian once not reusable anymore.
+        // Reassemble the jacobian once not reusable anymore (unless already done together with the residual).
         this->info("\t\tre-calculating Jacobian.");
-        this->assemble_jacobian(true);
+        if (!jacobian_assembled)
+          this->assemble_jacobian(true);
 
         // Set factorization schemes.
         if (this->jacobian_reusable)